@@ -0,0 +1,192 @@
+#pragma once
+
+/**
+ * @file    blob_store.hpp
+ * @brief   The content-addressed segment store for the large payloads of persistent objects.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The directory of the blob segments. It defaults to the "blobs" directory under PERS/file_path.
+ */
+#define CASCADE_PERSISTENT_BLOB_PATH    "CASCADE/persistent_blob_path"
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * @brief   The reference to a blob segment, which the persistent log stores in place of a large payload.
+ */
+struct BlobReference {
+    /** The SHA-256 digest of the payload, which names the segment. */
+    uint8_t digest[32];
+    /** The size of the payload in bytes. */
+    uint64_t size;
+
+    /**
+     * @return the hex string of the digest, which is the file name of the segment.
+     */
+    std::string to_string() const;
+
+    /**
+     * @brief   Parse a reference from the name of its segment.
+     *
+     * @param[in]   name    The hex string of the digest
+     * @param[in]   size    The size of the payload
+     *
+     * @return the reference.
+     *
+     * @throw std::invalid_argument if the name is not a hex digest.
+     */
+    static BlobReference from_string(const std::string& name, uint64_t size);
+};
+
+/**
+ * @brief   The content-addressed store of blob segments.
+ *
+ * A segment is a file named by the digest of its content, so writing the same payload twice, e.g. when an unchanged
+ * object is relocated by log retention, stores it once. A segment is written to a temporary file with O_DIRECT, or
+ * with buffered I/O if the file system does not support it, synced, and then renamed, so a segment that exists is
+ * complete. A segment is mapped on demand and stays mapped as long as a payload refers to it.
+ *
+ * The log entries referring to a segment are counted with acquire() and release(), and the segment is removed when
+ * the last of them is trimmed. A segment acquired with its payload is written by a background writer, so generating
+ * a delta does no I/O, and the payload is served from memory until the segment is written. The counts are kept in
+ * memory and rebuilt by replaying the logs on restart.
+ */
+class BlobSegmentStore {
+private:
+    /** The directory of the segments */
+    const std::string path;
+    /** The counter to name the temporary files */
+    std::atomic<uint64_t> temp_counter;
+    /** The mapped segments by name, which are unmapped when the last payload referring to them is released. */
+    std::unordered_map<std::string, std::weak_ptr<const uint8_t>> mapped_segments;
+    std::mutex mapped_segments_mutex;
+    /** The segments waiting for the writer by name, with their payloads pinned until they are written. */
+    std::map<std::string, std::pair<BlobReference, std::shared_ptr<const uint8_t>>> pending_segments;
+    /** The numbers of log entries referring to the segments, by name. */
+    std::unordered_map<std::string, uint64_t> segment_refcounts;
+    /** The segment being written by the writer, or an empty string. */
+    std::string writing_segment;
+    bool writer_running;
+    std::mutex segments_mutex;
+    std::condition_variable segments_cv;
+    std::thread writer_thread;
+    /**
+     * The background writer, which writes the pending segments in the order of their names.
+     */
+    void writer();
+    /**
+     * Write a segment file, unless it exists.
+     *
+     * @throw std::runtime_error if the segment can not be written.
+     */
+    void write_segment(const std::string& name, const uint8_t* bytes, std::size_t size);
+
+public:
+    /**
+     * @brief   Constructor
+     *
+     * @param[in]   _path   The directory of the segments, which is created if it does not exist.
+     */
+    explicit BlobSegmentStore(const std::string& _path);
+
+    /**
+     * @brief   Destructor, which writes the pending segments before it returns.
+     */
+    virtual ~BlobSegmentStore();
+
+    /**
+     * @brief   Compute the reference to a payload without writing it.
+     *
+     * @param[in]   bytes   The payload
+     * @param[in]   size    The size of the payload
+     *
+     * @return the reference.
+     *
+     * @throw std::runtime_error if the payload can not be digested.
+     */
+    static BlobReference reference_of(const uint8_t* bytes, std::size_t size);
+
+    /**
+     * @brief   Write a payload to a segment, unless the segment exists. It is durable when this call returns.
+     *
+     * @param[in]   bytes   The payload
+     * @param[in]   size    The size of the payload
+     *
+     * @return the reference to the segment.
+     *
+     * @throw std::runtime_error if the segment can not be written.
+     */
+    BlobReference write(const uint8_t* bytes, std::size_t size);
+
+    /**
+     * @brief   Count a log entry referring to a segment. If the payload is given and the segment does not exist, the
+     *          segment is written by the background writer, and the payload is served from memory until then.
+     *
+     * @param[in]   reference   The reference to the segment
+     * @param[in]   payload     The payload of the segment, which is kept until the segment is written, or nullptr.
+     */
+    void acquire(const BlobReference& reference, const std::shared_ptr<const uint8_t>& payload = nullptr);
+
+    /**
+     * @brief   Release a log entry referring to a segment, which is trimmed from the log. The segment is removed when
+     *          no log entry refers to it. A mapped segment stays readable until it is unmapped.
+     *
+     * @param[in]   reference   The reference to the segment
+     */
+    void release(const BlobReference& reference);
+
+    /**
+     * @brief   Test if a segment is available on this node, either written or waiting for the writer.
+     *
+     * @param[in]   reference   The reference to the segment
+     *
+     * @return true if the segment can be mapped.
+     */
+    bool contains(const BlobReference& reference);
+
+    /**
+     * @brief   Map a segment read-only.
+     *
+     * @param[in]   reference   The reference to the segment
+     *
+     * @return the mapped payload, which unmaps the segment when the last copy is released.
+     *
+     * @throw std::runtime_error if the segment is missing or does not match the reference.
+     */
+    std::shared_ptr<const uint8_t> map(const BlobReference& reference);
+
+    /**
+     * @brief   Read a range of a segment, e.g. to send it to a node missing the segment.
+     *
+     * @param[in]   reference   The reference to the segment
+     * @param[in]   offset      The offset of the range
+     * @param[in]   max_length  The maximum length of the range
+     *
+     * @return the bytes of the range, which is empty if the segment is missing or the offset is at its end.
+     */
+    std::vector<uint8_t> read(const BlobReference& reference, uint64_t offset, uint64_t max_length);
+
+    /**
+     * @brief   Get the blob segment store of this process, in the directory of CASCADE_PERSISTENT_BLOB_PATH.
+     *
+     * @return the store.
+     */
+    static BlobSegmentStore& get();
+};
+
+}  // namespace cascade
+}  // namespace derecho
@@ -37,3 +37,4 @@
 #include "volatile_store.hpp"
 #include "persistent_store.hpp"
 #include "trigger_store.hpp"
+#include "compact_store.hpp"
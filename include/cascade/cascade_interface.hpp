@@ -6,12 +6,14 @@
  */
 
 #include <cascade/config.h>
+#include <cascade/detail/interned_key_map.hpp>
 
 #include <derecho/core/derecho.hpp>
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
 #include <derecho/persistent/Persistent.hpp>
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -29,6 +31,29 @@ namespace cascade {
 class ICascadeContext : public derecho::DeserializationContext {};
 
 #define CURRENT_VERSION (persistent::INVALID_VERSION)
+/**
+ * The version of the null object returned by a versioned or timestamped read of a PersistentCascadeStore, if the
+ * requested state is older than the log retention horizon and has been trimmed from the log.
+ */
+#define EXPIRED_VERSION (static_cast<persistent::version_t>(-2))
+
+/**
+ * @brief The log retention policy of an object pool in a PersistentCascadeStore subgroup.
+ * A version of an object expires as soon as one of the enabled limits expires it, while the latest version of an
+ * object never expires. 0 disables a limit.
+ */
+struct LogRetentionPolicy {
+    /** Keep the last `max_versions` versions of each object. */
+    uint64_t max_versions;
+    /** Keep the versions needed to read the object pool as of `max_age_sec` seconds ago. */
+    uint64_t max_age_sec;
+    /** Keep the newest versions of the object pool in a shard up to about `max_bytes` bytes. */
+    uint64_t max_bytes;
+
+    bool is_enabled() const {
+        return (max_versions > 0) || (max_age_sec > 0) || (max_bytes > 0);
+    }
+};
 
 /**
  * @brief CriticalDataPathObserver
@@ -67,6 +92,63 @@ public:
  */
 using version_tuple = std::tuple<persistent::version_t, uint64_t>;
 
+/**
+ * A page of keys and the cursor to continue the listing after it, which is empty after the last page.
+ * This is the return type of list_keys_paged.
+ */
+template <typename KT>
+using key_page_t = std::tuple<std::vector<KT>, std::string>;
+
+/**
+ * A page of the versions of a key, latest first, and the version to continue the history from, which is INVALID_VERSION
+ * after the last page. This is the return type of get_versions.
+ */
+template <typename VT>
+using version_page_t = std::tuple<std::vector<VT>, persistent::version_t>;
+
+/**
+ * A page of the objects of a scan, in key order, and the cursor to continue the scan after it, which is empty after
+ * the last page. This is the return type of scan.
+ */
+template <typename VT>
+using scan_page_t = std::tuple<std::vector<VT>, std::string>;
+
+/**
+ * The metadata of an object without its payload. This is the return type of head and head_batch.
+ * A key that is not found has `version == INVALID_VERSION`; a removed key has the version of the removal and
+ * `is_null == true`. The fields an object type does not keep are INVALID_VERSION or 0.
+ */
+class ObjectHead : public mutils::ByteRepresentable {
+public:
+    /* the version of the object */
+    persistent::version_t version;
+    /* the timestamp of the object in microseconds */
+    uint64_t timestamp_us;
+    /* the previous version in the shard */
+    persistent::version_t previous_version;
+    /* the previous version of the same key */
+    persistent::version_t previous_version_by_key;
+    /* the size of the payload in bytes */
+    uint64_t payload_size;
+    /* true if the object is a null object, i.e. the key is not found or removed */
+    bool is_null;
+
+    DEFAULT_SERIALIZATION_SUPPORT(ObjectHead, version, timestamp_us, previous_version, previous_version_by_key,
+                                  payload_size, is_null);
+
+    ObjectHead(persistent::version_t _version = persistent::INVALID_VERSION,
+               uint64_t _timestamp_us = 0,
+               persistent::version_t _previous_version = persistent::INVALID_VERSION,
+               persistent::version_t _previous_version_by_key = persistent::INVALID_VERSION,
+               uint64_t _payload_size = 0,
+               bool _is_null = true) : version(_version),
+                                       timestamp_us(_timestamp_us),
+                                       previous_version(_previous_version),
+                                       previous_version_by_key(_previous_version_by_key),
+                                       payload_size(_payload_size),
+                                       is_null(_is_null) {}
+};
+
 /**
  * @brief   The cascade store interface.
  * This interface is for different Cascade Subgroup Types which provides different persistence guarantees.
@@ -116,6 +198,21 @@ public:
      */
     virtual void put_and_forget(const VT& value, bool as_trigger) const = 0;
 
+    /**
+     * @brief   put_batch(const std::vector<VT>&, bool)
+     *
+     * Put a batch of values atomically in a single ordered send. All values are applied under one version, and the
+     * batch is rejected as a whole if any of them fails validation or the previous version check, or if two of them
+     * have the same key.
+     *
+     * @param[in]   values      The K/V pair values
+     * @param[in]   as_trigger  The objects will NOT be used to update the K/V state.
+     *
+     * @return      a tuple including version number (version_t) and a timestamp in microseconds, or an invalid
+     *              version if the batch is rejected.
+     */
+    virtual version_tuple put_batch(const std::vector<VT>& values, bool as_trigger) const = 0;
+
 #ifdef ENABLE_EVALUATION
     /**
      * @brief   A function to evaluate the performance of an internal shard
@@ -164,6 +261,24 @@ public:
      */
     virtual const VT get(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const = 0;
 
+    /**
+     * @brief   get_range(const KT&,const persistent::version_t&,const bool,const uint64_t&,const uint64_t&)
+     *
+     * Get a value by key and version, like `get` with `exact == false`, with only a byte range of its payload. The
+     * range is clipped to the end of the payload. The range of a stored payload is a slice of it instead of a copy,
+     * and the range of a historical version is the only part of the payload copied out of the log.
+     *
+     * @param[in]   key     The key of the K/V pair to be retrieved.
+     * @param[in]   ver     Version: if `version == CURRENT_VERSION`, get the latest value.
+     * @param[in]   stable  return the stablized data
+     * @param[in]   offset  The offset of the range in the payload
+     * @param[in]   length  The length of the range
+     *
+     * @return A value with the range of its payload.
+     */
+    virtual const VT get_range(const KT& key, const persistent::version_t& ver, const bool stable,
+                               const uint64_t& offset, const uint64_t& length) const = 0;
+
     /**
      * @brief   multi_get(const KT&)
      *
@@ -253,6 +368,48 @@ public:
      */
     virtual std::vector<KT> list_keys_by_time(const std::string& prefix, const uint64_t& ts_us, const bool stable) const = 0;
 
+    /**
+     * @brief   list_keys_paged(const std::string&, const std::string&, const uint32_t&)
+     *
+     * List keys a page at a time, in key order, so that neither side holds the keys of the whole shard. A listing
+     * starts with an empty cursor and continues with the cursor returned with each page until it is empty. The
+     * cursor fixes the version the first page is listed at, and the stores which keep versions list the later pages
+     * at the same version.
+     *
+     * @param[in]   prefix      Prefix, only the key matching this prefix will be returned.
+     *                          Empty prefix matches all keys.
+     * @param[in]   cursor      The cursor returned with the previous page, or empty for the first page.
+     * @param[in]   limit       The maximum number of keys in the page, which must be positive.
+     *
+     * @return  A page of keys and the cursor of the next page, which is empty if this is the last page. The page is
+     *          empty with an empty cursor if the cursor is malformed, or if its version is trimmed from the log.
+     */
+    virtual key_page_t<KT> list_keys_paged(const std::string& prefix, const std::string& cursor, const uint32_t& limit) const = 0;
+
+    /**
+     * @brief   scan(const std::string&, const std::string&, const std::string&, const std::string&, const uint32_t&)
+     *
+     * Scan the latest objects of the keys matching a prefix on this replica, returning those matching a filter with
+     * their payload projected. The filter and the projection are evaluated here, so that only the matching objects,
+     * trimmed to the projected bytes, are sent back. See ScanFilter and ScanProjection for the expressions. A page
+     * stops at `max_results` objects or at the P2P reply budget, and a scan continues with the cursor returned with
+     * each page until it is empty, like list_keys_paged. Each page reads the latest objects.
+     *
+     * @param[in]   prefix      The prefix, only the key matching this prefix will be scanned.
+     *                          Empty prefix matches all keys.
+     * @param[in]   filter      The filter expression, empty to match all objects.
+     * @param[in]   projection  The projection expression, empty to return the whole payload.
+     * @param[in]   cursor      The cursor returned with the previous page, or empty for the first page.
+     * @param[in]   max_results The maximum number of objects in the page, 0 for no limit but the reply budget.
+     *
+     * @return  A page of the matching objects in key order, and the cursor of the next page, which is empty if this is
+     *          the last page.
+     *
+     * @throw   std::runtime_error if the filter, the projection or the cursor is invalid on this replica.
+     */
+    virtual scan_page_t<VT> scan(const std::string& prefix, const std::string& filter, const std::string& projection,
+                                 const std::string& cursor, const uint32_t& max_results) const = 0;
+
     /**
      * @brief multi_get_size(const KT&)
      *
@@ -302,6 +459,34 @@ public:
      */
     virtual uint64_t get_size_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const = 0;
 
+    /**
+     * @brief   head(const KT&,const persistent::version_t&,const bool)
+     *
+     * Get the metadata of an object by version, without copying its payload. The version is resolved like `get`
+     * with `exact == false`.
+     *
+     * @param[in]   key     The key
+     * @param[in]   ver     Version, if `ver == CURRENT_VERSION`, get the latest object.
+     * @param[in]   stable  return the stablized data
+     *
+     * @return  The metadata of the object.
+     */
+    virtual ObjectHead head(const KT& key, const persistent::version_t& ver, const bool stable) const = 0;
+
+    /**
+     * @brief   head_batch(const std::vector<KT>&,const persistent::version_t&,const bool)
+     *
+     * Get the metadata of a batch of objects in the shard, like `head`, in one RPC.
+     *
+     * @param[in]   keys    The keys
+     * @param[in]   ver     Version, if `ver == CURRENT_VERSION`, get the latest objects.
+     * @param[in]   stable  return the stablized data
+     *
+     * @return  The metadata of the objects, in the order of the keys.
+     */
+    virtual std::vector<ObjectHead> head_batch(const std::vector<KT>& keys, const persistent::version_t& ver,
+                                               const bool stable) const = 0;
+
     /**
      * @brief   trigger_put(const VT& value)
      *
@@ -353,6 +538,16 @@ protected:
      */
     virtual void ordered_put_and_forget(const VT& value, bool as_trigger) = 0;
 
+    /**
+     * @brief   ordered_put_batch
+     *
+     * @param[in]   values      The K/V pair objects, with distinct keys.
+     * @param[in]   as_trigger  If true, the values will NOT apply to the K/V state.
+     *
+     * @return  A tuple including version number (version_t) and a timestamp in microseconds.
+     */
+    virtual version_tuple ordered_put_batch(const std::vector<VT>& values, bool as_trigger) = 0;
+
     /**
      * @brief   ordered_remove
      *
@@ -580,6 +775,11 @@ public:
  * For example, a VT object can override the default 'overwriting' behaviour by refusing an object whose key has
  * already existed in the kv_map.
  *
+ * The stores keep the k/v map as a `key_value_map_t<KT,VT>`, which stores pathname keys interned as `InternedPathname`,
+ * and call 'validate_stored' with it. Its default implementation calls 'validate' with a copy of the map as a
+ * `std::map<KT,VT>` when the keys are interned, so an existing validator keeps working unchanged; a validator that is
+ * called on large maps overrides 'validate_stored' to avoid the copy.
+ *
  * @tparam  KT      The key type
  * @tparam  VT      The value type
  */
@@ -590,11 +790,154 @@ public:
     /**
      * @brief   A callback on PersistentCascadeStore::ordered_put or VolatileCascadeStore::ordered_put.
      *
-     * @param[in]   kv_map      The reference to the current shard state as a map from `KT` to `VT`.
+     * @param[in]   kv_map      The reference to the current shard state.
      *
      * @return  Returns `true` if validation is successful, otherwise, `false`.
      */
     virtual bool validate(const std::map<KT, VT>& kv_map) const = 0;
+
+    /**
+     * @brief   The callback the stores call, with the shard state as it is stored.
+     *
+     * @param[in]   kv_map      The reference to the current shard state as a map from the stored `KT` to `VT`.
+     *
+     * @return  Returns `true` if validation is successful, otherwise, `false`.
+     */
+    virtual bool validate_stored(const key_value_map_t<KT, VT>& kv_map) const {
+        if constexpr(std::is_same_v<key_value_map_t<KT, VT>, std::map<KT, VT>>) {
+            return validate(kv_map);
+        } else {
+            return validate(std::map<KT, VT>(kv_map.cbegin(), kv_map.cend()));
+        }
+    }
+};
+
+/**
+ * @brief   An optional interface for Cascade objects to share their payload between copies.
+ *
+ * If the VT type for PersistentCascadeStore/VolatileCascadeStore implements ISharePayload interface, its
+ * 'share_payload' method will be called on the copy of the object kept in the k/v map. After that, the payload is an
+ * immutable, reference-counted buffer, and a copy of the object, like the one returned by `get`, pins the buffer
+ * instead of copying it. The buffer is released when the last copy is destroyed.
+ */
+class ISharePayload {
+public:
+
+    /**
+     * @brief   Turn the payload into an immutable, reference-counted buffer.
+     */
+    virtual void share_payload() = 0;
+};
+
+/**
+ * @brief   An optional interface for Cascade objects to support partial updates.
+ *
+ * If the VT type for PersistentCascadeStore implements IPatchPayload interface, an object can carry a byte range patch
+ * of the payload of the current version of its key, as the argument of `put_range`. The persistent log then stores the
+ * patch instead of the full image, and a historical read reconstructs the image by applying the patches onto the last
+ * full image of the key.
+ */
+class IPatchPayload {
+public:
+    /** The offset to append a patch to the end of the payload. */
+    static constexpr uint64_t APPEND_OFFSET = 0xffffffffffffffffull;
+
+    /**
+     * @brief   Get the payload bytes.
+     *
+     * @return  the payload bytes, or nullptr if the payload is empty or not instantiated yet.
+     */
+    virtual const uint8_t* get_payload_bytes() const = 0;
+
+    /**
+     * @brief   Get the payload size.
+     *
+     * @return  the size of the payload in bytes.
+     */
+    virtual std::size_t get_payload_size() const = 0;
+
+    /**
+     * @brief   Turn the payload, which holds a patch, into the patched image of a base payload: the patch overwrites
+     *          the base at `offset`, extending it if the patch runs past its end.
+     *
+     * @param[in]   base        The base payload
+     * @param[in]   base_size   The size of the base payload
+     * @param[in]   offset      The offset of the patch in the base payload, no larger than base_size.
+     */
+    virtual void patch_payload(const uint8_t* base, std::size_t base_size, std::size_t offset) = 0;
+
+    /**
+     * @brief   Keep only a range of the payload.
+     *
+     * @param[in]   offset      The offset of the range
+     * @param[in]   size        The size of the range
+     */
+    virtual void trim_payload(std::size_t offset, std::size_t size) = 0;
+};
+
+/**
+ * @brief   An optional interface for Cascade objects to keep large payloads out of the persistent log.
+ *
+ * If the VT type for PersistentCascadeStore implements IExternalPayload interface, a payload larger than the blob
+ * threshold of its object pool is written to a content-addressed blob segment, and the persistent log stores only a
+ * reference to the segment. An object read from the log gets the segment attached, which is mapped on demand.
+ */
+class IExternalPayload {
+public:
+    /**
+     * @brief   Get the payload bytes.
+     *
+     * @return  the payload bytes, or nullptr if the payload is empty or not instantiated yet.
+     */
+    virtual const uint8_t* get_payload_bytes() const = 0;
+
+    /**
+     * @brief   Get the payload size.
+     *
+     * @return  the size of the payload in bytes.
+     */
+    virtual std::size_t get_payload_size() const = 0;
+
+    /**
+     * @brief   Replace the payload with an immutable buffer, which is pinned instead of copied.
+     *
+     * @param[in]   bytes       The buffer, or nullptr for an empty payload
+     * @param[in]   size        The size of the buffer
+     */
+    virtual void attach_payload(const std::shared_ptr<const uint8_t>& bytes, std::size_t size) = 0;
+};
+
+/**
+ * @brief   An optional interface for Cascade objects to support merge operators.
+ *
+ * If the VT type for PersistentCascadeStore/VolatileCascadeStore implements IMergePayload interface, an object can
+ * carry the operand of a merge operator registered in MergeOperatorRegistry, as the argument of `merge`. The store
+ * computes the new payload from the current object of the key and the operand on the ordered path, so a
+ * read-modify-write takes one ordered message.
+ */
+class IMergePayload {
+public:
+    /**
+     * @brief   Get the payload bytes.
+     *
+     * @return  the payload bytes, or nullptr if the payload is empty or not instantiated yet.
+     */
+    virtual const uint8_t* get_payload_bytes() const = 0;
+
+    /**
+     * @brief   Get the payload size.
+     *
+     * @return  the size of the payload in bytes.
+     */
+    virtual std::size_t get_payload_size() const = 0;
+
+    /**
+     * @brief   Replace the payload with a copy of a buffer.
+     *
+     * @param[in]   bytes       The buffer
+     * @param[in]   size        The size of the buffer
+     */
+    virtual void set_payload(const uint8_t* bytes, std::size_t size) = 0;
 };
 
 #ifdef ENABLE_EVALUATION
@@ -0,0 +1,132 @@
+#pragma once
+
+/**
+ * @file    chunked_object.hpp
+ * @brief   The manifest of a large object stored in chunks by ServiceClient::put_chunked.
+ */
+
+#include "detail/message_limits.hpp"
+
+#include <derecho/mutils-serialization/SerializationSupport.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * The size in bytes of the chunks of a large object. A chunk travels in the P2P request of a put, the ordered message
+ * delivering it and the P2P reply of a get, so the chunk size is capped by max_chunk_size(). If it is not set, the
+ * chunks are as large as max_chunk_size().
+ */
+#define CASCADE_CHUNK_SIZE                      "CASCADE/chunk_size_bytes"
+/**
+ * The maximum number of chunk puts or gets of a large object in flight at the same time.
+ */
+#define CASCADE_CHUNK_PARALLELISM               "CASCADE/chunk_parallelism"
+#define CASCADE_CHUNK_PARALLELISM_DEFAULT       (16)
+/**
+ * The separator between the key of a chunked object and the rest of its chunk prefix.
+ */
+#define CASCADE_CHUNK_KEY_SEPARATOR             "#chunk-"
+
+/**
+ * Get the largest chunk that fits in the P2P request, the ordered message and the P2P reply carrying it, see
+ * message_limits.hpp. The budgets leave room for the fixed fields of an object, but not for its key.
+ *
+ * @param[in]   chunk_key_size  The size of the longest chunk key.
+ *
+ * @return the maximum chunk size in bytes.
+ */
+inline uint64_t max_chunk_size(std::size_t chunk_key_size) {
+    const uint64_t budget = std::min({p2p_request_payload_budget(), ordered_payload_budget(), p2p_reply_payload_budget()});
+    // a serialized key takes its characters and a terminator.
+    const uint64_t key_bytes = chunk_key_size + sizeof(uint64_t);
+    return (budget > 2 * key_bytes) ? (budget - key_bytes) : (budget / 2);
+}
+
+/**
+ * @brief   The manifest of a chunked object.
+ *
+ * A large object is stored as chunks of `chunk_size` bytes under the keys `chunk_prefix` + chunk index, and the
+ * manifest is stored under the key of the object. The chunk keys are in the object pool of the object, so they are
+ * striped across the shards by hashing, or kept together if the affinity set regex of the object pool maps them to
+ * one affinity set. Each put of a chunked object uses a new chunk prefix, so a reader never mixes the chunks of two
+ * puts.
+ */
+class ChunkedObjectManifest : public mutils::ByteRepresentable {
+public:
+    static constexpr uint64_t MAGIC = 0x4b4e484353414353ull;  // "SCASCHNK"
+
+    /* MAGIC, which tells a manifest from the payload of an ordinary object */
+    uint64_t magic;
+    /* the size of the object in bytes */
+    uint64_t object_size;
+    /* the size of the chunks in bytes, where the last chunk may be smaller */
+    uint64_t chunk_size;
+    /* the key of chunk i is chunk_prefix + std::to_string(i) */
+    std::string chunk_prefix;
+
+    DEFAULT_SERIALIZATION_SUPPORT(ChunkedObjectManifest, magic, object_size, chunk_size, chunk_prefix);
+
+    ChunkedObjectManifest(uint64_t _magic = MAGIC,
+                          uint64_t _object_size = 0,
+                          uint64_t _chunk_size = 0,
+                          const std::string& _chunk_prefix = "") : magic(_magic),
+                                                                   object_size(_object_size),
+                                                                   chunk_size(_chunk_size),
+                                                                   chunk_prefix(_chunk_prefix) {}
+
+    /**
+     * @return the number of chunks.
+     */
+    uint64_t num_chunks() const {
+        return (chunk_size == 0) ? 0 : (object_size + chunk_size - 1) / chunk_size;
+    }
+
+    /**
+     * @param[in]   index   The chunk index
+     *
+     * @return the key of a chunk.
+     */
+    std::string chunk_key(uint64_t index) const {
+        return chunk_prefix + std::to_string(index);
+    }
+
+    /**
+     * @param[in]   index   The chunk index
+     *
+     * @return the size of a chunk in bytes.
+     */
+    uint64_t chunk_bytes(uint64_t index) const {
+        return std::min(chunk_size, object_size - index * chunk_size);
+    }
+
+    /**
+     * Test if a payload is a manifest.
+     *
+     * @param[in]   bytes   The payload
+     * @param[in]   size    The size of the payload
+     *
+     * @return true if the payload is a serialized manifest.
+     */
+    static bool is_manifest(const uint8_t* bytes, std::size_t size) {
+        uint64_t magic;
+        // three integers followed by a null-terminated string.
+        if(bytes == nullptr || size <= 3 * sizeof(uint64_t) || bytes[size - 1] != 0) {
+            return false;
+        }
+        memcpy(&magic, bytes, sizeof(magic));
+        if(magic != MAGIC) {
+            return false;
+        }
+        auto manifest = mutils::from_bytes<ChunkedObjectManifest>(nullptr, bytes);
+        return mutils::bytes_size(*manifest) == size && manifest->chunk_size > 0;
+    }
+};
+
+}  // namespace cascade
+}  // namespace derecho
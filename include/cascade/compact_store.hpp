@@ -0,0 +1,407 @@
+#pragma once
+
+#include "cascade/config.h"
+#include "cascade_interface.hpp"
+#include "detail/compact_delta_store_core.hpp"
+#include "detail/flat_uint64_table.hpp"
+#include "detail/key_page_cursor.hpp"
+#include "detail/object_head.hpp"
+#include "detail/payload_range.hpp"
+#include "detail/scan_object.hpp"
+
+#include <derecho/core/derecho.hpp>
+#include <derecho/mutils-serialization/SerializationSupport.hpp>
+#include <derecho/persistent/Persistent.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * template volatile compact cascade stores.
+ *
+ * VolatileCompactCascadeStore keeps objects with uint64_t keys in a FlatUInt64Table instead of a std::map of objects,
+ * which takes 32 bytes per key plus the payload, and keeps payloads of at most FlatUInt64Table::INLINE_PAYLOAD_BYTES
+ * bytes in the table. For small objects it takes several times less memory than a VolatileCascadeStore. In return, it
+ * keeps only the key, version, timestamp and payload of an object: an object read from it has no previous versions.
+ * Removing a key drops it, so a removed key is not distinguished from one that never existed. Object pool features,
+ * i.e. memory budgets and TTLs, and versioned or timed reads are not supported.
+ *
+ * P2P reads take a shared lock of the table, and the ordered path takes it exclusively to update the table. The whole
+ * table is sent to joining members in the view change.
+ *
+ * @tparam KT   - the key type, which must be uint64_t
+ * @tparam VT   - the object type, which must implement IMergePayload to get and set the payload
+ * @tparam IK   - a pointer to the invalid key
+ * @tparam IV   - a pointer to the invalid object
+ */
+template <typename KT, typename VT, KT* IK, VT* IV>
+class VolatileCompactCascadeStore : public ICascadeStore<KT, VT, IK, IV>,
+                                    public mutils::ByteRepresentable,
+                                    public derecho::GroupReference,
+                                    public derecho::NotificationSupport {
+    static_assert(std::is_same<KT, uint64_t>::value, "VolatileCompactCascadeStore only supports uint64_t keys.");
+    static_assert(std::is_base_of<IMergePayload, VT>::value, "VolatileCompactCascadeStore requires VT to implement IMergePayload.");
+
+private:
+    /**
+     * Apply an object under the current version.
+     *
+     * @return false if the object is rejected by the previous version check.
+     */
+    bool internal_ordered_put(const VT& value, bool as_trigger);
+    /**
+     * Apply a batch of objects under the current version, all or nothing.
+     *
+     * @return false if the batch is rejected.
+     */
+    bool internal_ordered_put_batch(const std::vector<VT>& values, bool as_trigger);
+    /**
+     * Build an object from its entry in kv_table.
+     */
+    static VT to_object(const KT& key, const FlatUInt64Table::View& view);
+    /**
+     * Read the object of a key.
+     *
+     * @return the object, or *IV if the key is not in kv_table.
+     */
+    VT read_object(const KT& key) const;
+    /* protects kv_table from P2P readers while the ordered path updates it */
+    mutable std::shared_mutex kv_table_mutex;
+
+public:
+    /* group reference */
+    using derecho::GroupReference::group;
+    /* the objects */
+    FlatUInt64Table kv_table;
+    /* record the version of latest update */
+    persistent::version_t update_version;
+    /* watcher */
+    CriticalDataPathObserver<VolatileCompactCascadeStore<KT, VT, IK, IV>>* cascade_watcher_ptr;
+    /* cascade context */
+    ICascadeContext* cascade_context_ptr;
+
+    REGISTER_RPC_FUNCTIONS_WITH_NOTIFICATION(VolatileCompactCascadeStore,
+                                             P2P_TARGETS(
+                                                     put,
+                                                     put_and_forget,
+                                                     put_batch,
+#ifdef ENABLE_EVALUATION
+                                                     perf_put,
+#endif
+                                                     remove,
+                                                     get,
+                                                     get_range,
+                                                     multi_get,
+                                                     get_by_time,
+                                                     multi_list_keys,
+                                                     list_keys,
+                                                     list_keys_by_time,
+                                                     list_keys_paged,
+                                                     scan,
+                                                     multi_get_size,
+                                                     get_size,
+                                                     get_size_by_time,
+                                                     head,
+                                                     head_batch,
+                                                     trigger_put,
+                                                     get_memory_usage
+#ifdef ENABLE_EVALUATION
+                                                     ,
+                                                     dump_timestamp_log
+#ifdef DUMP_TIMESTAMP_WORKAROUND
+                                                     ,
+                                                     dump_timestamp_log_workaround
+#endif
+#endif  // ENABLE_EVALUATION
+                                                     ),
+                                             ORDERED_TARGETS(
+                                                     ordered_put,
+                                                     ordered_put_and_forget,
+                                                     ordered_put_batch,
+                                                     ordered_remove,
+                                                     ordered_get,
+                                                     ordered_list_keys,
+                                                     ordered_get_size
+#ifdef ENABLE_EVALUATION
+                                                     ,
+                                                     ordered_dump_timestamp_log
+#endif  // ENABLE_EVALUATION
+                                                     ));
+#ifdef ENABLE_EVALUATION
+    virtual void dump_timestamp_log(const std::string& filename) const override;
+#ifdef DUMP_TIMESTAMP_WORKAROUND
+    virtual void dump_timestamp_log_workaround(const std::string& filename) const override;
+#endif
+#endif  // ENABLE_EVALUATION
+    virtual void trigger_put(const VT& value) const override;
+    virtual version_tuple put(const VT& value, bool as_trigger) const override;
+#ifdef ENABLE_EVALUATION
+    virtual double perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const override;
+#endif  // ENABLE_EVALUATION
+    virtual void put_and_forget(const VT& value, bool as_trigger) const override;
+    virtual version_tuple put_batch(const std::vector<VT>& values, bool as_trigger) const override;
+    virtual version_tuple remove(const KT& key) const override;
+    virtual const VT get(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
+    virtual const VT get_range(const KT& key, const persistent::version_t& ver, const bool stable,
+                               const uint64_t& offset, const uint64_t& length) const override;
+    virtual const VT multi_get(const KT& key) const override;
+    virtual const VT get_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
+    virtual std::vector<KT> multi_list_keys(const std::string& prefix) const override;
+    virtual std::vector<KT> list_keys(const std::string& prefix, const persistent::version_t& ver, const bool stable) const override;
+    virtual std::vector<KT> list_keys_by_time(const std::string& prefix, const uint64_t& ts_us, const bool stable) const override;
+    virtual key_page_t<KT> list_keys_paged(const std::string& prefix, const std::string& cursor, const uint32_t& limit) const override;
+    virtual scan_page_t<VT> scan(const std::string& prefix, const std::string& filter, const std::string& projection,
+                                 const std::string& cursor, const uint32_t& max_results) const override;
+    virtual uint64_t multi_get_size(const KT& key) const override;
+    virtual uint64_t get_size(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
+    virtual uint64_t get_size_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
+    virtual ObjectHead head(const KT& key, const persistent::version_t& ver, const bool stable) const override;
+    virtual std::vector<ObjectHead> head_batch(const std::vector<KT>& keys, const persistent::version_t& ver,
+                                               const bool stable) const override;
+    virtual version_tuple ordered_put(const VT& value, bool as_trigger) override;
+    virtual void ordered_put_and_forget(const VT& value, bool as_trigger) override;
+    virtual version_tuple ordered_put_batch(const std::vector<VT>& values, bool as_trigger) override;
+    virtual version_tuple ordered_remove(const KT& key) override;
+    virtual const VT ordered_get(const KT& key) override;
+    virtual std::vector<KT> ordered_list_keys(const std::string& prefix) override;
+    virtual uint64_t ordered_get_size(const KT& key) override;
+#ifdef ENABLE_EVALUATION
+    virtual void ordered_dump_timestamp_log(const std::string& filename) override;
+#endif  // ENABLE_EVALUATION
+
+    /**
+     * Get the memory used by the objects on this member.
+     *
+     * @return the number of keys and the bytes used by kv_table.
+     */
+    std::pair<uint64_t, uint64_t> get_memory_usage() const;
+
+    // serialization support
+    std::size_t to_bytes(uint8_t* buf) const;
+    std::size_t bytes_size() const;
+    void post_object(const std::function<void(uint8_t const* const, std::size_t)>& f) const;
+
+    static std::unique_ptr<VolatileCompactCascadeStore> from_bytes(mutils::DeserializationManager* dsm, uint8_t const* buf);
+
+    DEFAULT_DESERIALIZE_NOALLOC(VolatileCompactCascadeStore);
+
+    void ensure_registered(mutils::DeserializationManager&) {}
+
+    /* constructors */
+    VolatileCompactCascadeStore(CriticalDataPathObserver<VolatileCompactCascadeStore<KT, VT, IK, IV>>* cw = nullptr,
+                                ICascadeContext* cc = nullptr);
+    VolatileCompactCascadeStore(FlatUInt64Table&& _kvt,
+                                persistent::version_t _uv,
+                                CriticalDataPathObserver<VolatileCompactCascadeStore<KT, VT, IK, IV>>* cw = nullptr,
+                                ICascadeContext* cc = nullptr);  // move kv_table
+};
+
+/**
+ * template persistent compact cascade stores.
+ *
+ * PersistentCompactCascadeStore is the persistent counterpart of VolatileCompactCascadeStore. The objects are kept in a
+ * FlatUInt64Table in the CompactDeltaStoreCore of a Persistent<T>, and each ordered update is logged as a compact delta
+ * with 24 bytes per object besides its payload, so a restarted node rebuilds the table by replaying its log.
+ *
+ * A versioned read finds the version of the key in the log: an exact read reads the log entry of the version, and
+ * other reads follow the previous versions of the key back from its current version. Removing a key drops it from the
+ * table, so a versioned read of a key that is removed now, or of a version before a removal, finds nothing. A versioned
+ * list_keys is not supported, and neither are the object pool features, as in VolatileCompactCascadeStore.
+ *
+ * @tparam KT   - the key type, which must be uint64_t
+ * @tparam VT   - the object type, which must implement IMergePayload to get and set the payload
+ * @tparam IK   - a pointer to the invalid key
+ * @tparam IV   - a pointer to the invalid object
+ * @tparam ST   - the storage type of the log
+ */
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST = persistent::ST_FILE>
+class PersistentCompactCascadeStore : public ICascadeStore<KT, VT, IK, IV>,
+                                      public mutils::ByteRepresentable,
+                                      public derecho::PersistsFields,
+                                      public derecho::GroupReference,
+                                      public derecho::NotificationSupport {
+    static_assert(std::is_same<KT, uint64_t>::value, "PersistentCompactCascadeStore only supports uint64_t keys.");
+    static_assert(std::is_base_of<IMergePayload, VT>::value, "PersistentCompactCascadeStore requires VT to implement IMergePayload.");
+
+private:
+    /**
+     * Apply an object under the current version.
+     *
+     * @return false if the object is rejected by the previous version check.
+     */
+    bool internal_ordered_put(const VT& value, bool as_trigger);
+    /**
+     * Apply a batch of objects under the current version, all or nothing.
+     *
+     * @return false if the batch is rejected.
+     */
+    bool internal_ordered_put_batch(const std::vector<VT>& values, bool as_trigger);
+    /**
+     * Build an object from its entry in kv_table or in the log.
+     */
+    static VT to_object(const KT& key, const FlatUInt64Table::View& view);
+    /**
+     * Read the current object of a key.
+     *
+     * @return the object, or *IV if the key is not in kv_table.
+     */
+    VT read_object(const KT& key) const;
+    /**
+     * Resolve the version a read asks for. A stable read of the current version reads the global persistence frontier,
+     * and a stable read of a version waits for it to be persisted.
+     *
+     * @param ver       The version asked for, or CURRENT_VERSION
+     * @param stable    If the read is stable
+     *
+     * @return the version to read, CURRENT_VERSION for the current state, or INVALID_VERSION if the version is in the
+     *         future.
+     */
+    persistent::version_t resolve_version(const persistent::version_t& ver, const bool stable) const;
+    /**
+     * Read the object of a key at a version in the log.
+     *
+     * @param key       The key
+     * @param ver       The version, which is not CURRENT_VERSION
+     * @param exact     If true, only the log entry of the version is read.
+     *
+     * @return a copy of the object, which does not rely on the log, the null object of its removal, or *IV if it is
+     *         not found.
+     */
+    VT read_object(const KT& key, persistent::version_t ver, bool exact) const;
+
+public:
+    /* group reference */
+    using derecho::GroupReference::group;
+    /* the objects and the log */
+    persistent::Persistent<CompactDeltaStoreCore, ST> persistent_core;
+    /* watcher */
+    CriticalDataPathObserver<PersistentCompactCascadeStore<KT, VT, IK, IV>>* cascade_watcher_ptr;
+    /* cascade context */
+    ICascadeContext* cascade_context_ptr;
+
+    REGISTER_RPC_FUNCTIONS_WITH_NOTIFICATION(PersistentCompactCascadeStore,
+                                             P2P_TARGETS(
+                                                     put,
+                                                     put_and_forget,
+                                                     put_batch,
+#ifdef ENABLE_EVALUATION
+                                                     perf_put,
+#endif
+                                                     remove,
+                                                     get,
+                                                     get_range,
+                                                     multi_get,
+                                                     get_by_time,
+                                                     multi_list_keys,
+                                                     list_keys,
+                                                     list_keys_by_time,
+                                                     list_keys_paged,
+                                                     scan,
+                                                     multi_get_size,
+                                                     get_size,
+                                                     get_size_by_time,
+                                                     head,
+                                                     head_batch,
+                                                     trigger_put,
+                                                     get_memory_usage
+#ifdef ENABLE_EVALUATION
+                                                     ,
+                                                     dump_timestamp_log
+#ifdef DUMP_TIMESTAMP_WORKAROUND
+                                                     ,
+                                                     dump_timestamp_log_workaround
+#endif
+#endif  // ENABLE_EVALUATION
+                                                     ),
+                                             ORDERED_TARGETS(
+                                                     ordered_put,
+                                                     ordered_put_and_forget,
+                                                     ordered_put_batch,
+                                                     ordered_remove,
+                                                     ordered_get,
+                                                     ordered_list_keys,
+                                                     ordered_get_size
+#ifdef ENABLE_EVALUATION
+                                                     ,
+                                                     ordered_dump_timestamp_log
+#endif  // ENABLE_EVALUATION
+                                                     ));
+#ifdef ENABLE_EVALUATION
+    virtual void dump_timestamp_log(const std::string& filename) const override;
+#ifdef DUMP_TIMESTAMP_WORKAROUND
+    virtual void dump_timestamp_log_workaround(const std::string& filename) const override;
+#endif
+#endif  // ENABLE_EVALUATION
+    virtual void trigger_put(const VT& value) const override;
+    virtual version_tuple put(const VT& value, bool as_trigger) const override;
+#ifdef ENABLE_EVALUATION
+    virtual double perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const override;
+#endif  // ENABLE_EVALUATION
+    virtual void put_and_forget(const VT& value, bool as_trigger) const override;
+    virtual version_tuple put_batch(const std::vector<VT>& values, bool as_trigger) const override;
+    virtual version_tuple remove(const KT& key) const override;
+    virtual const VT get(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
+    virtual const VT get_range(const KT& key, const persistent::version_t& ver, const bool stable,
+                               const uint64_t& offset, const uint64_t& length) const override;
+    virtual const VT multi_get(const KT& key) const override;
+    virtual const VT get_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
+    virtual std::vector<KT> multi_list_keys(const std::string& prefix) const override;
+    virtual std::vector<KT> list_keys(const std::string& prefix, const persistent::version_t& ver, const bool stable) const override;
+    virtual std::vector<KT> list_keys_by_time(const std::string& prefix, const uint64_t& ts_us, const bool stable) const override;
+    virtual key_page_t<KT> list_keys_paged(const std::string& prefix, const std::string& cursor, const uint32_t& limit) const override;
+    virtual scan_page_t<VT> scan(const std::string& prefix, const std::string& filter, const std::string& projection,
+                                 const std::string& cursor, const uint32_t& max_results) const override;
+    virtual uint64_t multi_get_size(const KT& key) const override;
+    virtual uint64_t get_size(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
+    virtual uint64_t get_size_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
+    virtual ObjectHead head(const KT& key, const persistent::version_t& ver, const bool stable) const override;
+    virtual std::vector<ObjectHead> head_batch(const std::vector<KT>& keys, const persistent::version_t& ver,
+                                               const bool stable) const override;
+    virtual version_tuple ordered_put(const VT& value, bool as_trigger) override;
+    virtual void ordered_put_and_forget(const VT& value, bool as_trigger) override;
+    virtual version_tuple ordered_put_batch(const std::vector<VT>& values, bool as_trigger) override;
+    virtual version_tuple ordered_remove(const KT& key) override;
+    virtual const VT ordered_get(const KT& key) override;
+    virtual std::vector<KT> ordered_list_keys(const std::string& prefix) override;
+    virtual uint64_t ordered_get_size(const KT& key) override;
+#ifdef ENABLE_EVALUATION
+    virtual void ordered_dump_timestamp_log(const std::string& filename) override;
+#endif  // ENABLE_EVALUATION
+
+    /**
+     * Get the memory used by the objects on this member.
+     *
+     * @return the number of keys and the bytes used by the table of the objects.
+     */
+    std::pair<uint64_t, uint64_t> get_memory_usage() const;
+
+    // serialization support
+    DEFAULT_SERIALIZE(persistent_core);
+
+    static std::unique_ptr<PersistentCompactCascadeStore> from_bytes(mutils::DeserializationManager* dsm, uint8_t const* buf);
+
+    DEFAULT_DESERIALIZE_NOALLOC(PersistentCompactCascadeStore);
+
+    void ensure_registered(mutils::DeserializationManager&) {}
+
+    /* constructors */
+    PersistentCompactCascadeStore(persistent::PersistentRegistry* pr,
+                                  CriticalDataPathObserver<PersistentCompactCascadeStore<KT, VT, IK, IV>>* cw = nullptr,
+                                  ICascadeContext* cc = nullptr);
+    PersistentCompactCascadeStore(persistent::Persistent<CompactDeltaStoreCore, ST>&& _persistent_core,
+                                  CriticalDataPathObserver<PersistentCompactCascadeStore<KT, VT, IK, IV>>* cw = nullptr,
+                                  ICascadeContext* cc = nullptr);  // move persistent_core
+};
+
+}  // namespace cascade
+}  // namespace derecho
+
+#include "detail/compact_store_impl.hpp"
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "flat_uint64_table.hpp"
+
+#include <derecho/core/derecho.hpp>
+#include <derecho/mutils-serialization/SerializationSupport.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * The state of a PersistentCompactCascadeStore with its delta support. The objects are kept in a FlatUInt64Table, and
+ * the delta of a version lists the keys put or removed in it, whose payloads are read from the table when the delta is
+ * written to the log, so an update is not copied twice. Replaying the log on restart rebuilds the table.
+ */
+class CompactDeltaStoreCore : public mutils::ByteRepresentable,
+                              public persistent::IDeltaSupport<CompactDeltaStoreCore> {
+public:
+    /**
+     * @class DeltaType
+     * @brief a read-only view of a serialized delta, laid out as follows:
+     * 1) The number of entries, the version and the timestamp of the delta, each in 8 bytes;
+     * 2) The entries, each the key, the previous version of the key and the payload size in 8 bytes each, followed by
+     *    the payload. The size of a removal is REMOVED_SIZE, and it has no payload.
+     * So an entry in the log takes 24 bytes besides its payload.
+     */
+    class DeltaType : public mutils::ByteRepresentable {
+    public:
+        static constexpr uint64_t REMOVED_SIZE = ~0ull;
+        /**
+         * An entry of the delta. The payload bytes are valid while the delta is.
+         */
+        struct Entry {
+            uint64_t key;
+            persistent::version_t previous_version_by_key;
+            const uint8_t* bytes;
+            std::size_t size;
+            bool removed;
+        };
+
+    private:
+        /** The serialized delta. */
+        const uint8_t* buffer;
+        /** The copy of the serialized delta owned by a delta created by from_bytes(). */
+        std::unique_ptr<uint8_t[]> owned_buffer;
+        inline static uint64_t read_word(const uint8_t* pos);
+        /** The number of bytes of a serialized delta. */
+        inline static std::size_t serialized_size(const uint8_t* const v);
+
+    public:
+        static constexpr std::size_t HEADER_SIZE = 3 * sizeof(uint64_t);
+        static constexpr std::size_t ENTRY_HEADER_SIZE = 3 * sizeof(uint64_t);
+        /**
+         * @param _buffer   The serialized delta, which must outlive this view.
+         */
+        inline DeltaType(const uint8_t* const _buffer);
+        /**
+         * @return the number of entries.
+         */
+        inline std::size_t size() const;
+        /**
+         * @return the version of the delta.
+         */
+        inline persistent::version_t version() const;
+        /**
+         * @return the timestamp of the delta in microseconds.
+         */
+        inline uint64_t timestamp_us() const;
+        /**
+         * Find the entry of a key, with a linear scan of the entries.
+         *
+         * @return true if the key is in the delta.
+         */
+        inline bool find(uint64_t key, Entry& entry) const;
+        /**
+         * Visit the entries in the order they are logged.
+         *
+         * @param visitor   A callable as void(const Entry&)
+         */
+        template <typename Visitor>
+        void for_each(Visitor&& visitor) const;
+
+        inline virtual std::size_t to_bytes(uint8_t*) const override;
+        inline virtual void post_object(const std::function<void(uint8_t const* const, std::size_t)>&) const override;
+        inline virtual std::size_t bytes_size() const override;
+        inline virtual void ensure_registered(mutils::DeserializationManager&) {}
+        inline static std::unique_ptr<DeltaType> from_bytes(mutils::DeserializationManager*, const uint8_t* const);
+        inline static mutils::context_ptr<DeltaType> from_bytes_noalloc(mutils::DeserializationManager*, const uint8_t* const);
+        inline static mutils::context_ptr<const DeltaType> from_bytes_noalloc_const(mutils::DeserializationManager*,
+                                                                                  const uint8_t* const);
+    };
+
+private:
+    /** A key put or removed in the current delta. */
+    struct DeltaEntry {
+        uint64_t key;
+        persistent::version_t previous_version_by_key;
+        bool removed;
+    };
+    /** The keys put or removed in the current delta. */
+    std::vector<DeltaEntry> delta;
+    /** The version and timestamp of the current delta. */
+    persistent::version_t delta_version;
+    uint64_t delta_timestamp_us;
+    /**
+     * Start a delta for a version, unless it is started. The updates of a version, e.g. a batch, share a delta.
+     */
+    inline void start_delta(persistent::version_t version, uint64_t timestamp_us);
+
+public:
+    /** The objects. */
+    FlatUInt64Table kv_table;
+    /** Protects kv_table from P2P readers while the predicate thread updates it. */
+    mutable std::shared_mutex kv_table_mutex;
+
+    inline virtual size_t currentDeltaSize() override;
+    inline virtual size_t currentDeltaToBytes(uint8_t* const buf, size_t buf_size) override;
+    inline virtual void applyDelta(uint8_t const* const delta) override;
+    inline static std::unique_ptr<CompactDeltaStoreCore> create(mutils::DeserializationManager* dm);
+
+    /**
+     * Put the payload of a key under a version, and add it to the delta.
+     *
+     * @param key           The key
+     * @param version       The version of the update
+     * @param timestamp_us  The timestamp of the update
+     * @param bytes         The payload
+     * @param size          The size of the payload
+     */
+    inline void ordered_put(uint64_t key, persistent::version_t version, uint64_t timestamp_us,
+                            const uint8_t* bytes, std::size_t size);
+    /**
+     * Remove a key under a version, and add the removal to the delta.
+     *
+     * @return false if the key is not found, in which case nothing is logged.
+     */
+    inline bool ordered_remove(uint64_t key, persistent::version_t version, uint64_t timestamp_us);
+    /**
+     * Find the current object of a key, only called by the predicate thread, which is the only writer of kv_table.
+     */
+    inline bool ordered_find(uint64_t key, FlatUInt64Table::View& view) const;
+
+    // serialization support
+    inline std::size_t to_bytes(uint8_t* buf) const;
+    inline std::size_t bytes_size() const;
+    inline void post_object(const std::function<void(uint8_t const* const, std::size_t)>& f) const;
+    inline static std::unique_ptr<CompactDeltaStoreCore> from_bytes(mutils::DeserializationManager* dsm, uint8_t const* buf);
+    DEFAULT_DESERIALIZE_NOALLOC(CompactDeltaStoreCore);
+    void ensure_registered(mutils::DeserializationManager&) {}
+
+    // constructors
+    inline CompactDeltaStoreCore();
+    inline CompactDeltaStoreCore(FlatUInt64Table&& _kv_table);
+};
+
+}  // namespace cascade
+}  // namespace derecho
+
+#include "compact_delta_store_core_impl.hpp"
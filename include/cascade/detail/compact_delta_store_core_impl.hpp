@@ -0,0 +1,255 @@
+#pragma once
+#include "compact_delta_store_core.hpp"
+
+#include "debug_util.hpp"
+
+#include <derecho/core/derecho.hpp>
+#include <derecho/mutils-serialization/SerializationSupport.hpp>
+#include <derecho/persistent/Persistent.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+uint64_t CompactDeltaStoreCore::DeltaType::read_word(const uint8_t* pos) {
+    // the words in a delta are not necessarily aligned.
+    uint64_t word;
+    memcpy(&word, pos, sizeof(word));
+    return word;
+}
+
+std::size_t CompactDeltaStoreCore::DeltaType::serialized_size(const uint8_t* const v) {
+    const uint64_t num_entries = read_word(v);
+    std::size_t pos = HEADER_SIZE;
+    for(uint64_t i = 0; i < num_entries; i++) {
+        const uint64_t size = read_word(v + pos + 2 * sizeof(uint64_t));
+        pos += ENTRY_HEADER_SIZE + ((size == REMOVED_SIZE) ? 0 : size);
+    }
+    return pos;
+}
+
+CompactDeltaStoreCore::DeltaType::DeltaType(const uint8_t* const _buffer) : buffer(_buffer) {}
+
+std::size_t CompactDeltaStoreCore::DeltaType::size() const {
+    return static_cast<std::size_t>(read_word(buffer));
+}
+
+persistent::version_t CompactDeltaStoreCore::DeltaType::version() const {
+    return static_cast<persistent::version_t>(read_word(buffer + sizeof(uint64_t)));
+}
+
+uint64_t CompactDeltaStoreCore::DeltaType::timestamp_us() const {
+    return read_word(buffer + 2 * sizeof(uint64_t));
+}
+
+template <typename Visitor>
+void CompactDeltaStoreCore::DeltaType::for_each(Visitor&& visitor) const {
+    const std::size_t num_entries = size();
+    std::size_t pos = HEADER_SIZE;
+    for(std::size_t i = 0; i < num_entries; i++) {
+        Entry entry;
+        entry.key = read_word(buffer + pos);
+        entry.previous_version_by_key = static_cast<persistent::version_t>(read_word(buffer + pos + sizeof(uint64_t)));
+        const uint64_t size = read_word(buffer + pos + 2 * sizeof(uint64_t));
+        entry.removed = (size == REMOVED_SIZE);
+        entry.size = entry.removed ? 0 : static_cast<std::size_t>(size);
+        entry.bytes = buffer + pos + ENTRY_HEADER_SIZE;
+        visitor(static_cast<const Entry&>(entry));
+        pos += ENTRY_HEADER_SIZE + entry.size;
+    }
+}
+
+bool CompactDeltaStoreCore::DeltaType::find(uint64_t key, Entry& entry) const {
+    bool found = false;
+    // a delta has one entry per key, and most deltas have only one entry.
+    for_each([key, &entry, &found](const Entry& e) {
+        if(!found && e.key == key) {
+            entry = e;
+            found = true;
+        }
+    });
+    return found;
+}
+
+std::size_t CompactDeltaStoreCore::DeltaType::to_bytes(uint8_t*) const {
+    dbg_default_warn("{} should not be called. It is not designed for serialization.", __PRETTY_FUNCTION__);
+    return 0;
+}
+
+void CompactDeltaStoreCore::DeltaType::post_object(const std::function<void(uint8_t const* const, std::size_t)>&) const {
+    dbg_default_warn("{} should not be called. It is not designed for serialization.", __PRETTY_FUNCTION__);
+}
+
+std::size_t CompactDeltaStoreCore::DeltaType::bytes_size() const {
+    dbg_default_warn("{} should not be called. It is not designed for serialization.", __PRETTY_FUNCTION__);
+    return 0;
+}
+
+std::unique_ptr<CompactDeltaStoreCore::DeltaType> CompactDeltaStoreCore::DeltaType::from_bytes(
+        mutils::DeserializationManager*, const uint8_t* const v) {
+    std::size_t size = serialized_size(v);
+    std::unique_ptr<uint8_t[]> owned_buffer(new uint8_t[size]);
+    memcpy(owned_buffer.get(), v, size);
+    auto pdelta = std::make_unique<DeltaType>(owned_buffer.get());
+    pdelta->owned_buffer = std::move(owned_buffer);
+    return pdelta;
+}
+
+mutils::context_ptr<CompactDeltaStoreCore::DeltaType> CompactDeltaStoreCore::DeltaType::from_bytes_noalloc(
+        mutils::DeserializationManager*, const uint8_t* const v) {
+    return mutils::context_ptr<DeltaType>(new DeltaType(v));
+}
+
+mutils::context_ptr<const CompactDeltaStoreCore::DeltaType> CompactDeltaStoreCore::DeltaType::from_bytes_noalloc_const(
+        mutils::DeserializationManager*, const uint8_t* const v) {
+    return mutils::context_ptr<const DeltaType>(new DeltaType(v));
+}
+
+void CompactDeltaStoreCore::start_delta(persistent::version_t version, uint64_t timestamp_us) {
+    if(delta.empty()) {
+        delta_version = version;
+        delta_timestamp_us = timestamp_us;
+    }
+}
+
+size_t CompactDeltaStoreCore::currentDeltaSize() {
+    if(delta.empty()) {
+        return 0;
+    }
+    size_t delta_size = DeltaType::HEADER_SIZE;
+    for(const auto& entry : delta) {
+        delta_size += DeltaType::ENTRY_HEADER_SIZE;
+        FlatUInt64Table::View view;
+        if(!entry.removed && kv_table.find(entry.key, view)) {
+            delta_size += view.size;
+        }
+    }
+    return delta_size;
+}
+
+size_t CompactDeltaStoreCore::currentDeltaToBytes(uint8_t* const buf, size_t buf_size) {
+    size_t delta_size = currentDeltaSize();
+    if(delta_size == 0) {
+        return 0;
+    }
+    if(delta_size > buf_size) {
+        dbg_default_error("{}: failed because we need {} bytes for delta, but only a buffer with {} bytes given.\n",
+                          __PRETTY_FUNCTION__, delta_size, buf_size);
+    }
+    size_t offset = 0;
+    auto write_word = [buf, &offset](uint64_t word) {
+        memcpy(buf + offset, &word, sizeof(word));
+        offset += sizeof(word);
+    };
+    write_word(delta.size());
+    write_word(static_cast<uint64_t>(delta_version));
+    write_word(delta_timestamp_us);
+    // the predicate thread is the only writer of kv_table, so it reads the payloads without the lock.
+    for(const auto& entry : delta) {
+        write_word(entry.key);
+        write_word(static_cast<uint64_t>(entry.previous_version_by_key));
+        FlatUInt64Table::View view;
+        if(entry.removed || !kv_table.find(entry.key, view)) {
+            write_word(DeltaType::REMOVED_SIZE);
+            continue;
+        }
+        write_word(view.size);
+        if(view.size > 0) {
+            memcpy(buf + offset, view.bytes, view.size);
+        }
+        offset += view.size;
+    }
+    delta.clear();
+    return offset;
+}
+
+void CompactDeltaStoreCore::applyDelta(uint8_t const* const serialized_delta) {
+    DeltaType delta(serialized_delta);
+    const persistent::version_t version = delta.version();
+    const uint64_t timestamp_us = delta.timestamp_us();
+    std::unique_lock<std::shared_mutex> wlck(kv_table_mutex);
+    delta.for_each([this, version, timestamp_us](const DeltaType::Entry& entry) {
+        if(entry.removed) {
+            kv_table.erase(entry.key);
+        } else {
+            kv_table.put(entry.key, version, timestamp_us, entry.bytes, entry.size);
+        }
+    });
+}
+
+std::unique_ptr<CompactDeltaStoreCore> CompactDeltaStoreCore::create(mutils::DeserializationManager*) {
+    return std::make_unique<CompactDeltaStoreCore>();
+}
+
+void CompactDeltaStoreCore::ordered_put(uint64_t key, persistent::version_t version, uint64_t timestamp_us,
+                                        const uint8_t* bytes, std::size_t size) {
+    start_delta(version, timestamp_us);
+    FlatUInt64Table::View current;
+    const persistent::version_t previous_version_by_key = kv_table.find(key, current)
+                                                                  ? current.version
+                                                                  : persistent::INVALID_VERSION;
+    {
+        std::unique_lock<std::shared_mutex> wlck(kv_table_mutex);
+        kv_table.put(key, version, timestamp_us, bytes, size);
+    }
+    delta.push_back({key, previous_version_by_key, false});
+}
+
+bool CompactDeltaStoreCore::ordered_remove(uint64_t key, persistent::version_t version, uint64_t timestamp_us) {
+    FlatUInt64Table::View current;
+    if(!kv_table.find(key, current)) {
+        return false;
+    }
+    start_delta(version, timestamp_us);
+    const persistent::version_t previous_version_by_key = current.version;
+    {
+        std::unique_lock<std::shared_mutex> wlck(kv_table_mutex);
+        kv_table.erase(key);
+    }
+    delta.push_back({key, previous_version_by_key, true});
+    return true;
+}
+
+bool CompactDeltaStoreCore::ordered_find(uint64_t key, FlatUInt64Table::View& view) const {
+    return kv_table.find(key, view);
+}
+
+std::size_t CompactDeltaStoreCore::to_bytes(uint8_t* buf) const {
+    std::shared_lock<std::shared_mutex> rlck(kv_table_mutex);
+    return kv_table.to_bytes(buf);
+}
+
+std::size_t CompactDeltaStoreCore::bytes_size() const {
+    std::shared_lock<std::shared_mutex> rlck(kv_table_mutex);
+    return kv_table.bytes_size();
+}
+
+void CompactDeltaStoreCore::post_object(const std::function<void(uint8_t const* const, std::size_t)>& f) const {
+    std::shared_lock<std::shared_mutex> rlck(kv_table_mutex);
+    std::vector<uint8_t> table_bytes(kv_table.bytes_size());
+    kv_table.to_bytes(table_bytes.data());
+    f(table_bytes.data(), table_bytes.size());
+}
+
+std::unique_ptr<CompactDeltaStoreCore> CompactDeltaStoreCore::from_bytes(mutils::DeserializationManager*, uint8_t const* buf) {
+    FlatUInt64Table kv_table;
+    FlatUInt64Table::from_bytes(buf, kv_table);
+    return std::make_unique<CompactDeltaStoreCore>(std::move(kv_table));
+}
+
+CompactDeltaStoreCore::CompactDeltaStoreCore() : delta_version(persistent::INVALID_VERSION),
+                                                 delta_timestamp_us(0) {}
+
+CompactDeltaStoreCore::CompactDeltaStoreCore(FlatUInt64Table&& _kv_table) : delta_version(persistent::INVALID_VERSION),
+                                                                           delta_timestamp_us(0),
+                                                                           kv_table(std::move(_kv_table)) {}
+
+}  // namespace cascade
+}  // namespace derecho
@@ -0,0 +1,1408 @@
+#pragma once
+#include "../compact_store.hpp"
+
+#include "cascade/config.h"
+#include "cascade/utils.hpp"
+#include "debug_util.hpp"
+#ifdef ENABLE_EVALUATION
+#include "../volatile_store.hpp"
+#endif
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCompactCascadeStore<KT, VT, IK, IV>::put(const VT& value, bool as_trigger) const {
+    debug_enter_func_with_args("value.get_key_ref={}", value.get_key_ref());
+
+    derecho::Replicated<VolatileCompactCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_put)>(value,as_trigger);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCompactCascadeStore<KT, VT, IK, IV>::put_and_forget(const VT& value, bool as_trigger) const {
+    debug_enter_func_with_args("value.get_key_ref={}", value.get_key_ref());
+
+    derecho::Replicated<VolatileCompactCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index);
+    subgroup_handle.template ordered_send<RPC_NAME(ordered_put_and_forget)>(value,as_trigger);
+
+    debug_leave_func();
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCompactCascadeStore<KT, VT, IK, IV>::put_batch(const std::vector<VT>& values, bool as_trigger) const {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    derecho::Replicated<VolatileCompactCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_put_batch)>(values,as_trigger);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+#ifdef ENABLE_EVALUATION
+template <typename KT, typename VT, KT* IK, VT* IV>
+double VolatileCompactCascadeStore<KT, VT, IK, IV>::perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const {
+    debug_enter_func_with_args("max_payload_size={},duration_sec={}", max_payload_size, duration_sec);
+    derecho::Replicated<VolatileCompactCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index);
+    double ops = internal_perf_put(subgroup_handle, max_payload_size, duration_sec);
+    debug_leave_func_with_value("{} ops.", ops);
+    return ops;
+}
+#endif  // ENABLE_EVALUATION
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCompactCascadeStore<KT, VT, IK, IV>::remove(const KT& key) const {
+    debug_enter_func_with_args("key={}", key);
+
+    derecho::Replicated<VolatileCompactCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_remove)>(key);
+    auto& replies = results.get();
+    version_tuple ret(CURRENT_VERSION, 0);
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+VT VolatileCompactCascadeStore<KT, VT, IK, IV>::to_object(const KT& key, const FlatUInt64Table::View& view) {
+    VT value = create_null_object_cb<KT, VT, IK, IV>(key);
+    value.set_payload(view.bytes, view.size);
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        value.set_version(view.version);
+    }
+    if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+        value.set_timestamp(view.timestamp_us);
+    }
+    return value;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+VT VolatileCompactCascadeStore<KT, VT, IK, IV>::read_object(const KT& key) const {
+    std::shared_lock<std::shared_mutex> rlck(this->kv_table_mutex);
+    FlatUInt64Table::View view;
+    if(!this->kv_table.find(key, view)) {
+        return *IV;
+    }
+    return to_object(key, view);
+}
+
+// both stable and exact are ignored for VolatileCompactCascadeStore
+template <typename KT, typename VT, KT* IK, VT* IV>
+const VT VolatileCompactCascadeStore<KT, VT, IK, IV>::get(const KT& key, const persistent::version_t& ver, bool, bool) const {
+    debug_enter_func_with_args("key={},ver=0x{:x}", key, ver);
+    if(ver != CURRENT_VERSION) {
+        debug_leave_func_with_value("Cannot support versioned get, ver=0x{:x}", ver);
+        return *IV;
+    }
+    debug_leave_func();
+    return this->read_object(key);
+}
+
+// both stable and exact are ignored for VolatileCompactCascadeStore
+template <typename KT, typename VT, KT* IK, VT* IV>
+const VT VolatileCompactCascadeStore<KT, VT, IK, IV>::get_range(const KT& key, const persistent::version_t& ver, const bool,
+                                                                const uint64_t& offset, const uint64_t& length) const {
+    debug_enter_func_with_args("key={},ver=0x{:x},offset={},length={}", key, ver, offset, length);
+    if(ver != CURRENT_VERSION) {
+        debug_leave_func_with_value("Cannot support versioned get, ver=0x{:x}", ver);
+        return *IV;
+    }
+    // only the range is copied out of the table.
+    std::shared_lock<std::shared_mutex> rlck(this->kv_table_mutex);
+    FlatUInt64Table::View view;
+    if(!this->kv_table.find(key, view)) {
+        debug_leave_func_with_value("key:{} is not found", key);
+        return *IV;
+    }
+    const std::size_t start = static_cast<std::size_t>(std::min<uint64_t>(offset, view.size));
+    view.bytes += start;
+    view.size = static_cast<std::size_t>(std::min<uint64_t>(length, view.size - start));
+    debug_leave_func();
+    return to_object(key, view);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+const VT VolatileCompactCascadeStore<KT, VT, IK, IV>::multi_get(const KT& key) const {
+    debug_enter_func_with_args("key={}", key);
+
+    derecho::Replicated<VolatileCompactCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_get)>(key);
+    auto& replies = results.get();
+    for(auto& reply_pair : replies) {
+        reply_pair.second.wait();
+    }
+
+    debug_leave_func();
+    return replies.begin()->second.get();
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+const VT VolatileCompactCascadeStore<KT, VT, IK, IV>::get_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const {
+    // VolatileCompactCascadeStore does not support this.
+    debug_enter_func();
+    debug_leave_func();
+
+    return *IV;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<KT> VolatileCompactCascadeStore<KT, VT, IK, IV>::multi_list_keys(const std::string& prefix) const {
+    debug_enter_func_with_args("prefix={}", prefix);
+
+    derecho::Replicated<VolatileCompactCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_list_keys)>(prefix);
+    auto& replies = results.get();
+    std::vector<KT> ret;
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func();
+    return ret;
+}
+
+// uint64_t keys have no pathname, so only the empty prefix matches them, as in VolatileCascadeStore.
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<KT> VolatileCompactCascadeStore<KT, VT, IK, IV>::list_keys(const std::string& prefix, const persistent::version_t& ver, const bool) const {
+    debug_enter_func_with_args("prefix={},ver=0x{:x}", prefix, ver);
+    if(ver != CURRENT_VERSION) {
+        debug_leave_func_with_value("Cannot support versioned list_keys, ver=0x{:x}", ver);
+        return {};
+    }
+
+    std::vector<KT> key_list;
+    if(prefix.empty()) {
+        std::shared_lock<std::shared_mutex> rlck(this->kv_table_mutex);
+        key_list.reserve(this->kv_table.size());
+        this->kv_table.for_each([&key_list](uint64_t key, const FlatUInt64Table::View&) {
+            key_list.push_back(key);
+        });
+    }
+
+    debug_leave_func();
+    return key_list;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<KT> VolatileCompactCascadeStore<KT, VT, IK, IV>::list_keys_by_time(const std::string& prefix, const uint64_t& ts_us, const bool) const {
+    // VolatileCompactCascadeStore does not support this.
+    debug_enter_func_with_args("ts_us=0x{:x}", ts_us);
+    debug_leave_func();
+    return {};
+}
+
+// as list_keys, only the empty prefix matches uint64 keys. kv_table is not ordered, so a page is selected with a heap of
+// the smallest keys after the cursor, which bounds the memory by the page size.
+template <typename KT, typename VT, KT* IK, VT* IV>
+key_page_t<KT> VolatileCompactCascadeStore<KT, VT, IK, IV>::list_keys_paged(const std::string& prefix, const std::string& cursor,
+                                                                            const uint32_t& limit) const {
+    debug_enter_func_with_args("prefix={},cursor={},limit={}", prefix, cursor, limit);
+    KeyPageCursor<KT> page_cursor{CURRENT_VERSION, *IK};
+    if(limit == 0 || (!cursor.empty() && !KeyPageCursor<KT>::decode(cursor, page_cursor))) {
+        dbg_default_warn("{}: invalid cursor '{}' or limit {}.", __PRETTY_FUNCTION__, cursor, limit);
+        return {};
+    }
+
+    std::priority_queue<KT> page;
+    bool has_more = false;
+    if(prefix.empty()) {
+        std::shared_lock<std::shared_mutex> rlck(this->kv_table_mutex);
+        this->kv_table.for_each([&](uint64_t key, const FlatUInt64Table::View&) {
+            if(!cursor.empty() && key <= page_cursor.last_key) {
+                return;
+            }
+            if(page.size() < limit) {
+                page.push(key);
+            } else {
+                has_more = true;
+                if(key < page.top()) {
+                    page.pop();
+                    page.push(key);
+                }
+            }
+        });
+    }
+    std::vector<KT> keys(page.size());
+    for(auto it = keys.rbegin(); it != keys.rend(); it++) {
+        *it = page.top();
+        page.pop();
+    }
+
+    std::string next_cursor;
+    if(has_more) {
+        page_cursor.last_key = keys.back();
+        next_cursor = page_cursor.encode();
+    }
+    debug_leave_func_with_value("{} keys, next cursor '{}'", keys.size(), next_cursor);
+    return {std::move(keys), std::move(next_cursor)};
+}
+
+// as list_keys, only the empty prefix matches uint64 keys. The filter sees the keys in decimal. kv_table is not ordered,
+// so the page keeps the smallest matching keys after the cursor, see ScanPage.
+template <typename KT, typename VT, KT* IK, VT* IV>
+scan_page_t<VT> VolatileCompactCascadeStore<KT, VT, IK, IV>::scan(const std::string& prefix, const std::string& filter,
+                                                                  const std::string& projection, const std::string& cursor,
+                                                                  const uint32_t& max_results) const {
+    debug_enter_func_with_args("prefix={},filter={},projection={},cursor={},max_results={}", prefix, filter, projection, cursor, max_results);
+    ScanPage<KT, VT> page(filter, projection, cursor, max_results);
+    if(prefix.empty()) {
+        std::shared_lock<std::shared_mutex> rlck(this->kv_table_mutex);
+        this->kv_table.for_each([&](uint64_t key, const FlatUInt64Table::View& view) {
+            if(!page.start_after().has_value() || key > *page.start_after()) {
+                page.add(key, to_object(key, view));
+            }
+        });
+    }
+
+    auto result = page.finish();
+    debug_leave_func_with_value("{} objects, next cursor '{}'", std::get<0>(result).size(), std::get<1>(result));
+    return result;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+uint64_t VolatileCompactCascadeStore<KT, VT, IK, IV>::multi_get_size(const KT& key) const {
+    debug_enter_func_with_args("key={}", key);
+
+    derecho::Replicated<VolatileCompactCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_get_size)>(key);
+    auto& replies = results.get();
+    uint64_t ret = replies.begin()->second.get();
+
+    debug_leave_func();
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+uint64_t VolatileCompactCascadeStore<KT, VT, IK, IV>::get_size(const KT& key, const persistent::version_t& ver, const bool, const bool) const {
+    debug_enter_func_with_args("key={},ver=0x{:x}", key, ver);
+    if(ver != CURRENT_VERSION) {
+        debug_leave_func_with_value("Cannot support versioned get, ver=0x{:x}", ver);
+        return 0;
+    }
+    // the size of the object as it is sent by get.
+    const VT value = this->read_object(key);
+    debug_leave_func();
+    return value.is_valid() ? mutils::bytes_size(value) : 0;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+uint64_t VolatileCompactCascadeStore<KT, VT, IK, IV>::get_size_by_time(const KT&, const uint64_t&, const bool) const {
+    // VolatileCompactCascadeStore does not support this.
+    debug_enter_func();
+    debug_leave_func();
+    return 0;
+}
+
+// stable is ignored for VolatileCompactCascadeStore
+template <typename KT, typename VT, KT* IK, VT* IV>
+ObjectHead VolatileCompactCascadeStore<KT, VT, IK, IV>::head(const KT& key, const persistent::version_t& ver, const bool) const {
+    debug_enter_func_with_args("key={},ver=0x{:x}", key, ver);
+    if(ver != CURRENT_VERSION) {
+        debug_leave_func_with_value("Cannot support versioned head, ver=0x{:x}", ver);
+        return ObjectHead{};
+    }
+    // the metadata is read from the slot, without materializing the object.
+    std::shared_lock<std::shared_mutex> rlck(this->kv_table_mutex);
+    FlatUInt64Table::View view;
+    if(!this->kv_table.find(key, view)) {
+        debug_leave_func_with_value("key:{} is not found", key);
+        return ObjectHead{};
+    }
+    debug_leave_func();
+    return ObjectHead{view.version, view.timestamp_us, persistent::INVALID_VERSION, persistent::INVALID_VERSION,
+                      view.size, false};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<ObjectHead> VolatileCompactCascadeStore<KT, VT, IK, IV>::head_batch(const std::vector<KT>& keys,
+                                                                                const persistent::version_t& ver,
+                                                                                const bool stable) const {
+    debug_enter_func_with_args("{} keys,ver=0x{:x}", keys.size(), ver);
+    std::vector<ObjectHead> heads;
+    heads.reserve(keys.size());
+    for(const auto& key : keys) {
+        heads.emplace_back(this->head(key, ver, stable));
+    }
+    debug_leave_func();
+    return heads;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<KT> VolatileCompactCascadeStore<KT, VT, IK, IV>::ordered_list_keys(const std::string& prefix) {
+    debug_enter_func_with_args("prefix={}", prefix);
+
+    std::vector<KT> key_list;
+    if(prefix.empty()) {
+        // the ordered path is the only writer, so it reads kv_table without the lock.
+        key_list.reserve(this->kv_table.size());
+        this->kv_table.for_each([&key_list](uint64_t key, const FlatUInt64Table::View&) {
+            key_list.push_back(key);
+        });
+    }
+
+    debug_leave_func();
+    return key_list;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCompactCascadeStore<KT, VT, IK, IV>::ordered_put(const VT& value, bool as_trigger) {
+    debug_enter_func_with_args("key={}", value.get_key_ref());
+
+    auto version_and_hlc = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index).get_current_version();
+    version_tuple version_and_timestamp{persistent::INVALID_VERSION, 0};
+
+    if(this->internal_ordered_put(value,as_trigger) == true) {
+        version_and_timestamp = {std::get<0>(version_and_hlc),std::get<1>(version_and_hlc).m_rtc_us};
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_timestamp),
+            std::get<1>(version_and_timestamp));
+
+    return version_and_timestamp;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCompactCascadeStore<KT, VT, IK, IV>::ordered_put_and_forget(const VT& value, bool as_trigger) {
+    debug_enter_func_with_args("key={}", value.get_key_ref());
+    this->internal_ordered_put(value,as_trigger);
+    debug_leave_func();
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCompactCascadeStore<KT, VT, IK, IV>::ordered_put_batch(const std::vector<VT>& values, bool as_trigger) {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    auto version_and_hlc = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index).get_current_version();
+    version_tuple version_and_timestamp{persistent::INVALID_VERSION, 0};
+
+    if(this->internal_ordered_put_batch(values,as_trigger) == true) {
+        version_and_timestamp = {std::get<0>(version_and_hlc),std::get<1>(version_and_hlc).m_rtc_us};
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_timestamp),
+            std::get<1>(version_and_timestamp));
+
+    return version_and_timestamp;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool VolatileCompactCascadeStore<KT, VT, IK, IV>::internal_ordered_put(const VT& value, bool as_trigger) {
+    auto version_and_hlc = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index).get_current_version();
+
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        value.set_version(std::get<0>(version_and_hlc));
+    }
+    if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+        value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+    }
+
+    // the ordered path is the only writer, so it reads kv_table without the lock.
+    FlatUInt64Table::View current;
+    const persistent::version_t version_by_key = this->kv_table.find(value.get_key_ref(), current)
+                                                         ? current.version
+                                                         : persistent::INVALID_VERSION;
+    // Verify previous version MUST happen before update previous versions.
+    if constexpr(std::is_base_of<IVerifyPreviousVersion, VT>::value) {
+        if(!value.verify_previous_version(this->update_version, version_by_key)) {
+            // reject the update by returning an invalid version and timestamp
+            return false;
+        }
+    }
+    if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+        value.set_previous_version(this->update_version, version_by_key);
+    }
+
+    if(!as_trigger) {
+        {
+            std::unique_lock<std::shared_mutex> wlck(this->kv_table_mutex);
+            this->kv_table.put(value.get_key_ref(), std::get<0>(version_and_hlc), std::get<1>(version_and_hlc).m_rtc_us,
+                               value.get_payload_bytes(), value.get_payload_size());
+        }
+        this->update_version = std::get<0>(version_and_hlc);
+    }
+
+    if(cascade_watcher_ptr) {
+        (*cascade_watcher_ptr)(
+                this->subgroup_index,
+                group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index).get_shard_num(),
+                group->get_rpc_caller_id(),
+                value.get_key_ref(), value, cascade_context_ptr);
+    }
+
+    return true;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool VolatileCompactCascadeStore<KT, VT, IK, IV>::internal_ordered_put_batch(const std::vector<VT>& values, bool as_trigger) {
+    auto version_and_hlc = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index).get_current_version();
+
+    std::set<KT> keys;
+    for(const auto& value : values) {
+        if(!keys.insert(value.get_key_ref()).second) {
+            dbg_default_warn("{}: rejected a batch with duplicate key {}.", __PRETTY_FUNCTION__, value.get_key_ref());
+            return false;
+        }
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            value.set_version(std::get<0>(version_and_hlc));
+        }
+        if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+            value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+        }
+    }
+
+    // verify every object against the state before the batch, so that the batch is applied all or nothing.
+    std::vector<persistent::version_t> versions_by_key;
+    versions_by_key.reserve(values.size());
+    for(const auto& value : values) {
+        FlatUInt64Table::View current;
+        versions_by_key.push_back(this->kv_table.find(value.get_key_ref(), current) ? current.version : persistent::INVALID_VERSION);
+        if constexpr(std::is_base_of<IVerifyPreviousVersion, VT>::value) {
+            if(!value.verify_previous_version(this->update_version, versions_by_key.back())) {
+                return false;
+            }
+        }
+    }
+
+    for(std::size_t i = 0; i < values.size(); i++) {
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            values[i].set_previous_version(this->update_version, versions_by_key[i]);
+        }
+    }
+    if(!as_trigger) {
+        {
+            std::unique_lock<std::shared_mutex> wlck(this->kv_table_mutex);
+            for(const auto& value : values) {
+                this->kv_table.put(value.get_key_ref(), std::get<0>(version_and_hlc), std::get<1>(version_and_hlc).m_rtc_us,
+                                   value.get_payload_bytes(), value.get_payload_size());
+            }
+        }
+        this->update_version = std::get<0>(version_and_hlc);
+    }
+
+    if(cascade_watcher_ptr) {
+        for(const auto& value : values) {
+            (*cascade_watcher_ptr)(
+                    this->subgroup_index,
+                    group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index).get_shard_num(),
+                    group->get_rpc_caller_id(),
+                    value.get_key_ref(), value, cascade_context_ptr);
+        }
+    }
+
+    return true;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCompactCascadeStore<KT, VT, IK, IV>::ordered_remove(const KT& key) {
+    debug_enter_func_with_args("key={}", key);
+
+    auto version_and_hlc = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index).get_current_version();
+
+    FlatUInt64Table::View current;
+    if(this->kv_table.find(key, current)) {
+        auto value = create_null_object_cb<KT, VT, IK, IV>(key);
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            value.set_version(std::get<0>(version_and_hlc));
+        }
+        if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+            value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+        }
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            value.set_previous_version(this->update_version, current.version);
+        }
+        {
+            std::unique_lock<std::shared_mutex> wlck(this->kv_table_mutex);
+            this->kv_table.erase(key);
+        }
+        this->update_version = std::get<0>(version_and_hlc);
+
+        if(cascade_watcher_ptr) {
+            (*cascade_watcher_ptr)(
+                    this->subgroup_index,
+                    group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index).get_shard_num(),
+                    group->get_rpc_caller_id(),
+                    key, value, cascade_context_ptr);
+        }
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us);
+
+    return {std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+const VT VolatileCompactCascadeStore<KT, VT, IK, IV>::ordered_get(const KT& key) {
+    debug_enter_func_with_args("key={}", key);
+    debug_leave_func();
+    return this->read_object(key);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+uint64_t VolatileCompactCascadeStore<KT, VT, IK, IV>::ordered_get_size(const KT& key) {
+    debug_enter_func_with_args("key={}", key);
+    const VT value = this->read_object(key);
+    debug_leave_func();
+    return value.is_valid() ? mutils::bytes_size(value) : 0;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::pair<uint64_t, uint64_t> VolatileCompactCascadeStore<KT, VT, IK, IV>::get_memory_usage() const {
+    std::shared_lock<std::shared_mutex> rlck(this->kv_table_mutex);
+    return {this->kv_table.size(), this->kv_table.memory_usage()};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCompactCascadeStore<KT, VT, IK, IV>::trigger_put(const VT& value) const {
+    debug_enter_func_with_args("key={}", value.get_key_ref());
+
+    if(cascade_watcher_ptr) {
+        (*cascade_watcher_ptr)(
+                this->subgroup_index,
+                group->template get_subgroup<VolatileCompactCascadeStore<KT, VT, IK, IV>>(this->subgroup_index).get_shard_num(),
+                group->get_rpc_caller_id(),
+                value.get_key_ref(), value, cascade_context_ptr, true);
+    }
+
+    debug_leave_func();
+}
+
+#ifdef ENABLE_EVALUATION
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCompactCascadeStore<KT, VT, IK, IV>::dump_timestamp_log(const std::string& filename) const {
+    debug_enter_func_with_args("filename={}", filename);
+    derecho::Replicated<VolatileCompactCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCompactCascadeStore>(this->subgroup_index);
+    auto result = subgroup_handle.template ordered_send<RPC_NAME(ordered_dump_timestamp_log)>(filename);
+    auto& replies = result.get();
+    for(auto r : replies) {
+        volatile uint32_t _ = r;
+        _ = _;
+    }
+    debug_leave_func();
+    return;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCompactCascadeStore<KT, VT, IK, IV>::ordered_dump_timestamp_log(const std::string& filename) {
+    debug_enter_func_with_args("filename={}", filename);
+    TimestampLogger::flush(filename);
+    debug_leave_func();
+}
+#ifdef DUMP_TIMESTAMP_WORKAROUND
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCompactCascadeStore<KT, VT, IK, IV>::dump_timestamp_log_workaround(const std::string& filename) const {
+    debug_enter_func_with_args("filename={}", filename);
+    TimestampLogger::flush(filename);
+    debug_leave_func();
+}
+#endif
+#endif  // ENABLE_EVALUATION
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::unique_ptr<VolatileCompactCascadeStore<KT, VT, IK, IV>> VolatileCompactCascadeStore<KT, VT, IK, IV>::from_bytes(
+        mutils::DeserializationManager* dsm,
+        uint8_t const* buf) {
+    auto update_version_ptr = mutils::from_bytes<persistent::version_t>(dsm, buf);
+    std::size_t offset = mutils::bytes_size(*update_version_ptr);
+    FlatUInt64Table kv_table;
+    FlatUInt64Table::from_bytes(buf + offset, kv_table);
+    return std::make_unique<VolatileCompactCascadeStore>(std::move(kv_table),
+                                                         *update_version_ptr,
+                                                         dsm->registered<CriticalDataPathObserver<VolatileCompactCascadeStore<KT, VT, IK, IV>>>() ? &(dsm->mgr<CriticalDataPathObserver<VolatileCompactCascadeStore<KT, VT, IK, IV>>>()) : nullptr,
+                                                         dsm->registered<ICascadeContext>() ? &(dsm->mgr<ICascadeContext>()) : nullptr);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::size_t VolatileCompactCascadeStore<KT, VT, IK, IV>::to_bytes(uint8_t* buf) const {
+    std::shared_lock<std::shared_mutex> rlck(this->kv_table_mutex);
+    std::size_t offset = mutils::to_bytes(this->update_version, buf);
+    offset += this->kv_table.to_bytes(buf + offset);
+    return offset;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::size_t VolatileCompactCascadeStore<KT, VT, IK, IV>::bytes_size() const {
+    std::shared_lock<std::shared_mutex> rlck(this->kv_table_mutex);
+    return mutils::bytes_size(this->update_version) + this->kv_table.bytes_size();
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCompactCascadeStore<KT, VT, IK, IV>::post_object(const std::function<void(uint8_t const* const, std::size_t)>& f) const {
+    std::shared_lock<std::shared_mutex> rlck(this->kv_table_mutex);
+    mutils::post_object(f, this->update_version);
+    std::vector<uint8_t> table_bytes(this->kv_table.bytes_size());
+    this->kv_table.to_bytes(table_bytes.data());
+    f(table_bytes.data(), table_bytes.size());
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+VolatileCompactCascadeStore<KT, VT, IK, IV>::VolatileCompactCascadeStore(
+        CriticalDataPathObserver<VolatileCompactCascadeStore<KT, VT, IK, IV>>* cw,
+        ICascadeContext* cc) : update_version(persistent::INVALID_VERSION),
+                               cascade_watcher_ptr(cw),
+                               cascade_context_ptr(cc) {
+    debug_enter_func();
+    debug_leave_func();
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+VolatileCompactCascadeStore<KT, VT, IK, IV>::VolatileCompactCascadeStore(
+        FlatUInt64Table&& _kvt,
+        persistent::version_t _uv,
+        CriticalDataPathObserver<VolatileCompactCascadeStore<KT, VT, IK, IV>>* cw,
+        ICascadeContext* cc) : kv_table(std::move(_kvt)),
+                               update_version(_uv),
+                               cascade_watcher_ptr(cw),
+                               cascade_context_ptr(cc) {
+    debug_enter_func_with_args("move to kv_table, size={}", kv_table.size());
+    debug_leave_func();
+}
+
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::put(const VT& value, bool as_trigger) const {
+    debug_enter_func_with_args("value.get_key_ref={}", value.get_key_ref());
+
+    derecho::Replicated<PersistentCompactCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_put)>(value,as_trigger);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::put_and_forget(const VT& value, bool as_trigger) const {
+    debug_enter_func_with_args("value.get_key_ref={}", value.get_key_ref());
+
+    derecho::Replicated<PersistentCompactCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index);
+    subgroup_handle.template ordered_send<RPC_NAME(ordered_put_and_forget)>(value,as_trigger);
+
+    debug_leave_func();
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::put_batch(const std::vector<VT>& values, bool as_trigger) const {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    derecho::Replicated<PersistentCompactCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_put_batch)>(values,as_trigger);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+#ifdef ENABLE_EVALUATION
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+double PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const {
+    debug_enter_func_with_args("max_payload_size={},duration_sec={}", max_payload_size, duration_sec);
+    derecho::Replicated<PersistentCompactCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index);
+    double ops = internal_perf_put(subgroup_handle, max_payload_size, duration_sec);
+    debug_leave_func_with_value("{} ops.", ops);
+    return ops;
+}
+#endif  // ENABLE_EVALUATION
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::remove(const KT& key) const {
+    debug_enter_func_with_args("key={}", key);
+
+    derecho::Replicated<PersistentCompactCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_remove)>(key);
+    auto& replies = results.get();
+    version_tuple ret(CURRENT_VERSION, 0);
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+VT PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::to_object(const KT& key, const FlatUInt64Table::View& view) {
+    VT value = create_null_object_cb<KT, VT, IK, IV>(key);
+    value.set_payload(view.bytes, view.size);
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        value.set_version(view.version);
+    }
+    if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+        value.set_timestamp(view.timestamp_us);
+    }
+    return value;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+VT PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::read_object(const KT& key) const {
+    std::shared_lock<std::shared_mutex> rlck(this->persistent_core->kv_table_mutex);
+    FlatUInt64Table::View view;
+    if(!this->persistent_core->kv_table.find(key, view)) {
+        return *IV;
+    }
+    return to_object(key, view);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+persistent::version_t PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::resolve_version(const persistent::version_t& ver,
+                                                                                         const bool stable) const {
+    if(!stable) {
+        return ver;
+    }
+    derecho::Replicated<PersistentCompactCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index);
+    if(ver == CURRENT_VERSION) {
+        return subgroup_handle.get_global_persistence_frontier();
+    }
+    // as in PersistentCascadeStore, a version beyond both the global persistence frontier and the local log is in the
+    // future.
+    if(!subgroup_handle.wait_for_global_persistence_frontier(ver) && ver > persistent_core.getLatestVersion()) {
+        dbg_default_debug("{}: requested version:{:x} is beyond the latest atomic broadcast version.", __PRETTY_FUNCTION__, ver);
+        return persistent::INVALID_VERSION;
+    }
+    return ver;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+VT PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::read_object(const KT& key, persistent::version_t ver, bool exact) const {
+    using DeltaType = CompactDeltaStoreCore::DeltaType;
+    if(ver == persistent::INVALID_VERSION) {
+        return *IV;
+    }
+    persistent::version_t target_version = ver;
+    if(!exact) {
+        {
+            std::shared_lock<std::shared_mutex> rlck(this->persistent_core->kv_table_mutex);
+            FlatUInt64Table::View view;
+            if(!this->persistent_core->kv_table.find(key, view)) {
+                return *IV;
+            }
+            if(view.version <= ver) {
+                return to_object(key, view);
+            }
+            target_version = view.version;
+        }
+        // follow the previous versions of the key back to the latest one not after the requested version.
+        while(target_version != persistent::INVALID_VERSION && target_version > ver) {
+            target_version = persistent_core.template getDelta<DeltaType>(target_version, true,
+                    [&key](const DeltaType& delta) {
+                        DeltaType::Entry entry;
+                        return delta.find(key, entry) ? entry.previous_version_by_key : persistent::INVALID_VERSION;
+                    });
+        }
+        if(target_version == persistent::INVALID_VERSION) {
+            return *IV;
+        }
+    }
+    return persistent_core.template getDelta<DeltaType>(target_version, true,
+            [&key](const DeltaType& delta) {
+                DeltaType::Entry entry;
+                if(!delta.find(key, entry)) {
+                    return VT(*IV);
+                }
+                // the object is copied out of the log.
+                if(entry.removed) {
+                    VT value = create_null_object_cb<KT, VT, IK, IV>(key);
+                    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+                        value.set_version(delta.version());
+                    }
+                    if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+                        value.set_timestamp(delta.timestamp_us());
+                    }
+                    return value;
+                }
+                return to_object(key, FlatUInt64Table::View{delta.version(), delta.timestamp_us(), entry.bytes, entry.size});
+            });
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+const VT PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::get(const KT& key, const persistent::version_t& ver, const bool stable, bool exact) const {
+    debug_enter_func_with_args("key={},ver=0x{:x},stable={},exact={}", key, ver, stable, exact);
+    const persistent::version_t requested_version = this->resolve_version(ver, stable);
+    if(requested_version == CURRENT_VERSION) {
+        debug_leave_func();
+        return this->read_object(key);
+    }
+    debug_leave_func_with_value("key={} at version:0x{:x}", key, requested_version);
+    return this->read_object(key, requested_version, exact);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+const VT PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::get_range(const KT& key, const persistent::version_t& ver, const bool stable,
+                                                                      const uint64_t& offset, const uint64_t& length) const {
+    debug_enter_func_with_args("key={},ver=0x{:x},stable={},offset={},length={}", key, ver, stable, offset, length);
+    const persistent::version_t requested_version = this->resolve_version(ver, stable);
+    if(requested_version != CURRENT_VERSION) {
+        VT value = this->read_object(key, requested_version, false);
+        slice_payload(value, offset, length);
+        debug_leave_func_with_value("key={} at version:0x{:x}", key, requested_version);
+        return value;
+    }
+    // only the range is copied out of the table.
+    std::shared_lock<std::shared_mutex> rlck(this->persistent_core->kv_table_mutex);
+    FlatUInt64Table::View view;
+    if(!this->persistent_core->kv_table.find(key, view)) {
+        debug_leave_func_with_value("key:{} is not found", key);
+        return *IV;
+    }
+    const std::size_t start = static_cast<std::size_t>(std::min<uint64_t>(offset, view.size));
+    view.bytes += start;
+    view.size = static_cast<std::size_t>(std::min<uint64_t>(length, view.size - start));
+    debug_leave_func();
+    return to_object(key, view);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+const VT PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::multi_get(const KT& key) const {
+    debug_enter_func_with_args("key={}", key);
+
+    derecho::Replicated<PersistentCompactCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_get)>(key);
+    auto& replies = results.get();
+    for(auto& reply_pair : replies) {
+        reply_pair.second.wait();
+    }
+
+    debug_leave_func();
+    return replies.begin()->second.get();
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+const VT PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::get_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const {
+    debug_enter_func_with_args("key={},ts_us={},stable={}", key, ts_us, stable);
+    derecho::Replicated<PersistentCompactCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index);
+    // get_global_stability_frontier return nano seconds.
+    if(stable && (ts_us > (subgroup_handle.compute_global_stability_frontier() / 1000))) {
+        dbg_default_warn("Cannot get data at a time in the future.");
+        debug_leave_func();
+        return *IV;
+    }
+    const persistent::version_t ver = persistent_core.getVersionAtTime({ts_us, 0});
+    debug_leave_func_with_value("key={} at version:0x{:x}", key, ver);
+    return this->read_object(key, ver, false);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::vector<KT> PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::multi_list_keys(const std::string& prefix) const {
+    debug_enter_func_with_args("prefix={}", prefix);
+
+    derecho::Replicated<PersistentCompactCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_list_keys)>(prefix);
+    auto& replies = results.get();
+    std::vector<KT> ret;
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func();
+    return ret;
+}
+
+// uint64_t keys have no pathname, so only the empty prefix matches them, as in VolatileCompactCascadeStore. The log has
+// no index of the keys of a version, so a versioned list_keys is not supported, and stable is ignored.
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::vector<KT> PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::list_keys(const std::string& prefix, const persistent::version_t& ver,
+                                                                             const bool stable) const {
+    debug_enter_func_with_args("prefix={},ver=0x{:x},stable={}", prefix, ver, stable);
+    if(ver != CURRENT_VERSION) {
+        debug_leave_func_with_value("Cannot support versioned list_keys, ver=0x{:x}", ver);
+        return {};
+    }
+
+    std::vector<KT> key_list;
+    if(prefix.empty()) {
+        std::shared_lock<std::shared_mutex> rlck(this->persistent_core->kv_table_mutex);
+        key_list.reserve(this->persistent_core->kv_table.size());
+        this->persistent_core->kv_table.for_each([&key_list](uint64_t key, const FlatUInt64Table::View&) {
+            key_list.push_back(key);
+        });
+    }
+
+    debug_leave_func();
+    return key_list;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::vector<KT> PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::list_keys_by_time(const std::string& prefix, const uint64_t& ts_us,
+                                                                                     const bool) const {
+    // PersistentCompactCascadeStore does not support this, as the versioned list_keys.
+    debug_enter_func_with_args("ts_us=0x{:x}", ts_us);
+    debug_leave_func();
+    return {};
+}
+
+// as in VolatileCompactCascadeStore, a page is selected with a heap of the smallest keys after the cursor.
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+key_page_t<KT> PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::list_keys_paged(const std::string& prefix, const std::string& cursor,
+                                                                                   const uint32_t& limit) const {
+    debug_enter_func_with_args("prefix={},cursor={},limit={}", prefix, cursor, limit);
+    KeyPageCursor<KT> page_cursor{CURRENT_VERSION, *IK};
+    if(limit == 0 || (!cursor.empty() && !KeyPageCursor<KT>::decode(cursor, page_cursor))) {
+        dbg_default_warn("{}: invalid cursor '{}' or limit {}.", __PRETTY_FUNCTION__, cursor, limit);
+        return {};
+    }
+
+    std::priority_queue<KT> page;
+    bool has_more = false;
+    if(prefix.empty()) {
+        std::shared_lock<std::shared_mutex> rlck(this->persistent_core->kv_table_mutex);
+        this->persistent_core->kv_table.for_each([&](uint64_t key, const FlatUInt64Table::View&) {
+            if(!cursor.empty() && key <= page_cursor.last_key) {
+                return;
+            }
+            if(page.size() < limit) {
+                page.push(key);
+            } else {
+                has_more = true;
+                if(key < page.top()) {
+                    page.pop();
+                    page.push(key);
+                }
+            }
+        });
+    }
+    std::vector<KT> keys(page.size());
+    for(auto it = keys.rbegin(); it != keys.rend(); it++) {
+        *it = page.top();
+        page.pop();
+    }
+
+    std::string next_cursor;
+    if(has_more) {
+        page_cursor.last_key = keys.back();
+        next_cursor = page_cursor.encode();
+    }
+    debug_leave_func_with_value("{} keys, next cursor '{}'", keys.size(), next_cursor);
+    return {std::move(keys), std::move(next_cursor)};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+scan_page_t<VT> PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::scan(const std::string& prefix, const std::string& filter,
+                                                                        const std::string& projection, const std::string& cursor,
+                                                                        const uint32_t& max_results) const {
+    debug_enter_func_with_args("prefix={},filter={},projection={},cursor={},max_results={}", prefix, filter, projection, cursor, max_results);
+    ScanPage<KT, VT> page(filter, projection, cursor, max_results);
+    if(prefix.empty()) {
+        std::shared_lock<std::shared_mutex> rlck(this->persistent_core->kv_table_mutex);
+        this->persistent_core->kv_table.for_each([&](uint64_t key, const FlatUInt64Table::View& view) {
+            if(!page.start_after().has_value() || key > *page.start_after()) {
+                page.add(key, to_object(key, view));
+            }
+        });
+    }
+
+    auto result = page.finish();
+    debug_leave_func_with_value("{} objects, next cursor '{}'", std::get<0>(result).size(), std::get<1>(result));
+    return result;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+uint64_t PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::multi_get_size(const KT& key) const {
+    debug_enter_func_with_args("key={}", key);
+
+    derecho::Replicated<PersistentCompactCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_get_size)>(key);
+    auto& replies = results.get();
+    uint64_t ret = replies.begin()->second.get();
+
+    debug_leave_func();
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+uint64_t PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::get_size(const KT& key, const persistent::version_t& ver, const bool stable,
+                                                                     const bool exact) const {
+    debug_enter_func_with_args("key={},ver=0x{:x},stable={},exact={}", key, ver, stable, exact);
+    // the size of the object as it is sent by get.
+    const VT value = this->get(key, ver, stable, exact);
+    debug_leave_func();
+    return value.is_valid() ? mutils::bytes_size(value) : 0;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+uint64_t PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::get_size_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const {
+    debug_enter_func_with_args("key={},ts_us={},stable={}", key, ts_us, stable);
+    const VT value = this->get_by_time(key, ts_us, stable);
+    debug_leave_func();
+    return value.is_valid() ? mutils::bytes_size(value) : 0;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+ObjectHead PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::head(const KT& key, const persistent::version_t& ver, const bool stable) const {
+    debug_enter_func_with_args("key={},ver=0x{:x},stable={}", key, ver, stable);
+    const persistent::version_t requested_version = this->resolve_version(ver, stable);
+    if(requested_version != CURRENT_VERSION) {
+        const VT value = this->read_object(key, requested_version, false);
+        debug_leave_func_with_value("key={} at version:0x{:x}", key, requested_version);
+        return value.is_valid() ? make_object_head(value) : ObjectHead{};
+    }
+    // the metadata is read from the slot, without materializing the object.
+    std::shared_lock<std::shared_mutex> rlck(this->persistent_core->kv_table_mutex);
+    FlatUInt64Table::View view;
+    if(!this->persistent_core->kv_table.find(key, view)) {
+        debug_leave_func_with_value("key:{} is not found", key);
+        return ObjectHead{};
+    }
+    debug_leave_func();
+    return ObjectHead{view.version, view.timestamp_us, persistent::INVALID_VERSION, persistent::INVALID_VERSION,
+                      view.size, false};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::vector<ObjectHead> PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::head_batch(const std::vector<KT>& keys,
+                                                                                      const persistent::version_t& ver,
+                                                                                      const bool stable) const {
+    debug_enter_func_with_args("{} keys,ver=0x{:x}", keys.size(), ver);
+    // resolve the version once, so that the heads are read at the same version.
+    const persistent::version_t requested_version = this->resolve_version(ver, stable);
+    std::vector<ObjectHead> heads;
+    heads.reserve(keys.size());
+    for(const auto& key : keys) {
+        heads.emplace_back(this->head(key, requested_version, false));
+    }
+    debug_leave_func();
+    return heads;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::vector<KT> PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::ordered_list_keys(const std::string& prefix) {
+    debug_enter_func_with_args("prefix={}", prefix);
+
+    std::vector<KT> key_list;
+    if(prefix.empty()) {
+        // the ordered path is the only writer, so it reads kv_table without the lock.
+        key_list.reserve(this->persistent_core->kv_table.size());
+        this->persistent_core->kv_table.for_each([&key_list](uint64_t key, const FlatUInt64Table::View&) {
+            key_list.push_back(key);
+        });
+    }
+
+    debug_leave_func();
+    return key_list;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::ordered_put(const VT& value, bool as_trigger) {
+    debug_enter_func_with_args("key={}", value.get_key_ref());
+
+    auto version_and_hlc = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index).get_current_version();
+    version_tuple version_and_timestamp{persistent::INVALID_VERSION, 0};
+
+    if(this->internal_ordered_put(value,as_trigger) == true) {
+        version_and_timestamp = {std::get<0>(version_and_hlc),std::get<1>(version_and_hlc).m_rtc_us};
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_timestamp),
+            std::get<1>(version_and_timestamp));
+
+    return version_and_timestamp;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::ordered_put_and_forget(const VT& value, bool as_trigger) {
+    debug_enter_func_with_args("key={}", value.get_key_ref());
+    this->internal_ordered_put(value,as_trigger);
+    debug_leave_func();
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::ordered_put_batch(const std::vector<VT>& values, bool as_trigger) {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    auto version_and_hlc = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index).get_current_version();
+    version_tuple version_and_timestamp{persistent::INVALID_VERSION, 0};
+
+    if(this->internal_ordered_put_batch(values,as_trigger) == true) {
+        version_and_timestamp = {std::get<0>(version_and_hlc),std::get<1>(version_and_hlc).m_rtc_us};
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_timestamp),
+            std::get<1>(version_and_timestamp));
+
+    return version_and_timestamp;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+bool PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::internal_ordered_put(const VT& value, bool as_trigger) {
+    auto version_and_hlc = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index).get_current_version();
+
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        value.set_version(std::get<0>(version_and_hlc));
+    }
+    if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+        value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+    }
+
+    FlatUInt64Table::View current;
+    const persistent::version_t version_by_key = this->persistent_core->ordered_find(value.get_key_ref(), current)
+                                                         ? current.version
+                                                         : persistent::INVALID_VERSION;
+    // Verify previous version MUST happen before update previous versions.
+    if constexpr(std::is_base_of<IVerifyPreviousVersion, VT>::value) {
+        if(!value.verify_previous_version(this->persistent_core.getLatestVersion(), version_by_key)) {
+            // reject the update by returning an invalid version and timestamp
+            return false;
+        }
+    }
+    if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+        value.set_previous_version(this->persistent_core.getLatestVersion(), version_by_key);
+    }
+
+    if(!as_trigger) {
+        this->persistent_core->ordered_put(value.get_key_ref(), std::get<0>(version_and_hlc), std::get<1>(version_and_hlc).m_rtc_us,
+                                           value.get_payload_bytes(), value.get_payload_size());
+    }
+
+    if(cascade_watcher_ptr) {
+        (*cascade_watcher_ptr)(
+                this->subgroup_index,
+                group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index).get_shard_num(),
+                group->get_rpc_caller_id(),
+                value.get_key_ref(), value, cascade_context_ptr);
+    }
+
+    return true;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+bool PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::internal_ordered_put_batch(const std::vector<VT>& values, bool as_trigger) {
+    auto version_and_hlc = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index).get_current_version();
+
+    std::set<KT> keys;
+    for(const auto& value : values) {
+        if(!keys.insert(value.get_key_ref()).second) {
+            dbg_default_warn("{}: rejected a batch with duplicate key {}.", __PRETTY_FUNCTION__, value.get_key_ref());
+            return false;
+        }
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            value.set_version(std::get<0>(version_and_hlc));
+        }
+        if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+            value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+        }
+    }
+
+    // verify every object against the state before the batch, so that the batch is applied all or nothing.
+    const persistent::version_t prev_ver = this->persistent_core.getLatestVersion();
+    std::vector<persistent::version_t> versions_by_key;
+    versions_by_key.reserve(values.size());
+    for(const auto& value : values) {
+        FlatUInt64Table::View current;
+        versions_by_key.push_back(this->persistent_core->ordered_find(value.get_key_ref(), current) ? current.version : persistent::INVALID_VERSION);
+        if constexpr(std::is_base_of<IVerifyPreviousVersion, VT>::value) {
+            if(!value.verify_previous_version(prev_ver, versions_by_key.back())) {
+                return false;
+            }
+        }
+    }
+
+    for(std::size_t i = 0; i < values.size(); i++) {
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            values[i].set_previous_version(prev_ver, versions_by_key[i]);
+        }
+    }
+    if(!as_trigger) {
+        // the objects of a batch share the delta of its version.
+        for(const auto& value : values) {
+            this->persistent_core->ordered_put(value.get_key_ref(), std::get<0>(version_and_hlc), std::get<1>(version_and_hlc).m_rtc_us,
+                                               value.get_payload_bytes(), value.get_payload_size());
+        }
+    }
+
+    if(cascade_watcher_ptr) {
+        for(const auto& value : values) {
+            (*cascade_watcher_ptr)(
+                    this->subgroup_index,
+                    group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index).get_shard_num(),
+                    group->get_rpc_caller_id(),
+                    value.get_key_ref(), value, cascade_context_ptr);
+        }
+    }
+
+    return true;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::ordered_remove(const KT& key) {
+    debug_enter_func_with_args("key={}", key);
+
+    auto version_and_hlc = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index).get_current_version();
+
+    FlatUInt64Table::View current;
+    if(this->persistent_core->ordered_find(key, current)) {
+        auto value = create_null_object_cb<KT, VT, IK, IV>(key);
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            value.set_version(std::get<0>(version_and_hlc));
+        }
+        if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+            value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+        }
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            value.set_previous_version(this->persistent_core.getLatestVersion(), current.version);
+        }
+        this->persistent_core->ordered_remove(key, std::get<0>(version_and_hlc), std::get<1>(version_and_hlc).m_rtc_us);
+
+        if(cascade_watcher_ptr) {
+            (*cascade_watcher_ptr)(
+                    this->subgroup_index,
+                    group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index).get_shard_num(),
+                    group->get_rpc_caller_id(),
+                    key, value, cascade_context_ptr);
+        }
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us);
+
+    return {std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+const VT PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::ordered_get(const KT& key) {
+    debug_enter_func_with_args("key={}", key);
+    debug_leave_func();
+    return this->read_object(key);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+uint64_t PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::ordered_get_size(const KT& key) {
+    debug_enter_func_with_args("key={}", key);
+    const VT value = this->read_object(key);
+    debug_leave_func();
+    return value.is_valid() ? mutils::bytes_size(value) : 0;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::pair<uint64_t, uint64_t> PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::get_memory_usage() const {
+    std::shared_lock<std::shared_mutex> rlck(this->persistent_core->kv_table_mutex);
+    return {this->persistent_core->kv_table.size(), this->persistent_core->kv_table.memory_usage()};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::trigger_put(const VT& value) const {
+    debug_enter_func_with_args("key={}", value.get_key_ref());
+
+    if(cascade_watcher_ptr) {
+        (*cascade_watcher_ptr)(
+                this->subgroup_index,
+                group->template get_subgroup<PersistentCompactCascadeStore<KT, VT, IK, IV, ST>>(this->subgroup_index).get_shard_num(),
+                group->get_rpc_caller_id(),
+                value.get_key_ref(), value, cascade_context_ptr, true);
+    }
+
+    debug_leave_func();
+}
+
+#ifdef ENABLE_EVALUATION
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::dump_timestamp_log(const std::string& filename) const {
+    debug_enter_func_with_args("filename={}", filename);
+    derecho::Replicated<PersistentCompactCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCompactCascadeStore>(this->subgroup_index);
+    auto result = subgroup_handle.template ordered_send<RPC_NAME(ordered_dump_timestamp_log)>(filename);
+    auto& replies = result.get();
+    for(auto r : replies) {
+        volatile uint32_t _ = r;
+        _ = _;
+    }
+    debug_leave_func();
+    return;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::ordered_dump_timestamp_log(const std::string& filename) {
+    debug_enter_func_with_args("filename={}", filename);
+    TimestampLogger::flush(filename);
+    debug_leave_func();
+}
+#ifdef DUMP_TIMESTAMP_WORKAROUND
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::dump_timestamp_log_workaround(const std::string& filename) const {
+    debug_enter_func_with_args("filename={}", filename);
+    TimestampLogger::flush(filename);
+    debug_leave_func();
+}
+#endif
+#endif  // ENABLE_EVALUATION
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::unique_ptr<PersistentCompactCascadeStore<KT, VT, IK, IV, ST>> PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::from_bytes(
+        mutils::DeserializationManager* dsm,
+        uint8_t const* buf) {
+    auto persistent_core_ptr = mutils::from_bytes<persistent::Persistent<CompactDeltaStoreCore, ST>>(dsm, buf);
+    return std::make_unique<PersistentCompactCascadeStore>(std::move(*persistent_core_ptr),
+                                                           dsm->registered<CriticalDataPathObserver<PersistentCompactCascadeStore<KT, VT, IK, IV>>>() ? &(dsm->mgr<CriticalDataPathObserver<PersistentCompactCascadeStore<KT, VT, IK, IV>>>()) : nullptr,
+                                                           dsm->registered<ICascadeContext>() ? &(dsm->mgr<ICascadeContext>()) : nullptr);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::PersistentCompactCascadeStore(
+        persistent::PersistentRegistry* pr,
+        CriticalDataPathObserver<PersistentCompactCascadeStore<KT, VT, IK, IV>>* cw,
+        ICascadeContext* cc) : persistent_core([]() {
+                                   return std::make_unique<CompactDeltaStoreCore>();
+                               },
+                                               nullptr, pr),
+                               cascade_watcher_ptr(cw),
+                               cascade_context_ptr(cc) {
+    debug_enter_func();
+    // the log has been replayed into kv_table by the constructor of persistent_core.
+    debug_leave_func_with_value("recovered {} objects at version:0x{:x}", persistent_core->kv_table.size(),
+                                persistent_core.getLatestVersion());
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+PersistentCompactCascadeStore<KT, VT, IK, IV, ST>::PersistentCompactCascadeStore(
+        persistent::Persistent<CompactDeltaStoreCore, ST>&& _persistent_core,
+        CriticalDataPathObserver<PersistentCompactCascadeStore<KT, VT, IK, IV>>* cw,
+        ICascadeContext* cc) : persistent_core(std::move(_persistent_core)),
+                               cascade_watcher_ptr(cw),
+                               cascade_context_ptr(cc) {
+    debug_enter_func_with_args("move to persistent_core, size={}", persistent_core->kv_table.size());
+    debug_leave_func();
+}
+
+}  // namespace cascade
+}  // namespace derecho
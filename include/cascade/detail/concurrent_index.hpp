@@ -0,0 +1,298 @@
+#pragma once
+
+#include <cascade/config.h>
+
+#include "interned_key_map.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * EpochDomain is a process-wide epoch based reclamation (EBR) domain.
+ *
+ * Readers announce the global epoch they observed on entry to a read-side critical section, and clear it on exit.
+ * Writers tag every unlinked object with the epoch at which it was retired, then advance the global epoch. An object
+ * retired at epoch E is freed only after every reader active at epoch E or earlier has left its critical section.
+ * This gives readers wait-free access to shared data structures without a seqlock retry loop.
+ */
+class EpochDomain {
+public:
+    /**
+     * The maximum number of threads that can be inside read-side critical sections at the same time. A thread holds
+     * a slot from its first read until it exits.
+     */
+    static constexpr uint32_t MAX_READER_SLOTS = 1024;
+    /**
+     * Epoch value of a reader slot not in a critical section.
+     */
+    static constexpr uint64_t QUIESCENT_EPOCH = 0;
+
+private:
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{QUIESCENT_EPOCH};
+        std::atomic<bool> in_use{false};
+    };
+    struct ThreadState {
+        uint32_t slot_index;
+        uint32_t depth;
+        ThreadState();
+        ~ThreadState();
+    };
+
+    alignas(64) std::atomic<uint64_t> global_epoch;
+    std::atomic<uint32_t> slot_high_watermark;
+    ReaderSlot slots[MAX_READER_SLOTS];
+
+    EpochDomain();
+    inline uint32_t claim_slot();
+    inline void release_slot(uint32_t slot_index);
+    static inline ThreadState& thread_state();
+
+public:
+    /**
+     * Get the process-wide epoch domain.
+     */
+    static inline EpochDomain& get();
+    /**
+     * Enter a read-side critical section. Critical sections can be nested.
+     */
+    inline void enter();
+    /**
+     * Leave a read-side critical section.
+     */
+    inline void leave();
+    /**
+     * Advance the global epoch.
+     *
+     * @return the epoch before advancing, which is the tag for objects retired just before this call.
+     */
+    inline uint64_t advance();
+    /**
+     * Get the oldest epoch still observed by an active reader.
+     *
+     * @return the oldest active epoch, or UINT64_MAX if no reader is in a critical section.
+     */
+    inline uint64_t min_active_epoch() const;
+};
+
+/**
+ * RAII guard for a read-side critical section in the process-wide EpochDomain.
+ */
+class EpochGuard {
+public:
+    EpochGuard() { EpochDomain::get().enter(); }
+    ~EpochGuard() { EpochDomain::get().leave(); }
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+/**
+ * Test if the pathname of a key starts with a prefix, without materializing the pathname. This is equivalent to
+ * `get_pathname<KT>(key).find(prefix) == 0`.
+ *
+ * @tparam KT       - the key type
+ * @param  key      - the key
+ * @param  prefix   - the prefix
+ * @param  separator- the path separator
+ *
+ * @return true if the pathname of the key starts with prefix.
+ */
+template <typename KT>
+inline bool pathname_has_prefix(const KT& key, const std::string& prefix, char separator = PATH_SEPARATOR);
+inline bool pathname_has_prefix(const InternedPathname& key, const std::string& prefix, char separator = PATH_SEPARATOR);
+
+/**
+ * Test if a key, as a string, starts with a prefix, without materializing an interned key.
+ */
+template <typename KT>
+inline bool key_starts_with(const KT& key, const std::string& prefix);
+inline bool key_starts_with(const InternedPathname& key, const std::string& prefix);
+
+/**
+ * ConcurrentKeyIndex is a single-writer, multi-reader index over the entries of a node-based map, like the
+ * `key_value_map_t<KT,VT>` kv_map of the cascade stores, whose keys are stored as `stored_key_t<KT>`. The index keeps no
+ * key of its own, and it is looked up by KT.
+ *
+ * Every key has one index node, which is reachable in two ways:
+ * - an open addressing hash table of node pointers, for point lookups;
+ * - a skip list in key order, for listing keys by prefix in O(log(n) + matches). Since keys sharing a pathname prefix
+ *   are contiguous in lexicographical order, this replaces a full scan of the map.
+ *
+ * The index does not own the entries it points to. The writer, which is the only thread calling the mutating APIs,
+ * publishes the address of an entry after it is fully constructed. When the entry is replaced or dropped, the writer
+ * hands its storage (e.g. a node handle extracted from the map) to retire() instead of destroying it. Retired objects,
+ * including index nodes and old hash tables, are destroyed by reclaim() once no reader can observe them.
+ *
+ * Readers call the const APIs inside an EpochGuard and MUST NOT hold the returned pointers after the guard is
+ * released.
+ *
+ * @tparam KT   - the key type
+ * @tparam VT   - the value type
+ */
+template <typename KT, typename VT>
+class ConcurrentKeyIndex {
+public:
+    using entry_type = std::pair<const stored_key_t<KT>, VT>;
+    static constexpr uint32_t MAX_HEIGHT = 24;
+
+private:
+    struct Node {
+        const uint64_t hash;
+        std::atomic<const entry_type*> entry;
+        const uint32_t height;
+        std::unique_ptr<std::atomic<Node*>[]> next;
+        Node(uint64_t _hash, const entry_type* _entry, uint32_t _height);
+    };
+
+    /* open addressing table of node pointers, with linear probing */
+    struct Table {
+        const size_t mask;
+        std::unique_ptr<std::atomic<Node*>[]> slots;
+        explicit Table(size_t capacity);
+    };
+
+    struct Retired {
+        virtual ~Retired() = default;
+    };
+
+    template <typename T>
+    struct RetiredObject : public Retired {
+        T object;
+        explicit RetiredObject(T&& _object) : object(std::move(_object)) {}
+    };
+
+    std::atomic<Table*> table;
+    /* the skip list head, which has no entry */
+    Node head;
+    size_t num_entries;
+    /* live nodes plus tombstones in the hash table */
+    size_t num_used_slots;
+    uint64_t random_state;
+    /* retired objects tagged with the epoch when they were retired, in ascending epoch order */
+    std::vector<std::pair<uint64_t, std::unique_ptr<Retired>>> limbo;
+
+    static inline Node* tombstone();
+    /**
+     * Hash a key or a stored key, which hash the same.
+     */
+    template <typename K>
+    static inline uint64_t hash_of(const K& key);
+    inline uint32_t random_height();
+    /**
+     * Find the hash slot of a key. Writer only.
+     */
+    template <typename K>
+    std::atomic<Node*>* find_slot(const K& key, uint64_t hash) const;
+    /**
+     * Find the predecessors of a key at every level of the skip list.
+     */
+    template <typename K>
+    Node* find_predecessors(const K& key, Node** preds) const;
+    /**
+     * Find the first node whose key is not less than `key`.
+     */
+    Node* seek(const KT& key) const;
+    /**
+     * Rebuild the hash table into a table of the given capacity, dropping tombstones. The old table is retired.
+     */
+    void rehash(size_t capacity);
+
+public:
+    /**
+     * Look up a key. Must be called inside an EpochGuard.
+     *
+     * @param key   - the key
+     *
+     * @return the pointer to the value, or nullptr if the key is not in the index.
+     */
+    const VT* find(const KT& key) const;
+    /**
+     * Visit all entries in key order. Must be called inside an EpochGuard. Entries published or erased during the
+     * traversal may or may not be visited.
+     *
+     * @param visitor   - the visitor lambda, returning false to stop the traversal.
+     */
+    void for_each(const std::function<bool(const KT&, const VT&)>& visitor) const;
+    /**
+     * Visit all entries in key order with their keys as stored, e.g. to measure the keys without materializing them.
+     * Must be called inside an EpochGuard.
+     *
+     * @param visitor   - the visitor lambda, returning false to stop the traversal.
+     */
+    void for_each_entry(const std::function<bool(const entry_type&)>& visitor) const;
+    /**
+     * Visit, in key order, the entries whose pathname starts with `prefix`, which is the matching rule of list_keys.
+     * Must be called inside an EpochGuard.
+     *
+     * @param prefix    - the prefix
+     * @param visitor   - the visitor lambda, returning false to stop the traversal.
+     */
+    void for_each_with_prefix(const std::string& prefix, const std::function<bool(const KT&, const VT&)>& visitor) const;
+    /**
+     * Visit, in key order, the entries whose pathname starts with `prefix` and whose key is greater than
+     * `start_after`, which resumes a listing after its last key. Must be called inside an EpochGuard.
+     *
+     * @param prefix        - the prefix
+     * @param start_after   - the last key visited before
+     * @param visitor       - the visitor lambda, returning false to stop the traversal.
+     */
+    void for_each_with_prefix_after(const std::string& prefix, const KT& start_after,
+                                    const std::function<bool(const KT&, const VT&)>& visitor) const;
+    /**
+     * Insert or replace the entry of a key. Writer only.
+     *
+     * @param entry - a fully constructed entry, which must stay valid until it is retired.
+     */
+    void publish(const entry_type& entry);
+    /**
+     * An entry of another type, e.g. of a map whose keys are not stored as stored_key_t<KT>, would be published as a
+     * temporary copy.
+     */
+    template <typename Entry>
+    void publish(const Entry& entry) = delete;
+    /**
+     * Remove a key from the index. Writer only.
+     *
+     * @param key   - the key
+     *
+     * @return true if the key was found and removed.
+     */
+    bool erase(const KT& key);
+    /**
+     * Drop all entries. Writer only.
+     */
+    void clear();
+    /**
+     * Defer the destruction of an object until no reader can observe it. Writer only.
+     *
+     * @param object - the object to retire, e.g. a node handle extracted from the map owning the entries.
+     */
+    template <typename T>
+    void retire(T&& object);
+    /**
+     * Destroy the retired objects that are no longer reachable by any reader. Writer only.
+     */
+    void reclaim();
+    /**
+     * @return the number of entries in the index.
+     */
+    size_t size() const;
+
+    ConcurrentKeyIndex();
+    ConcurrentKeyIndex(const ConcurrentKeyIndex&) = delete;
+    ConcurrentKeyIndex& operator=(const ConcurrentKeyIndex&) = delete;
+    virtual ~ConcurrentKeyIndex();
+};
+
+}  // namespace cascade
+}  // namespace derecho
+
+#include "concurrent_index_impl.hpp"
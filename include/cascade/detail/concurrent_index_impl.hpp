@@ -0,0 +1,458 @@
+#pragma once
+#include <limits>
+#include <thread>
+#include <type_traits>
+
+namespace derecho {
+namespace cascade {
+
+inline EpochDomain::ThreadState::ThreadState() : slot_index(EpochDomain::get().claim_slot()), depth(0) {}
+
+inline EpochDomain::ThreadState::~ThreadState() {
+    EpochDomain::get().release_slot(slot_index);
+}
+
+inline EpochDomain::EpochDomain() : global_epoch(QUIESCENT_EPOCH + 1), slot_high_watermark(0) {}
+
+inline EpochDomain& EpochDomain::get() {
+    static EpochDomain domain;
+    return domain;
+}
+
+inline EpochDomain::ThreadState& EpochDomain::thread_state() {
+    static thread_local ThreadState state;
+    return state;
+}
+
+inline uint32_t EpochDomain::claim_slot() {
+    while(true) {
+        for(uint32_t i = 0; i < MAX_READER_SLOTS; i++) {
+            bool expected = false;
+            if(!slots[i].in_use.load(std::memory_order_relaxed) &&
+               slots[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                uint32_t hw = slot_high_watermark.load(std::memory_order_seq_cst);
+                while(hw < i + 1 && !slot_high_watermark.compare_exchange_weak(hw, i + 1, std::memory_order_seq_cst)) {
+                }
+                return i;
+            }
+        }
+        // all slots are taken, wait for a reader thread to exit.
+        std::this_thread::yield();
+    }
+}
+
+inline void EpochDomain::release_slot(uint32_t slot_index) {
+    slots[slot_index].epoch.store(QUIESCENT_EPOCH, std::memory_order_release);
+    slots[slot_index].in_use.store(false, std::memory_order_release);
+}
+
+inline void EpochDomain::enter() {
+    ThreadState& state = thread_state();
+    if(state.depth++ == 0) {
+        slots[state.slot_index].epoch.store(global_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        // the announcement must be visible before any shared pointer is loaded.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+inline void EpochDomain::leave() {
+    ThreadState& state = thread_state();
+    if(--state.depth == 0) {
+        slots[state.slot_index].epoch.store(QUIESCENT_EPOCH, std::memory_order_release);
+    }
+}
+
+inline uint64_t EpochDomain::advance() {
+    return global_epoch.fetch_add(1, std::memory_order_seq_cst);
+}
+
+inline uint64_t EpochDomain::min_active_epoch() const {
+    // pairs with the fence in enter(): either the reader sees the unlinked state, or we see its announcement.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t min_epoch = std::numeric_limits<uint64_t>::max();
+    uint32_t hw = slot_high_watermark.load(std::memory_order_seq_cst);
+    for(uint32_t i = 0; i < hw; i++) {
+        uint64_t e = slots[i].epoch.load(std::memory_order_seq_cst);
+        if(e != QUIESCENT_EPOCH && e < min_epoch) {
+            min_epoch = e;
+        }
+    }
+    return min_epoch;
+}
+
+template <typename KT>
+inline bool pathname_has_prefix(const KT& key, const std::string& prefix, char separator) {
+    if constexpr(std::is_convertible_v<KT, std::string>) {
+        if(prefix.empty()) {
+            return true;
+        }
+        const std::string& str = key;
+        size_t pos = str.rfind(separator);
+        return (pos != std::string::npos) && (pos >= prefix.size()) && (str.compare(0, prefix.size(), prefix) == 0);
+    } else {
+        // keys other than strings have empty pathnames.
+        return prefix.empty();
+    }
+}
+
+inline bool pathname_has_prefix(const InternedPathname& key, const std::string& prefix, char separator) {
+    if(prefix.empty()) {
+        return true;
+    }
+    if(separator != PATH_SEPARATOR) {
+        return pathname_has_prefix(key.str(), prefix, separator);
+    }
+    // the interned prefix of the key ends with its last separator.
+    const std::size_t prefix_size = key.get_prefix().size();
+    return (prefix_size > prefix.size()) && key.starts_with(prefix);
+}
+
+template <typename KT>
+inline bool key_starts_with(const KT& key, const std::string& prefix) {
+    const std::string& str = key;
+    return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+inline bool key_starts_with(const InternedPathname& key, const std::string& prefix) {
+    return key.starts_with(prefix);
+}
+
+template <typename KT, typename VT>
+ConcurrentKeyIndex<KT, VT>::Node::Node(uint64_t _hash, const entry_type* _entry, uint32_t _height)
+        : hash(_hash), entry(_entry), height(_height), next(new std::atomic<Node*>[_height]) {
+    for(uint32_t i = 0; i < height; i++) {
+        next[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+template <typename KT, typename VT>
+ConcurrentKeyIndex<KT, VT>::Table::Table(size_t capacity)
+        : mask(capacity - 1), slots(new std::atomic<Node*>[capacity]) {
+    for(size_t i = 0; i < capacity; i++) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+template <typename KT, typename VT>
+inline typename ConcurrentKeyIndex<KT, VT>::Node* ConcurrentKeyIndex<KT, VT>::tombstone() {
+    return reinterpret_cast<Node*>(static_cast<uintptr_t>(1));
+}
+
+template <typename KT, typename VT>
+template <typename K>
+inline uint64_t ConcurrentKeyIndex<KT, VT>::hash_of(const K& key) {
+    uint64_t h;
+    if constexpr(std::is_same_v<K, InternedPathname>) {
+        h = key.hash();
+    } else if constexpr(!std::is_same_v<stored_key_t<KT>, KT>) {
+        h = pathname_hash(key);
+    } else {
+        h = static_cast<uint64_t>(std::hash<KT>{}(key));
+    }
+    // finalizer from MurmurHash3 to spread integer keys over the low bits.
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+template <typename KT, typename VT>
+inline uint32_t ConcurrentKeyIndex<KT, VT>::random_height() {
+    // xorshift64, with a branching factor of 4
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    uint32_t height = 1;
+    uint64_t bits = random_state;
+    while(height < MAX_HEIGHT && (bits & 3) == 0) {
+        height++;
+        bits >>= 2;
+    }
+    return height;
+}
+
+template <typename KT, typename VT>
+template <typename K>
+std::atomic<typename ConcurrentKeyIndex<KT, VT>::Node*>* ConcurrentKeyIndex<KT, VT>::find_slot(const K& key, uint64_t hash) const {
+    Table* t = table.load(std::memory_order_relaxed);
+    for(size_t i = hash & t->mask;; i = (i + 1) & t->mask) {
+        Node* node = t->slots[i].load(std::memory_order_relaxed);
+        if(node == nullptr) {
+            return nullptr;
+        }
+        if(node != tombstone() && node->hash == hash && node->entry.load(std::memory_order_relaxed)->first == key) {
+            return &t->slots[i];
+        }
+    }
+}
+
+template <typename KT, typename VT>
+template <typename K>
+typename ConcurrentKeyIndex<KT, VT>::Node* ConcurrentKeyIndex<KT, VT>::find_predecessors(const K& key, Node** preds) const {
+    Node* pred = const_cast<Node*>(&head);
+    for(int32_t level = MAX_HEIGHT - 1; level >= 0; level--) {
+        Node* node = pred->next[level].load(std::memory_order_acquire);
+        while(node != nullptr && node->entry.load(std::memory_order_acquire)->first < key) {
+            pred = node;
+            node = pred->next[level].load(std::memory_order_acquire);
+        }
+        if(preds != nullptr) {
+            preds[level] = pred;
+        }
+    }
+    return pred->next[0].load(std::memory_order_acquire);
+}
+
+template <typename KT, typename VT>
+typename ConcurrentKeyIndex<KT, VT>::Node* ConcurrentKeyIndex<KT, VT>::seek(const KT& key) const {
+    return find_predecessors(key, nullptr);
+}
+
+template <typename KT, typename VT>
+const VT* ConcurrentKeyIndex<KT, VT>::find(const KT& key) const {
+    const uint64_t hash = hash_of(key);
+    const Table* t = table.load(std::memory_order_acquire);
+    for(size_t i = hash & t->mask;; i = (i + 1) & t->mask) {
+        Node* node = t->slots[i].load(std::memory_order_acquire);
+        if(node == nullptr) {
+            return nullptr;
+        }
+        if(node != tombstone() && node->hash == hash) {
+            const entry_type* entry = node->entry.load(std::memory_order_acquire);
+            if(entry->first == key) {
+                return &entry->second;
+            }
+        }
+    }
+}
+
+template <typename KT, typename VT>
+void ConcurrentKeyIndex<KT, VT>::for_each(const std::function<bool(const KT&, const VT&)>& visitor) const {
+    for(Node* node = head.next[0].load(std::memory_order_acquire); node != nullptr;
+        node = node->next[0].load(std::memory_order_acquire)) {
+        const entry_type* entry = node->entry.load(std::memory_order_acquire);
+        if(!visitor(entry->first, entry->second)) {
+            break;
+        }
+    }
+}
+
+template <typename KT, typename VT>
+void ConcurrentKeyIndex<KT, VT>::for_each_entry(const std::function<bool(const entry_type&)>& visitor) const {
+    for(Node* node = head.next[0].load(std::memory_order_acquire); node != nullptr;
+        node = node->next[0].load(std::memory_order_acquire)) {
+        if(!visitor(*node->entry.load(std::memory_order_acquire))) {
+            break;
+        }
+    }
+}
+
+template <typename KT, typename VT>
+void ConcurrentKeyIndex<KT, VT>::for_each_with_prefix(const std::string& prefix,
+                                                      const std::function<bool(const KT&, const VT&)>& visitor) const {
+    if constexpr(std::is_convertible_v<KT, std::string> && std::is_constructible_v<KT, const std::string&>) {
+        if(prefix.empty()) {
+            for_each(visitor);
+            return;
+        }
+        // all keys starting with prefix are contiguous; only those whose pathname also starts with it match.
+        for(Node* node = seek(KT(prefix)); node != nullptr; node = node->next[0].load(std::memory_order_acquire)) {
+            const entry_type* entry = node->entry.load(std::memory_order_acquire);
+            if(!key_starts_with(entry->first, prefix)) {
+                break;
+            }
+            if(pathname_has_prefix(entry->first, prefix) && !visitor(entry->first, entry->second)) {
+                break;
+            }
+        }
+    } else {
+        if(prefix.empty()) {
+            for_each(visitor);
+        }
+    }
+}
+
+template <typename KT, typename VT>
+void ConcurrentKeyIndex<KT, VT>::for_each_with_prefix_after(const std::string& prefix, const KT& start_after,
+                                                            const std::function<bool(const KT&, const VT&)>& visitor) const {
+    if constexpr(std::is_convertible_v<KT, std::string> && std::is_constructible_v<KT, const std::string&>) {
+        // the keys starting with prefix are contiguous, so the traversal starts at the later of prefix and start_after.
+        const KT prefix_key(prefix);
+        const KT& first = (start_after < prefix_key) ? prefix_key : start_after;
+        for(Node* node = seek(first); node != nullptr; node = node->next[0].load(std::memory_order_acquire)) {
+            const entry_type* entry = node->entry.load(std::memory_order_acquire);
+            if(!key_starts_with(entry->first, prefix)) {
+                break;
+            }
+            if(entry->first == start_after) {
+                continue;
+            }
+            if(pathname_has_prefix(entry->first, prefix) && !visitor(entry->first, entry->second)) {
+                break;
+            }
+        }
+    } else {
+        if(!prefix.empty()) {
+            return;
+        }
+        for(Node* node = seek(start_after); node != nullptr; node = node->next[0].load(std::memory_order_acquire)) {
+            const entry_type* entry = node->entry.load(std::memory_order_acquire);
+            if(entry->first == start_after) {
+                continue;
+            }
+            if(!visitor(entry->first, entry->second)) {
+                break;
+            }
+        }
+    }
+}
+
+template <typename KT, typename VT>
+void ConcurrentKeyIndex<KT, VT>::publish(const entry_type& entry) {
+    const uint64_t hash = hash_of(entry.first);
+    std::atomic<Node*>* slot = find_slot(entry.first, hash);
+    if(slot != nullptr) {
+        slot->load(std::memory_order_relaxed)->entry.store(&entry, std::memory_order_release);
+        return;
+    }
+    // link the new node into the skip list from the bottom up, so that a reader reaching it from an upper level can
+    // always continue at the lower levels.
+    Node* preds[MAX_HEIGHT];
+    find_predecessors(entry.first, preds);
+    Node* node = new Node(hash, &entry, random_height());
+    for(uint32_t level = 0; level < node->height; level++) {
+        node->next[level].store(preds[level]->next[level].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    for(uint32_t level = 0; level < node->height; level++) {
+        preds[level]->next[level].store(node, std::memory_order_release);
+    }
+    // then make it reachable by hash, reusing the first tombstone on the probing path.
+    Table* t = table.load(std::memory_order_relaxed);
+    for(size_t i = hash & t->mask;; i = (i + 1) & t->mask) {
+        Node* occupant = t->slots[i].load(std::memory_order_relaxed);
+        if(occupant == nullptr || occupant == tombstone()) {
+            if(occupant == nullptr) {
+                num_used_slots++;
+            }
+            t->slots[i].store(node, std::memory_order_release);
+            break;
+        }
+    }
+    num_entries++;
+    if(num_used_slots * 2 > t->mask + 1) {
+        size_t capacity = t->mask + 1;
+        while(num_entries * 4 > capacity) {
+            capacity <<= 1;
+        }
+        rehash(capacity);
+    }
+}
+
+template <typename KT, typename VT>
+bool ConcurrentKeyIndex<KT, VT>::erase(const KT& key) {
+    std::atomic<Node*>* slot = find_slot(key, hash_of(key));
+    if(slot == nullptr) {
+        return false;
+    }
+    Node* node = slot->load(std::memory_order_relaxed);
+    slot->store(tombstone(), std::memory_order_release);
+    // unlink from the top down. Readers standing on 'node' can still follow its next pointers until it is reclaimed.
+    Node* preds[MAX_HEIGHT];
+    find_predecessors(key, preds);
+    for(int32_t level = node->height - 1; level >= 0; level--) {
+        if(preds[level]->next[level].load(std::memory_order_relaxed) == node) {
+            preds[level]->next[level].store(node->next[level].load(std::memory_order_relaxed), std::memory_order_release);
+        }
+    }
+    num_entries--;
+    retire(std::unique_ptr<Node>(node));
+    return true;
+}
+
+template <typename KT, typename VT>
+void ConcurrentKeyIndex<KT, VT>::rehash(size_t capacity) {
+    Table* old_table = table.load(std::memory_order_relaxed);
+    Table* new_table = new Table(capacity);
+    for(size_t i = 0; i <= old_table->mask; i++) {
+        Node* node = old_table->slots[i].load(std::memory_order_relaxed);
+        if(node == nullptr || node == tombstone()) {
+            continue;
+        }
+        for(size_t j = node->hash & new_table->mask;; j = (j + 1) & new_table->mask) {
+            if(new_table->slots[j].load(std::memory_order_relaxed) == nullptr) {
+                new_table->slots[j].store(node, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+    num_used_slots = num_entries;
+    table.store(new_table, std::memory_order_release);
+    retire(std::unique_ptr<Table>(old_table));
+}
+
+template <typename KT, typename VT>
+void ConcurrentKeyIndex<KT, VT>::clear() {
+    std::vector<std::unique_ptr<Node>> nodes;
+    for(Node* node = head.next[0].load(std::memory_order_relaxed); node != nullptr;
+        node = node->next[0].load(std::memory_order_relaxed)) {
+        nodes.emplace_back(node);
+    }
+    for(uint32_t level = 0; level < MAX_HEIGHT; level++) {
+        head.next[level].store(nullptr, std::memory_order_release);
+    }
+    Table* old_table = table.load(std::memory_order_relaxed);
+    table.store(new Table(old_table->mask + 1), std::memory_order_release);
+    num_entries = 0;
+    num_used_slots = 0;
+    retire(std::unique_ptr<Table>(old_table));
+    retire(std::move(nodes));
+}
+
+template <typename KT, typename VT>
+template <typename T>
+void ConcurrentKeyIndex<KT, VT>::retire(T&& object) {
+    static_assert(!std::is_lvalue_reference<T>::value, "retire() takes the ownership of an rvalue.");
+    limbo.emplace_back(EpochDomain::get().advance(),
+                       std::make_unique<RetiredObject<std::decay_t<T>>>(std::move(object)));
+}
+
+template <typename KT, typename VT>
+void ConcurrentKeyIndex<KT, VT>::reclaim() {
+    if(limbo.empty()) {
+        return;
+    }
+    uint64_t min_epoch = EpochDomain::get().min_active_epoch();
+    size_t num_reclaimable = 0;
+    while(num_reclaimable < limbo.size() && limbo[num_reclaimable].first < min_epoch) {
+        num_reclaimable++;
+    }
+    limbo.erase(limbo.begin(), limbo.begin() + num_reclaimable);
+}
+
+template <typename KT, typename VT>
+size_t ConcurrentKeyIndex<KT, VT>::size() const {
+    return num_entries;
+}
+
+template <typename KT, typename VT>
+ConcurrentKeyIndex<KT, VT>::ConcurrentKeyIndex()
+        : table(new Table(256)),
+          head(0, nullptr, MAX_HEIGHT),
+          num_entries(0),
+          num_used_slots(0),
+          random_state(reinterpret_cast<uintptr_t>(this) | 1) {}
+
+template <typename KT, typename VT>
+ConcurrentKeyIndex<KT, VT>::~ConcurrentKeyIndex() {
+    Node* node = head.next[0].load(std::memory_order_relaxed);
+    while(node != nullptr) {
+        Node* next = node->next[0].load(std::memory_order_relaxed);
+        delete node;
+        node = next;
+    }
+    delete table.load(std::memory_order_relaxed);
+    limbo.clear();
+}
+
+}  // namespace cascade
+}  // namespace derecho
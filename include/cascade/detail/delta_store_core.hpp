@@ -1,19 +1,101 @@
 #pragma once
 
+#include "cascade/blob_store.hpp"
 #include "cascade/cascade_interface.hpp"
+#include "cascade/merge_operator.hpp"
+#include "concurrent_index.hpp"
+#include "interned_key_map.hpp"
+#include "key_value_map.hpp"
+#include "object_head.hpp"
+#include "shared_tree_map.hpp"
 
 #include <derecho/core/derecho.hpp>
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+/**
+ * A persistent subgroup materializes a checkpoint of its state after this many versions have been applied since the
+ * last checkpoint, so that reconstructing a historical state, e.g. for a versioned list_keys, replays the log from the
+ * nearest checkpoint instead of from the beginning. 0 disables the version trigger.
+ */
+#define CASCADE_PERSISTENT_CHECKPOINT_INTERVAL  "CASCADE/persistent_checkpoint_interval"
+#define CASCADE_PERSISTENT_CHECKPOINT_INTERVAL_DEFAULT (4096)
+/**
+ * A checkpoint is also materialized after the applied objects since the last checkpoint reach this many bytes. 0
+ * disables the size trigger.
+ */
+#define CASCADE_PERSISTENT_CHECKPOINT_BYTES     "CASCADE/persistent_checkpoint_bytes"
+#define CASCADE_PERSISTENT_CHECKPOINT_BYTES_DEFAULT (268435456)
+/**
+ * The maximum number of checkpoints kept in memory. When it is exceeded, every other checkpoint is dropped and the
+ * triggers are doubled, so the checkpoints keep covering the whole log.
+ */
+#define CASCADE_PERSISTENT_MAX_CHECKPOINTS      "CASCADE/persistent_max_checkpoints"
+#define CASCADE_PERSISTENT_MAX_CHECKPOINTS_DEFAULT (32)
+/**
+ * A partial update of a key is logged as a patch unless the key already has this many patches since its last full
+ * image in the log, so that a historical read applies no more than this many patches. A partial update is also logged
+ * as a full image if the patch is not smaller than half of the image. 0 always logs full images.
+ */
+#define CASCADE_PERSISTENT_MAX_PATCH_CHAIN      "CASCADE/persistent_max_patch_chain"
+#define CASCADE_PERSISTENT_MAX_PATCH_CHAIN_DEFAULT (16)
+/**
+ * Before the log of a persistent subgroup is trimmed to its retention horizon, the current objects logged before the
+ * horizon are relocated, i.e. logged again, after it. A retention round relocates up to this many objects and holds
+ * the horizon before the rest, so that a round does not log a huge delta.
+ */
+#define CASCADE_PERSISTENT_RETENTION_BATCH      "CASCADE/persistent_retention_batch"
+#define CASCADE_PERSISTENT_RETENTION_BATCH_DEFAULT (1024)
+/**
+ * The payload of an object larger than this many bytes is written to a blob segment, and the log stores only a
+ * reference to it. An object pool can override it with its blob_threshold. 0 keeps all payloads in the log. A segment
+ * is removed when the log entries referring to it are trimmed, and a replica missing a segment, e.g. after losing its
+ * disk, fetches it from the other shard members.
+ */
+#define CASCADE_PERSISTENT_BLOB_THRESHOLD       "CASCADE/persistent_blob_threshold"
+#define CASCADE_PERSISTENT_BLOB_THRESHOLD_DEFAULT (0)
+/**
+ * A persistent subgroup writes its latest checkpoint persisted by all replicas to a snapshot file every this many
+ * seconds, so that a restarted node loads the snapshot and replays only the log after it. 0 disables snapshots.
+ */
+#define CASCADE_PERSISTENT_SNAPSHOT_INTERVAL    "CASCADE/persistent_snapshot_interval_sec"
+#define CASCADE_PERSISTENT_SNAPSHOT_INTERVAL_DEFAULT (300)
+/**
+ * The directory of the snapshot files. It defaults to the "snapshots" directory under PERS/file_path.
+ */
+#define CASCADE_PERSISTENT_SNAPSHOT_PATH        "CASCADE/persistent_snapshot_path"
+
 namespace derecho {
 namespace cascade {
 
+/**
+ * The context to recover a DeltaCascadeStoreCore from a snapshot file, passed to the constructor of its Persistent<T>
+ * wrapper, which rebuilds the state from the log on restart.
+ */
+class SnapshotRecovery : public mutils::RemoteDeserializationContext {
+public:
+    /** The snapshot file, or an empty string if snapshots are disabled. */
+    const std::string snapshot_file;
+    /** When the recovery starts. */
+    const std::chrono::steady_clock::time_point start;
+
+    explicit SnapshotRecovery(const std::string& _snapshot_file)
+            : snapshot_file(_snapshot_file), start(std::chrono::steady_clock::now()) {}
+};
+
 /**
  * Persistent Cascade Store Delta Support
  */
@@ -21,29 +103,338 @@ template <typename KT, typename VT, KT* IK, VT* IV>
 class DeltaCascadeStoreCore : public mutils::ByteRepresentable,
                               public persistent::IDeltaSupport<DeltaCascadeStoreCore<KT, VT, IK, IV>> {
 private:
-#if defined(__i386__) || defined(__x86_64__) || defined(_M_AMD64) || defined(_M_IX86)
-    mutable std::atomic<persistent::version_t> lockless_v1;
-    mutable std::atomic<persistent::version_t> lockless_v2;
-#else
-#error The lockless reader/writer works only with TSO memory reordering. Please check https://en.wikipedia.org/wiki/Memory_ordering
-#endif
+    /** The lockless hash and prefix index for readers other than the predicate thread, pointing into kv_map. */
+    ConcurrentKeyIndex<KT, VT> kv_index;
+    /** The versions of a key in ascending order. */
+    struct KeyVersions {
+        std::vector<persistent::version_t> versions;
+        /** The sizes of the versions, for the byte limit of log retention. */
+        std::vector<uint64_t> sizes;
+        /**
+         * false if the versions before versions.front() are unknown, e.g. when the state is transferred as kv_map or
+         * the log is replayed from a retention horizon.
+         */
+        bool complete;
+    };
+    /**
+     * The per-key version index, which costs 8 bytes per version of a key. It is built by applying the deltas, so
+     * replaying the log on restart rebuilds it. Pathname keys are interned as the id of their prefix and the rest of
+     * the key, so the index does not keep another copy of every key in kv_map.
+     */
+    InternedKeyMap<KT, KeyVersions> version_index;
+    mutable std::shared_mutex version_index_mutex;
+    /**
+     * Rebuild kv_index from kv_map, and seed version_index with the current version of each key, used after kv_map is
+     * constructed.
+     */
+    void rebuild_kv_index();
+    /**
+     * Append a version of a key to version_index.
+     *
+     * @param key       The key
+     * @param ver       The version
+     * @param size      The size of the version
+     * @param complete  If ver is known to be the first version of the key, used if the key is not indexed yet.
+     */
+    void index_version(const KT& key, persistent::version_t ver, uint64_t size, bool complete);
+    /**
+     * The state of a key in a checkpoint. The payload is not kept, so that a checkpoint does not hold the payloads
+     * superseded after it. It is read from kv_map or the log when the checkpoint is written to a snapshot file.
+     */
+    struct CheckpointEntry {
+        ObjectHead head;
+        /** The patch chain length of the key, 0 if its latest version is a full image. */
+        uint32_t patch_chain_length;
+        /** The relocation of the key, or a pair of INVALID_VERSION if it is not relocated. */
+        std::pair<persistent::version_t, persistent::version_t> relocation;
+    };
+    /** The checkpoints by the version they materialize. */
+    std::map<persistent::version_t, SharedTreeMap<stored_key_t<KT>, CheckpointEntry>> checkpoints;
+    /** The versions applied after the earliest checkpoint, in ascending order. */
+    std::vector<persistent::version_t> checkpointed_versions;
+    mutable std::shared_mutex checkpoint_mutex;
+    /** The last applied version, INVALID_VERSION if none has been applied since construction. */
+    persistent::version_t last_applied_version;
+    uint64_t versions_since_checkpoint;
+    uint64_t bytes_since_checkpoint;
+    uint64_t checkpoint_interval;
+    uint64_t checkpoint_bytes;
+    uint32_t max_checkpoints;
+    /**
+     * The current state of every key as checkpoint entries, updated with kv_map by the predicate thread. A checkpoint
+     * is a copy of it, which shares the nodes of the unchanged keys, so taking one is O(1).
+     */
+    SharedTreeMap<stored_key_t<KT>, CheckpointEntry> checkpoint_entries;
+    /** If checkpoint_entries is maintained, i.e. VT implements IKeepVersion and a checkpoint trigger is set. */
+    bool tracks_checkpoints;
+    /**
+     * Update the checkpoint entry of a key from kv_map, patch_chain_lengths, and relocations.
+     */
+    void track_checkpoint_entry(const KT& key);
+    /** The number of patches logged for a key since its last full image, for the keys whose latest version is a patch. */
+    std::unordered_map<KT, uint32_t> patch_chain_lengths;
+    uint32_t max_patch_chain;
+    /**
+     * The relocated objects, mapped to the version of the object and the version of the log entry it is relocated to,
+     * guarded by version_index_mutex.
+     */
+    std::unordered_map<KT, std::pair<persistent::version_t, persistent::version_t>> relocations;
+    uint32_t retention_batch;
+    /**
+     * The blob thresholds of the object pools, by pathname. They are logged in a delta when they change, and again
+     * before log retention trims the delta logging them, so that a replica replaying the log writes the payloads to
+     * blob segments as the others do.
+     */
+    std::map<std::string, uint64_t> blob_thresholds;
+    uint64_t default_blob_threshold;
+    /** The version of the latest delta logging blob_thresholds, or INVALID_VERSION if they are never logged. */
+    persistent::version_t blob_thresholds_version;
+    /** The magic number of snapshot files, "CSNAPSHT". */
+    static constexpr uint64_t SNAPSHOT_MAGIC = 0x54485350414e5343ull;
+    /** The version of the snapshot the state is loaded from, INVALID_VERSION if none. */
+    persistent::version_t snapshot_version;
+    /** The number of objects loaded from the snapshot. */
+    uint64_t snapshot_objects;
+    /** The numbers of the deltas replayed and skipped by applyDelta, which skips those in the snapshot. */
+    uint64_t replayed_deltas;
+    uint64_t skipped_deltas;
+    /**
+     * Test if the payload of an object goes to a blob segment, by the blob threshold of its object pool. It requires
+     * VT to implement IExternalPayload.
+     */
+    bool is_external(const VT& value) const;
+    /**
+     * If this core counts the blob segments of its log entries in BlobSegmentStore, which is false for a historical
+     * state replayed from the log.
+     */
+    bool tracks_segments;
+    /** The blob segments referred to by the log entries, by the version of the entry, guarded by segments_mutex. */
+    std::map<persistent::version_t, std::vector<BlobReference>> logged_segments;
+    /** The log entries before this version are trimmed, guarded by segments_mutex. */
+    persistent::version_t segments_trimmed_before;
+    /** An object replayed from the log while its blob segment is missing on this node. */
+    struct MissingSegment {
+        /** The version of the object */
+        persistent::version_t version;
+        /** The blob segment of the object, or of the object a patch of it applies to. */
+        BlobReference reference;
+        /** If the object is a patch applied to a missing payload, which is rebuilt by replaying the log again. */
+        bool patched;
+    };
+    /**
+     * The objects replayed without their blob segments by key, guarded by segments_mutex. They are kept to recognize
+     * the copies a lockless reader may still hold after the objects are replaced.
+     */
+    std::unordered_map<KT, MissingSegment> missing_segments;
+    std::atomic<bool> has_missing_segments;
+    /** The keys whose objects in kv_map are still missing their blob segments, only used by the predicate thread. */
+    std::unordered_set<KT> stub_keys;
+    /** Set when a missing blob segment is fetched, so that the predicate thread attaches it to kv_map. */
+    std::atomic<bool> fetched_segments;
+    mutable std::mutex segments_mutex;
+    /**
+     * Count a log entry referring to a blob segment, which is released when the entry is trimmed.
+     *
+     * @param ver           The version of the log entry, or INVALID_VERSION if it is unknown.
+     * @param reference     The reference to the segment
+     * @param payload       The payload to write the segment with, or nullptr if the entry is replayed.
+     */
+    void log_segment(persistent::version_t ver, const BlobReference& reference, const std::shared_ptr<const uint8_t>& payload);
+    /**
+     * Record an object installed by replaying the log without its blob segment.
+     */
+    void mark_missing_segment(const VT& stub, const BlobReference& reference, bool patched);
+    /**
+     * @return true if an object may be a copy of an object replayed without its blob segment.
+     */
+    bool may_miss_segment(const VT& value) const;
+    /**
+     * Attach the blob segment to a copy of an object replayed without it, if it is fetched since. It can be called from
+     * a thread other than the predicate thread.
+     *
+     * @param value     The copy of a stored object
+     *
+     * @throw std::runtime_error if the segment is still missing, so that an empty payload is never returned.
+     */
+    void attach_missing_segment(VT& value) const;
+    /**
+     * Replace the object of a key in kv_map and kv_index, keeping its version in version_index.
+     */
+    void replace_stored(const VT& value);
+    /**
+     * Attach the fetched blob segments to the objects in kv_map replayed without them. Called by the predicate thread.
+     */
+    void attach_fetched_segments();
+    /**
+     * Make sure the payload of the object of a key is in kv_map before it is used as the base of an update, fetching
+     * its blob segment with segment_fetcher if it is missing. Called by the predicate thread.
+     *
+     * @throw std::runtime_error if the segment can not be fetched.
+     */
+    void ensure_segment(const KT& key);
+    /**
+     * @return a copy of kv_map with the blob segments attached to the objects replayed without them, which is sent by
+     *         state transfer.
+     *
+     * @throw std::runtime_error if a segment is still missing.
+     */
+    key_value_map_t<KT, VT> attached_kv_map() const;
+    /**
+     * Account an object about to be applied. If it starts a new version and a trigger is reached, the current kv_map,
+     * which is the state at last_applied_version, is materialized as a checkpoint.
+     *
+     * @param value     The object about to be applied.
+     */
+    void checkpoint_if_needed(const VT& value);
+    /**
+     * Install an object to kv_map, kv_index, and version_index.
+     */
+    void install(const VT& value);
+    /**
+     * Drop the object of a key from kv_map, kv_index, and version_index.
+     */
+    void drop(const KT& key);
 
 public:
     /**
      * @class DeltaType
-     * @brief the delta type that are stored in a delta.
-     * 1) The first sizeof(std::vector<KT>::size_type) bytes is the number of VT objects in the
-     * delta, followed by specified number of 
-     * 2) Serialized VT objects.
+     * @brief a read-only view of a serialized delta.
+     * An indexed delta is laid out as follows:
+     * 1) The number of objects in the delta, OR'ed with INDEXED_DELTA_FLAG, as a std::size_t. It is also OR'ed with
+     *    SETTINGS_DELTA_FLAG if the delta logs the blob thresholds, which follow it as the version of the delta and a
+     *    serialized std::map<std::string, uint64_t>. Such a delta may have no objects;
+     * 2) The directory: the offsets of the entries from the beginning of the delta, ordered by key, each as a
+     *    std::size_t;
+     * 3) The entries, each a serialized key followed by the serialized VT object. The directory offset of a patch entry
+     *    is OR'ed with PATCH_ENTRY_FLAG, and the key of a patch entry is followed by a PatchHeader, then the VT object
+     *    whose payload is the patch. The directory offset of a relocated entry, which is an unchanged object logged
+     *    again by log retention, is OR'ed with RELOCATED_ENTRY_FLAG, and its key is followed by the version of the
+     *    log entry, then the VT object. The directory offset of an external entry, whose payload is in a blob segment,
+     *    is OR'ed with EXTERNAL_ENTRY_FLAG, and the other headers of the entry are followed by a BlobReference, then
+     *    the VT object with an empty payload.
+     * A lookup binary-searches the directory, deserializing only the keys it visits, and returns a view of the object
+     * in the delta, with the blob segment of an external entry attached as its payload. Deltas written before the directory was introduced are a std::size_t number of objects followed by
+     * the serialized VT objects, which are still readable with a linear scan.
      */
     class DeltaType : public mutils::ByteRepresentable {
     public:
-        /* The objects */
-        std::unordered_map<KT,VT> objects;
+        /** The header of a patch entry. */
+        struct PatchHeader {
+            /** The offset of the patch in the payload of the previous version of the key */
+            std::size_t offset;
+            /** The size of the patched payload */
+            std::size_t image_size;
+        };
+
+    private:
+        mutils::DeserializationManager* dsm;
+        /** The serialized delta. */
+        const uint8_t* buffer;
+        /** The copy of the serialized delta owned by a delta created by from_bytes(). */
+        std::unique_ptr<uint8_t[]> owned_buffer;
+        std::size_t num_objects;
+        bool indexed;
+        /** The offset of the directory, or of the first object of an unindexed delta, after the settings if any. */
+        std::size_t objects_offset;
+        /** The offset of the i-th entry in the directory. */
+        std::size_t entry_offset(std::size_t i) const;
+        /** The flags of the i-th entry in the directory. */
+        std::size_t entry_flags(std::size_t i) const;
+        /**
+         * Read the header of an indexed entry.
+         *
+         * @param pos           The offset of the entry, right after the key.
+         * @param flags         The flags of the entry.
+         * @param patch         Set to the patch header of a patch entry, and reset otherwise, if it is not nullptr.
+         * @param relocated_at  Set to the version a relocated entry is relocated at, and INVALID_VERSION otherwise, if
+         *                      it is not nullptr.
+         * @param external      Set to the blob reference of an external entry, if it is not nullptr.
+         *
+         * @return the offset of the VT object.
+         */
+        std::size_t read_entry_header(std::size_t pos, std::size_t flags, std::optional<PatchHeader>* patch,
+                                      persistent::version_t* relocated_at = nullptr,
+                                      BlobReference* external = nullptr) const;
+        /** The offset of the first object in an unindexed delta. */
+        std::size_t first_object_offset() const;
+        /** The number of bytes of a serialized delta. */
+        static std::size_t serialized_size(mutils::DeserializationManager* dsm, const uint8_t* const v);
+
+    public:
+        static constexpr std::size_t INDEXED_DELTA_FLAG = (1ull << 63);
+        static constexpr std::size_t SETTINGS_DELTA_FLAG = (1ull << 62);
+        static constexpr std::size_t PATCH_ENTRY_FLAG = (1ull << 63);
+        static constexpr std::size_t RELOCATED_ENTRY_FLAG = (1ull << 62);
+        static constexpr std::size_t EXTERNAL_ENTRY_FLAG = (1ull << 61);
+        static constexpr std::size_t ENTRY_FLAGS = (PATCH_ENTRY_FLAG | RELOCATED_ENTRY_FLAG | EXTERNAL_ENTRY_FLAG);
         /** @fn DeltaType
          *  @brief Constructor
+         *  @param _dsm     The deserialization manager
+         *  @param _buffer  The serialized delta, which must outlive this view.
+         */
+        DeltaType(mutils::DeserializationManager* _dsm, const uint8_t* const _buffer);
+        /**
+         * @return the number of objects in the delta.
          */
-        DeltaType();
+        std::size_t size() const;
+        /**
+         * @return the version of the delta, which is the version of its objects or the version they are relocated
+         *         at, or INVALID_VERSION if it is unknown.
+         */
+        persistent::version_t version() const;
+        /**
+         * Find the object of a key.
+         *
+         * @param key   The key
+         * @param patch Set to the patch header if the object is a patch, and reset otherwise, if it is not nullptr. The
+         *              payload of a patch is only the patched range, while its other members are those of the patched
+         *              object.
+         *
+         * @return a view of the object in the delta, or an empty pointer if the key is not in the delta. The view
+         *         shares the memory of the delta, so copy it to keep it beyond the lifetime of the delta. The payload of
+         *         an external entry is the mapped blob segment, which outlives the delta.
+         *
+         * @throw std::runtime_error if the blob segment of an external entry is missing on this node.
+         */
+        mutils::context_ptr<VT> find(const KT& key, std::optional<PatchHeader>* patch = nullptr) const;
+        /**
+         * Visit the keys in the delta without deserializing the objects of an indexed delta.
+         *
+         * @param visitor   The visitor
+         */
+        void for_each_key(const std::function<void(const KT&)>& visitor) const;
+        /**
+         * Visit the objects in the delta.
+         *
+         * @param visitor   The visitor, which takes an object, its patch header if the object is a patch, the version
+         *                  of the delta if the object is relocated or INVALID_VERSION otherwise, and the blob segment
+         *                  of an external entry if it is missing on this node, in which case the object has no payload,
+         *                  or nullptr otherwise.
+         */
+        void for_each(const std::function<void(const VT&, const std::optional<PatchHeader>&, persistent::version_t,
+                                               const BlobReference*)>& visitor) const;
+        /**
+         * Read the blob thresholds logged in the delta.
+         *
+         * @param ver           Set to the version of the delta.
+         * @param thresholds    Set to the blob thresholds.
+         *
+         * @return false if the delta does not log the blob thresholds.
+         */
+        bool blob_thresholds(persistent::version_t& ver, std::map<std::string, uint64_t>& thresholds) const;
+        /**
+         * Visit the blob segments of the external entries, without deserializing the objects.
+         *
+         * @param visitor   The visitor
+         */
+        void for_each_segment(const std::function<void(const BlobReference&)>& visitor) const;
+        /**
+         * Attach the blob segment of an external entry to its object as the payload.
+         *
+         * @return false if the segment is missing on this node.
+         */
+        static bool attach_external(VT& value, const BlobReference& external);
+
         virtual std::size_t to_bytes(uint8_t*) const override;
         virtual void post_object(const std::function<void(uint8_t const* const, std::size_t)>&) const override;
         virtual std::size_t bytes_size() const override;
@@ -58,14 +449,29 @@ public:
     };
     /** The delta is a list of keys for the objects that are changed by put or remove. */
     std::vector<KT> delta;
-    /** The KV map */
-    std::map<KT, VT> kv_map;
+    /** The keys in delta that are logged as patches, mapped to the offset and size of the patch. */
+    std::unordered_map<KT, std::pair<std::size_t, std::size_t>> delta_patches;
+    /** The keys in delta that are relocated, mapped to the version of the delta. */
+    std::unordered_map<KT, persistent::version_t> delta_relocations;
+    /** The keys in delta whose payloads are written to blob segments, mapped to the references. */
+    std::unordered_map<KT, BlobReference> delta_externals;
+    /** If the current delta logs blob_thresholds, at blob_thresholds_version. */
+    bool delta_blob_thresholds;
+    /** The keys in delta, sorted and deduplicated, in the order of the directory of the serialized delta. */
+    std::vector<KT> delta_keys() const;
+    /** The KV map, where pathname keys are interned as their prefixes and the rest of the keys. */
+    key_value_map_t<KT, VT> kv_map;
+    /**
+     * Fetch a missing blob segment from the other shard members and write it to BlobSegmentStore, set by the
+     * PersistentCascadeStore. It returns false if no shard member has the segment.
+     */
+    std::function<bool(const BlobReference&)> segment_fetcher;
 
     //////////////////////////////////////////////////////////////////////////
     // Delta is represented by a list of objects for both put and remove
     // operations, where the latter one is a list of objects with only key but
-    // is empty. Get operations will not create a delta. The first 4 bytes of
-    // the delta is the number of deltas.
+    // is empty. Get operations will not create a delta. Please refer to
+    // DeltaType for the layout of a serialized delta.
     ///////////////////////////////////////////////////////////////////////////
     virtual size_t currentDeltaSize() override;
     virtual size_t currentDeltaToBytes(uint8_t * const buf, size_t buf_size) override;
@@ -75,10 +481,62 @@ public:
      * apply put to current state
      */
     void apply_ordered_put(const VT& value);
+    /**
+     * apply a partial update to current state
+     *
+     * @param image     The patched object
+     */
+    void apply_ordered_patch(const VT& image);
+    /**
+     * apply a relocated object to current state
+     *
+     * @param value         The object
+     * @param relocated_at  The version of the log entry it is relocated to
+     */
+    void apply_relocated(const VT& value, persistent::version_t relocated_at);
     /**
      * Ordered put, and generate a delta.
      */
     virtual bool ordered_put(const VT& value, persistent::version_t prever, bool as_trigger);
+    /**
+     * Ordered put of a batch of objects with distinct keys, and generate one delta with all of them. The batch is
+     * verified as a whole before any object is applied.
+     *
+     * @param values    The objects. Their versions and timestamps should be set.
+     * @param prev_ver  The previous version.
+     * @param as_trigger    If true, the objects are verified but not applied.
+     *
+     * @return false if two objects have the same key, or any object is rejected by the validator or the previous
+     *         version check, in which case nothing is applied.
+     */
+    virtual bool ordered_put_batch(const std::vector<VT>& values, persistent::version_t prev_ver, bool as_trigger);
+    /**
+     * Ordered partial update, and generate a delta. The patch is applied to the current object of the key, or to an
+     * empty payload if there is none, and the delta logs only the patch unless CASCADE_PERSISTENT_MAX_PATCH_CHAIN says
+     * otherwise. It requires VT to implement IPatchPayload.
+     *
+     * @param patch     An object with the key and the patch as its payload. Its version and timestamp should be set.
+     * @param offset    The offset of the patch in the current payload, or IPatchPayload::APPEND_OFFSET to append.
+     * @param prev_ver  The previous version.
+     *
+     * @return false if the offset is beyond the end of the current payload, the patch is empty, or the update is
+     *         rejected by the validator or the previous version check.
+     */
+    virtual bool ordered_put_range(const VT& patch, uint64_t offset, persistent::version_t prev_ver);
+    /**
+     * Ordered merge, and generate a delta. The merge operator computes the new payload from the current object of
+     * the key, or from nothing if there is none, and the operand, and the result is put as a full object. It requires
+     * VT to implement IMergePayload.
+     *
+     * @param operand           An object with the key and the operand as its payload. Its version and timestamp
+     *                          should be set.
+     * @param merge_operator    The name of the merge operator in MergeOperatorRegistry.
+     * @param prev_ver          The previous version.
+     *
+     * @return false if the operator is unknown or rejects the operand, or the update is rejected by the validator or
+     *         the previous version check.
+     */
+    virtual bool ordered_merge(const VT& operand, const std::string& merge_operator, persistent::version_t prev_ver);
     /**
      * Ordered remove, and generate a delta.
      */
@@ -99,6 +557,17 @@ public:
      * locklessly list keys for the caller from a thread other than the predicate thread.
      */
     virtual std::vector<KT> lockless_list_keys(const std::string& prefix) const;
+    /**
+     * locklessly visit the objects of the keys with a prefix, for the caller from a thread other than the predicate
+     * thread. The visitor returns false to stop.
+     */
+    virtual void lockless_for_each_with_prefix(const std::string& prefix,
+                                               const std::function<bool(const KT&, const VT&)>& visitor) const;
+    /**
+     * locklessly visit the objects of the keys with a prefix after a key, like lockless_for_each_with_prefix.
+     */
+    virtual void lockless_for_each_with_prefix_after(const std::string& prefix, const KT& start_after,
+                                                     const std::function<bool(const KT&, const VT&)>& visitor) const;
     /**
      * ordered get_size, not need to generate a delta.
      */
@@ -107,9 +576,180 @@ public:
      * locklessly get size of an object
      */
     virtual uint64_t lockless_get_size(const KT& key) const;
+    /**
+     * locklessly get the metadata of an object, without copying its payload
+     */
+    virtual ObjectHead lockless_head(const KT& key) const;
+    /**
+     * Find the latest version of a key no later than `ver` with the per-key version index, in O(log(n)) for a key with
+     * n versions. It can be called from a thread other than the predicate thread.
+     *
+     * @param key   The key
+     * @param ver   The version
+     *
+     * @return the version, INVALID_VERSION if the key has no version no later than `ver`, or std::nullopt if the index
+     *         does not cover `ver` for the key.
+     */
+    std::optional<persistent::version_t> lockless_find_version(const KT& key, persistent::version_t ver) const;
+    /**
+     * Find the latest checkpoint no later than `ver`. A checkpoint holds the keys and object heads without payloads,
+     * and shares the entries of the keys unchanged since with the later checkpoints. It can be called from a thread
+     * other than the predicate thread.
+     *
+     * @param ver               The version
+     * @param later_versions    Filled with the versions applied after the checkpoint, no later than `ver`, in
+     *                          ascending order. Replaying their deltas over the checkpoint gives the state at `ver`.
+     *
+     * @return a pair of the checkpoint version and the checkpointed entries by key, or an INVALID_VERSION and empty
+     *         entries if there is no such checkpoint.
+     */
+    std::pair<persistent::version_t, SharedTreeMap<stored_key_t<KT>, CheckpointEntry>> lockless_find_checkpoint(
+            persistent::version_t ver, std::vector<persistent::version_t>& later_versions) const;
+    /**
+     * Find the log entry of a relocated object. It can be called from a thread other than the predicate thread.
+     *
+     * @param key   The key
+     * @param ver   The version of the object
+     *
+     * @return the version of the log entry the object is relocated to, or INVALID_VERSION if that version of the
+     *         object is not relocated.
+     */
+    persistent::version_t lockless_find_relocation(const KT& key, persistent::version_t ver) const;
+
+    /** The log retention policy of an object pool, resolved at the version of a retention round. */
+    struct PoolRetention {
+        /** The object pool pathname */
+        std::string pathname;
+        /** The policy */
+        LogRetentionPolicy policy;
+        /** The version of the state as of max_age_sec ago, or INVALID_VERSION if the age is unlimited or unknown. */
+        persistent::version_t age_cutoff;
+    };
+    /**
+     * Find the retention horizon, i.e. the oldest version the log must keep for the versions retained by the object
+     * pools. A key that belongs to no pool in `pools` keeps all its versions. The current version of a key does not
+     * hold the horizon, because it is relocated if it is older than the horizon. Called by the predicate thread.
+     *
+     * @param pools             The retention policies of the object pools.
+     * @param earliest_version  The earliest version in the log, which is the horizon if nothing can be trimmed.
+     * @param latest_version    The version of the retention round.
+     *
+     * @return the horizon.
+     */
+    persistent::version_t find_retention_horizon(const std::vector<PoolRetention>& pools,
+                                                 persistent::version_t earliest_version,
+                                                 persistent::version_t latest_version) const;
+    /**
+     * Relocate the current objects logged before a horizon, oldest first and up to CASCADE_PERSISTENT_RETENTION_BATCH
+     * objects, and generate a delta. The removed objects before the horizon are dropped instead. An object whose blob
+     * segment is still missing is relocated by its reference, so the delta does not depend on the fetched segments. The
+     * blob thresholds are logged again if their delta is before the horizon. Called by the predicate thread.
+     *
+     * @param horizon   The retention horizon
+     * @param ver       The version of the retention round.
+     *
+     * @return the horizon the log can be trimmed to after the delta is persisted, which is lower than `horizon` if
+     *         some objects are left for the next round.
+     */
+    persistent::version_t relocate_before(persistent::version_t horizon, persistent::version_t ver);
+    /**
+     * Drop the index, relocations and checkpoints of the versions before a retention horizon. It is called by the
+     * predicate thread in the retention round after the one choosing the horizon, so every replica relocates the
+     * objects from the same index, whenever it truncates its log.
+     *
+     * @param horizon   The retention horizon, the earliest readable version.
+     */
+    void prune_before(persistent::version_t horizon);
+    /**
+     * Release the blob segments of the log entries before a horizon, once they are truncated from the log. It can be
+     * called from a thread other than the predicate thread.
+     *
+     * @param horizon   The new earliest version in the log.
+     */
+    void release_segments_before(persistent::version_t horizon);
+    /**
+     * Count the blob segments of a log entry found by scanning the log, unless the entry is replayed or generated by
+     * this core, e.g. a log entry received by state transfer. It can be called from a thread other than the predicate
+     * thread.
+     *
+     * @param ver           The version of the log entry
+     * @param references    The blob segments of the entry
+     */
+    void lockless_track_segments(persistent::version_t ver, const std::vector<BlobReference>& references);
+    /**
+     * @return the blob segments of the objects replayed without them, which are to be fetched. It can be called from a
+     *         thread other than the predicate thread.
+     */
+    std::vector<BlobReference> lockless_missing_segments() const;
+    /**
+     * Tell the predicate thread to attach the blob segments fetched since the log was replayed. It can be called from
+     * a thread other than the predicate thread.
+     */
+    void notify_fetched_segments();
+    /**
+     * Set the blob thresholds of object pools, which apply to the deltas generated afterwards, and log them in the
+     * delta of the version if they change. Called by the predicate thread.
+     *
+     * @param thresholds    The thresholds in bytes by object pool pathname, or 0 to follow
+     *                      CASCADE_PERSISTENT_BLOB_THRESHOLD.
+     * @param ver           The version of the update.
+     */
+    void set_blob_thresholds(const std::map<std::string, uint64_t>& thresholds, persistent::version_t ver);
+    /**
+     * Write the latest checkpoint no later than a version to a snapshot file, which is replaced atomically. It can be
+     * called from a thread other than the predicate thread.
+     *
+     * A snapshot is laid out for mmap: five uint64_t of the magic, the version, and the numbers of objects, patch
+     * chains, and relocations, followed by the records of each. A record is its size as a std::size_t, followed by
+     * the serialized object, or the serialized key and its patch chain length or relocation, padded to 8 bytes.
+     *
+     * @param file              The snapshot file
+     * @param ver               The latest version to write, e.g. the global persistence frontier, so that a
+     *                          snapshot never has a version that can be truncated from the log.
+     * @param last_snapshot     The version of the current snapshot file, which is not written again.
+     * @param read_object       Read a version of an object from the log, used for the objects superseded in kv_map
+     *                          since the checkpoint. It returns an object of another version, e.g. an expired
+     *                          object, if the version is trimmed.
+     *
+     * @return the version of the snapshot file, which is last_snapshot if no later checkpoint is found.
+     *
+     * @throw std::runtime_error if the snapshot can not be written.
+     */
+    persistent::version_t lockless_write_snapshot(const std::string& file, persistent::version_t ver,
+                                                  persistent::version_t last_snapshot,
+                                                  const std::function<VT(const KT&, persistent::version_t)>& read_object) const;
+    /**
+     * Load the state from a snapshot file, called on recovery before any delta is applied. The payloads of the
+     * objects stay in the mapped file if VT implements IExternalPayload.
+     *
+     * @param file  The snapshot file
+     *
+     * @return true if the snapshot is loaded, or false if it is missing or invalid.
+     */
+    bool load_snapshot(const std::string& file);
+    /**
+     * @return the statistics of the recovery: "snapshot_version", "snapshot_objects", "replayed_deltas", and
+     *         "skipped_deltas".
+     */
+    std::map<std::string, uint64_t> get_recovery_stats() const;
+    /**
+     * Measure the keys of kv_map, which the checkpoints share, and of the version index. It can be called from a
+     * thread other than the predicate thread.
+     *
+     * @return the memory used by the keys: "keys", the number of keys, "prefixes", the number of interned prefixes
+     *         used by kv_map, "key_bytes", the bytes the keys would take as full keys in kv_map, "stored_key_bytes",
+     *         the bytes they take in kv_map including their prefixes, and "index_key_bytes", the bytes they take in
+     *         the version index.
+     */
+    std::map<std::string, uint64_t> get_key_memory_stats() const;
 
-    // serialization supports
-    DEFAULT_SERIALIZATION_SUPPORT(DeltaCascadeStoreCore, kv_map);
+    // serialization supports, which send kv_map with the payloads of the objects replayed without their blob segments.
+    virtual std::size_t to_bytes(uint8_t* buf) const override;
+    virtual void post_object(const std::function<void(uint8_t const* const, std::size_t)>& f) const override;
+    virtual std::size_t bytes_size() const override;
+    static std::unique_ptr<DeltaCascadeStoreCore> from_bytes(mutils::DeserializationManager* dsm, uint8_t const* buf);
+    DEFAULT_DESERIALIZE_NOALLOC(DeltaCascadeStoreCore);
+    void ensure_registered(mutils::DeserializationManager&) {}
 
     // constructors
     DeltaCascadeStoreCore();
@@ -13,9 +13,22 @@
 #include <derecho/utils/time.h>
 #endif
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <type_traits>
 #include <vector>
 
@@ -23,7 +36,261 @@ namespace derecho {
 namespace cascade {
 
 template <typename KT, typename VT, KT* IK, VT* IV>
-DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::DeltaType() {}
+DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::DeltaType(mutils::DeserializationManager* _dsm, const uint8_t* const _buffer)
+        : dsm(_dsm), buffer(_buffer) {
+    std::size_t header = *mutils::from_bytes_noalloc<std::size_t>(dsm, buffer);
+    indexed = ((header & INDEXED_DELTA_FLAG) != 0);
+    num_objects = (header & ~(INDEXED_DELTA_FLAG | SETTINGS_DELTA_FLAG));
+    objects_offset = mutils::bytes_size(header);
+    if((header & SETTINGS_DELTA_FLAG) != 0) {
+        objects_offset += sizeof(persistent::version_t);
+        objects_offset += mutils::deserialize_and_run(dsm, buffer + objects_offset, [](const std::map<std::string, uint64_t>& thresholds) {
+            return mutils::bytes_size(thresholds);
+        });
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::entry_offset(std::size_t i) const {
+    std::size_t offset;
+    // the directory is not necessarily aligned.
+    memcpy(&offset, buffer + objects_offset + sizeof(std::size_t) * i, sizeof(std::size_t));
+    return (offset & ~ENTRY_FLAGS);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::entry_flags(std::size_t i) const {
+    std::size_t offset;
+    memcpy(&offset, buffer + objects_offset + sizeof(std::size_t) * i, sizeof(std::size_t));
+    return (offset & ENTRY_FLAGS);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::read_entry_header(
+        std::size_t pos, std::size_t flags, std::optional<PatchHeader>* patch, persistent::version_t* relocated_at,
+        BlobReference* external) const {
+    if((flags & PATCH_ENTRY_FLAG) != 0) {
+        if(patch != nullptr) {
+            PatchHeader header;
+            memcpy(&header.offset, buffer + pos, sizeof(std::size_t));
+            memcpy(&header.image_size, buffer + pos + sizeof(std::size_t), sizeof(std::size_t));
+            *patch = header;
+        }
+        pos += 2 * sizeof(std::size_t);
+    } else if(patch != nullptr) {
+        patch->reset();
+    }
+    if((flags & RELOCATED_ENTRY_FLAG) != 0) {
+        if(relocated_at != nullptr) {
+            memcpy(relocated_at, buffer + pos, sizeof(persistent::version_t));
+        }
+        pos += sizeof(persistent::version_t);
+    } else if(relocated_at != nullptr) {
+        *relocated_at = persistent::INVALID_VERSION;
+    }
+    if((flags & EXTERNAL_ENTRY_FLAG) != 0) {
+        if(external != nullptr) {
+            memcpy(external, buffer + pos, sizeof(BlobReference));
+        }
+        pos += sizeof(BlobReference);
+    }
+    return pos;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::attach_external(VT& value, const BlobReference& external) {
+    if constexpr(std::is_base_of<IExternalPayload, VT>::value) {
+        try {
+            value.attach_payload(BlobSegmentStore::get().map(external), external.size);
+        } catch(const std::runtime_error& ex) {
+            // the segment is fetched from the other shard members, see PersistentCascadeStore.
+            dbg_default_warn("Blob segment {} of key {} is missing on this node: {}", external.to_string(), value.get_key_ref(), ex.what());
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::first_object_offset() const {
+    return objects_offset;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::serialized_size(
+        mutils::DeserializationManager* dsm, const uint8_t* const v) {
+    DeltaType delta(dsm, v);
+    if(delta.num_objects == 0) {
+        return delta.first_object_offset();
+    }
+    std::size_t pos;
+    std::size_t num_objects_to_skip;
+    if(delta.indexed) {
+        // the entries are written in the directory order, so the last one ends the delta.
+        pos = delta.entry_offset(delta.num_objects - 1);
+        pos += mutils::deserialize_and_run(dsm, v + pos, [](const KT& key) { return mutils::bytes_size(key); });
+        pos = delta.read_entry_header(pos, delta.entry_flags(delta.num_objects - 1), nullptr);
+        num_objects_to_skip = 1;
+    } else {
+        pos = delta.first_object_offset();
+        num_objects_to_skip = delta.num_objects;
+    }
+    while(num_objects_to_skip--) {
+        pos += mutils::deserialize_and_run(dsm, v + pos, [](const VT& value) { return mutils::bytes_size(value); });
+    }
+    return pos;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::size() const {
+    return num_objects;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+persistent::version_t DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::version() const {
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        if(num_objects == 0) {
+            return persistent::INVALID_VERSION;
+        }
+        std::size_t pos = first_object_offset();
+        if(indexed) {
+            // a delta of relocated objects has the version they are relocated at.
+            persistent::version_t relocated_at;
+            pos = entry_offset(0);
+            pos += mutils::deserialize_and_run(dsm, buffer + pos, [](const KT& key) { return mutils::bytes_size(key); });
+            pos = read_entry_header(pos, entry_flags(0), nullptr, &relocated_at);
+            if(relocated_at != persistent::INVALID_VERSION) {
+                return relocated_at;
+            }
+        }
+        return mutils::deserialize_and_run(dsm, buffer + pos, [](const VT& value) { return value.get_version(); });
+    } else {
+        return persistent::INVALID_VERSION;
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+mutils::context_ptr<VT> DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::find(const KT& key, std::optional<PatchHeader>* patch) const {
+    if(indexed) {
+        std::size_t low = 0;
+        std::size_t high = num_objects;
+        while(low < high) {
+            std::size_t mid = low + (high - low) / 2;
+            std::size_t pos = entry_offset(mid);
+            std::size_t key_size = 0;
+            int cmp = mutils::deserialize_and_run(dsm, buffer + pos, [&key, &key_size](const KT& entry_key) {
+                key_size = mutils::bytes_size(entry_key);
+                return (entry_key < key) ? -1 : ((key < entry_key) ? 1 : 0);
+            });
+            if(cmp < 0) {
+                low = mid + 1;
+            } else if(cmp > 0) {
+                high = mid;
+            } else {
+                BlobReference external;
+                pos = read_entry_header(pos + key_size, entry_flags(mid), patch, nullptr, &external);
+                auto po = mutils::from_bytes_noalloc<VT>(dsm, const_cast<uint8_t* const>(buffer) + pos);
+                if((entry_flags(mid) & EXTERNAL_ENTRY_FLAG) != 0 && !attach_external(*po, external)) {
+                    throw std::runtime_error("Blob segment " + external.to_string() + " is missing on this node.");
+                }
+                return po;
+            }
+        }
+    } else {
+        std::size_t pos = first_object_offset();
+        for(std::size_t i = 0; i < num_objects; i++) {
+            auto po = mutils::from_bytes_noalloc<VT>(dsm, const_cast<uint8_t* const>(buffer) + pos);
+            if(po->get_key_ref() == key) {
+                if(patch != nullptr) {
+                    patch->reset();
+                }
+                return po;
+            }
+            pos += mutils::bytes_size(*po);
+        }
+    }
+    return mutils::context_ptr<VT>{};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::for_each_key(const std::function<void(const KT&)>& visitor) const {
+    if(indexed) {
+        for(std::size_t i = 0; i < num_objects; i++) {
+            mutils::deserialize_and_run(dsm, buffer + entry_offset(i), [&visitor](const KT& key) {
+                visitor(key);
+                return true;
+            });
+        }
+    } else {
+        for_each([&visitor](const VT& value, const std::optional<PatchHeader>&, persistent::version_t, const BlobReference*) {
+            visitor(value.get_key_ref());
+        });
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::for_each(
+        const std::function<void(const VT&, const std::optional<PatchHeader>&, persistent::version_t, const BlobReference*)>& visitor) const {
+    std::size_t pos = first_object_offset();
+    std::optional<PatchHeader> patch;
+    persistent::version_t relocated_at = persistent::INVALID_VERSION;
+    BlobReference external;
+    bool is_external = false;
+    for(std::size_t i = 0; i < num_objects; i++) {
+        if(indexed) {
+            pos = entry_offset(i);
+            pos += mutils::deserialize_and_run(dsm, buffer + pos, [](const KT& key) { return mutils::bytes_size(key); });
+            pos = read_entry_header(pos, entry_flags(i), &patch, &relocated_at, &external);
+            is_external = ((entry_flags(i) & EXTERNAL_ENTRY_FLAG) != 0);
+        }
+        pos += mutils::deserialize_and_run(dsm, buffer + pos, [&visitor, &patch, &relocated_at, &external, is_external](const VT& value) {
+            if(is_external) {
+                // the object in the delta has no payload, so the copy is cheap.
+                VT attached(value);
+                bool is_attached = attach_external(attached, external);
+                visitor(attached, patch, relocated_at, is_attached ? nullptr : &external);
+            } else {
+                visitor(value, patch, relocated_at, nullptr);
+            }
+            return mutils::bytes_size(value);
+        });
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::blob_thresholds(persistent::version_t& ver,
+                                                                      std::map<std::string, uint64_t>& thresholds) const {
+    std::size_t header = *mutils::from_bytes_noalloc<std::size_t>(dsm, buffer);
+    if((header & SETTINGS_DELTA_FLAG) == 0) {
+        return false;
+    }
+    std::size_t pos = mutils::bytes_size(header);
+    memcpy(&ver, buffer + pos, sizeof(persistent::version_t));
+    pos += sizeof(persistent::version_t);
+    mutils::deserialize_and_run(dsm, buffer + pos, [&thresholds](const std::map<std::string, uint64_t>& logged) {
+        thresholds = logged;
+        return true;
+    });
+    return true;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::for_each_segment(const std::function<void(const BlobReference&)>& visitor) const {
+    // only an indexed delta has external entries.
+    if(!indexed) {
+        return;
+    }
+    for(std::size_t i = 0; i < num_objects; i++) {
+        if((entry_flags(i) & EXTERNAL_ENTRY_FLAG) == 0) {
+            continue;
+        }
+        std::size_t pos = entry_offset(i);
+        pos += mutils::deserialize_and_run(dsm, buffer + pos, [](const KT& key) { return mutils::bytes_size(key); });
+        BlobReference external;
+        read_entry_header(pos, entry_flags(i), nullptr, nullptr, &external);
+        visitor(external);
+    }
+}
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 std::size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::to_bytes(uint8_t*) const {
@@ -50,16 +317,11 @@ template <typename KT, typename VT, KT* IK, VT* IV>
 std::unique_ptr<typename DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType>
 DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::from_bytes(
     mutils::DeserializationManager* dsm,const uint8_t* const v) {
-    size_t pos = 0;
-    std::size_t num_objects = *mutils::from_bytes_noalloc<std::size_t>(dsm,v + pos);
-    pos += mutils::bytes_size(num_objects);
-    auto pdelta = std::make_unique<DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>();
-    while (num_objects--) {
-        auto po = mutils::from_bytes<VT>(dsm,v + pos);
-        pos += mutils::bytes_size(*po);
-        KT key = po->get_key_ref();
-        pdelta->objects.emplace(std::move(key),std::move(*po));
-    }
+    std::size_t size = serialized_size(dsm, v);
+    std::unique_ptr<uint8_t[]> owned_buffer(new uint8_t[size]);
+    memcpy(owned_buffer.get(), v, size);
+    auto pdelta = std::make_unique<DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(dsm, owned_buffer.get());
+    pdelta->owned_buffer = std::move(owned_buffer);
     return pdelta;
 }
 
@@ -67,43 +329,71 @@ template <typename KT, typename VT, KT* IK, VT* IV>
 mutils::context_ptr<typename DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType>
 DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::from_bytes_noalloc(
     mutils::DeserializationManager* dsm,const uint8_t* const v) {
-    size_t pos = 0;
-    std::size_t num_objects = *mutils::from_bytes_noalloc<std::size_t>(dsm,v + pos);
-    pos += mutils::bytes_size(num_objects);
-    auto* pdelta = new DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType();
-    while (num_objects--) {
-        auto po = mutils::from_bytes_noalloc<VT>(dsm,const_cast<uint8_t* const>(v) + pos);
-        pos += mutils::bytes_size(*po);
-        KT key = po->get_key_ref();
-        pdelta->objects.emplace(std::move(key),std::move(*po));
-    }
-    return mutils::context_ptr<DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(pdelta);
+    return mutils::context_ptr<DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(
+            new DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType(dsm, v));
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 mutils::context_ptr<const typename DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType>
 DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::from_bytes_noalloc_const(
     mutils::DeserializationManager* dsm,const uint8_t* const v) {
-    size_t pos = 0;
-    std::size_t num_objects = *mutils::from_bytes_noalloc<std::size_t>(dsm,v + pos);
-    pos += mutils::bytes_size(num_objects);
-    auto* pdelta = new DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType();
-    while (num_objects--) {
-        auto po = mutils::from_bytes_noalloc<VT>(dsm,const_cast<uint8_t* const>(v) + pos);
-        pos += mutils::bytes_size(*po);
-        KT key = po->get_key_ref();
-        pdelta->objects.emplace(std::move(key),std::move(*po));
-    }
-    return mutils::context_ptr<const DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(pdelta);
+    return mutils::context_ptr<const DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(
+            new DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType(dsm, v));
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<KT> DeltaCascadeStoreCore<KT, VT, IK, IV>::delta_keys() const {
+    std::vector<KT> keys(delta);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::currentDeltaSize() {
     size_t delta_size = 0;
-    if (delta.size() > 0) {
-        delta_size += mutils::bytes_size(static_cast<std::size_t>(delta.size()));
-        for (const auto& k:delta) {
-            delta_size+=mutils::bytes_size(this->kv_map[k]);
+    if (delta.size() > 0 || delta_blob_thresholds) {
+        auto keys = delta_keys();
+        delta_size += mutils::bytes_size(static_cast<std::size_t>(keys.size()));
+        if (delta_blob_thresholds) {
+            delta_size += sizeof(persistent::version_t) + mutils::bytes_size(this->blob_thresholds);
+        }
+        delta_size += sizeof(std::size_t) * keys.size();
+        for (const auto& k:keys) {
+            delta_size+=mutils::bytes_size(k);
+            if constexpr(std::is_base_of<IPatchPayload, VT>::value) {
+                auto patch = this->delta_patches.find(k);
+                if (patch != this->delta_patches.cend()) {
+                    VT patch_object(key_value_map_at(this->kv_map, k));
+                    patch_object.trim_payload(patch->second.first, patch->second.second);
+                    delta_size+=2 * sizeof(std::size_t);
+                    delta_size+=mutils::bytes_size(patch_object);
+                    continue;
+                }
+            }
+            if (this->delta_relocations.find(k) != this->delta_relocations.cend()) {
+                delta_size+=sizeof(persistent::version_t);
+            }
+            if constexpr(std::is_base_of<IExternalPayload, VT>::value) {
+                const VT& value = key_value_map_at(this->kv_map, k);
+                auto external = this->delta_externals.find(k);
+                if (external == this->delta_externals.cend() && this->is_external(value)) {
+                    // only the reference is computed here. The segment is written in the background when the delta is.
+                    try {
+                        external = this->delta_externals.emplace(k,
+                                BlobSegmentStore::reference_of(value.get_payload_bytes(), value.get_payload_size())).first;
+                    } catch(const std::runtime_error& ex) {
+                        dbg_default_warn("Failed to digest the payload of key {}, logging it inline: {}", k, ex.what());
+                    }
+                }
+                if (external != this->delta_externals.cend()) {
+                    // an external entry logs the object without the payload, which is serialized after its size.
+                    delta_size+=sizeof(BlobReference);
+                    delta_size+=mutils::bytes_size(value) - value.get_payload_size();
+                    continue;
+                }
+            }
+            delta_size+=mutils::bytes_size(key_value_map_at(this->kv_map, k));
         }
     }
     return delta_size;
@@ -117,72 +407,871 @@ size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::currentDeltaToBytes(uint8_t * cons
         dbg_default_error("{}: failed because we need {} bytes for delta, but only a buffer with {} bytes given.\n",
             __PRETTY_FUNCTION__, delta_size, buf_size);
     }
-    size_t offset = mutils::to_bytes(static_cast<std::size_t>(delta.size()),buf);
-    for(const auto& k:delta) {
-        offset += mutils::to_bytes(this->kv_map[k],buf+offset);
+    auto keys = delta_keys();
+    // the objects in a delta share its version, or the version they are relocated at.
+    persistent::version_t delta_version = persistent::INVALID_VERSION;
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        if (!keys.empty()) {
+            auto relocation = this->delta_relocations.find(keys.front());
+            delta_version = (relocation != this->delta_relocations.cend()) ? relocation->second : key_value_map_at(this->kv_map, keys.front()).get_version();
+        }
+    }
+    std::size_t header = static_cast<std::size_t>(keys.size()) | DeltaType::INDEXED_DELTA_FLAG;
+    if (delta_blob_thresholds) {
+        header |= DeltaType::SETTINGS_DELTA_FLAG;
+    }
+    size_t offset = mutils::to_bytes(header,buf);
+    if (delta_blob_thresholds) {
+        memcpy(buf + offset, &this->blob_thresholds_version, sizeof(persistent::version_t));
+        offset += sizeof(persistent::version_t);
+        offset += mutils::to_bytes(this->blob_thresholds,buf+offset);
+    }
+    size_t directory_offset = offset;
+    offset += sizeof(std::size_t) * keys.size();
+    for(const auto& k:keys) {
+        std::size_t entry_offset = offset;
+        offset += mutils::to_bytes(k,buf+offset);
+        if constexpr(std::is_base_of<IPatchPayload, VT>::value) {
+            auto patch = this->delta_patches.find(k);
+            if (patch != this->delta_patches.cend()) {
+                VT patch_object(key_value_map_at(this->kv_map, k));
+                typename DeltaType::PatchHeader header{patch->second.first, patch_object.get_payload_size()};
+                patch_object.trim_payload(patch->second.first, patch->second.second);
+                memcpy(buf + offset, &header.offset, sizeof(std::size_t));
+                memcpy(buf + offset + sizeof(std::size_t), &header.image_size, sizeof(std::size_t));
+                offset += 2 * sizeof(std::size_t);
+                offset += mutils::to_bytes(patch_object,buf+offset);
+                entry_offset |= DeltaType::PATCH_ENTRY_FLAG;
+                memcpy(buf + directory_offset, &entry_offset, sizeof(std::size_t));
+                directory_offset += sizeof(std::size_t);
+                continue;
+            }
+        }
+        auto relocation = this->delta_relocations.find(k);
+        if (relocation != this->delta_relocations.cend()) {
+            memcpy(buf + offset, &relocation->second, sizeof(persistent::version_t));
+            offset += sizeof(persistent::version_t);
+            entry_offset |= DeltaType::RELOCATED_ENTRY_FLAG;
+        }
+        if constexpr(std::is_base_of<IExternalPayload, VT>::value) {
+            auto external = this->delta_externals.find(k);
+            if (external != this->delta_externals.cend()) {
+                memcpy(buf + offset, &external->second, sizeof(BlobReference));
+                offset += sizeof(BlobReference);
+                VT stub(key_value_map_at(this->kv_map, k));
+                stub.attach_payload(nullptr, 0);
+                offset += mutils::to_bytes(stub,buf+offset);
+                // the copy pins the payload until the segment is written.
+                auto pinned = std::make_shared<VT>(key_value_map_at(this->kv_map, k));
+                this->log_segment(delta_version, external->second,
+                                  std::shared_ptr<const uint8_t>(pinned, pinned->get_payload_bytes()));
+                entry_offset |= DeltaType::EXTERNAL_ENTRY_FLAG;
+                memcpy(buf + directory_offset, &entry_offset, sizeof(std::size_t));
+                directory_offset += sizeof(std::size_t);
+                continue;
+            }
+        }
+        offset += mutils::to_bytes(key_value_map_at(this->kv_map, k),buf+offset);
+        memcpy(buf + directory_offset, &entry_offset, sizeof(std::size_t));
+        directory_offset += sizeof(std::size_t);
     }
     delta.clear();
+    delta_patches.clear();
+    delta_relocations.clear();
+    delta_externals.clear();
+    delta_blob_thresholds = false;
     return offset;
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 void DeltaCascadeStoreCore<KT, VT, IK, IV>::applyDelta(uint8_t const* const serialized_delta) {
-    std::size_t num_objects = *mutils::from_bytes<std::size_t>(nullptr,serialized_delta);
-    size_t offset = mutils::bytes_size(num_objects);
-    while (num_objects--) {
-        offset +=
-            mutils::deserialize_and_run(nullptr, serialized_delta + offset,
-                [this](const VT& value) {
-                    this->apply_ordered_put(value);
-                    return mutils::bytes_size(value);
-                }
-            );
+    DeltaType delta(nullptr, serialized_delta);
+    persistent::version_t ver = delta.version();
+    // the blob thresholds are not in a snapshot, so they are taken from every delta logging them.
+    std::map<std::string, uint64_t> thresholds;
+    persistent::version_t thresholds_version;
+    if(delta.blob_thresholds(thresholds_version, thresholds)) {
+        this->blob_thresholds = std::move(thresholds);
+        this->blob_thresholds_version = thresholds_version;
+    }
+    if(this->tracks_segments) {
+        // the log entry keeps its blob segments until it is trimmed, even if it is in the snapshot.
+        delta.for_each_segment([this, ver](const BlobReference& reference) { this->log_segment(ver, reference, nullptr); });
     }
+    if(this->snapshot_version != persistent::INVALID_VERSION) {
+        // the state is loaded from a snapshot, which has the deltas up to its version.
+        if(ver != persistent::INVALID_VERSION && ver <= this->snapshot_version) {
+            this->skipped_deltas++;
+            return;
+        }
+    }
+    this->replayed_deltas++;
+    delta.for_each(
+        [this](const VT& value, const std::optional<typename DeltaType::PatchHeader>& patch, persistent::version_t relocated_at,
+               const BlobReference* missing) {
+            if(relocated_at != persistent::INVALID_VERSION) {
+                this->apply_relocated(value, relocated_at);
+            } else if constexpr(std::is_base_of<IPatchPayload, VT>::value) {
+                if(patch.has_value()) {
+                    // deltas are applied in order, so kv_map holds the version the patch applies to.
+                    const uint8_t* base = nullptr;
+                    std::size_t base_size = 0;
+                    std::optional<BlobReference> missing_base;
+                    auto it = this->kv_map.find(value.get_key_ref());
+                    if(it != this->kv_map.end()) {
+                        base = it->second.get_payload_bytes();
+                        base_size = it->second.get_payload_size();
+                        if(this->stub_keys.find(value.get_key_ref()) != this->stub_keys.end()) {
+                            std::lock_guard<std::mutex> lck(this->segments_mutex);
+                            missing_base = this->missing_segments.at(value.get_key_ref()).reference;
+                        }
+                    }
+                    VT image(value);
+                    image.patch_payload(base, base_size, patch->offset);
+                    this->apply_ordered_patch(image);
+                    if(missing_base.has_value()) {
+                        this->mark_missing_segment(image, *missing_base, true);
+                    }
+                    return;
+                }
+                this->apply_ordered_put(value);
+            } else {
+                this->apply_ordered_put(value);
+            }
+            if(missing != nullptr) {
+                this->mark_missing_segment(value, *missing, false);
+            }
+        });
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 void DeltaCascadeStoreCore<KT, VT, IK, IV>::apply_ordered_put(const VT& value) {
-    // for lockless check
-    this->lockless_v1.store(value.get_version(), std::memory_order_relaxed);
-    // compiler reordering barrier
-#ifdef __GNUC__
-    asm volatile("" ::
-                         : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        this->checkpoint_if_needed(value);
+    }
+    this->install(value);
+}
 
-    this->kv_map.erase(value.get_key_ref());
-    this->kv_map.emplace(value.get_key_ref(), value);
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::apply_relocated(const VT& value, persistent::version_t relocated_at) {
+    {
+        std::unique_lock<std::shared_mutex> wlck(this->version_index_mutex);
+        this->relocations[value.get_key_ref()] = std::make_pair(value.get_version(), relocated_at);
+    }
+    // the object keeps its version, which is not the version of the delta, so it is not accounted for checkpoints.
+    this->install(value);
+}
 
-    // compiler reordering barrier
-#ifdef __GNUC__
-    asm volatile("" ::
-                         : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::install(const VT& value) {
+    auto old_node = key_value_map_extract(this->kv_map, value.get_key_ref());
+    // reuse the stored key of the old object, so that an update does not intern the key again.
+    auto it = old_node.empty() ? this->kv_map.emplace(value.get_key_ref(), value).first
+                               : this->kv_map.emplace(old_node.key(), value).first;
+    if constexpr(std::is_base_of<ISharePayload, VT>::value) {
+        it->second.share_payload();
+    }
+    this->kv_index.publish(*it);
+    if(!old_node.empty()) {
+        // lockless readers may still be copying the old object.
+        this->kv_index.retire(std::move(old_node));
+    }
+    this->kv_index.reclaim();
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        // a key first seen with a previous version is replayed from a retention horizon.
+        bool complete = true;
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            complete = (value.previous_version_by_key == persistent::INVALID_VERSION);
+        }
+        this->index_version(value.get_key_ref(), value.get_version(), mutils::bytes_size(value), complete);
+    }
+    if constexpr(std::is_base_of<IPatchPayload, VT>::value) {
+        // a full image ends the patch chain of the key.
+        this->patch_chain_lengths.erase(value.get_key_ref());
+        this->delta_patches.erase(value.get_key_ref());
+    }
+    this->stub_keys.erase(value.get_key_ref());
+    this->track_checkpoint_entry(value.get_key_ref());
+}
 
-    // for lockless check
-    this->lockless_v2.store(value.get_version(), std::memory_order_relaxed);
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::drop(const KT& key) {
+    this->kv_index.erase(key);
+    auto old_node = key_value_map_extract(this->kv_map, key);
+    if(!old_node.empty()) {
+        this->kv_index.retire(std::move(old_node));
+    }
+    this->kv_index.reclaim();
+    {
+        std::unique_lock<std::shared_mutex> wlck(this->version_index_mutex);
+        this->version_index.erase(key);
+        this->relocations.erase(key);
+    }
+    this->patch_chain_lengths.erase(key);
+    this->stub_keys.erase(key);
+    this->track_checkpoint_entry(key);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::apply_ordered_patch(const VT& image) {
+    uint32_t chain_length = 0;
+    auto chain = this->patch_chain_lengths.find(image.get_key_ref());
+    if(chain != this->patch_chain_lengths.end()) {
+        chain_length = chain->second;
+    }
+    this->apply_ordered_put(image);
+    this->patch_chain_lengths[image.get_key_ref()] = chain_length + 1;
+    this->track_checkpoint_entry(image.get_key_ref());
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::rebuild_kv_index() {
+    this->kv_index.clear();
+    this->checkpoint_entries.clear();
+    std::unique_lock<std::shared_mutex> wlck(this->version_index_mutex);
+    this->version_index.clear();
+    for(auto& kv : this->kv_map) {
+        this->track_checkpoint_entry(kv.first);
+        if constexpr(std::is_base_of<ISharePayload, VT>::value) {
+            kv.second.share_payload();
+        }
+        this->kv_index.publish(kv);
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            // only the current version is known.
+            this->version_index.try_emplace(kv.first, KeyVersions{{kv.second.get_version()}, {mutils::bytes_size(kv.second)}, false});
+        }
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::index_version(const KT& key, persistent::version_t ver, uint64_t size, bool complete) {
+    std::unique_lock<std::shared_mutex> wlck(this->version_index_mutex);
+    auto& key_versions = this->version_index.try_emplace(key, KeyVersions{{}, {}, complete}).first->second;
+    // versions are applied in order, so appending keeps the vector sorted.
+    if(key_versions.versions.empty() || key_versions.versions.back() < ver) {
+        key_versions.versions.push_back(ver);
+        key_versions.sizes.push_back(size);
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::optional<persistent::version_t> DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_find_version(const KT& key, persistent::version_t ver) const {
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        std::shared_lock<std::shared_mutex> rlck(this->version_index_mutex);
+        auto it = this->version_index.find(key);
+        if(it == this->version_index.cend()) {
+            return persistent::INVALID_VERSION;
+        }
+        const auto& versions = it->second.versions;
+        auto pos = std::upper_bound(versions.cbegin(), versions.cend(), ver);
+        if(pos == versions.cbegin()) {
+            if(it->second.complete) {
+                return persistent::INVALID_VERSION;
+            }
+            return std::nullopt;
+        }
+        return *(pos - 1);
+    } else {
+        return std::nullopt;
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::checkpoint_if_needed(const VT& value) {
+    const persistent::version_t ver = value.get_version();
+    if(ver != this->last_applied_version) {
+        if(!this->stub_keys.empty()) {
+            this->attach_fetched_segments();
+        }
+        // value starts a new version, so kv_map holds the complete state of last_applied_version. A checkpoint is
+        // not taken while an object in kv_map misses its blob segment.
+        if(this->tracks_checkpoints && this->last_applied_version != persistent::INVALID_VERSION && this->stub_keys.empty()
+           && ((this->checkpoint_interval > 0 && this->versions_since_checkpoint >= this->checkpoint_interval)
+               || (this->checkpoint_bytes > 0 && this->bytes_since_checkpoint >= this->checkpoint_bytes))) {
+            // the checkpoint shares its nodes with checkpoint_entries, so nothing is copied.
+            std::unique_lock<std::shared_mutex> wlck(this->checkpoint_mutex);
+            this->checkpoints.emplace(this->last_applied_version, this->checkpoint_entries);
+            if(this->checkpoints.size() > this->max_checkpoints) {
+                // drop every other checkpoint but the earliest, and space the following ones twice as far.
+                auto it = std::next(this->checkpoints.begin());
+                while(it != this->checkpoints.end()) {
+                    it = this->checkpoints.erase(it);
+                    if(it != this->checkpoints.end()) {
+                        it++;
+                    }
+                }
+                this->checkpoint_interval *= 2;
+                this->checkpoint_bytes *= 2;
+            }
+            this->versions_since_checkpoint = 0;
+            this->bytes_since_checkpoint = 0;
+        }
+        if(!this->checkpoints.empty()) {
+            std::unique_lock<std::shared_mutex> wlck(this->checkpoint_mutex);
+            this->checkpointed_versions.push_back(ver);
+        }
+        this->last_applied_version = ver;
+        this->versions_since_checkpoint++;
+    }
+    this->bytes_since_checkpoint += mutils::bytes_size(value);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::track_checkpoint_entry(const KT& key) {
+    if(!this->tracks_checkpoints) {
+        return;
+    }
+    auto it = this->kv_map.find(key);
+    if(it == this->kv_map.end()) {
+        this->checkpoint_entries.erase(key);
+        return;
+    }
+    CheckpointEntry entry{make_object_head(it->second), 0, {persistent::INVALID_VERSION, persistent::INVALID_VERSION}};
+    auto chain = this->patch_chain_lengths.find(key);
+    if(chain != this->patch_chain_lengths.end()) {
+        entry.patch_chain_length = chain->second;
+    }
+    // relocations are only written by this thread, so they are read without the lock.
+    auto relocation = this->relocations.find(key);
+    if(relocation != this->relocations.end()) {
+        entry.relocation = relocation->second;
+    }
+    // the entry shares the stored key with kv_map.
+    this->checkpoint_entries.insert_or_assign(it->first, entry);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::pair<persistent::version_t, SharedTreeMap<stored_key_t<KT>, typename DeltaCascadeStoreCore<KT, VT, IK, IV>::CheckpointEntry>>
+DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_find_checkpoint(
+        persistent::version_t ver, std::vector<persistent::version_t>& later_versions) const {
+    std::shared_lock<std::shared_mutex> rlck(this->checkpoint_mutex);
+    auto it = this->checkpoints.upper_bound(ver);
+    if(it == this->checkpoints.cbegin()) {
+        return {persistent::INVALID_VERSION, {}};
+    }
+    it--;
+    auto from = std::upper_bound(this->checkpointed_versions.cbegin(), this->checkpointed_versions.cend(), it->first);
+    auto to = std::upper_bound(from, this->checkpointed_versions.cend(), ver);
+    later_versions.assign(from, to);
+    return {it->first, it->second};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+persistent::version_t DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_find_relocation(const KT& key, persistent::version_t ver) const {
+    std::shared_lock<std::shared_mutex> rlck(this->version_index_mutex);
+    auto it = this->relocations.find(key);
+    if(it != this->relocations.cend() && it->second.first == ver) {
+        return it->second.second;
+    }
+    return persistent::INVALID_VERSION;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+persistent::version_t DeltaCascadeStoreCore<KT, VT, IK, IV>::find_retention_horizon(
+        const std::vector<PoolRetention>& pools,
+        persistent::version_t earliest_version,
+        persistent::version_t latest_version) const {
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value && std::is_convertible_v<KT, std::string>) {
+        // object pools do not nest, so a key belongs to at most one of them. The pool only depends on the interned
+        // prefix of the key, which ends with a separator, so it is looked up once per prefix.
+        std::unordered_map<uint32_t, std::size_t> pool_by_prefix;
+        auto find_pool = [this, &pools, &pool_by_prefix](const InternedKey& stored_key) {
+            auto cached = pool_by_prefix.find(stored_key.prefix_id);
+            if(cached != pool_by_prefix.end()) {
+                return cached->second;
+            }
+            const std::string& prefix = this->version_index.prefix_of(stored_key);
+            std::size_t pool_index = pools.size();
+            for(std::size_t i = 0; i < pools.size(); i++) {
+                if(prefix.size() > pools[i].pathname.size() && prefix[pools[i].pathname.size()] == PATH_SEPARATOR
+                   && prefix.compare(0, pools[i].pathname.size(), pools[i].pathname) == 0) {
+                    pool_index = i;
+                    break;
+                }
+            }
+            pool_by_prefix.emplace(stored_key.prefix_id, pool_index);
+            return pool_index;
+        };
+        // the oldest state a pool keeps readable for its age and byte limits.
+        std::vector<persistent::version_t> cutoffs;
+        std::vector<std::vector<std::pair<persistent::version_t, uint64_t>>> sized_versions(pools.size());
+        for(const auto& kv : this->version_index) {
+            std::size_t pool_index = find_pool(kv.first);
+            if(pool_index < pools.size() && pools[pool_index].policy.max_bytes > 0) {
+                for(std::size_t i = 0; i < kv.second.versions.size(); i++) {
+                    sized_versions[pool_index].emplace_back(kv.second.versions[i], kv.second.sizes[i]);
+                }
+            }
+        }
+        for(std::size_t pool_index = 0; pool_index < pools.size(); pool_index++) {
+            persistent::version_t cutoff = pools[pool_index].age_cutoff;
+            auto& pool_versions = sized_versions[pool_index];
+            std::sort(pool_versions.begin(), pool_versions.end(),
+                      [](const auto& l, const auto& r) { return l.first > r.first; });
+            uint64_t total_bytes = 0;
+            for(const auto& sized_version : pool_versions) {
+                total_bytes += sized_version.second;
+                if(total_bytes > pools[pool_index].policy.max_bytes) {
+                    // approximately, since the state at the cutoff also keeps one older version of some keys.
+                    cutoff = std::max(cutoff, sized_version.first);
+                    break;
+                }
+            }
+            cutoffs.push_back(cutoff);
+        }
+        persistent::version_t horizon = latest_version;
+        for(const auto& kv : this->version_index) {
+            const auto& versions = kv.second.versions;
+            if(versions.empty()) {
+                continue;
+            }
+            // the oldest version of the key to keep, and the versions before an incomplete index are kept too.
+            persistent::version_t required = kv.second.complete ? versions.front() : earliest_version;
+            std::size_t pool_index = find_pool(kv.first);
+            if(pool_index < pools.size()) {
+                const auto& policy = pools[pool_index].policy;
+                if(policy.max_versions > 0 && versions.size() >= policy.max_versions) {
+                    required = std::max(required, versions[versions.size() - policy.max_versions]);
+                }
+                if(cutoffs[pool_index] != persistent::INVALID_VERSION) {
+                    auto pos = std::upper_bound(versions.cbegin(), versions.cend(), cutoffs[pool_index]);
+                    if(pos != versions.cbegin()) {
+                        required = std::max(required, *(pos - 1));
+                    }
+                }
+            }
+            // the current version is relocated instead.
+            if(required < versions.back()) {
+                if constexpr(std::is_base_of<IPatchPayload, VT>::value) {
+                    // a patch needs the full image its chain starts from, at most max_patch_chain versions earlier.
+                    std::size_t required_index = std::lower_bound(versions.cbegin(), versions.cend(), required) - versions.cbegin();
+                    if(required_index >= this->max_patch_chain) {
+                        required = versions[required_index - this->max_patch_chain];
+                    } else {
+                        required = kv.second.complete ? versions.front() : earliest_version;
+                    }
+                }
+                // a relocated version is read from the log entry it is relocated to.
+                auto relocation = this->relocations.find(this->version_index.key_of(kv.first));
+                if(relocation != this->relocations.cend() && relocation->second.first == required) {
+                    required = relocation->second.second;
+                }
+                horizon = std::min(horizon, required);
+            }
+            if(horizon <= earliest_version) {
+                break;
+            }
+        }
+        return std::max(horizon, earliest_version);
+    } else {
+        dbg_default_warn("{}: log retention requires string keys and versioned objects.", __PRETTY_FUNCTION__);
+        return earliest_version;
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+persistent::version_t DeltaCascadeStoreCore<KT, VT, IK, IV>::relocate_before(persistent::version_t horizon, persistent::version_t ver) {
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        assert(this->delta.empty());
+        this->attach_fetched_segments();
+        // the version of the log entry of each current object, oldest first.
+        std::vector<std::pair<persistent::version_t, KT>> candidates;
+        {
+            std::shared_lock<std::shared_mutex> rlck(this->version_index_mutex);
+            for(const auto& kv : this->kv_map) {
+                persistent::version_t logged_at = kv.second.get_version();
+                if constexpr(std::is_base_of<IPatchPayload, VT>::value) {
+                    // a patch needs the full image its chain starts from.
+                    auto chain = this->patch_chain_lengths.find(kv.first);
+                    auto key_versions = this->version_index.find(kv.first);
+                    if(chain != this->patch_chain_lengths.cend() && key_versions != this->version_index.cend()) {
+                        const auto& versions = key_versions->second.versions;
+                        logged_at = (versions.size() > chain->second)
+                                            ? versions[versions.size() - 1 - chain->second]
+                                            : persistent::INVALID_VERSION;
+                    }
+                }
+                auto relocation = this->relocations.find(kv.first);
+                if(relocation != this->relocations.cend() && relocation->second.first == logged_at) {
+                    logged_at = relocation->second.second;
+                }
+                if(logged_at < horizon) {
+                    candidates.emplace_back(logged_at, kv.first);
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        for(const auto& candidate : candidates) {
+            if(this->stub_keys.find(candidate.second) == this->stub_keys.end()) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lck(this->segments_mutex);
+            const auto& missing = this->missing_segments.at(candidate.second);
+            if(missing.patched) {
+                // the object is rebuilt only by replaying the log with the segment, as in ensure_segment().
+                dbg_default_critical("{}: the payload of key {} is patched over the missing blob segment {}, so it can not be relocated.",
+                                     __PRETTY_FUNCTION__, candidate.second, missing.reference.to_string());
+                throw std::runtime_error("The payload of the object is patched over blob segment " + missing.reference.to_string()
+                                         + ", which is unavailable on this node.");
+            }
+        }
+        uint32_t num_relocated = 0;
+        for(const auto& candidate : candidates) {
+            if(key_value_map_at(this->kv_map, candidate.second).is_null()) {
+                // a removed object disappears with its log entries.
+                this->drop(candidate.second);
+                continue;
+            }
+            if(num_relocated >= this->retention_batch) {
+                // hold the horizon for the next round.
+                horizon = candidate.first;
+                break;
+            }
+            if(this->stub_keys.find(candidate.second) != this->stub_keys.end()) {
+                // the entry needs only the reference to the missing blob segment, so the object is relocated as on the
+                // other replicas, and the segment is repaired separately.
+                std::lock_guard<std::mutex> lck(this->segments_mutex);
+                this->delta_externals[candidate.second] = this->missing_segments.at(candidate.second).reference;
+            }
+            this->delta.push_back(candidate.second);
+            this->delta_relocations[candidate.second] = ver;
+            this->patch_chain_lengths.erase(candidate.second);
+            {
+                std::unique_lock<std::shared_mutex> wlck(this->version_index_mutex);
+                this->relocations[candidate.second] = std::make_pair(key_value_map_at(this->kv_map, candidate.second).get_version(), ver);
+            }
+            this->track_checkpoint_entry(candidate.second);
+            num_relocated++;
+        }
+        if(!this->blob_thresholds.empty() && this->blob_thresholds_version < horizon) {
+            // log the blob thresholds again before the delta logging them is trimmed.
+            this->delta_blob_thresholds = true;
+            this->blob_thresholds_version = ver;
+        }
+    }
+    return horizon;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::prune_before(persistent::version_t horizon) {
+    std::vector<KT> unrelocated;
+    {
+        std::unique_lock<std::shared_mutex> wlck(this->version_index_mutex);
+        for(auto& kv : this->version_index) {
+            auto& versions = kv.second.versions;
+            auto pos = std::lower_bound(versions.begin(), versions.end(), horizon);
+            if(pos - versions.begin() > 1) {
+                // keep the last version before the horizon, so that a read of it is reported as expired.
+                std::size_t num_pruned = (pos - versions.begin()) - 1;
+                versions.erase(versions.begin(), versions.begin() + num_pruned);
+                kv.second.sizes.erase(kv.second.sizes.begin(), kv.second.sizes.begin() + num_pruned);
+            }
+        }
+        for(auto it = this->relocations.begin(); it != this->relocations.end();) {
+            if(it->second.second < horizon) {
+                unrelocated.push_back(it->first);
+                it = this->relocations.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+    for(const auto& key : unrelocated) {
+        this->track_checkpoint_entry(key);
+    }
+    std::unique_lock<std::shared_mutex> wlck(this->checkpoint_mutex);
+    this->checkpoints.erase(this->checkpoints.begin(), this->checkpoints.lower_bound(horizon));
+    persistent::version_t first_checkpoint = this->checkpoints.empty() ? this->last_applied_version : this->checkpoints.begin()->first;
+    this->checkpointed_versions.erase(
+            this->checkpointed_versions.begin(),
+            std::upper_bound(this->checkpointed_versions.begin(), this->checkpointed_versions.end(), first_checkpoint));
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::release_segments_before(persistent::version_t horizon) {
+    // the blob segments are removed once no log entry refers to them.
+    std::lock_guard<std::mutex> lck(this->segments_mutex);
+    auto end = this->logged_segments.lower_bound(horizon);
+    for(auto it = this->logged_segments.begin(); it != end; it++) {
+        for(const auto& reference : it->second) {
+            BlobSegmentStore::get().release(reference);
+        }
+    }
+    this->logged_segments.erase(this->logged_segments.begin(), end);
+    this->segments_trimmed_before = horizon;
+}
+
+/**
+ * Write a record of a snapshot file: its size, followed by the bytes written by the writer, padded to 8 bytes.
+ */
+static inline void write_snapshot_record(std::ofstream& out, std::vector<uint8_t>& buffer, std::size_t size,
+                                         const std::function<void(uint8_t*)>& writer) {
+    std::size_t padded_size = (size + 7) & ~static_cast<std::size_t>(7);
+    buffer.assign(sizeof(std::size_t) + padded_size, 0);
+    memcpy(buffer.data(), &size, sizeof(std::size_t));
+    writer(buffer.data() + sizeof(std::size_t));
+    out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+persistent::version_t DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_write_snapshot(
+        const std::string& file, persistent::version_t ver, persistent::version_t last_snapshot,
+        const std::function<VT(const KT&, persistent::version_t)>& read_object) const {
+    SharedTreeMap<stored_key_t<KT>, CheckpointEntry> checkpoint;
+    persistent::version_t checkpoint_version;
+    {
+        std::shared_lock<std::shared_mutex> rlck(this->checkpoint_mutex);
+        auto it = this->checkpoints.upper_bound(ver);
+        if(it == this->checkpoints.cbegin()) {
+            return last_snapshot;
+        }
+        it--;
+        if(last_snapshot != persistent::INVALID_VERSION && it->first <= last_snapshot) {
+            return last_snapshot;
+        }
+        checkpoint_version = it->first;
+        checkpoint = it->second;
+    }
+    uint64_t num_chains = 0;
+    uint64_t num_relocations = 0;
+    checkpoint.for_each([&num_chains, &num_relocations](const auto&, const CheckpointEntry& entry) {
+        num_chains += (entry.patch_chain_length > 0) ? 1 : 0;
+        num_relocations += (entry.relocation.first != persistent::INVALID_VERSION) ? 1 : 0;
+        return true;
+    });
+    std::filesystem::path path(file);
+    std::filesystem::create_directories(path.parent_path());
+    std::string temp = file + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        uint64_t header[5] = {SNAPSHOT_MAGIC, static_cast<uint64_t>(checkpoint_version), checkpoint.size(),
+                              num_chains, num_relocations};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        std::vector<uint8_t> buffer;
+        checkpoint.for_each([this, &out, &buffer, &read_object](const KT& key, const CheckpointEntry& entry) {
+            // an object unchanged since the checkpoint is copied from kv_map, and a superseded one is read from the log.
+            std::optional<VT> value;
+            {
+                EpochGuard epoch_guard;
+                const VT* value_ptr = this->kv_index.find(key);
+                if(value_ptr != nullptr && make_object_head(*value_ptr).version == entry.head.version) {
+                    value.emplace(*value_ptr);
+                }
+            }
+            if(value.has_value()) {
+                if(this->may_miss_segment(*value)) {
+                    this->attach_missing_segment(*value);
+                }
+            } else {
+                value.emplace(read_object(key, entry.head.version));
+                if(make_object_head(*value).version != entry.head.version) {
+                    throw std::runtime_error("The object of the snapshot is trimmed from the log.");
+                }
+            }
+            write_snapshot_record(out, buffer, mutils::bytes_size(*value),
+                                  [&value](uint8_t* buf) { mutils::to_bytes(*value, buf); });
+            return true;
+        });
+        checkpoint.for_each([&out, &buffer](const auto& stored_key, const CheckpointEntry& entry) {
+            if(entry.patch_chain_length > 0) {
+                const KT key(stored_key);
+                std::size_t key_size = mutils::bytes_size(key);
+                write_snapshot_record(out, buffer, key_size + sizeof(uint32_t), [&key, &entry, key_size](uint8_t* buf) {
+                    mutils::to_bytes(key, buf);
+                    memcpy(buf + key_size, &entry.patch_chain_length, sizeof(uint32_t));
+                });
+            }
+            return true;
+        });
+        checkpoint.for_each([&out, &buffer](const auto& stored_key, const CheckpointEntry& entry) {
+            if(entry.relocation.first != persistent::INVALID_VERSION) {
+                const KT key(stored_key);
+                std::size_t key_size = mutils::bytes_size(key);
+                write_snapshot_record(out, buffer, key_size + 2 * sizeof(persistent::version_t), [&key, &entry, key_size](uint8_t* buf) {
+                    mutils::to_bytes(key, buf);
+                    memcpy(buf + key_size, &entry.relocation.first, sizeof(persistent::version_t));
+                    memcpy(buf + key_size + sizeof(persistent::version_t), &entry.relocation.second, sizeof(persistent::version_t));
+                });
+            }
+            return true;
+        });
+        out.flush();
+        if(!out) {
+            throw std::runtime_error("Failed to write snapshot " + temp + ".");
+        }
+    }
+    // make the snapshot durable before it replaces the previous one.
+    int fd = ::open(temp.c_str(), O_RDONLY);
+    if(fd < 0 || ::fdatasync(fd) != 0 || ::rename(temp.c_str(), file.c_str()) != 0) {
+        int error = errno;
+        if(fd >= 0) {
+            ::close(fd);
+        }
+        ::unlink(temp.c_str());
+        throw std::runtime_error("Failed to write snapshot " + file + ": " + strerror(error));
+    }
+    ::close(fd);
+    int dir_fd = ::open(path.parent_path().c_str(), O_RDONLY | O_DIRECTORY);
+    if(dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return checkpoint_version;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool DeltaCascadeStoreCore<KT, VT, IK, IV>::load_snapshot(const std::string& file) {
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+    struct stat st;
+    uint64_t header[5];
+    if(::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(header)) {
+        ::close(fd);
+        dbg_default_warn("Ignoring snapshot {}, which is truncated.", file);
+        return false;
+    }
+    std::size_t file_size = st.st_size;
+    void* addr = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(addr == MAP_FAILED) {
+        dbg_default_warn("Ignoring snapshot {}, which can not be mapped: {}", file, strerror(errno));
+        return false;
+    }
+    // the payloads loaded in place keep the mapping alive.
+    std::shared_ptr<const uint8_t> mapped(static_cast<const uint8_t*>(addr), [file_size](const uint8_t* p) {
+        ::munmap(const_cast<uint8_t*>(p), file_size);
+    });
+    uint8_t* const buffer = const_cast<uint8_t*>(mapped.get());
+    memcpy(header, buffer, sizeof(header));
+    if(header[0] != SNAPSHOT_MAGIC) {
+        dbg_default_warn("Ignoring snapshot {}, which has a bad magic number.", file);
+        return false;
+    }
+    std::size_t pos = sizeof(header);
+    // returns the offset of the next record, or 0 if the record overflows the file.
+    auto next_record = [&pos, file_size, buffer]() -> std::size_t {
+        std::size_t size;
+        if(file_size - pos < sizeof(std::size_t)) {
+            return 0;
+        }
+        memcpy(&size, buffer + pos, sizeof(std::size_t));
+        std::size_t padded_size = (size + 7) & ~static_cast<std::size_t>(7);
+        if(padded_size < size || file_size - pos - sizeof(std::size_t) < padded_size) {
+            return 0;
+        }
+        pos += sizeof(std::size_t);
+        return pos + padded_size;
+    };
+    key_value_map_t<KT, VT> loaded;
+    std::unordered_map<KT, uint32_t> loaded_chains;
+    std::unordered_map<KT, std::pair<persistent::version_t, persistent::version_t>> loaded_relocations;
+    for(uint64_t i = 0; i < header[2]; i++) {
+        std::size_t next = next_record();
+        if(next == 0) {
+            dbg_default_warn("Ignoring snapshot {}, which is truncated.", file);
+            return false;
+        }
+        auto value = mutils::from_bytes_noalloc<VT>(nullptr, buffer + pos);
+        if constexpr(std::is_base_of<IExternalPayload, VT>::value) {
+            // the payload stays in the mapping instead of being copied.
+            if(value->get_payload_size() > 0) {
+                value->attach_payload(std::shared_ptr<const uint8_t>(mapped, value->get_payload_bytes()), value->get_payload_size());
+            }
+        }
+        loaded.emplace_hint(loaded.end(), value->get_key_ref(), *value);
+        pos = next;
+    }
+    for(uint64_t i = 0; i < header[3]; i++) {
+        std::size_t next = next_record();
+        if(next == 0) {
+            dbg_default_warn("Ignoring snapshot {}, which is truncated.", file);
+            return false;
+        }
+        mutils::deserialize_and_run(nullptr, buffer + pos, [&loaded_chains, buffer, pos](const KT& key) {
+            uint32_t chain_length;
+            memcpy(&chain_length, buffer + pos + mutils::bytes_size(key), sizeof(uint32_t));
+            loaded_chains.emplace(key, chain_length);
+            return true;
+        });
+        pos = next;
+    }
+    for(uint64_t i = 0; i < header[4]; i++) {
+        std::size_t next = next_record();
+        if(next == 0) {
+            dbg_default_warn("Ignoring snapshot {}, which is truncated.", file);
+            return false;
+        }
+        mutils::deserialize_and_run(nullptr, buffer + pos, [&loaded_relocations, buffer, pos](const KT& key) {
+            std::pair<persistent::version_t, persistent::version_t> relocation;
+            std::size_t key_size = mutils::bytes_size(key);
+            memcpy(&relocation.first, buffer + pos + key_size, sizeof(persistent::version_t));
+            memcpy(&relocation.second, buffer + pos + key_size + sizeof(persistent::version_t), sizeof(persistent::version_t));
+            loaded_relocations.emplace(key, relocation);
+            return true;
+        });
+        pos = next;
+    }
+    this->kv_map = std::move(loaded);
+    this->patch_chain_lengths = std::move(loaded_chains);
+    {
+        std::unique_lock<std::shared_mutex> wlck(this->version_index_mutex);
+        this->relocations = std::move(loaded_relocations);
+    }
+    this->rebuild_kv_index();
+    this->snapshot_version = static_cast<persistent::version_t>(header[1]);
+    this->last_applied_version = this->snapshot_version;
+    return true;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::map<std::string, uint64_t> DeltaCascadeStoreCore<KT, VT, IK, IV>::get_key_memory_stats() const {
+    KeyMemoryStats<KT> key_stats;
+    {
+        // kv_map is only read by the predicate thread, so the keys are visited through kv_index, which points to them.
+        EpochGuard epoch_guard;
+        this->kv_index.for_each_entry([&key_stats](const auto& entry) {
+            key_stats.add(entry.first);
+            return true;
+        });
+    }
+    auto stats = key_stats.get();
+    std::shared_lock<std::shared_mutex> rlck(this->version_index_mutex);
+    stats["index_key_bytes"] = this->version_index.get_key_memory_stats().at("stored_key_bytes");
+    return stats;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::map<std::string, uint64_t> DeltaCascadeStoreCore<KT, VT, IK, IV>::get_recovery_stats() const {
+    return {{"snapshot_version", static_cast<uint64_t>(this->snapshot_version)},
+            {"snapshot_objects", (this->snapshot_version == persistent::INVALID_VERSION) ? 0 : this->snapshot_objects},
+            {"replayed_deltas", this->replayed_deltas},
+            {"skipped_deltas", this->skipped_deltas}};
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 std::unique_ptr<DeltaCascadeStoreCore<KT, VT, IK, IV>> DeltaCascadeStoreCore<KT, VT, IK, IV>::create(mutils::DeserializationManager* dm) {
-    if(dm != nullptr) {
-        try {
-            return std::make_unique<DeltaCascadeStoreCore<KT, VT, IK, IV>>();
-        } catch(...) {
+    auto core = std::make_unique<DeltaCascadeStoreCore<KT, VT, IK, IV>>();
+    // only the recovery of a PersistentCascadeStore registers a SnapshotRecovery, while reading a historical state
+    // from the log replays it from the start.
+    core->tracks_segments = (dm != nullptr && dm->registered<SnapshotRecovery>());
+    if(core->tracks_segments) {
+        const std::string& snapshot_file = dm->mgr<SnapshotRecovery>().snapshot_file;
+        if(!snapshot_file.empty() && core->load_snapshot(snapshot_file)) {
+            core->snapshot_objects = core->kv_map.size();
+            dbg_default_info("Loaded {} objects of version:0x{:x} from snapshot {}.",
+                             core->snapshot_objects, core->snapshot_version, snapshot_file);
         }
     }
-    return std::make_unique<DeltaCascadeStoreCore<KT, VT, IK, IV>>();
+    return core;
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_put(const VT& value, persistent::version_t prev_ver, bool as_trigger) {
     // call validator
     if constexpr(std::is_base_of<IValidator<KT, VT>, VT>::value) {
-        if(!value.validate(this->kv_map)) {
+        if(!value.validate_stored(this->kv_map)) {
             return false;
         }
     }
@@ -191,7 +1280,7 @@ bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_put(const VT& value, persist
     if constexpr(std::is_base_of<IVerifyPreviousVersion, VT>::value) {
         bool verify_result;
         if(kv_map.find(value.get_key_ref()) != this->kv_map.end()) {
-            verify_result = value.verify_previous_version(prev_ver, this->kv_map.at(value.get_key_ref()).get_version());
+            verify_result = value.verify_previous_version(prev_ver, key_value_map_at(this->kv_map, value.get_key_ref()).get_version());
         } else {
             verify_result = value.verify_previous_version(prev_ver, persistent::INVALID_VERSION);
         }
@@ -203,7 +1292,7 @@ bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_put(const VT& value, persist
     if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
         persistent::version_t prev_ver_by_key = persistent::INVALID_VERSION;
         if(kv_map.find(value.get_key_ref()) != kv_map.end()) {
-            prev_ver_by_key = kv_map.at(value.get_key_ref()).get_version();
+            prev_ver_by_key = key_value_map_at(this->kv_map, value.get_key_ref()).get_version();
         }
         value.set_previous_version(prev_ver, prev_ver_by_key);
     }
@@ -217,6 +1306,118 @@ bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_put(const VT& value, persist
     return true;
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_put_batch(const std::vector<VT>& values, persistent::version_t prev_ver, bool as_trigger) {
+    std::set<KT> keys;
+    for(const auto& value : values) {
+        if(!keys.insert(value.get_key_ref()).second) {
+            dbg_default_warn("{}: rejected a batch with duplicate key {}.", __PRETTY_FUNCTION__, value.get_key_ref());
+            return false;
+        }
+    }
+    // verify every object against the state before the batch, so that the batch is applied all or nothing.
+    for(const auto& value : values) {
+        if constexpr(std::is_base_of<IValidator<KT, VT>, VT>::value) {
+            if(!value.validate_stored(this->kv_map)) {
+                return false;
+            }
+        }
+        if constexpr(std::is_base_of<IVerifyPreviousVersion, VT>::value) {
+            auto it = this->kv_map.find(value.get_key_ref());
+            if(!value.verify_previous_version(prev_ver,
+                                              (it != this->kv_map.end()) ? it->second.get_version() : persistent::INVALID_VERSION)) {
+                return false;
+            }
+        }
+    }
+    if(!as_trigger) {
+        assert(this->delta.empty());
+    }
+    for(const auto& value : values) {
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            auto it = this->kv_map.find(value.get_key_ref());
+            value.set_previous_version(prev_ver,
+                                       (it != this->kv_map.end()) ? it->second.get_version() : persistent::INVALID_VERSION);
+        }
+        if(!as_trigger) {
+            // all objects go to the same delta, which is logged under one version.
+            this->delta.push_back(value.get_key_ref());
+            apply_ordered_put(value);
+        }
+    }
+    return true;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_put_range(const VT& patch, uint64_t offset, persistent::version_t prev_ver) {
+    if constexpr(std::is_base_of<IPatchPayload, VT>::value) {
+        const KT& key = patch.get_key_ref();
+        this->ensure_segment(key);
+        const uint8_t* base = nullptr;
+        std::size_t base_size = 0;
+        auto it = this->kv_map.find(key);
+        if(it != this->kv_map.end()) {
+            base = it->second.get_payload_bytes();
+            base_size = it->second.get_payload_size();
+        }
+        if(offset == IPatchPayload::APPEND_OFFSET) {
+            offset = base_size;
+        }
+        const std::size_t patch_size = patch.get_payload_size();
+        if(offset > base_size || patch_size == 0) {
+            return false;
+        }
+        VT image(patch);
+        image.patch_payload(base, base_size, offset);
+        uint32_t chain_length = 0;
+        auto chain = this->patch_chain_lengths.find(key);
+        if(chain != this->patch_chain_lengths.end()) {
+            chain_length = chain->second;
+        }
+        // log a full image to start a new chain, or if the patch saves less than half of the image.
+        const bool log_patch = (base_size > 0) && (chain_length < this->max_patch_chain)
+                               && (patch_size * 2 < image.get_payload_size());
+        if(!this->ordered_put(image, prev_ver, false)) {
+            return false;
+        }
+        if(log_patch) {
+            this->delta_patches[key] = std::make_pair(static_cast<std::size_t>(offset), patch_size);
+            this->patch_chain_lengths[key] = chain_length + 1;
+            this->track_checkpoint_entry(key);
+        }
+        return true;
+    } else {
+        dbg_default_warn("{}: partial update is not supported by the object type.", __PRETTY_FUNCTION__);
+        return false;
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_merge(const VT& operand, const std::string& merge_operator, persistent::version_t prev_ver) {
+    if constexpr(std::is_base_of<IMergePayload, VT>::value) {
+        this->ensure_segment(operand.get_key_ref());
+        const uint8_t* base = nullptr;
+        std::size_t base_size = 0;
+        auto it = this->kv_map.find(operand.get_key_ref());
+        if(it != this->kv_map.end() && !it->second.is_null()) {
+            base = it->second.get_payload_bytes();
+            base_size = it->second.get_payload_size();
+        }
+        std::vector<uint8_t> merged;
+        if(!MergeOperatorRegistry::get().merge(merge_operator, base, base_size,
+                                               operand.get_payload_bytes(), operand.get_payload_size(), merged)) {
+            dbg_default_warn("{}: merge operator {} rejected the operand of key {}.", __PRETTY_FUNCTION__, merge_operator, operand.get_key_ref());
+            return false;
+        }
+        VT image(operand);
+        image.set_payload(merged.data(), merged.size());
+        return this->ordered_put(image, prev_ver, false);
+    } else {
+        dbg_default_warn("{}: merge is not supported by the object type.", __PRETTY_FUNCTION__);
+        return false;
+    }
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_remove(const VT& value, persistent::version_t prev_ver) {
     auto& key = value.get_key_ref();
@@ -224,13 +1425,13 @@ bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_remove(const VT& value, pers
     if(kv_map.find(key) == kv_map.end()) {
         // skip it when no such key.
         return false;
-    } else if(kv_map.at(key).is_null()) {
+    } else if(key_value_map_at(this->kv_map, key).is_null()) {
         // and skip the keys has been deleted already.
         return false;
     }
 
     if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
-        value.set_previous_version(prev_ver, kv_map.at(key).get_version());
+        value.set_previous_version(prev_ver, key_value_map_at(this->kv_map, key).get_version());
     }
     // create delta.
     assert(this->delta.empty());
@@ -243,7 +1444,9 @@ bool DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_remove(const VT& value, pers
 template <typename KT, typename VT, KT* IK, VT* IV>
 const VT DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_get(const KT& key) const {
     if(kv_map.find(key) != kv_map.end()) {
-        return kv_map.at(key);
+        VT value(key_value_map_at(this->kv_map, key));
+        this->attach_missing_segment(value);
+        return value;
     } else {
         return *IV;
     }
@@ -251,101 +1454,84 @@ const VT DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_get(const KT& key) const
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 const VT DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_get(const KT& key) const {
-    persistent::version_t v1, v2;
-    static thread_local VT copied_out;
-    do {
-        // This only for TSO memory reordering.
-        v2 = this->lockless_v2.load(std::memory_order_relaxed);
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        /* 
-         * An out_of_range exception can be thrown even if 'key' exists in
-         * kv_map. Since std::map is not thread-safe, and there is another
-         * thread modifying kv_map concurrently, the internal data structure can
-         * be changed while this thread is inside kv_map.at(key). Therefore, we
-         * keep trying until it is possible to copy either the object we are
-         * looking for, or the invalid object.
-         */
-        while(true) {
-            try {
-                if(this->kv_map.find(key) != this->kv_map.end()) {
-                    copied_out.copy_from(this->kv_map.at(key));
-                } else {
-                    copied_out.copy_from(*IV);
-                }
-
-                break;
-            } catch (const std::out_of_range&) {
-                dbg_default_debug("{}: out_of_range exception thrown while trying to get key {}", __PRETTY_FUNCTION__, key);
-            }
-        }
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        v1 = this->lockless_v1.load(std::memory_order_relaxed);
-        // busy sleep
-        std::this_thread::yield();
-    } while(v1 != v2);
-    return copied_out;
+    // the copy pins the payload of the stored object if VT implements ISharePayload.
+    EpochGuard epoch_guard;
+    const VT* value_ptr = this->kv_index.find(key);
+    if(value_ptr != nullptr) {
+        VT value(*value_ptr);
+        this->attach_missing_segment(value);
+        return value;
+    } else {
+        return *IV;
+    }
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 std::vector<KT> DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_list_keys(const std::string& prefix) const {
-    persistent::version_t v1, v2;
     std::vector<KT> key_list;
-    do {
-        // This only for TSO memory reordering.
-        v2 = this->lockless_v2.load(std::memory_order_relaxed);
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        for(const auto& kv : kv_map) {
-            if(get_pathname<KT>(kv.first).find(prefix) == 0) {
-                key_list.push_back(kv.first);
-            }
-        }
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        v1 = this->lockless_v1.load(std::memory_order_relaxed);
-        // busy sleep
-        std::this_thread::yield();
-    } while(v1 != v2);
+    EpochGuard epoch_guard;
+    this->kv_index.for_each_with_prefix(prefix, [&key_list](const KT& key, const VT&) {
+        key_list.push_back(key);
+        return true;
+    });
     return key_list;
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
-std::vector<KT> DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_list_keys(const std::string& prefix) {
-    std::vector<KT> key_list;
-    for(const auto& kv : kv_map) {
-        if(get_pathname<KT>(kv.first).find(prefix) == 0) {
-            key_list.push_back(kv.first);
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_for_each_with_prefix(
+        const std::string& prefix, const std::function<bool(const KT&, const VT&)>& visitor) const {
+    EpochGuard epoch_guard;
+    if(!this->has_missing_segments.load(std::memory_order_acquire)) {
+        this->kv_index.for_each_with_prefix(prefix, visitor);
+        return;
+    }
+    this->kv_index.for_each_with_prefix(prefix, [this, &visitor](const KT& key, const VT& stored) {
+        if(!this->may_miss_segment(stored)) {
+            return visitor(key, stored);
         }
+        VT value(stored);
+        this->attach_missing_segment(value);
+        return visitor(key, value);
+    });
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_for_each_with_prefix_after(
+        const std::string& prefix, const KT& start_after, const std::function<bool(const KT&, const VT&)>& visitor) const {
+    EpochGuard epoch_guard;
+    if(!this->has_missing_segments.load(std::memory_order_acquire)) {
+        this->kv_index.for_each_with_prefix_after(prefix, start_after, visitor);
+        return;
     }
+    this->kv_index.for_each_with_prefix_after(prefix, start_after, [this, &visitor](const KT& key, const VT& stored) {
+        if(!this->may_miss_segment(stored)) {
+            return visitor(key, stored);
+        }
+        VT value(stored);
+        this->attach_missing_segment(value);
+        return visitor(key, value);
+    });
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<KT> DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_list_keys(const std::string& prefix) {
+    std::vector<KT> key_list;
+    this->kv_index.for_each_with_prefix(prefix, [&key_list](const KT& key, const VT&) {
+        key_list.push_back(key);
+        return true;
+    });
     return key_list;
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 uint64_t DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_get_size(const KT& key) {
     if(kv_map.find(key) != kv_map.end()) {
-        return mutils::bytes_size(kv_map.at(key));
+        if(this->may_miss_segment(key_value_map_at(this->kv_map, key))) {
+            VT value(key_value_map_at(this->kv_map, key));
+            this->attach_missing_segment(value);
+            return mutils::bytes_size(value);
+        }
+        return mutils::bytes_size(key_value_map_at(this->kv_map, key));
     } else {
         return 0;
     }
@@ -353,51 +1539,383 @@ uint64_t DeltaCascadeStoreCore<KT, VT, IK, IV>::ordered_get_size(const KT& key)
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 uint64_t DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_get_size(const KT& key) const {
-    persistent::version_t v1, v2;
-    uint64_t size = 0ull;
-
-    do {
-        // This only for TSO memory reordering.
-        v2 = this->lockless_v2.load(std::memory_order_relaxed);
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        if(this->kv_map.find(key) != this->kv_map.end()) {
-            size = mutils::bytes_size(this->kv_map.at(key));
-        }
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        v1 = this->lockless_v1.load(std::memory_order_relaxed);
-        // busy sleep
-        std::this_thread::yield();
-    } while(v1 != v2);
-    return size;
+    EpochGuard epoch_guard;
+    const VT* value_ptr = this->kv_index.find(key);
+    if(value_ptr != nullptr) {
+        if(this->may_miss_segment(*value_ptr)) {
+            VT value(*value_ptr);
+            this->attach_missing_segment(value);
+            return mutils::bytes_size(value);
+        }
+        return mutils::bytes_size(*value_ptr);
+    }
+    return 0;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+ObjectHead DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_head(const KT& key) const {
+    EpochGuard epoch_guard;
+    const VT* value_ptr = this->kv_index.find(key);
+    if(value_ptr != nullptr) {
+        if(this->may_miss_segment(*value_ptr)) {
+            VT value(*value_ptr);
+            this->attach_missing_segment(value);
+            return make_object_head(value);
+        }
+        return make_object_head(*value_ptr);
+    }
+    return ObjectHead{};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool DeltaCascadeStoreCore<KT, VT, IK, IV>::is_external(const VT& value) const {
+    if constexpr(std::is_base_of<IExternalPayload, VT>::value) {
+        uint64_t threshold = this->default_blob_threshold;
+        if constexpr(std::is_convertible_v<KT, std::string>) {
+            const std::string& key = value.get_key_ref();
+            for(const auto& pool : this->blob_thresholds) {
+                if(key.size() > pool.first.size() && key[pool.first.size()] == PATH_SEPARATOR
+                   && pathname_has_prefix(key, pool.first)) {
+                    threshold = pool.second;
+                    break;
+                }
+            }
+        }
+        return (threshold > 0 && value.get_payload_size() > threshold);
+    }
+    return false;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::set_blob_thresholds(const std::map<std::string, uint64_t>& thresholds,
+                                                                persistent::version_t ver) {
+    bool changed = false;
+    for(const auto& threshold : thresholds) {
+        auto it = this->blob_thresholds.find(threshold.first);
+        if(threshold.second == 0) {
+            if(it != this->blob_thresholds.end()) {
+                this->blob_thresholds.erase(it);
+                changed = true;
+            }
+        } else if(it == this->blob_thresholds.end() || it->second != threshold.second) {
+            this->blob_thresholds[threshold.first] = threshold.second;
+            changed = true;
+        }
+    }
+    if(changed) {
+        this->delta_blob_thresholds = true;
+        this->blob_thresholds_version = ver;
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::log_segment(persistent::version_t ver, const BlobReference& reference,
+                                                        const std::shared_ptr<const uint8_t>& payload) {
+    BlobSegmentStore::get().acquire(reference, payload);
+    if(ver != persistent::INVALID_VERSION) {
+        std::lock_guard<std::mutex> lck(this->segments_mutex);
+        this->logged_segments[ver].push_back(reference);
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_track_segments(persistent::version_t ver, const std::vector<BlobReference>& references) {
+    std::lock_guard<std::mutex> lck(this->segments_mutex);
+    if(!this->tracks_segments || references.empty() || ver == persistent::INVALID_VERSION
+       || (this->segments_trimmed_before != persistent::INVALID_VERSION && ver < this->segments_trimmed_before)
+       || this->logged_segments.find(ver) != this->logged_segments.end()) {
+        return;
+    }
+    for(const auto& reference : references) {
+        BlobSegmentStore::get().acquire(reference);
+    }
+    this->logged_segments.emplace(ver, references);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::mark_missing_segment(const VT& stub, const BlobReference& reference, bool patched) {
+    persistent::version_t ver = persistent::INVALID_VERSION;
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        ver = stub.get_version();
+    }
+    {
+        std::lock_guard<std::mutex> lck(this->segments_mutex);
+        this->missing_segments[stub.get_key_ref()] = MissingSegment{ver, reference, patched};
+    }
+    this->stub_keys.insert(stub.get_key_ref());
+    this->has_missing_segments.store(true, std::memory_order_release);
+    if(patched) {
+        dbg_default_error("Key {} is patched over the missing blob segment {}, so it is unreadable until its log is replayed with the segment.",
+                          stub.get_key_ref(), reference.to_string());
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool DeltaCascadeStoreCore<KT, VT, IK, IV>::may_miss_segment(const VT& value) const {
+    if constexpr(std::is_base_of<IExternalPayload, VT>::value) {
+        // a blob segment is never empty, so an object with a payload has it.
+        return this->has_missing_segments.load(std::memory_order_acquire) && value.get_payload_size() == 0;
+    }
+    return false;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::attach_missing_segment(VT& value) const {
+    if(!this->may_miss_segment(value)) {
+        return;
+    }
+    MissingSegment missing;
+    {
+        std::lock_guard<std::mutex> lck(this->segments_mutex);
+        auto it = this->missing_segments.find(value.get_key_ref());
+        if(it == this->missing_segments.cend()) {
+            return;
+        }
+        missing = it->second;
+    }
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        if(missing.version != value.get_version()) {
+            // a later object of the key.
+            return;
+        }
+    }
+    if(!missing.patched && DeltaType::attach_external(value, missing.reference)) {
+        return;
+    }
+    throw std::runtime_error("The payload of the object is in blob segment " + missing.reference.to_string()
+                             + ", which is missing on this node and being fetched from the shard members.");
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::replace_stored(const VT& value) {
+    auto old_node = key_value_map_extract(this->kv_map, value.get_key_ref());
+    // reuse the stored key of the old object, so that an update does not intern the key again.
+    auto it = old_node.empty() ? this->kv_map.emplace(value.get_key_ref(), value).first
+                               : this->kv_map.emplace(old_node.key(), value).first;
+    if constexpr(std::is_base_of<ISharePayload, VT>::value) {
+        it->second.share_payload();
+    }
+    this->kv_index.publish(*it);
+    if(!old_node.empty()) {
+        this->kv_index.retire(std::move(old_node));
+    }
+    this->kv_index.reclaim();
+    this->track_checkpoint_entry(value.get_key_ref());
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::attach_fetched_segments() {
+    if(!this->fetched_segments.exchange(false)) {
+        return;
+    }
+    for(auto key = this->stub_keys.begin(); key != this->stub_keys.end();) {
+        MissingSegment missing;
+        {
+            std::lock_guard<std::mutex> lck(this->segments_mutex);
+            missing = this->missing_segments.at(*key);
+        }
+        VT value(key_value_map_at(this->kv_map, *key));
+        if(!missing.patched && BlobSegmentStore::get().contains(missing.reference)
+           && DeltaType::attach_external(value, missing.reference)) {
+            this->replace_stored(value);
+            key = this->stub_keys.erase(key);
+        } else {
+            key++;
+        }
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::ensure_segment(const KT& key) {
+    if(this->stub_keys.find(key) == this->stub_keys.end()) {
+        return;
+    }
+    MissingSegment missing;
+    {
+        std::lock_guard<std::mutex> lck(this->segments_mutex);
+        missing = this->missing_segments.at(key);
+    }
+    VT value(key_value_map_at(this->kv_map, key));
+    if(!missing.patched && !BlobSegmentStore::get().contains(missing.reference) && this->segment_fetcher) {
+        this->segment_fetcher(missing.reference);
+    }
+    if(missing.patched || !DeltaType::attach_external(value, missing.reference)) {
+        // the other replicas apply the update, so this one diverges.
+        dbg_default_critical("{}: the payload of key {} in blob segment {} is unavailable, so the update can not be applied.",
+                             __PRETTY_FUNCTION__, key, missing.reference.to_string());
+        throw std::runtime_error("The payload of the object is in blob segment " + missing.reference.to_string()
+                                 + ", which is unavailable on this node.");
+    }
+    this->replace_stored(value);
+    this->stub_keys.erase(key);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<BlobReference> DeltaCascadeStoreCore<KT, VT, IK, IV>::lockless_missing_segments() const {
+    std::vector<BlobReference> references;
+    std::lock_guard<std::mutex> lck(this->segments_mutex);
+    for(const auto& missing : this->missing_segments) {
+        references.push_back(missing.second.reference);
+    }
+    return references;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::notify_fetched_segments() {
+    this->fetched_segments.store(true);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+key_value_map_t<KT, VT> DeltaCascadeStoreCore<KT, VT, IK, IV>::attached_kv_map() const {
+    key_value_map_t<KT, VT> attached(this->kv_map);
+    for(const auto& key : this->stub_keys) {
+        this->attach_missing_segment(key_value_map_at(attached, key));
+    }
+    return attached;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::to_bytes(uint8_t* buf) const {
+    if(this->stub_keys.empty()) {
+        return key_value_map_to_bytes<KT, VT>(this->kv_map, buf);
+    }
+    return key_value_map_to_bytes<KT, VT>(this->attached_kv_map(), buf);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void DeltaCascadeStoreCore<KT, VT, IK, IV>::post_object(const std::function<void(uint8_t const* const, std::size_t)>& f) const {
+    if(this->stub_keys.empty()) {
+        key_value_map_post_object<KT, VT>(f, this->kv_map);
+    } else {
+        key_value_map_post_object<KT, VT>(f, this->attached_kv_map());
+    }
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
-DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaCascadeStoreCore() : lockless_v1(persistent::INVALID_VERSION),
-                                                                 lockless_v2(persistent::INVALID_VERSION) {
+std::size_t DeltaCascadeStoreCore<KT, VT, IK, IV>::bytes_size() const {
+    if(this->stub_keys.empty()) {
+        return key_value_map_bytes_size<KT, VT>(this->kv_map);
+    }
+    return key_value_map_bytes_size<KT, VT>(this->attached_kv_map());
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
-DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaCascadeStoreCore(const std::map<KT, VT>& _kv_map) : lockless_v1(persistent::INVALID_VERSION),
-                                                                                                lockless_v2(persistent::INVALID_VERSION),
-                                                                                                kv_map(_kv_map) {
+std::unique_ptr<DeltaCascadeStoreCore<KT, VT, IK, IV>> DeltaCascadeStoreCore<KT, VT, IK, IV>::from_bytes(
+        mutils::DeserializationManager* dsm, uint8_t const* buf) {
+    // kv_map is sent as a std::map<KT, VT>.
+    auto kv_map_ptr = mutils::from_bytes<std::map<KT, VT>>(dsm, buf);
+    return std::make_unique<DeltaCascadeStoreCore>(std::move(*kv_map_ptr));
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaCascadeStoreCore()
+        : last_applied_version(persistent::INVALID_VERSION),
+          versions_since_checkpoint(0),
+          bytes_since_checkpoint(0),
+          checkpoint_interval(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_CHECKPOINT_INTERVAL)
+                                      ? derecho::getConfUInt64(CASCADE_PERSISTENT_CHECKPOINT_INTERVAL)
+                                      : CASCADE_PERSISTENT_CHECKPOINT_INTERVAL_DEFAULT),
+          checkpoint_bytes(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_CHECKPOINT_BYTES)
+                                   ? derecho::getConfUInt64(CASCADE_PERSISTENT_CHECKPOINT_BYTES)
+                                   : CASCADE_PERSISTENT_CHECKPOINT_BYTES_DEFAULT),
+          max_checkpoints(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_MAX_CHECKPOINTS)
+                                  ? derecho::getConfUInt32(CASCADE_PERSISTENT_MAX_CHECKPOINTS)
+                                  : CASCADE_PERSISTENT_MAX_CHECKPOINTS_DEFAULT),
+          tracks_checkpoints(std::is_base_of<IKeepVersion, VT>::value && (checkpoint_interval > 0 || checkpoint_bytes > 0)),
+          max_patch_chain(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_MAX_PATCH_CHAIN)
+                                  ? derecho::getConfUInt32(CASCADE_PERSISTENT_MAX_PATCH_CHAIN)
+                                  : CASCADE_PERSISTENT_MAX_PATCH_CHAIN_DEFAULT),
+          retention_batch(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_RETENTION_BATCH)
+                                  ? derecho::getConfUInt32(CASCADE_PERSISTENT_RETENTION_BATCH)
+                                  : CASCADE_PERSISTENT_RETENTION_BATCH_DEFAULT),
+          default_blob_threshold(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_BLOB_THRESHOLD)
+                                         ? derecho::getConfUInt64(CASCADE_PERSISTENT_BLOB_THRESHOLD)
+                                         : CASCADE_PERSISTENT_BLOB_THRESHOLD_DEFAULT),
+          blob_thresholds_version(persistent::INVALID_VERSION),
+          snapshot_version(persistent::INVALID_VERSION),
+          snapshot_objects(0),
+          replayed_deltas(0),
+          skipped_deltas(0),
+          tracks_segments(true),
+          segments_trimmed_before(persistent::INVALID_VERSION),
+          has_missing_segments(false),
+          fetched_segments(false),
+          delta_blob_thresholds(false) {}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaCascadeStoreCore(const std::map<KT, VT>& _kv_map)
+        : last_applied_version(persistent::INVALID_VERSION),
+          versions_since_checkpoint(0),
+          bytes_since_checkpoint(0),
+          checkpoint_interval(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_CHECKPOINT_INTERVAL)
+                                      ? derecho::getConfUInt64(CASCADE_PERSISTENT_CHECKPOINT_INTERVAL)
+                                      : CASCADE_PERSISTENT_CHECKPOINT_INTERVAL_DEFAULT),
+          checkpoint_bytes(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_CHECKPOINT_BYTES)
+                                   ? derecho::getConfUInt64(CASCADE_PERSISTENT_CHECKPOINT_BYTES)
+                                   : CASCADE_PERSISTENT_CHECKPOINT_BYTES_DEFAULT),
+          max_checkpoints(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_MAX_CHECKPOINTS)
+                                  ? derecho::getConfUInt32(CASCADE_PERSISTENT_MAX_CHECKPOINTS)
+                                  : CASCADE_PERSISTENT_MAX_CHECKPOINTS_DEFAULT),
+          tracks_checkpoints(std::is_base_of<IKeepVersion, VT>::value && (checkpoint_interval > 0 || checkpoint_bytes > 0)),
+          max_patch_chain(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_MAX_PATCH_CHAIN)
+                                  ? derecho::getConfUInt32(CASCADE_PERSISTENT_MAX_PATCH_CHAIN)
+                                  : CASCADE_PERSISTENT_MAX_PATCH_CHAIN_DEFAULT),
+          retention_batch(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_RETENTION_BATCH)
+                                  ? derecho::getConfUInt32(CASCADE_PERSISTENT_RETENTION_BATCH)
+                                  : CASCADE_PERSISTENT_RETENTION_BATCH_DEFAULT),
+          default_blob_threshold(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_BLOB_THRESHOLD)
+                                         ? derecho::getConfUInt64(CASCADE_PERSISTENT_BLOB_THRESHOLD)
+                                         : CASCADE_PERSISTENT_BLOB_THRESHOLD_DEFAULT),
+          blob_thresholds_version(persistent::INVALID_VERSION),
+          snapshot_version(persistent::INVALID_VERSION),
+          snapshot_objects(0),
+          replayed_deltas(0),
+          skipped_deltas(0),
+          tracks_segments(true),
+          segments_trimmed_before(persistent::INVALID_VERSION),
+          has_missing_segments(false),
+          fetched_segments(false),
+          delta_blob_thresholds(false),
+          kv_map(to_key_value_map<KT, VT>(_kv_map)) {
+    rebuild_kv_index();
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
-DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaCascadeStoreCore(std::map<KT, VT>&& _kv_map) : lockless_v1(persistent::INVALID_VERSION),
-                                                                                           lockless_v2(persistent::INVALID_VERSION),
-                                                                                           kv_map(std::move(_kv_map)) {
+DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaCascadeStoreCore(std::map<KT, VT>&& _kv_map)
+        : last_applied_version(persistent::INVALID_VERSION),
+          versions_since_checkpoint(0),
+          bytes_since_checkpoint(0),
+          checkpoint_interval(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_CHECKPOINT_INTERVAL)
+                                      ? derecho::getConfUInt64(CASCADE_PERSISTENT_CHECKPOINT_INTERVAL)
+                                      : CASCADE_PERSISTENT_CHECKPOINT_INTERVAL_DEFAULT),
+          checkpoint_bytes(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_CHECKPOINT_BYTES)
+                                   ? derecho::getConfUInt64(CASCADE_PERSISTENT_CHECKPOINT_BYTES)
+                                   : CASCADE_PERSISTENT_CHECKPOINT_BYTES_DEFAULT),
+          max_checkpoints(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_MAX_CHECKPOINTS)
+                                  ? derecho::getConfUInt32(CASCADE_PERSISTENT_MAX_CHECKPOINTS)
+                                  : CASCADE_PERSISTENT_MAX_CHECKPOINTS_DEFAULT),
+          tracks_checkpoints(std::is_base_of<IKeepVersion, VT>::value && (checkpoint_interval > 0 || checkpoint_bytes > 0)),
+          max_patch_chain(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_MAX_PATCH_CHAIN)
+                                  ? derecho::getConfUInt32(CASCADE_PERSISTENT_MAX_PATCH_CHAIN)
+                                  : CASCADE_PERSISTENT_MAX_PATCH_CHAIN_DEFAULT),
+          retention_batch(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_RETENTION_BATCH)
+                                  ? derecho::getConfUInt32(CASCADE_PERSISTENT_RETENTION_BATCH)
+                                  : CASCADE_PERSISTENT_RETENTION_BATCH_DEFAULT),
+          default_blob_threshold(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_BLOB_THRESHOLD)
+                                         ? derecho::getConfUInt64(CASCADE_PERSISTENT_BLOB_THRESHOLD)
+                                         : CASCADE_PERSISTENT_BLOB_THRESHOLD_DEFAULT),
+          blob_thresholds_version(persistent::INVALID_VERSION),
+          snapshot_version(persistent::INVALID_VERSION),
+          snapshot_objects(0),
+          replayed_deltas(0),
+          skipped_deltas(0),
+          tracks_segments(true),
+          segments_trimmed_before(persistent::INVALID_VERSION),
+          has_missing_segments(false),
+          fetched_segments(false),
+          delta_blob_thresholds(false),
+          kv_map(to_key_value_map<KT, VT>(std::move(_kv_map))) {
+    rebuild_kv_index();
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
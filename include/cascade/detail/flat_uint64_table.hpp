@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * FlatUInt64Table is a hash table of objects with uint64_t keys in one flat array, with open addressing.
+ *
+ * Each slot takes 32 bytes: the key, the version and the timestamp of the object, and a payload word. A payload of at
+ * most INLINE_PAYLOAD_BYTES bytes is stored in the payload word, and a larger payload is stored in a block allocated
+ * for it, to which the payload word points. Collisions are resolved by linear probing, and an erased slot is filled by
+ * shifting the following slots of the probe sequence back, so the table needs no tombstones. The table grows when it
+ * is 7/8 full.
+ *
+ * FlatUInt64Table is not thread safe.
+ */
+class FlatUInt64Table {
+public:
+    /* the largest payload stored in the slot */
+    static constexpr std::size_t INLINE_PAYLOAD_BYTES = sizeof(uint64_t) - 1;
+
+    /**
+     * The object of a key. The payload bytes are valid until the table is modified.
+     */
+    struct View {
+        int64_t version;
+        uint64_t timestamp_us;
+        const uint8_t* bytes;
+        std::size_t size;
+    };
+
+private:
+    struct Slot {
+        uint64_t key;
+        int64_t version;
+        uint64_t timestamp_us;
+        /* 0 for an empty slot. If the lowest bit of the first byte is set, the first byte is the size shifted by one
+         * and the payload follows it; otherwise it is a pointer to a block of the size followed by the payload. */
+        uint64_t payload;
+    };
+    static_assert(sizeof(Slot) == 32, "FlatUInt64Table slots are expected to be 32 bytes.");
+
+    /* the slots, whose number is 0 or a power of two */
+    std::vector<Slot> slots;
+    /* the number of keys */
+    std::size_t num_entries;
+    /* the bytes of the allocated payload blocks */
+    std::size_t heap_bytes;
+
+    inline static uint64_t hash(uint64_t key);
+    inline static uint64_t make_payload(const uint8_t* bytes, std::size_t size);
+    inline static void release_payload(uint64_t payload);
+    inline static std::size_t payload_block_bytes(uint64_t payload);
+    inline static View view_of(const Slot& slot);
+    /**
+     * @return the index of the slot of a key, or slots.size() if the key is not in the table.
+     */
+    inline std::size_t find_slot(uint64_t key) const;
+    /**
+     * Move the slots to a new array of a number of slots.
+     */
+    inline void rehash(std::size_t capacity);
+
+public:
+    inline FlatUInt64Table();
+    inline FlatUInt64Table(FlatUInt64Table&& other);
+    inline FlatUInt64Table& operator=(FlatUInt64Table&& other);
+    FlatUInt64Table(const FlatUInt64Table&) = delete;
+    FlatUInt64Table& operator=(const FlatUInt64Table&) = delete;
+    inline ~FlatUInt64Table();
+
+    /**
+     * Find the object of a key.
+     *
+     * @param key           The key
+     * @param view          Set to the object if the key is found
+     *
+     * @return true if the key is found.
+     */
+    inline bool find(uint64_t key, View& view) const;
+
+    /**
+     * Insert the object of a key, or replace it. The payload is copied.
+     *
+     * @param key           The key
+     * @param version       The version of the object
+     * @param timestamp_us  The timestamp of the object
+     * @param bytes         The payload
+     * @param size          The size of the payload
+     *
+     * @throw std::bad_alloc if the payload block can not be allocated. The table is not changed.
+     */
+    inline void put(uint64_t key, int64_t version, uint64_t timestamp_us, const uint8_t* bytes, std::size_t size);
+
+    /**
+     * Erase the object of a key.
+     *
+     * @param key           The key
+     *
+     * @return true if the key was in the table.
+     */
+    inline bool erase(uint64_t key);
+
+    /**
+     * Visit all objects, in no particular order.
+     *
+     * @param visitor       Called as visitor(key, view) for each object
+     */
+    template <typename Visitor>
+    void for_each(Visitor&& visitor) const;
+
+    /**
+     * Make room for a number of keys without growing.
+     */
+    inline void reserve(std::size_t count);
+
+    /**
+     * Erase all objects.
+     */
+    inline void clear();
+
+    /**
+     * @return the number of keys.
+     */
+    inline std::size_t size() const;
+
+    /**
+     * @return the bytes used by the slots and the payload blocks.
+     */
+    inline std::size_t memory_usage() const;
+
+    /**
+     * Serialization: the number of keys, followed by the key, version, timestamp, payload size and payload of each
+     * object.
+     */
+    inline std::size_t bytes_size() const;
+    inline std::size_t to_bytes(uint8_t* buf) const;
+    /**
+     * @param buf           The buffer written by to_bytes
+     * @param table         The table to fill, which is cleared first
+     *
+     * @return the number of bytes read.
+     */
+    inline static std::size_t from_bytes(const uint8_t* buf, FlatUInt64Table& table);
+};
+
+}  // namespace cascade
+}  // namespace derecho
+
+#include "flat_uint64_table_impl.hpp"
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+namespace derecho {
+namespace cascade {
+
+uint64_t FlatUInt64Table::hash(uint64_t key) {
+    // the finalizer of splitmix64, which spreads sequential ids over the slots.
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return key;
+}
+
+uint64_t FlatUInt64Table::make_payload(const uint8_t* bytes, std::size_t size) {
+    uint64_t payload;
+    if(size <= INLINE_PAYLOAD_BYTES) {
+        uint8_t word[sizeof(uint64_t)] = {};
+        word[0] = static_cast<uint8_t>((size << 1) | 1);
+        if(size > 0) {
+            memcpy(word + 1, bytes, size);
+        }
+        memcpy(&payload, word, sizeof(payload));
+    } else {
+        // the block is aligned by malloc, so the lowest bit of its address is clear.
+        uint8_t* block = static_cast<uint8_t*>(malloc(sizeof(uint64_t) + size));
+        if(block == nullptr) {
+            throw std::bad_alloc();
+        }
+        const uint64_t block_size = size;
+        memcpy(block, &block_size, sizeof(block_size));
+        memcpy(block + sizeof(block_size), bytes, size);
+        payload = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(block));
+    }
+    return payload;
+}
+
+void FlatUInt64Table::release_payload(uint64_t payload) {
+    if((reinterpret_cast<const uint8_t*>(&payload)[0] & 1) == 0) {
+        free(reinterpret_cast<void*>(static_cast<uintptr_t>(payload)));
+    }
+}
+
+std::size_t FlatUInt64Table::payload_block_bytes(uint64_t payload) {
+    if(reinterpret_cast<const uint8_t*>(&payload)[0] & 1) {
+        return 0;
+    }
+    uint64_t block_size;
+    memcpy(&block_size, reinterpret_cast<const void*>(static_cast<uintptr_t>(payload)), sizeof(block_size));
+    return sizeof(block_size) + block_size;
+}
+
+FlatUInt64Table::View FlatUInt64Table::view_of(const Slot& slot) {
+    const uint8_t* word = reinterpret_cast<const uint8_t*>(&slot.payload);
+    if(word[0] & 1) {
+        return {slot.version, slot.timestamp_us, word + 1, static_cast<std::size_t>(word[0] >> 1)};
+    }
+    const uint8_t* block = reinterpret_cast<const uint8_t*>(static_cast<uintptr_t>(slot.payload));
+    uint64_t block_size;
+    memcpy(&block_size, block, sizeof(block_size));
+    return {slot.version, slot.timestamp_us, block + sizeof(block_size), static_cast<std::size_t>(block_size)};
+}
+
+std::size_t FlatUInt64Table::find_slot(uint64_t key) const {
+    if(slots.empty()) {
+        return 0;
+    }
+    const std::size_t mask = slots.size() - 1;
+    // the table is never full, so the probe ends at an empty slot.
+    for(std::size_t index = hash(key) & mask; slots[index].payload != 0; index = (index + 1) & mask) {
+        if(slots[index].key == key) {
+            return index;
+        }
+    }
+    return slots.size();
+}
+
+void FlatUInt64Table::rehash(std::size_t capacity) {
+    std::vector<Slot> old_slots(capacity);
+    old_slots.swap(slots);
+    const std::size_t mask = capacity - 1;
+    for(const auto& slot : old_slots) {
+        if(slot.payload != 0) {
+            std::size_t index = hash(slot.key) & mask;
+            while(slots[index].payload != 0) {
+                index = (index + 1) & mask;
+            }
+            slots[index] = slot;
+        }
+    }
+}
+
+FlatUInt64Table::FlatUInt64Table() : num_entries(0), heap_bytes(0) {}
+
+FlatUInt64Table::FlatUInt64Table(FlatUInt64Table&& other) : slots(std::move(other.slots)),
+                                                             num_entries(other.num_entries),
+                                                             heap_bytes(other.heap_bytes) {
+    other.slots.clear();
+    other.num_entries = 0;
+    other.heap_bytes = 0;
+}
+
+FlatUInt64Table& FlatUInt64Table::operator=(FlatUInt64Table&& other) {
+    if(this != &other) {
+        clear();
+        slots.swap(other.slots);
+        std::swap(num_entries, other.num_entries);
+        std::swap(heap_bytes, other.heap_bytes);
+    }
+    return *this;
+}
+
+FlatUInt64Table::~FlatUInt64Table() {
+    clear();
+}
+
+bool FlatUInt64Table::find(uint64_t key, View& view) const {
+    const std::size_t index = find_slot(key);
+    if(index >= slots.size()) {
+        return false;
+    }
+    view = view_of(slots[index]);
+    return true;
+}
+
+void FlatUInt64Table::put(uint64_t key, int64_t version, uint64_t timestamp_us, const uint8_t* bytes, std::size_t size) {
+    const uint64_t payload = make_payload(bytes, size);
+    std::size_t index = find_slot(key);
+    if(index < slots.size()) {
+        heap_bytes -= payload_block_bytes(slots[index].payload);
+        release_payload(slots[index].payload);
+    } else {
+        if((num_entries + 1) * 8 > slots.size() * 7) {
+            try {
+                rehash(std::max<std::size_t>(16, slots.size() * 2));
+            } catch(...) {
+                release_payload(payload);
+                throw;
+            }
+        }
+        const std::size_t mask = slots.size() - 1;
+        index = hash(key) & mask;
+        while(slots[index].payload != 0) {
+            index = (index + 1) & mask;
+        }
+        num_entries++;
+    }
+    slots[index] = Slot{key, version, timestamp_us, payload};
+    heap_bytes += payload_block_bytes(payload);
+}
+
+bool FlatUInt64Table::erase(uint64_t key) {
+    std::size_t hole = find_slot(key);
+    if(hole >= slots.size()) {
+        return false;
+    }
+    heap_bytes -= payload_block_bytes(slots[hole].payload);
+    release_payload(slots[hole].payload);
+    // shift back the following slots of the probe sequence whose home slot is not after the hole.
+    const std::size_t mask = slots.size() - 1;
+    for(std::size_t index = (hole + 1) & mask; slots[index].payload != 0; index = (index + 1) & mask) {
+        const std::size_t home = hash(slots[index].key) & mask;
+        if(((index - home) & mask) >= ((index - hole) & mask)) {
+            slots[hole] = slots[index];
+            hole = index;
+        }
+    }
+    slots[hole] = Slot{};
+    num_entries--;
+    return true;
+}
+
+template <typename Visitor>
+void FlatUInt64Table::for_each(Visitor&& visitor) const {
+    for(const auto& slot : slots) {
+        if(slot.payload != 0) {
+            visitor(slot.key, view_of(slot));
+        }
+    }
+}
+
+void FlatUInt64Table::reserve(std::size_t count) {
+    std::size_t capacity = std::max<std::size_t>(16, slots.size());
+    while(count * 8 > capacity * 7) {
+        capacity *= 2;
+    }
+    if(capacity > slots.size()) {
+        rehash(capacity);
+    }
+}
+
+void FlatUInt64Table::clear() {
+    for(const auto& slot : slots) {
+        if(slot.payload != 0) {
+            release_payload(slot.payload);
+        }
+    }
+    std::vector<Slot>().swap(slots);
+    num_entries = 0;
+    heap_bytes = 0;
+}
+
+std::size_t FlatUInt64Table::size() const {
+    return num_entries;
+}
+
+std::size_t FlatUInt64Table::memory_usage() const {
+    return slots.size() * sizeof(Slot) + heap_bytes;
+}
+
+std::size_t FlatUInt64Table::bytes_size() const {
+    std::size_t size = sizeof(uint64_t);
+    for_each([&size](uint64_t, const View& view) {
+        size += sizeof(uint64_t) * 4 + view.size;
+    });
+    return size;
+}
+
+std::size_t FlatUInt64Table::to_bytes(uint8_t* buf) const {
+    std::size_t offset = 0;
+    auto write_word = [buf, &offset](uint64_t word) {
+        memcpy(buf + offset, &word, sizeof(word));
+        offset += sizeof(word);
+    };
+    write_word(num_entries);
+    for_each([&](uint64_t key, const View& view) {
+        write_word(key);
+        write_word(static_cast<uint64_t>(view.version));
+        write_word(view.timestamp_us);
+        write_word(view.size);
+        if(view.size > 0) {
+            memcpy(buf + offset, view.bytes, view.size);
+        }
+        offset += view.size;
+    });
+    return offset;
+}
+
+std::size_t FlatUInt64Table::from_bytes(const uint8_t* buf, FlatUInt64Table& table) {
+    std::size_t offset = 0;
+    auto read_word = [buf, &offset]() {
+        uint64_t word;
+        memcpy(&word, buf + offset, sizeof(word));
+        offset += sizeof(word);
+        return word;
+    };
+    table.clear();
+    const uint64_t count = read_word();
+    table.reserve(count);
+    for(uint64_t i = 0; i < count; i++) {
+        const uint64_t key = read_word();
+        const int64_t version = static_cast<int64_t>(read_word());
+        const uint64_t timestamp_us = read_word();
+        const uint64_t size = read_word();
+        table.put(key, version, timestamp_us, buf + offset, size);
+        offset += size;
+    }
+    return offset;
+}
+
+}  // namespace cascade
+}  // namespace derecho
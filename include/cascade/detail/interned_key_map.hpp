@@ -0,0 +1,391 @@
+#pragma once
+
+#include <cascade/config.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * KeyPrefixTable interns the prefixes of pathname keys, i.e. the object pool pathname and the path of a key up to its
+ * last separator, like "/pool/a/b/c/" of "/pool/a/b/c/obj123". Each distinct prefix is stored once and referred to by
+ * a 32-bit id. A prefix is counted by the keys referring to it and dropped with the last one, and its id is reused.
+ *
+ * KeyPrefixTable is not thread safe.
+ */
+class KeyPrefixTable {
+private:
+    struct Prefix {
+        std::string pathname;
+        /* the number of keys referring to the prefix, 0 if the id is free */
+        uint64_t refcount;
+    };
+    /* the prefixes by id, in a deque so that the views in ids stay valid */
+    std::deque<Prefix> prefixes;
+    std::vector<uint32_t> free_ids;
+    /* the ids by prefix, viewing the pathnames in prefixes */
+    std::unordered_map<std::string_view, uint32_t> ids;
+    /* the bytes allocated for the pathnames */
+    std::size_t pathname_bytes;
+
+public:
+    inline KeyPrefixTable();
+    KeyPrefixTable(const KeyPrefixTable&) = delete;
+    KeyPrefixTable& operator=(const KeyPrefixTable&) = delete;
+
+    /**
+     * Split a pathname into its prefix, up to and including the last separator, and the rest.
+     *
+     * @return the prefix and the suffix, viewing the pathname. The prefix is empty if there is no separator.
+     */
+    inline static std::pair<std::string_view, std::string_view> split(std::string_view pathname,
+                                                                      char separator = PATH_SEPARATOR);
+
+    /**
+     * Intern a prefix, or count one more reference to it.
+     *
+     * @return the id of the prefix.
+     */
+    inline uint32_t acquire(std::string_view prefix);
+
+    /**
+     * Drop a reference to a prefix, dropping the prefix with the last one.
+     */
+    inline void release(uint32_t id);
+
+    /**
+     * Find the id of a prefix.
+     *
+     * @return true if the prefix is interned.
+     */
+    inline bool find(std::string_view prefix, uint32_t& id) const;
+
+    /**
+     * @return the prefix of an id.
+     */
+    inline const std::string& pathname(uint32_t id) const;
+
+    /**
+     * Drop all prefixes.
+     */
+    inline void clear();
+
+    /**
+     * @return the number of prefixes.
+     */
+    inline std::size_t size() const;
+
+    /**
+     * @return the approximate bytes used by the prefixes and the lookup table.
+     */
+    inline std::size_t memory_usage() const;
+};
+
+/**
+ * A key stored as the id of its prefix in a KeyPrefixTable and the rest of it. The suffix of a typical key, like
+ * "obj123", fits in the inline buffer of std::string, so the key takes no allocation of its own.
+ */
+struct InternedKey {
+    uint32_t prefix_id;
+    std::string suffix;
+
+    bool operator==(const InternedKey& other) const {
+        return prefix_id == other.prefix_id && suffix == other.suffix;
+    }
+};
+
+struct InternedKeyHash {
+    std::size_t operator()(const InternedKey& key) const {
+        return std::hash<std::string>{}(key.suffix) ^ (static_cast<std::size_t>(key.prefix_id) * 0x9e3779b97f4a7c15ull);
+    }
+};
+
+/**
+ * @return the bytes a std::string of a length allocates beyond its own object, 0 if it fits in the inline buffer.
+ */
+inline std::size_t string_heap_bytes(std::size_t length) {
+    static const std::size_t inline_capacity = std::string().capacity();
+    return (length > inline_capacity) ? length + 1 : 0;
+}
+
+/**
+ * Hash a pathname with 64-bit FNV-1a, which can be computed piece by piece, so that a key split into its prefix and
+ * suffix hashes the same as the full pathname.
+ *
+ * @param pathname  - the pathname, or the next piece of it
+ * @param seed      - the hash of the pieces before
+ */
+inline uint64_t pathname_hash(std::string_view pathname, uint64_t seed = 0xcbf29ce484222325ull) {
+    for(const char c : pathname) {
+        seed = (seed ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+    }
+    return seed;
+}
+
+/**
+ * InternedPathname is a pathname key stored as a pointer to its interned prefix, up to and including the last
+ * separator, and the rest of it. It is the key type of kv_map for pathname keys: the object pool pathname repeated
+ * in every key is kept once per process, and the suffix of a typical key, like "obj123", fits in the inline buffer of
+ * std::string.
+ *
+ * The prefixes are interned in a process-wide pool and counted by the keys referring to them. A key is interned when
+ * it is constructed from a std::string, which takes the lock of the pool; copying a key only counts one more
+ * reference, so a key is interned once when it is put the first time. An InternedPathname compares, in the order of
+ * the full pathnames, with another one and with a std::string, so that a map keyed by InternedPathname with
+ * std::less<> is looked up by std::string without materializing a key. It converts to a std::string implicitly.
+ */
+class InternedPathname {
+private:
+    struct Prefix {
+        std::string pathname;
+        /* the number of keys referring to the prefix */
+        mutable std::atomic<uint64_t> refcount;
+        /* the hash of the prefix */
+        uint64_t hash;
+    };
+    struct PrefixPool;
+
+    /* the prefix, nullptr if the pathname has no separator */
+    const Prefix* prefix;
+    std::string suffix;
+    /* a flag the container of the key may set on its stored copy, which is neither compared nor copied */
+    mutable bool mark = false;
+
+    inline static PrefixPool& pool();
+    inline static const Prefix* acquire(std::string_view pathname);
+    inline static void release(const Prefix* prefix);
+
+public:
+    InternedPathname() : prefix(nullptr) {}
+    inline InternedPathname(const std::string& pathname);
+    inline InternedPathname(const InternedPathname& other);
+    inline InternedPathname(InternedPathname&& other) noexcept;
+    inline InternedPathname& operator=(const InternedPathname& other);
+    inline InternedPathname& operator=(InternedPathname&& other) noexcept;
+    inline ~InternedPathname();
+
+    /**
+     * @return the full pathname.
+     */
+    inline std::string str() const;
+    operator std::string() const { return str(); }
+    std::string_view get_prefix() const { return prefix ? std::string_view(prefix->pathname) : std::string_view{}; }
+    const std::string& get_suffix() const { return suffix; }
+    std::size_t size() const { return get_prefix().size() + suffix.size(); }
+    bool empty() const { return size() == 0; }
+    /**
+     * Compare with a pathname, like std::string::compare.
+     */
+    inline int compare(std::string_view other) const;
+    int compare(const std::string& other) const { return compare(std::string_view(other)); }
+    inline int compare(const InternedPathname& other) const;
+    /**
+     * @return true if the pathname starts with `head`.
+     */
+    inline bool starts_with(std::string_view head) const;
+    /**
+     * @return the same hash as pathname_hash() of the full pathname.
+     */
+    uint64_t hash() const { return pathname_hash(suffix, prefix ? prefix->hash : pathname_hash({})); }
+    /**
+     * @return the bytes the key allocates beyond its own object, not counting its shared prefix.
+     */
+    std::size_t heap_bytes() const { return string_heap_bytes(suffix.size()); }
+    /**
+     * The mark is not part of the pathname, so it can be set on a key stored in an ordered container, like the CLOCK
+     * reference bit of the keys in an object pool with a memory budget. A copy of a key is not marked.
+     */
+    bool is_marked() const { return mark; }
+    void set_mark(bool marked) const { mark = marked; }
+    /**
+     * @return an id of the interned prefix, shared by all keys with the same prefix, 0 if there is no prefix.
+     */
+    uintptr_t prefix_id() const { return reinterpret_cast<uintptr_t>(prefix); }
+    /**
+     * @return the bytes the process-wide pool takes for an interned prefix of a length.
+     */
+    static std::size_t prefix_bytes(std::size_t length) {
+        return sizeof(Prefix) + string_heap_bytes(length) + sizeof(std::pair<const std::string_view, Prefix*>)
+               + 2 * sizeof(void*);
+    }
+
+    friend bool operator==(const InternedPathname& lhs, const InternedPathname& rhs) {
+        return lhs.prefix == rhs.prefix ? lhs.suffix == rhs.suffix : lhs.compare(rhs) == 0;
+    }
+    friend bool operator==(const InternedPathname& lhs, const std::string& rhs) { return lhs.compare(rhs) == 0; }
+    friend bool operator==(const std::string& lhs, const InternedPathname& rhs) { return rhs.compare(lhs) == 0; }
+    friend bool operator!=(const InternedPathname& lhs, const InternedPathname& rhs) { return !(lhs == rhs); }
+    friend bool operator!=(const InternedPathname& lhs, const std::string& rhs) { return !(lhs == rhs); }
+    friend bool operator!=(const std::string& lhs, const InternedPathname& rhs) { return !(lhs == rhs); }
+    friend bool operator<(const InternedPathname& lhs, const InternedPathname& rhs) { return lhs.compare(rhs) < 0; }
+    friend bool operator<(const InternedPathname& lhs, const std::string& rhs) { return lhs.compare(rhs) < 0; }
+    friend bool operator<(const std::string& lhs, const InternedPathname& rhs) { return rhs.compare(lhs) > 0; }
+    friend std::ostream& operator<<(std::ostream& out, const InternedPathname& pathname) {
+        return out << pathname.get_prefix() << pathname.suffix;
+    }
+};
+
+/**
+ * The type a key of type KT is stored as in kv_map: an InternedPathname for pathname keys, and KT for the others.
+ */
+template <typename KT>
+struct stored_key {
+    using type = KT;
+};
+template <>
+struct stored_key<std::string> {
+    using type = InternedPathname;
+};
+template <typename KT>
+using stored_key_t = typename stored_key<KT>::type;
+
+/**
+ * The type of kv_map, the state of a shard as an ordered map from keys to objects. Pathname keys are stored as
+ * InternedPathname, which is looked up by std::string through std::less<>; the other keys are stored as they are.
+ *
+ * @tparam KT   - the key type
+ * @tparam VT   - the value type
+ */
+template <typename KT, typename VT>
+using key_value_map_t = std::conditional_t<std::is_same_v<stored_key_t<KT>, KT>,
+                                           std::map<KT, VT>,
+                                           std::map<stored_key_t<KT>, VT, std::less<>>>;
+
+/**
+ * InternedKeyMap is an unordered map by key for the per-key indices kept next to kv_map, e.g. the version index of the
+ * persistent stores. With pathname keys, it stores each key as an InternedKey instead of a copy of the pathname, so
+ * that the object pool pathname repeated in every key is kept once. Other key types are stored as they are.
+ *
+ * The map is looked up and updated by the full key. Iterating it gives the stored keys, whose full key is
+ * materialized by key_of(). Like std::unordered_map, it is not thread safe.
+ *
+ * @tparam KT           - the key type
+ * @tparam T            - the mapped type
+ * @tparam interned     - if the keys are interned, which is the case for keys convertible to std::string
+ */
+template <typename KT, typename T, bool interned = std::is_convertible_v<KT, std::string>>
+class InternedKeyMap {
+public:
+    using key_type = KT;
+    using map_type = std::unordered_map<KT, T>;
+    using iterator = typename map_type::iterator;
+    using const_iterator = typename map_type::const_iterator;
+
+private:
+    map_type entries;
+
+public:
+    iterator find(const KT& key) { return entries.find(key); }
+    const_iterator find(const KT& key) const { return entries.find(key); }
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const KT& key, Args&&... args) {
+        return entries.try_emplace(key, std::forward<Args>(args)...);
+    }
+    std::size_t erase(const KT& key) { return entries.erase(key); }
+    void clear() { entries.clear(); }
+    std::size_t size() const { return entries.size(); }
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.cbegin(); }
+    const_iterator end() const { return entries.cend(); }
+    const_iterator cbegin() const { return entries.cbegin(); }
+    const_iterator cend() const { return entries.cend(); }
+    const KT& key_of(const key_type& key) const { return key; }
+    /**
+     * @return "keys", "key_bytes", the bytes the keys take as they are, and "stored_key_bytes", the bytes the keys
+     *         take in this map, which are the same for keys that are not interned.
+     */
+    std::map<std::string, uint64_t> get_key_memory_stats() const {
+        const uint64_t key_bytes = entries.size() * sizeof(KT);
+        return {{"keys", entries.size()}, {"key_bytes", key_bytes}, {"stored_key_bytes", key_bytes}};
+    }
+};
+
+template <typename KT, typename T>
+class InternedKeyMap<KT, T, true> {
+public:
+    using key_type = InternedKey;
+    using map_type = std::unordered_map<InternedKey, T, InternedKeyHash>;
+    using iterator = typename map_type::iterator;
+    using const_iterator = typename map_type::const_iterator;
+
+private:
+    KeyPrefixTable prefix_table;
+    map_type entries;
+    /* the bytes the keys would take as full pathnames */
+    uint64_t key_bytes;
+    /* the bytes allocated for the suffixes */
+    uint64_t suffix_bytes;
+
+    /**
+     * Find the stored key of a key.
+     *
+     * @return false if the prefix of the key is not interned, so the key is not in the map.
+     */
+    inline bool lookup_key(const KT& key, InternedKey& interned_key) const;
+
+public:
+    inline InternedKeyMap();
+    InternedKeyMap(const InternedKeyMap&) = delete;
+    InternedKeyMap& operator=(const InternedKeyMap&) = delete;
+
+    inline iterator find(const KT& key);
+    inline const_iterator find(const KT& key) const;
+    /**
+     * Insert a key with a value constructed from args, if the key is not in the map.
+     *
+     * @return the entry of the key, and true if it is inserted.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const KT& key, Args&&... args);
+    inline std::size_t erase(const KT& key);
+    inline void clear();
+    std::size_t size() const { return entries.size(); }
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.cbegin(); }
+    const_iterator end() const { return entries.cend(); }
+    const_iterator cbegin() const { return entries.cbegin(); }
+    const_iterator cend() const { return entries.cend(); }
+    /**
+     * Materialize the full key of a stored key.
+     */
+    inline KT key_of(const key_type& key) const;
+    /**
+     * @return the interned prefix of a stored key, which is shared by all keys with the same prefix_id.
+     */
+    const std::string& prefix_of(const key_type& key) const { return prefix_table.pathname(key.prefix_id); }
+    /**
+     * @return "keys", "prefixes", "key_bytes", the bytes the keys would take as full pathnames including their
+     *         std::string objects, and "stored_key_bytes", the bytes the keys take in this map including the
+     *         prefix table.
+     */
+    inline std::map<std::string, uint64_t> get_key_memory_stats() const;
+};
+
+}  // namespace cascade
+}  // namespace derecho
+
+namespace std {
+template <>
+struct hash<derecho::cascade::InternedPathname> {
+    std::size_t operator()(const derecho::cascade::InternedPathname& pathname) const {
+        return static_cast<std::size_t>(pathname.hash());
+    }
+};
+}  // namespace std
+
+#include "interned_key_map_impl.hpp"
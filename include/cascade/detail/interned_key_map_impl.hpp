@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+
+namespace derecho {
+namespace cascade {
+
+KeyPrefixTable::KeyPrefixTable() : pathname_bytes(0) {}
+
+std::pair<std::string_view, std::string_view> KeyPrefixTable::split(std::string_view pathname, char separator) {
+    const std::size_t pos = pathname.rfind(separator);
+    if(pos == std::string_view::npos) {
+        return {std::string_view{}, pathname};
+    }
+    return {pathname.substr(0, pos + 1), pathname.substr(pos + 1)};
+}
+
+uint32_t KeyPrefixTable::acquire(std::string_view prefix) {
+    auto it = ids.find(prefix);
+    if(it != ids.end()) {
+        prefixes[it->second].refcount++;
+        return it->second;
+    }
+    uint32_t id;
+    if(free_ids.empty()) {
+        id = static_cast<uint32_t>(prefixes.size());
+        prefixes.push_back(Prefix{std::string(prefix), 1});
+    } else {
+        id = free_ids.back();
+        free_ids.pop_back();
+        prefixes[id] = Prefix{std::string(prefix), 1};
+    }
+    // the view must be taken from the stored pathname, which does not move.
+    ids.emplace(std::string_view(prefixes[id].pathname), id);
+    pathname_bytes += string_heap_bytes(prefix.size());
+    return id;
+}
+
+void KeyPrefixTable::release(uint32_t id) {
+    assert(id < prefixes.size() && prefixes[id].refcount > 0);
+    if(--prefixes[id].refcount == 0) {
+        ids.erase(std::string_view(prefixes[id].pathname));
+        pathname_bytes -= string_heap_bytes(prefixes[id].pathname.size());
+        std::string().swap(prefixes[id].pathname);
+        free_ids.push_back(id);
+    }
+}
+
+bool KeyPrefixTable::find(std::string_view prefix, uint32_t& id) const {
+    auto it = ids.find(prefix);
+    if(it == ids.end()) {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
+
+const std::string& KeyPrefixTable::pathname(uint32_t id) const {
+    return prefixes[id].pathname;
+}
+
+void KeyPrefixTable::clear() {
+    ids.clear();
+    prefixes.clear();
+    free_ids.clear();
+    pathname_bytes = 0;
+}
+
+std::size_t KeyPrefixTable::size() const {
+    return ids.size();
+}
+
+std::size_t KeyPrefixTable::memory_usage() const {
+    // a lookup entry is a node of a view and an id, plus a bucket pointer.
+    return prefixes.size() * sizeof(Prefix) + pathname_bytes + free_ids.capacity() * sizeof(uint32_t)
+           + ids.size() * (sizeof(std::pair<const std::string_view, uint32_t>) + sizeof(void*))
+           + ids.bucket_count() * sizeof(void*);
+}
+
+struct InternedPathname::PrefixPool {
+    std::mutex mutex;
+    /* the prefixes by pathname, viewing the pathnames in the prefixes */
+    std::unordered_map<std::string_view, Prefix*> prefixes;
+};
+
+InternedPathname::PrefixPool& InternedPathname::pool() {
+    // never destroyed, since keys may be released by other static objects at exit.
+    static PrefixPool* prefix_pool = new PrefixPool();
+    return *prefix_pool;
+}
+
+const InternedPathname::Prefix* InternedPathname::acquire(std::string_view pathname) {
+    if(pathname.empty()) {
+        return nullptr;
+    }
+    PrefixPool& prefix_pool = pool();
+    std::lock_guard<std::mutex> lock(prefix_pool.mutex);
+    auto it = prefix_pool.prefixes.find(pathname);
+    if(it != prefix_pool.prefixes.end()) {
+        uint64_t refcount = it->second->refcount.load(std::memory_order_relaxed);
+        while(refcount > 0
+              && !it->second->refcount.compare_exchange_weak(refcount, refcount + 1, std::memory_order_relaxed)) {
+        }
+        if(refcount > 0) {
+            return it->second;
+        }
+        // the last key referring to the prefix is being destroyed, which deletes the prefix once it is replaced here.
+        prefix_pool.prefixes.erase(it);
+    }
+    Prefix* prefix = new Prefix{std::string(pathname), {1}, pathname_hash(pathname)};
+    prefix_pool.prefixes.emplace(std::string_view(prefix->pathname), prefix);
+    return prefix;
+}
+
+void InternedPathname::release(const Prefix* prefix) {
+    if(prefix == nullptr || prefix->refcount.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    PrefixPool& prefix_pool = pool();
+    {
+        std::lock_guard<std::mutex> lock(prefix_pool.mutex);
+        auto it = prefix_pool.prefixes.find(std::string_view(prefix->pathname));
+        if(it != prefix_pool.prefixes.end() && it->second == prefix) {
+            prefix_pool.prefixes.erase(it);
+        }
+    }
+    delete prefix;
+}
+
+InternedPathname::InternedPathname(const std::string& pathname) : prefix(nullptr) {
+    auto parts = KeyPrefixTable::split(pathname);
+    prefix = acquire(parts.first);
+    suffix.assign(parts.second.data(), parts.second.size());
+}
+
+InternedPathname::InternedPathname(const InternedPathname& other) : prefix(other.prefix), suffix(other.suffix) {
+    if(prefix != nullptr) {
+        prefix->refcount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+InternedPathname::InternedPathname(InternedPathname&& other) noexcept
+        : prefix(other.prefix), suffix(std::move(other.suffix)) {
+    other.prefix = nullptr;
+}
+
+InternedPathname& InternedPathname::operator=(const InternedPathname& other) {
+    if(this != &other) {
+        *this = InternedPathname(other);
+    }
+    return *this;
+}
+
+InternedPathname& InternedPathname::operator=(InternedPathname&& other) noexcept {
+    if(this != &other) {
+        release(prefix);
+        prefix = other.prefix;
+        other.prefix = nullptr;
+        suffix = std::move(other.suffix);
+    }
+    return *this;
+}
+
+InternedPathname::~InternedPathname() {
+    release(prefix);
+}
+
+std::string InternedPathname::str() const {
+    std::string pathname;
+    pathname.reserve(size());
+    pathname.append(get_prefix()).append(suffix);
+    return pathname;
+}
+
+int InternedPathname::compare(std::string_view other) const {
+    const std::string_view head = get_prefix();
+    const std::size_t length = std::min(head.size(), other.size());
+    const int result = head.substr(0, length).compare(other.substr(0, length));
+    if(result != 0) {
+        return result;
+    }
+    if(other.size() < head.size()) {
+        return 1;
+    }
+    return std::string_view(suffix).compare(other.substr(head.size()));
+}
+
+int InternedPathname::compare(const InternedPathname& other) const {
+    if(prefix == other.prefix) {
+        return suffix.compare(other.suffix);
+    }
+    // walk both pathnames piece by piece.
+    std::string_view lhs[2] = {get_prefix(), suffix};
+    std::string_view rhs[2] = {other.get_prefix(), other.suffix};
+    std::size_t i = 0, j = 0;
+    while(true) {
+        while(i < 2 && lhs[i].empty()) {
+            i++;
+        }
+        while(j < 2 && rhs[j].empty()) {
+            j++;
+        }
+        if(i == 2 || j == 2) {
+            return (i == 2 ? 0 : 1) - (j == 2 ? 0 : 1);
+        }
+        const std::size_t length = std::min(lhs[i].size(), rhs[j].size());
+        const int result = lhs[i].substr(0, length).compare(rhs[j].substr(0, length));
+        if(result != 0) {
+            return result;
+        }
+        lhs[i].remove_prefix(length);
+        rhs[j].remove_prefix(length);
+    }
+}
+
+bool InternedPathname::starts_with(std::string_view head) const {
+    const std::string_view prefix_view = get_prefix();
+    if(head.size() <= prefix_view.size()) {
+        return prefix_view.substr(0, head.size()) == head;
+    }
+    return prefix_view == head.substr(0, prefix_view.size())
+           && std::string_view(suffix).substr(0, head.size() - prefix_view.size()) == head.substr(prefix_view.size());
+}
+
+template <typename KT, typename T>
+InternedKeyMap<KT, T, true>::InternedKeyMap() : key_bytes(0), suffix_bytes(0) {}
+
+template <typename KT, typename T>
+bool InternedKeyMap<KT, T, true>::lookup_key(const KT& key, InternedKey& interned_key) const {
+    const std::string& pathname = key;
+    auto parts = KeyPrefixTable::split(pathname);
+    if(!prefix_table.find(parts.first, interned_key.prefix_id)) {
+        return false;
+    }
+    interned_key.suffix.assign(parts.second.data(), parts.second.size());
+    return true;
+}
+
+template <typename KT, typename T>
+typename InternedKeyMap<KT, T, true>::iterator InternedKeyMap<KT, T, true>::find(const KT& key) {
+    InternedKey interned_key;
+    if(!lookup_key(key, interned_key)) {
+        return entries.end();
+    }
+    return entries.find(interned_key);
+}
+
+template <typename KT, typename T>
+typename InternedKeyMap<KT, T, true>::const_iterator InternedKeyMap<KT, T, true>::find(const KT& key) const {
+    InternedKey interned_key;
+    if(!lookup_key(key, interned_key)) {
+        return entries.cend();
+    }
+    return entries.find(interned_key);
+}
+
+template <typename KT, typename T>
+template <typename... Args>
+std::pair<typename InternedKeyMap<KT, T, true>::iterator, bool> InternedKeyMap<KT, T, true>::try_emplace(
+        const KT& key, Args&&... args) {
+    const std::string& pathname = key;
+    auto parts = KeyPrefixTable::split(pathname);
+    InternedKey interned_key{prefix_table.acquire(parts.first), std::string(parts.second)};
+    auto ret = entries.try_emplace(std::move(interned_key), std::forward<Args>(args)...);
+    if(ret.second) {
+        key_bytes += sizeof(std::string) + string_heap_bytes(pathname.size());
+        suffix_bytes += string_heap_bytes(parts.second.size());
+    } else {
+        prefix_table.release(ret.first->first.prefix_id);
+    }
+    return ret;
+}
+
+template <typename KT, typename T>
+std::size_t InternedKeyMap<KT, T, true>::erase(const KT& key) {
+    InternedKey interned_key;
+    if(!lookup_key(key, interned_key) || entries.erase(interned_key) == 0) {
+        return 0;
+    }
+    const std::string& pathname = key;
+    key_bytes -= sizeof(std::string) + string_heap_bytes(pathname.size());
+    suffix_bytes -= string_heap_bytes(interned_key.suffix.size());
+    prefix_table.release(interned_key.prefix_id);
+    return 1;
+}
+
+template <typename KT, typename T>
+void InternedKeyMap<KT, T, true>::clear() {
+    entries.clear();
+    prefix_table.clear();
+    key_bytes = 0;
+    suffix_bytes = 0;
+}
+
+template <typename KT, typename T>
+KT InternedKeyMap<KT, T, true>::key_of(const key_type& key) const {
+    const std::string& prefix = prefix_table.pathname(key.prefix_id);
+    std::string pathname;
+    pathname.reserve(prefix.size() + key.suffix.size());
+    pathname.append(prefix).append(key.suffix);
+    return KT(std::move(pathname));
+}
+
+template <typename KT, typename T>
+std::map<std::string, uint64_t> InternedKeyMap<KT, T, true>::get_key_memory_stats() const {
+    return {{"keys", entries.size()},
+            {"prefixes", prefix_table.size()},
+            {"key_bytes", key_bytes},
+            {"stored_key_bytes", entries.size() * sizeof(InternedKey) + suffix_bytes + prefix_table.memory_usage()}};
+}
+
+}  // namespace cascade
+}  // namespace derecho
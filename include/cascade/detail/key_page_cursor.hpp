@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * KeyPageCursor is the continuation cursor of list_keys_paged, i.e. the version a listing is consistent at and the
+ * last key returned so far. It is encoded as "<version>:<key>", with integer keys in decimal. Clients pass the
+ * encoded cursor back as it is.
+ *
+ * @tparam KT   - the key type, convertible to std::string or an unsigned integer
+ */
+template <typename KT>
+struct KeyPageCursor {
+    int64_t version;
+    KT last_key;
+
+    /**
+     * @return the encoded cursor.
+     */
+    std::string encode() const {
+        std::string cursor = std::to_string(version);
+        cursor.push_back(':');
+        if constexpr(std::is_convertible_v<KT, std::string>) {
+            const std::string& key = last_key;
+            cursor.append(key);
+        } else {
+            cursor.append(std::to_string(last_key));
+        }
+        return cursor;
+    }
+
+    /**
+     * Decode a cursor.
+     *
+     * @param encoded   - the encoded cursor
+     * @param cursor    - the decoded cursor
+     *
+     * @return false if the cursor is malformed.
+     */
+    static bool decode(const std::string& encoded, KeyPageCursor& cursor) {
+        const std::size_t colon = encoded.find(':');
+        if(colon == std::string::npos || colon == 0) {
+            return false;
+        }
+        char* end = nullptr;
+        errno = 0;
+        cursor.version = std::strtoll(encoded.c_str(), &end, 10);
+        if(end != encoded.c_str() + colon || errno == ERANGE) {
+            return false;
+        }
+        if constexpr(std::is_convertible_v<KT, std::string>) {
+            cursor.last_key = KT(encoded.substr(colon + 1));
+        } else {
+            const char* key_begin = encoded.c_str() + colon + 1;
+            if(*key_begin < '0' || *key_begin > '9') {
+                return false;
+            }
+            errno = 0;
+            const unsigned long long key = std::strtoull(key_begin, &end, 10);
+            if(*end != '\0' || errno == ERANGE) {
+                return false;
+            }
+            cursor.last_key = static_cast<KT>(key);
+        }
+        return true;
+    }
+};
+
+}  // namespace cascade
+}  // namespace derecho
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "interned_key_map.hpp"
+
+#include <derecho/mutils-serialization/SerializationSupport.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * Get the object of a key in kv_map like std::map::at, but looked up by the key as it is, so a pathname key is not
+ * interned for the lookup.
+ *
+ * @throw std::out_of_range if the key is not in kv_map.
+ */
+template <typename Map, typename Key>
+auto& key_value_map_at(Map& kv_map, const Key& key) {
+    auto it = kv_map.find(key);
+    if(it == kv_map.end()) {
+        throw std::out_of_range("the key is not in kv_map.");
+    }
+    return it->second;
+}
+
+/**
+ * Extract the node of a key from kv_map like std::map::extract, but looked up by the key as it is.
+ *
+ * @return the node, or an empty node if the key is not in kv_map.
+ */
+template <typename Map, typename Key>
+typename Map::node_type key_value_map_extract(Map& kv_map, const Key& key) {
+    auto it = kv_map.find(key);
+    if(it == kv_map.end()) {
+        return typename Map::node_type{};
+    }
+    return kv_map.extract(it);
+}
+
+/**
+ * kv_map is serialized as a std::map<KT, VT>, so the wire format does not depend on how the keys are stored. mutils
+ * serializes a map as the number of its entries followed by the entries, so the header is taken from an empty map.
+ *
+ * @return the size of the header.
+ */
+template <typename KT, typename VT>
+std::size_t key_value_map_header(std::size_t num_entries, uint8_t* buf) {
+    const std::size_t header_size = mutils::to_bytes(std::map<KT, VT>{}, buf);
+    if(header_size == sizeof(uint32_t)) {
+        const uint32_t count = static_cast<uint32_t>(num_entries);
+        std::memcpy(buf, &count, sizeof(count));
+    } else if(header_size == sizeof(uint64_t)) {
+        const uint64_t count = static_cast<uint64_t>(num_entries);
+        std::memcpy(buf, &count, sizeof(count));
+    } else {
+        throw std::logic_error("unknown header size " + std::to_string(header_size) + " of a serialized std::map.");
+    }
+    return header_size;
+}
+
+/**
+ * @return the serialized size of kv_map, which is the same as the std::map<KT, VT> it stores.
+ */
+template <typename KT, typename VT>
+std::size_t key_value_map_bytes_size(const key_value_map_t<KT, VT>& kv_map) {
+    if constexpr(std::is_same_v<stored_key_t<KT>, KT>) {
+        return mutils::bytes_size(kv_map);
+    } else {
+        // a serialized string takes the same bytes as the empty string plus its characters.
+        const std::size_t empty_key_size = mutils::bytes_size(std::string{});
+        std::size_t size = mutils::bytes_size(std::map<KT, VT>{});
+        for(const auto& kv : kv_map) {
+            size += empty_key_size + kv.first.size() + mutils::bytes_size(kv.second);
+        }
+        return size;
+    }
+}
+
+/**
+ * Serialize kv_map as the std::map<KT, VT> it stores.
+ *
+ * @return the serialized size.
+ */
+template <typename KT, typename VT>
+std::size_t key_value_map_to_bytes(const key_value_map_t<KT, VT>& kv_map, uint8_t* buf) {
+    if constexpr(std::is_same_v<stored_key_t<KT>, KT>) {
+        return mutils::to_bytes(kv_map, buf);
+    } else {
+        std::size_t offset = key_value_map_header<KT, VT>(kv_map.size(), buf);
+        for(const auto& kv : kv_map) {
+            offset += mutils::to_bytes(KT(kv.first), buf + offset);
+            offset += mutils::to_bytes(kv.second, buf + offset);
+        }
+        return offset;
+    }
+}
+
+/**
+ * Post kv_map serialized as the std::map<KT, VT> it stores.
+ */
+template <typename KT, typename VT>
+void key_value_map_post_object(const std::function<void(uint8_t const* const, std::size_t)>& f,
+                               const key_value_map_t<KT, VT>& kv_map) {
+    if constexpr(std::is_same_v<stored_key_t<KT>, KT>) {
+        mutils::post_object(f, kv_map);
+    } else {
+        uint8_t header[sizeof(uint64_t) * 2];
+        if(mutils::bytes_size(std::map<KT, VT>{}) > sizeof(header)) {
+            throw std::logic_error("the header of a serialized std::map is too large.");
+        }
+        f(header, key_value_map_header<KT, VT>(kv_map.size(), header));
+        for(const auto& kv : kv_map) {
+            mutils::post_object(f, KT(kv.first));
+            mutils::post_object(f, kv.second);
+        }
+    }
+}
+
+/**
+ * Convert a deserialized std::map<KT, VT> to kv_map, moving the objects.
+ */
+template <typename KT, typename VT>
+key_value_map_t<KT, VT> to_key_value_map(std::map<KT, VT>&& map) {
+    if constexpr(std::is_same_v<stored_key_t<KT>, KT>) {
+        return std::move(map);
+    } else {
+        key_value_map_t<KT, VT> kv_map;
+        while(!map.empty()) {
+            auto node = map.extract(map.begin());
+            // the stored keys are in the same order as the full keys.
+            kv_map.emplace_hint(kv_map.end(), stored_key_t<KT>(node.key()), std::move(node.mapped()));
+        }
+        return kv_map;
+    }
+}
+
+/**
+ * Convert a std::map<KT, VT> to kv_map, copying the objects.
+ */
+template <typename KT, typename VT>
+key_value_map_t<KT, VT> to_key_value_map(const std::map<KT, VT>& map) {
+    if constexpr(std::is_same_v<stored_key_t<KT>, KT>) {
+        return map;
+    } else {
+        key_value_map_t<KT, VT> kv_map;
+        for(const auto& kv : map) {
+            kv_map.emplace_hint(kv_map.end(), stored_key_t<KT>(kv.first), kv.second);
+        }
+        return kv_map;
+    }
+}
+
+/**
+ * Account the memory used by the keys of kv_map, added one by one as they are stored. An interned prefix is counted
+ * once, by the first key using it.
+ */
+template <typename KT>
+class KeyMemoryStats {
+private:
+    uint64_t keys = 0;
+    uint64_t key_bytes = 0;
+    uint64_t stored_key_bytes = 0;
+    std::unordered_set<uintptr_t> prefixes;
+
+public:
+    void add(const stored_key_t<KT>& key) {
+        keys++;
+        if constexpr(std::is_same_v<stored_key_t<KT>, KT>) {
+            key_bytes += sizeof(KT);
+            stored_key_bytes += sizeof(KT);
+        } else {
+            key_bytes += sizeof(KT) + string_heap_bytes(key.size());
+            stored_key_bytes += sizeof(key) + key.heap_bytes();
+            if(key.prefix_id() != 0 && prefixes.insert(key.prefix_id()).second) {
+                stored_key_bytes += stored_key_t<KT>::prefix_bytes(key.get_prefix().size());
+            }
+        }
+    }
+    /**
+     * @return "keys", "prefixes", "key_bytes", the bytes the keys would take as full keys, and "stored_key_bytes",
+     *         the bytes they take as stored, including their prefixes.
+     */
+    std::map<std::string, uint64_t> get() const {
+        return {{"keys", keys},
+                {"prefixes", prefixes.size()},
+                {"key_bytes", key_bytes},
+                {"stored_key_bytes", stored_key_bytes}};
+    }
+};
+
+}  // namespace cascade
+}  // namespace derecho
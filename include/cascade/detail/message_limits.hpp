@@ -0,0 +1,58 @@
+#pragma once
+
+#include <derecho/conf/conf.hpp>
+
+#include <cstdint>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * The bytes reserved in a derecho message for the RPC header and the fields around a serialized payload.
+ */
+#define CASCADE_MESSAGE_HEADER_RESERVE          (256)
+/**
+ * The message size derecho falls back to when the configuration does not set it.
+ */
+#define CASCADE_MESSAGE_SIZE_FALLBACK           (10240)
+
+/**
+ * Get the room for the serialized return value of a P2P RPC, derived from DERECHO/max_p2p_reply_payload_size. A reply
+ * larger than the limit can not be sent, so RPCs returning a variable amount of data stop at this budget.
+ *
+ * @return the budget in bytes.
+ */
+inline uint64_t p2p_reply_payload_budget() {
+    const uint64_t size = derecho::hasCustomizedConfKey(CONF_DERECHO_MAX_P2P_REPLY_PAYLOAD_SIZE)
+                                  ? derecho::getConfUInt64(CONF_DERECHO_MAX_P2P_REPLY_PAYLOAD_SIZE)
+                                  : CASCADE_MESSAGE_SIZE_FALLBACK;
+    return size > 2 * CASCADE_MESSAGE_HEADER_RESERVE ? size - CASCADE_MESSAGE_HEADER_RESERVE : size / 2;
+}
+
+/**
+ * Get the room for the serialized arguments of a P2P RPC, derived from DERECHO/max_p2p_request_payload_size.
+ *
+ * @return the budget in bytes.
+ */
+inline uint64_t p2p_request_payload_budget() {
+    const uint64_t size = derecho::hasCustomizedConfKey(CONF_DERECHO_MAX_P2P_REQUEST_PAYLOAD_SIZE)
+                                  ? derecho::getConfUInt64(CONF_DERECHO_MAX_P2P_REQUEST_PAYLOAD_SIZE)
+                                  : CASCADE_MESSAGE_SIZE_FALLBACK;
+    return size > 2 * CASCADE_MESSAGE_HEADER_RESERVE ? size - CASCADE_MESSAGE_HEADER_RESERVE : size / 2;
+}
+
+/**
+ * Get the room for the serialized arguments of an ordered RPC, derived from SUBGROUP/DEFAULT/max_payload_size. A
+ * subgroup with its own profile must not set a smaller limit than the default one.
+ *
+ * @return the budget in bytes.
+ */
+inline uint64_t ordered_payload_budget() {
+    const uint64_t size = derecho::hasCustomizedConfKey(CONF_SUBGROUP_DEFAULT_MAX_PAYLOAD_SIZE)
+                                  ? derecho::getConfUInt64(CONF_SUBGROUP_DEFAULT_MAX_PAYLOAD_SIZE)
+                                  : CASCADE_MESSAGE_SIZE_FALLBACK;
+    return size > 2 * CASCADE_MESSAGE_HEADER_RESERVE ? size - CASCADE_MESSAGE_HEADER_RESERVE : size / 2;
+}
+
+}  // namespace cascade
+}  // namespace derecho
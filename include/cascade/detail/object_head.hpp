@@ -0,0 +1,50 @@
+#pragma once
+
+#include "cascade/cascade_interface.hpp"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * Read the metadata of an object without copying its payload. The version, timestamp and previous versions are read
+ * if VT implements IKeepVersion, IKeepTimestamp and IKeepPreviousVersion respectively. The payload size is read from
+ * the payload interfaces of VT, or is the serialized size of the object if VT implements none of them.
+ *
+ * @tparam VT           - the object type
+ * @param  value        - the object
+ * @param  image_size   - the size of the payload image if the object holds a patch of it, or -1
+ *
+ * @return the metadata of the object.
+ */
+template <typename VT>
+ObjectHead make_object_head(const VT& value, int64_t image_size = -1) {
+    ObjectHead head;
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        head.version = value.get_version();
+    }
+    if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+        head.timestamp_us = value.get_timestamp();
+    }
+    if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+        head.previous_version = value.previous_version;
+        head.previous_version_by_key = value.previous_version_by_key;
+    }
+    head.is_null = value.is_null();
+    if(head.is_null) {
+        head.payload_size = 0;
+    } else if(image_size >= 0) {
+        head.payload_size = static_cast<uint64_t>(image_size);
+    } else if constexpr(std::is_base_of<IMergePayload, VT>::value || std::is_base_of<IPatchPayload, VT>::value
+                        || std::is_base_of<IExternalPayload, VT>::value) {
+        head.payload_size = value.get_payload_size();
+    } else {
+        head.payload_size = mutils::bytes_size(value);
+    }
+    return head;
+}
+
+}  // namespace cascade
+}  // namespace derecho
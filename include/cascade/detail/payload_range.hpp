@@ -0,0 +1,40 @@
+#pragma once
+
+#include "cascade/cascade_interface.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * Keep only a byte range of the payload of an object, clipped to the end of the payload. A range starting past the end
+ * of the payload is empty. If VT implements ISharePayload and the payload is shared, the range is a slice that pins
+ * the payload instead of a copy. Objects of types without a payload interface, and null objects, are left as they
+ * are.
+ *
+ * @tparam VT           - the object type
+ * @param  value        - the object
+ * @param  offset       - the offset of the range
+ * @param  length       - the length of the range
+ */
+template <typename VT>
+void slice_payload(VT& value, uint64_t offset, uint64_t length) {
+    if(value.is_null()) {
+        return;
+    }
+    if constexpr(std::is_base_of<IPatchPayload, VT>::value) {
+        const uint64_t size = value.get_payload_size();
+        offset = std::min(offset, size);
+        value.trim_payload(offset, std::min(length, size - offset));
+    } else if constexpr(std::is_base_of<IMergePayload, VT>::value) {
+        const uint64_t size = value.get_payload_size();
+        offset = std::min(offset, size);
+        value.set_payload(value.get_payload_bytes() + offset, std::min(length, size - offset));
+    }
+}
+
+}  // namespace cascade
+}  // namespace derecho
@@ -9,9 +9,16 @@
 #include <derecho/conf/conf.hpp>
 #include <derecho/persistent/PersistentInterface.hpp>
 #include <derecho/persistent/detail/PersistLog.hpp>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <map>
 #include <memory>
+#include <optional>
+#include <set>
 #include <string>
 #include <tuple>
 #include <type_traits>
@@ -54,6 +61,38 @@ void PersistentCascadeStore<KT, VT, IK, IV, ST>::put_and_forget(const VT& value,
     debug_leave_func();
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::put_batch(const std::vector<VT>& values, bool as_trigger) const {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_put_batch)>(values, as_trigger);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::put_range(const VT& patch, const uint64_t& offset) const {
+    debug_enter_func_with_args("patch.get_key_ref()={},offset={}", patch.get_key_ref(), offset);
+
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_put_range)>(patch, offset);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
 #ifdef ENABLE_EVALUATION
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 double PersistentCascadeStore<KT, VT, IK, IV, ST>::perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const {
@@ -130,9 +169,26 @@ const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::get(const KT& key, const pe
 #endif
         return persistent_core->lockless_get(key);
     } else {
+        if(exact) {
+            // the version may be relocated to a later log entry, or trimmed.
+            requested_version = this->find_log_version(key, requested_version);
+        } else if(requested_version < this->retention_horizon.load()) {
+            requested_version = EXPIRED_VERSION;
+        }
+        if(requested_version == EXPIRED_VERSION) {
+#if __cplusplus > 201703L
+            LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_END, group,*IV,ver);
+#else
+            LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_END, group,*IV,ver);
+#endif
+            debug_leave_func_with_value("key:{} at version:0x{:x} is expired", key, ver);
+            return create_expired_object();
+        }
         return persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(requested_version, exact,
         [this, key, requested_version, exact, ver](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta) {
-            if(delta.objects.find(key) != delta.objects.cend()) {
+            std::optional<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType::PatchHeader> patch;
+            auto object = delta.find(key, &patch);
+            if(object) {
                 debug_leave_func_with_value("key:{} is found at version:0x{:x}", key, requested_version);
 #if __cplusplus > 201703L
                 LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_END, group,*IV,ver);
@@ -140,7 +196,7 @@ const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::get(const KT& key, const pe
                 LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_END, group,*IV,ver);
 #endif
                 // This return is a copy to make sure returned value does not rely on the data in the delta log.
-                return delta.objects.at(key);
+                return this->reconstruct_object(key, *object, patch);
             } else {
                 if(exact) {
                     // return invalid object for EXACT search.
@@ -152,19 +208,8 @@ const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::get(const KT& key, const pe
 #endif
                     return *IV;
                 } else {
-                    // fall back to the slow path.
-                    // following the backward chain until its version is behind requested_version.
-                    // TODO: We can introduce a per-key version index to achieve a better performance
-                    //       with a 64bit per log entry memory overhead.
-                    VT o = persistent_core->lockless_get(key);
-                    persistent::version_t target_version = o.version;
-                    while (target_version > requested_version) {
-                        target_version = 
-                            persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(target_version,true,
-                                [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
-                                    return delta.objects.at(key).previous_version_by_key;
-                                });
-                    }
+                    // find the latest version of the key before requested_version.
+                    persistent::version_t target_version = this->find_version_of_key(key, requested_version);
                     if (target_version == persistent::INVALID_VERSION) {
 #if __cplusplus > 201703L
                         LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_END, group,*IV,ver);
@@ -173,17 +218,27 @@ const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::get(const KT& key, const pe
 #endif
                         debug_leave_func_with_value("No data found for key:{} before version:0x{:x}", key, requested_version);
                         return *IV;
-                    } else {
+                    }
+                    persistent::version_t log_version = this->find_log_version(key, target_version);
 #if __cplusplus > 201703L
-                        LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_END, group,*IV,ver);
+                    LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_END, group,*IV,ver);
 #else
-                        LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_END, group,*IV,ver);
+                    LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_END, group,*IV,ver);
 #endif
-                        return persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(target_version,true,
-                                [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
+                    if(log_version == EXPIRED_VERSION) {
+                        debug_leave_func_with_value("key:{} before version:0x{:x} is expired", key, requested_version);
+                        return create_expired_object();
+                    } else {
+                        return persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(log_version,true,
+                                [this, &key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
                                     // This return is a copy, which make sure the returned value does not rely on the data in
                                     // the delta log.
-                                    return delta.objects.at(key);
+                                    std::optional<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType::PatchHeader> patch;
+                                    auto object = delta.find(key, &patch);
+                                    if(object) {
+                                        return this->reconstruct_object(key, *object, patch);
+                                    }
+                                    return VT(*IV);
                                 });
                     }
                 }
@@ -192,6 +247,249 @@ const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::get(const KT& key, const pe
     }
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::get_range(const KT& key, const persistent::version_t& ver, const bool stable,
+                                                              const uint64_t& offset, const uint64_t& length) const {
+    debug_enter_func_with_args("key={},ver=0x{:x},stable={},offset={},length={}", key, ver, stable, offset, length);
+
+    persistent::version_t requested_version = ver;
+
+    // adjust version if stable is requested, like get.
+    if(stable) {
+        derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+        if(requested_version == CURRENT_VERSION) {
+            requested_version = subgroup_handle.get_global_persistence_frontier();
+        } else if(!subgroup_handle.wait_for_global_persistence_frontier(requested_version) && requested_version > persistent_core.getLatestVersion()) {
+            debug_leave_func_with_value("requested version:{:x} is beyond the latest atomic broadcast version.", requested_version);
+            return *IV;
+        }
+    }
+
+    if(requested_version == CURRENT_VERSION) {
+        // the copy pins the shared payload of the latest object, which is then sliced.
+        VT value = persistent_core->lockless_get(key);
+        slice_payload(value, offset, length);
+        debug_leave_func_with_value("lockless_get({})", key);
+        return value;
+    }
+    if(requested_version < this->retention_horizon.load()) {
+        debug_leave_func_with_value("key:{} at version:0x{:x} is expired", key, ver);
+        return create_expired_object();
+    }
+    persistent::version_t target_version = this->find_version_of_key(key, requested_version);
+    if(target_version == persistent::INVALID_VERSION) {
+        debug_leave_func_with_value("No data found for key:{} before version:0x{:x}", key, requested_version);
+        return *IV;
+    }
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        // the key is not updated after the requested version, so the latest object is sliced instead.
+        if(persistent_core->lockless_head(key).version == target_version) {
+            VT value = persistent_core->lockless_get(key);
+            if(value.get_version() == target_version) {
+                slice_payload(value, offset, length);
+                debug_leave_func_with_value("key:{} is not updated after version:0x{:x}", key, requested_version);
+                return value;
+            }
+        }
+    }
+    persistent::version_t log_version = (target_version == EXPIRED_VERSION) ? EXPIRED_VERSION : this->find_log_version(key, target_version);
+    if(log_version == EXPIRED_VERSION) {
+        debug_leave_func_with_value("key:{} before version:0x{:x} is expired", key, requested_version);
+        return create_expired_object();
+    }
+    debug_leave_func();
+    return persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(log_version,true,
+            [this, &key, offset, length](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
+                std::optional<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType::PatchHeader> patch;
+                auto object = delta.find(key, &patch);
+                if(!object) {
+                    return VT(*IV);
+                }
+                if(patch.has_value()) {
+                    // a patch is applied to its image before the image is sliced.
+                    VT value = this->reconstruct_object(key, *object, patch);
+                    slice_payload(value, offset, length);
+                    return value;
+                }
+                // only the range is copied out of the log entry.
+                slice_payload(*object, offset, length);
+                return VT(*object);
+            });
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_page_t<VT> PersistentCascadeStore<KT, VT, IK, IV, ST>::get_versions(const KT& key,
+                                                                            const persistent::version_t& ver_begin,
+                                                                            const persistent::version_t& ver_end,
+                                                                            const uint32_t& max_count) const {
+    debug_enter_func_with_args("key={},ver_begin=0x{:x},ver_end=0x{:x},max_count={}", key, ver_begin, ver_end, max_count);
+    std::vector<VT> objects;
+    persistent::version_t next_version = persistent::INVALID_VERSION;
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+        persistent::version_t requested_version = ver_end;
+        if(requested_version == CURRENT_VERSION) {
+            requested_version = subgroup_handle.get_global_persistence_frontier();
+        } else if(!subgroup_handle.wait_for_global_persistence_frontier(requested_version)
+                  && requested_version > persistent_core.getLatestVersion()) {
+            dbg_default_debug("{}: requested version:{:x} is beyond the latest atomic broadcast version.", __PRETTY_FUNCTION__, requested_version);
+            debug_leave_func_with_value("{} objects", objects.size());
+            return {std::move(objects), next_version};
+        }
+        if(requested_version < this->retention_horizon.load()) {
+            objects.push_back(create_expired_object());
+            debug_leave_func_with_value("key:{} at version:0x{:x} is expired", key, requested_version);
+            return {std::move(objects), next_version};
+        }
+        // the reply carries the objects, their count, and the version to continue from.
+        const uint64_t reply_budget = p2p_reply_payload_budget();
+        uint64_t reply_size = sizeof(std::size_t) + sizeof(persistent::version_t);
+        // walk the version chain of the key backward, reading each version from the local log.
+        persistent::version_t ver = this->find_version_of_key(key, requested_version);
+        while(ver != persistent::INVALID_VERSION) {
+            persistent::version_t log_version = (ver == EXPIRED_VERSION) ? EXPIRED_VERSION : this->find_log_version(key, ver);
+            if(log_version != EXPIRED_VERSION && ver_begin != persistent::INVALID_VERSION && ver < ver_begin) {
+                break;
+            }
+            if(log_version == EXPIRED_VERSION) {
+                objects.push_back(create_expired_object());
+                break;
+            }
+            if(max_count != 0 && objects.size() >= max_count) {
+                next_version = ver;
+                break;
+            }
+            VT object = persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(log_version,true,
+                    [this, &key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
+                        std::optional<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType::PatchHeader> patch;
+                        auto object = delta.find(key, &patch);
+                        if(object) {
+                            return this->reconstruct_object(key, *object, patch);
+                        }
+                        return VT(*IV);
+                    });
+            if(object.get_version() == EXPIRED_VERSION) {
+                // the image a patch is applied onto is trimmed.
+                objects.emplace_back(std::move(object));
+                break;
+            }
+            if(!object.is_valid()) {
+                break;
+            }
+            // an object larger than the budget is still returned alone, so that the history makes progress.
+            const uint64_t object_size = mutils::bytes_size(object);
+            if(!objects.empty() && reply_size + object_size > reply_budget) {
+                next_version = ver;
+                break;
+            }
+            reply_size += object_size;
+            if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+                ver = object.previous_version_by_key;
+            } else {
+                ver = this->find_version_of_key(key, ver - 1);
+            }
+            objects.emplace_back(std::move(object));
+        }
+    } else {
+        dbg_default_warn("{}: get_versions requires versioned objects.", __PRETTY_FUNCTION__);
+    }
+    debug_leave_func_with_value("{} objects, next version:0x{:x}", objects.size(), next_version);
+    return {std::move(objects), next_version};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+persistent::version_t PersistentCascadeStore<KT, VT, IK, IV, ST>::find_version_of_key(const KT& key, persistent::version_t ver) const {
+    auto indexed_version = persistent_core->lockless_find_version(key, ver);
+    if(indexed_version.has_value()) {
+        return indexed_version.value();
+    }
+    // fall back to the slow path.
+    // following the backward chain until its version is behind ver.
+    VT o = persistent_core->lockless_get(key);
+    persistent::version_t target_version = o.version;
+    while (target_version > ver) {
+        persistent::version_t log_version = this->find_log_version(key, target_version);
+        if(log_version == EXPIRED_VERSION) {
+            return EXPIRED_VERSION;
+        }
+        target_version =
+            persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(log_version,true,
+                [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
+                    auto object = delta.find(key);
+                    if(object) {
+                        return object->previous_version_by_key;
+                    }
+                    return persistent::INVALID_VERSION;
+                });
+    }
+    return target_version;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+VT PersistentCascadeStore<KT, VT, IK, IV, ST>::reconstruct_object(const KT& key, const VT& object,
+        const std::optional<typename DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::PatchHeader>& patch) const {
+    if constexpr(std::is_base_of<IPatchPayload, VT>::value) {
+        if(patch.has_value()) {
+            // collect the patches back to the last full image of the key, and apply them in order.
+            std::vector<std::pair<VT, std::size_t>> patches;
+            patches.emplace_back(object, patch->offset);
+            std::optional<VT> image;
+            persistent::version_t prev_ver_by_key = object.previous_version_by_key;
+            while(!image.has_value()) {
+                if(prev_ver_by_key == persistent::INVALID_VERSION) {
+                    image.emplace(*IV);
+                    break;
+                }
+                prev_ver_by_key = this->find_log_version(key, prev_ver_by_key);
+                if(prev_ver_by_key == EXPIRED_VERSION) {
+                    return create_expired_object();
+                }
+                prev_ver_by_key = persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(prev_ver_by_key,true,
+                    [&key, &patches, &image](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
+                        std::optional<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType::PatchHeader> prev_patch;
+                        auto prev_object = delta.find(key, &prev_patch);
+                        if(!prev_object) {
+                            image.emplace(*IV);
+                        } else if(prev_patch.has_value()) {
+                            patches.emplace_back(*prev_object, prev_patch->offset);
+                            return prev_object->previous_version_by_key;
+                        } else {
+                            image.emplace(*prev_object);
+                        }
+                        return persistent::INVALID_VERSION;
+                    });
+            }
+            for(auto it = patches.rbegin(); it != patches.rend(); it++) {
+                it->first.patch_payload(image->get_payload_bytes(), image->get_payload_size(), it->second);
+                image.emplace(std::move(it->first));
+            }
+            return std::move(*image);
+        }
+    }
+    return VT(object);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+persistent::version_t PersistentCascadeStore<KT, VT, IK, IV, ST>::find_log_version(const KT& key, persistent::version_t ver) const {
+    persistent::version_t relocated_at = persistent_core->lockless_find_relocation(key, ver);
+    if(relocated_at != persistent::INVALID_VERSION) {
+        return relocated_at;
+    }
+    if(ver < this->retention_horizon.load()) {
+        return EXPIRED_VERSION;
+    }
+    return ver;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+VT PersistentCascadeStore<KT, VT, IK, IV, ST>::create_expired_object() {
+    VT expired(*IV);
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        expired.set_version(EXPIRED_VERSION);
+    }
+    return expired;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::multi_get(const KT& key) const {
     debug_enter_func_with_args("key={}", key);
@@ -231,7 +529,8 @@ const VT PersistentCascadeStore<KT, VT, IK, IV, ST>::get_by_time(const KT& key,
 
     persistent::version_t ver = persistent_core.getVersionAtTime({ts_us, 0});
     if(ver == persistent::INVALID_VERSION) {
-        return *IV;
+        // the time is before the log, which may have been trimmed.
+        return (this->retention_horizon.load() == persistent::INVALID_VERSION) ? *IV : create_expired_object();
     }
 
     debug_leave_func();
@@ -304,10 +603,32 @@ uint64_t PersistentCascadeStore<KT, VT, IK, IV, ST>::get_size(const KT& key, con
 #endif
          return rvo_val;
     } else {
+        if(exact) {
+            // the version may be relocated to a later log entry, or trimmed.
+            requested_version = this->find_log_version(key, requested_version);
+        } else if(requested_version < this->retention_horizon.load()) {
+            requested_version = EXPIRED_VERSION;
+        }
+        if(requested_version == EXPIRED_VERSION) {
+#if __cplusplus > 201703L
+            LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
+#else
+            LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
+#endif
+            debug_leave_func_with_value("key:{} at version:0x{:x} is expired", key, ver);
+            return 0ull;
+        }
         return persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(requested_version, exact, [this, &key, requested_version, exact, ver](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta) -> uint64_t {
-            if(delta.objects.find(key)!=delta.objects.cend()) {
+            std::optional<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType::PatchHeader> patch;
+            auto object = delta.find(key, &patch);
+            if(object) {
                 debug_leave_func_with_value("key:{} is found at version:0x{:x}", key, requested_version);
-                uint64_t size = mutils::bytes_size(delta.objects.at(key));
+                uint64_t size = mutils::bytes_size(*object);
+                if constexpr(std::is_base_of<IPatchPayload, VT>::value) {
+                    if(patch.has_value()) {
+                        size = size - object->get_payload_size() + patch->image_size;
+                    }
+                }
 #if __cplusplus > 201703L
                 LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
 #else
@@ -325,23 +646,9 @@ uint64_t PersistentCascadeStore<KT, VT, IK, IV, ST>::get_size(const KT& key, con
 #endif
                     return 0ull;
                 } else {
-                    // fall back to the slow path.
-                    // following the backward chain until its version is behind requested_version.
-                    // TODO: We can introduce a per-key version index to achieve a better performance
-                    //       with a 64bit per log entry memory overhead.
-                    VT o = persistent_core->lockless_get(key);
-                    persistent::version_t target_version = o.version;
-                    while (target_version > requested_version) {
-                        target_version =
-                            persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(target_version,true,
-                                [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
-                                    if (delta.objects.find(key) != delta.objects.cend()) {
-                                        return delta.objects.at(key).previous_version_by_key;
-                                    }
-                                    return persistent::INVALID_VERSION;
-                                });
-                    }
-                    if (target_version == persistent::INVALID_VERSION) {
+                    // find the latest version of the key before requested_version.
+                    persistent::version_t target_version = this->find_log_version(key, this->find_version_of_key(key, requested_version));
+                    if (target_version == persistent::INVALID_VERSION || target_version == EXPIRED_VERSION) {
 #if __cplusplus > 201703L
                         LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_GET_SIZE_END, group,*IV,ver);
 #else
@@ -352,8 +659,16 @@ uint64_t PersistentCascadeStore<KT, VT, IK, IV, ST>::get_size(const KT& key, con
                     } else {
                         auto size = persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(target_version,true,
                                 [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
-                                    if (delta.objects.find(key) != delta.objects.cend()) {
-                                        return static_cast<uint64_t>(mutils::bytes_size(delta.objects.at(key)));
+                                    std::optional<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType::PatchHeader> patch;
+                                    auto object = delta.find(key, &patch);
+                                    if(object) {
+                                        uint64_t size = mutils::bytes_size(*object);
+                                        if constexpr(std::is_base_of<IPatchPayload, VT>::value) {
+                                            if(patch.has_value()) {
+                                                size = size - object->get_payload_size() + patch->image_size;
+                                            }
+                                        }
+                                        return size;
                                     }
                                     return static_cast<uint64_t>(0ull);
                                 });
@@ -386,6 +701,7 @@ uint64_t PersistentCascadeStore<KT, VT, IK, IV, ST>::get_size_by_time(const KT&
 
     persistent::version_t ver = persistent_core.getVersionAtTime({ts_us, 0});
     if(ver == persistent::INVALID_VERSION) {
+        // the time is before the log, or the log is trimmed.
         return 0;
     }
 
@@ -394,6 +710,85 @@ uint64_t PersistentCascadeStore<KT, VT, IK, IV, ST>::get_size_by_time(const KT&
     return get_size(key, ver, stable);
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+ObjectHead PersistentCascadeStore<KT, VT, IK, IV, ST>::head(const KT& key, const persistent::version_t& ver, const bool stable) const {
+    debug_enter_func_with_args("key={},ver=0x{:x},stable={}", key, ver, stable);
+
+    persistent::version_t requested_version = ver;
+
+    // adjust version if stable is requested, like get.
+    if(stable) {
+        derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+        if(requested_version == CURRENT_VERSION) {
+            requested_version = subgroup_handle.get_global_persistence_frontier();
+        } else if(!subgroup_handle.wait_for_global_persistence_frontier(requested_version) && requested_version > persistent_core.getLatestVersion()) {
+            debug_leave_func_with_value("requested version:{:x} is beyond the latest atomic broadcast version.", requested_version);
+            return ObjectHead{};
+        }
+    }
+
+    // the latest object is read in place.
+    ObjectHead latest = persistent_core->lockless_head(key);
+    if(requested_version == CURRENT_VERSION) {
+        debug_leave_func_with_value("lockless_head({})", key);
+        return latest;
+    }
+    if(requested_version < this->retention_horizon.load()) {
+        debug_leave_func_with_value("key:{} at version:0x{:x} is expired", key, ver);
+        return make_object_head(create_expired_object());
+    }
+    persistent::version_t target_version = this->find_version_of_key(key, requested_version);
+    if(target_version == persistent::INVALID_VERSION) {
+        debug_leave_func_with_value("No data found for key:{} before version:0x{:x}", key, requested_version);
+        return ObjectHead{};
+    }
+    if(target_version == latest.version) {
+        debug_leave_func_with_value("key:{} is not updated after version:0x{:x}", key, requested_version);
+        return latest;
+    }
+    persistent::version_t log_version = (target_version == EXPIRED_VERSION) ? EXPIRED_VERSION : this->find_log_version(key, target_version);
+    if(log_version == EXPIRED_VERSION) {
+        debug_leave_func_with_value("key:{} before version:0x{:x} is expired", key, requested_version);
+        return make_object_head(create_expired_object());
+    }
+    // a historical object is read from its log entry, where a patch only tells the size of the image it makes.
+    debug_leave_func();
+    return persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(log_version,true,
+            [&key](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
+                std::optional<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType::PatchHeader> patch;
+                auto object = delta.find(key, &patch);
+                if(!object) {
+                    return ObjectHead{};
+                }
+                if constexpr(std::is_base_of<IPatchPayload, VT>::value) {
+                    if(patch.has_value()) {
+                        return make_object_head(*object, static_cast<int64_t>(patch->image_size));
+                    }
+                }
+                return make_object_head(*object);
+            });
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::vector<ObjectHead> PersistentCascadeStore<KT, VT, IK, IV, ST>::head_batch(const std::vector<KT>& keys,
+                                                                               const persistent::version_t& ver,
+                                                                               const bool stable) const {
+    debug_enter_func_with_args("{} keys,ver=0x{:x},stable={}", keys.size(), ver, stable);
+    persistent::version_t requested_version = ver;
+    // resolve the stable version once, so that the batch is read at the same version.
+    if(stable && requested_version == CURRENT_VERSION) {
+        derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+        requested_version = subgroup_handle.get_global_persistence_frontier();
+    }
+    std::vector<ObjectHead> heads;
+    heads.reserve(keys.size());
+    for(const auto& key : keys) {
+        heads.emplace_back(this->head(key, requested_version, stable));
+    }
+    debug_leave_func();
+    return heads;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 std::vector<KT> PersistentCascadeStore<KT, VT, IK, IV, ST>::multi_list_keys(const std::string& prefix) const {
     debug_enter_func_with_args("prefix={}.", prefix);
@@ -456,15 +851,44 @@ std::vector<KT> PersistentCascadeStore<KT, VT, IK, IV, ST>::list_keys(const std:
         LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_LIST_KEYS_END, group,*IV,ver);
 #endif
         return rvo_val;
+    } else if(requested_version < this->retention_horizon.load()) {
+#if __cplusplus > 201703L
+        LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_LIST_KEYS_END, group,*IV,ver);
+#else
+        LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_PERSISTENT_LIST_KEYS_END, group,*IV,ver);
+#endif
+        dbg_default_debug("{}: requested version:{:x} is expired.", __PRETTY_FUNCTION__, requested_version);
+        return {};
     } else {
         std::vector<KT> keys;
-        persistent_core.get(requested_version, [&keys, &prefix](const DeltaCascadeStoreCore<KT, VT, IK, IV>& pers_core) {
-            for(const auto& kv : pers_core.kv_map) {
-                if(get_pathname<KT>(kv.first).find(prefix) == 0) {
-                    keys.push_back(kv.first);
+        std::vector<persistent::version_t> later_versions;
+        auto checkpoint = persistent_core->lockless_find_checkpoint(requested_version, later_versions);
+        if(checkpoint.first != persistent::INVALID_VERSION) {
+            // start from the nearest checkpoint. A key never leaves kv_map once put (a remove leaves an empty object),
+            // so replaying a delta only adds its keys.
+            std::set<KT> key_set;
+            checkpoint.second.for_each([&key_set, &prefix](const auto& key, const auto&) {
+                if(pathname_has_prefix(key, prefix)) {
+                    key_set.emplace(key);
                 }
+                return true;
+            });
+            for(const auto& later_version : later_versions) {
+                persistent_core.template getDelta<typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType>(later_version,true,
+                    [&key_set, &prefix](const typename DeltaCascadeStoreCore<KT,VT,IK,IV>::DeltaType& delta){
+                        delta.for_each_key([&key_set, &prefix](const KT& key) {
+                            if(pathname_has_prefix(key, prefix)) {
+                                key_set.emplace(key);
+                            }
+                        });
+                    });
             }
-        });
+            keys.assign(key_set.cbegin(), key_set.cend());
+        } else {
+            persistent_core.get(requested_version, [&keys, &prefix](const DeltaCascadeStoreCore<KT, VT, IK, IV>& pers_core) {
+                keys = pers_core.lockless_list_keys(prefix);
+            });
+        }
 #if __cplusplus > 201703L
         LOG_TIMESTAMP_BY_TAG(TLT_PERSISTENT_LIST_KEYS_END, group,*IV,ver);
 #else
@@ -496,6 +920,102 @@ std::vector<KT> PersistentCascadeStore<KT, VT, IK, IV, ST>::list_keys_by_time(co
     return list_keys(prefix, ver, stable);
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+key_page_t<KT> PersistentCascadeStore<KT, VT, IK, IV, ST>::list_keys_paged(const std::string& prefix, const std::string& cursor,
+                                                                           const uint32_t& limit) const {
+    debug_enter_func_with_args("prefix={},cursor={},limit={}", prefix, cursor, limit);
+    KeyPageCursor<KT> page_cursor{persistent::INVALID_VERSION, *IK};
+    if(limit == 0 || (!cursor.empty() && !KeyPageCursor<KT>::decode(cursor, page_cursor))) {
+        dbg_default_warn("{}: invalid cursor '{}' or limit {}.", __PRETTY_FUNCTION__, cursor, limit);
+        return {};
+    }
+    if(cursor.empty()) {
+        // the listing is fixed at the global persistence frontier, which every member of the shard has applied, so
+        // any of them can list the later pages.
+        derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+        page_cursor.version = subgroup_handle.get_global_persistence_frontier();
+    }
+    if(page_cursor.version < this->retention_horizon.load()) {
+        dbg_default_warn("{}: rejected cursor '{}', whose version 0x{:x} is trimmed from the log.", __PRETTY_FUNCTION__,
+                         cursor, page_cursor.version);
+        return {};
+    }
+    // A key stays in kv_map once put, so the keys at the listing version are the current keys which have a version no
+    // later than it. The version index answers that for most keys; the others are resolved through the log.
+    std::vector<KT> keys;
+    bool has_more = false;
+    bool expired = false;
+    std::optional<std::set<KT>> keys_at_version;
+    auto visitor = [this, &prefix, &keys, &has_more, &expired, &keys_at_version, &page_cursor, limit](const KT& key, const VT&) {
+        auto ver = persistent_core->lockless_find_version(key, page_cursor.version);
+        if(!ver.has_value()) {
+            if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+                // follow the versions of the key back through the log.
+                ver = this->find_version_of_key(key, page_cursor.version);
+            } else {
+                // the objects carry no versions, so the keys at the listing version are listed once from the nearest
+                // checkpoint and the deltas after it.
+                if(!keys_at_version.has_value()) {
+                    auto listed = this->list_keys(prefix, page_cursor.version, false);
+                    keys_at_version.emplace(listed.cbegin(), listed.cend());
+                }
+                ver = (keys_at_version->count(key) > 0) ? page_cursor.version : persistent::INVALID_VERSION;
+            }
+        }
+        if(ver.value() == EXPIRED_VERSION) {
+            // the log is trimmed past the listing version while the page is listed.
+            expired = true;
+            return false;
+        }
+        if(ver.value() == persistent::INVALID_VERSION) {
+            return true;
+        }
+        if(keys.size() == limit) {
+            has_more = true;
+            return false;
+        }
+        keys.push_back(key);
+        return true;
+    };
+    if(cursor.empty()) {
+        persistent_core->lockless_for_each_with_prefix(prefix, visitor);
+    } else {
+        persistent_core->lockless_for_each_with_prefix_after(prefix, page_cursor.last_key, visitor);
+    }
+    if(expired) {
+        dbg_default_warn("{}: rejected cursor '{}', whose version 0x{:x} is trimmed from the log.", __PRETTY_FUNCTION__,
+                         cursor, page_cursor.version);
+        return {};
+    }
+    std::string next_cursor;
+    if(has_more) {
+        page_cursor.last_key = keys.back();
+        next_cursor = page_cursor.encode();
+    }
+    debug_leave_func_with_value("{} keys, next cursor '{}'", keys.size(), next_cursor);
+    return {std::move(keys), std::move(next_cursor)};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+scan_page_t<VT> PersistentCascadeStore<KT, VT, IK, IV, ST>::scan(const std::string& prefix, const std::string& filter,
+                                                                 const std::string& projection, const std::string& cursor,
+                                                                 const uint32_t& max_results) const {
+    debug_enter_func_with_args("prefix={},filter={},projection={},cursor={},max_results={}", prefix, filter, projection, cursor, max_results);
+    ScanPage<KT, VT> page(filter, projection, cursor, max_results);
+    // like list_keys at CURRENT_VERSION, each page reads the latest objects delivered to this replica.
+    auto visitor = [&page](const KT& key, const VT& value) {
+        return page.add(key, value);
+    };
+    if(!page.start_after().has_value()) {
+        persistent_core->lockless_for_each_with_prefix(prefix, visitor);
+    } else {
+        persistent_core->lockless_for_each_with_prefix_after(prefix, *page.start_after(), visitor);
+    }
+    auto result = page.finish();
+    debug_leave_func_with_value("{} objects, next cursor '{}'", std::get<0>(result).size(), std::get<1>(result));
+    return result;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_put(const VT& value,bool as_trigger) {
     debug_enter_func_with_args("key={}", value.get_key_ref());
@@ -553,6 +1073,114 @@ void PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_put_and_forget(const VT
     debug_leave_func();
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::merge(const VT& operand, const std::string& merge_operator) const {
+    debug_enter_func_with_args("operand.get_key_ref()={},merge_operator={}", operand.get_key_ref(), merge_operator);
+
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_merge)>(operand, merge_operator);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_put_batch(const std::vector<VT>& values, bool as_trigger) {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    auto version_and_hlc = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_current_version();
+    for(const auto& value : values) {
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            value.set_version(std::get<0>(version_and_hlc));
+        }
+        if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+            value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+        }
+    }
+    version_tuple version_and_timestamp{persistent::INVALID_VERSION,0};
+    // the batch is one delta, hence one log entry, under this version.
+    if(this->persistent_core->ordered_put_batch(values, this->persistent_core.getLatestVersion(), as_trigger)) {
+        version_and_timestamp = {std::get<0>(version_and_hlc),std::get<1>(version_and_hlc).m_rtc_us};
+        if(cascade_watcher_ptr) {
+            for(const auto& value : values) {
+                (*cascade_watcher_ptr)(
+                        this->subgroup_index,
+                        group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_shard_num(),
+                        group->get_rpc_caller_id(),
+                        value.get_key_ref(), value, cascade_context_ptr);
+            }
+        }
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_timestamp),
+            std::get<1>(version_and_timestamp));
+    return version_and_timestamp;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_put_range(const VT& patch, const uint64_t& offset) {
+    debug_enter_func_with_args("key={},offset={}", patch.get_key_ref(), offset);
+
+    auto version_and_hlc = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_current_version();
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        patch.set_version(std::get<0>(version_and_hlc));
+    }
+    if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+        patch.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+    }
+    version_tuple version_and_timestamp{persistent::INVALID_VERSION,0};
+    if(this->persistent_core->ordered_put_range(patch, offset, this->persistent_core.getLatestVersion())) {
+        version_and_timestamp = {std::get<0>(version_and_hlc),std::get<1>(version_and_hlc).m_rtc_us};
+        if(cascade_watcher_ptr) {
+            (*cascade_watcher_ptr)(
+                    this->subgroup_index,
+                    group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_shard_num(),
+                    group->get_rpc_caller_id(),
+                    patch.get_key_ref(), this->persistent_core->ordered_get(patch.get_key_ref()), cascade_context_ptr);
+        }
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_timestamp),
+            std::get<1>(version_and_timestamp));
+    return version_and_timestamp;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_merge(const VT& operand, const std::string& merge_operator) {
+    debug_enter_func_with_args("key={},merge_operator={}", operand.get_key_ref(), merge_operator);
+
+    auto version_and_hlc = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_current_version();
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        operand.set_version(std::get<0>(version_and_hlc));
+    }
+    if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+        operand.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+    }
+    version_tuple version_and_timestamp{persistent::INVALID_VERSION,0};
+    if(this->persistent_core->ordered_merge(operand, merge_operator, this->persistent_core.getLatestVersion())) {
+        version_and_timestamp = {std::get<0>(version_and_hlc),std::get<1>(version_and_hlc).m_rtc_us};
+        if(cascade_watcher_ptr) {
+            (*cascade_watcher_ptr)(
+                    this->subgroup_index,
+                    group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_shard_num(),
+                    group->get_rpc_caller_id(),
+                    operand.get_key_ref(), this->persistent_core->ordered_get(operand.get_key_ref()), cascade_context_ptr);
+        }
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_timestamp),
+            std::get<1>(version_and_timestamp));
+    return version_and_timestamp;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 bool PersistentCascadeStore<KT, VT, IK, IV, ST>::internal_ordered_put(const VT& value, bool as_trigger) {
     auto version_and_hlc = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_current_version();
@@ -673,6 +1301,117 @@ uint64_t PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_get_size(const KT&
     return size;
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::apply_retention(const std::map<std::string, LogRetentionPolicy>& policies) const {
+    debug_enter_func_with_args("number of policies={}", policies.size());
+
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_apply_retention)>(policies);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_apply_retention(const std::map<std::string, LogRetentionPolicy>& policies) {
+    debug_enter_func_with_args("number of policies={}", policies.size());
+
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    auto version_and_hlc = subgroup_handle.get_current_version();
+    const persistent::version_t latest_version = std::get<0>(version_and_hlc);
+    const uint64_t now_us = std::get<1>(version_and_hlc).m_rtc_us;
+
+    // 1 - commit the horizon chosen in an earlier round, whose relocated objects every replica has applied in order.
+    //     The index is pruned here, on the ordered path, so that all replicas choose the next horizon from it.
+    if(this->pending_trim.first != persistent::INVALID_VERSION) {
+        // readers see the horizon before the index and the log entries are gone.
+        this->retention_horizon.store(this->pending_trim.first);
+        this->persistent_core->prune_before(this->pending_trim.first);
+        this->pending_truncation = this->pending_trim;
+        this->pending_trim = {persistent::INVALID_VERSION, persistent::INVALID_VERSION};
+    }
+
+    // 2 - truncate the log once all replicas persisted the relocated objects. When that happens depends on the
+    //     persistence frontier this replica sees, so nothing below depends on it.
+    if(this->pending_truncation.first != persistent::INVALID_VERSION
+       && subgroup_handle.get_global_persistence_frontier() >= this->pending_truncation.second) {
+        this->invalidate_snapshot_before(this->pending_truncation.first);
+        // trim() drops the log entries up to and including the version.
+        this->persistent_core.trim(this->pending_truncation.first - 1);
+        this->persistent_core->release_segments_before(this->pending_truncation.first);
+        dbg_default_debug("{}: trimmed the log to version:0x{:x}.", __PRETTY_FUNCTION__, this->pending_truncation.first);
+        this->pending_truncation = {persistent::INVALID_VERSION, persistent::INVALID_VERSION};
+    }
+
+    // the horizon is chosen above the committed horizon, not the earliest version of the local log, which depends on
+    // when this replica truncated it. Before the first commit, the log starts at the same version on all replicas.
+    persistent::version_t earliest_version = this->retention_horizon.load();
+    if(earliest_version == persistent::INVALID_VERSION) {
+        // the log may have been trimmed before a restart.
+        earliest_version = this->persistent_core.getEarliestVersion();
+        this->retention_horizon.store(earliest_version);
+    }
+    if(earliest_version != persistent::INVALID_VERSION) {
+        // 3 - resolve the policies at the time of this round.
+        std::vector<typename DeltaCascadeStoreCore<KT, VT, IK, IV>::PoolRetention> pools;
+        for(const auto& policy : policies) {
+            persistent::version_t age_cutoff = persistent::INVALID_VERSION;
+            const uint64_t max_age_us = policy.second.max_age_sec * 1000000;
+            if(policy.second.max_age_sec > 0 && now_us > max_age_us) {
+                age_cutoff = this->persistent_core.getVersionAtTime({now_us - max_age_us, 0});
+                // a time before the committed horizon resolves the same, whether or not this replica truncated the log.
+                if(age_cutoff < earliest_version) {
+                    age_cutoff = persistent::INVALID_VERSION;
+                }
+            }
+            pools.push_back({policy.first, policy.second, age_cutoff});
+        }
+        // 4 - relocate the current objects logged before the horizon, and commit the horizon in the next round.
+        persistent::version_t horizon = this->persistent_core->find_retention_horizon(pools, earliest_version, latest_version);
+        if(horizon > earliest_version) {
+            horizon = this->persistent_core->relocate_before(horizon, latest_version);
+        }
+        if(horizon > earliest_version) {
+            this->pending_trim = {horizon, latest_version};
+        }
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", latest_version, now_us);
+    return {latest_version, now_us};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::set_blob_thresholds(const std::map<std::string, uint64_t>& thresholds) const {
+    debug_enter_func_with_args("number of thresholds={}", thresholds.size());
+
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_set_blob_thresholds)>(thresholds);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+version_tuple PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_set_blob_thresholds(const std::map<std::string, uint64_t>& thresholds) {
+    debug_enter_func_with_args("number of thresholds={}", thresholds.size());
+
+    auto version_and_hlc = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index).get_current_version();
+    this->persistent_core->set_blob_thresholds(thresholds, std::get<0>(version_and_hlc));
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(version_and_hlc), std::get<1>(version_and_hlc).m_rtc_us);
+    return {std::get<0>(version_and_hlc), std::get<1>(version_and_hlc).m_rtc_us};
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 void PersistentCascadeStore<KT, VT, IK, IV, ST>::trigger_put(const VT& value) const {
     debug_enter_func_with_args("key={}", value.get_key_ref());
@@ -747,6 +1486,217 @@ std::vector<KT> PersistentCascadeStore<KT, VT, IK, IV, ST>::ordered_list_keys(co
     return rvo_val;
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::map<std::string, uint64_t> PersistentCascadeStore<KT, VT, IK, IV, ST>::get_recovery_stats() const {
+    debug_enter_func();
+    debug_leave_func_with_value("recovery_us={}", this->recovery_stats.at("recovery_us"));
+    return this->recovery_stats;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::map<std::string, uint64_t> PersistentCascadeStore<KT, VT, IK, IV, ST>::get_key_memory_stats() const {
+    debug_enter_func();
+    auto stats = this->persistent_core->get_key_memory_stats();
+    const uint64_t num_keys = stats.at("keys");
+    stats["key_bytes_per_key"] = (num_keys == 0) ? 0 : stats.at("key_bytes") / num_keys;
+    stats["stored_key_bytes_per_key"] = (num_keys == 0) ? 0 : stats.at("stored_key_bytes") / num_keys;
+    stats["index_key_bytes_per_key"] = (num_keys == 0) ? 0 : stats.at("index_key_bytes") / num_keys;
+    debug_leave_func_with_value("keys={},stored_key_bytes={}", num_keys, stats.at("stored_key_bytes"));
+    return stats;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::vector<uint8_t> PersistentCascadeStore<KT, VT, IK, IV, ST>::get_blob_segment(const std::string& segment, const uint64_t& size,
+                                                                                  const uint64_t& offset) const {
+    debug_enter_func_with_args("segment={},size={},offset={}", segment, size, offset);
+    std::vector<uint8_t> piece;
+    try {
+        piece = BlobSegmentStore::get().read(BlobReference::from_string(segment, size), offset, p2p_reply_payload_budget());
+    } catch(const std::invalid_argument& ex) {
+        dbg_default_warn("{}: {}", __PRETTY_FUNCTION__, ex.what());
+    }
+    debug_leave_func_with_value("{} bytes", piece.size());
+    return piece;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCascadeStore<KT, VT, IK, IV, ST>::start_segment_repair() {
+    if constexpr(std::is_base_of<IExternalPayload, VT>::value) {
+        this->persistent_core->segment_fetcher = [this](const BlobReference& reference) {
+            return this->fetch_blob_segment(reference);
+        };
+        this->segment_repair_running = true;
+        this->segment_repair_thread = std::thread(&PersistentCascadeStore::segment_repair_worker, this);
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+bool PersistentCascadeStore<KT, VT, IK, IV, ST>::fetch_blob_segment(const BlobReference& reference) {
+    if(group == nullptr) {
+        return false;
+    }
+    const std::string segment = reference.to_string();
+    derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+    const std::vector<node_id_t> members = group->template get_subgroup_members<PersistentCascadeStore>(this->subgroup_index)
+                                                   .at(subgroup_handle.get_shard_num());
+    for(node_id_t node : members) {
+        if(node == group->get_my_id()) {
+            continue;
+        }
+        try {
+            std::vector<uint8_t> bytes;
+            bytes.reserve(reference.size);
+            while(bytes.size() < reference.size) {
+                auto results = subgroup_handle.template p2p_send<RPC_NAME(get_blob_segment)>(node, segment, reference.size,
+                                                                                             static_cast<uint64_t>(bytes.size()));
+                auto& replies = results.get();
+                std::vector<uint8_t> piece = replies.begin()->second.get();
+                if(piece.empty()) {
+                    break;
+                }
+                bytes.insert(bytes.end(), piece.cbegin(), piece.cend());
+            }
+            if(bytes.size() != reference.size) {
+                continue;
+            }
+            BlobReference fetched = BlobSegmentStore::reference_of(bytes.data(), bytes.size());
+            if(memcmp(fetched.digest, reference.digest, sizeof(reference.digest)) != 0) {
+                dbg_default_warn("{}: blob segment {} from node {} does not match its digest.", __PRETTY_FUNCTION__, segment, node);
+                continue;
+            }
+            BlobSegmentStore::get().write(bytes.data(), bytes.size());
+            dbg_default_info("Fetched blob segment {} of {} bytes from node {}.", segment, reference.size, node);
+            return true;
+        } catch(const std::exception& ex) {
+            dbg_default_warn("{}: failed to fetch blob segment {} from node {}: {}", __PRETTY_FUNCTION__, segment, node, ex.what());
+        }
+    }
+    return false;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+bool PersistentCascadeStore<KT, VT, IK, IV, ST>::scan_logged_segments(std::vector<BlobReference>& missing) {
+    try {
+        const int64_t latest_index = this->persistent_core.getLatestIndex();
+        for(int64_t index = this->persistent_core.getEarliestIndex(); index <= latest_index; index++) {
+            this->persistent_core.template getDeltaByIndex<typename DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType>(index,
+                    [this, &missing](const typename DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType& delta) {
+                        std::vector<BlobReference> references;
+                        delta.for_each_segment([&references](const BlobReference& reference) { references.push_back(reference); });
+                        this->persistent_core->lockless_track_segments(delta.version(), references);
+                        for(const auto& reference : references) {
+                            if(!BlobSegmentStore::get().contains(reference)) {
+                                missing.push_back(reference);
+                            }
+                        }
+                    });
+        }
+    } catch(const std::exception& ex) {
+        dbg_default_warn("{}: failed to scan the log for blob segments: {}", __PRETTY_FUNCTION__, ex.what());
+        return false;
+    }
+    return true;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCascadeStore<KT, VT, IK, IV, ST>::segment_repair_worker() {
+    pthread_setname_np(pthread_self(), "cs_blob_repair");
+    bool scanned = false;
+    std::unique_lock<std::mutex> lck(this->segment_repair_mutex);
+    while(this->segment_repair_running) {
+        this->segment_repair_cv.wait_for(lck, SEGMENT_REPAIR_INTERVAL, [this]() { return !this->segment_repair_running; });
+        if(!this->segment_repair_running || group == nullptr) {
+            continue;
+        }
+        lck.unlock();
+        std::vector<BlobReference> missing = this->persistent_core->lockless_missing_segments();
+        if(!scanned) {
+            scanned = this->scan_logged_segments(missing);
+        }
+        std::set<std::string> visited;
+        bool fetched = false;
+        for(const auto& reference : missing) {
+            if(!visited.insert(reference.to_string()).second) {
+                continue;
+            }
+            if(BlobSegmentStore::get().contains(reference) || this->fetch_blob_segment(reference)) {
+                fetched = true;
+            } else {
+                dbg_default_warn("{}: no shard member has blob segment {} yet.", __PRETTY_FUNCTION__, reference.to_string());
+            }
+        }
+        if(fetched) {
+            this->persistent_core->notify_fetched_segments();
+        }
+        lck.lock();
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+uint32_t PersistentCascadeStore<KT, VT, IK, IV, ST>::get_snapshot_interval() {
+    return derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_SNAPSHOT_INTERVAL)
+                   ? derecho::getConfUInt32(CASCADE_PERSISTENT_SNAPSHOT_INTERVAL)
+                   : CASCADE_PERSISTENT_SNAPSHOT_INTERVAL_DEFAULT;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+std::string PersistentCascadeStore<KT, VT, IK, IV, ST>::get_snapshot_file(persistent::PersistentRegistry* pr) {
+    // a log in memory is not replayed on restart.
+    if(ST != persistent::ST_FILE || pr == nullptr) {
+        return "";
+    }
+    std::string path = derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_SNAPSHOT_PATH)
+                               ? derecho::getConfString(CASCADE_PERSISTENT_SNAPSHOT_PATH)
+                               : derecho::getConfString(derecho::Conf::PERS_FILE_PATH) + "/snapshots";
+    return path + "/" + std::string(pr->get_subgroup_prefix()) + ".snapshot";
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCascadeStore<KT, VT, IK, IV, ST>::snapshot_worker(uint32_t interval_sec) {
+    pthread_setname_np(pthread_self(), "cs_snapshot");
+    std::unique_lock<std::mutex> lck(this->snapshot_mutex);
+    while(this->snapshot_running) {
+        this->snapshot_cv.wait_for(lck, std::chrono::seconds(interval_sec), [this]() { return !this->snapshot_running; });
+        if(!this->snapshot_running || group == nullptr) {
+            continue;
+        }
+        lck.unlock();
+        try {
+            derecho::Replicated<PersistentCascadeStore>& subgroup_handle = group->template get_subgroup<PersistentCascadeStore>(this->subgroup_index);
+            // a version persisted by all replicas is never truncated from the log.
+            persistent::version_t frontier = subgroup_handle.get_global_persistence_frontier();
+            std::lock_guard<std::mutex> file_lck(this->snapshot_file_mutex);
+            persistent::version_t after = this->snapshot_version;
+            if(this->snapshot_floor != persistent::INVALID_VERSION && (after == persistent::INVALID_VERSION || after < this->snapshot_floor)) {
+                after = this->snapshot_floor - 1;
+            }
+            persistent::version_t ver = this->persistent_core->lockless_write_snapshot(
+                    this->snapshot_recovery.snapshot_file, frontier, after,
+                    [this](const KT& key, persistent::version_t version) { return this->get(key, version, false, true); });
+            if(ver != after) {
+                this->snapshot_version = ver;
+                dbg_default_debug("{}: wrote the snapshot of version:0x{:x}.", __PRETTY_FUNCTION__, ver);
+            }
+        } catch(const std::exception& ex) {
+            dbg_default_warn("Failed to write snapshot {}: {}", this->snapshot_recovery.snapshot_file, ex.what());
+        }
+        lck.lock();
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+void PersistentCascadeStore<KT, VT, IK, IV, ST>::invalidate_snapshot_before(persistent::version_t horizon) {
+    if(this->snapshot_recovery.snapshot_file.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> file_lck(this->snapshot_file_mutex);
+    this->snapshot_floor = horizon;
+    if(this->snapshot_version != persistent::INVALID_VERSION && this->snapshot_version < horizon) {
+        ::unlink(this->snapshot_recovery.snapshot_file.c_str());
+        this->snapshot_version = persistent::INVALID_VERSION;
+    }
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 std::unique_ptr<PersistentCascadeStore<KT, VT, IK, IV, ST>> PersistentCascadeStore<KT, VT, IK, IV, ST>::from_bytes(mutils::DeserializationManager* dsm, uint8_t const* buf) {
     auto persistent_core_ptr = mutils::from_bytes<persistent::Persistent<DeltaCascadeStoreCore<KT, VT, IK, IV>, ST>>(dsm, buf);
@@ -760,12 +1710,49 @@ template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
 PersistentCascadeStore<KT, VT, IK, IV, ST>::PersistentCascadeStore(
         persistent::PersistentRegistry* pr,
         CriticalDataPathObserver<PersistentCascadeStore<KT, VT, IK, IV>>* cw,
-        ICascadeContext* cc) : persistent_core([]() {
+        ICascadeContext* cc) : retention_horizon(persistent::INVALID_VERSION),
+                               pending_trim{persistent::INVALID_VERSION, persistent::INVALID_VERSION},
+                               pending_truncation{persistent::INVALID_VERSION, persistent::INVALID_VERSION},
+                               snapshot_recovery(get_snapshot_interval() > 0 ? get_snapshot_file(pr) : ""),
+                               snapshot_version(persistent::INVALID_VERSION),
+                               snapshot_floor(persistent::INVALID_VERSION),
+                               snapshot_running(false),
+                               segment_repair_running(false),
+                               persistent_core([]() {
                                    return std::make_unique<DeltaCascadeStoreCore<KT, VT, IK, IV>>();
                                },
-                                               nullptr, pr),
+                                               nullptr, pr, false,
+                                               mutils::DeserializationManager({&snapshot_recovery})),
                                cascade_watcher_ptr(cw),
                                cascade_context_ptr(cc) {
+    // the log has been replayed by the constructor of persistent_core.
+    this->recovery_stats = this->persistent_core->get_recovery_stats();
+    this->recovery_stats["recovery_us"] = std::chrono::duration_cast<std::chrono::microseconds>(
+                                                  std::chrono::steady_clock::now() - this->snapshot_recovery.start)
+                                                  .count();
+    this->snapshot_version = static_cast<persistent::version_t>(this->recovery_stats["snapshot_version"]);
+    this->start_segment_repair();
+    if(this->snapshot_recovery.snapshot_file.empty()) {
+        // a snapshot left by a run with snapshots enabled misses the trims since then.
+        std::string snapshot_file = get_snapshot_file(pr);
+        if(!snapshot_file.empty()) {
+            ::unlink(snapshot_file.c_str());
+        }
+        return;
+    }
+    dbg_default_info("Recovered {} in {} us, with {} objects from the snapshot of version:0x{:x}, {} log entries replayed, and {} skipped.",
+                     this->snapshot_recovery.snapshot_file, this->recovery_stats["recovery_us"],
+                     this->recovery_stats["snapshot_objects"], this->snapshot_version,
+                     this->recovery_stats["replayed_deltas"], this->recovery_stats["skipped_deltas"]);
+    if(this->snapshot_version == persistent::INVALID_VERSION) {
+        // the snapshot is missing, invalid, or stale because the log is empty.
+        ::unlink(this->snapshot_recovery.snapshot_file.c_str());
+    } else if(this->snapshot_version > this->persistent_core.getLatestVersion()) {
+        dbg_default_warn("The snapshot {} of version:0x{:x} is later than the log of version:0x{:x}.",
+                         this->snapshot_recovery.snapshot_file, this->snapshot_version, this->persistent_core.getLatestVersion());
+    }
+    this->snapshot_running = true;
+    this->snapshot_thread = std::thread(&PersistentCascadeStore::snapshot_worker, this, get_snapshot_interval());
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
@@ -773,13 +1760,32 @@ PersistentCascadeStore<KT, VT, IK, IV, ST>::PersistentCascadeStore(
         persistent::Persistent<DeltaCascadeStoreCore<KT, VT, IK, IV>, ST>&&
                 _persistent_core,
         CriticalDataPathObserver<PersistentCascadeStore<KT, VT, IK, IV>>* cw,
-        ICascadeContext* cc) : persistent_core(std::move(_persistent_core)),
+        ICascadeContext* cc) : retention_horizon(persistent::INVALID_VERSION),
+                               pending_trim{persistent::INVALID_VERSION, persistent::INVALID_VERSION},
+                               pending_truncation{persistent::INVALID_VERSION, persistent::INVALID_VERSION},
+                               snapshot_recovery(""),
+                               snapshot_version(persistent::INVALID_VERSION),
+                               snapshot_floor(persistent::INVALID_VERSION),
+                               snapshot_running(false),
+                               segment_repair_running(false),
+                               persistent_core(std::move(_persistent_core)),
                                cascade_watcher_ptr(cw),
                                cascade_context_ptr(cc) {
+    this->recovery_stats = this->persistent_core->get_recovery_stats();
+    this->recovery_stats["recovery_us"] = 0;
+    this->start_segment_repair();
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
-PersistentCascadeStore<KT, VT, IK, IV, ST>::PersistentCascadeStore() : persistent_core(
+PersistentCascadeStore<KT, VT, IK, IV, ST>::PersistentCascadeStore() : retention_horizon(persistent::INVALID_VERSION),
+                                                                       pending_trim{persistent::INVALID_VERSION, persistent::INVALID_VERSION},
+                                                                       pending_truncation{persistent::INVALID_VERSION, persistent::INVALID_VERSION},
+                                                                       snapshot_recovery(""),
+                                                                       snapshot_version(persistent::INVALID_VERSION),
+                                                                       snapshot_floor(persistent::INVALID_VERSION),
+                                                                       snapshot_running(false),
+                                                                       segment_repair_running(false),
+                                                                       persistent_core(
         []() {
             return std::make_unique<DeltaCascadeStoreCore<KT, VT, IK, IV>>();
         },
@@ -790,7 +1796,24 @@ PersistentCascadeStore<KT, VT, IK, IV, ST>::PersistentCascadeStore() : persisten
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
-PersistentCascadeStore<KT, VT, IK, IV, ST>::~PersistentCascadeStore() {}
+PersistentCascadeStore<KT, VT, IK, IV, ST>::~PersistentCascadeStore() {
+    {
+        std::lock_guard<std::mutex> lck(this->snapshot_mutex);
+        this->snapshot_running = false;
+    }
+    this->snapshot_cv.notify_all();
+    if(this->snapshot_thread.joinable()) {
+        this->snapshot_thread.join();
+    }
+    {
+        std::lock_guard<std::mutex> lck(this->segment_repair_mutex);
+        this->segment_repair_running = false;
+    }
+    this->segment_repair_cv.notify_all();
+    if(this->segment_repair_thread.joinable()) {
+        this->segment_repair_thread.join();
+    }
+}
 
 }  // namespace cascade
 }  // namespace derecho
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "cascade/cascade_interface.hpp"
+#include "cascade/scan_filter.hpp"
+#include "key_page_cursor.hpp"
+#include "message_limits.hpp"
+
+#include <derecho/mutils-serialization/SerializationSupport.hpp>
+
+#include <iterator>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * Test an object of a scan with a filter, and append its projection to the results if it matches. Null objects, i.e.
+ * removed keys, never match. The version, timestamp and payload of the object are tested if VT implements
+ * IKeepVersion, IKeepTimestamp and IMergePayload respectively, and the payload is projected only if VT implements
+ * IMergePayload.
+ *
+ * @tparam KT           - the key type
+ * @tparam VT           - the object type
+ * @param  key          - the key
+ * @param  value        - the object
+ * @param  filter       - the filter
+ * @param  projection   - the projection
+ * @param  results      - the results, to which the projected object is appended
+ */
+template <typename KT, typename VT>
+void scan_object(const KT& key, const VT& value, const ScanFilter& filter, const ScanProjection& projection,
+                 std::vector<VT>& results) {
+    if(value.is_null()) {
+        return;
+    }
+    ScanFields fields{{}, persistent::INVALID_VERSION, 0, nullptr, 0};
+    std::string key_string;
+    if constexpr(std::is_convertible_v<KT, std::string>) {
+        const std::string& pathname = key;
+        fields.key = pathname;
+    } else if constexpr(std::is_integral_v<KT>) {
+        key_string = std::to_string(key);
+        fields.key = key_string;
+    }
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        fields.version = value.get_version();
+    }
+    if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+        fields.timestamp_us = value.get_timestamp();
+    }
+    if constexpr(std::is_base_of<IMergePayload, VT>::value) {
+        fields.payload = value.get_payload_bytes();
+        fields.payload_size = value.get_payload_size();
+    }
+    if(!filter.match(fields)) {
+        return;
+    }
+    results.emplace_back(value);
+    if constexpr(std::is_base_of<IMergePayload, VT>::value) {
+        if(!projection.keeps_payload()) {
+            auto projected = projection.apply(fields.payload, fields.payload_size);
+            results.back().set_payload(projected.first, projected.second);
+        }
+    }
+}
+
+/**
+ * ScanPage collects a page of a scan: the matching objects with the smallest keys after the cursor, up to a number of
+ * objects and to p2p_reply_payload_budget() bytes of reply. The keys may be offered in any order. An object larger than
+ * the budget is returned alone, so that a scan always makes progress. The cursor of the next page is a KeyPageCursor
+ * at CURRENT_VERSION, since each page reads the latest objects.
+ *
+ * @tparam KT   - the key type
+ * @tparam VT   - the object type
+ */
+template <typename KT, typename VT>
+class ScanPage {
+    ScanFilter filter;
+    ScanProjection projection;
+    const uint32_t max_results;
+    const uint64_t budget;
+    std::optional<KT> after;
+    /* the matching objects by key, and the bytes of the reply carrying them */
+    std::map<KT, VT> objects;
+    uint64_t reply_size;
+    /* the smallest key of the matching objects left for the next page */
+    std::optional<KT> bound;
+    std::vector<VT> matched;
+
+    static uint64_t cursor_size(const KT& key) {
+        // the length of the string, the version in decimal, the colon and the key.
+        return sizeof(std::size_t) + 21 + mutils::bytes_size(key);
+    }
+
+public:
+    /**
+     * Compile the expressions and decode the cursor of a scan.
+     *
+     * @param filter_expression     - the filter expression, empty to match all objects
+     * @param projection_expression - the projection expression, empty to return the whole payload
+     * @param cursor                - the cursor returned with the previous page, or empty for the first page
+     * @param _max_results          - the maximum number of objects in the page, 0 for no limit
+     *
+     * @throw std::runtime_error if the filter, the projection or the cursor is invalid.
+     */
+    ScanPage(const std::string& filter_expression, const std::string& projection_expression, const std::string& cursor,
+             uint32_t _max_results)
+            : max_results(_max_results), budget(p2p_reply_payload_budget()), reply_size(sizeof(std::size_t)) {
+        std::string error;
+        if(!ScanFilter::compile(filter_expression, filter, error)) {
+            throw std::runtime_error("Invalid scan filter '" + filter_expression + "': " + error);
+        }
+        if(!ScanProjection::compile(projection_expression, projection, error)) {
+            throw std::runtime_error("Invalid scan projection '" + projection_expression + "': " + error);
+        }
+        if(!cursor.empty()) {
+            KeyPageCursor<KT> page_cursor{CURRENT_VERSION, KT{}};
+            if(!KeyPageCursor<KT>::decode(cursor, page_cursor)) {
+                throw std::runtime_error("Invalid scan cursor '" + cursor + "'.");
+            }
+            after = page_cursor.last_key;
+        }
+    }
+
+    /**
+     * @return the key the page starts after, or std::nullopt for the first page.
+     */
+    const std::optional<KT>& start_after() const {
+        return after;
+    }
+
+    /**
+     * Offer an object of a key after start_after().
+     *
+     * @param key   - the key
+     * @param value - the object
+     *
+     * @return false if the keys after this one are beyond the page, so that a scan in key order can stop.
+     */
+    bool add(const KT& key, const VT& value) {
+        if(bound.has_value() && !(key < *bound)) {
+            return false;
+        }
+        scan_object(key, value, filter, projection, matched);
+        if(matched.empty()) {
+            return true;
+        }
+        reply_size += mutils::bytes_size(matched.back());
+        objects.emplace(key, std::move(matched.back()));
+        matched.clear();
+        // leave the objects with the largest keys to the next page.
+        while(objects.size() > 1
+              && ((max_results != 0 && objects.size() > max_results)
+                  || reply_size + cursor_size(objects.rbegin()->first) > budget)) {
+            auto last = std::prev(objects.end());
+            reply_size -= mutils::bytes_size(last->second);
+            bound = last->first;
+            objects.erase(last);
+        }
+        return !bound.has_value() || key < *bound;
+    }
+
+    /**
+     * @return the page, with the cursor of the next page, which is empty if this is the last page.
+     */
+    scan_page_t<VT> finish() {
+        std::string cursor;
+        if(bound.has_value()) {
+            cursor = KeyPageCursor<KT>{CURRENT_VERSION, objects.rbegin()->first}.encode();
+        }
+        std::vector<VT> results;
+        results.reserve(objects.size());
+        for(auto& entry : objects) {
+            results.emplace_back(std::move(entry.second));
+        }
+        objects.clear();
+        return {std::move(results), std::move(cursor)};
+    }
+};
+
+}  // namespace cascade
+}  // namespace derecho
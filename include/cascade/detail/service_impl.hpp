@@ -3,12 +3,17 @@
 #include <derecho/core/notification.hpp>
 #include <vector>
 #include <map>
+#include <deque>
 #include <typeindex>
 #include <variant>
+#include <optional>
+#include <exception>
+#include <type_traits>
 #include <derecho/core/derecho.hpp>
 #include <cascade/config.h>
 #include <cascade/data_flow_graph.hpp>
 #include <chrono>
+#include <fstream>
 
 using namespace std::chrono_literals;
 
@@ -31,12 +36,41 @@ derecho::Factory<CascadeType> factory_wrapper(ICascadeContext* context_ptr, dere
         };
 }
 
+template <typename... CascadeTypes>
+json load_subgroup_layout() {
+    json layout;
+    if (derecho::hasCustomizedConfKey(derecho::Conf::LAYOUT_JSON_LAYOUT)) {
+        layout = json::parse(derecho::getConfString(derecho::Conf::LAYOUT_JSON_LAYOUT));
+    } else if (derecho::hasCustomizedConfKey(derecho::Conf::LAYOUT_JSON_LAYOUT_FILE)) {
+        std::ifstream json_file(derecho::getAbsoluteFilePath(derecho::getConfString(derecho::Conf::LAYOUT_JSON_LAYOUT_FILE)));
+        if (!json_file) {
+            dbg_default_error("Cannot load json configuration from file: {}", derecho::getAbsoluteFilePath(derecho::getConfString(derecho::Conf::LAYOUT_JSON_LAYOUT_FILE)));
+            throw derecho::derecho_exception("Cannot load json configuration from file.");
+        }
+        json_file >> layout;
+    } else {
+        throw derecho::derecho_exception("The json layout is not configured.");
+    }
+    const std::vector<const char*> layout_conf_keys{nullptr, subgroup_layout_conf_key<CascadeTypes>()...};
+    const std::vector<std::string> type_names{"CascadeMetadataService", typeid(CascadeTypes).name()...};
+    for (std::size_t type_index = layout.size(); type_index < layout_conf_keys.size(); type_index++) {
+        json type_layout = json::array();
+        if (layout_conf_keys[type_index] != nullptr && derecho::hasCustomizedConfKey(layout_conf_keys[type_index])) {
+            type_layout = json::parse(derecho::getConfString(layout_conf_keys[type_index]));
+        }
+        dbg_default_info("The json layout has no entry for {}, use {}.", type_names[type_index], type_layout.dump());
+        layout.push_back(json{{"type_alias", type_names[type_index]}, {"layout", type_layout}});
+    }
+    return layout;
+}
+
 template <typename... CascadeTypes>
 Service<CascadeTypes...>::Service(const std::vector<DeserializationContext*>& dsms,
                                   derecho::cascade::Factory<CascadeMetadataService<CascadeTypes...>> metadata_service_factory,
                                   derecho::cascade::Factory<CascadeTypes>... factories) {
     // STEP 1 - load configuration
-    derecho::SubgroupInfo si{derecho::make_subgroup_allocator<CascadeMetadataService<CascadeTypes...>,CascadeTypes...>()};
+    derecho::SubgroupInfo si{derecho::make_subgroup_allocator<CascadeMetadataService<CascadeTypes...>,CascadeTypes...>(
+            load_subgroup_layout<CascadeTypes...>())};
     // STEP 2 - setup cascade context
     context = std::make_unique<ExecutionEngine<CascadeTypes...>>();
     std::vector<DeserializationContext*> new_dsms(dsms);
@@ -56,7 +90,10 @@ Service<CascadeTypes...>::Service(const std::vector<DeserializationContext*>& ds
                 },
                 si,
                 new_dsms,
-                std::vector<derecho::view_upcall_t>{},
+                std::vector<derecho::view_upcall_t>{
+                    [](const derecho::View&) {
+                        ServiceClient<CascadeTypes...>::refresh_singleton_view();
+                    }},
                 factory_wrapper(context.get(),metadata_service_factory),
                 factory_wrapper(context.get(),factories)...);
     dbg_default_trace("joined group.");
@@ -153,10 +190,22 @@ std::unique_ptr<CascadeType> client_stub_factory() {
 #endif
 
 
+/**
+ * Allocate a process-wide unique id for a ServiceClient.
+ */
+inline uint64_t next_service_client_id() {
+    static std::atomic<uint64_t> next_id{1};
+    return next_id.fetch_add(1,std::memory_order_relaxed);
+}
+
 template <typename... CascadeTypes>
 ServiceClient<CascadeTypes...>::ServiceClient(derecho::Group<CascadeMetadataService<CascadeTypes...>,CascadeTypes...>* _group_ptr):
     external_group_ptr(nullptr),
-    group_ptr(_group_ptr) {
+    external_calls(nullptr),
+    external_sending(false),
+    group_ptr(_group_ptr),
+    client_id(next_service_client_id()),
+    view_generation(0) {
     if (group_ptr == nullptr) {
         this->external_group_ptr =
             std::make_unique<derecho::ExternalGroupClient<CascadeMetadataService<CascadeTypes...>,CascadeTypes...>>(
@@ -184,7 +233,7 @@ std::vector<node_id_t> ServiceClient<CascadeTypes...>::get_members() const {
     if (!is_external_client()) {
         return group_ptr->get_members();
     } else {
-        return external_group_ptr->get_members();
+        return external_call([](external_group_t& client) { return client.get_members(); });
     }
 }
 
@@ -199,7 +248,9 @@ std::vector<node_id_t> ServiceClient<CascadeTypes...>::get_shard_members(uint32_
             return {};
         }
     } else {
-        return external_group_ptr->template get_shard_members<SubgroupType>(subgroup_index,shard_index);
+        return external_call([subgroup_index,shard_index](external_group_t& client) {
+            return client.template get_shard_members<SubgroupType>(subgroup_index,shard_index);
+        });
     }
 }
 
@@ -241,7 +292,9 @@ std::vector<std::vector<node_id_t>> ServiceClient<CascadeTypes...>::get_subgroup
     if (!is_external_client()) {
         return group_ptr->template get_subgroup_members<SubgroupType>(subgroup_index);
     } else {
-        return external_group_ptr->template get_subgroup_members<SubgroupType>(subgroup_index);
+        return external_call([subgroup_index](external_group_t& client) {
+            return client.template get_subgroup_members<SubgroupType>(subgroup_index);
+        });
     }
 }
 
@@ -283,7 +336,9 @@ uint32_t ServiceClient<CascadeTypes...>::get_number_of_subgroups() const {
     if (!is_external_client()) {
         return group_ptr->template get_num_subgroups<SubgroupType>();
     } else {
-        return external_group_ptr->template get_number_of_subgroups<SubgroupType>();
+        return external_call([](external_group_t& client) {
+            return client.template get_number_of_subgroups<SubgroupType>();
+        });
     }
 }
 
@@ -293,7 +348,9 @@ uint32_t ServiceClient<CascadeTypes...>::get_number_of_shards(uint32_t subgroup_
     if (!is_external_client()) {
         return group_ptr->template get_subgroup_members<SubgroupType>(subgroup_index).size();
     } else {
-        return external_group_ptr->template get_number_of_shards<SubgroupType>(subgroup_index);
+        return external_call([subgroup_index](external_group_t& client) {
+            return client.template get_number_of_shards<SubgroupType>(subgroup_index);
+        });
     }
 }
 
@@ -414,17 +471,124 @@ template <typename SubgroupType>
 void ServiceClient<CascadeTypes...>::refresh_member_cache_entry(uint32_t subgroup_index,
                                                           uint32_t shard_index) {
     auto key = std::make_tuple(std::type_index(typeid(SubgroupType)),subgroup_index,shard_index);
+    const uint64_t generation = view_generation.load(std::memory_order_acquire);
     auto members = get_shard_members<SubgroupType>(subgroup_index,shard_index);
-    std::shared_lock rlck(member_cache_mutex);
-    if (member_cache.find(key) == member_cache.end()) {
-        rlck.unlock();
-        std::unique_lock wlck(member_cache_mutex);
-        member_cache[key] = members;
-    } else {
+    std::unique_lock wlck(member_cache_mutex);
+    // the members are dropped if the view changed during the lookup, and looked up again by the caller.
+    if (view_generation.load(std::memory_order_acquire) == generation) {
         member_cache[key].swap(members);
     }
 }
 
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+typename ServiceClient<CascadeTypes...>::template external_caller_t<SubgroupType>&
+ServiceClient<CascadeTypes...>::get_external_caller(uint32_t subgroup_index) const {
+    // The handles of the calling thread. The callers are owned by the external group client and live as long as it,
+    // so a thread only resolves a handle once per client and view.
+    struct caller_handles_t {
+        uint64_t client_id = 0;
+        uint64_t view_generation = 0;
+        std::vector<external_caller_t<SubgroupType>*> callers;
+    };
+    thread_local caller_handles_t handles;
+
+    const uint64_t generation = view_generation.load(std::memory_order_acquire);
+    if (handles.client_id != client_id || handles.view_generation != generation) {
+        handles.client_id = client_id;
+        handles.view_generation = generation;
+        handles.callers.clear();
+    }
+    if (subgroup_index >= handles.callers.size()) {
+        handles.callers.resize(subgroup_index + 1, nullptr);
+    }
+    if (handles.callers[subgroup_index] == nullptr) {
+        // the external group client creates the callers lazily, which is safe in a call run by external_call().
+        handles.callers[subgroup_index] = &external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
+    }
+    return *handles.callers[subgroup_index];
+}
+
+template <typename... CascadeTypes>
+template <typename CallFunc>
+auto ServiceClient<CascadeTypes...>::external_call(CallFunc&& call) const {
+    using result_t = std::invoke_result_t<CallFunc&,external_group_t&>;
+    std::conditional_t<std::is_void_v<result_t>,bool,std::optional<result_t>> result{};
+    std::exception_ptr error;
+    external_call_t submitted;
+    submitted.run = [&call,&result,&error](external_group_t& client) {
+        try {
+            if constexpr (std::is_void_v<result_t>) {
+                call(client);
+            } else {
+                result.emplace(call(client));
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+    };
+    submitted.next = external_calls.load(std::memory_order_relaxed);
+    while (!external_calls.compare_exchange_weak(submitted.next,&submitted,std::memory_order_release,std::memory_order_relaxed)) {
+    }
+    while (!submitted.done.load(std::memory_order_acquire)) {
+        if (external_sending.exchange(true,std::memory_order_acquire)) {
+            // another thread is sending, and runs this call if it was submitted before its last batch.
+            std::this_thread::yield();
+            continue;
+        }
+        // run the calls submitted so far, oldest first. A call is done once it returns, after which its thread may
+        // drop it, so the next one is read before.
+        external_call_t* pending = external_calls.exchange(nullptr,std::memory_order_acquire);
+        external_call_t* batch = nullptr;
+        while (pending != nullptr) {
+            external_call_t* next = pending->next;
+            pending->next = batch;
+            batch = pending;
+            pending = next;
+        }
+        while (batch != nullptr) {
+            external_call_t* next = batch->next;
+            batch->run(*external_group_ptr);
+            batch->done.store(true,std::memory_order_release);
+            batch = next;
+        }
+        external_sending.store(false,std::memory_order_release);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if constexpr (!std::is_void_v<result_t>) {
+        return std::move(*result);
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType, typename SendFunc>
+auto ServiceClient<CascadeTypes...>::external_send(uint32_t subgroup_index, SendFunc&& send) {
+    try {
+        // only the send runs in the external call; the reply is waited for by the calling thread.
+        return external_call([this,subgroup_index,&send](external_group_t&) {
+            return send(this->template get_external_caller<SubgroupType>(subgroup_index));
+        });
+    } catch (derecho::derecho_exception& ex) {
+        dbg_default_warn("{}: failed to send to subgroup {}: {}. Refreshing the view.",
+                         __PRETTY_FUNCTION__, subgroup_index, ex.what());
+        refresh_view();
+        throw;
+    }
+}
+
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::refresh_view() {
+    std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
+    {
+        std::unique_lock wlck(member_cache_mutex);
+        member_cache.clear();
+    }
+    view_generation.fetch_add(1,std::memory_order_acq_rel);
+    dbg_default_debug("ServiceClient {} refreshed its view, generation={}.", client_id, view_generation.load());
+}
+
 template <typename... CascadeTypes>
 template <typename KeyType>
 std::tuple<uint32_t,uint32_t,uint32_t> ServiceClient<CascadeTypes...>::key_to_shard(
@@ -526,37 +690,51 @@ node_id_t ServiceClient<CascadeTypes...>::pick_member_by_policy(uint32_t subgrou
 
     auto key = std::make_tuple(std::type_index(typeid(SubgroupType)),subgroup_index,shard_index);
 
-    if (member_cache.find(key) == member_cache.end() || retry) {
+    // The cache entry might be dropped by refresh_view() between the refresh and the lookup, so try again until it is
+    // found under the read lock.
+    std::shared_lock rlck(member_cache_mutex);
+    auto entry = member_cache.find(key);
+    bool refresh = retry;
+    while (entry == member_cache.end() || refresh) {
+        rlck.unlock();
         refresh_member_cache_entry<SubgroupType>(subgroup_index,shard_index);
+        refresh = false;
+        rlck.lock();
+        entry = member_cache.find(key);
+    }
+    const std::vector<node_id_t>& members = entry->second;
+    if (members.empty()) {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": shard " + std::to_string(shard_index) +
+                " of subgroup " + std::to_string(subgroup_index) + " has no member.");
     }
-
-    std::shared_lock rlck(member_cache_mutex);
 
     node_id_t node_id = last_specified_node_id_or_index;
 
     switch(policy) {
     case ShardMemberSelectionPolicy::FirstMember:
-        node_id = member_cache.at(key).front();
+        node_id = members.front();
         break;
     case ShardMemberSelectionPolicy::LastMember:
-        node_id = member_cache.at(key).back();
+        node_id = members.back();
         break;
     case ShardMemberSelectionPolicy::Random:
-        node_id = member_cache.at(key)[get_time()%member_cache.at(key).size()]; // use time as random source.
+        node_id = members[get_time()%members.size()]; // use time as random source.
         break;
     case ShardMemberSelectionPolicy::FixedRandom:
         if (node_id == INVALID_NODE_ID || retry) {
-            node_id = member_cache.at(key)[get_time()%member_cache.at(key).size()]; // use time as random source.
+            node_id = members[get_time()%members.size()]; // use time as random source.
         }
         break;
     case ShardMemberSelectionPolicy::RoundRobin:
         {
-            std::shared_lock rlck(member_selection_policies_mutex);
-            node_id = static_cast<uint32_t>(node_id+1)%member_cache.at(key).size();
-            auto new_policy = std::make_tuple(ShardMemberSelectionPolicy::RoundRobin,node_id);
-            member_selection_policies[key].swap(new_policy);
+            // the policy entry holds the round robin cursor, which is shared by all threads.
+            std::unique_lock wlck(member_selection_policies_mutex);
+            auto& cursor = member_selection_policies.try_emplace(key,
+                    ShardMemberSelectionPolicy::RoundRobin,last_specified_node_id_or_index).first->second;
+            node_id = static_cast<uint32_t>(std::get<1>(cursor)+1)%members.size();
+            std::get<1>(cursor) = node_id;
         }
-        node_id = member_cache.at(key)[node_id];
+        node_id = members[node_id];
         break;
     case ShardMemberSelectionPolicy::KeyHashing:
         {
@@ -569,7 +747,7 @@ node_id_t ServiceClient<CascadeTypes...>::pick_member_by_policy(uint32_t subgrou
                 dbg_default_warn("Key type {} is neither integral nor string, falling back to FirstMember policy. {}:{}",
                         typeid(KeyTypeForHashing).name(), __FILE__, __LINE__);
             }
-            node_id = member_cache.at(key)[hash % member_cache.at(key).size()];
+            node_id = members[hash % members.size()];
         }
         break;
     default:
@@ -589,7 +767,6 @@ derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::put(
     LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_PUT_START,
             (std::is_base_of<IHasMessageID,typename SubgroupType::ObjectType>::value?value.get_message_id():0));
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
             // ordered put as a shard member
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
@@ -608,11 +785,11 @@ derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::put(
             }
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
-        return caller.template p2p_send<RPC_NAME(put)>(node_id,value,as_trigger);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(put)>(node_id,value,as_trigger);
+        });
     }
 }
 
@@ -625,9 +802,17 @@ derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_r
         uint32_t shard_index,
         bool as_trigger) {
     if (type_index == 0) {
-        return this->template put<FirstType>(value,subgroup_index,shard_index,as_trigger);
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template put<FirstType>(value,subgroup_index,shard_index,as_trigger);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
-        return this->template type_recursive_put<ObjectType, SecondType, RestTypes...>(type_index-1,value,subgroup_index,shard_index,as_trigger);
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_put<ObjectType, SecondType, RestTypes...>(type_index-1,value,subgroup_index,shard_index,as_trigger);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     }
 }
 
@@ -640,7 +825,11 @@ derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_r
         uint32_t shard_index,
         bool as_trigger) {
     if (type_index == 0) {
-        return this->template put<LastType>(value,subgroup_index,shard_index,as_trigger);
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template put<LastType>(value,subgroup_index,shard_index,as_trigger);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
@@ -666,66 +855,85 @@ derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::put(
 
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-void ServiceClient<CascadeTypes...>::put_and_forget(
-        const typename SubgroupType::ObjectType& value,
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::put_batch(
+        const std::vector<typename SubgroupType::ObjectType>& objects,
         uint32_t subgroup_index,
         uint32_t shard_index,
         bool as_trigger) {
-    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_PUT_AND_FORGET_START,
-            (std::is_base_of<IHasMessageID,typename SubgroupType::ObjectType>::value?value.get_message_id():0));
+    if (objects.empty()) {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": the batch is empty.");
+    }
+    // the batch is applied by one ordered send, which may be relayed from a P2P request.
+    const uint64_t budget = std::min(p2p_request_payload_budget(),ordered_payload_budget());
+    const uint64_t batch_bytes = mutils::bytes_size(objects) + mutils::bytes_size(as_trigger);
+    if (batch_bytes > budget) {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": the batch of " + std::to_string(batch_bytes)
+                                         + " bytes does not fit in a message of " + std::to_string(budget) + " bytes.");
+    }
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
-            // do ordered put as a shard member (Replicated).
+            // ordered put_batch as a shard member
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-            subgroup_handle.template ordered_send<RPC_NAME(ordered_put_and_forget)>(value,as_trigger);
+            return subgroup_handle.template ordered_send<RPC_NAME(ordered_put_batch)>(objects,as_trigger);
         } else {
-            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
-            // do p2p put
-            try{
+            // p2p put_batch
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,objects.front().get_key_ref());
+            try {
                 // as a subgroup member
                 auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-                subgroup_handle.template p2p_send<RPC_NAME(put_and_forget)>(node_id,value,as_trigger);
+                return subgroup_handle.template p2p_send<RPC_NAME(put_batch)>(node_id,objects,as_trigger);
             } catch (derecho::invalid_subgroup_exception& ex) {
                 // as an external caller
                 auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-                subgroup_handle.template p2p_send<RPC_NAME(put_and_forget)>(node_id,value,as_trigger);
+                return subgroup_handle.template p2p_send<RPC_NAME(put_batch)>(node_id,objects,as_trigger);
             }
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
-        caller.template p2p_send<RPC_NAME(put_and_forget)>(node_id,value,as_trigger);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,objects.front().get_key_ref());
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(put_batch)>(node_id,objects,as_trigger);
+        });
     }
 }
 
 template <typename... CascadeTypes>
 template <typename ObjectType, typename FirstType, typename SecondType, typename... RestTypes>
-void ServiceClient<CascadeTypes...>::type_recursive_put_and_forget(
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_put_batch(
         uint32_t type_index,
-        const ObjectType& value,
+        const std::vector<ObjectType>& objects,
         uint32_t subgroup_index,
         uint32_t shard_index,
         bool as_trigger) {
     if (type_index == 0) {
-        put_and_forget<FirstType>(value,subgroup_index,shard_index,as_trigger);
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template put_batch<FirstType>(objects,subgroup_index,shard_index,as_trigger);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
-        type_recursive_put_and_forget<ObjectType,SecondType,RestTypes...>(type_index-1,value,subgroup_index,shard_index,as_trigger);
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_put_batch<ObjectType, SecondType, RestTypes...>(type_index-1,objects,subgroup_index,shard_index,as_trigger);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     }
 }
 
 template <typename... CascadeTypes>
 template <typename ObjectType, typename LastType>
-void ServiceClient<CascadeTypes...>::type_recursive_put_and_forget(
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_put_batch(
         uint32_t type_index,
-        const ObjectType& value,
+        const std::vector<ObjectType>& objects,
         uint32_t subgroup_index,
         uint32_t shard_index,
         bool as_trigger) {
     if (type_index == 0) {
-        put_and_forget<LastType>(value,subgroup_index,shard_index,as_trigger);
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template put_batch<LastType>(objects,subgroup_index,shard_index,as_trigger);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
@@ -733,74 +941,324 @@ void ServiceClient<CascadeTypes...>::type_recursive_put_and_forget(
 
 template <typename... CascadeTypes>
 template <typename ObjectType>
-void ServiceClient<CascadeTypes...>::put_and_forget(const ObjectType& value,bool as_trigger) {
-    // STEP 1 - get key
+std::vector<std::unique_ptr<derecho::rpc::QueryResults<version_tuple>>> ServiceClient<CascadeTypes...>::put_batch(
+        const std::vector<ObjectType>& objects, bool as_trigger) {
     if constexpr (!std::is_base_of_v<ICascadeObject<std::string,ObjectType>,ObjectType>) {
-        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports object of type ICascadeObject<std::string,ObjectType>,but we get ") + typeid(ObjectType).name());
+        throw derecho::derecho_exception(std::string("ServiceClient<>::put_batch() only support object of type ICascadeObject<std::string,ObjectType>,but we get ") + typeid(ObjectType).name());
+    }
+
+    // group the objects by shard, rejecting the whole batch before anything is sent if an object can not fit in a
+    // message by itself.
+    const uint64_t budget = std::min(p2p_request_payload_budget(),ordered_payload_budget());
+    const uint64_t empty_batch_bytes = mutils::bytes_size(std::vector<ObjectType>{}) + mutils::bytes_size(as_trigger);
+    std::map<std::tuple<uint32_t,uint32_t,uint32_t>,std::vector<ObjectType>> shard_batches;
+    for (const auto& object : objects) {
+        if (empty_batch_bytes + mutils::bytes_size(object) > budget) {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object " + object.get_key_ref() + " of "
+                                             + std::to_string(mutils::bytes_size(object)) + " bytes does not fit in a message of "
+                                             + std::to_string(budget) + " bytes.");
+        }
+        shard_batches[this->template key_to_shard(object.get_key_ref())].push_back(object);
+    }
+
+    // split the objects of each shard into sub-batches that fit in a message.
+    std::vector<std::unique_ptr<derecho::rpc::QueryResults<version_tuple>>> results;
+    for (auto& shard_batch : shard_batches) {
+        uint32_t subgroup_type_index,subgroup_index,shard_index;
+        std::tie(subgroup_type_index,subgroup_index,shard_index) = shard_batch.first;
+        std::vector<ObjectType> sub_batch;
+        uint64_t sub_batch_bytes = empty_batch_bytes;
+        auto send_sub_batch = [&]() {
+            results.emplace_back(std::make_unique<derecho::rpc::QueryResults<version_tuple>>(
+                    this->template type_recursive_put_batch<ObjectType,CascadeTypes...>(
+                            subgroup_type_index,sub_batch,subgroup_index,shard_index,as_trigger)));
+            sub_batch.clear();
+            sub_batch_bytes = empty_batch_bytes;
+        };
+        for (auto& object : shard_batch.second) {
+            const uint64_t object_bytes = mutils::bytes_size(object);
+            if (!sub_batch.empty() && sub_batch_bytes + object_bytes > budget) {
+                send_sub_batch();
+            }
+            sub_batch_bytes += object_bytes;
+            sub_batch.emplace_back(std::move(object));
+        }
+        send_sub_batch();
     }
+    return results;
+}
 
-    // STEP 2 - get shard
-    uint32_t subgroup_type_index,subgroup_index,shard_index;
-    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(value.get_key_ref());
+template <typename... CascadeTypes>
+version_tuple ServiceClient<CascadeTypes...>::put_chunked(const ObjectWithStringKey& object, uint64_t chunk_size) {
+    const std::string chunk_prefix = object.key + CASCADE_CHUNK_KEY_SEPARATOR + std::to_string(this->get_my_id()) +
+                                     "-" + std::to_string(get_time_ns()) + "-";
+    // a chunk index takes at most 20 digits.
+    const uint64_t chunk_size_limit = max_chunk_size(chunk_prefix.size() + 20);
+    if (chunk_size == 0) {
+        chunk_size = derecho::hasCustomizedConfKey(CASCADE_CHUNK_SIZE) ? derecho::getConfUInt64(CASCADE_CHUNK_SIZE) : chunk_size_limit;
+    }
+    if (chunk_size > chunk_size_limit) {
+        dbg_default_warn("{}: chunk size {} does not fit in a message, use {} instead.", __PRETTY_FUNCTION__, chunk_size, chunk_size_limit);
+        chunk_size = chunk_size_limit;
+    }
+    const std::size_t parallelism = std::max<std::size_t>(1,
+            derecho::hasCustomizedConfKey(CASCADE_CHUNK_PARALLELISM) ? derecho::getConfUInt32(CASCADE_CHUNK_PARALLELISM) : CASCADE_CHUNK_PARALLELISM_DEFAULT);
+    auto wait_for_version = [](derecho::rpc::QueryResults<version_tuple>& result) {
+        version_tuple ret{persistent::INVALID_VERSION,0};
+        for (auto& reply : result.get()) {
+            ret = reply.second.get();
+        }
+        return ret;
+    };
+
+    if (object.blob.size <= chunk_size) {
+        auto result = this->put(object);
+        return wait_for_version(result);
+    }
+    if (object.blob.memory_mode == object_memory_mode_t::BLOB_GENERATOR || object.blob.bytes == nullptr) {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": the payload of a chunked object must be in memory.");
+    }
+
+    // read the object the manifest replaces, whose chunks are removed once it is replaced. The read is not stable, so
+    // its version is the one the manifest is checked against.
+    auto read_current = [this,&object](std::unique_ptr<ChunkedObjectManifest>& current_manifest) {
+        persistent::version_t current_version = persistent::INVALID_VERSION;
+        current_manifest.reset();
+        auto result = this->get(object.key,CURRENT_VERSION,false);
+        for (auto& reply : result.get()) {
+            auto current = reply.second.get();
+            if (current.is_valid()) {
+                current_version = current.get_version();
+            }
+            if (ChunkedObjectManifest::is_manifest(current.blob.bytes,current.blob.size)) {
+                current_manifest = mutils::from_bytes<ChunkedObjectManifest>(nullptr,current.blob.bytes);
+            }
+            break;
+        }
+        return current_version;
+    };
+    std::unique_ptr<ChunkedObjectManifest> old_manifest;
+    persistent::version_t old_version = read_current(old_manifest);
+
+    ChunkedObjectManifest manifest(ChunkedObjectManifest::MAGIC,object.blob.size,chunk_size,chunk_prefix);
+    auto remove_chunks = [this,parallelism](const ChunkedObjectManifest& chunks) {
+        std::deque<std::unique_ptr<derecho::rpc::QueryResults<version_tuple>>> in_flight;
+        for (uint64_t index = 0; index < chunks.num_chunks(); index++) {
+            in_flight.emplace_back(std::make_unique<derecho::rpc::QueryResults<version_tuple>>(this->remove(chunks.chunk_key(index))));
+            while (in_flight.size() >= parallelism || (index + 1 == chunks.num_chunks() && !in_flight.empty())) {
+                for (auto& reply : in_flight.front()->get()) {
+                    reply.second.get();
+                }
+                in_flight.pop_front();
+            }
+        }
+    };
+
+    std::deque<std::unique_ptr<derecho::rpc::QueryResults<version_tuple>>> in_flight;
+    bool rejected = false;
+    for (uint64_t index = 0; index < manifest.num_chunks(); index++) {
+        ObjectWithStringKey chunk;
+        chunk.key = manifest.chunk_key(index);
+        // the chunk refers to the payload of the object, which is serialized by put without a copy.
+        chunk.blob = Blob(object.blob.bytes + index * chunk_size,manifest.chunk_bytes(index),true);
+        in_flight.emplace_back(std::make_unique<derecho::rpc::QueryResults<version_tuple>>(this->put(chunk)));
+        while (in_flight.size() >= parallelism || (index + 1 == manifest.num_chunks() && !in_flight.empty())) {
+            rejected |= (std::get<0>(wait_for_version(*in_flight.front())) == persistent::INVALID_VERSION);
+            in_flight.pop_front();
+        }
+    }
+    if (rejected) {
+        remove_chunks(manifest);
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": a chunk of " + object.key + " is rejected.");
+    }
+
+    ObjectWithStringKey manifest_object;
+    manifest_object.key = object.key;
+    manifest_object.previous_version = object.previous_version;
+    manifest_object.previous_version_by_key = object.previous_version_by_key;
+    std::vector<uint8_t> manifest_bytes(mutils::bytes_size(manifest));
+    mutils::to_bytes(manifest,manifest_bytes.data());
+    manifest_object.blob = Blob(manifest_bytes.data(),manifest_bytes.size());
+    // the manifest only replaces the object read above, so the chunks of a manifest put concurrently are not orphaned.
+    const bool checked_by_caller = (object.previous_version_by_key != persistent::INVALID_VERSION);
+    constexpr uint32_t max_attempts = 3;
+    for (uint32_t attempt = 1;; attempt++) {
+        if (!checked_by_caller) {
+            // INVALID_VERSION disables the check, so a key that does not exist is expected at version 0, which is
+            // older than any version of an existing key but the first version of the subgroup.
+            manifest_object.previous_version_by_key = (old_version == persistent::INVALID_VERSION) ? 0 : old_version;
+        }
+        auto result = this->put(manifest_object);
+        auto ret = wait_for_version(result);
+        if (std::get<0>(ret) != persistent::INVALID_VERSION) {
+            if (old_manifest) {
+                remove_chunks(*old_manifest);
+            }
+            return ret;
+        }
+        if (checked_by_caller) {
+            // the manifest failed the previous version check of the caller, so the object is not replaced.
+            remove_chunks(manifest);
+            return ret;
+        }
+        if (attempt >= max_attempts) {
+            remove_chunks(manifest);
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": " + object.key + " keeps being updated concurrently.");
+        }
+        dbg_default_debug("{}: {} is updated concurrently, retry.", __PRETTY_FUNCTION__, object.key);
+        old_version = read_current(old_manifest);
+    }
+}
 
-    // STEP 3 - call recursive put_and_forget
-    this->template type_recursive_put_and_forget<ObjectType,CascadeTypes...>(subgroup_type_index,value,subgroup_index,shard_index,as_trigger);
+template <typename... CascadeTypes>
+ObjectWithStringKey ServiceClient<CascadeTypes...>::get_chunked(const std::string& key) {
+    const std::size_t parallelism = std::max<std::size_t>(1,
+            derecho::hasCustomizedConfKey(CASCADE_CHUNK_PARALLELISM) ? derecho::getConfUInt32(CASCADE_CHUNK_PARALLELISM) : CASCADE_CHUNK_PARALLELISM_DEFAULT);
+    // a concurrent put_chunked removes the chunks of the manifest it replaces, so a reader tries the new manifest.
+    constexpr uint32_t max_attempts = 3;
+    for (uint32_t attempt = 1;; attempt++) {
+        auto result = this->get(key,CURRENT_VERSION,true);
+        auto& replies = result.get();
+        if (replies.empty()) {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": no reply for " + key + ".");
+        }
+        ObjectWithStringKey object(replies.begin()->second.get());
+        if (!ChunkedObjectManifest::is_manifest(object.blob.bytes,object.blob.size)) {
+            return object;
+        }
+        auto manifest = mutils::from_bytes<ChunkedObjectManifest>(nullptr,object.blob.bytes);
+
+        std::shared_ptr<uint8_t> buffer(static_cast<uint8_t*>(malloc(manifest->object_size)),free);
+        if (!buffer) {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": failed to allocate " + std::to_string(manifest->object_size) + " bytes.");
+        }
+        using chunk_result_t = decltype(this->get(key,CURRENT_VERSION,true));
+        std::deque<std::pair<uint64_t,std::unique_ptr<chunk_result_t>>> in_flight;
+        bool complete = true;
+        for (uint64_t index = 0; index < manifest->num_chunks(); index++) {
+            in_flight.emplace_back(index,std::make_unique<chunk_result_t>(this->get(manifest->chunk_key(index),CURRENT_VERSION,true)));
+            while (in_flight.size() >= parallelism || (index + 1 == manifest->num_chunks() && !in_flight.empty())) {
+                const uint64_t chunk_index = in_flight.front().first;
+                for (auto& reply : in_flight.front().second->get()) {
+                    auto chunk = reply.second.get();
+                    if (chunk.is_null() || !chunk.is_valid() || chunk.blob.size != manifest->chunk_bytes(chunk_index)) {
+                        complete = false;
+                    } else if (complete) {
+                        memcpy(buffer.get() + chunk_index * manifest->chunk_size,chunk.blob.bytes,chunk.blob.size);
+                    }
+                    break;
+                }
+                in_flight.pop_front();
+            }
+        }
+        if (complete) {
+            object.blob = Blob(std::shared_ptr<const uint8_t>(buffer),manifest->object_size);
+            return object;
+        }
+        if (attempt >= max_attempts) {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": chunks of " + key + " are missing.");
+        }
+        dbg_default_debug("{}: chunks of {} are missing, retry.", __PRETTY_FUNCTION__, key);
+    }
+}
+
+template <typename... CascadeTypes>
+version_tuple ServiceClient<CascadeTypes...>::remove_chunked(const std::string& key) {
+    std::unique_ptr<ChunkedObjectManifest> manifest;
+    {
+        auto result = this->get(key,CURRENT_VERSION,true);
+        for (auto& reply : result.get()) {
+            auto object = reply.second.get();
+            if (ChunkedObjectManifest::is_manifest(object.blob.bytes,object.blob.size)) {
+                manifest = mutils::from_bytes<ChunkedObjectManifest>(nullptr,object.blob.bytes);
+            }
+            break;
+        }
+    }
+    version_tuple ret{persistent::INVALID_VERSION,0};
+    auto result = this->remove(key);
+    for (auto& reply : result.get()) {
+        ret = reply.second.get();
+    }
+    if (manifest) {
+        for (uint64_t index = 0; index < manifest->num_chunks(); index++) {
+            auto chunk_result = this->remove(manifest->chunk_key(index));
+            for (auto& reply : chunk_result.get()) {
+                reply.second.get();
+            }
+        }
+    }
+    return ret;
 }
 
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::trigger_put(
-        const typename SubgroupType::ObjectType& value,
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::put_range(
+        const typename SubgroupType::ObjectType& patch,
+        uint64_t offset,
         uint32_t subgroup_index,
         uint32_t shard_index) {
-    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_TRIGGER_PUT_START,
-            (std::is_base_of<IHasMessageID,typename SubgroupType::ObjectType>::value?value.get_message_id():0));
+    static_assert(is_persistent_cascade_store<SubgroupType>::value, "Partial update is only supported by PersistentCascadeStore.");
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
-        if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index){
+        if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+            // ordered put_range as a shard member
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
-            dbg_default_trace("trigger_put to node {}",node_id);
-            return subgroup_handle.template p2p_send<RPC_NAME(trigger_put)>(node_id,value);
+            return subgroup_handle.template ordered_send<RPC_NAME(ordered_put_range)>(patch,offset);
         } else {
-            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
-            dbg_default_trace("trigger_put to node {}",node_id);
-            return subgroup_handle.template p2p_send<RPC_NAME(trigger_put)>(node_id,value);
+            // p2p put_range
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,patch.get_key_ref());
+            try {
+                // as a subgroup member
+                auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+                return subgroup_handle.template p2p_send<RPC_NAME(put_range)>(node_id,patch,offset);
+            } catch (derecho::invalid_subgroup_exception& ex) {
+                // as an external caller
+                auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                return subgroup_handle.template p2p_send<RPC_NAME(put_range)>(node_id,patch,offset);
+            }
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
-        dbg_default_trace("trigger_put to node {}",node_id);
-        return caller.template p2p_send<RPC_NAME(trigger_put)>(node_id,value);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,patch.get_key_ref());
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(put_range)>(node_id,patch,offset);
+        });
     }
 }
 
 template <typename... CascadeTypes>
 template <typename ObjectType, typename FirstType, typename SecondType, typename... RestTypes>
-derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::type_recursive_trigger_put(
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_put_range(
         uint32_t type_index,
-        const ObjectType& value,
+        const ObjectType& patch,
+        uint64_t offset,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return trigger_put<FirstType>(value,subgroup_index,shard_index);
+        if constexpr (is_persistent_cascade_store<FirstType>::value) {
+            return this->template put_range<FirstType>(patch,offset,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": partial update is only supported by PersistentCascadeStore.");
+        }
     } else {
-        return type_recursive_trigger_put<ObjectType,SecondType,RestTypes...>(type_index-1,value,subgroup_index,shard_index);
+        return this->template type_recursive_put_range<ObjectType, SecondType, RestTypes...>(type_index-1,patch,offset,subgroup_index,shard_index);
     }
 }
 
 template <typename... CascadeTypes>
 template <typename ObjectType, typename LastType>
-derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::type_recursive_trigger_put(
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_put_range(
         uint32_t type_index,
-        const ObjectType& value,
+        const ObjectType& patch,
+        uint64_t offset,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return trigger_put<LastType>(value,subgroup_index,shard_index);
+        if constexpr (is_persistent_cascade_store<LastType>::value) {
+            return this->template put_range<LastType>(patch,offset,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": partial update is only supported by PersistentCascadeStore.");
+        }
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
@@ -808,361 +1266,402 @@ derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::type_recursive_
 
 template <typename... CascadeTypes>
 template <typename ObjectType>
-derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::trigger_put(
-        const ObjectType& value) {
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::put_range(
+        const ObjectType& patch, uint64_t offset) {
+
     // STEP 1 - get key
     if constexpr (!std::is_base_of_v<ICascadeObject<std::string,ObjectType>,ObjectType>) {
-        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports object of type ICascadeObject<std::string,ObjectType>,but we get ") + typeid(ObjectType).name());
+        throw derecho::derecho_exception(std::string("ServiceClient<>::put_range() only support object of type ICascadeObject<std::string,ObjectType>,but we get ") + typeid(ObjectType).name());
     }
 
     // STEP 2 - get shard
     uint32_t subgroup_type_index,subgroup_index,shard_index;
-    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(value.get_key_ref());
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(patch.get_key_ref());
 
-    // STEP 3 - call recursive trigger_put
-    return this->template type_recursive_trigger_put<ObjectType,CascadeTypes...>(subgroup_type_index,value,subgroup_index,shard_index);
+    // STEP 3 - call recursive put_range
+    return this->template type_recursive_put_range<ObjectType,CascadeTypes...>(subgroup_type_index,patch,offset,subgroup_index,shard_index);
 }
 
 template <typename... CascadeTypes>
-template <typename SubgroupType>
-void ServiceClient<CascadeTypes...>::collective_trigger_put(
-        const typename SubgroupType::ObjectType& value,
-        uint32_t subgroup_index,
-        std::unordered_map<node_id_t,std::unique_ptr<derecho::rpc::QueryResults<void>>>& nodes_and_futures) {
-    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_COLLECTIVE_TRIGGER_PUT_START,
-            (std::is_base_of<IHasMessageID,typename SubgroupType::ObjectType>::value?value.get_message_id():0));
-    if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
-        if (group_ptr->template get_my_shard<SubgroupType>(subgroup_index) != -1) {
-            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-            for (auto& kv: nodes_and_futures) {
-                nodes_and_futures[kv.first] = std::make_unique<derecho::rpc::QueryResults<void>>(
-                        std::move(subgroup_handle.template p2p_send<RPC_NAME(trigger_put)>(kv.first,value)));
-            }
-        } else {
-            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            for (auto& kv: nodes_and_futures) {
-                nodes_and_futures[kv.first] = std::make_unique<derecho::rpc::QueryResults<void>>(
-                        std::move(subgroup_handle.template p2p_send<RPC_NAME(trigger_put)>(kv.first,value)));
-            }
-        }
-    } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-        for (auto& kv: nodes_and_futures) {
-            nodes_and_futures[kv.first] = std::make_unique<derecho::rpc::QueryResults<void>>(
-                    std::move(caller.template p2p_send<RPC_NAME(trigger_put)>(kv.first,value)));
-        }
-    }
+template <typename ObjectType>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::append(const ObjectType& patch) {
+    return this->template put_range<ObjectType>(patch,IPatchPayload::APPEND_OFFSET);
 }
 
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::remove(
-        const typename SubgroupType::KeyType& key,
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::merge(
+        const typename SubgroupType::ObjectType& operand,
+        const std::string& merge_operator,
         uint32_t subgroup_index,
         uint32_t shard_index) {
-    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_REMOVE_START,0);
+    static_assert(is_persistent_cascade_store<SubgroupType>::value || is_volatile_cascade_store<SubgroupType>::value,
+                  "Merge is only supported by VolatileCascadeStore and PersistentCascadeStore.");
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
-            // do ordered remove as a member (Replicated).
+            // ordered merge as a shard member
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template ordered_send<RPC_NAME(ordered_remove)>(key);
+            return subgroup_handle.template ordered_send<RPC_NAME(ordered_merge)>(operand,merge_operator);
         } else {
-            // do p2p remove
-            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+            // p2p merge
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,operand.get_key_ref());
             try {
                 // as a subgroup member
                 auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-                return subgroup_handle.template p2p_send<RPC_NAME(remove)>(node_id,key);
+                return subgroup_handle.template p2p_send<RPC_NAME(merge)>(node_id,operand,merge_operator);
             } catch (derecho::invalid_subgroup_exception& ex) {
                 // as an external caller
                 auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-                return subgroup_handle.template p2p_send<RPC_NAME(remove)>(node_id,key);
+                return subgroup_handle.template p2p_send<RPC_NAME(merge)>(node_id,operand,merge_operator);
             }
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(remove)>(node_id,key);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,operand.get_key_ref());
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(merge)>(node_id,operand,merge_operator);
+        });
     }
 }
 
 template <typename... CascadeTypes>
-template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
-derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_remove(
+template <typename ObjectType, typename FirstType, typename SecondType, typename... RestTypes>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_merge(
         uint32_t type_index,
-        const KeyType& key,
+        const ObjectType& operand,
+        const std::string& merge_operator,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template remove<FirstType>(key,subgroup_index,shard_index);
+        if constexpr (is_persistent_cascade_store<FirstType>::value || is_volatile_cascade_store<FirstType>::value) {
+            return this->template merge<FirstType>(operand,merge_operator,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": merge is only supported by VolatileCascadeStore and PersistentCascadeStore.");
+        }
     } else {
-        return this->template type_recursive_remove<KeyType,SecondType,RestTypes...>(type_index-1,key,subgroup_index,shard_index);
+        return this->template type_recursive_merge<ObjectType, SecondType, RestTypes...>(type_index-1,operand,merge_operator,subgroup_index,shard_index);
     }
 }
 
 template <typename... CascadeTypes>
-template <typename KeyType, typename LastType>
-derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_remove(
+template <typename ObjectType, typename LastType>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_merge(
         uint32_t type_index,
-        const KeyType& key,
+        const ObjectType& operand,
+        const std::string& merge_operator,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template remove<LastType>(key,subgroup_index,shard_index);
+        if constexpr (is_persistent_cascade_store<LastType>::value || is_volatile_cascade_store<LastType>::value) {
+            return this->template merge<LastType>(operand,merge_operator,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": merge is only supported by VolatileCascadeStore and PersistentCascadeStore.");
+        }
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
 }
 
 template <typename... CascadeTypes>
-template <typename KeyType>
-derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::remove(
-        const KeyType& key) {
+template <typename ObjectType>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::merge(
+        const ObjectType& operand, const std::string& merge_operator) {
+
     // STEP 1 - get key
-    if constexpr (!std::is_convertible_v<KeyType,std::string>) {
-        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
+    if constexpr (!std::is_base_of_v<ICascadeObject<std::string,ObjectType>,ObjectType>) {
+        throw derecho::derecho_exception(std::string("ServiceClient<>::merge() only support object of type ICascadeObject<std::string,ObjectType>,but we get ") + typeid(ObjectType).name());
     }
 
     // STEP 2 - get shard
     uint32_t subgroup_type_index,subgroup_index,shard_index;
-    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(operand.get_key_ref());
 
-    // STEP 3 - call recursive remove
-    return this->template type_recursive_remove<KeyType,CascadeTypes...>(subgroup_type_index,key,subgroup_index,shard_index);
+    // STEP 3 - call recursive merge
+    return this->template type_recursive_merge<ObjectType,CascadeTypes...>(subgroup_type_index,operand,merge_operator,subgroup_index,shard_index);
 }
 
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::get(
-        const typename SubgroupType::KeyType& key,
-        const persistent::version_t& version,
-        bool stable,
+void ServiceClient<CascadeTypes...>::put_and_forget(
+        const typename SubgroupType::ObjectType& value,
         uint32_t subgroup_index,
-        uint32_t shard_index) {
-    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_GET_START,0);
+        uint32_t shard_index,
+        bool as_trigger) {
+    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_PUT_AND_FORGET_START,
+            (std::is_base_of<IHasMessageID,typename SubgroupType::ObjectType>::value?value.get_message_id():0));
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        try {
-            // do p2p get as a subgroup member
+        if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+            // do ordered put as a shard member (Replicated).
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
-                node_id = group_ptr->get_my_id();
-                // local get
-                auto obj = subgroup_handle.get_ref().get(key,version,stable);
-                auto pending_results = std::make_shared<PendingResults<const typename SubgroupType::ObjectType>>();
-                pending_results->fulfill_map({node_id});
-                pending_results->set_value(node_id,obj);
-                auto query_results = pending_results->get_future();
-                return std::move(*query_results);
-            }
-            return subgroup_handle.template p2p_send<RPC_NAME(get)>(node_id,key,version,stable,false);
-        } catch (derecho::invalid_subgroup_exception& ex) {
-            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(get)>(node_id,key,version,stable,false);
-        }
-    } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
-        // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(get)>(node_id,key,version,stable,false);
-    }
-}
-
-template <typename... CascadeTypes>
-template <typename SubgroupType>
-derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::multi_get(
-        const typename SubgroupType::KeyType& key,
-        uint32_t subgroup_index,
-        uint32_t shard_index) {
-    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_MULTI_GET_START,0);
-    if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        try {
-            // do p2p multi_get as a subgroup member.
-            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
-                node_id = group_ptr->get_my_id();
+            subgroup_handle.template ordered_send<RPC_NAME(ordered_put_and_forget)>(value,as_trigger);
+        } else {
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
+            // do p2p put
+            try{
+                // as a subgroup member
+                auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+                subgroup_handle.template p2p_send<RPC_NAME(put_and_forget)>(node_id,value,as_trigger);
+            } catch (derecho::invalid_subgroup_exception& ex) {
+                // as an external caller
+                auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                subgroup_handle.template p2p_send<RPC_NAME(put_and_forget)>(node_id,value,as_trigger);
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(multi_get)>(node_id,key);
-        } catch (derecho::invalid_subgroup_exception& ex) {
-            // do p2p multi_get as an external caller.
-            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(multi_get)>(node_id,key);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(multi_get)>(node_id,key);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
+        this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            caller.template p2p_send<RPC_NAME(put_and_forget)>(node_id,value,as_trigger);
+        });
     }
 }
 
 template <typename... CascadeTypes>
-template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
-auto ServiceClient<CascadeTypes...>::type_recursive_get(
+template <typename ObjectType, typename FirstType, typename SecondType, typename... RestTypes>
+void ServiceClient<CascadeTypes...>::type_recursive_put_and_forget(
         uint32_t type_index,
-        const KeyType& key,
-        const persistent::version_t& version,
-        bool stable,
+        const ObjectType& value,
         uint32_t subgroup_index,
-        uint32_t shard_index) {
+        uint32_t shard_index,
+        bool as_trigger) {
     if (type_index == 0) {
-        return this->template get<FirstType>(key,version,stable,subgroup_index,shard_index);
+        if constexpr (is_object_pool_type<FirstType>()) {
+            put_and_forget<FirstType>(value,subgroup_index,shard_index,as_trigger);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
-        return this->template type_recursive_get<KeyType,SecondType,RestTypes...>(type_index-1,key,version,stable,subgroup_index,shard_index);
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            type_recursive_put_and_forget<ObjectType,SecondType,RestTypes...>(type_index-1,value,subgroup_index,shard_index,as_trigger);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     }
 }
 
 template <typename... CascadeTypes>
-template <typename KeyType, typename LastType>
-auto ServiceClient<CascadeTypes...>::type_recursive_get(
+template <typename ObjectType, typename LastType>
+void ServiceClient<CascadeTypes...>::type_recursive_put_and_forget(
         uint32_t type_index,
-        const KeyType& key,
-        const persistent::version_t& version,
-        bool stable,
+        const ObjectType& value,
         uint32_t subgroup_index,
-        uint32_t shard_index) {
+        uint32_t shard_index,
+        bool as_trigger) {
     if (type_index == 0) {
-        return this->template get<LastType>(key,version,stable,subgroup_index,shard_index);
+        if constexpr (is_object_pool_type<LastType>()) {
+            put_and_forget<LastType>(value,subgroup_index,shard_index,as_trigger);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
 }
 
 template <typename... CascadeTypes>
-template <typename KeyType>
-auto ServiceClient<CascadeTypes...>::get(
-        // const std::decay_t<typename std::result_of_t<decltype(&ObjectType::get_key_ref())>>& key,
-        const KeyType& key,
-        const persistent::version_t& version,
-        bool stable) {
+template <typename ObjectType>
+void ServiceClient<CascadeTypes...>::put_and_forget(const ObjectType& value,bool as_trigger) {
     // STEP 1 - get key
-    if constexpr (!std::is_convertible_v<KeyType,std::string>) {
-        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
+    if constexpr (!std::is_base_of_v<ICascadeObject<std::string,ObjectType>,ObjectType>) {
+        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports object of type ICascadeObject<std::string,ObjectType>,but we get ") + typeid(ObjectType).name());
     }
 
     // STEP 2 - get shard
     uint32_t subgroup_type_index,subgroup_index,shard_index;
-    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(value.get_key_ref());
 
-    // STEP 3 - call recursive get
-    return this->template type_recursive_get<KeyType,CascadeTypes...>(subgroup_type_index,key,version,stable,subgroup_index,shard_index);
+    // STEP 3 - call recursive put_and_forget
+    this->template type_recursive_put_and_forget<ObjectType,CascadeTypes...>(subgroup_type_index,value,subgroup_index,shard_index,as_trigger);
 }
 
 template <typename... CascadeTypes>
-template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
-auto ServiceClient<CascadeTypes...>::type_recursive_multi_get(
+template <typename SubgroupType>
+derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::trigger_put(
+        const typename SubgroupType::ObjectType& value,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_TRIGGER_PUT_START,
+            (std::is_base_of<IHasMessageID,typename SubgroupType::ObjectType>::value?value.get_message_id():0));
+    if (!is_external_client()) {
+        if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index){
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
+            dbg_default_trace("trigger_put to node {}",node_id);
+            return subgroup_handle.template p2p_send<RPC_NAME(trigger_put)>(node_id,value);
+        } else {
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
+            dbg_default_trace("trigger_put to node {}",node_id);
+            return subgroup_handle.template p2p_send<RPC_NAME(trigger_put)>(node_id,value);
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,value.get_key_ref());
+        dbg_default_trace("trigger_put to node {}",node_id);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(trigger_put)>(node_id,value);
+        });
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename ObjectType, typename FirstType, typename SecondType, typename... RestTypes>
+derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::type_recursive_trigger_put(
         uint32_t type_index,
-        const KeyType& key,
+        const ObjectType& value,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template multi_get<FirstType>(key,subgroup_index,shard_index);
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return trigger_put<FirstType>(value,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
-        return this->template type_recursive_multi_get<KeyType,SecondType,RestTypes...>(type_index-1,key,subgroup_index,shard_index);
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return type_recursive_trigger_put<ObjectType,SecondType,RestTypes...>(type_index-1,value,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     }
 }
 
 template <typename... CascadeTypes>
-template <typename KeyType, typename LastType>
-auto ServiceClient<CascadeTypes...>::type_recursive_multi_get(
+template <typename ObjectType, typename LastType>
+derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::type_recursive_trigger_put(
         uint32_t type_index,
-        const KeyType& key,
+        const ObjectType& value,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template multi_get<LastType>(key,subgroup_index,shard_index);
+        if constexpr (is_object_pool_type<LastType>()) {
+            return trigger_put<LastType>(value,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
 }
 
 template <typename... CascadeTypes>
-template <typename KeyType>
-auto ServiceClient<CascadeTypes...>::multi_get(
-        const KeyType& key) {
+template <typename ObjectType>
+derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::trigger_put(
+        const ObjectType& value) {
     // STEP 1 - get key
-    if constexpr (!std::is_convertible_v<KeyType,std::string>) {
-        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
+    if constexpr (!std::is_base_of_v<ICascadeObject<std::string,ObjectType>,ObjectType>) {
+        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports object of type ICascadeObject<std::string,ObjectType>,but we get ") + typeid(ObjectType).name());
     }
 
     // STEP 2 - get shard
     uint32_t subgroup_type_index,subgroup_index,shard_index;
-    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(value.get_key_ref());
 
-    // STEP 3 - call recursive get
-    return this->template type_recursive_multi_get<KeyType,CascadeTypes...>(subgroup_type_index,key,subgroup_index,shard_index);
+    // STEP 3 - call recursive trigger_put
+    return this->template type_recursive_trigger_put<ObjectType,CascadeTypes...>(subgroup_type_index,value,subgroup_index,shard_index);
 }
 
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::get_by_time(
+void ServiceClient<CascadeTypes...>::collective_trigger_put(
+        const typename SubgroupType::ObjectType& value,
+        uint32_t subgroup_index,
+        std::unordered_map<node_id_t,std::unique_ptr<derecho::rpc::QueryResults<void>>>& nodes_and_futures) {
+    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_COLLECTIVE_TRIGGER_PUT_START,
+            (std::is_base_of<IHasMessageID,typename SubgroupType::ObjectType>::value?value.get_message_id():0));
+    if (!is_external_client()) {
+        if (group_ptr->template get_my_shard<SubgroupType>(subgroup_index) != -1) {
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            for (auto& kv: nodes_and_futures) {
+                nodes_and_futures[kv.first] = std::make_unique<derecho::rpc::QueryResults<void>>(
+                        std::move(subgroup_handle.template p2p_send<RPC_NAME(trigger_put)>(kv.first,value)));
+            }
+        } else {
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            for (auto& kv: nodes_and_futures) {
+                nodes_and_futures[kv.first] = std::make_unique<derecho::rpc::QueryResults<void>>(
+                        std::move(subgroup_handle.template p2p_send<RPC_NAME(trigger_put)>(kv.first,value)));
+            }
+        }
+    } else {
+        for (auto& kv: nodes_and_futures) {
+            nodes_and_futures[kv.first] = std::make_unique<derecho::rpc::QueryResults<void>>(
+                    this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+                        return caller.template p2p_send<RPC_NAME(trigger_put)>(kv.first,value);
+                    }));
+        }
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::remove(
         const typename SubgroupType::KeyType& key,
-        const uint64_t& ts_us,
-        const bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
+    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_REMOVE_START,0);
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        try {
-            // do p2p get_by_time
+        if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+            // do ordered remove as a member (Replicated).
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
-                // as a shard member.
-                node_id = group_ptr->get_my_id();
+            return subgroup_handle.template ordered_send<RPC_NAME(ordered_remove)>(key);
+        } else {
+            // do p2p remove
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+            try {
+                // as a subgroup member
+                auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+                return subgroup_handle.template p2p_send<RPC_NAME(remove)>(node_id,key);
+            } catch (derecho::invalid_subgroup_exception& ex) {
+                // as an external caller
+                auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                return subgroup_handle.template p2p_send<RPC_NAME(remove)>(node_id,key);
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(get_by_time)>(node_id,key,ts_us,stable);
-        } catch (derecho::invalid_subgroup_exception& ex) {
-            // do p2p get_by_time as an external caller
-            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(get_by_time)>(node_id,key,ts_us,stable);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>();
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(get_by_time)>(node_id,key,ts_us,stable);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(remove)>(node_id,key);
+        });
     }
 }
 
 template <typename... CascadeTypes>
 template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
-auto ServiceClient<CascadeTypes...>::type_recursive_get_by_time(
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_remove(
         uint32_t type_index,
         const KeyType& key,
-        const uint64_t& ts_us,
-        const bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template get_by_time<FirstType>(key,ts_us,stable,subgroup_index,shard_index);
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template remove<FirstType>(key,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
-        return this->template type_recursive_get_by_time<KeyType,SecondType,RestTypes...>(type_index-1,key,ts_us,stable,subgroup_index,shard_index);
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_remove<KeyType,SecondType,RestTypes...>(type_index-1,key,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     }
 }
 
 template <typename... CascadeTypes>
 template <typename KeyType, typename LastType>
-auto ServiceClient<CascadeTypes...>::type_recursive_get_by_time(
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_remove(
         uint32_t type_index,
         const KeyType& key,
-        const uint64_t& ts_us,
-        const bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template get_by_time<LastType>(key,ts_us,stable,subgroup_index,shard_index);
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template remove<LastType>(key,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
@@ -1170,10 +1669,8 @@ auto ServiceClient<CascadeTypes...>::type_recursive_get_by_time(
 
 template <typename... CascadeTypes>
 template <typename KeyType>
-auto ServiceClient<CascadeTypes...>::get_by_time(
-        const KeyType& key,
-        const uint64_t& ts_us,
-        const bool stable) {
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::remove(
+        const KeyType& key) {
     // STEP 1 - get key
     if constexpr (!std::is_convertible_v<KeyType,std::string>) {
         throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
@@ -1183,71 +1680,156 @@ auto ServiceClient<CascadeTypes...>::get_by_time(
     uint32_t subgroup_type_index,subgroup_index,shard_index;
     std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
 
-    // STEP 3 - call recursive get_by_time
-    return this->template type_recursive_get_by_time<KeyType,CascadeTypes...>(subgroup_type_index,key,ts_us,stable,subgroup_index,shard_index);
+    // STEP 3 - call recursive remove
+    return this->template type_recursive_remove<KeyType,CascadeTypes...>(subgroup_type_index,key,subgroup_index,shard_index);
 }
 
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size(
+derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::get(
         const typename SubgroupType::KeyType& key,
         const persistent::version_t& version,
-        const bool stable,
+        bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
-    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_GET_SIZE_START,0);
+    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_GET_START,0);
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
         try {
-            // do p2p get_size as a subgroup_member
+            // do p2p get as a subgroup member
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
             if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
-                // as a shard member.
                 node_id = group_ptr->get_my_id();
+                // local get
+                auto obj = subgroup_handle.get_ref().get(key,version,stable);
+                auto pending_results = std::make_shared<PendingResults<const typename SubgroupType::ObjectType>>();
+                pending_results->fulfill_map({node_id});
+                pending_results->set_value(node_id,obj);
+                auto query_results = pending_results->get_future();
+                return std::move(*query_results);
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(get_size)>(node_id,key,version,stable,false);
+            return subgroup_handle.template p2p_send<RPC_NAME(get)>(node_id,key,version,stable,false);
         } catch (derecho::invalid_subgroup_exception& ex) {
-            // do p2p get_size as an external caller
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(get_size)>(node_id,key,version,stable,false);
+            return subgroup_handle.template p2p_send<RPC_NAME(get)>(node_id,key,version,stable,false);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(get_size)>(node_id,key,version,stable,false);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(get)>(node_id,key,version,stable,false);
+        });
     }
 }
 
 template <typename... CascadeTypes>
-template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
-derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recursive_get_size(
-        uint32_t type_index,
+template <typename SubgroupType>
+derecho::rpc::QueryResults<version_page_t<typename SubgroupType::ObjectType>> ServiceClient<CascadeTypes...>::get_versions(
+        const typename SubgroupType::KeyType& key,
+        const persistent::version_t& ver_begin,
+        const persistent::version_t& ver_end,
+        uint32_t max_count,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    static_assert(is_persistent_cascade_store<SubgroupType>::value, "get_versions is only supported by PersistentCascadeStore.");
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        try {
+            // do p2p get_versions as a subgroup member
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                node_id = group_ptr->get_my_id();
+                // local get_versions
+                auto page = subgroup_handle.get_ref().get_versions(key,ver_begin,ver_end,max_count);
+                auto pending_results = std::make_shared<PendingResults<version_page_t<typename SubgroupType::ObjectType>>>();
+                pending_results->fulfill_map({node_id});
+                pending_results->set_value(node_id,page);
+                auto query_results = pending_results->get_future();
+                return std::move(*query_results);
+            }
+            return subgroup_handle.template p2p_send<RPC_NAME(get_versions)>(node_id,key,ver_begin,ver_end,max_count);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(get_versions)>(node_id,key,ver_begin,ver_end,max_count);
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(get_versions)>(node_id,key,ver_begin,ver_end,max_count);
+        });
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::multi_get(
+        const typename SubgroupType::KeyType& key,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_MULTI_GET_START,0);
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        try {
+            // do p2p multi_get as a subgroup member.
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                node_id = group_ptr->get_my_id();
+            }
+            return subgroup_handle.template p2p_send<RPC_NAME(multi_get)>(node_id,key);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p multi_get as an external caller.
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(multi_get)>(node_id,key);
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(multi_get)>(node_id,key);
+        });
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
+auto ServiceClient<CascadeTypes...>::type_recursive_get(
+        uint32_t type_index,
         const KeyType& key,
         const persistent::version_t& version,
-        const bool stable,
+        bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template get_size<FirstType>(key,version,stable,subgroup_index,shard_index);
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template get<FirstType>(key,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
-        return this->template type_recursive_get_size<KeyType,SecondType,RestTypes...>(type_index-1,key,version,stable,subgroup_index,shard_index);
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_get<KeyType,SecondType,RestTypes...>(type_index-1,key,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     }
 }
 
 template <typename... CascadeTypes>
 template <typename KeyType, typename LastType>
-derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recursive_get_size(
+auto ServiceClient<CascadeTypes...>::type_recursive_get(
         uint32_t type_index,
         const KeyType& key,
         const persistent::version_t& version,
-        const bool stable,
+        bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template get_size<LastType>(key,version,stable,subgroup_index,shard_index);
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template get<LastType>(key,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
@@ -1255,11 +1837,12 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recurs
 
 template <typename... CascadeTypes>
 template <typename KeyType>
-derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size(
+auto ServiceClient<CascadeTypes...>::get(
+        // const std::decay_t<typename std::result_of_t<decltype(&ObjectType::get_key_ref())>>& key,
         const KeyType& key,
         const persistent::version_t& version,
-        const bool stable) {
-    // STEP 1 - verify the keys
+        bool stable) {
+    // STEP 1 - get key
     if constexpr (!std::is_convertible_v<KeyType,std::string>) {
         throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
     }
@@ -1269,62 +1852,91 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size(
     std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
 
     // STEP 3 - call recursive get
-    return this->template type_recursive_get_size<KeyType,CascadeTypes...>(subgroup_type_index,key,version,stable,subgroup_index,shard_index);
+    return this->template type_recursive_get<KeyType,CascadeTypes...>(subgroup_type_index,key,version,stable,subgroup_index,shard_index);
 }
 
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::multi_get_size(
+derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::get_range(
         const typename SubgroupType::KeyType& key,
-        uint32_t subgroup_index, uint32_t shard_index) {
-    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_MULTI_GET_SIZE_START,0);
+        const uint64_t offset,
+        const uint64_t length,
+        const persistent::version_t& version,
+        bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
         try {
-            // do p2p multi_get_size as a subgroup member.
+            // do p2p get_range as a subgroup member
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
             if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
                 node_id = group_ptr->get_my_id();
+                // local get_range
+                auto obj = subgroup_handle.get_ref().get_range(key,version,stable,offset,length);
+                auto pending_results = std::make_shared<PendingResults<const typename SubgroupType::ObjectType>>();
+                pending_results->fulfill_map({node_id});
+                pending_results->set_value(node_id,obj);
+                auto query_results = pending_results->get_future();
+                return std::move(*query_results);
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(multi_get_size)>(node_id,key);
+            return subgroup_handle.template p2p_send<RPC_NAME(get_range)>(node_id,key,version,stable,offset,length);
         } catch (derecho::invalid_subgroup_exception& ex) {
-            // do p2p multi_get_size as an external caller.
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(multi_get_size)>(node_id,key);
+            return subgroup_handle.template p2p_send<RPC_NAME(get_range)>(node_id,key,version,stable,offset,length);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(multi_get_size)>(node_id,key);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(get_range)>(node_id,key,version,stable,offset,length);
+        });
     }
 }
 
 template <typename... CascadeTypes>
 template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
-derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recursive_multi_get_size(
+auto ServiceClient<CascadeTypes...>::type_recursive_get_range(
         uint32_t type_index,
         const KeyType& key,
+        const uint64_t offset,
+        const uint64_t length,
+        const persistent::version_t& version,
+        bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template multi_get_size<FirstType>(key,subgroup_index,shard_index);
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template get_range<FirstType>(key,offset,length,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
-        return this->template type_recursive_multi_get_size<KeyType,SecondType,RestTypes...>(type_index-1,key,subgroup_index,shard_index);
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_get_range<KeyType,SecondType,RestTypes...>(type_index-1,key,offset,length,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     }
 }
 
 template <typename... CascadeTypes>
 template <typename KeyType, typename LastType>
-derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recursive_multi_get_size(
+auto ServiceClient<CascadeTypes...>::type_recursive_get_range(
         uint32_t type_index,
         const KeyType& key,
+        const uint64_t offset,
+        const uint64_t length,
+        const persistent::version_t& version,
+        bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template multi_get_size<LastType>(key,subgroup_index,shard_index);
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template get_range<LastType>(key,offset,length,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
@@ -1332,8 +1944,70 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recurs
 
 template <typename... CascadeTypes>
 template <typename KeyType>
-derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::multi_get_size(const KeyType& key) {
-    // STEP 1 - verify the keys
+auto ServiceClient<CascadeTypes...>::get_range(
+        const KeyType& key,
+        const uint64_t offset,
+        const uint64_t length,
+        const persistent::version_t& version,
+        bool stable) {
+    // STEP 1 - get key
+    if constexpr (!std::is_convertible_v<KeyType,std::string>) {
+        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
+    }
+
+    // STEP 2 - get shard
+    uint32_t subgroup_type_index,subgroup_index,shard_index;
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
+
+    // STEP 3 - call recursive get_range
+    return this->template type_recursive_get_range<KeyType,CascadeTypes...>(subgroup_type_index,key,offset,length,version,stable,subgroup_index,shard_index);
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
+auto ServiceClient<CascadeTypes...>::type_recursive_multi_get(
+        uint32_t type_index,
+        const KeyType& key,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template multi_get<FirstType>(key,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_multi_get<KeyType,SecondType,RestTypes...>(type_index-1,key,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename LastType>
+auto ServiceClient<CascadeTypes...>::type_recursive_multi_get(
+        uint32_t type_index,
+        const KeyType& key,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template multi_get<LastType>(key,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType>
+auto ServiceClient<CascadeTypes...>::multi_get(
+        const KeyType& key) {
+    // STEP 1 - get key
     if constexpr (!std::is_convertible_v<KeyType,std::string>) {
         throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
     }
@@ -1343,44 +2017,44 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::multi_get_s
     std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
 
     // STEP 3 - call recursive get
-    return this->template type_recursive_multi_get_size<KeyType,CascadeTypes...>(subgroup_type_index,key,subgroup_index,shard_index);
+    return this->template type_recursive_multi_get<KeyType,CascadeTypes...>(subgroup_type_index,key,subgroup_index,shard_index);
 }
 
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size_by_time(
+derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::get_by_time(
         const typename SubgroupType::KeyType& key,
         const uint64_t& ts_us,
         const bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
         try {
-            // do p2p get_size_by_time as a subgroup member.
+            // do p2p get_by_time
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
             if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                // as a shard member.
                 node_id = group_ptr->get_my_id();
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(get_size_by_time)>(node_id,key,ts_us,stable);
+            return subgroup_handle.template p2p_send<RPC_NAME(get_by_time)>(node_id,key,ts_us,stable);
         } catch (derecho::invalid_subgroup_exception& ex) {
-            // do p2p get_size_by_time as an external caller.
+            // do p2p get_by_time as an external caller
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(get_size_by_time)>(node_id,key,ts_us,stable);
+            return subgroup_handle.template p2p_send<RPC_NAME(get_by_time)>(node_id,key,ts_us,stable);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
-        return caller.template p2p_send<RPC_NAME(get_size_by_time)>(node_id,key,ts_us,stable);
+        return this->template external_send<SubgroupType>(0,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(get_by_time)>(node_id,key,ts_us,stable);
+        });
     }
 }
 
 template <typename... CascadeTypes>
 template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
-derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recursive_get_size_by_time(
+auto ServiceClient<CascadeTypes...>::type_recursive_get_by_time(
         uint32_t type_index,
         const KeyType& key,
         const uint64_t& ts_us,
@@ -1388,15 +2062,23 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recurs
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template get_size_by_time<FirstType>(key,ts_us,stable,subgroup_index,shard_index);
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template get_by_time<FirstType>(key,ts_us,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
-        return this->template type_recursive_get_size_by_time<KeyType,SecondType,RestTypes...>(type_index-1,key,ts_us,stable,subgroup_index,shard_index);
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_get_by_time<KeyType,SecondType,RestTypes...>(type_index-1,key,ts_us,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     }
 }
 
 template <typename... CascadeTypes>
 template <typename KeyType, typename LastType>
-derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recursive_get_size_by_time(
+auto ServiceClient<CascadeTypes...>::type_recursive_get_by_time(
         uint32_t type_index,
         const KeyType& key,
         const uint64_t& ts_us,
@@ -1404,7 +2086,11 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recurs
         uint32_t subgroup_index,
         uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template get_size_by_time<LastType>(key,ts_us,stable,subgroup_index,shard_index);
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template get_by_time<LastType>(key,ts_us,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
@@ -1412,11 +2098,11 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recurs
 
 template <typename... CascadeTypes>
 template <typename KeyType>
-derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size_by_time(
+auto ServiceClient<CascadeTypes...>::get_by_time(
         const KeyType& key,
         const uint64_t& ts_us,
         const bool stable) {
-    // STEP 1 - verify the keys
+    // STEP 1 - get key
     if constexpr (!std::is_convertible_v<KeyType,std::string>) {
         throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
     }
@@ -1425,103 +2111,860 @@ derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size_by
     uint32_t subgroup_type_index,subgroup_index,shard_index;
     std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
 
-    // STEP 3 - call recursive get
-    return this->template type_recursive_get_size_by_time<KeyType,CascadeTypes...>(subgroup_type_index,key,ts_us,stable,subgroup_index,shard_index);
+    // STEP 3 - call recursive get_by_time
+    return this->template type_recursive_get_by_time<KeyType,CascadeTypes...>(subgroup_type_index,key,ts_us,stable,subgroup_index,shard_index);
 }
 
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> ServiceClient<CascadeTypes...>::list_keys(
+derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size(
+        const typename SubgroupType::KeyType& key,
         const persistent::version_t& version,
         const bool stable,
         uint32_t subgroup_index,
         uint32_t shard_index) {
-    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_LIST_KEYS_START,0);
+    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_GET_SIZE_START,0);
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
         try {
-            // do p2p list_keys as a subgroup member.
+            // do p2p get_size as a subgroup_member
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
             if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                // as a shard member.
                 node_id = group_ptr->get_my_id();
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,"",version,stable);
+            return subgroup_handle.template p2p_send<RPC_NAME(get_size)>(node_id,key,version,stable,false);
         } catch (derecho::invalid_subgroup_exception& ex) {
-            // do p2p list_keys as an external client.
+            // do p2p get_size as an external caller
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,"",version,stable);
+            return subgroup_handle.template p2p_send<RPC_NAME(get_size)>(node_id,key,version,stable,false);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
-        return caller.template p2p_send<RPC_NAME(list_keys)>(node_id,"",version,stable);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(get_size)>(node_id,key,version,stable,false);
+        });
     }
 }
 
 template <typename... CascadeTypes>
-template <typename FirstType, typename SecondType, typename... RestTypes>
-auto ServiceClient<CascadeTypes...>::type_recursive_list_keys(
+template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
+derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recursive_get_size(
         uint32_t type_index,
+        const KeyType& key,
         const persistent::version_t& version,
         const bool stable,
-        const std::string& object_pool_pathname) {
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template __list_keys<FirstType>(version,stable,object_pool_pathname);
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template get_size<FirstType>(key,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
-        return this->template type_recursive_list_keys<SecondType, RestTypes...>(type_index-1, version, stable, object_pool_pathname);
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_get_size<KeyType,SecondType,RestTypes...>(type_index-1,key,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     }
 }
 
 template <typename... CascadeTypes>
-template <typename LastType>
-auto ServiceClient<CascadeTypes...>::type_recursive_list_keys(
+template <typename KeyType, typename LastType>
+derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recursive_get_size(
         uint32_t type_index,
+        const KeyType& key,
         const persistent::version_t& version,
         const bool stable,
-        const std::string& object_pool_pathname) {
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template __list_keys<LastType>(version,stable,object_pool_pathname);
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template get_size<LastType>(key,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
 }
 
 template <typename... CascadeTypes>
-template <typename SubgroupType>
-std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> ServiceClient<CascadeTypes...>::__list_keys(
+template <typename KeyType>
+derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size(
+        const KeyType& key,
         const persistent::version_t& version,
-        const bool stable,
-        const std::string& object_pool_pathname){
-    auto opm = find_object_pool(object_pool_pathname);
-    if (!opm.is_valid() || opm.is_null() || opm.deleted) {
-        throw derecho::derecho_exception("Failed to find object_pool:" + object_pool_pathname);
+        const bool stable) {
+    // STEP 1 - verify the keys
+    if constexpr (!std::is_convertible_v<KeyType,std::string>) {
+        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
     }
-    uint32_t subgroup_index = opm.subgroup_index;
-    uint32_t shards = get_number_of_shards<SubgroupType>(subgroup_index);
-    std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> result;
-    for (uint32_t shard_index = 0; shard_index < shards; shard_index ++){
-        if (!is_external_client()) {
-            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
-            try {
-                auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-                if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
-                    node_id = group_ptr->get_my_id();
-                }
-                auto shard_keys = subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,object_pool_pathname,version,stable);
-                result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
-            } catch (derecho::invalid_subgroup_exception& ex) {
-                auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-                auto shard_keys= subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,object_pool_pathname,version,stable);
+
+    // STEP 2 - get shard
+    uint32_t subgroup_type_index,subgroup_index,shard_index;
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
+
+    // STEP 3 - call recursive get
+    return this->template type_recursive_get_size<KeyType,CascadeTypes...>(subgroup_type_index,key,version,stable,subgroup_index,shard_index);
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::multi_get_size(
+        const typename SubgroupType::KeyType& key,
+        uint32_t subgroup_index, uint32_t shard_index) {
+    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_MULTI_GET_SIZE_START,0);
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        try {
+            // do p2p multi_get_size as a subgroup member.
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                node_id = group_ptr->get_my_id();
+            }
+            return subgroup_handle.template p2p_send<RPC_NAME(multi_get_size)>(node_id,key);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p multi_get_size as an external caller.
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(multi_get_size)>(node_id,key);
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(multi_get_size)>(node_id,key);
+        });
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
+derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recursive_multi_get_size(
+        uint32_t type_index,
+        const KeyType& key,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template multi_get_size<FirstType>(key,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_multi_get_size<KeyType,SecondType,RestTypes...>(type_index-1,key,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename LastType>
+derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recursive_multi_get_size(
+        uint32_t type_index,
+        const KeyType& key,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template multi_get_size<LastType>(key,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType>
+derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::multi_get_size(const KeyType& key) {
+    // STEP 1 - verify the keys
+    if constexpr (!std::is_convertible_v<KeyType,std::string>) {
+        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
+    }
+
+    // STEP 2 - get shard
+    uint32_t subgroup_type_index,subgroup_index,shard_index;
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
+
+    // STEP 3 - call recursive get
+    return this->template type_recursive_multi_get_size<KeyType,CascadeTypes...>(subgroup_type_index,key,subgroup_index,shard_index);
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size_by_time(
+        const typename SubgroupType::KeyType& key,
+        const uint64_t& ts_us,
+        const bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        try {
+            // do p2p get_size_by_time as a subgroup member.
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                node_id = group_ptr->get_my_id();
+            }
+            return subgroup_handle.template p2p_send<RPC_NAME(get_size_by_time)>(node_id,key,ts_us,stable);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p get_size_by_time as an external caller.
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(get_size_by_time)>(node_id,key,ts_us,stable);
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(get_size_by_time)>(node_id,key,ts_us,stable);
+        });
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
+derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recursive_get_size_by_time(
+        uint32_t type_index,
+        const KeyType& key,
+        const uint64_t& ts_us,
+        const bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template get_size_by_time<FirstType>(key,ts_us,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_get_size_by_time<KeyType,SecondType,RestTypes...>(type_index-1,key,ts_us,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename LastType>
+derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::type_recursive_get_size_by_time(
+        uint32_t type_index,
+        const KeyType& key,
+        const uint64_t& ts_us,
+        const bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template get_size_by_time<LastType>(key,ts_us,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType>
+derecho::rpc::QueryResults<uint64_t> ServiceClient<CascadeTypes...>::get_size_by_time(
+        const KeyType& key,
+        const uint64_t& ts_us,
+        const bool stable) {
+    // STEP 1 - verify the keys
+    if constexpr (!std::is_convertible_v<KeyType,std::string>) {
+        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
+    }
+
+    // STEP 2 - get shard
+    uint32_t subgroup_type_index,subgroup_index,shard_index;
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
+
+    // STEP 3 - call recursive get
+    return this->template type_recursive_get_size_by_time<KeyType,CascadeTypes...>(subgroup_type_index,key,ts_us,stable,subgroup_index,shard_index);
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<ObjectHead> ServiceClient<CascadeTypes...>::head(
+        const typename SubgroupType::KeyType& key,
+        const persistent::version_t& version,
+        const bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        try {
+            // do p2p head as a subgroup_member
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                // as a shard member.
+                node_id = group_ptr->get_my_id();
+            }
+            return subgroup_handle.template p2p_send<RPC_NAME(head)>(node_id,key,version,stable);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p head as an external caller
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(head)>(node_id,key,version,stable);
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,key);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(head)>(node_id,key,version,stable);
+        });
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
+derecho::rpc::QueryResults<ObjectHead> ServiceClient<CascadeTypes...>::type_recursive_head(
+        uint32_t type_index,
+        const KeyType& key,
+        const persistent::version_t& version,
+        const bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template head<FirstType>(key,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_head<KeyType,SecondType,RestTypes...>(type_index-1,key,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename LastType>
+derecho::rpc::QueryResults<ObjectHead> ServiceClient<CascadeTypes...>::type_recursive_head(
+        uint32_t type_index,
+        const KeyType& key,
+        const persistent::version_t& version,
+        const bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template head<LastType>(key,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType>
+derecho::rpc::QueryResults<ObjectHead> ServiceClient<CascadeTypes...>::head(
+        const KeyType& key,
+        const persistent::version_t& version,
+        const bool stable) {
+    // STEP 1 - verify the keys
+    if constexpr (!std::is_convertible_v<KeyType,std::string>) {
+        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
+    }
+
+    // STEP 2 - get shard
+    uint32_t subgroup_type_index,subgroup_index,shard_index;
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(key);
+
+    // STEP 3 - call recursive head
+    return this->template type_recursive_head<KeyType,CascadeTypes...>(subgroup_type_index,key,version,stable,subgroup_index,shard_index);
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<std::vector<ObjectHead>> ServiceClient<CascadeTypes...>::head_batch(
+        const std::vector<typename SubgroupType::KeyType>& keys,
+        const persistent::version_t& version,
+        const bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (keys.empty()) {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": the batch is empty.");
+    }
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,keys.front());
+        try {
+            // do p2p head_batch as a subgroup_member
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                // as a shard member.
+                node_id = group_ptr->get_my_id();
+            }
+            return subgroup_handle.template p2p_send<RPC_NAME(head_batch)>(node_id,keys,version,stable);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p head_batch as an external caller
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(head_batch)>(node_id,keys,version,stable);
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,keys.front());
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(head_batch)>(node_id,keys,version,stable);
+        });
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
+derecho::rpc::QueryResults<std::vector<ObjectHead>> ServiceClient<CascadeTypes...>::type_recursive_head_batch(
+        uint32_t type_index,
+        const std::vector<KeyType>& keys,
+        const persistent::version_t& version,
+        const bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template head_batch<FirstType>(keys,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_head_batch<KeyType,SecondType,RestTypes...>(type_index-1,keys,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType, typename LastType>
+derecho::rpc::QueryResults<std::vector<ObjectHead>> ServiceClient<CascadeTypes...>::type_recursive_head_batch(
+        uint32_t type_index,
+        const std::vector<KeyType>& keys,
+        const persistent::version_t& version,
+        const bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template head_batch<LastType>(keys,version,stable,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename KeyType>
+std::vector<ObjectHead> ServiceClient<CascadeTypes...>::head_batch(
+        const std::vector<KeyType>& keys,
+        const persistent::version_t& version,
+        const bool stable) {
+    if constexpr (!std::is_convertible_v<KeyType,std::string>) {
+        throw derecho::derecho_exception(__PRETTY_FUNCTION__ + std::string(" only supports string key,but we get ") + typeid(KeyType).name());
+    }
+
+    // group the keys by shard, remembering their positions in the batch.
+    std::map<std::tuple<uint32_t,uint32_t,uint32_t>,std::pair<std::vector<KeyType>,std::vector<std::size_t>>> shard_batches;
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        auto& shard_batch = shard_batches[this->template key_to_shard(keys[i])];
+        shard_batch.first.push_back(keys[i]);
+        shard_batch.second.push_back(i);
+    }
+
+    // send the batches before waiting for any of them.
+    std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<ObjectHead>>>> results;
+    for (const auto& shard_batch : shard_batches) {
+        uint32_t subgroup_type_index,subgroup_index,shard_index;
+        std::tie(subgroup_type_index,subgroup_index,shard_index) = shard_batch.first;
+        results.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<ObjectHead>>>(
+                this->template type_recursive_head_batch<KeyType,CascadeTypes...>(
+                        subgroup_type_index,shard_batch.second.first,version,stable,subgroup_index,shard_index)));
+    }
+
+    std::vector<ObjectHead> heads(keys.size());
+    auto result = results.begin();
+    for (const auto& shard_batch : shard_batches) {
+        for (auto& reply : (*result)->get()) {
+            std::vector<ObjectHead> shard_heads = reply.second.get();
+            for (std::size_t i = 0; i < shard_heads.size() && i < shard_batch.second.second.size(); i++) {
+                heads[shard_batch.second.second[i]] = shard_heads[i];
+            }
+        }
+        result++;
+    }
+    return heads;
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> ServiceClient<CascadeTypes...>::list_keys(
+        const persistent::version_t& version,
+        const bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_LIST_KEYS_START,0);
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        try {
+            // do p2p list_keys as a subgroup member.
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                node_id = group_ptr->get_my_id();
+            }
+            return subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,"",version,stable);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p list_keys as an external client.
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,"",version,stable);
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(list_keys)>(node_id,"",version,stable);
+        });
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename FirstType, typename SecondType, typename... RestTypes>
+auto ServiceClient<CascadeTypes...>::type_recursive_list_keys(
+        uint32_t type_index,
+        const persistent::version_t& version,
+        const bool stable,
+        const std::string& object_pool_pathname) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template __list_keys<FirstType>(version,stable,object_pool_pathname);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_list_keys<SecondType, RestTypes...>(type_index-1, version, stable, object_pool_pathname);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename LastType>
+auto ServiceClient<CascadeTypes...>::type_recursive_list_keys(
+        uint32_t type_index,
+        const persistent::version_t& version,
+        const bool stable,
+        const std::string& object_pool_pathname) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template __list_keys<LastType>(version,stable,object_pool_pathname);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> ServiceClient<CascadeTypes...>::__list_keys(
+        const persistent::version_t& version,
+        const bool stable,
+        const std::string& object_pool_pathname){
+    auto opm = find_object_pool(object_pool_pathname);
+    if (!opm.is_valid() || opm.is_null() || opm.deleted) {
+        throw derecho::derecho_exception("Failed to find object_pool:" + object_pool_pathname);
+    }
+    uint32_t subgroup_index = opm.subgroup_index;
+    uint32_t shards = get_number_of_shards<SubgroupType>(subgroup_index);
+    std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> result;
+    for (uint32_t shard_index = 0; shard_index < shards; shard_index ++){
+        if (!is_external_client()) {
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+            try {
+                auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+                if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                    node_id = group_ptr->get_my_id();
+                }
+                auto shard_keys = subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,object_pool_pathname,version,stable);
+                result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
+            } catch (derecho::invalid_subgroup_exception& ex) {
+                auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                auto shard_keys= subgroup_handle.template p2p_send<RPC_NAME(list_keys)>(node_id,object_pool_pathname,version,stable);
+                result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
+            }
+        } else {
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+            auto shard_keys = this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+                return caller.template p2p_send<RPC_NAME(list_keys)>(node_id,object_pool_pathname,version,stable);
+            });
+            result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
+        }
+    }
+    return result;
+}
+
+template <typename... CascadeTypes>
+auto ServiceClient<CascadeTypes...>::list_keys(
+        const persistent::version_t& version,
+        const bool stable,
+        const std::string& object_pool_pathname) {
+    volatile uint32_t subgroup_type_index,subgroup_index,shard_index;
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(object_pool_pathname+"/_");
+    return this->template type_recursive_list_keys<CascadeTypes...>(subgroup_type_index,version,stable,object_pool_pathname);
+}
+
+template <typename ReturnType>
+inline ReturnType wait_for_future(derecho::rpc::QueryResults<ReturnType>& result){
+    // iterate through ReplyMap
+    for (auto& reply_future: result.get()) {
+        ReturnType reply = static_cast<ReturnType>(reply_future.second.get());
+        return reply;
+    }
+    return ReturnType();
+}
+
+
+template <typename... CascadeTypes>
+template <typename KeyType>
+std::vector<KeyType> ServiceClient<CascadeTypes...>::wait_list_keys(
+        std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<KeyType>>>>& future){
+    std::vector<KeyType> result;
+    // iterate over each shard's Query result
+    for(auto& query_result: future){
+        std::vector<KeyType> reply = wait_for_future<std::vector<KeyType>>(*(query_result.get()));
+        std::move(reply.begin(), reply.end(), std::back_inserter(result));
+    }
+    return result;
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> ServiceClient<CascadeTypes...>::multi_list_keys(
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_MULTI_LIST_KEYS_START,0);
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        try {
+            // do p2p multi_list_keys as a subgroup member.
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                node_id = group_ptr->get_my_id();
+            }
+            return subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,"");
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p multi_list_keys as an external client.
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+            return subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,"");
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,"");
+        });
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename FirstType, typename SecondType, typename... RestTypes>
+auto ServiceClient<CascadeTypes...>::type_recursive_multi_list_keys (
+        uint32_t type_index,
+        const std::string& object_pool_pathname) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template __multi_list_keys<FirstType>(object_pool_pathname);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_multi_list_keys<SecondType, RestTypes...>(type_index-1,object_pool_pathname);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename LastType>
+auto ServiceClient<CascadeTypes...>::type_recursive_multi_list_keys (
+        uint32_t type_index,
+        const std::string& object_pool_pathname) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template __multi_list_keys<LastType>(object_pool_pathname);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> ServiceClient<CascadeTypes...>::__multi_list_keys(const std::string& object_pool_pathname) {
+    auto opm = find_object_pool(object_pool_pathname);
+    if (!opm.is_valid() || opm.is_null() || opm.deleted) {
+        throw derecho::derecho_exception("Failed to find object_pool:" + object_pool_pathname);
+    }
+    uint32_t subgroup_index = opm.subgroup_index;
+    uint32_t shards = get_number_of_shards<SubgroupType>(subgroup_index);
+    std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> result;
+    for (uint32_t shard_index = 0; shard_index < shards; shard_index ++){
+        if (!is_external_client()) {
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,object_pool_pathname);
+            try {
+                auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+                if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                    node_id = group_ptr->get_my_id();
+                }
+                auto shard_keys = subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,object_pool_pathname);
+                result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
+            } catch (derecho::invalid_subgroup_exception& ex) {
+                auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                auto shard_keys= subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,object_pool_pathname);
+                result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
+            }
+        } else {
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,object_pool_pathname);
+            auto shard_keys = this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+                return caller.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,object_pool_pathname);
+            });
+            result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
+        }
+    }
+    return result;
+}
+
+template <typename... CascadeTypes>
+auto ServiceClient<CascadeTypes...>::multi_list_keys(const std::string& object_pool_pathname) {
+    volatile uint32_t subgroup_type_index,subgroup_index,shard_index;
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(object_pool_pathname+"/_");
+    return this->template type_recursive_multi_list_keys<CascadeTypes...>(subgroup_type_index,object_pool_pathname);
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> ServiceClient<CascadeTypes...>::list_keys_by_time(
+        const uint64_t& ts_us,
+        const bool stable,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        try {
+            // do p2p list_keys_by_time as a subgroup member
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                node_id = group_ptr->get_my_id();
+            }
+            return subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,"",ts_us,stable);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p list_keys_by_time as an external client.
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,"",ts_us,stable);
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,"",ts_us,stable);
+        });
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename FirstType, typename SecondType, typename... RestTypes>
+auto ServiceClient<CascadeTypes...>::type_recursive_list_keys_by_time(
+        uint32_t type_index,
+        const uint64_t& ts_us,
+        const bool stable,
+        const std::string& object_pool_pathname) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template __list_keys_by_time<FirstType>(ts_us,stable,object_pool_pathname);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_list_keys_by_time<SecondType, RestTypes...>(type_index-1,ts_us,stable,object_pool_pathname);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename LastType>
+auto ServiceClient<CascadeTypes...>::type_recursive_list_keys_by_time(
+        uint32_t type_index,
+        const uint64_t& ts_us,
+        const bool stable,
+        const std::string& object_pool_pathname) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template __list_keys_by_time<LastType>(ts_us,stable,object_pool_pathname);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> ServiceClient<CascadeTypes...>::__list_keys_by_time(
+        const uint64_t& ts_us,
+        const bool stable,
+        const std::string& object_pool_pathname){
+    auto opm = find_object_pool(object_pool_pathname);
+    if (!opm.is_valid() || opm.is_null() || opm.deleted) {
+        throw derecho::derecho_exception("Failed to find object_pool:" + object_pool_pathname);
+    }
+    uint32_t subgroup_index = opm.subgroup_index;
+    uint32_t shards = get_number_of_shards<SubgroupType>(subgroup_index);
+    std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> result;
+    for (uint32_t shard_index = 0; shard_index < shards; shard_index ++){
+        if (!is_external_client()) {
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,object_pool_pathname);
+            try {
+                // do p2p list_keys_by_time as a subgroup member.
+                auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+                if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                    node_id = group_ptr->get_my_id();
+                }
+                auto shard_keys = subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,object_pool_pathname,ts_us,stable);
+                result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
+            } catch (derecho::invalid_subgroup_exception& ex) {
+                // do p2p list_keys_by_time as an external client.
+                auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                auto shard_keys = subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,object_pool_pathname,ts_us,stable);
                 result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
             }
         } else {
-            std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
-            auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
-            auto shard_keys = caller.template p2p_send<RPC_NAME(list_keys)>(node_id,object_pool_pathname,version,stable);
+            // call as an external client (ExternalClientCaller).
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,object_pool_pathname);
+            auto shard_keys = this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+                return caller.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,object_pool_pathname,ts_us,stable);
+            });
             result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
         }
     }
@@ -1529,294 +2972,663 @@ std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename Subg
 }
 
 template <typename... CascadeTypes>
-auto ServiceClient<CascadeTypes...>::list_keys(
-        const persistent::version_t& version,
-        const bool stable,
+auto ServiceClient<CascadeTypes...>::list_keys_by_time(const uint64_t& ts_us, const bool stable, const std::string& object_pool_pathname) {
+    volatile uint32_t subgroup_type_index,subgroup_index,shard_index;
+    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(object_pool_pathname+"/_");
+    return this->template type_recursive_list_keys_by_time<CascadeTypes...>(subgroup_type_index,ts_us,stable,object_pool_pathname);
+}
+
+/**
+ * Check the syntax of the expressions of a scan before sending it. The predicates are not resolved, since they may
+ * only be registered on the servers.
+ */
+inline void check_scan_expressions(const std::string& filter, const std::string& projection) {
+    ScanFilter scan_filter;
+    ScanProjection scan_projection;
+    std::string error;
+    if (!ScanFilter::compile(filter,scan_filter,error,false)) {
+        throw derecho::derecho_exception("Invalid scan filter '" + filter + "': " + error);
+    }
+    if (!ScanProjection::compile(projection,scan_projection,error)) {
+        throw derecho::derecho_exception("Invalid scan projection '" + projection + "': " + error);
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<scan_page_t<typename SubgroupType::ObjectType>> ServiceClient<CascadeTypes...>::scan(
+        const std::string& prefix,
+        const std::string& filter,
+        const std::string& projection,
+        const std::string& cursor,
+        uint32_t max_results,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    check_scan_expressions(filter,projection);
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        try {
+            // do p2p scan as a subgroup member.
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                node_id = group_ptr->get_my_id();
+            }
+            return subgroup_handle.template p2p_send<RPC_NAME(scan)>(node_id,prefix,filter,projection,cursor,max_results);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p scan as an external client.
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(scan)>(node_id,prefix,filter,projection,cursor,max_results);
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(scan)>(node_id,prefix,filter,projection,cursor,max_results);
+        });
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename FirstType, typename SecondType, typename... RestTypes>
+auto ServiceClient<CascadeTypes...>::type_recursive_scan(
+        uint32_t type_index,
+        const std::string& filter,
+        const std::string& projection,
+        uint32_t max_results,
+        const std::string& object_pool_pathname) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<FirstType>()) {
+            return this->template __scan<FirstType>(filter,projection,max_results,object_pool_pathname);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        if constexpr (has_object_pool_type<SecondType,RestTypes...>()) {
+            return this->template type_recursive_scan<SecondType, RestTypes...>(type_index-1,filter,projection,max_results,object_pool_pathname);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename LastType>
+auto ServiceClient<CascadeTypes...>::type_recursive_scan(
+        uint32_t type_index,
+        const std::string& filter,
+        const std::string& projection,
+        uint32_t max_results,
+        const std::string& object_pool_pathname) {
+    if (type_index == 0) {
+        if constexpr (is_object_pool_type<LastType>()) {
+            return this->template __scan<LastType>(filter,projection,max_results,object_pool_pathname);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": object pools are only supported by subgroup types with string keys.");
+        }
+    } else {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+std::vector<typename SubgroupType::ObjectType> ServiceClient<CascadeTypes...>::__scan(
+        const std::string& filter,
+        const std::string& projection,
+        uint32_t max_results,
+        const std::string& object_pool_pathname) {
+    using page_future_t = derecho::rpc::QueryResults<scan_page_t<typename SubgroupType::ObjectType>>;
+    auto opm = find_object_pool(object_pool_pathname);
+    if (!opm.is_valid() || opm.is_null() || opm.deleted) {
+        throw derecho::derecho_exception("Failed to find object_pool:" + object_pool_pathname);
+    }
+    uint32_t subgroup_index = opm.subgroup_index;
+    uint32_t shards = get_number_of_shards<SubgroupType>(subgroup_index);
+    std::vector<std::unique_ptr<page_future_t>> first_pages;
+    for (uint32_t shard_index = 0; shard_index < shards; shard_index ++) {
+        first_pages.emplace_back(std::make_unique<page_future_t>(
+                this->template scan<SubgroupType>(object_pool_pathname,filter,projection,"",max_results,subgroup_index,shard_index)));
+    }
+    std::vector<typename SubgroupType::ObjectType> objects;
+    for (uint32_t shard_index = 0; shard_index < shards; shard_index ++) {
+        std::unique_ptr<page_future_t> pending_page = std::move(first_pages[shard_index]);
+        uint32_t remaining = max_results;
+        while (pending_page) {
+            scan_page_t<typename SubgroupType::ObjectType> page;
+            for (auto& reply_future : pending_page->get()) {
+                page = reply_future.second.get();
+                break;
+            }
+            auto& page_objects = std::get<0>(page);
+            const std::string& cursor = std::get<1>(page);
+            if (max_results != 0) {
+                remaining -= std::min<uint32_t>(remaining,page_objects.size());
+            }
+            std::move(page_objects.begin(),page_objects.end(),std::back_inserter(objects));
+            pending_page.reset();
+            if (!cursor.empty() && (max_results == 0 || remaining > 0)) {
+                pending_page = std::make_unique<page_future_t>(
+                        this->template scan<SubgroupType>(object_pool_pathname,filter,projection,cursor,remaining,subgroup_index,shard_index));
+            }
+        }
+    }
+    return objects;
+}
+
+template <typename... CascadeTypes>
+auto ServiceClient<CascadeTypes...>::scan(
+        const std::string& filter,
+        const std::string& projection,
+        uint32_t max_results,
         const std::string& object_pool_pathname) {
     volatile uint32_t subgroup_type_index,subgroup_index,shard_index;
     std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(object_pool_pathname+"/_");
-    return this->template type_recursive_list_keys<CascadeTypes...>(subgroup_type_index,version,stable,object_pool_pathname);
+    return this->template type_recursive_scan<CascadeTypes...>(subgroup_type_index,filter,projection,max_results,object_pool_pathname);
 }
 
-template <typename ReturnType>
-inline ReturnType wait_for_future(derecho::rpc::QueryResults<ReturnType>& result){
-    // iterate through ReplyMap
-    for (auto& reply_future: result.get()) {
-        ReturnType reply = static_cast<ReturnType>(reply_future.second.get());
-        return reply;
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<key_page_t<typename SubgroupType::KeyType>> ServiceClient<CascadeTypes...>::list_keys_paged(
+        const std::string& prefix,
+        const std::string& cursor,
+        uint32_t limit,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    // the cursor carries the version and the last key of the listing, so any member of the shard can continue it.
+    if (!is_external_client()) {
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        try {
+            // do p2p list_keys_paged as a subgroup member.
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+                node_id = group_ptr->get_my_id();
+            }
+            return subgroup_handle.template p2p_send<RPC_NAME(list_keys_paged)>(node_id,prefix,cursor,limit);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p list_keys_paged as an external client.
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(list_keys_paged)>(node_id,prefix,cursor,limit);
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(list_keys_paged)>(node_id,prefix,cursor,limit);
+        });
     }
-    return ReturnType();
 }
 
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::refresh_object_pool_metadata_cache() {
+    std::unordered_map<std::string,ObjectPoolMetadataCacheEntry> refreshed_metadata;
+    uint32_t num_shards = this->template get_number_of_shards<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX);
+    for(uint32_t shard=0;shard<num_shards;shard++) {
+        auto results = this->template multi_list_keys<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX,shard);
+        for (auto& reply : results.get()) { // only once
+            for(auto& key: reply.second.get()) { // iterate over keys
+                // we only read the stable version.
+                auto opm_result = this->template get<CascadeMetadataService<CascadeTypes...>>(key,CURRENT_VERSION,false,METADATA_SERVICE_SUBGROUP_INDEX,shard);
+                for (auto& opm_reply:opm_result.get()) { // only once
+                    refreshed_metadata.emplace(key,opm_reply.second.get());
+                    break;
+                }
+            }
+            break;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> wlck(object_pool_metadata_cache_mutex);
+    this->object_pool_metadata_cache = std::move(refreshed_metadata);
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::create_object_pool(
+        const std::string& pathname, const uint32_t subgroup_index,
+        const sharding_policy_t sharding_policy, const std::unordered_map<std::string,uint32_t>& object_locations,
+        const std::string& affinity_set_regex, const uint64_t memory_budget, const uint64_t blob_threshold,
+        const uint64_t ttl_ms) {
+    uint32_t subgroup_type_index = ObjectPoolMetadata<CascadeTypes...>::template get_subgroup_type_index<SubgroupType>();
+    if (subgroup_type_index == ObjectPoolMetadata<CascadeTypes...>::invalid_subgroup_type_index) {
+        dbg_default_crit("Create object pool failed because of invalid SubgroupType:{}", typeid(SubgroupType).name());
+        throw derecho::derecho_exception(std::string("Create object pool failed because SubgroupType is invalid:")+typeid(SubgroupType).name());
+    }
+    if constexpr (!is_object_pool_type<SubgroupType>()) {
+        dbg_default_crit("Create object pool failed because SubgroupType:{} has no string keys", typeid(SubgroupType).name());
+        throw derecho::derecho_exception(std::string("Create object pool failed because SubgroupType has no string keys:")+typeid(SubgroupType).name());
+    }
+    ObjectPoolMetadata<CascadeTypes...> opm(pathname,subgroup_type_index,subgroup_index,sharding_policy,object_locations,affinity_set_regex,false,memory_budget,{0,0,0},blob_threshold,ttl_ms);
+    if (memory_budget > 0) {
+        if constexpr (is_volatile_cascade_store<SubgroupType>::value) {
+            // enforce the budget before the object pool is visible to other clients.
+            uint32_t num_shards = this->template get_number_of_shards<SubgroupType>(subgroup_index);
+            for (uint32_t shard_index = 0; shard_index < num_shards; shard_index++) {
+                auto result = this->template set_memory_budget<SubgroupType>(pathname,memory_budget,subgroup_index,shard_index);
+                for (auto& reply : result.get()) {
+                    reply.second.get();
+                }
+            }
+        } else {
+            dbg_default_warn("Memory budget is ignored by object pool:{} of SubgroupType:{}", pathname, typeid(SubgroupType).name());
+        }
+    }
+    if (blob_threshold > 0) {
+        if constexpr (is_persistent_cascade_store<SubgroupType>::value) {
+            uint32_t num_shards = this->template get_number_of_shards<SubgroupType>(subgroup_index);
+            for (uint32_t shard_index = 0; shard_index < num_shards; shard_index++) {
+                auto result = this->template set_blob_thresholds<SubgroupType>({{pathname,blob_threshold}},subgroup_index,shard_index);
+                for (auto& reply : result.get()) {
+                    reply.second.get();
+                }
+            }
+        } else {
+            dbg_default_warn("Blob threshold is ignored by object pool:{} of SubgroupType:{}", pathname, typeid(SubgroupType).name());
+        }
+    }
+    if (ttl_ms > 0) {
+        if constexpr (is_volatile_cascade_store<SubgroupType>::value) {
+            uint32_t num_shards = this->template get_number_of_shards<SubgroupType>(subgroup_index);
+            for (uint32_t shard_index = 0; shard_index < num_shards; shard_index++) {
+                auto result = this->template set_ttl<SubgroupType>(pathname,ttl_ms,subgroup_index,shard_index);
+                for (auto& reply : result.get()) {
+                    reply.second.get();
+                }
+            }
+        } else {
+            dbg_default_warn("TTL is ignored by object pool:{} of SubgroupType:{}", pathname, typeid(SubgroupType).name());
+        }
+    }
+    // clear local cache entry.
+    std::shared_lock<std::shared_mutex> rlck(object_pool_metadata_cache_mutex);
+    if (object_pool_metadata_cache.find(pathname)==object_pool_metadata_cache.end()) {
+        rlck.unlock();
+    } else {
+        rlck.unlock();
+        std::unique_lock<std::shared_mutex> wlck(object_pool_metadata_cache_mutex);
+        object_pool_metadata_cache.erase(pathname);
+    }
+    // determine the shard index by hashing
+    uint32_t metadata_service_shard_index = std::hash<std::string>{}(pathname) % this->template get_number_of_shards<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX);
+
+    return this->template put<CascadeMetadataService<CascadeTypes...>>(opm,METADATA_SERVICE_SUBGROUP_INDEX,metadata_service_shard_index);
+}
 
 template <typename... CascadeTypes>
-template <typename KeyType>
-std::vector<KeyType> ServiceClient<CascadeTypes...>::wait_list_keys(
-        std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<KeyType>>>>& future){
-    std::vector<KeyType> result;
-    // iterate over each shard's Query result
-    for(auto& query_result: future){
-        std::vector<KeyType> reply = wait_for_future<std::vector<KeyType>>(*(query_result.get()));
-        std::move(reply.begin(), reply.end(), std::back_inserter(result));
+template <typename SubgroupType>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::set_memory_budget(
+        const std::string& pathname, const uint64_t memory_budget,
+        uint32_t subgroup_index, uint32_t shard_index) {
+    static_assert(is_volatile_cascade_store<SubgroupType>::value, "Memory budget is only supported by VolatileCascadeStore.");
+    if (!is_external_client()) {
+        if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+            // ordered set_memory_budget as a shard member
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template ordered_send<RPC_NAME(ordered_set_memory_budget)>(pathname,memory_budget);
+        } else {
+            // p2p set_memory_budget
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,pathname);
+            try {
+                // as a subgroup member
+                auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+                return subgroup_handle.template p2p_send<RPC_NAME(set_memory_budget)>(node_id,pathname,memory_budget);
+            } catch (derecho::invalid_subgroup_exception& ex) {
+                // as an external caller
+                auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                return subgroup_handle.template p2p_send<RPC_NAME(set_memory_budget)>(node_id,pathname,memory_budget);
+            }
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,pathname);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(set_memory_budget)>(node_id,pathname,memory_budget);
+        });
     }
-    return result;
 }
 
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> ServiceClient<CascadeTypes...>::multi_list_keys(
-        uint32_t subgroup_index,
-        uint32_t shard_index) {
-    LOG_SERVICE_CLIENT_TIMESTAMP(TLT_SERVICE_CLIENT_MULTI_LIST_KEYS_START,0);
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::set_ttl(
+        const std::string& pathname, const uint64_t ttl_ms,
+        uint32_t subgroup_index, uint32_t shard_index) {
+    static_assert(is_volatile_cascade_store<SubgroupType>::value, "TTL is only supported by VolatileCascadeStore.");
+    if (!is_external_client()) {
+        if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+            // ordered set_ttl as a shard member
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template ordered_send<RPC_NAME(ordered_set_ttl)>(pathname,ttl_ms);
+        } else {
+            // p2p set_ttl
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,pathname);
+            try {
+                // as a subgroup member
+                auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+                return subgroup_handle.template p2p_send<RPC_NAME(set_ttl)>(node_id,pathname,ttl_ms);
+            } catch (derecho::invalid_subgroup_exception& ex) {
+                // as an external caller
+                auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                return subgroup_handle.template p2p_send<RPC_NAME(set_ttl)>(node_id,pathname,ttl_ms);
+            }
+        }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,pathname);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(set_ttl)>(node_id,pathname,ttl_ms);
+        });
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename FirstType, typename SecondType, typename... RestTypes>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_set_ttl(
+        uint32_t type_index,
+        const std::string& pathname,
+        const uint64_t ttl_ms,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_volatile_cascade_store<FirstType>::value) {
+            return this->template set_ttl<FirstType>(pathname,ttl_ms,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": TTL is only supported by VolatileCascadeStore.");
+        }
+    } else {
+        return this->template type_recursive_set_ttl<SecondType, RestTypes...>(type_index-1,pathname,ttl_ms,subgroup_index,shard_index);
+    }
+}
+
+template <typename... CascadeTypes>
+template <typename LastType>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_set_ttl(
+        uint32_t type_index,
+        const std::string& pathname,
+        const uint64_t ttl_ms,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_volatile_cascade_store<LastType>::value) {
+            return this->template set_ttl<LastType>(pathname,ttl_ms,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": TTL is only supported by VolatileCascadeStore.");
+        }
+    } else {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+    }
+}
+
+template <typename... CascadeTypes>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::set_ttl(
+        const std::string& pathname, const uint64_t ttl_ms) {
+    auto opm = find_object_pool(pathname);
+    if (!opm.is_valid() || opm.is_null() || opm.deleted || opm.pathname != pathname) {
+        throw derecho::derecho_exception(std::string("object pool:")+pathname+" does not exist.");
+    }
+    // the shards expire the objects by the TTL they keep in memory, so they are updated before the metadata.
+    uint32_t num_shards = this->get_number_of_shards(pathname);
+    for (uint32_t shard_index = 0; shard_index < num_shards; shard_index++) {
+        auto result = this->template type_recursive_set_ttl<CascadeTypes...>(opm.subgroup_type_index,pathname,ttl_ms,opm.subgroup_index,shard_index);
+        for (auto& reply : result.get()) {
+            reply.second.get();
+        }
+    }
+    opm.ttl_ms = ttl_ms;
+    opm.set_previous_version(CURRENT_VERSION,opm.version); // only check previous_version_by_key
+    // clear local cache entry.
+    std::unique_lock<std::shared_mutex> wlck(object_pool_metadata_cache_mutex);
+    object_pool_metadata_cache.erase(pathname);
+    wlck.unlock();
+    // determine the shard index by hashing
+    uint32_t metadata_service_shard_index = std::hash<std::string>{}(pathname) % this->template get_number_of_shards<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX);
+
+    return this->template put<CascadeMetadataService<CascadeTypes...>>(opm,METADATA_SERVICE_SUBGROUP_INDEX,metadata_service_shard_index);
+}
+
+template <typename... CascadeTypes>
+template <typename SubgroupType>
+derecho::rpc::QueryResults<std::map<std::string,uint64_t>> ServiceClient<CascadeTypes...>::get_cache_stats(
+        const std::string& pathname, uint32_t subgroup_index, uint32_t shard_index) {
+    static_assert(is_volatile_cascade_store<SubgroupType>::value, "Cache statistics are only supported by VolatileCascadeStore.");
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,pathname);
         try {
-            // do p2p multi_list_keys as a subgroup member.
+            // do p2p get_cache_stats as a subgroup member.
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
             if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
                 node_id = group_ptr->get_my_id();
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,"");
+            return subgroup_handle.template p2p_send<RPC_NAME(get_cache_stats)>(node_id,pathname);
         } catch (derecho::invalid_subgroup_exception& ex) {
-            // do p2p multi_list_keys as an external client.
+            // do p2p get_cache_stats as an external caller.
             auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
-            return subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,"");
+            return subgroup_handle.template p2p_send<RPC_NAME(get_cache_stats)>(node_id,pathname);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
-        return caller.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,"");
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,pathname);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(get_cache_stats)>(node_id,pathname);
+        });
     }
 }
 
 template <typename... CascadeTypes>
-template <typename FirstType, typename SecondType, typename... RestTypes>
-auto ServiceClient<CascadeTypes...>::type_recursive_multi_list_keys (
-        uint32_t type_index,
-        const std::string& object_pool_pathname) {
-    if (type_index == 0) {
-        return this->template __multi_list_keys<FirstType>(object_pool_pathname);
+template <typename SubgroupType>
+derecho::rpc::QueryResults<std::map<std::string,uint64_t>> ServiceClient<CascadeTypes...>::get_recovery_stats(
+        node_id_t node_id, uint32_t subgroup_index, uint32_t shard_index) {
+    static_assert(is_persistent_cascade_store<SubgroupType>::value, "Recovery statistics are only supported by PersistentCascadeStore.");
+    if (!is_external_client()) {
+        try {
+            // do p2p get_recovery_stats as a subgroup member.
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(get_recovery_stats)>(node_id);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p get_recovery_stats as an external caller.
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(get_recovery_stats)>(node_id);
+        }
     } else {
-        return this->template type_recursive_multi_list_keys<SecondType, RestTypes...>(type_index-1,object_pool_pathname);
+        // call as an external client (ExternalClientCaller).
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(get_recovery_stats)>(node_id);
+        });
     }
 }
 
 template <typename... CascadeTypes>
-template <typename LastType>
-auto ServiceClient<CascadeTypes...>::type_recursive_multi_list_keys (
-        uint32_t type_index,
-        const std::string& object_pool_pathname) {
-    if (type_index == 0) {
-        return this->template __multi_list_keys<LastType>(object_pool_pathname);
+template <typename SubgroupType>
+derecho::rpc::QueryResults<std::map<std::string,uint64_t>> ServiceClient<CascadeTypes...>::get_key_memory_stats(
+        node_id_t node_id, uint32_t subgroup_index, uint32_t shard_index) {
+    static_assert(is_persistent_cascade_store<SubgroupType>::value, "Key memory statistics are only supported by PersistentCascadeStore.");
+    if (!is_external_client()) {
+        try {
+            // do p2p get_key_memory_stats as a subgroup member.
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(get_key_memory_stats)>(node_id);
+        } catch (derecho::invalid_subgroup_exception& ex) {
+            // do p2p get_key_memory_stats as an external caller.
+            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template p2p_send<RPC_NAME(get_key_memory_stats)>(node_id);
+        }
     } else {
-        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
+        // call as an external client (ExternalClientCaller).
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(get_key_memory_stats)>(node_id);
+        });
     }
 }
 
 template <typename... CascadeTypes>
-template <typename SubgroupType>
-std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> ServiceClient<CascadeTypes...>::__multi_list_keys(const std::string& object_pool_pathname) {
-    auto opm = find_object_pool(object_pool_pathname);
-    if (!opm.is_valid() || opm.is_null() || opm.deleted) {
-        throw derecho::derecho_exception("Failed to find object_pool:" + object_pool_pathname);
-    }
-    uint32_t subgroup_index = opm.subgroup_index;
-    uint32_t shards = get_number_of_shards<SubgroupType>(subgroup_index);
-    std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> result;
-    for (uint32_t shard_index = 0; shard_index < shards; shard_index ++){
-        if (!is_external_client()) {
-            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,object_pool_pathname);
-            try {
-                auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-                if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
-                    node_id = group_ptr->get_my_id();
-                }
-                auto shard_keys = subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,object_pool_pathname);
-                result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
-            } catch (derecho::invalid_subgroup_exception& ex) {
-                auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-                auto shard_keys= subgroup_handle.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,object_pool_pathname);
-                result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
-            }
-        } else {
-            std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
-            auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,object_pool_pathname);
-            auto shard_keys = caller.template p2p_send<RPC_NAME(multi_list_keys)>(node_id,object_pool_pathname);
-            result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
-        }
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::set_log_retention(
+        const std::string& pathname, const LogRetentionPolicy& log_retention) {
+    auto opm = find_object_pool(pathname);
+    if (!opm.is_valid() || opm.is_null() || opm.deleted || opm.pathname != pathname) {
+        throw derecho::derecho_exception(std::string("object pool:")+pathname+" does not exist.");
     }
-    return result;
-}
+    opm.log_retention = log_retention;
+    opm.set_previous_version(CURRENT_VERSION,opm.version); // only check previous_version_by_key
+    // clear local cache entry.
+    std::unique_lock<std::shared_mutex> wlck(object_pool_metadata_cache_mutex);
+    object_pool_metadata_cache.erase(pathname);
+    wlck.unlock();
+    // determine the shard index by hashing
+    uint32_t metadata_service_shard_index = std::hash<std::string>{}(pathname) % this->template get_number_of_shards<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX);
 
-template <typename... CascadeTypes>
-auto ServiceClient<CascadeTypes...>::multi_list_keys(const std::string& object_pool_pathname) {
-    volatile uint32_t subgroup_type_index,subgroup_index,shard_index;
-    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(object_pool_pathname+"/_");
-    return this->template type_recursive_multi_list_keys<CascadeTypes...>(subgroup_type_index,object_pool_pathname);
+    return this->template put<CascadeMetadataService<CascadeTypes...>>(opm,METADATA_SERVICE_SUBGROUP_INDEX,metadata_service_shard_index);
 }
 
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>> ServiceClient<CascadeTypes...>::list_keys_by_time(
-        const uint64_t& ts_us,
-        const bool stable,
-        uint32_t subgroup_index,
-        uint32_t shard_index) {
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::apply_retention(
+        const std::map<std::string,LogRetentionPolicy>& policies,
+        uint32_t subgroup_index, uint32_t shard_index) {
+    static_assert(is_persistent_cascade_store<SubgroupType>::value, "Log retention is only supported by PersistentCascadeStore.");
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
-        try {
-            // do p2p list_keys_by_time as a subgroup member
+        if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+            // ordered apply_retention as a shard member
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-            if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
-                node_id = group_ptr->get_my_id();
+            return subgroup_handle.template ordered_send<RPC_NAME(ordered_apply_retention)>(policies);
+        } else {
+            // p2p apply_retention
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,std::string{});
+            try {
+                // as a subgroup member
+                auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+                return subgroup_handle.template p2p_send<RPC_NAME(apply_retention)>(node_id,policies);
+            } catch (derecho::invalid_subgroup_exception& ex) {
+                // as an external caller
+                auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
+                return subgroup_handle.template p2p_send<RPC_NAME(apply_retention)>(node_id,policies);
             }
-            return subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,"",ts_us,stable);
-        } catch (derecho::invalid_subgroup_exception& ex) {
-            // do p2p list_keys_by_time as an external client.
-            auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-            return subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,"",ts_us,stable);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
         // call as an external client (ExternalClientCaller).
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
-        return caller.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,"",ts_us,stable);
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,std::string{});
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(apply_retention)>(node_id,policies);
+        });
     }
 }
 
 template <typename... CascadeTypes>
 template <typename FirstType, typename SecondType, typename... RestTypes>
-auto ServiceClient<CascadeTypes...>::type_recursive_list_keys_by_time(
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_apply_retention(
         uint32_t type_index,
-        const uint64_t& ts_us,
-        const bool stable,
-        const std::string& object_pool_pathname) {
+        const std::map<std::string,LogRetentionPolicy>& policies,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template __list_keys_by_time<FirstType>(ts_us,stable,object_pool_pathname);
+        if constexpr (is_persistent_cascade_store<FirstType>::value) {
+            return this->template apply_retention<FirstType>(policies,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": log retention is only supported by PersistentCascadeStore.");
+        }
     } else {
-        return this->template type_recursive_list_keys_by_time<SecondType, RestTypes...>(type_index-1,ts_us,stable,object_pool_pathname);
+        return this->template type_recursive_apply_retention<SecondType, RestTypes...>(type_index-1,policies,subgroup_index,shard_index);
     }
 }
 
 template <typename... CascadeTypes>
 template <typename LastType>
-auto ServiceClient<CascadeTypes...>::type_recursive_list_keys_by_time(
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_apply_retention(
         uint32_t type_index,
-        const uint64_t& ts_us,
-        const bool stable,
-        const std::string& object_pool_pathname) {
+        const std::map<std::string,LogRetentionPolicy>& policies,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
     if (type_index == 0) {
-        return this->template __list_keys_by_time<LastType>(ts_us,stable,object_pool_pathname);
+        if constexpr (is_persistent_cascade_store<LastType>::value) {
+            return this->template apply_retention<LastType>(policies,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": log retention is only supported by PersistentCascadeStore.");
+        }
     } else {
         throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
 }
 
+template <typename... CascadeTypes>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::apply_retention(
+        uint32_t subgroup_type_index,
+        const std::map<std::string,LogRetentionPolicy>& policies,
+        uint32_t subgroup_index, uint32_t shard_index) {
+    return this->template type_recursive_apply_retention<CascadeTypes...>(subgroup_type_index,policies,subgroup_index,shard_index);
+}
+
 template <typename... CascadeTypes>
 template <typename SubgroupType>
-std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> ServiceClient<CascadeTypes...>::__list_keys_by_time(
-        const uint64_t& ts_us,
-        const bool stable,
-        const std::string& object_pool_pathname){
-    auto opm = find_object_pool(object_pool_pathname);
-    if (!opm.is_valid() || opm.is_null() || opm.deleted) {
-        throw derecho::derecho_exception("Failed to find object_pool:" + object_pool_pathname);
-    }
-    uint32_t subgroup_index = opm.subgroup_index;
-    uint32_t shards = get_number_of_shards<SubgroupType>(subgroup_index);
-    std::vector<std::unique_ptr<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>> result;
-    for (uint32_t shard_index = 0; shard_index < shards; shard_index ++){
-        if (!is_external_client()) {
-            std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
-            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,object_pool_pathname);
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::set_blob_thresholds(
+        const std::map<std::string,uint64_t>& thresholds,
+        uint32_t subgroup_index, uint32_t shard_index) {
+    static_assert(is_persistent_cascade_store<SubgroupType>::value, "Blob thresholds are only supported by PersistentCascadeStore.");
+    if (!is_external_client()) {
+        if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
+            // ordered set_blob_thresholds as a shard member
+            auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
+            return subgroup_handle.template ordered_send<RPC_NAME(ordered_set_blob_thresholds)>(thresholds);
+        } else {
+            // p2p set_blob_thresholds
+            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,std::string{});
             try {
-                // do p2p list_keys_by_time as a subgroup member.
+                // as a subgroup member
                 auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
-                if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
-                    node_id = group_ptr->get_my_id();
-                }
-                auto shard_keys = subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,object_pool_pathname,ts_us,stable);
-                result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
+                return subgroup_handle.template p2p_send<RPC_NAME(set_blob_thresholds)>(node_id,thresholds);
             } catch (derecho::invalid_subgroup_exception& ex) {
-                // do p2p list_keys_by_time as an external client.
+                // as an external caller
                 auto& subgroup_handle = group_ptr->template get_nonmember_subgroup<SubgroupType>(subgroup_index);
-                auto shard_keys = subgroup_handle.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,object_pool_pathname,ts_us,stable);
-                result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
+                return subgroup_handle.template p2p_send<RPC_NAME(set_blob_thresholds)>(node_id,thresholds);
             }
-        } else {
-            std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
-            // call as an external client (ExternalClientCaller).
-            auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-            node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,object_pool_pathname);
-            auto shard_keys = caller.template p2p_send<RPC_NAME(list_keys_by_time)>(node_id,object_pool_pathname,ts_us,stable);
-            result.emplace_back(std::make_unique<derecho::rpc::QueryResults<std::vector<typename SubgroupType::KeyType>>>(std::move(shard_keys)));
         }
+    } else {
+        // call as an external client (ExternalClientCaller).
+        node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,std::string{});
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(set_blob_thresholds)>(node_id,thresholds);
+        });
     }
-    return result;
-}
-
-template <typename... CascadeTypes>
-auto ServiceClient<CascadeTypes...>::list_keys_by_time(const uint64_t& ts_us, const bool stable, const std::string& object_pool_pathname) {
-    volatile uint32_t subgroup_type_index,subgroup_index,shard_index;
-    std::tie(subgroup_type_index,subgroup_index,shard_index) = this->template key_to_shard(object_pool_pathname+"/_");
-    return this->template type_recursive_list_keys_by_time<CascadeTypes...>(subgroup_type_index,ts_us,stable,object_pool_pathname);
 }
 
 template <typename... CascadeTypes>
-void ServiceClient<CascadeTypes...>::refresh_object_pool_metadata_cache() {
-    std::unordered_map<std::string,ObjectPoolMetadataCacheEntry> refreshed_metadata;
-    uint32_t num_shards = this->template get_number_of_shards<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX);
-    for(uint32_t shard=0;shard<num_shards;shard++) {
-        auto results = this->template multi_list_keys<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX,shard);
-        for (auto& reply : results.get()) { // only once
-            for(auto& key: reply.second.get()) { // iterate over keys
-                // we only read the stable version.
-                auto opm_result = this->template get<CascadeMetadataService<CascadeTypes...>>(key,CURRENT_VERSION,false,METADATA_SERVICE_SUBGROUP_INDEX,shard);
-                for (auto& opm_reply:opm_result.get()) { // only once
-                    refreshed_metadata.emplace(key,opm_reply.second.get());
-                    break;
-                }
-            }
-            break;
+template <typename FirstType, typename SecondType, typename... RestTypes>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_set_blob_thresholds(
+        uint32_t type_index,
+        const std::map<std::string,uint64_t>& thresholds,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_persistent_cascade_store<FirstType>::value) {
+            return this->template set_blob_thresholds<FirstType>(thresholds,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": blob thresholds are only supported by PersistentCascadeStore.");
         }
+    } else {
+        return this->template type_recursive_set_blob_thresholds<SecondType, RestTypes...>(type_index-1,thresholds,subgroup_index,shard_index);
     }
-
-    std::unique_lock<std::shared_mutex> wlck(object_pool_metadata_cache_mutex);
-    this->object_pool_metadata_cache = std::move(refreshed_metadata);
 }
 
 template <typename... CascadeTypes>
-template <typename SubgroupType>
-derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::create_object_pool(
-        const std::string& pathname, const uint32_t subgroup_index,
-        const sharding_policy_t sharding_policy, const std::unordered_map<std::string,uint32_t>& object_locations,
-        const std::string& affinity_set_regex) {
-    uint32_t subgroup_type_index = ObjectPoolMetadata<CascadeTypes...>::template get_subgroup_type_index<SubgroupType>();
-    if (subgroup_type_index == ObjectPoolMetadata<CascadeTypes...>::invalid_subgroup_type_index) {
-        dbg_default_crit("Create object pool failed because of invalid SubgroupType:{}", typeid(SubgroupType).name());
-        throw derecho::derecho_exception(std::string("Create object pool failed because SubgroupType is invalid:")+typeid(SubgroupType).name());
-    }
-    ObjectPoolMetadata<CascadeTypes...> opm(pathname,subgroup_type_index,subgroup_index,sharding_policy,object_locations,affinity_set_regex,false);
-    // clear local cache entry.
-    std::shared_lock<std::shared_mutex> rlck(object_pool_metadata_cache_mutex);
-    if (object_pool_metadata_cache.find(pathname)==object_pool_metadata_cache.end()) {
-        rlck.unlock();
+template <typename LastType>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::type_recursive_set_blob_thresholds(
+        uint32_t type_index,
+        const std::map<std::string,uint64_t>& thresholds,
+        uint32_t subgroup_index,
+        uint32_t shard_index) {
+    if (type_index == 0) {
+        if constexpr (is_persistent_cascade_store<LastType>::value) {
+            return this->template set_blob_thresholds<LastType>(thresholds,subgroup_index,shard_index);
+        } else {
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": blob thresholds are only supported by PersistentCascadeStore.");
+        }
     } else {
-        rlck.unlock();
-        std::unique_lock<std::shared_mutex> wlck(object_pool_metadata_cache_mutex);
-        object_pool_metadata_cache.erase(pathname);
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": type index is out of boundary.");
     }
-    // determine the shard index by hashing
-    uint32_t metadata_service_shard_index = std::hash<std::string>{}(pathname) % this->template get_number_of_shards<CascadeMetadataService<CascadeTypes...>>(METADATA_SERVICE_SUBGROUP_INDEX);
+}
 
-    return this->template put<CascadeMetadataService<CascadeTypes...>>(opm,METADATA_SERVICE_SUBGROUP_INDEX,metadata_service_shard_index);
+template <typename... CascadeTypes>
+derecho::rpc::QueryResults<version_tuple> ServiceClient<CascadeTypes...>::set_blob_thresholds(
+        uint32_t subgroup_type_index,
+        const std::map<std::string,uint64_t>& thresholds,
+        uint32_t subgroup_index, uint32_t shard_index) {
+    return this->template type_recursive_set_blob_thresholds<CascadeTypes...>(subgroup_type_index,thresholds,subgroup_index,shard_index);
 }
 
 template <typename... CascadeTypes>
@@ -1953,9 +3765,11 @@ bool ServiceClient<CascadeTypes...>::register_notification_handler(
     if (per_type_registry.find(subgroup_index) == per_type_registry.cend()) {
         per_type_registry.emplace(subgroup_index,SubgroupNotificationHandler<SubgroupType>{});
         // register to subgroup_caller
-        auto& subgroup_caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-        // to do ... register it.
-        per_type_registry.at(subgroup_index).initialize(subgroup_caller);
+        // the registration updates the caller, which is shared by the threads sending through it.
+        auto& handler_registry = per_type_registry.at(subgroup_index);
+        external_call([this,&handler_registry,subgroup_index](external_group_t&) {
+            handler_registry.initialize(this->template get_external_caller<SubgroupType>(subgroup_index));
+        });
     }
     auto& subgroup_handlers = per_type_registry.at(subgroup_index);
 
@@ -2095,7 +3909,6 @@ template <typename SubgroupType>
 derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::dump_timestamp(const std::string& filename, const uint32_t subgroup_index, const uint32_t shard_index) {
 
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
             return subgroup_handle.template ordered_send<RPC_NAME(ordered_dump_timestamp_log)>(filename);
@@ -2105,10 +3918,10 @@ derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::dump_timestamp(
             return subgroup_handle.template p2p_send<RPC_NAME(dump_timestamp_log)>(node_id,filename);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,filename);
-        return caller.template p2p_send<RPC_NAME(dump_timestamp_log)>(node_id,filename);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(dump_timestamp_log)>(node_id,filename);
+        });
     }
 }
 
@@ -2162,7 +3975,6 @@ template <typename... CascadeTypes>
 template <typename SubgroupType>
 derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::dump_timestamp_workaround(const std::string& filename, const uint32_t subgroup_index, const uint32_t shard_index, const node_id_t node_id) {
     if (!is_external_client()) {
-        std::lock_guard<std::mutex> lck(this->group_ptr_mutex);
         if (static_cast<uint32_t>(group_ptr->template get_my_shard<SubgroupType>(subgroup_index)) == shard_index) {
             auto& subgroup_handle = group_ptr->template get_subgroup<SubgroupType>(subgroup_index);
             return subgroup_handle.template p2p_send<RPC_NAME(dump_timestamp_log_workaround)>(node_id, filename);
@@ -2171,9 +3983,9 @@ derecho::rpc::QueryResults<void> ServiceClient<CascadeTypes...>::dump_timestamp_
             return subgroup_handle.template p2p_send<RPC_NAME(dump_timestamp_log_workaround)>(node_id,filename);
         }
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
-        return caller.template p2p_send<RPC_NAME(dump_timestamp_log_workaround)>(node_id,filename);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(dump_timestamp_log_workaround)>(node_id,filename);
+        });
     }
 }
 
@@ -2184,10 +3996,10 @@ derecho::rpc::QueryResults<double> ServiceClient<CascadeTypes...>::perf_put(cons
         // 'perf_put' must be issued from an external client.
         throw derecho::derecho_exception{"perf_put must be issued from an external client."};
     } else {
-        std::lock_guard<std::mutex> lck(this->external_group_ptr_mutex);
-        auto& caller = external_group_ptr->template get_subgroup_caller<SubgroupType>(subgroup_index);
         node_id_t node_id = pick_member_by_policy<SubgroupType>(subgroup_index,shard_index,0);
-        return caller.template p2p_send<RPC_NAME(perf_put)>(node_id,message_size,duration_sec);
+        return this->template external_send<SubgroupType>(subgroup_index,[&](auto& caller) {
+            return caller.template p2p_send<RPC_NAME(perf_put)>(node_id,message_size,duration_sec);
+        });
     }
 }
 #endif//ENABLE_EVALUATION
@@ -2239,6 +4051,15 @@ ServiceClient<CascadeTypes...>& ServiceClient<CascadeTypes...>::get_service_clie
     }
     return *service_client_singleton_ptr;
 }
+
+template <typename... CascadeTypes>
+void ServiceClient<CascadeTypes...>::refresh_singleton_view() {
+    std::lock_guard<std::mutex> lock_guard(singleton_mutex);
+    // the first view is installed before the singleton is initialized.
+    if (service_client_singleton_ptr) {
+        service_client_singleton_ptr->refresh_view();
+    }
+}
 #endif//__WITHOUT_SERVICE_SINGLETONS__
 
 template <typename... CascadeTypes>
@@ -2432,6 +4253,13 @@ void ExecutionEngine<CascadeTypes...>::construct() {
                 // worker id 0xFFFFFFFF is reserved for single thread
                 this->workhorse(0xFFFFFFFF,single_threaded_action_queue_for_p2p);
             });
+    // 3 - start the log retention worker
+    uint32_t log_retention_interval = derecho::hasCustomizedConfKey(CASCADE_CONTEXT_LOG_RETENTION_INTERVAL)?
+                                      derecho::getConfUInt32(CASCADE_CONTEXT_LOG_RETENTION_INTERVAL):
+                                      CASCADE_CONTEXT_LOG_RETENTION_INTERVAL_DEFAULT;
+    if (log_retention_interval > 0) {
+        log_retention_thread = std::thread(&ExecutionEngine<CascadeTypes...>::log_retention_worker,this,log_retention_interval);
+    }
 }
 
 template <typename... CascadeTypes>
@@ -2455,6 +4283,69 @@ void ExecutionEngine<CascadeTypes...>::workhorse(uint32_t worker_id, struct acti
     dbg_default_trace("Cascade context workhorse[{}] finished normally.", static_cast<uint64_t>(gettid()));
 }
 
+template <typename... CascadeTypes>
+void ExecutionEngine<CascadeTypes...>::log_retention_worker(uint32_t interval_sec) {
+    pthread_setname_np(pthread_self(), "cs_retention");
+    dbg_default_trace("Cascade context log retention worker started");
+    auto& client = this->get_service_client_ref();
+    // the blob thresholds last set by this node in each shard it leads.
+    std::map<std::tuple<uint32_t,uint32_t,uint32_t>,std::map<std::string,uint64_t>> set_blob_thresholds;
+    std::unique_lock<std::mutex> lck(log_retention_mutex);
+    while(is_running) {
+        log_retention_cv.wait_for(lck,std::chrono::seconds(interval_sec),[this]{return !is_running;});
+        if (!is_running) {
+            break;
+        }
+        lck.unlock();
+        try {
+            // collect the policies and blob thresholds of the object pools in each shard led by this node.
+            std::map<std::tuple<uint32_t,uint32_t,uint32_t>,std::map<std::string,LogRetentionPolicy>> shard_policies;
+            std::map<std::tuple<uint32_t,uint32_t,uint32_t>,std::map<std::string,uint64_t>> shard_blob_thresholds;
+            for (const auto& pathname: client.list_object_pools(false,true)) {
+                auto opm = client.find_object_pool(pathname);
+                if (!opm.is_valid() || opm.is_null() || (!opm.log_retention.is_enabled() && opm.blob_threshold == 0)) {
+                    continue;
+                }
+                uint32_t num_shards = client.get_number_of_shards(pathname);
+                for (uint32_t shard_index = 0; shard_index < num_shards; shard_index++) {
+                    auto members = client.get_shard_members(pathname,shard_index);
+                    if (!members.empty() && members.front() == client.get_my_id()) {
+                        if (opm.log_retention.is_enabled()) {
+                            shard_policies[{opm.subgroup_type_index,opm.subgroup_index,shard_index}].emplace(pathname,opm.log_retention);
+                        }
+                        if (opm.blob_threshold > 0) {
+                            shard_blob_thresholds[{opm.subgroup_type_index,opm.subgroup_index,shard_index}].emplace(pathname,opm.blob_threshold);
+                        }
+                    }
+                }
+            }
+            // the thresholds are logged by the shards, so they are only set when they differ from those this node set
+            // last, which catches up with the object pools created or changed while the shard was unavailable.
+            for (const auto& shard: shard_blob_thresholds) {
+                auto it = set_blob_thresholds.find(shard.first);
+                if (it != set_blob_thresholds.end() && it->second == shard.second) {
+                    continue;
+                }
+                auto result = client.set_blob_thresholds(std::get<0>(shard.first),shard.second,std::get<1>(shard.first),std::get<2>(shard.first));
+                for (auto& reply: result.get()) {
+                    reply.second.get();
+                }
+                set_blob_thresholds[shard.first] = shard.second;
+            }
+            for (const auto& shard: shard_policies) {
+                auto result = client.apply_retention(std::get<0>(shard.first),shard.second,std::get<1>(shard.first),std::get<2>(shard.first));
+                for (auto& reply: result.get()) {
+                    reply.second.get();
+                }
+            }
+        } catch (const std::exception& ex) {
+            dbg_default_warn("Log retention round failed: {}", ex.what());
+        }
+        lck.lock();
+    }
+    dbg_default_trace("Cascade context log retention worker finished normally.");
+}
+
 template <typename... CascadeTypes>
 void ExecutionEngine<CascadeTypes...>::action_queue::initialize() {
     action_buffer_head.store(0);
@@ -2548,6 +4439,13 @@ void ExecutionEngine<CascadeTypes...>::destroy() {
     if(single_threaded_workhorse_for_p2p.joinable()) {
         single_threaded_workhorse_for_p2p.join();
     }
+    {
+        std::lock_guard<std::mutex> lck(log_retention_mutex);
+        log_retention_cv.notify_all();
+    }
+    if(log_retention_thread.joinable()) {
+        log_retention_thread.join();
+    }
     dbg_default_trace("Cascade context@{:p} is destroyed.",static_cast<void*>(this));
 }
 
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * SharedTreeMap is a sorted map whose copies share their nodes. It is a treap of immutable nodes: an update copies
+ * only the O(log n) nodes on the path to the key, so copying the map is O(1), and a copy keeps the content it had when
+ * it was made while the original is updated. The priority of a node is a hash of its key, so the shape of the tree
+ * does not depend on the order of the updates.
+ *
+ * SharedTreeMap is not thread safe, but different copies can be used by different threads, since the nodes they share
+ * are never modified.
+ *
+ * @tparam K    - the key type, which must be hashable by std::hash
+ * @tparam V    - the value type
+ */
+template <typename K, typename V>
+class SharedTreeMap {
+private:
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+    struct Node {
+        K key;
+        V value;
+        uint64_t priority;
+        /* the number of nodes in the subtree */
+        std::size_t size;
+        NodePtr left;
+        NodePtr right;
+    };
+    NodePtr root;
+
+    inline static uint64_t priority_of(const K& key);
+    inline static std::size_t size_of(const NodePtr& node) { return node ? node->size : 0; }
+    /**
+     * @return the node with new children, which is a copy unless the children are unchanged.
+     */
+    inline static NodePtr with_children(const NodePtr& node, const NodePtr& left, const NodePtr& right);
+    /**
+     * Split a tree into the nodes before, at, and after a key.
+     */
+    template <typename Key>
+    inline static void split(const NodePtr& node, const Key& key, NodePtr& less, NodePtr& equal, NodePtr& greater);
+    /**
+     * Merge two trees, where all keys of `left` are before all keys of `right`.
+     */
+    inline static NodePtr merge(const NodePtr& left, const NodePtr& right);
+    template <typename Visitor>
+    inline static bool for_each(const NodePtr& node, Visitor& visitor);
+
+public:
+    SharedTreeMap() = default;
+
+    /**
+     * Insert a key, or replace its value.
+     */
+    inline void insert_or_assign(const K& key, const V& value);
+    /**
+     * Erase a key, which can be given as any type comparable with K.
+     *
+     * @return true if the key is found.
+     */
+    template <typename Key>
+    inline bool erase(const Key& key);
+    /**
+     * Find a key, which can be given as any type comparable with K.
+     *
+     * @return the value of the key, or nullptr if the key is not found. It is valid while this map is not updated.
+     */
+    template <typename Key>
+    inline const V* find(const Key& key) const;
+    /**
+     * Visit the entries in the order of the keys.
+     *
+     * @param visitor   A callable as bool(const K&, const V&), which returns false to stop.
+     *
+     * @return false if the visitor stopped.
+     */
+    template <typename Visitor>
+    inline bool for_each(Visitor&& visitor) const;
+    std::size_t size() const { return size_of(root); }
+    bool empty() const { return !root; }
+    void clear() { root.reset(); }
+};
+
+}  // namespace cascade
+}  // namespace derecho
+
+#include "shared_tree_map_impl.hpp"
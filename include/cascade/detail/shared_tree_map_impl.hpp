@@ -0,0 +1,116 @@
+#pragma once
+
+#include <utility>
+
+namespace derecho {
+namespace cascade {
+
+template <typename K, typename V>
+uint64_t SharedTreeMap<K, V>::priority_of(const K& key) {
+    // mix the hash, since std::hash of an integer is the integer itself, and ordered priorities degrade the treap.
+    uint64_t x = static_cast<uint64_t>(std::hash<K>{}(key)) + 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+template <typename K, typename V>
+typename SharedTreeMap<K, V>::NodePtr SharedTreeMap<K, V>::with_children(const NodePtr& node, const NodePtr& left,
+                                                                        const NodePtr& right) {
+    if(node->left == left && node->right == right) {
+        return node;
+    }
+    return std::make_shared<const Node>(
+            Node{node->key, node->value, node->priority, size_of(left) + size_of(right) + 1, left, right});
+}
+
+template <typename K, typename V>
+template <typename Key>
+void SharedTreeMap<K, V>::split(const NodePtr& node, const Key& key, NodePtr& less, NodePtr& equal, NodePtr& greater) {
+    if(!node) {
+        less.reset();
+        equal.reset();
+        greater.reset();
+    } else if(key < node->key) {
+        NodePtr left_greater;
+        split(node->left, key, less, equal, left_greater);
+        greater = with_children(node, left_greater, node->right);
+    } else if(node->key < key) {
+        NodePtr right_less;
+        split(node->right, key, right_less, equal, greater);
+        less = with_children(node, node->left, right_less);
+    } else {
+        less = node->left;
+        equal = node;
+        greater = node->right;
+    }
+}
+
+template <typename K, typename V>
+typename SharedTreeMap<K, V>::NodePtr SharedTreeMap<K, V>::merge(const NodePtr& left, const NodePtr& right) {
+    if(!left) {
+        return right;
+    }
+    if(!right) {
+        return left;
+    }
+    if(left->priority > right->priority) {
+        return with_children(left, left->left, merge(left->right, right));
+    }
+    return with_children(right, merge(left, right->left), right->right);
+}
+
+template <typename K, typename V>
+void SharedTreeMap<K, V>::insert_or_assign(const K& key, const V& value) {
+    NodePtr less, equal, greater;
+    split(root, key, less, equal, greater);
+    NodePtr node = std::make_shared<const Node>(Node{key, value, priority_of(key), 1, nullptr, nullptr});
+    root = merge(merge(less, node), greater);
+}
+
+template <typename K, typename V>
+template <typename Key>
+bool SharedTreeMap<K, V>::erase(const Key& key) {
+    if(find(key) == nullptr) {
+        // nothing is copied.
+        return false;
+    }
+    NodePtr less, equal, greater;
+    split(root, key, less, equal, greater);
+    root = merge(less, greater);
+    return true;
+}
+
+template <typename K, typename V>
+template <typename Key>
+const V* SharedTreeMap<K, V>::find(const Key& key) const {
+    const Node* node = root.get();
+    while(node != nullptr) {
+        if(key < node->key) {
+            node = node->left.get();
+        } else if(node->key < key) {
+            node = node->right.get();
+        } else {
+            return &node->value;
+        }
+    }
+    return nullptr;
+}
+
+template <typename K, typename V>
+template <typename Visitor>
+bool SharedTreeMap<K, V>::for_each(const NodePtr& node, Visitor& visitor) {
+    if(!node) {
+        return true;
+    }
+    return for_each(node->left, visitor) && visitor(node->key, node->value) && for_each(node->right, visitor);
+}
+
+template <typename K, typename V>
+template <typename Visitor>
+bool SharedTreeMap<K, V>::for_each(Visitor&& visitor) const {
+    return for_each(root, visitor);
+}
+
+}  // namespace cascade
+}  // namespace derecho
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * TimingWheel is a hierarchical timing wheel holding entries due at a tick.
+ *
+ * The wheel has LEVELS levels of SLOTS slots. A slot of level l covers SLOTS^l ticks, so an entry is placed in the
+ * lowest level whose span covers its distance from the current tick. When the current tick crosses a slot boundary of
+ * a higher level, the entries of that slot are cascaded down to the lower levels. Scheduling is O(1), and advancing is
+ * O(1) per tick plus the entries cascaded or due. An entry further away than the span of the wheel waits in the last
+ * level and is placed again each time its slot cascades.
+ *
+ * TimingWheel is not thread safe.
+ *
+ * @tparam T    - the type of the entries
+ */
+template <typename T>
+class TimingWheel {
+public:
+    static constexpr uint32_t SLOT_BITS = 6;
+    static constexpr uint32_t SLOTS = 1u << SLOT_BITS;
+    static constexpr uint32_t LEVELS = 4;
+
+private:
+    struct Entry {
+        T item;
+        uint64_t deadline;
+    };
+    std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> wheel;
+    /* the next tick to process */
+    uint64_t current_tick;
+    /* the number of entries */
+    std::size_t num_entries;
+
+    /**
+     * Place an entry in the slot of its deadline, or in the current slot if it is overdue.
+     */
+    inline void place(Entry&& entry);
+    /**
+     * Move the entries of the current slot of a level to the lower levels.
+     */
+    inline void cascade(uint32_t level);
+
+public:
+    /**
+     * Constructor
+     *
+     * @param start_tick    The first tick to process
+     */
+    explicit TimingWheel(uint64_t start_tick = 0);
+
+    /**
+     * Schedule an entry. An entry due before the current tick is due at the current tick.
+     *
+     * @param item          The entry
+     * @param deadline      The tick at which the entry is due
+     */
+    inline void schedule(const T& item, uint64_t deadline);
+
+    /**
+     * Process all the ticks up to and including `now`.
+     *
+     * @param now           The current tick
+     * @param due           The entries due by `now` are appended to it.
+     */
+    inline void advance(uint64_t now, std::vector<T>& due);
+
+    /**
+     * Drop all entries, and restart from a tick.
+     *
+     * @param start_tick    The first tick to process
+     */
+    inline void reset(uint64_t start_tick);
+
+    /**
+     * @return the number of entries.
+     */
+    inline std::size_t size() const;
+
+    /**
+     * @return the next tick to process.
+     */
+    inline uint64_t get_current_tick() const;
+};
+
+}  // namespace cascade
+}  // namespace derecho
+
+#include "timing_wheel_impl.hpp"
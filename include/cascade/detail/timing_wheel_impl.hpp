@@ -0,0 +1,86 @@
+#pragma once
+
+namespace derecho {
+namespace cascade {
+
+template <typename T>
+TimingWheel<T>::TimingWheel(uint64_t start_tick) : current_tick(start_tick), num_entries(0) {}
+
+template <typename T>
+void TimingWheel<T>::place(Entry&& entry) {
+    const uint64_t target = (entry.deadline < current_tick) ? current_tick : entry.deadline;
+    const uint64_t delta = target - current_tick;
+    uint32_t level = 0;
+    while(level < LEVELS - 1 && delta >= (uint64_t{1} << (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    uint64_t slot_tick = target;
+    if(delta >= (uint64_t{1} << (SLOT_BITS * LEVELS))) {
+        // beyond the span of the wheel: wait in the last slot of the last level, keeping the real deadline.
+        slot_tick = current_tick + (uint64_t{1} << (SLOT_BITS * LEVELS)) - 1;
+    }
+    wheel[level][(slot_tick >> (SLOT_BITS * level)) & (SLOTS - 1)].emplace_back(std::move(entry));
+}
+
+template <typename T>
+void TimingWheel<T>::cascade(uint32_t level) {
+    auto& slot = wheel[level][(current_tick >> (SLOT_BITS * level)) & (SLOTS - 1)];
+    std::vector<Entry> entries;
+    entries.swap(slot);
+    for(auto& entry : entries) {
+        place(std::move(entry));
+    }
+}
+
+template <typename T>
+void TimingWheel<T>::schedule(const T& item, uint64_t deadline) {
+    place(Entry{item, deadline});
+    num_entries++;
+}
+
+template <typename T>
+void TimingWheel<T>::advance(uint64_t now, std::vector<T>& due) {
+    while(current_tick <= now) {
+        if(num_entries == 0) {
+            current_tick = now + 1;
+            break;
+        }
+        // the higher levels go first, since they cascade into the slots of the lower levels at this tick.
+        for(uint32_t level = LEVELS - 1; level > 0; level--) {
+            if((current_tick & ((uint64_t{1} << (SLOT_BITS * level)) - 1)) == 0) {
+                cascade(level);
+            }
+        }
+        auto& slot = wheel[0][current_tick & (SLOTS - 1)];
+        for(auto& entry : slot) {
+            due.emplace_back(std::move(entry.item));
+        }
+        num_entries -= slot.size();
+        slot.clear();
+        current_tick++;
+    }
+}
+
+template <typename T>
+void TimingWheel<T>::reset(uint64_t start_tick) {
+    for(auto& level : wheel) {
+        for(auto& slot : level) {
+            slot.clear();
+        }
+    }
+    current_tick = start_tick;
+    num_entries = 0;
+}
+
+template <typename T>
+std::size_t TimingWheel<T>::size() const {
+    return num_entries;
+}
+
+template <typename T>
+uint64_t TimingWheel<T>::get_current_tick() const {
+    return current_tick;
+}
+
+}  // namespace cascade
+}  // namespace derecho
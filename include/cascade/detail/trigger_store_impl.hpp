@@ -28,6 +28,12 @@ void TriggerCascadeNoStore<KT, VT, IK, IV>::put_and_forget(const VT& value, bool
     dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple TriggerCascadeNoStore<KT, VT, IK, IV>::put_batch(const std::vector<VT>& values, bool as_trigger) const {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+    return {persistent::INVALID_VERSION, 0};
+}
+
 #ifdef ENABLE_EVALUATION
 template <typename KT, typename VT, KT* IK, VT* IV>
 double TriggerCascadeNoStore<KT, VT, IK, IV>::perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const {
@@ -48,6 +54,13 @@ const VT TriggerCascadeNoStore<KT, VT, IK, IV>::get(const KT& key, const persist
     return *IV;
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+const VT TriggerCascadeNoStore<KT, VT, IK, IV>::get_range(const KT& key, const persistent::version_t& ver, const bool stable,
+                                                          const uint64_t& offset, const uint64_t& length) const {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+    return *IV;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 const VT TriggerCascadeNoStore<KT, VT, IK, IV>::multi_get(const KT& key) const {
     dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
@@ -78,6 +91,20 @@ std::vector<KT> TriggerCascadeNoStore<KT, VT, IK, IV>::list_keys_by_time(const s
     return {};
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+key_page_t<KT> TriggerCascadeNoStore<KT, VT, IK, IV>::list_keys_paged(const std::string& prefix, const std::string& cursor, const uint32_t& limit) const {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+    return {};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+scan_page_t<VT> TriggerCascadeNoStore<KT, VT, IK, IV>::scan(const std::string& prefix, const std::string& filter,
+                                                            const std::string& projection, const std::string& cursor,
+                                                            const uint32_t& max_results) const {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+    return {};
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 uint64_t TriggerCascadeNoStore<KT, VT, IK, IV>::multi_get_size(const KT& key) const {
     dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
@@ -96,6 +123,19 @@ uint64_t TriggerCascadeNoStore<KT, VT, IK, IV>::get_size_by_time(const KT& key,
     return 0;
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+ObjectHead TriggerCascadeNoStore<KT, VT, IK, IV>::head(const KT& key, const persistent::version_t& ver, const bool stable) const {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+    return {};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<ObjectHead> TriggerCascadeNoStore<KT, VT, IK, IV>::head_batch(const std::vector<KT>& keys, const persistent::version_t& ver,
+                                                                          const bool stable) const {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+    return {};
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 std::vector<KT> TriggerCascadeNoStore<KT, VT, IK, IV>::ordered_list_keys(const std::string& prefix) {
     dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
@@ -113,6 +153,12 @@ void TriggerCascadeNoStore<KT, VT, IK, IV>::ordered_put_and_forget(const VT& val
     dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple TriggerCascadeNoStore<KT, VT, IK, IV>::ordered_put_batch(const std::vector<VT>& values, bool as_trigger) {
+    dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
+    return {persistent::INVALID_VERSION, 0};
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 version_tuple TriggerCascadeNoStore<KT, VT, IK, IV>::ordered_remove(const KT& key) {
     dbg_default_warn("Calling unsupported func:{}", __PRETTY_FUNCTION__);
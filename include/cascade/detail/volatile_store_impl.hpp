@@ -6,10 +6,16 @@
 #include "debug_util.hpp"
 
 #include <derecho/conf/conf.hpp>
+#include <derecho/core/derecho_exception.hpp>
 #include <derecho/persistent/PersistentInterface.hpp>
 #include <derecho/persistent/detail/PersistLog.hpp>
+#include <pthread.h>
+
+#include <algorithm>
+#include <exception>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 
@@ -47,6 +53,38 @@ void VolatileCascadeStore<KT, VT, IK, IV>::put_and_forget(const VT& value, bool
     debug_leave_func();
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCascadeStore<KT, VT, IK, IV>::merge(const VT& operand, const std::string& merge_operator) const {
+    debug_enter_func_with_args("operand.get_key_ref={},merge_operator={}", operand.get_key_ref(), merge_operator);
+
+    derecho::Replicated<VolatileCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_merge)>(operand,merge_operator);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCascadeStore<KT, VT, IK, IV>::put_batch(const std::vector<VT>& values, bool as_trigger) const {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    derecho::Replicated<VolatileCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_put_batch)>(values,as_trigger);
+    auto& replies = results.get();
+    version_tuple ret{CURRENT_VERSION, 0};
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
 #ifdef ENABLE_EVALUATION
 
 template <typename CascadeType>
@@ -122,54 +160,40 @@ const VT VolatileCascadeStore<KT, VT, IK, IV>::get(const KT& key, const persiste
         return *IV;
     }
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_GET_START, group, *IV);
-
-    // copy data out
-    persistent::version_t v1, v2;
-    static thread_local VT copied_out;
-    do {
-        // This only for TSO memory reordering.
-        v2 = this->lockless_v2.load(std::memory_order_relaxed);
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        /* 
-         * An out_of_range exception can be thrown even if 'key' exists in
-         * kv_map. Since std::map is not thread-safe, and there is another
-         * thread modifying kv_map concurrently, the internal data structure can
-         * be changed while this thread is inside kv_map.at(key). Therefore, we
-         * keep trying until it is possible to copy either the object we are
-         * looking for, or the invalid object.
-         */
-        while(true) {
-            try {
-                if(this->kv_map.find(key) != this->kv_map.end()) {
-                    copied_out.copy_from(this->kv_map.at(key));
-                } else {
-                    copied_out.copy_from(*IV);
-                }
-
-                break;
-            } catch (const std::out_of_range&) {
-                dbg_default_debug("{}: out_of_range exception thrown while trying to get key {}", __PRETTY_FUNCTION__, key);
-            }
+    this->check_transferred(key);
+
+    // If VT implements ISharePayload, the copy pins the payload of the stored object instead of copying it, and the
+    // reply is serialized straight from the pinned buffer.
+    EpochGuard epoch_guard;
+    const VT* value_ptr = this->kv_index.find(key);
+    // an expired object is skipped before it is removed.
+    if(value_ptr != nullptr && this->is_expired(*value_ptr)) {
+        value_ptr = nullptr;
+    }
+    if(this->cache_enabled.load(std::memory_order_relaxed)) {
+        if(value_ptr != nullptr && !value_ptr->is_null()) {
+            this->cache_hits.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            this->cache_misses.fetch_add(1, std::memory_order_relaxed);
         }
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        v1 = this->lockless_v1.load(std::memory_order_relaxed);
-        // busy sleep
-        std::this_thread::yield();
-    } while(v1 != v2);
+    }
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_GET_END, group, *IV);
-    return copied_out;
+    if(value_ptr != nullptr) {
+        return *value_ptr;
+    } else {
+        return *IV;
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+const VT VolatileCascadeStore<KT, VT, IK, IV>::get_range(const KT& key, const persistent::version_t& ver, const bool stable,
+                                                         const uint64_t& offset, const uint64_t& length) const {
+    debug_enter_func_with_args("key={},ver=0x{:x},offset={},length={}", key, ver, offset, length);
+    // the copy pins the shared payload of the stored object, which is then sliced.
+    VT value = this->get(key, ver, stable, false);
+    slice_payload(value, offset, length);
+    debug_leave_func();
+    return value;
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
@@ -224,37 +248,19 @@ std::vector<KT> VolatileCascadeStore<KT, VT, IK, IV>::list_keys(const std::strin
         return {};
     }
 
+    if(this->transfer_in_progress.load()) {
+        throw std::runtime_error("Keys are not available until the state transfer to this member finishes.");
+    }
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_LIST_KEYS_START, group, *IV);
     // copy key list out
     std::vector<KT> key_list;
-    persistent::version_t v1, v2;
-    static thread_local VT copied_out;
-    do {
-        // This only for TSO memory reordering.
-        v2 = this->lockless_v2.load(std::memory_order_relaxed);
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        for(auto kv : this->kv_map) {
-            if(get_pathname<KT>(kv.first).find(prefix) == 0) {
-                key_list.push_back(kv.first);
-            }
-        }
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        v1 = this->lockless_v1.load(std::memory_order_relaxed);
-        // busy sleep
-        std::this_thread::yield();
-    } while(v1 != v2);
+    {
+        EpochGuard epoch_guard;
+        this->kv_index.for_each_with_prefix(prefix, [&key_list](const KT& key, const VT&) {
+            key_list.push_back(key);
+            return true;
+        });
+    }
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_LIST_KEYS_END, group, *IV);
 
     return key_list;
@@ -268,6 +274,72 @@ std::vector<KT> VolatileCascadeStore<KT, VT, IK, IV>::list_keys_by_time(const st
     return {};
 }
 
+// a volatile store keeps no history, so the pages follow the latest keys. A key present throughout the listing is
+// returned exactly once.
+template <typename KT, typename VT, KT* IK, VT* IV>
+key_page_t<KT> VolatileCascadeStore<KT, VT, IK, IV>::list_keys_paged(const std::string& prefix, const std::string& cursor,
+                                                                     const uint32_t& limit) const {
+    debug_enter_func_with_args("prefix={},cursor={},limit={}", prefix, cursor, limit);
+    KeyPageCursor<KT> page_cursor{CURRENT_VERSION, *IK};
+    if(limit == 0 || (!cursor.empty() && !KeyPageCursor<KT>::decode(cursor, page_cursor))) {
+        dbg_default_warn("{}: invalid cursor '{}' or limit {}.", __PRETTY_FUNCTION__, cursor, limit);
+        return {};
+    }
+    if(this->transfer_in_progress.load()) {
+        throw std::runtime_error("Keys are not available until the state transfer to this member finishes.");
+    }
+    std::vector<KT> keys;
+    bool has_more = false;
+    auto visitor = [&keys, &has_more, limit](const KT& key, const VT&) {
+        if(keys.size() == limit) {
+            has_more = true;
+            return false;
+        }
+        keys.push_back(key);
+        return true;
+    };
+    {
+        EpochGuard epoch_guard;
+        if(cursor.empty()) {
+            this->kv_index.for_each_with_prefix(prefix, visitor);
+        } else {
+            this->kv_index.for_each_with_prefix_after(prefix, page_cursor.last_key, visitor);
+        }
+    }
+    std::string next_cursor;
+    if(has_more) {
+        page_cursor.last_key = keys.back();
+        next_cursor = page_cursor.encode();
+    }
+    debug_leave_func_with_value("{} keys, next cursor '{}'", keys.size(), next_cursor);
+    return {std::move(keys), std::move(next_cursor)};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+scan_page_t<VT> VolatileCascadeStore<KT, VT, IK, IV>::scan(const std::string& prefix, const std::string& filter,
+                                                           const std::string& projection, const std::string& cursor,
+                                                           const uint32_t& max_results) const {
+    debug_enter_func_with_args("prefix={},filter={},projection={},cursor={},max_results={}", prefix, filter, projection, cursor, max_results);
+    ScanPage<KT, VT> page(filter, projection, cursor, max_results);
+    if(this->transfer_in_progress.load()) {
+        throw std::runtime_error("Objects are not available until the state transfer to this member finishes.");
+    }
+    auto visitor = [this, &page](const KT& key, const VT& value) {
+        return this->is_expired(value) || page.add(key, value);
+    };
+    {
+        EpochGuard epoch_guard;
+        if(!page.start_after().has_value()) {
+            this->kv_index.for_each_with_prefix(prefix, visitor);
+        } else {
+            this->kv_index.for_each_with_prefix_after(prefix, *page.start_after(), visitor);
+        }
+    }
+    auto result = page.finish();
+    debug_leave_func_with_value("{} objects, next cursor '{}'", std::get<0>(result).size(), std::get<1>(result));
+    return result;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 uint64_t VolatileCascadeStore<KT, VT, IK, IV>::multi_get_size(const KT& key) const {
     debug_enter_func_with_args("key={}", key);
@@ -298,32 +370,15 @@ uint64_t VolatileCascadeStore<KT, VT, IK, IV>::get_size(const KT& key, const per
 
     // copy data out
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_GET_SIZE_START, group, *IV);
-    persistent::version_t v1, v2;
+    this->check_transferred(key);
     uint64_t size = 0ull;
-    do {
-        // This only for TSO memory reordering.
-        v2 = this->lockless_v2.load(std::memory_order_relaxed);
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        if(this->kv_map.find(key) != this->kv_map.end()) {
-            size = mutils::bytes_size(this->kv_map.at(key));
+    {
+        EpochGuard epoch_guard;
+        const VT* value_ptr = this->kv_index.find(key);
+        if(value_ptr != nullptr && !this->is_expired(*value_ptr)) {
+            size = mutils::bytes_size(*value_ptr);
         }
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                             : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        v1 = this->lockless_v1.load(std::memory_order_relaxed);
-        // busy sleep
-        std::this_thread::yield();
-    } while(v1 != v2);
+    }
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_GET_SIZE_END, group, *IV);
     return size;
 }
@@ -337,6 +392,41 @@ uint64_t VolatileCascadeStore<KT, VT, IK, IV>::get_size_by_time(const KT&, const
     return 0;
 }
 
+// stable is ignored for VolatileCascadeStore
+template <typename KT, typename VT, KT* IK, VT* IV>
+ObjectHead VolatileCascadeStore<KT, VT, IK, IV>::head(const KT& key, const persistent::version_t& ver, const bool) const {
+    debug_enter_func_with_args("key={},ver=0x{:x}", key, ver);
+    if(ver != CURRENT_VERSION) {
+        debug_leave_func_with_value("Cannot support versioned head, ver=0x{:x}", ver);
+        return ObjectHead{};
+    }
+    this->check_transferred(key);
+
+    // the metadata is read in place, without copying the payload.
+    EpochGuard epoch_guard;
+    const VT* value_ptr = this->kv_index.find(key);
+    if(value_ptr == nullptr || this->is_expired(*value_ptr)) {
+        debug_leave_func_with_value("key:{} is not found", key);
+        return ObjectHead{};
+    }
+    debug_leave_func();
+    return make_object_head(*value_ptr);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<ObjectHead> VolatileCascadeStore<KT, VT, IK, IV>::head_batch(const std::vector<KT>& keys,
+                                                                         const persistent::version_t& ver,
+                                                                         const bool stable) const {
+    debug_enter_func_with_args("{} keys,ver=0x{:x}", keys.size(), ver);
+    std::vector<ObjectHead> heads;
+    heads.reserve(keys.size());
+    for(const auto& key : keys) {
+        heads.emplace_back(this->head(key, ver, stable));
+    }
+    debug_leave_func();
+    return heads;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 std::vector<KT> VolatileCascadeStore<KT, VT, IK, IV>::ordered_list_keys(const std::string& prefix) {
     debug_enter_func();
@@ -350,12 +440,13 @@ std::vector<KT> VolatileCascadeStore<KT, VT, IK, IV>::ordered_list_keys(const st
 #else
     LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_VOLATILE_ORDERED_LIST_KEYS_START,group,*IV,std::get<0>(version_and_hlc));
 #endif
+    auto transfer_lck = this->lock_for_transfer();
+    this->wait_for_transfer(transfer_lck);
     std::vector<KT> key_list;
-    for(auto kv : this->kv_map) {
-        if(get_pathname<KT>(kv.first).find(prefix) == 0) {
-            key_list.push_back(kv.first);
-        }
-    }
+    this->kv_index.for_each_with_prefix(prefix, [&key_list](const KT& key, const VT&) {
+        key_list.push_back(key);
+        return true;
+    });
 #if __cplusplus > 201703L
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_ORDERED_LIST_KEYS_END,group,*IV,std::get<0>(version_and_hlc));
 #else
@@ -417,10 +508,153 @@ void VolatileCascadeStore<KT, VT, IK, IV>::ordered_put_and_forget(const VT& valu
     debug_leave_func();
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCascadeStore<KT, VT, IK, IV>::ordered_merge(const VT& operand, const std::string& merge_operator) {
+    debug_enter_func_with_args("key={},merge_operator={}", operand.get_key_ref(), merge_operator);
+
+    auto version_and_hlc = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_current_version();
+    version_tuple version_and_timestamp{persistent::INVALID_VERSION, 0};
+
+    if constexpr(std::is_base_of<IMergePayload, VT>::value) {
+        VT image(operand);
+        std::vector<uint8_t> merged;
+        bool merge_ok;
+        {
+            auto transfer_lck = this->lock_for_transfer();
+            this->wait_for_key(operand.get_key_ref(), transfer_lck);
+            const uint8_t* base = nullptr;
+            std::size_t base_size = 0;
+            auto it = this->kv_map.find(operand.get_key_ref());
+            if(it != this->kv_map.end() && !it->second.is_null()) {
+                base = it->second.get_payload_bytes();
+                base_size = it->second.get_payload_size();
+            }
+            merge_ok = MergeOperatorRegistry::get().merge(merge_operator, base, base_size,
+                                                          operand.get_payload_bytes(), operand.get_payload_size(), merged);
+        }
+        // the key has arrived, so the state transfer does not change it before internal_ordered_put.
+        if(!merge_ok) {
+            dbg_default_warn("{}: merge operator {} rejected the operand of key {}.", __PRETTY_FUNCTION__, merge_operator, operand.get_key_ref());
+        } else {
+            image.set_payload(merged.data(), merged.size());
+            if(this->internal_ordered_put(image,false) == true) {
+                version_and_timestamp = {std::get<0>(version_and_hlc),std::get<1>(version_and_hlc).m_rtc_us};
+            }
+        }
+    } else {
+        dbg_default_warn("{}: merge is not supported by the object type.", __PRETTY_FUNCTION__);
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_timestamp),
+            std::get<1>(version_and_timestamp));
+
+    return version_and_timestamp;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCascadeStore<KT, VT, IK, IV>::ordered_put_batch(const std::vector<VT>& values, bool as_trigger) {
+    debug_enter_func_with_args("num_objects={}", values.size());
+
+    auto version_and_hlc = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_current_version();
+    version_tuple version_and_timestamp{persistent::INVALID_VERSION, 0};
+
+    if(this->internal_ordered_put_batch(values,as_trigger) == true) {
+        version_and_timestamp = {std::get<0>(version_and_hlc),std::get<1>(version_and_hlc).m_rtc_us};
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_timestamp),
+            std::get<1>(version_and_timestamp));
+
+    return version_and_timestamp;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool VolatileCascadeStore<KT, VT, IK, IV>::internal_ordered_put_batch(const std::vector<VT>& values, bool as_trigger) {
+    auto version_and_hlc = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_current_version();
+
+    auto transfer_lck = this->lock_for_transfer();
+    if constexpr(std::is_base_of<IValidator<KT, VT>, VT>::value) {
+        // a validator may look at any key.
+        this->wait_for_transfer(transfer_lck);
+    } else {
+        for(const auto& value : values) {
+            this->wait_for_key(value.get_key_ref(), transfer_lck);
+        }
+    }
+    this->collect_tombstones(std::get<0>(version_and_hlc));
+
+    std::set<KT> keys;
+    for(const auto& value : values) {
+        if(!keys.insert(value.get_key_ref()).second) {
+            dbg_default_warn("{}: rejected a batch with duplicate key {}.", __PRETTY_FUNCTION__, value.get_key_ref());
+            return false;
+        }
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            value.set_version(std::get<0>(version_and_hlc));
+        }
+        if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+            value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+        }
+    }
+
+    // verify every object against the state before the batch, so that the batch is applied all or nothing.
+    for(const auto& value : values) {
+        if constexpr(std::is_base_of<IValidator<KT, VT>, VT>::value) {
+            if(!value.validate_stored(this->kv_map)) {
+                return false;
+            }
+        }
+        if constexpr(std::is_base_of<IVerifyPreviousVersion, VT>::value) {
+            auto it = this->kv_map.find(value.get_key_ref());
+            if(!value.verify_previous_version(this->update_version,
+                                              (it != this->kv_map.end()) ? it->second.get_version() : persistent::INVALID_VERSION)) {
+                return false;
+            }
+        }
+    }
+
+    for(const auto& value : values) {
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            auto it = this->kv_map.find(value.get_key_ref());
+            value.set_previous_version(this->update_version,
+                                       (it != this->kv_map.end()) ? it->second.get_version() : persistent::INVALID_VERSION);
+        }
+        if(!as_trigger) {
+            this->update_kv_map(value.get_key_ref(), value);
+        }
+    }
+    if(!as_trigger) {
+        this->update_version = std::get<0>(version_and_hlc);
+    }
+
+    if(cascade_watcher_ptr) {
+        for(const auto& value : values) {
+            (*cascade_watcher_ptr)(
+                    this->subgroup_index,
+                    group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_shard_num(),
+                    group->get_rpc_caller_id(),
+                    value.get_key_ref(), value, cascade_context_ptr);
+        }
+    }
+
+    return true;
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 bool VolatileCascadeStore<KT, VT, IK, IV>::internal_ordered_put(const VT& value, bool as_trigger) {
     auto version_and_hlc = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_current_version();
 
+    auto transfer_lck = this->lock_for_transfer();
+    if constexpr(std::is_base_of<IValidator<KT, VT>, VT>::value) {
+        // a validator may look at any key.
+        this->wait_for_transfer(transfer_lck);
+    } else {
+        this->wait_for_key(value.get_key_ref(), transfer_lck);
+    }
+    this->collect_tombstones(std::get<0>(version_and_hlc));
+
     if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
         value.set_version(std::get<0>(version_and_hlc));
     }
@@ -430,7 +664,7 @@ bool VolatileCascadeStore<KT, VT, IK, IV>::internal_ordered_put(const VT& value,
 
     // validator
     if constexpr(std::is_base_of<IValidator<KT, VT>, VT>::value) {
-        if(!value.validate(this->kv_map)) {
+        if(!value.validate_stored(this->kv_map)) {
             return false;
         }
     }
@@ -439,7 +673,7 @@ bool VolatileCascadeStore<KT, VT, IK, IV>::internal_ordered_put(const VT& value,
     if constexpr(std::is_base_of<IVerifyPreviousVersion, VT>::value) {
         bool verify_result;
         if(this->kv_map.find(value.get_key_ref()) != this->kv_map.end()) {
-            verify_result = value.verify_previous_version(this->update_version, this->kv_map.at(value.get_key_ref()).get_version());
+            verify_result = value.verify_previous_version(this->update_version, key_value_map_at(this->kv_map, value.get_key_ref()).get_version());
         } else {
             verify_result = value.verify_previous_version(this->update_version, persistent::INVALID_VERSION);
         }
@@ -450,36 +684,15 @@ bool VolatileCascadeStore<KT, VT, IK, IV>::internal_ordered_put(const VT& value,
     }
     if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
         if(this->kv_map.find(value.get_key_ref()) != this->kv_map.end()) {
-            value.set_previous_version(this->update_version, this->kv_map.at(value.get_key_ref()).get_version());
+            value.set_previous_version(this->update_version, key_value_map_at(this->kv_map, value.get_key_ref()).get_version());
         } else {
             value.set_previous_version(this->update_version, persistent::INVALID_VERSION);
         }
     }
 
-    if (!as_trigger) {
-    // for lockless check
-    this->lockless_v1.store(std::get<0>(version_and_hlc), std::memory_order_relaxed);
-    // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                         : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-
-        this->kv_map.erase(value.get_key_ref());           // remove
-        this->kv_map.emplace(value.get_key_ref(), value);  // copy constructor
+    if(!as_trigger) {
+        this->update_kv_map(value.get_key_ref(), value);
         this->update_version = std::get<0>(version_and_hlc);
-
-        // for lockless check
-        // compiler reordering barrier
-#ifdef __GNUC__
-        asm volatile("" ::
-                         : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-        this->lockless_v2.store(std::get<0>(version_and_hlc), std::memory_order_relaxed);
     }
 
     if(cascade_watcher_ptr) {
@@ -495,68 +708,437 @@ bool VolatileCascadeStore<KT, VT, IK, IV>::internal_ordered_put(const VT& value,
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
-version_tuple VolatileCascadeStore<KT, VT, IK, IV>::ordered_remove(const KT& key) {
-    debug_enter_func_with_args("key={}", key);
-
-    auto version_and_hlc = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_current_version();
+void VolatileCascadeStore<KT, VT, IK, IV>::update_kv_map(const KT& key, const VT& value) {
+    if(this->transfer_in_progress.load()) {
+        this->incoming_transfer->touched.insert(key);
+    }
+    auto old_node = key_value_map_extract(this->kv_map, key);
+    // reuse the stored key of the old object, so that an update does not intern the key again.
+    auto it = old_node.empty() ? this->kv_map.emplace(key, value).first
+                               : this->kv_map.emplace(old_node.key(), value).first;  // copy constructor
+    if constexpr(std::is_base_of<ISharePayload, VT>::value) {
+        it->second.share_payload();
+    }
+    this->kv_index.publish(*it);
+    this->schedule_expiration(key, it->second);
+    auto pool_cache_it = this->find_pool_cache(key);
+    if(pool_cache_it != this->pool_caches.end()) {
+        if(!old_node.empty()) {
+            pool_cache_it->second.used_bytes -= mutils::bytes_size(old_node.mapped());
+        }
+        pool_cache_it->second.used_bytes += mutils::bytes_size(it->second);
+        set_referenced(it->first, true);
+    }
+    if(!old_node.empty()) {
+        // lockless readers may still be copying the old object.
+        this->kv_index.retire(std::move(old_node));
+    }
+    this->kv_index.reclaim();
+    if(pool_cache_it != this->pool_caches.end()) {
+        this->evict_from_pool(pool_cache_it);
+    }
+}
 
-#if __cplusplus > 201703L
-    LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_ORDERED_REMOVE_START,group,*IV,std::get<0>(version_and_hlc));
-#else
-    LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_VOLATILE_ORDERED_REMOVE_START,group,*IV,std::get<0>(version_and_hlc));
-#endif
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::erase_from_kv_map(const KT& key) {
+    if(this->transfer_in_progress.load()) {
+        this->incoming_transfer->touched.insert(key);
+    }
+    auto old_node = key_value_map_extract(this->kv_map, key);
+    if(old_node.empty()) {
+        return;
+    }
+    auto pool_cache_it = this->find_pool_cache(key);
+    if(pool_cache_it != this->pool_caches.end()) {
+        pool_cache_it->second.used_bytes -= mutils::bytes_size(old_node.mapped());
+    }
+    this->kv_index.erase(key);
+    this->kv_index.retire(std::move(old_node));
+    this->kv_index.reclaim();
+}
 
-    if(this->kv_map.find(key) == this->kv_map.end()) {
-        debug_leave_func_with_value("version=0x{:x},timestamp={}us",
-                std::get<0>(version_and_hlc), 
-                std::get<1>(version_and_hlc).m_rtc_us);
-        return {std::get<0>(version_and_hlc),
-                std::get<1>(version_and_hlc).m_rtc_us};
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::rebuild_kv_index() {
+    this->kv_index.clear();
+    this->tombstones.clear();
+    for(auto& kv : this->kv_map) {
+        if constexpr(std::is_base_of<ISharePayload, VT>::value) {
+            kv.second.share_payload();
+        }
+        this->kv_index.publish(kv);
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            if(kv.second.is_null()) {
+                this->tombstones.emplace_back(kv.second.get_version(), kv.first);
+            }
+        }
     }
+    // a joining member purges exactly the tombstones the existing members purge, in the same order.
+    std::sort(this->tombstones.begin(), this->tombstones.end(),
+              [](const auto& l, const auto& r) { return l.first < r.first; });
+}
 
-    auto value = create_null_object_cb<KT, VT, IK, IV>(key);
+template <typename KT, typename VT, KT* IK, VT* IV>
+uint64_t VolatileCascadeStore<KT, VT, IK, IV>::tombstone_age(persistent::version_t removal_version,
+                                                             persistent::version_t current_version) {
+    const uint64_t removal_view = static_cast<uint64_t>(removal_version) >> 32;
+    const uint64_t current_view = static_cast<uint64_t>(current_version) >> 32;
+    const uint64_t removal_seq = static_cast<uint64_t>(removal_version) & 0xffffffffull;
+    const uint64_t current_seq = static_cast<uint64_t>(current_version) & 0xffffffffull;
+    if(current_view == removal_view) {
+        return (current_seq > removal_seq) ? (current_seq - removal_seq) : 0;
+    } else if(current_view > removal_view) {
+        return current_seq + 1;
+    }
+    return 0;
+}
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::collect_tombstones(persistent::version_t current_version) {
+    // without the version of a tombstone, we cannot decide when it is safe to purge it.
     if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
-        value.set_version(std::get<0>(version_and_hlc));
+        if(this->tombstone_gc_batch == 0 || current_version == persistent::INVALID_VERSION) {
+            return;
+        }
+        uint32_t num_purged = 0;
+        while(!this->tombstones.empty() && num_purged < this->tombstone_gc_batch) {
+            const auto& removal_version = this->tombstones.front().first;
+            const auto& key = this->tombstones.front().second;
+            if(tombstone_age(removal_version, current_version) < this->tombstone_gc_delay) {
+                break;
+            }
+            auto it = this->kv_map.find(key);
+            // skip the stale entries for keys updated after the removal.
+            if(it != this->kv_map.end() && it->second.is_null() && it->second.get_version() == removal_version) {
+                dbg_default_trace("{}: purge tombstone of key:{} removed at version:0x{:x}", __PRETTY_FUNCTION__, key, removal_version);
+                this->erase_from_kv_map(key);
+                num_purged++;
+            }
+            this->tombstones.pop_front();
+        }
     }
-    if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
-        value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+typename VolatileCascadeStore<KT, VT, IK, IV>::pool_cache_map_t::iterator
+VolatileCascadeStore<KT, VT, IK, IV>::find_pool_cache(const KT& key) {
+    if constexpr(std::is_convertible_v<KT, std::string>) {
+        if(this->pool_caches.empty()) {
+            return this->pool_caches.end();
+        }
+        // object pools do not nest, so the first pool found along the pathname is the one.
+        const std::string pathname = get_pathname<KT>(key);
+        std::size_t pos = 0;
+        while((pos = pathname.find(PATH_SEPARATOR, pos + 1)) != std::string::npos) {
+            auto it = this->pool_caches.find(pathname.substr(0, pos));
+            if(it != this->pool_caches.end()) {
+                return it;
+            }
+        }
+        return this->pool_caches.find(pathname);
+    } else {
+        return this->pool_caches.end();
     }
-    if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
-        if(this->kv_map.find(key) != this->kv_map.end()) {
-            value.set_previous_version(this->update_version, this->kv_map.at(key).get_version());
-        } else {
-            value.set_previous_version(this->update_version, persistent::INVALID_VERSION);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+uint64_t VolatileCascadeStore<KT, VT, IK, IV>::compute_pool_bytes(const std::string& pathname) const {
+    uint64_t bytes = 0;
+    if constexpr(std::is_convertible_v<KT, std::string>) {
+        const std::string range_begin = pathname + PATH_SEPARATOR;
+        for(auto it = this->kv_map.lower_bound(range_begin);
+            it != this->kv_map.end() && key_starts_with(it->first, range_begin);
+            it++) {
+            bytes += mutils::bytes_size(it->second);
         }
     }
+    return bytes;
+}
 
-    // for lockless check
-    this->lockless_v1.store(std::get<0>(version_and_hlc), std::memory_order_relaxed);
-    // compiler reordering barrier
-#ifdef __GNUC__
-    asm volatile("" ::
-                         : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::evict_from_pool(typename pool_cache_map_t::iterator pool_cache_it) {
+    if constexpr(std::is_convertible_v<KT, std::string>) {
+        auto& pool_cache = pool_cache_it->second;
+        if(pool_cache.budget == 0) {
+            return;
+        }
+        // the keys of the pool are contiguous in kv_map, starting from "<pathname>/".
+        const std::string range_begin = pool_cache_it->first + PATH_SEPARATOR;
+        auto in_pool = [&range_begin](const auto& key) {
+            return key_starts_with(key, range_begin);
+        };
+        while(pool_cache.used_bytes > pool_cache.budget) {
+            auto kv_it = in_pool(pool_cache.hand) ? this->kv_map.upper_bound(pool_cache.hand)
+                                                  : this->kv_map.lower_bound(range_begin);
+            if(kv_it == this->kv_map.end() || !in_pool(kv_it->first)) {
+                // the hand wraps around.
+                kv_it = this->kv_map.lower_bound(range_begin);
+                if(kv_it == this->kv_map.end() || !in_pool(kv_it->first)) {
+                    dbg_default_error("{}: object pool {} is empty but uses {} bytes.", __PRETTY_FUNCTION__,
+                                      pool_cache_it->first, pool_cache.used_bytes);
+                    pool_cache.used_bytes = 0;
+                    break;
+                }
+            }
+            pool_cache.hand = kv_it->first;
+            if(is_referenced(kv_it->first)) {
+                // second chance
+                set_referenced(kv_it->first, false);
+                continue;
+            }
+            const KT victim = kv_it->first;
+            dbg_default_trace("{}: evict key:{} from object pool {}", __PRETTY_FUNCTION__, victim, pool_cache_it->first);
+            this->erase_from_kv_map(victim);
+            pool_cache.evictions++;
+        }
+    }
+}
 
-    this->kv_map.erase(key);  // remove
-    this->kv_map.emplace(key, value);
-    this->update_version = std::get<0>(version_and_hlc);
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::rebuild_pool_caches() {
+    for(auto& pool_cache : this->pool_caches) {
+        pool_cache.second.used_bytes = this->compute_pool_bytes(pool_cache.first);
+    }
+    this->cache_enabled.store(!this->pool_caches.empty(), std::memory_order_relaxed);
+}
 
-    // for lockless check
-    // compiler reordering barrier
-#ifdef __GNUC__
-    asm volatile("" ::
-                         : "memory");
-#else
-#error Lockless support is currently for GCC only
-#endif
-    this->lockless_v2.store(std::get<0>(version_and_hlc), std::memory_order_relaxed);
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool VolatileCascadeStore<KT, VT, IK, IV>::is_referenced(const stored_key_t<KT>& key) {
+    if constexpr(std::is_same_v<stored_key_t<KT>, InternedPathname>) {
+        return key.is_marked();
+    } else {
+        return false;
+    }
+}
 
-    if(cascade_watcher_ptr) {
-        (*cascade_watcher_ptr)(
-                // group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_subgroup_id(), // this is subgroup id
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::set_referenced(const stored_key_t<KT>& key, bool referenced) {
+    if constexpr(std::is_same_v<stored_key_t<KT>, InternedPathname>) {
+        key.set_mark(referenced);
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::vector<KT> VolatileCascadeStore<KT, VT, IK, IV>::get_referenced_keys() const {
+    std::vector<KT> keys;
+    if constexpr(std::is_same_v<stored_key_t<KT>, InternedPathname>) {
+        // only the keys of the object pools with a memory budget are referenced.
+        if(!this->pool_caches.empty()) {
+            for(const auto& kv : this->kv_map) {
+                if(kv.first.is_marked()) {
+                    keys.emplace_back(kv.first);
+                }
+            }
+        }
+    }
+    return keys;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+uint64_t VolatileCascadeStore<KT, VT, IK, IV>::find_ttl_us(const KT& key, const std::map<std::string, uint64_t>& ttls) {
+    if constexpr(std::is_convertible_v<KT, std::string>) {
+        if(ttls.empty()) {
+            return 0;
+        }
+        // object pools do not nest, so the first pool found along the pathname is the one.
+        const std::string pathname = get_pathname<KT>(key);
+        std::size_t pos = 0;
+        while((pos = pathname.find(PATH_SEPARATOR, pos + 1)) != std::string::npos) {
+            auto it = ttls.find(pathname.substr(0, pos));
+            if(it != ttls.end()) {
+                return it->second * 1000;
+            }
+        }
+        auto it = ttls.find(pathname);
+        if(it != ttls.end()) {
+            return it->second * 1000;
+        }
+    }
+    return 0;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+uint64_t VolatileCascadeStore<KT, VT, IK, IV>::get_expiration_us(const VT& value, const std::map<std::string, uint64_t>& ttls) {
+    if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+        if(value.is_null()) {
+            return 0;
+        }
+        const uint64_t ttl_us = find_ttl_us(value.get_key_ref(), ttls);
+        if(ttl_us > 0) {
+            return value.get_timestamp() + ttl_us;
+        }
+    }
+    return 0;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool VolatileCascadeStore<KT, VT, IK, IV>::is_expired(const VT& value) const {
+    const auto ttls = std::atomic_load(&this->pool_ttls);
+    if(ttls->empty()) {
+        return false;
+    }
+    const uint64_t expiration_us = get_expiration_us(value, *ttls);
+    return expiration_us != 0 && expiration_us <= get_time_us();
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::schedule_expiration(const KT& key, const VT& value) {
+    if(this->pool_ttls->empty()) {
+        return;
+    }
+    const uint64_t expiration_us = get_expiration_us(value, *this->pool_ttls);
+    if(expiration_us == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lck(this->expiration_mutex);
+    this->expiration_wheel.schedule({key, expiration_us}, (expiration_us + this->ttl_tick_us - 1) / this->ttl_tick_us);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::rebuild_expiration_wheel() {
+    {
+        std::lock_guard<std::mutex> lck(this->expiration_mutex);
+        this->expiration_wheel.reset(get_time_us() / this->ttl_tick_us);
+    }
+    if(this->pool_ttls->empty()) {
+        return;
+    }
+    for(const auto& kv : this->kv_map) {
+        this->schedule_expiration(kv.first, kv.second);
+    }
+    this->start_expiration_worker();
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::start_expiration_worker() {
+    if(!this->expiration_thread.joinable()) {
+        this->expiration_thread = std::thread(&VolatileCascadeStore::expiration_worker, this);
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::expiration_worker() {
+    pthread_setname_np(pthread_self(), "cs_vcss_ttl");
+    dbg_default_trace("{}: expiration worker started.", __PRETTY_FUNCTION__);
+    // a member keeps an expired key this many ticks before checking if it is removed.
+    constexpr uint64_t retry_ticks = 10;
+    std::unique_lock<std::mutex> lck(this->expiration_mutex);
+    while(!this->expiration_stopping) {
+        this->expiration_cv.wait_for(lck, std::chrono::microseconds(this->ttl_tick_us), [this]() { return this->expiration_stopping; });
+        if(this->expiration_stopping) {
+            break;
+        }
+        const uint64_t now_us = get_time_us();
+        std::vector<std::pair<KT, uint64_t>> due;
+        this->expiration_wheel.advance(now_us / this->ttl_tick_us, due);
+        if(due.empty()) {
+            continue;
+        }
+        lck.unlock();
+
+        std::vector<KT> expired;
+        std::vector<std::pair<KT, uint64_t>> pending;
+        {
+            const auto ttls = std::atomic_load(&this->pool_ttls);
+            EpochGuard epoch_guard;
+            for(auto& entry : due) {
+                const VT* value_ptr = this->kv_index.find(entry.first);
+                // a key not streamed to this member yet is scheduled when it is installed.
+                if(value_ptr == nullptr) {
+                    continue;
+                }
+                const uint64_t expiration_us = get_expiration_us(*value_ptr, *ttls);
+                if(expiration_us == 0) {
+                    continue;
+                }
+                if(expiration_us > now_us) {
+                    // an update scheduled the key again, unless this entry is just early by the tick.
+                    if(expiration_us == entry.second) {
+                        pending.emplace_back(std::move(entry));
+                    }
+                    continue;
+                }
+                expired.push_back(entry.first);
+                pending.emplace_back(entry.first, now_us + retry_ticks * this->ttl_tick_us);
+            }
+        }
+
+        if(!expired.empty() && group != nullptr) {
+            try {
+                auto& subgroup_handle = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index);
+                auto shard_members = group->template get_subgroup_members<VolatileCascadeStore>(this->subgroup_index).at(subgroup_handle.get_shard_num());
+                if(!shard_members.empty() && shard_members.front() == group->get_my_id()) {
+                    const std::size_t batch_size = (this->ttl_batch == 0) ? expired.size() : this->ttl_batch;
+                    for(std::size_t begin = 0; begin < expired.size(); begin += batch_size) {
+                        std::vector<KT> batch(expired.begin() + begin,
+                                              expired.begin() + std::min(expired.size(), begin + batch_size));
+                        auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_expire)>(batch);
+                        for(auto& reply_pair : results.get()) {
+                            reply_pair.second.get();
+                        }
+                    }
+                }
+            } catch(const std::exception& ex) {
+                dbg_default_warn("{}: failed to expire {} keys: {}", __PRETTY_FUNCTION__, expired.size(), ex.what());
+            }
+        }
+
+        lck.lock();
+        for(const auto& entry : pending) {
+            this->expiration_wheel.schedule(entry, (entry.second + this->ttl_tick_us - 1) / this->ttl_tick_us);
+        }
+    }
+    dbg_default_trace("{}: expiration worker finished.", __PRETTY_FUNCTION__);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCascadeStore<KT, VT, IK, IV>::ordered_remove(const KT& key) {
+    debug_enter_func_with_args("key={}", key);
+
+    auto version_and_hlc = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_current_version();
+
+#if __cplusplus > 201703L
+    LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_ORDERED_REMOVE_START,group,*IV,std::get<0>(version_and_hlc));
+#else
+    LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_VOLATILE_ORDERED_REMOVE_START,group,*IV,std::get<0>(version_and_hlc));
+#endif
+
+    auto transfer_lck = this->lock_for_transfer();
+    this->wait_for_key(key, transfer_lck);
+    this->collect_tombstones(std::get<0>(version_and_hlc));
+
+    if(this->kv_map.find(key) == this->kv_map.end()) {
+        debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+                std::get<0>(version_and_hlc), 
+                std::get<1>(version_and_hlc).m_rtc_us);
+        return {std::get<0>(version_and_hlc),
+                std::get<1>(version_and_hlc).m_rtc_us};
+    }
+
+    auto value = create_null_object_cb<KT, VT, IK, IV>(key);
+
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        value.set_version(std::get<0>(version_and_hlc));
+    }
+    if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+        value.set_timestamp(std::get<1>(version_and_hlc).m_rtc_us);
+    }
+    if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+        if(this->kv_map.find(key) != this->kv_map.end()) {
+            value.set_previous_version(this->update_version, key_value_map_at(this->kv_map, key).get_version());
+        } else {
+            value.set_previous_version(this->update_version, persistent::INVALID_VERSION);
+        }
+    }
+
+    this->update_kv_map(key, value);
+    this->update_version = std::get<0>(version_and_hlc);
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        this->tombstones.emplace_back(std::get<0>(version_and_hlc), key);
+    }
+
+    if(cascade_watcher_ptr) {
+        (*cascade_watcher_ptr)(
+                // group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_subgroup_id(), // this is subgroup id
                 this->subgroup_index,
                 group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_shard_num(),
                 group->get_rpc_caller_id(),
@@ -590,14 +1172,21 @@ const VT VolatileCascadeStore<KT, VT, IK, IV>::ordered_get(const KT& key) {
     LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_VOLATILE_ORDERED_GET_START,group,*IV,std::get<0>(version_and_hlc));
 #endif
 
-    if(this->kv_map.find(key) != this->kv_map.end()) {
+    auto transfer_lck = this->lock_for_transfer();
+    this->wait_for_key(key, transfer_lck);
+    auto kv_it = this->kv_map.find(key);
+    if(kv_it != this->kv_map.end()) {
+        auto pool_cache_it = this->find_pool_cache(key);
+        if(pool_cache_it != this->pool_caches.end()) {
+            set_referenced(kv_it->first, true);
+        }
         debug_leave_func_with_value("key={}", key);
 #if __cplusplus > 201703L
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_ORDERED_GET_END,group,*IV,std::get<0>(version_and_hlc));
 #else
     LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_VOLATILE_ORDERED_GET_END,group,*IV,std::get<0>(version_and_hlc));
 #endif
-        return this->kv_map.at(key);
+        return key_value_map_at(this->kv_map, key);
     } else {
 #if __cplusplus > 201703L
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_ORDERED_GET_END,group,*IV,std::get<0>(version_and_hlc));
@@ -623,13 +1212,15 @@ uint64_t VolatileCascadeStore<KT, VT, IK, IV>::ordered_get_size(const KT& key) {
     LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_VOLATILE_ORDERED_GET_SIZE_START,group,*IV,std::get<0>(version_and_hlc));
 #endif
 
+    auto transfer_lck = this->lock_for_transfer();
+    this->wait_for_key(key, transfer_lck);
     if(this->kv_map.find(key) != this->kv_map.end()) {
 #if __cplusplus > 201703L
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_ORDERED_GET_SIZE_END,group,*IV,std::get<0>(version_and_hlc));
 #else
     LOG_TIMESTAMP_BY_TAG_EXTRA(TLT_VOLATILE_ORDERED_GET_SIZE_END,group,*IV,std::get<0>(version_and_hlc));
 #endif
-        return mutils::bytes_size(this->kv_map.at(key));
+        return mutils::bytes_size(key_value_map_at(this->kv_map, key));
     } else {
 #if __cplusplus > 201703L
     LOG_TIMESTAMP_BY_TAG(TLT_VOLATILE_ORDERED_GET_SIZE_END,group,*IV,std::get<0>(version_and_hlc));
@@ -641,6 +1232,218 @@ uint64_t VolatileCascadeStore<KT, VT, IK, IV>::ordered_get_size(const KT& key) {
     }
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCascadeStore<KT, VT, IK, IV>::set_memory_budget(const std::string& pathname, const uint64_t& budget) const {
+    debug_enter_func_with_args("pathname={},budget={}", pathname, budget);
+    derecho::Replicated<VolatileCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_set_memory_budget)>(pathname, budget);
+    auto& replies = results.get();
+    version_tuple ret(CURRENT_VERSION, 0);
+    // TODO: verify consistency ?
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCascadeStore<KT, VT, IK, IV>::ordered_set_memory_budget(const std::string& pathname, const uint64_t& budget) {
+    debug_enter_func_with_args("pathname={},budget={}", pathname, budget);
+    auto version_and_hlc = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_current_version();
+
+    // the memory usage of a pool counts all of its keys.
+    auto transfer_lck = this->lock_for_transfer();
+    this->wait_for_transfer(transfer_lck);
+    if constexpr(!std::is_convertible_v<KT, std::string>) {
+        dbg_default_warn("{}: memory budget is only supported for string keys.", __PRETTY_FUNCTION__);
+    } else if(pathname.empty() || pathname.front() != PATH_SEPARATOR || pathname.back() == PATH_SEPARATOR) {
+        dbg_default_warn("{}: invalid object pool pathname:{}", __PRETTY_FUNCTION__, pathname);
+    } else {
+        if(budget == 0) {
+            if(this->pool_caches.erase(pathname) > 0) {
+                // a key is only referenced while its object pool has a budget.
+                const std::string range_begin = pathname + PATH_SEPARATOR;
+                for(auto it = this->kv_map.lower_bound(range_begin);
+                    it != this->kv_map.end() && key_starts_with(it->first, range_begin);
+                    it++) {
+                    set_referenced(it->first, false);
+                }
+            }
+        } else {
+            auto pool_cache_it = this->pool_caches.find(pathname);
+            if(pool_cache_it == this->pool_caches.end()) {
+                pool_cache_it = this->pool_caches.emplace(pathname, VolatilePoolCache<KT>(budget)).first;
+                pool_cache_it->second.used_bytes = this->compute_pool_bytes(pathname);
+            } else {
+                pool_cache_it->second.budget = budget;
+            }
+            // a smaller budget evicts right away.
+            this->evict_from_pool(pool_cache_it);
+        }
+        this->cache_enabled.store(!this->pool_caches.empty(), std::memory_order_relaxed);
+        this->update_version = std::get<0>(version_and_hlc);
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us);
+    return {std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::map<std::string, uint64_t> VolatileCascadeStore<KT, VT, IK, IV>::get_cache_stats(const std::string& pathname) const {
+    debug_enter_func_with_args("pathname={}", pathname);
+    derecho::Replicated<VolatileCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_get_cache_stats)>(pathname);
+    auto& replies = results.get();
+    std::map<std::string, uint64_t> stats;
+    // the pool state is identical on all members, but each member counts the hits and misses of its own readers.
+    for(auto& reply_pair : replies) {
+        auto member_stats = reply_pair.second.get();
+        if(stats.empty()) {
+            stats = std::move(member_stats);
+        } else if(!member_stats.empty()) {
+            stats["hits"] += member_stats["hits"];
+            stats["misses"] += member_stats["misses"];
+        }
+    }
+    debug_leave_func();
+    return stats;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::map<std::string, uint64_t> VolatileCascadeStore<KT, VT, IK, IV>::ordered_get_cache_stats(const std::string& pathname) {
+    debug_enter_func_with_args("pathname={}", pathname);
+    std::map<std::string, uint64_t> stats;
+    auto pool_cache_it = this->pool_caches.find(pathname);
+    if(pool_cache_it != this->pool_caches.end()) {
+        stats.emplace("budget", pool_cache_it->second.budget);
+        stats.emplace("used_bytes", pool_cache_it->second.used_bytes);
+        stats.emplace("evictions", pool_cache_it->second.evictions);
+        stats.emplace("hits", this->cache_hits.load(std::memory_order_relaxed));
+        stats.emplace("misses", this->cache_misses.load(std::memory_order_relaxed));
+    }
+    debug_leave_func();
+    return stats;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCascadeStore<KT, VT, IK, IV>::set_ttl(const std::string& pathname, const uint64_t& ttl_ms) const {
+    debug_enter_func_with_args("pathname={},ttl_ms={}", pathname, ttl_ms);
+    derecho::Replicated<VolatileCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index);
+    auto results = subgroup_handle.template ordered_send<RPC_NAME(ordered_set_ttl)>(pathname, ttl_ms);
+    auto& replies = results.get();
+    version_tuple ret(CURRENT_VERSION, 0);
+    for(auto& reply_pair : replies) {
+        ret = reply_pair.second.get();
+    }
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us", std::get<0>(ret), std::get<1>(ret));
+    return ret;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCascadeStore<KT, VT, IK, IV>::ordered_set_ttl(const std::string& pathname, const uint64_t& ttl_ms) {
+    debug_enter_func_with_args("pathname={},ttl_ms={}", pathname, ttl_ms);
+    auto version_and_hlc = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_current_version();
+
+    // the objects already in the pool expire by the new TTL.
+    auto transfer_lck = this->lock_for_transfer();
+    this->wait_for_transfer(transfer_lck);
+    if constexpr(!std::is_convertible_v<KT, std::string> || !std::is_base_of<IKeepTimestamp, VT>::value) {
+        dbg_default_warn("{}: TTL is only supported for string keys and objects with a timestamp.", __PRETTY_FUNCTION__);
+    } else if(pathname.empty() || pathname.front() != PATH_SEPARATOR || pathname.back() == PATH_SEPARATOR) {
+        dbg_default_warn("{}: invalid object pool pathname:{}", __PRETTY_FUNCTION__, pathname);
+    } else {
+        auto ttls = std::make_shared<std::map<std::string, uint64_t>>(*this->pool_ttls);
+        if(ttl_ms == 0) {
+            ttls->erase(pathname);
+        } else {
+            (*ttls)[pathname] = ttl_ms;
+        }
+        std::atomic_store(&this->pool_ttls, std::shared_ptr<const std::map<std::string, uint64_t>>(std::move(ttls)));
+        if(ttl_ms > 0) {
+            const std::string range_begin = pathname + PATH_SEPARATOR;
+            for(auto it = this->kv_map.lower_bound(range_begin);
+                it != this->kv_map.end() && key_starts_with(it->first, range_begin);
+                it++) {
+                this->schedule_expiration(it->first, it->second);
+            }
+            this->start_expiration_worker();
+        }
+        this->update_version = std::get<0>(version_and_hlc);
+    }
+
+    debug_leave_func_with_value("version=0x{:x},timestamp={}us",
+            std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us);
+    return {std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us};
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+version_tuple VolatileCascadeStore<KT, VT, IK, IV>::ordered_expire(const std::vector<KT>& keys) {
+    debug_enter_func_with_args("num_keys={}", keys.size());
+    auto version_and_hlc = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_current_version();
+
+    auto transfer_lck = this->lock_for_transfer();
+    for(const auto& key : keys) {
+        this->wait_for_key(key, transfer_lck);
+    }
+    this->collect_tombstones(std::get<0>(version_and_hlc));
+
+    // the timestamp of this operation is the same on all members, so they remove the same keys.
+    const uint64_t now_us = std::get<1>(version_and_hlc).m_rtc_us;
+    const auto ttls = this->pool_ttls;
+    uint32_t num_expired = 0;
+    for(const auto& key : keys) {
+        auto it = this->kv_map.find(key);
+        if(it == this->kv_map.end()) {
+            continue;
+        }
+        const uint64_t expiration_us = get_expiration_us(it->second, *ttls);
+        if(expiration_us == 0 || expiration_us > now_us) {
+            continue;
+        }
+
+        auto value = create_null_object_cb<KT, VT, IK, IV>(key);
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            value.set_version(std::get<0>(version_and_hlc));
+        }
+        if constexpr(std::is_base_of<IKeepTimestamp, VT>::value) {
+            value.set_timestamp(now_us);
+        }
+        if constexpr(std::is_base_of<IKeepPreviousVersion, VT>::value) {
+            value.set_previous_version(this->update_version, it->second.get_version());
+        }
+
+        this->update_kv_map(key, value);
+        if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+            this->tombstones.emplace_back(std::get<0>(version_and_hlc), key);
+        }
+        num_expired++;
+
+        if(cascade_watcher_ptr) {
+            (*cascade_watcher_ptr)(
+                    this->subgroup_index,
+                    group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_shard_num(),
+                    group->get_rpc_caller_id(),
+                    key, value, cascade_context_ptr);
+        }
+    }
+    if(num_expired > 0) {
+        this->update_version = std::get<0>(version_and_hlc);
+    }
+
+    debug_leave_func_with_value("expired {} keys,version=0x{:x},timestamp={}us",
+            num_expired,
+            std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us);
+    return {std::get<0>(version_and_hlc),
+            std::get<1>(version_and_hlc).m_rtc_us};
+}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 void VolatileCascadeStore<KT, VT, IK, IV>::trigger_put(const VT& value) const {
     debug_enter_func_with_args("key={}", value.get_key_ref());
@@ -693,55 +1496,678 @@ template <typename KT, typename VT, KT* IK, VT* IV>
 std::unique_ptr<VolatileCascadeStore<KT, VT, IK, IV>> VolatileCascadeStore<KT, VT, IK, IV>::from_bytes(
         mutils::DeserializationManager* dsm,
         uint8_t const* buf) {
-    auto kv_map_ptr = mutils::from_bytes<std::map<KT, VT>>(dsm, buf);
-    auto update_version_ptr = mutils::from_bytes<persistent::version_t>(dsm, buf + mutils::bytes_size(*kv_map_ptr));
-    auto volatile_cascade_store_ptr = std::make_unique<VolatileCascadeStore>(std::move(*kv_map_ptr),
+    auto transfer_id_ptr = mutils::from_bytes<uint64_t>(dsm, buf);
+    std::size_t offset = mutils::bytes_size(*transfer_id_ptr);
+    // kv_map is sent as a std::map<KT, VT>.
+    std::map<KT, VT> kv_map;
+    if(*transfer_id_ptr == 0) {
+        auto kv_map_ptr = mutils::from_bytes<std::map<KT, VT>>(dsm, buf + offset);
+        offset += mutils::bytes_size(*kv_map_ptr);
+        kv_map = std::move(*kv_map_ptr);
+    }
+    auto update_version_ptr = mutils::from_bytes<persistent::version_t>(dsm, buf + offset);
+    offset += mutils::bytes_size(*update_version_ptr);
+    auto pool_caches_ptr = mutils::from_bytes<pool_cache_map_t>(dsm, buf + offset);
+    offset += mutils::bytes_size(*pool_caches_ptr);
+    auto referenced_keys_ptr = mutils::from_bytes<std::vector<KT>>(dsm, buf + offset);
+    offset += mutils::bytes_size(*referenced_keys_ptr);
+    auto pool_ttls_ptr = mutils::from_bytes<std::map<std::string, uint64_t>>(dsm, buf + offset);
+    offset += mutils::bytes_size(*pool_ttls_ptr);
+    auto volatile_cascade_store_ptr = std::make_unique<VolatileCascadeStore>(std::move(kv_map),
                                                                              *update_version_ptr,
                                                                              dsm->registered<CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>>() ? &(dsm->mgr<CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>>()) : nullptr,
                                                                              dsm->registered<ICascadeContext>() ? &(dsm->mgr<ICascadeContext>()) : nullptr);
+    volatile_cascade_store_ptr->pool_caches = std::move(*pool_caches_ptr);
+    volatile_cascade_store_ptr->rebuild_pool_caches();
+    // the whole kv_map is sent when there are object pools with a memory budget.
+    for(const auto& key : *referenced_keys_ptr) {
+        auto kv_it = volatile_cascade_store_ptr->kv_map.find(key);
+        if(kv_it != volatile_cascade_store_ptr->kv_map.end()) {
+            set_referenced(kv_it->first, true);
+        }
+    }
+    volatile_cascade_store_ptr->pool_ttls = std::make_shared<const std::map<std::string, uint64_t>>(std::move(*pool_ttls_ptr));
+    volatile_cascade_store_ptr->rebuild_expiration_wheel();
+    if(*transfer_id_ptr != 0) {
+        auto donor_ptr = mutils::from_bytes<node_id_t>(dsm, buf + offset);
+        offset += mutils::bytes_size(*donor_ptr);
+        auto num_keys_ptr = mutils::from_bytes<uint64_t>(dsm, buf + offset);
+        auto& transfer = volatile_cascade_store_ptr->incoming_transfer;
+        transfer = std::make_unique<IncomingTransfer>();
+        transfer->donor = *donor_ptr;
+        transfer->id = *transfer_id_ptr;
+        transfer->num_keys = *num_keys_ptr;
+        transfer->source = *donor_ptr;
+        transfer->source_id = *transfer_id_ptr;
+        volatile_cascade_store_ptr->transfer_in_progress.store(true);
+        transfer->worker = std::thread(&VolatileCascadeStore::stream_state, volatile_cascade_store_ptr.get());
+    }
     return volatile_cascade_store_ptr;
 }
 
 template <typename KT, typename VT, KT* IK, VT* IV>
-VolatileCascadeStore<KT, VT, IK, IV>::VolatileCascadeStore(
-        CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>* cw,
-        ICascadeContext* cc) : lockless_v1(persistent::INVALID_VERSION),
-                               lockless_v2(persistent::INVALID_VERSION),
-                               update_version(persistent::INVALID_VERSION),
-                               cascade_watcher_ptr(cw),
-                               cascade_context_ptr(cc) {
-    debug_enter_func();
+std::size_t VolatileCascadeStore<KT, VT, IK, IV>::to_bytes(uint8_t* buf) const {
+    const uint64_t transfer_id = this->prepare_outgoing_transfer();
+    std::size_t offset = mutils::to_bytes(transfer_id, buf);
+    if(transfer_id == 0) {
+        offset += key_value_map_to_bytes<KT, VT>(this->kv_map, buf + offset);
+    }
+    offset += mutils::to_bytes(this->update_version, buf + offset);
+    offset += mutils::to_bytes(this->pool_caches, buf + offset);
+    offset += mutils::to_bytes(this->get_referenced_keys(), buf + offset);
+    offset += mutils::to_bytes(*this->pool_ttls, buf + offset);
+    if(transfer_id != 0) {
+        offset += mutils::to_bytes(group->get_my_id(), buf + offset);
+        offset += mutils::to_bytes(static_cast<uint64_t>(this->kv_map.size()), buf + offset);
+    }
+    return offset;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::size_t VolatileCascadeStore<KT, VT, IK, IV>::bytes_size() const {
+    const uint64_t transfer_id = this->prepare_outgoing_transfer();
+    std::size_t size = mutils::bytes_size(transfer_id);
+    if(transfer_id == 0) {
+        size += key_value_map_bytes_size<KT, VT>(this->kv_map);
+    }
+    size += mutils::bytes_size(this->update_version);
+    size += mutils::bytes_size(this->pool_caches);
+    size += mutils::bytes_size(this->get_referenced_keys());
+    size += mutils::bytes_size(*this->pool_ttls);
+    if(transfer_id != 0) {
+        size += mutils::bytes_size(node_id_t{}) + mutils::bytes_size(uint64_t{});
+    }
+    return size;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::post_object(const std::function<void(uint8_t const* const, std::size_t)>& f) const {
+    const uint64_t transfer_id = this->prepare_outgoing_transfer();
+    mutils::post_object(f, transfer_id);
+    if(transfer_id == 0) {
+        key_value_map_post_object<KT, VT>(f, this->kv_map);
+    }
+    mutils::post_object(f, this->update_version);
+    mutils::post_object(f, this->pool_caches);
+    mutils::post_object(f, this->get_referenced_keys());
+    mutils::post_object(f, *this->pool_ttls);
+    if(transfer_id != 0) {
+        mutils::post_object(f, group->get_my_id());
+        mutils::post_object(f, static_cast<uint64_t>(this->kv_map.size()));
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+uint64_t VolatileCascadeStore<KT, VT, IK, IV>::prepare_outgoing_transfer() const {
+    if constexpr(!state_streamable) {
+        // a copy of kv_map would copy the payloads, and an object larger than a chunk could not be sent in pieces.
+        return 0;
+    } else {
+        // evictions depend on all keys of a pool, so a cache is sent as a whole.
+        if(this->state_transfer_chunk_bytes == 0 || !this->pool_caches.empty() || group == nullptr
+           || key_value_map_bytes_size<KT, VT>(this->kv_map) <= this->state_transfer_chunk_bytes) {
+            return 0;
+        }
+        std::lock_guard<std::mutex> lck(this->outgoing_transfers_mutex);
+        const auto now = std::chrono::steady_clock::now();
+        for(auto it = this->outgoing_transfers.begin(); it != this->outgoing_transfers.end();) {
+            if(now - it->second.last_access > OUTGOING_TRANSFER_IDLE_TIMEOUT) {
+                dbg_default_warn("{}: drop state transfer {}, which is idle.", __PRETTY_FUNCTION__, it->first);
+                it = this->outgoing_transfers.erase(it);
+            } else {
+                it++;
+            }
+        }
+        // the members joining in the same view change, and the calls to size and serialize the state, share the copy.
+        if(!this->outgoing_transfers.empty() && this->outgoing_transfers.rbegin()->second.version == this->update_version) {
+            this->outgoing_transfers.rbegin()->second.last_access = now;
+            return this->outgoing_transfers.rbegin()->first;
+        }
+        const uint64_t transfer_id = this->next_transfer_id++;
+        // the copy pins the payloads of kv_map, which are shared, instead of copying them.
+        this->outgoing_transfers.emplace(transfer_id, OutgoingTransfer{std::make_shared<const key_value_map_t<KT, VT>>(this->kv_map),
+                                                                       this->update_version, now});
+        dbg_default_info("{}: start state transfer {} of {} keys at version:0x{:x}.", __PRETTY_FUNCTION__,
+                         transfer_id, this->kv_map.size(), this->update_version);
+        return transfer_id;
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+typename VolatileCascadeStore<KT, VT, IK, IV>::OutgoingTransfer VolatileCascadeStore<KT, VT, IK, IV>::find_outgoing_transfer(
+        const uint64_t& transfer_id) const {
+    std::lock_guard<std::mutex> lck(this->outgoing_transfers_mutex);
+    auto it = this->outgoing_transfers.find(transfer_id);
+    if(it == this->outgoing_transfers.end()) {
+        throw std::out_of_range("Unknown state transfer " + std::to_string(transfer_id) + ".");
+    }
+    it->second.last_access = std::chrono::steady_clock::now();
+    return it->second;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+uint64_t VolatileCascadeStore<KT, VT, IK, IV>::state_chunk_budget() const {
+    return std::min(this->state_transfer_chunk_bytes, p2p_reply_payload_budget());
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+typename VolatileCascadeStore<KT, VT, IK, IV>::state_chunk_t VolatileCascadeStore<KT, VT, IK, IV>::get_state_chunk(
+        const uint64_t& transfer_id, const KT& after, const bool& from_start) const {
+    debug_enter_func_with_args("transfer_id={},after={},from_start={}", transfer_id, after, from_start);
+    if constexpr(!state_streamable) {
+        throw std::runtime_error("The state of this store is not streamed.");
+    } else {
+        const uint64_t budget = this->state_chunk_budget();
+        // the lengths of the two vectors and the version.
+        const uint64_t reserve = 3 * sizeof(uint64_t);
+        std::vector<VT> objects;
+        std::vector<KT> large_keys;
+        uint64_t bytes = reserve;
+        auto visitor = [&](const KT& key, const VT& value) {
+            const uint64_t size = mutils::bytes_size(value);
+            if(bytes + size <= budget) {
+                objects.push_back(value);
+                bytes += size;
+                return true;
+            }
+            // an object which does not fit in any chunk is fetched in pieces, see get_state_object.
+            if(reserve + size > budget && bytes + mutils::bytes_size(key) <= budget) {
+                large_keys.push_back(key);
+            }
+            return false;
+        };
+        persistent::version_t version;
+        if(transfer_id == 0) {
+            if(this->transfer_in_progress.load()) {
+                throw std::runtime_error("This member is receiving the state itself.");
+            }
+            {
+                EpochGuard epoch_guard;
+                if(from_start) {
+                    this->kv_index.for_each(visitor);
+                } else {
+                    this->kv_index.for_each_with_prefix_after("", after, visitor);
+                }
+            }
+            // loaded after the traversal, so no object visited is newer.
+            version = this->applying_version.load();
+        } else {
+            auto transfer = this->find_outgoing_transfer(transfer_id);
+            for(auto it = from_start ? transfer.snapshot->cbegin() : transfer.snapshot->upper_bound(after);
+                it != transfer.snapshot->cend() && visitor(it->first, it->second);
+                it++) {
+            }
+            version = transfer.version;
+        }
+        debug_leave_func_with_value("{} objects, {} bytes, {} large objects, version=0x{:x}",
+                                    objects.size(), bytes, large_keys.size(), version);
+        return {std::move(objects), std::move(large_keys), version};
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+typename VolatileCascadeStore<KT, VT, IK, IV>::state_piece_t VolatileCascadeStore<KT, VT, IK, IV>::get_state_object(
+        const uint64_t& transfer_id, const KT& key, const uint64_t& offset) const {
+    debug_enter_func_with_args("transfer_id={},key={},offset={}", transfer_id, key, offset);
+    if constexpr(!state_streamable) {
+        throw std::runtime_error("The state of this store is not streamed.");
+    } else {
+        std::optional<VT> object;
+        persistent::version_t version;
+        if(transfer_id == 0) {
+            if(this->transfer_in_progress.load()) {
+                throw std::runtime_error("This member is receiving the state itself.");
+            }
+            {
+                EpochGuard epoch_guard;
+                const VT* value = this->kv_index.find(key);
+                if(value != nullptr) {
+                    object.emplace(*value);
+                }
+            }
+            version = this->applying_version.load();
+        } else {
+            auto transfer = this->find_outgoing_transfer(transfer_id);
+            auto it = transfer.snapshot->find(key);
+            if(it != transfer.snapshot->cend()) {
+                object.emplace(it->second);
+            }
+            version = transfer.version;
+        }
+        if(!object.has_value()) {
+            debug_leave_func_with_value("key is absent, version=0x{:x}", version);
+            return {*IV, 0, version};
+        }
+        const uint64_t payload_size = object->get_payload_size();
+        // the object without its payload, the payload size and the version.
+        const uint64_t reserve = mutils::bytes_size(*object) - payload_size + 2 * sizeof(uint64_t);
+        const uint64_t budget = this->state_chunk_budget();
+        if(reserve >= budget) {
+            throw std::runtime_error("The object of the key does not fit in a P2P reply without its payload.");
+        }
+        slice_payload(*object, offset, budget - reserve);
+        debug_leave_func_with_value("{} of {} bytes, version=0x{:x}", object->get_payload_size(), payload_size, version);
+        return {std::move(*object), payload_size, version};
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::end_state_transfer(const uint64_t& transfer_id) const {
+    debug_enter_func_with_args("transfer_id={}", transfer_id);
+    std::lock_guard<std::mutex> lck(this->outgoing_transfers_mutex);
+    this->outgoing_transfers.erase(transfer_id);
     debug_leave_func();
 }
 
+template <typename KT, typename VT, KT* IK, VT* IV>
+template <typename ReplyType>
+std::optional<ReplyType> VolatileCascadeStore<KT, VT, IK, IV>::request_state(
+        const std::function<ReplyType(node_id_t, uint64_t)>& request) {
+    IncomingTransfer& transfer = *this->incoming_transfer;
+    uint32_t round = 1;
+    while(true) {
+        for(uint32_t attempt = 1; attempt <= STATE_TRANSFER_ATTEMPTS; attempt++) {
+            try {
+                return request(transfer.source, transfer.source_id);
+            } catch(const std::exception& ex) {
+                dbg_default_warn("{}: attempt {} of {} to get the state from node {} failed: {}", __PRETTY_FUNCTION__,
+                                 attempt, STATE_TRANSFER_ATTEMPTS, transfer.source, ex.what());
+            }
+            std::unique_lock<std::mutex> lck(this->transfer_mutex);
+            if(this->transfer_cv.wait_for(lck, STATE_TRANSFER_RETRY_DELAY * attempt, [this]() { return this->transfer_stopping; })) {
+                return std::nullopt;
+            }
+        }
+        // turn to the live state of another shard member.
+        transfer.failed_sources.insert(transfer.source);
+        derecho::Replicated<VolatileCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index);
+        const std::vector<node_id_t> members = group->template get_subgroup_members<VolatileCascadeStore>(this->subgroup_index)
+                                                       .at(subgroup_handle.get_shard_num());
+        auto next = std::find_if(members.cbegin(), members.cend(), [this, &transfer](node_id_t node) {
+            return node != group->get_my_id() && transfer.failed_sources.find(node) == transfer.failed_sources.end();
+        });
+        if(next == members.cend()) {
+            if(round == STATE_TRANSFER_ROUNDS) {
+                dbg_default_critical("{}: no shard member can serve the state after {} rounds.", __PRETTY_FUNCTION__, round);
+                return std::nullopt;
+            }
+            // back off before going over the shard members again, which may have recovered.
+            std::unique_lock<std::mutex> lck(this->transfer_mutex);
+            if(this->transfer_cv.wait_for(lck, STATE_TRANSFER_RETRY_DELAY * STATE_TRANSFER_ATTEMPTS * (1u << round),
+                                          [this]() { return this->transfer_stopping; })) {
+                return std::nullopt;
+            }
+            lck.unlock();
+            dbg_default_warn("{}: no shard member served the state in round {}, try them again.", __PRETTY_FUNCTION__, round);
+            round++;
+            transfer.failed_sources.clear();
+            next = std::find_if(members.cbegin(), members.cend(), [this](node_id_t node) { return node != group->get_my_id(); });
+            if(next == members.cend()) {
+                dbg_default_critical("{}: no other shard member to serve the state.", __PRETTY_FUNCTION__);
+                return std::nullopt;
+            }
+        }
+        dbg_default_warn("{}: stream the rest of the state from the live state of node {}.", __PRETTY_FUNCTION__, *next);
+        transfer.source = *next;
+        transfer.source_id = 0;
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::optional<std::pair<VT, persistent::version_t>> VolatileCascadeStore<KT, VT, IK, IV>::fetch_state_object(
+        derecho::Replicated<VolatileCascadeStore>& subgroup_handle, const KT& key) {
+    if constexpr(!state_streamable) {
+        return std::nullopt;
+    } else {
+        // the payload before the piece being fetched, which are all of the same version of the object.
+        std::vector<uint8_t> payload;
+        persistent::version_t object_version = persistent::INVALID_VERSION;
+        while(true) {
+            const uint64_t offset = payload.size();
+            auto piece = this->template request_state<state_piece_t>([&subgroup_handle, &key, offset](node_id_t node, uint64_t id) {
+                auto results = subgroup_handle.template p2p_send<RPC_NAME(get_state_object)>(node, id, key, offset);
+                auto& replies = results.get();
+                return state_piece_t{replies.begin()->second.get()};
+            });
+            if(!piece.has_value()) {
+                return std::nullopt;
+            }
+            auto& [object, payload_size, version] = *piece;
+            if(object.get_key_ref() != key) {
+                return std::make_pair(*IV, version);
+            }
+            if(offset > 0 && object.get_version() != object_version) {
+                // the object changed on the live state of the source, so fetch the new one from the start.
+                payload.clear();
+                continue;
+            }
+            const uint64_t piece_size = object.get_payload_size();
+            if(offset + piece_size >= payload_size || piece_size == 0) {
+                if(offset > 0) {
+                    object.patch_payload(payload.data(), payload.size(), payload.size());
+                }
+                return std::make_pair(std::move(object), version);
+            }
+            payload.insert(payload.end(), object.get_payload_bytes(), object.get_payload_bytes() + piece_size);
+            object_version = object.get_version();
+        }
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool VolatileCascadeStore<KT, VT, IK, IV>::has_delivered(persistent::version_t version) const {
+    const persistent::version_t applying = this->applying_version.load();
+    // an ordered operation waiting for the state has not changed anything yet.
+    return this->incoming_transfer->ordered_waiting ? version < applying : version <= applying;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::stream_state() {
+    pthread_setname_np(pthread_self(), "cs_state_xfer");
+    IncomingTransfer& transfer = *this->incoming_transfer;
+    const auto start = std::chrono::steady_clock::now();
+    {
+        // the group reference is set after the store is deserialized.
+        std::unique_lock<std::mutex> lck(this->transfer_mutex);
+        while(group == nullptr) {
+            if(this->transfer_cv.wait_for(lck, std::chrono::milliseconds(10), [this]() { return this->transfer_stopping; })) {
+                return;
+            }
+        }
+    }
+    dbg_default_info("{}: stream the state of {} keys from node {}.", __PRETTY_FUNCTION__, transfer.num_keys, transfer.donor);
+    derecho::Replicated<VolatileCascadeStore>& subgroup_handle = group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index);
+    std::unique_lock<std::mutex> lck(this->transfer_mutex);
+    // wait until this member has delivered the operations a state from the live state of a member reflects.
+    // @return false if the state can not be installed now, because an ordered operation waits for a key, or never,
+    //         because an ordered operation waits for the whole state; see `stuck`.
+    bool stuck = false;
+    auto wait_until_delivered = [this, &transfer, &lck, &stuck](persistent::version_t version) {
+        while(!this->has_delivered(version)) {
+            if(this->transfer_stopping || transfer.demand.has_value()) {
+                return false;
+            }
+            if(transfer.waiting_for_state) {
+                stuck = true;
+                return false;
+            }
+            this->transfer_cv.wait_for(lck, std::chrono::milliseconds(10));
+        }
+        return true;
+    };
+    while(!this->transfer_stopping && !stuck) {
+        if(transfer.demand.has_value()) {
+            // an ordered operation waits for the key.
+            const KT key = *transfer.demand;
+            lck.unlock();
+            auto fetched = this->fetch_state_object(subgroup_handle, key);
+            lck.lock();
+            if(!fetched.has_value()) {
+                stuck = true;
+                break;
+            }
+            const VT& value = fetched->first;
+            const bool present = (value.get_key_ref() == key);
+            // a newer object on a live state is the one at this member if no operation since has changed the key.
+            bool current = this->has_delivered(fetched->second);
+            if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+                current = current || (present && this->has_delivered(value.get_version()));
+            }
+            if(!current) {
+                dbg_default_critical("{}: the live state of node {} is newer than this member for key:{}.",
+                                     __PRETTY_FUNCTION__, transfer.source, key);
+                stuck = true;
+                break;
+            }
+            if(present) {
+                this->install_transferred(value);
+            }
+            transfer.touched.insert(key);
+            transfer.demand.reset();
+            this->transfer_cv.notify_all();
+            continue;
+        }
+        const KT after = transfer.cursor.value_or(KT{});
+        const bool from_start = !transfer.cursor.has_value();
+        lck.unlock();
+        auto chunk = this->template request_state<state_chunk_t>([&subgroup_handle, &after, from_start](node_id_t node, uint64_t id) {
+            auto results = subgroup_handle.template p2p_send<RPC_NAME(get_state_chunk)>(node, id, after, from_start);
+            auto& replies = results.get();
+            return state_chunk_t{replies.begin()->second.get()};
+        });
+        lck.lock();
+        if(!chunk.has_value()) {
+            stuck = true;
+            break;
+        }
+        auto& [objects, large_keys, version] = *chunk;
+        if(objects.empty() && large_keys.empty()) {
+            break;
+        }
+        if(!wait_until_delivered(version)) {
+            // serve the ordered operation first, and fetch the chunk again.
+            continue;
+        }
+        for(const auto& object : objects) {
+            this->install_transferred(object);
+        }
+        if(!objects.empty()) {
+            transfer.cursor = objects.back().get_key_ref();
+        }
+        this->transfer_cv.notify_all();
+        if(!large_keys.empty()) {
+            const KT key = large_keys.front();
+            lck.unlock();
+            auto fetched = this->fetch_state_object(subgroup_handle, key);
+            lck.lock();
+            if(!fetched.has_value()) {
+                stuck = true;
+                break;
+            }
+            if(!wait_until_delivered(fetched->second)) {
+                continue;
+            }
+            if(fetched->first.get_key_ref() == key) {
+                this->install_transferred(fetched->first);
+            }
+            transfer.cursor = key;
+            this->transfer_cv.notify_all();
+        }
+    }
+    if(this->transfer_stopping) {
+        return;
+    }
+    if(stuck) {
+        // the keys not streamed stay unavailable: the ordered operations waiting for them fail with an exception, and
+        // this member has to be restarted to get the whole state.
+        dbg_default_critical("{}: failed to stream the state from node {}. The keys not streamed are unavailable at "
+                             "this member.",
+                             __PRETTY_FUNCTION__, transfer.source);
+        transfer.failed = true;
+        this->transfer_cv.notify_all();
+        return;
+    }
+    this->transfer_in_progress.store(false);
+    this->transfer_cv.notify_all();
+    lck.unlock();
+    if(transfer.source_id != 0) {
+        try {
+            subgroup_handle.template p2p_send<RPC_NAME(end_state_transfer)>(transfer.source, transfer.source_id);
+        } catch(const std::exception& ex) {
+            // the source drops the copy when it is idle.
+            dbg_default_warn("{}: failed to end state transfer {} on node {}: {}", __PRETTY_FUNCTION__, transfer.source_id,
+                             transfer.source, ex.what());
+        }
+    }
+    dbg_default_info("{}: streamed the state from node {} in {} ms.", __PRETTY_FUNCTION__, transfer.source,
+                     std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+std::unique_lock<std::mutex> VolatileCascadeStore<KT, VT, IK, IV>::lock_for_transfer() {
+    std::unique_lock<std::mutex> lck(this->transfer_mutex, std::defer_lock);
+    if(this->transfer_in_progress.load()) {
+        lck.lock();
+    }
+    this->applying_version.store(std::get<0>(group->template get_subgroup<VolatileCascadeStore>(this->subgroup_index).get_current_version()));
+    return lck;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::wait_for_key(const KT& key, std::unique_lock<std::mutex>& lck) {
+    if(!lck.owns_lock()) {
+        return;
+    }
+    while(this->transfer_in_progress.load() && !this->is_transferred(key)) {
+        if(this->incoming_transfer->failed) {
+            this->incoming_transfer->ordered_waiting = false;
+            throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": the state transfer to this member failed.");
+        }
+        if(!this->incoming_transfer->demand.has_value()) {
+            this->incoming_transfer->demand = key;
+            this->transfer_cv.notify_all();
+        }
+        this->incoming_transfer->ordered_waiting = true;
+        this->transfer_cv.wait(lck);
+    }
+    this->incoming_transfer->ordered_waiting = false;
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::wait_for_transfer(std::unique_lock<std::mutex>& lck) {
+    if(!lck.owns_lock()) {
+        return;
+    }
+    this->incoming_transfer->ordered_waiting = true;
+    this->incoming_transfer->waiting_for_state = true;
+    this->transfer_cv.wait(lck, [this]() { return !this->transfer_in_progress.load() || this->incoming_transfer->failed; });
+    this->incoming_transfer->ordered_waiting = false;
+    this->incoming_transfer->waiting_for_state = false;
+    if(this->transfer_in_progress.load()) {
+        throw derecho::derecho_exception(std::string(__PRETTY_FUNCTION__) + ": the state transfer to this member failed.");
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+bool VolatileCascadeStore<KT, VT, IK, IV>::is_transferred(const KT& key) const {
+    const auto& transfer = *this->incoming_transfer;
+    return transfer.touched.find(key) != transfer.touched.end()
+           || (transfer.cursor.has_value() && !(*transfer.cursor < key));
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::install_transferred(const VT& value) {
+    const KT& key = value.get_key_ref();
+    // a key updated after the cut has a later object already.
+    if(this->incoming_transfer->touched.find(key) != this->incoming_transfer->touched.end()
+       || this->kv_map.find(key) != this->kv_map.end()) {
+        return;
+    }
+    if constexpr(std::is_base_of<IKeepVersion, VT>::value) {
+        if(value.is_null()) {
+            // the other members may have purged the tombstone since the cut.
+            if(this->update_version != persistent::INVALID_VERSION
+               && tombstone_age(value.get_version(), this->update_version) >= this->tombstone_gc_delay) {
+                return;
+            }
+            auto pos = std::upper_bound(this->tombstones.begin(), this->tombstones.end(), value.get_version(),
+                                        [](persistent::version_t ver, const auto& tombstone) { return ver < tombstone.first; });
+            this->tombstones.emplace(pos, value.get_version(), key);
+        }
+    }
+    auto it = this->kv_map.emplace(key, value).first;
+    if constexpr(std::is_base_of<ISharePayload, VT>::value) {
+        it->second.share_payload();
+    }
+    this->kv_index.publish(*it);
+    this->schedule_expiration(key, it->second);
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+void VolatileCascadeStore<KT, VT, IK, IV>::check_transferred(const KT& key) const {
+    if(!this->transfer_in_progress.load()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lck(this->transfer_mutex);
+    if(this->transfer_in_progress.load() && !this->is_transferred(key)) {
+        throw std::runtime_error(this->incoming_transfer->failed
+                                         ? "Key is not available, because the state transfer to this member failed."
+                                         : "Key is not available until the state transfer to this member finishes.");
+    }
+}
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+VolatileCascadeStore<KT, VT, IK, IV>::VolatileCascadeStore(
+        CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>* cw,
+        ICascadeContext* cc) : VolatileCascadeStore(std::map<KT, VT>{}, persistent::INVALID_VERSION, cw, cc) {}
+
 template <typename KT, typename VT, KT* IK, VT* IV>
 VolatileCascadeStore<KT, VT, IK, IV>::VolatileCascadeStore(
         const std::map<KT, VT>& _kvm,
         persistent::version_t _uv,
         CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>* cw,
-        ICascadeContext* cc) : lockless_v1(_uv),
-                               lockless_v2(_uv),
-                               kv_map(_kvm),
-                               update_version(_uv),
-                               cascade_watcher_ptr(cw),
-                               cascade_context_ptr(cc) {
-    debug_enter_func_with_args("copy to kv_map, size={}", kv_map.size());
-    debug_leave_func();
-}
+        ICascadeContext* cc) : VolatileCascadeStore(std::map<KT, VT>(_kvm), _uv, cw, cc) {}
 
 template <typename KT, typename VT, KT* IK, VT* IV>
 VolatileCascadeStore<KT, VT, IK, IV>::VolatileCascadeStore(
         std::map<KT, VT>&& _kvm,
         persistent::version_t _uv,
         CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>* cw,
-        ICascadeContext* cc) : lockless_v1(_uv),
-                               lockless_v2(_uv),
-                               kv_map(std::move(_kvm)),
+        ICascadeContext* cc) : tombstone_gc_delay(derecho::hasCustomizedConfKey(CASCADE_VOLATILE_TOMBSTONE_GC_DELAY)
+                                                          ? derecho::getConfUInt64(CASCADE_VOLATILE_TOMBSTONE_GC_DELAY)
+                                                          : CASCADE_VOLATILE_TOMBSTONE_GC_DELAY_DEFAULT),
+                               tombstone_gc_batch(derecho::hasCustomizedConfKey(CASCADE_VOLATILE_TOMBSTONE_GC_BATCH)
+                                                          ? derecho::getConfUInt32(CASCADE_VOLATILE_TOMBSTONE_GC_BATCH)
+                                                          : CASCADE_VOLATILE_TOMBSTONE_GC_BATCH_DEFAULT),
+                               state_transfer_chunk_bytes(derecho::hasCustomizedConfKey(CASCADE_VOLATILE_STATE_TRANSFER_CHUNK)
+                                                                  ? derecho::getConfUInt64(CASCADE_VOLATILE_STATE_TRANSFER_CHUNK)
+                                                                  : CASCADE_VOLATILE_STATE_TRANSFER_CHUNK_DEFAULT),
+                               cache_enabled(false),
+                               cache_hits(0),
+                               cache_misses(0),
+                               pool_ttls(std::make_shared<const std::map<std::string, uint64_t>>()),
+                               ttl_tick_us(std::max<uint64_t>(derecho::hasCustomizedConfKey(CASCADE_VOLATILE_TTL_TICK)
+                                                                      ? derecho::getConfUInt64(CASCADE_VOLATILE_TTL_TICK)
+                                                                      : CASCADE_VOLATILE_TTL_TICK_DEFAULT,
+                                                              1) * 1000),
+                               ttl_batch(derecho::hasCustomizedConfKey(CASCADE_VOLATILE_TTL_BATCH)
+                                                 ? derecho::getConfUInt32(CASCADE_VOLATILE_TTL_BATCH)
+                                                 : CASCADE_VOLATILE_TTL_BATCH_DEFAULT),
+                               expiration_wheel(get_time_us() / ttl_tick_us),
+                               expiration_stopping(false),
+                               next_transfer_id(1),
+                               transfer_in_progress(false),
+                               transfer_stopping(false),
+                               applying_version(_uv),
+                               kv_map(to_key_value_map<KT, VT>(std::move(_kvm))),
                                update_version(_uv),
                                cascade_watcher_ptr(cw),
                                cascade_context_ptr(cc) {
-    debug_enter_func_with_args("move to kv_map, size={}", kv_map.size());
+    debug_enter_func_with_args("kv_map size={}", kv_map.size());
+    rebuild_kv_index();
     debug_leave_func();
 }
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+VolatileCascadeStore<KT, VT, IK, IV>::~VolatileCascadeStore() {
+    if(this->expiration_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lck(this->expiration_mutex);
+            this->expiration_stopping = true;
+        }
+        this->expiration_cv.notify_all();
+        this->expiration_thread.join();
+    }
+    if(this->incoming_transfer) {
+        {
+            std::lock_guard<std::mutex> lck(this->transfer_mutex);
+            this->transfer_stopping = true;
+        }
+        this->transfer_cv.notify_all();
+        if(this->incoming_transfer->worker.joinable()) {
+            this->incoming_transfer->worker.join();
+        }
+    }
+}
 }  // namespace cascade
 }  // namespace derecho
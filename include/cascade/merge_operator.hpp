@@ -0,0 +1,101 @@
+#pragma once
+
+/**
+ * @file    merge_operator.hpp
+ * @brief   The registry of merge operators, which update an object on the ordered path from an operand.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * A merge operator computes the new payload of an object from its current payload and an operand.
+ *
+ * @param[in]   base            The current payload, or nullptr if the key does not exist.
+ * @param[in]   base_size       The size of the current payload
+ * @param[in]   operand         The operand
+ * @param[in]   operand_size    The size of the operand
+ * @param[out]  merged          The new payload
+ *
+ * @return false if the operand or the current payload is malformed, which rejects the merge.
+ */
+using merge_operator_t = std::function<bool(const uint8_t* base, std::size_t base_size,
+                                            const uint8_t* operand, std::size_t operand_size,
+                                            std::vector<uint8_t>& merged)>;
+
+/** Add a little-endian int64 operand to the current int64 payload, which is 0 if the key does not exist. */
+#define CASCADE_MERGE_ADD_INT64     "add_int64"
+/** Append the operand to the current payload. */
+#define CASCADE_MERGE_APPEND_BYTES  "append_bytes"
+/** Keep the larger of the int64 operand and the current int64 payload. */
+#define CASCADE_MERGE_MAX_INT64     "max_int64"
+/** Keep the smaller of the int64 operand and the current int64 payload. */
+#define CASCADE_MERGE_MIN_INT64     "min_int64"
+
+/**
+ * @brief   The merge operators of this process, by name.
+ *
+ * A merge is applied by every replica of a shard on the ordered path, so an operator must be deterministic and must be
+ * registered under the same name on all the nodes, e.g. when a UDL is loaded. The built-in operators above are always
+ * registered.
+ */
+class MergeOperatorRegistry {
+private:
+    std::unordered_map<std::string, merge_operator_t> operators;
+    mutable std::shared_mutex operators_mutex;
+
+    MergeOperatorRegistry();
+
+public:
+    /**
+     * @brief   Register a merge operator.
+     *
+     * @param[in]   name    The name of the operator
+     * @param[in]   op      The operator
+     *
+     * @return false if an operator of the name exists, which is kept.
+     */
+    bool register_operator(const std::string& name, const merge_operator_t& op);
+
+    /**
+     * @brief   Test if a merge operator is registered.
+     *
+     * @param[in]   name    The name of the operator
+     *
+     * @return true if it is registered.
+     */
+    bool has_operator(const std::string& name) const;
+
+    /**
+     * @brief   Apply a merge operator.
+     *
+     * @param[in]   name            The name of the operator
+     * @param[in]   base            The current payload, or nullptr if the key does not exist.
+     * @param[in]   base_size       The size of the current payload
+     * @param[in]   operand         The operand
+     * @param[in]   operand_size    The size of the operand
+     * @param[out]  merged          The new payload
+     *
+     * @return false if the operator is unknown or rejects the merge.
+     */
+    bool merge(const std::string& name, const uint8_t* base, std::size_t base_size,
+               const uint8_t* operand, std::size_t operand_size, std::vector<uint8_t>& merged) const;
+
+    /**
+     * @brief   Get the merge operator registry of this process.
+     *
+     * @return the registry.
+     */
+    static MergeOperatorRegistry& get();
+};
+
+}  // namespace cascade
+}  // namespace derecho
@@ -27,6 +27,7 @@ enum object_memory_mode_t {
     DEFAULT,
     EMPLACED,
     BLOB_GENERATOR,
+    SHARED,
 };
 
 using blob_generator_func_t = std::function<std::size_t(uint8_t*,const std::size_t)>;
@@ -42,16 +43,21 @@ public:
 
     object_memory_mode_t   memory_mode;
 
+    // for SHARED mode only: the reference count of the immutable data buffer
+    std::shared_ptr<const uint8_t> shared_bytes;
 
     // constructor - copy to own the data
     Blob(const uint8_t* const b, const decltype(size) s);
 
     Blob(const uint8_t* b, const decltype(size) s, bool emplaced);
 
+    // shared constructor - pin an immutable, reference-counted buffer
+    Blob(const std::shared_ptr<const uint8_t>& shared, const decltype(size) s);
+
     // generator constructor - data to be generated on serialization
     Blob(const blob_generator_func_t& generator, const decltype(size) s);
 
-    // copy constructor - copy to own the data
+    // copy constructor - copy to own the data, or share the data of a SHARED blob
     Blob(const Blob& other);
 
     // move constructor - accept the memory from another object
@@ -69,6 +75,15 @@ public:
     // copy evaluator:
     Blob& operator=(const Blob& other);
 
+    // turn the data into an immutable, reference-counted buffer shared by the copies of this blob
+    void share();
+
+    // replace the data, which is a patch, with a copy of base overwritten by the patch at offset
+    void patch(const uint8_t* base, const std::size_t base_size, const std::size_t offset);
+
+    // keep only the data in [offset, offset + s), where shared data is sliced instead of copied
+    void trim(const std::size_t offset, const std::size_t s);
+
     // serialization/deserialization supports
     std::size_t to_bytes(uint8_t* v) const;
 
@@ -94,7 +109,11 @@ public:
 class ObjectWithUInt64Key : public mutils::ByteRepresentable,
                             public ICascadeObject<uint64_t,ObjectWithUInt64Key>,
                             public IKeepTimestamp,
-                            public IVerifyPreviousVersion
+                            public IVerifyPreviousVersion,
+                            public ISharePayload,
+                            public IPatchPayload,
+                            public IExternalPayload,
+                            public IMergePayload
 #ifdef ENABLE_EVALUATION
                             , public IHasMessageID
 #endif
@@ -179,6 +198,13 @@ public:
     virtual bool is_null() const override;
     virtual bool is_valid() const override;
     virtual void copy_from(const ObjectWithUInt64Key& rhs) override;
+    virtual void share_payload() override;
+    virtual const uint8_t* get_payload_bytes() const override;
+    virtual std::size_t get_payload_size() const override;
+    virtual void patch_payload(const uint8_t* base, std::size_t base_size, std::size_t offset) override;
+    virtual void trim_payload(std::size_t offset, std::size_t size) override;
+    virtual void attach_payload(const std::shared_ptr<const uint8_t>& bytes, std::size_t size) override;
+    virtual void set_payload(const uint8_t* bytes, std::size_t size) override;
     virtual void set_version(persistent::version_t ver) const override;
     virtual persistent::version_t get_version() const override;
     virtual void set_timestamp(uint64_t ts_us) const override;
@@ -237,7 +263,11 @@ inline std::ostream& operator<<(std::ostream& out, const ObjectWithUInt64Key& o)
 class ObjectWithStringKey : public mutils::ByteRepresentable,
                             public ICascadeObject<std::string,ObjectWithStringKey>,
                             public IKeepTimestamp,
-                            public IVerifyPreviousVersion
+                            public IVerifyPreviousVersion,
+                            public ISharePayload,
+                            public IPatchPayload,
+                            public IExternalPayload,
+                            public IMergePayload
 #ifdef ENABLE_EVALUATION
                             ,public IHasMessageID
 #endif
@@ -322,6 +352,13 @@ public:
     virtual bool is_null() const override;
     virtual bool is_valid() const override;
     virtual void copy_from(const ObjectWithStringKey& rhs) override;
+    virtual void share_payload() override;
+    virtual const uint8_t* get_payload_bytes() const override;
+    virtual std::size_t get_payload_size() const override;
+    virtual void patch_payload(const uint8_t* base, std::size_t base_size, std::size_t offset) override;
+    virtual void trim_payload(std::size_t offset, std::size_t size) override;
+    virtual void attach_payload(const std::shared_ptr<const uint8_t>& bytes, std::size_t size) override;
+    virtual void set_payload(const uint8_t* bytes, std::size_t size) override;
     virtual void set_version(persistent::version_t ver) const override;
     virtual persistent::version_t get_version() const override;
     virtual void set_timestamp(uint64_t ts_us) const override;
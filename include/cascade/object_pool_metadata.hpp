@@ -3,6 +3,11 @@
 #include "object.hpp"
 #include "utils.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
 namespace derecho {
 namespace cascade {
 
@@ -53,23 +58,197 @@ public:
     std::unordered_map<std::string,uint32_t>    object_locations; // the list of shards where a corresponding key is stored.
     std::string                                 affinity_set_regex; // the regex to extract the affinity set string
     bool                                        deleted; // is deleted
+    uint64_t                                    memory_budget; // memory budget in bytes for a volatile object pool working as a cache, 0 for unlimited.
+    LogRetentionPolicy                          log_retention; // log retention policy for a persistent object pool, all 0 to keep the whole log.
+    uint64_t                                    blob_threshold; // payloads larger than this go to blob segments in a persistent object pool, 0 for the default.
+    uint64_t                                    ttl_ms; // the objects of a volatile object pool expire this many milliseconds after their timestamps, 0 for never.
+
+    /**
+     * Serialization support. The record is versioned, because it is kept in the log of the metadata service: it
+     * starts with a format tag, followed by the fields of the original record, the size of the extension, and the
+     * extension fields memory_budget, log_retention, blob_threshold and ttl_ms. A record without the tag is one
+     * written before the extension, whose extension fields are 0. A reader takes the extension fields it knows, and
+     * the fields it does not know read as 0, so a field is added to the extension by appending it.
+     *
+     * A deserialized object is written back in the format and with the extension size it was read with, unless its
+     * extension fields no longer fit, because the parsers of the logs and of the containers skip a record by its
+     * bytes_size().
+     */
+    static constexpr uint64_t SERIALIZATION_TAG_MASK = 0xffffffff00000000ull;
+    static constexpr uint64_t SERIALIZATION_TAG = 0x4f504d4400000001ull;  // "OPMD" and format 1
+    static constexpr std::size_t EXTENSION_FIELDS = 6;
+    static constexpr uint64_t UNTAGGED_RECORD = ~0ull;
+
+private:
+    /**
+     * The size of the extension this object was read with, or UNTAGGED_RECORD for a record without the tag.
+     */
+    uint64_t record_extension_size = EXTENSION_FIELDS * sizeof(uint64_t);
+
+    /**
+     * Visit the fields of the original record in the order they are serialized.
+     */
+    template <typename Visitor>
+    void for_each_original_field(Visitor&& visitor) const {
+#ifdef ENABLE_EVALUATION
+        visitor(message_id);
+#endif
+        visitor(version);
+        visitor(timestamp_us);
+        visitor(previous_version);
+        visitor(previous_version_by_key);
+        visitor(pathname);
+        visitor(subgroup_type_index);
+        visitor(subgroup_index);
+        visitor(sharding_policy);
+        visitor(object_locations);
+        visitor(affinity_set_regex);
+        visitor(deleted);
+    }
+
+    std::array<uint64_t,EXTENSION_FIELDS> extension_fields() const {
+        return {memory_budget,log_retention.max_versions,log_retention.max_age_sec,log_retention.max_bytes,
+                blob_threshold,ttl_ms};
+    }
+
+    /**
+     * @return the size of the extension to write, or UNTAGGED_RECORD to write the original record.
+     */
+    uint64_t extension_size() const {
+        const auto extension = extension_fields();
+        std::size_t used = EXTENSION_FIELDS;
+        while (used > 0 && extension[used - 1] == 0) {
+            used--;
+        }
+        if (record_extension_size == UNTAGGED_RECORD) {
+            return (used == 0) ? UNTAGGED_RECORD : sizeof(extension);
+        }
+        return std::max<uint64_t>(record_extension_size,used * sizeof(uint64_t));
+    }
+
+    /**
+     * Serialize the extension of a given size into buf, with the fields this object does not know as 0.
+     */
+    void extension_to_bytes(uint64_t size,uint8_t* buf) const {
+        const auto extension = extension_fields();
+        const std::size_t known = std::min<uint64_t>(size,sizeof(extension));
+        memcpy(buf,&size,sizeof(size));
+        memcpy(buf + sizeof(size),extension.data(),known);
+        memset(buf + sizeof(size) + known,0,size - known);
+    }
 
-    // serialization support
-    DEFAULT_SERIALIZATION_SUPPORT(ObjectPoolMetadata<CascadeTypes...>,
+public:
+    std::size_t to_bytes(uint8_t* buf) const {
+        const uint64_t size = extension_size();
+        std::size_t pos = 0;
+        if (size != UNTAGGED_RECORD) {
+            pos += mutils::to_bytes(SERIALIZATION_TAG,buf);
+        }
+        for_each_original_field([buf,&pos](const auto& field) {
+            pos += mutils::to_bytes(field,buf + pos);
+        });
+        if (size != UNTAGGED_RECORD) {
+            extension_to_bytes(size,buf + pos);
+            pos += sizeof(size) + size;
+        }
+        return pos;
+    }
+
+    std::size_t bytes_size() const {
+        const uint64_t size = extension_size();
+        std::size_t bytes = 0;
+        for_each_original_field([&bytes](const auto& field) {
+            bytes += mutils::bytes_size(field);
+        });
+        if (size != UNTAGGED_RECORD) {
+            bytes += sizeof(SERIALIZATION_TAG) + sizeof(size) + size;
+        }
+        return bytes;
+    }
+
+    void post_object(const std::function<void(uint8_t const* const, std::size_t)>& f) const {
+        const uint64_t size = extension_size();
+        if (size != UNTAGGED_RECORD) {
+            mutils::post_object(f,SERIALIZATION_TAG);
+        }
+        for_each_original_field([&f](const auto& field) {
+            mutils::post_object(f,field);
+        });
+        if (size != UNTAGGED_RECORD) {
+            std::vector<uint8_t> extension(sizeof(size) + size);
+            extension_to_bytes(size,extension.data());
+            f(extension.data(),extension.size());
+        }
+    }
+
+    void ensure_registered(mutils::DeserializationManager&) {}
+
+    static std::unique_ptr<ObjectPoolMetadata> from_bytes(mutils::DeserializationManager* dsm, const uint8_t* const buf) {
+        std::size_t pos = 0;
+        uint64_t tag;
+        memcpy(&tag,buf,sizeof(tag));
+        // the original record starts with a version, or a message id, neither of which looks like a tag.
+        const bool tagged = ((tag & SERIALIZATION_TAG_MASK) == (SERIALIZATION_TAG & SERIALIZATION_TAG_MASK));
+        if (tagged) {
+            pos += sizeof(tag);
+        }
+#ifdef ENABLE_EVALUATION
+        auto p_message_id = mutils::from_bytes<uint64_t>(dsm,buf + pos);
+        pos += mutils::bytes_size(*p_message_id);
+#endif
+        auto p_version = mutils::from_bytes<persistent::version_t>(dsm,buf + pos);
+        pos += mutils::bytes_size(*p_version);
+        auto p_timestamp_us = mutils::from_bytes<uint64_t>(dsm,buf + pos);
+        pos += mutils::bytes_size(*p_timestamp_us);
+        auto p_previous_version = mutils::from_bytes<persistent::version_t>(dsm,buf + pos);
+        pos += mutils::bytes_size(*p_previous_version);
+        auto p_previous_version_by_key = mutils::from_bytes<persistent::version_t>(dsm,buf + pos);
+        pos += mutils::bytes_size(*p_previous_version_by_key);
+        auto p_pathname = mutils::from_bytes<std::string>(dsm,buf + pos);
+        pos += mutils::bytes_size(*p_pathname);
+        auto p_subgroup_type_index = mutils::from_bytes<uint32_t>(dsm,buf + pos);
+        pos += mutils::bytes_size(*p_subgroup_type_index);
+        auto p_subgroup_index = mutils::from_bytes<uint32_t>(dsm,buf + pos);
+        pos += mutils::bytes_size(*p_subgroup_index);
+        auto p_sharding_policy = mutils::from_bytes<sharding_policy_t>(dsm,buf + pos);
+        pos += mutils::bytes_size(*p_sharding_policy);
+        auto p_object_locations = mutils::from_bytes<std::unordered_map<std::string,uint32_t>>(dsm,buf + pos);
+        pos += mutils::bytes_size(*p_object_locations);
+        auto p_affinity_set_regex = mutils::from_bytes<std::string>(dsm,buf + pos);
+        pos += mutils::bytes_size(*p_affinity_set_regex);
+        auto p_deleted = mutils::from_bytes<bool>(dsm,buf + pos);
+        pos += mutils::bytes_size(*p_deleted);
+        std::array<uint64_t,EXTENSION_FIELDS> extension{};
+        uint64_t extension_size = UNTAGGED_RECORD;
+        if (tagged) {
+            memcpy(&extension_size,buf + pos,sizeof(extension_size));
+            pos += sizeof(extension_size);
+            memcpy(extension.data(),buf + pos,std::min<uint64_t>(extension_size,sizeof(extension)));
+        }
+        auto metadata = std::make_unique<ObjectPoolMetadata>(
 #ifdef ENABLE_EVALUATION
-                                  message_id,
+                *p_message_id,
 #endif
-                                  version,
-                                  timestamp_us,
-                                  previous_version,
-                                  previous_version_by_key,
-                                  pathname,
-                                  subgroup_type_index,
-                                  subgroup_index,
-                                  sharding_policy,
-                                  object_locations,
-                                  affinity_set_regex,
-                                  deleted);
+                *p_version,
+                *p_timestamp_us,
+                *p_previous_version,
+                *p_previous_version_by_key,
+                *p_pathname,
+                *p_subgroup_type_index,
+                *p_subgroup_index,
+                *p_sharding_policy,
+                *p_object_locations,
+                *p_affinity_set_regex,
+                *p_deleted,
+                extension[0],
+                LogRetentionPolicy{extension[1],extension[2],extension[3]},
+                extension[4],
+                extension[5]);
+        metadata->record_extension_size = extension_size;
+        return metadata;
+    }
+
+    DEFAULT_DESERIALIZE_NOALLOC(ObjectPoolMetadata);
 
     // constructor 0: default
     ObjectPoolMetadata():
@@ -86,7 +265,11 @@ public:
         sharding_policy(HASH),
         object_locations(),
         affinity_set_regex(""),
-        deleted(false) {}
+        deleted(false),
+        memory_budget(0),
+        log_retention{0,0,0},
+        blob_threshold(0),
+        ttl_ms(0) {}
 
     // constructor 1:
     ObjectPoolMetadata(
@@ -103,7 +286,11 @@ public:
                        sharding_policy_t _sharding_policy,
                        const std::unordered_map<std::string,uint32_t>& _object_locations,
                        const std::string& _affinity_set_regex,
-                       bool _deleted):
+                       bool _deleted,
+                       uint64_t _memory_budget = 0,
+                       const LogRetentionPolicy& _log_retention = {0,0,0},
+                       uint64_t _blob_threshold = 0,
+                       uint64_t _ttl_ms = 0):
 #ifdef ENABLE_EVALUATION
         message_id(_message_id),
 #endif
@@ -117,7 +304,11 @@ public:
         sharding_policy(_sharding_policy),
         object_locations(_object_locations),
         affinity_set_regex(_affinity_set_regex),
-        deleted(_deleted) {
+        deleted(_deleted),
+        memory_budget(_memory_budget),
+        log_retention(_log_retention),
+        blob_threshold(_blob_threshold),
+        ttl_ms(_ttl_ms) {
             if (!check_pathname_format(_pathname)) {
                 throw derecho::derecho_exception("Invalid object pool pathname:" + _pathname);
             }
@@ -129,7 +320,11 @@ public:
                        sharding_policy_t _sharding_policy,
                        const std::unordered_map<std::string,uint32_t>& _object_locations,
                        const std::string& _affinity_set_regex,
-                       bool _deleted):
+                       bool _deleted,
+                       uint64_t _memory_budget = 0,
+                       const LogRetentionPolicy& _log_retention = {0,0,0},
+                       uint64_t _blob_threshold = 0,
+                       uint64_t _ttl_ms = 0):
 #ifdef ENABLE_EVALUATION
         message_id(0),
 #endif
@@ -143,7 +338,11 @@ public:
         sharding_policy(_sharding_policy),
         object_locations(_object_locations),
         affinity_set_regex(_affinity_set_regex),
-        deleted(_deleted) {
+        deleted(_deleted),
+        memory_budget(_memory_budget),
+        log_retention(_log_retention),
+        blob_threshold(_blob_threshold),
+        ttl_ms(_ttl_ms) {
             if (!check_pathname_format(_pathname)) {
                 throw derecho::derecho_exception("Invalid object pool pathname:" + _pathname);
             }
@@ -164,7 +363,12 @@ public:
         sharding_policy(other.sharding_policy),
         object_locations(other.object_locations),
         affinity_set_regex(other.affinity_set_regex),
-        deleted(other.deleted) {}
+        deleted(other.deleted),
+        memory_budget(other.memory_budget),
+        log_retention(other.log_retention),
+        blob_threshold(other.blob_threshold),
+        ttl_ms(other.ttl_ms),
+        record_extension_size(other.record_extension_size) {}
 
     // constructor 3: move constructor
     ObjectPoolMetadata(ObjectPoolMetadata&& other):
@@ -181,7 +385,12 @@ public:
         sharding_policy(other.sharding_policy),
         object_locations(std::move(other.object_locations)),
         affinity_set_regex(other.affinity_set_regex),
-        deleted(other.deleted) {}
+        deleted(other.deleted),
+        memory_budget(other.memory_budget),
+        log_retention(other.log_retention),
+        blob_threshold(other.blob_threshold),
+        ttl_ms(other.ttl_ms),
+        record_extension_size(other.record_extension_size) {}
 
     void operator = (const ObjectPoolMetadata& other) {
 #ifdef ENABLE_EVALUATION
@@ -198,6 +407,11 @@ public:
         this->object_locations = other.object_locations;
         this->affinity_set_regex = other.affinity_set_regex;
         this->deleted = other.deleted;
+        this->memory_budget = other.memory_budget;
+        this->log_retention = other.log_retention;
+        this->blob_threshold = other.blob_threshold;
+        this->ttl_ms = other.ttl_ms;
+        this->record_extension_size = other.record_extension_size;
     }
 
 #ifdef ENABLE_EVALUATION
@@ -253,6 +467,18 @@ public:
     }
 
     virtual bool validate(const std::map<std::string,ObjectPoolMetadata<CascadeTypes...>>& kv_map) const override {
+        return validate_pathname(kv_map);
+    }
+
+    virtual bool validate_stored(const key_value_map_t<std::string,ObjectPoolMetadata<CascadeTypes...>>& kv_map) const override {
+        return validate_pathname(kv_map);
+    }
+
+    /**
+     * Check that the pathname is neither under an existing object pool nor above one.
+     */
+    template <typename MapType>
+    bool validate_pathname(const MapType& kv_map) const {
         auto components = str_tokenizer(pathname,true,PATH_SEPARATOR); // only check prefixes. It is valid to overwrite an existing one.
         std::string prefix;
         for (const auto& comp:components) {
@@ -261,9 +487,13 @@ public:
                 return false;
             }
         }
-        for (const auto& oppn:kv_map) {
-            if (oppn.first.size() > pathname.size() && (oppn.first.compare(0,pathname.size(),pathname) == 0)) {
-                return false;
+        // the pools under pathname follow it in the order of the keys.
+        auto next = kv_map.upper_bound(pathname);
+        if (next != kv_map.end()) {
+            if constexpr (std::is_same_v<typename MapType::key_type,std::string>) {
+                return next->first.compare(0,pathname.size(),pathname) != 0;
+            } else {
+                return !next->first.starts_with(pathname);
             }
         }
         return true;
@@ -397,7 +627,13 @@ inline std::ostream& operator<<(std::ostream& out, const ObjectPoolMetadata<Casc
             "\tsharding_policy:" << std::to_string(opm.sharding_policy) <<"\n" <<
             "\tobject_locations:[hidden]" << "\n" <<
             "\taffinity_set_regex:" << opm.affinity_set_regex << "\n" <<
-            "\tis_deleted:" << std::to_string(opm.deleted) <<
+            "\tis_deleted:" << std::to_string(opm.deleted) << "\n" <<
+            "\tmemory_budget:" << std::to_string(opm.memory_budget) << "\n" <<
+            "\tlog_retention:{max_versions:" << opm.log_retention.max_versions <<
+                ",max_age_sec:" << opm.log_retention.max_age_sec <<
+                ",max_bytes:" << opm.log_retention.max_bytes << "}" << "\n" <<
+            "\tblob_threshold:" << std::to_string(opm.blob_threshold) << "\n" <<
+            "\tttl_ms:" << std::to_string(opm.ttl_ms) <<
             std::endl;
     }
     return out;
@@ -2,15 +2,27 @@
 
 #include "cascade_interface.hpp"
 #include "detail/delta_store_core.hpp"
+#include "detail/key_page_cursor.hpp"
+#include "detail/message_limits.hpp"
+#include "detail/object_head.hpp"
+#include "detail/payload_range.hpp"
+#include "detail/scan_object.hpp"
 
 #include <derecho/core/derecho.hpp>
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
 namespace derecho {
@@ -31,6 +43,136 @@ class PersistentCascadeStore : public ICascadeStore<KT, VT, IK, IV>,
                                public derecho::NotificationSupport {
 private:
     bool internal_ordered_put(const VT& value, bool as_trigger);
+    /**
+     * Find the latest version of a key no later than `ver`. It looks up the per-key version index, and falls back to
+     * following the previous_version_by_key chain in the log if the index does not cover `ver`.
+     *
+     * @param key   The key
+     * @param ver   The version
+     *
+     * @return the version, or INVALID_VERSION if the key has no version no later than `ver`.
+     */
+    persistent::version_t find_version_of_key(const KT& key, persistent::version_t ver) const;
+    /**
+     * Reconstruct an object found in the log. A patch is applied onto the image of the previous version of its key,
+     * which is reconstructed by following previous_version_by_key until a full image.
+     *
+     * @param key       The key
+     * @param object    The object found in a delta
+     * @param patch     The patch header if the object is a patch
+     *
+     * @return a copy of the object, which does not rely on the data in the log.
+     */
+    VT reconstruct_object(const KT& key, const VT& object,
+                          const std::optional<typename DeltaCascadeStoreCore<KT, VT, IK, IV>::DeltaType::PatchHeader>& patch) const;
+    /**
+     * Find the log entry of a version of a key, which is later than the version if the object is relocated.
+     *
+     * @param key   The key
+     * @param ver   The version of the object
+     *
+     * @return the version of the log entry, or EXPIRED_VERSION if it is trimmed from the log.
+     */
+    persistent::version_t find_log_version(const KT& key, persistent::version_t ver) const;
+    /**
+     * Create the object returned for a version trimmed from the log.
+     *
+     * @return an invalid object with version EXPIRED_VERSION.
+     */
+    static VT create_expired_object();
+    /**
+     * The earliest version kept in the log, or INVALID_VERSION if the log has never been trimmed. A read of a state
+     * before it returns an expired object.
+     */
+    std::atomic<persistent::version_t> retention_horizon;
+    /**
+     * The retention horizon chosen in the last retention round, and the version of the delta with the objects
+     * relocated for it. The next round commits it as retention_horizon and prunes the index to it.
+     */
+    std::pair<persistent::version_t, persistent::version_t> pending_trim;
+    /**
+     * The committed retention horizon the log is to be truncated to, and the version of the delta with the objects
+     * relocated for it. The log is truncated once the delta is persisted by all replicas, which is local to each
+     * replica, so it decides nothing logged or applied.
+     */
+    std::pair<persistent::version_t, persistent::version_t> pending_truncation;
+    /**
+     * The snapshot recovery context passed to persistent_core, which is constructed before it, so the recovery time
+     * counts from the construction of this context.
+     */
+    SnapshotRecovery snapshot_recovery;
+    /** The statistics of the recovery, see get_recovery_stats(). */
+    std::map<std::string, uint64_t> recovery_stats;
+    /**
+     * The version of the snapshot file, and the earliest version a snapshot may have, which is raised to the retention
+     * horizon when the log is trimmed, guarded by snapshot_file_mutex.
+     */
+    persistent::version_t snapshot_version;
+    persistent::version_t snapshot_floor;
+    std::mutex snapshot_file_mutex;
+    /** The snapshot writer thread, see CASCADE_PERSISTENT_SNAPSHOT_INTERVAL. */
+    std::thread snapshot_thread;
+    bool snapshot_running;
+    std::mutex snapshot_mutex;
+    std::condition_variable snapshot_cv;
+    /**
+     * The snapshot writer, which writes the latest checkpoint persisted by all replicas to the snapshot file.
+     *
+     * @param interval_sec  The interval in seconds
+     */
+    void snapshot_worker(uint32_t interval_sec);
+    /** The blob segment repairer, which fetches the blob segments missing on this node from the shard members. */
+    std::thread segment_repair_thread;
+    bool segment_repair_running;
+    std::mutex segment_repair_mutex;
+    std::condition_variable segment_repair_cv;
+    /** The interval between the rounds of the blob segment repairer. */
+    static constexpr std::chrono::seconds SEGMENT_REPAIR_INTERVAL{5};
+    /**
+     * Start the blob segment repairer if VT implements IExternalPayload, and let persistent_core fetch the segments it
+     * misses.
+     */
+    void start_segment_repair();
+    /**
+     * The blob segment repairer. It scans the log once to count the blob segments of the log entries not replayed
+     * here, e.g. those received by state transfer, and fetches the segments missing on this node from the shard
+     * members, retrying every SEGMENT_REPAIR_INTERVAL.
+     */
+    void segment_repair_worker();
+    /**
+     * Scan the log for the blob segments of its entries.
+     *
+     * @param missing   The segments missing on this node are appended to it.
+     *
+     * @return false if the scan fails, e.g. because the log is trimmed meanwhile.
+     */
+    bool scan_logged_segments(std::vector<BlobReference>& missing);
+    /**
+     * Fetch a blob segment from the other shard members in pieces bounded by the P2P reply size, and write it to
+     * BlobSegmentStore after checking its digest.
+     *
+     * @param reference     The reference to the segment
+     *
+     * @return true if the segment is fetched.
+     */
+    bool fetch_blob_segment(const BlobReference& reference);
+    /**
+     * Raise the earliest version of a snapshot before the log is trimmed to a retention horizon, and remove the
+     * snapshot file if it is earlier, because replaying the trimmed log after it would miss the trimmed deltas.
+     *
+     * @param horizon   The retention horizon
+     */
+    void invalidate_snapshot_before(persistent::version_t horizon);
+    /**
+     * @param pr    The persistent registry of this shard
+     *
+     * @return the snapshot file of this shard, or an empty string if the log is not in files.
+     */
+    static std::string get_snapshot_file(persistent::PersistentRegistry* pr);
+    /**
+     * @return the snapshot interval in seconds, 0 if snapshots are disabled.
+     */
+    static uint32_t get_snapshot_interval();
 
 public:
     using derecho::GroupReference::group;
@@ -43,19 +185,33 @@ public:
                                              P2P_TARGETS(
                                                      put,
                                                      put_and_forget,
+                                                     put_batch,
+                                                     put_range,
+                                                     merge,
 #ifdef ENABLE_EVALUATION
                                                      perf_put,
 #endif  // ENABLE_EVALUATION
                                                      remove,
                                                      get,
+                                                     get_range,
+                                                     get_versions,
                                                      multi_get,
                                                      get_by_time,
                                                      multi_list_keys,
                                                      list_keys,
                                                      list_keys_by_time,
+                                                     list_keys_paged,
+                                                     scan,
                                                      multi_get_size,
                                                      get_size,
                                                      get_size_by_time,
+                                                     head,
+                                                     head_batch,
+                                                     apply_retention,
+                                                     set_blob_thresholds,
+                                                     get_recovery_stats,
+                                                     get_key_memory_stats,
+                                                     get_blob_segment,
                                                      trigger_put
 #ifdef ENABLE_EVALUATION
                                                      ,
@@ -69,10 +225,15 @@ public:
                                              ORDERED_TARGETS(
                                                      ordered_put,
                                                      ordered_put_and_forget,
+                                                     ordered_put_batch,
+                                                     ordered_put_range,
+                                                     ordered_merge,
                                                      ordered_remove,
                                                      ordered_get,
                                                      ordered_list_keys,
-                                                     ordered_get_size
+                                                     ordered_get_size,
+                                                     ordered_apply_retention,
+                                                     ordered_set_blob_thresholds
 #ifdef ENABLE_EVALUATION
                                                      ,
                                                      ordered_dump_timestamp_log
@@ -87,25 +248,130 @@ public:
     virtual void trigger_put(const VT& value) const override;
     virtual version_tuple put(const VT& value, bool as_trigger) const override;
     virtual void put_and_forget(const VT& value, bool as_trigger) const override;
+    virtual version_tuple put_batch(const std::vector<VT>& values, bool as_trigger) const override;
+    /**
+     * Partially update an object: write a patch at an offset of its payload, or append it. The persistent log stores
+     * only the patch. It requires VT to implement IPatchPayload.
+     *
+     * @param patch     An object with the key and the patch as its payload
+     * @param offset    The offset of the patch in the current payload, or IPatchPayload::APPEND_OFFSET to append.
+     *
+     * @return a tuple of version and timestamp, which is INVALID_VERSION if the offset is beyond the end of the current
+     *         payload, the patch is empty, or the update is rejected.
+     */
+    version_tuple put_range(const VT& patch, const uint64_t& offset) const;
+    /**
+     * Merge an operand into the object of its key with a merge operator in MergeOperatorRegistry, e.g. to add to a
+     * counter or append to a list in one ordered message instead of a get and a conditional put. It requires VT to
+     * implement IMergePayload.
+     *
+     * @param operand           An object with the key and the operand as its payload
+     * @param merge_operator    The name of the merge operator
+     *
+     * @return a tuple of version and timestamp, which is INVALID_VERSION if the operator is unknown or rejects the
+     *         operand, or the update is rejected.
+     */
+    version_tuple merge(const VT& operand, const std::string& merge_operator) const;
 #ifdef ENABLE_EVALUATION
     virtual double perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const override;
 #endif  // ENABLE_EVALUATION
     virtual version_tuple remove(const KT& key) const override;
     virtual const VT get(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
+    virtual const VT get_range(const KT& key, const persistent::version_t& ver, const bool stable,
+                               const uint64_t& offset, const uint64_t& length) const override;
+    /**
+     * Get the stable versions of a key in a version range, from the latest backward, walking the version chain of
+     * the key in the local log. A page stops at `max_count` objects or before the reply exceeds the P2P reply size,
+     * and a client gets the rest of the history by calling it again with `ver_end` set to the returned version.
+     *
+     * @param key       The key
+     * @param ver_begin The earliest version to return, or INVALID_VERSION for no limit
+     * @param ver_end   The latest version to return, or CURRENT_VERSION for the latest stable version
+     * @param max_count The maximum number of objects to return, or 0 for no limit
+     *
+     * @return the objects, latest first, including the null objects of removals, and the version to continue from,
+     *         which is INVALID_VERSION if the history in the range is exhausted. If the walk reaches a version trimmed
+     *         from the log, the last object returned is an expired object with version EXPIRED_VERSION.
+     */
+    version_page_t<VT> get_versions(const KT& key, const persistent::version_t& ver_begin, const persistent::version_t& ver_end,
+                                    const uint32_t& max_count) const;
     virtual const VT multi_get(const KT& key) const override;
     virtual const VT get_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
     virtual std::vector<KT> multi_list_keys(const std::string& prefix) const override;
     virtual std::vector<KT> list_keys(const std::string& prefix, const persistent::version_t& ver, const bool stable) const override;
     virtual std::vector<KT> list_keys_by_time(const std::string& prefix, const uint64_t& ts_us, const bool stable) const override;
+    virtual key_page_t<KT> list_keys_paged(const std::string& prefix, const std::string& cursor, const uint32_t& limit) const override;
+    virtual scan_page_t<VT> scan(const std::string& prefix, const std::string& filter, const std::string& projection,
+                                 const std::string& cursor, const uint32_t& max_results) const override;
     virtual uint64_t multi_get_size(const KT& key) const override;
     virtual uint64_t get_size(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
     virtual uint64_t get_size_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
+    virtual ObjectHead head(const KT& key, const persistent::version_t& ver, const bool stable) const override;
+    virtual std::vector<ObjectHead> head_batch(const std::vector<KT>& keys, const persistent::version_t& ver,
+                                               const bool stable) const override;
+    /**
+     * Trim the log to the versions retained by the object pools of this shard. A retention round relocates the current
+     * objects logged before the retention horizon, and the next round commits the horizon. The log is trimmed to it
+     * in a round after the relocated objects are persisted. Reading a version before a committed horizon gets an
+     * object with version EXPIRED_VERSION.
+     *
+     * @param policies  The log retention policies, keyed by the object pool pathnames.
+     *
+     * @return a tuple of the version and timestamp of the retention round.
+     */
+    version_tuple apply_retention(const std::map<std::string, LogRetentionPolicy>& policies) const;
+    /**
+     * Set the blob thresholds of the object pools of this shard. The payload of an object larger than the threshold of
+     * its pool is written to a blob segment, and the log stores only a reference to it. The thresholds are logged
+     * with the next delta, and again by the retention round that trims past it, so they survive restarts.
+     *
+     * @param thresholds    The blob thresholds in bytes, keyed by the object pool pathnames. A threshold of 0 follows
+     *                      CASCADE/persistent_blob_threshold.
+     *
+     * @return a tuple of the version and timestamp of the update.
+     */
+    version_tuple set_blob_thresholds(const std::map<std::string, uint64_t>& thresholds) const;
+    /**
+     * Get the statistics of the recovery of this replica from its snapshot and log on start.
+     *
+     * @return a map of "recovery_us", the time to load the snapshot and replay the log in microseconds,
+     *         "snapshot_version", the version of the snapshot or INVALID_VERSION if none is loaded, "snapshot_objects",
+     *         the number of objects in the snapshot, and "replayed_deltas" and "skipped_deltas", the numbers of the log
+     *         entries replayed and skipped because they are in the snapshot.
+     */
+    std::map<std::string, uint64_t> get_recovery_stats() const;
+    /**
+     * Get the memory used by the keys of this replica. Pathname keys are stored in kv_map, which the checkpoints
+     * share, as interned prefixes and suffixes, and in the per-key version index as ids of interned prefixes and
+     * suffixes.
+     *
+     * @return a map of "keys", the number of keys, "prefixes", the number of interned prefixes, "key_bytes", the bytes
+     *         the keys would take as full keys in kv_map, "stored_key_bytes", the bytes they take in kv_map,
+     *         "index_key_bytes", the bytes they take in the version index, and "key_bytes_per_key",
+     *         "stored_key_bytes_per_key", and "index_key_bytes_per_key", the same bytes divided by the number of keys.
+     */
+    std::map<std::string, uint64_t> get_key_memory_stats() const;
+    /**
+     * Read a piece of a blob segment of this replica, for a shard member missing the segment.
+     *
+     * @param segment   The name of the segment, i.e. the hex string of its digest
+     * @param size      The size of the segment
+     * @param offset    The offset of the piece
+     *
+     * @return the piece, bounded by the P2P reply size, which is empty if the segment is missing on this replica.
+     */
+    std::vector<uint8_t> get_blob_segment(const std::string& segment, const uint64_t& size, const uint64_t& offset) const;
     virtual version_tuple ordered_put(const VT& value, bool as_trigger) override;
     virtual void ordered_put_and_forget(const VT& value, bool as_trigger) override;
+    virtual version_tuple ordered_put_batch(const std::vector<VT>& values, bool as_trigger) override;
+    version_tuple ordered_put_range(const VT& patch, const uint64_t& offset);
+    version_tuple ordered_merge(const VT& operand, const std::string& merge_operator);
     virtual version_tuple ordered_remove(const KT& key) override;
     virtual const VT ordered_get(const KT& key) override;
     virtual std::vector<KT> ordered_list_keys(const std::string& prefix) override;
     virtual uint64_t ordered_get_size(const KT& key) override;
+    version_tuple ordered_apply_retention(const std::map<std::string, LogRetentionPolicy>& policies);
+    version_tuple ordered_set_blob_thresholds(const std::map<std::string, uint64_t>& thresholds);
 #ifdef ENABLE_EVALUATION
     virtual void ordered_dump_timestamp_log(const std::string& filename) override;
 #endif  // ENABLE_EVALUATION
@@ -131,6 +397,16 @@ public:
     // destructor
     virtual ~PersistentCascadeStore();
 };
+
+/**
+ * Test if a subgroup type is a PersistentCascadeStore.
+ */
+template <typename T>
+struct is_persistent_cascade_store : std::false_type {};
+
+template <typename KT, typename VT, KT* IK, VT* IV, persistent::StorageType ST>
+struct is_persistent_cascade_store<PersistentCascadeStore<KT, VT, IK, IV, ST>> : std::true_type {};
+
 }  // namespace cascade
 }  // namespace derecho
 
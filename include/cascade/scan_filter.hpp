@@ -0,0 +1,204 @@
+#pragma once
+
+/**
+ * @file    scan_filter.hpp
+ * @brief   The filters and projections of scans, which select and trim the objects of a shard on the server.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * The fields of an object tested by a scan filter.
+ */
+struct ScanFields {
+    /** The key, or its decimal form for integer keys. */
+    std::string_view key;
+    /** The version, or INVALID_VERSION if the object has none. */
+    int64_t version;
+    /** The timestamp in microseconds, or 0 if the object has none. */
+    uint64_t timestamp_us;
+    /** The payload, or nullptr if it is empty. */
+    const uint8_t* payload;
+    std::size_t payload_size;
+};
+
+/**
+ * A scan predicate tests an object, with the argument given in the filter expression.
+ *
+ * @param[in]   fields      The fields of the object
+ * @param[in]   argument    The argument, which is empty if none is given
+ *
+ * @return true if the object matches.
+ */
+using scan_predicate_t = std::function<bool(const ScanFields& fields, const std::string& argument)>;
+
+/**
+ * @brief   The scan predicates of this process, by name.
+ *
+ * A predicate is run on the replica serving a scan, so it must be registered under the same name on all the nodes of
+ * the subgroups it scans, e.g. by a UDL under its UUID when it is loaded.
+ */
+class ScanPredicateRegistry {
+private:
+    std::unordered_map<std::string, scan_predicate_t> predicates;
+    mutable std::shared_mutex predicates_mutex;
+
+    ScanPredicateRegistry() = default;
+
+public:
+    /**
+     * @brief   Register a scan predicate.
+     *
+     * @param[in]   name        The name of the predicate
+     * @param[in]   predicate   The predicate
+     *
+     * @return false if a predicate of the name exists, which is kept.
+     */
+    bool register_predicate(const std::string& name, const scan_predicate_t& predicate);
+
+    /**
+     * @brief   Find a scan predicate.
+     *
+     * @param[in]   name        The name of the predicate
+     * @param[out]  predicate   The predicate, if it is registered
+     *
+     * @return true if it is registered.
+     */
+    bool find_predicate(const std::string& name, scan_predicate_t& predicate) const;
+
+    /**
+     * @brief   Get the scan predicate registry of this process.
+     *
+     * @return the registry.
+     */
+    static ScanPredicateRegistry& get();
+};
+
+/**
+ * @brief   A compiled scan filter.
+ *
+ * A filter expression is a conjunction of clauses, and the empty expression matches every object:
+ *
+ *      filter  := "" | clause ( "&&" clause )*
+ *      clause  := field op literal | "@" name [ "(" string ")" ]
+ *      field   := "key" | "version" | "timestamp" | "size" | "payload"
+ *      op      := "==" | "!=" | "<" | "<=" | ">" | ">=" | "^="
+ *      literal := integer | string
+ *
+ * "version", "timestamp" and "size", the size of the payload, are compared with integers, in decimal or with the 0x
+ * prefix in hexadecimal. "key" and "payload" are compared byte-wise with strings in double quotes, where \", \\ and
+ * \xHH are escaped. "^=" tests if the key or the payload starts with a string. "@name" calls the predicate registered
+ * under the name in ScanPredicateRegistry, with the optional string argument, e.g. @my_udl_uuid("threshold=3").
+ */
+class ScanFilter {
+private:
+    enum class Field { KEY, VERSION, TIMESTAMP, SIZE, PAYLOAD, PREDICATE };
+    enum class Op { EQ, NE, LT, LE, GT, GE, PREFIX };
+    struct Clause {
+        Field field;
+        Op op;
+        int64_t number;
+        std::string bytes;
+        scan_predicate_t predicate;
+    };
+    std::vector<Clause> clauses;
+
+    static bool compare_bytes(std::string_view value, Op op, const std::string& literal);
+    template <typename T>
+    static bool compare_number(T value, Op op, T literal);
+
+public:
+    /**
+     * @brief   Compile a filter expression.
+     *
+     * @param[in]   expression          The filter expression
+     * @param[out]  filter              The compiled filter
+     * @param[out]  error               The reason, if the expression is invalid
+     * @param[in]   resolve_predicates  If the predicates are looked up in ScanPredicateRegistry. A client checking the
+     *                                  syntax of a filter run on the servers passes false, and the predicates of the
+     *                                  compiled filter match every object.
+     *
+     * @return false if the expression is invalid, or if it calls a predicate which is not registered.
+     */
+    static bool compile(const std::string& expression, ScanFilter& filter, std::string& error,
+                        bool resolve_predicates = true);
+
+    /**
+     * @brief   Quote bytes as a string literal of filter expressions.
+     *
+     * @param[in]   bytes       The bytes
+     *
+     * @return the string literal.
+     */
+    static std::string quote(std::string_view bytes);
+
+    /**
+     * @return true if the filter matches every object.
+     */
+    bool matches_all() const { return clauses.empty(); }
+
+    /**
+     * @brief   Test an object.
+     *
+     * @param[in]   fields      The fields of the object
+     *
+     * @return true if the object matches all clauses.
+     */
+    bool match(const ScanFields& fields) const;
+};
+
+/**
+ * @brief   A compiled scan projection, which selects the payload bytes returned for a matching object:
+ *
+ *      projection := "" | "payload"                    the whole payload
+ *                  | "none"                            no payload, only the key, version and timestamp
+ *                  | "payload[" offset ":" length "]"  at most length bytes from offset
+ */
+class ScanProjection {
+private:
+    uint64_t offset;
+    uint64_t length;
+
+public:
+    ScanProjection() : offset(0), length(UINT64_MAX) {}
+
+    /**
+     * @brief   Compile a projection expression.
+     *
+     * @param[in]   expression  The projection expression
+     * @param[out]  projection  The compiled projection
+     * @param[out]  error       The reason, if the expression is invalid
+     *
+     * @return false if the expression is invalid.
+     */
+    static bool compile(const std::string& expression, ScanProjection& projection, std::string& error);
+
+    /**
+     * @return true if the whole payload is returned.
+     */
+    bool keeps_payload() const { return offset == 0 && length == UINT64_MAX; }
+
+    /**
+     * @brief   Project a payload.
+     *
+     * @param[in]   payload     The payload
+     * @param[in]   size        The size of the payload
+     *
+     * @return the projected bytes, which are in the payload.
+     */
+    std::pair<const uint8_t*, std::size_t> apply(const uint8_t* payload, std::size_t size) const;
+};
+
+}  // namespace cascade
+}  // namespace derecho
@@ -21,6 +21,7 @@
 #include <derecho/persistent/PersistentInterface.hpp>
 #include <memory>
 #include <mutex>
+#include <atomic>
 #include <shared_mutex>
 #include <typeinfo>
 #include <tuple>
@@ -37,9 +38,12 @@
 #include "cascade.hpp"
 #include "utils.hpp"
 #include "object_pool_metadata.hpp"
+#include "chunked_object.hpp"
 #include "user_defined_logic_manager.hpp"
 #include "data_flow_graph.hpp"
+#include "detail/message_limits.hpp"
 #include "detail/prefix_registry.hpp"
+#include "scan_filter.hpp"
 
 namespace derecho {
 namespace cascade {
@@ -66,6 +70,79 @@ namespace cascade {
                have_same_object_type<SecondCascadeType,RestCascadeTypes...>();
     }
 
+    /**
+     * @fn constexpr bool is_object_pool_type()
+     * @tparam  CascadeType     Cascade Type
+     * @return  true if object pools can be placed in subgroups of CascadeType, which needs string keys.
+     */
+    template <typename CascadeType>
+    constexpr bool is_object_pool_type() {
+        return std::is_convertible<typename CascadeType::KeyType, std::string>::value;
+    }
+
+    /**
+     * @fn constexpr bool has_object_pool_type()
+     * @tparam  CascadeTypes    Cascade Types
+     * @return  true if any of CascadeTypes can hold object pools.
+     */
+    template <typename... CascadeTypes>
+    constexpr bool has_object_pool_type() {
+        return (is_object_pool_type<CascadeTypes>() || ...);
+    }
+
+    /**
+     * @fn constexpr bool have_same_object_pool_object_type()
+     * @tparam  CascadeType     Cascade Type
+     * @return  true, since there is at most one object pool type.
+     */
+    template <typename CascadeType>
+    constexpr bool have_same_object_pool_object_type() {
+        return true;
+    }
+
+    /**
+     * @fn constexpr bool have_same_object_pool_object_type()
+     * @tparam  FirstCascadeType
+     * @tparam  SecondCascadeType
+     * @tparam  RestCascadeTypes
+     * @return  true if the CascadeType(s) holding object pools have the same ObjectType, otherwise false. The other
+     *          types, like the compact stores with uint64_t keys, are only accessed by subgroup type, index and shard.
+     */
+    template <typename FirstCascadeType, typename SecondCascadeType, typename ... RestCascadeTypes>
+    constexpr bool have_same_object_pool_object_type() {
+        if constexpr (!is_object_pool_type<FirstCascadeType>()) {
+            return have_same_object_pool_object_type<SecondCascadeType,RestCascadeTypes...>();
+        } else if constexpr (!is_object_pool_type<SecondCascadeType>()) {
+            return have_same_object_pool_object_type<FirstCascadeType,RestCascadeTypes...>();
+        } else {
+            return have_same_object_type<FirstCascadeType,SecondCascadeType>() &&
+                   have_same_object_pool_object_type<SecondCascadeType,RestCascadeTypes...>();
+        }
+    }
+
+    /**
+     * @fn const char* subgroup_layout_conf_key()
+     * @tparam  CascadeType     Cascade Type
+     * @return  the configuration key holding the layout of the subgroups of CascadeType, which is used if the json
+     *          layout has no entry for it, or nullptr if there is no such key. It is specialized by the subgroup types
+     *          with such a key, see service_types.hpp.
+     */
+    template <typename CascadeType>
+    const char* subgroup_layout_conf_key() {
+        return nullptr;
+    }
+
+    /**
+     * @fn json load_subgroup_layout()
+     * @brief Load the json layout from the derecho configuration, and fill the entries missing from its end with the
+     *        layouts in subgroup_layout_conf_key() of their types. A type with neither gets no subgroup, so a layout
+     *        written before a subgroup type was appended to CascadeTypes keeps working.
+     * @tparam  CascadeTypes    Cascade Types, following the metadata service.
+     * @return  the layout, with an entry for the metadata service and each of CascadeTypes.
+     */
+    template <typename... CascadeTypes>
+    json load_subgroup_layout();
+
     /** Cascade Factory type*/
     template <typename CascadeType>
     using Factory = std::function<std::unique_ptr<CascadeType>(persistent::PersistentRegistry*, subgroup_id_t subgroup_id, ICascadeContext*)>;
@@ -238,7 +315,7 @@ namespace cascade {
     template <typename... CascadeTypes>
     class Service {
 
-        static_assert(have_same_object_type<CascadeTypes...>());
+        static_assert(have_same_object_pool_object_type<CascadeTypes...>());
 
         /**
          * Constructor
@@ -462,14 +539,43 @@ namespace cascade {
 
     template <typename... CascadeTypes>
     class ServiceClient {
-        static_assert(have_same_object_type<CascadeTypes...>());
+        static_assert(have_same_object_pool_object_type<CascadeTypes...>());
     private:
+        using external_group_t = derecho::ExternalGroupClient<CascadeMetadataService<CascadeTypes...>,CascadeTypes...>;
+        template <typename SubgroupType>
+        using external_caller_t = derecho::ExternalClientCaller<SubgroupType,external_group_t>;
         // default caller as an external client.
-        std::unique_ptr<derecho::ExternalGroupClient<CascadeMetadataService<CascadeTypes...>,CascadeTypes...>> external_group_ptr;
+        std::unique_ptr<external_group_t> external_group_ptr;
+        /**
+         * A call into the external group client, submitted by a thread and run by the thread sending for all of them.
+         */
+        struct external_call_t {
+            std::function<void(external_group_t&)> run;
+            external_call_t* next = nullptr;
+            std::atomic<bool> done{false};
+        };
+        /**
+         * The external group client is not thread-safe: its callers share the p2p connections and the lazily created
+         * caller map. So the calls into it are pushed to the lock-free stack 'external_calls', and the thread which
+         * sets 'external_sending' runs them in submission order, while the other threads wait for their own calls
+         * only. The member selection, the metadata lookups and the reply waits of an operation run outside. See
+         * external_call().
+         */
+        mutable std::atomic<external_call_t*> external_calls;
+        mutable std::atomic<bool> external_sending;
+        /**
+         * 'external_group_ptr_mutex' serializes the reconfigurations after view changes. See refresh_view().
+         */
         mutable std::mutex external_group_ptr_mutex;
-        // caller as a group member.
+        // caller as a group member. The group is thread-safe for sending, so no client-wide lock is taken.
         derecho::Group<CascadeMetadataService<CascadeTypes...>, CascadeTypes...>* group_ptr;
-        mutable std::mutex group_ptr_mutex;
+        /**
+         * 'client_id' identifies this client in the per-thread caller handle caches, so that a client created at the
+         * address of a destroyed one never sees its handles. 'view_generation' is bumped on view changes to make the
+         * threads resolve their handles again, and to drop the member cache entries looked up before the change.
+         */
+        const uint64_t client_id;
+        std::atomic<uint64_t> view_generation;
         // cascade server side notification handler registry.
         mutable mutils::KindMap<per_type_notification_handler_registry_t,CascadeTypes...> notification_handler_registry;
         mutable std::mutex notification_handler_registry_mutex;
@@ -558,6 +664,40 @@ namespace cascade {
         template <typename SubgroupType>
         void refresh_member_cache_entry(uint32_t subgroup_index, uint32_t shard_index);
 
+        /**
+         * Get the caller handle of a subgroup as an external client. The handles are cached per thread and per
+         * client, so a thread only looks the handle up in the external group client once per view. It is called
+         * by the calls run by external_call().
+         * @param[in] subgroup_index
+         *
+         * @return the caller of the subgroup.
+         */
+        template <typename SubgroupType>
+        external_caller_t<SubgroupType>& get_external_caller(uint32_t subgroup_index) const;
+
+        /**
+         * Run a call into the external group client, serialized with the calls of the other threads without a lock:
+         * the call is submitted to 'external_calls', and the calling thread either runs the submitted calls itself or
+         * waits for another thread to run its call.
+         * @param[in] call              a callable as R(external_group_t&).
+         *
+         * @return what 'call' returns. The exception it throws is rethrown in the calling thread.
+         */
+        template <typename CallFunc>
+        auto external_call(CallFunc&& call) const;
+
+        /**
+         * Send through the caller handle of a subgroup as an external client, see external_call(). If the send fails,
+         * the view is refreshed before the exception is rethrown, so that the next operation picks a member of the
+         * current view.
+         * @param[in] subgroup_index
+         * @param[in] send              a callable as R(external_caller_t<SubgroupType>&), which sends the request.
+         *
+         * @return what 'send' returns, usually the QueryResults of the request.
+         */
+        template <typename SubgroupType, typename SendFunc>
+        auto external_send(uint32_t subgroup_index, SendFunc&& send);
+
         /**
          * Deprecated: Please use key_to_shard() instead
          *
@@ -704,6 +844,14 @@ namespace cascade {
         std::tuple<ShardMemberSelectionPolicy,node_id_t> get_member_selection_policy(
                 uint32_t subgroup_index, uint32_t shard_index) const;
 
+        /**
+         * "refresh_view" reconfigures the client after a view change: the cached shard members are dropped and the
+         * threads resolve their caller handles again on their next operation. Cascade members call it from the view
+         * upcall, and external clients call it when a send fails, since the external group client only finds a member
+         * failed or removed when it sends to it. Applications may also call it when they learn about a membership change.
+         */
+        void refresh_view();
+
         /**
          * "put" writes an object to a given subgroup/shard.
          *
@@ -769,6 +917,205 @@ namespace cascade {
         template <typename ObjectType>
         derecho::rpc::QueryResults<version_tuple> put(const ObjectType& object, bool as_trigger = false);
 
+        /**
+         * "put_batch" writes a batch of objects to a given subgroup/shard in a single ordered send. The objects are
+         * applied atomically under one version, and a PersistentCascadeStore logs them as one entry. The batch is
+         * rejected as a whole if any object fails the previous version check or validation, or if two objects
+         * have the same key. The batch must fit in one message, see ordered_payload_budget() and
+         * p2p_request_payload_budget() in detail/message_limits.hpp; a larger batch is rejected before it is sent.
+         *
+         * @tparam SubgroupType     Type of the subgroup
+         * @param[in] objects           the objects to write, which must belong to the given shard.
+         * @param[in] subgroup_index    the subgroup index of CascadeType
+         * @param[in] shard_index       the shard index.
+         * @param[in] as_trigger        If true, the objects will NOT apply to the K/V store.
+         *
+         * @return a future to the version and timestamp of the batch, where the version is INVALID_VERSION if the
+         *         batch is rejected.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<version_tuple> put_batch(const std::vector<typename SubgroupType::ObjectType>& objects,
+                uint32_t subgroup_index, uint32_t shard_index, bool as_trigger = false);
+
+    protected:
+        template <typename ObjectType, typename FirstType, typename SecondType, typename... RestTypes>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_put_batch(
+                uint32_t type_index,
+                const std::vector<ObjectType>& objects,
+                uint32_t subgroup_index,
+                uint32_t shard_index,
+                bool as_trigger);
+
+        template <typename ObjectType, typename LastType>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_put_batch(
+                uint32_t type_index,
+                const std::vector<ObjectType>& objects,
+                uint32_t subgroup_index,
+                uint32_t shard_index,
+                bool as_trigger);
+    public:
+        /**
+         * object pool version of put_batch. The objects are grouped by the shards their keys map to, and the group
+         * of each shard is split, in the order of the objects, into sub-batches that fit in one message. Each
+         * sub-batch is written with one put_batch, so the all-or-nothing guarantee, including the duplicate key
+         * check, holds per sub-batch: neither across sub-batches of the same shard nor across shards. The whole
+         * batch is rejected before anything is sent if an object does not fit in a message by itself.
+         * @param[in] objects           the objects to write, the object pools are extracted from the object keys.
+         * @param[in] as_trigger        If true, the objects will NOT apply to the K/V store.
+         *
+         * @return the futures to the versions and timestamps of the sub-batches, in the order of the subgroup type,
+         *         subgroup index and shard index they go to, and then of the objects.
+         */
+        template <typename ObjectType>
+        std::vector<std::unique_ptr<derecho::rpc::QueryResults<version_tuple>>> put_batch(
+                const std::vector<ObjectType>& objects, bool as_trigger = false);
+
+        /**
+         * "put_chunked" writes a large object as chunks and a manifest, see ChunkedObjectManifest. The chunks are put
+         * in parallel, up to CASCADE/chunk_parallelism at a time, and then the manifest is put under the key of the
+         * object, so a reader never sees a manifest before its chunks. The chunks of the object replaced by the
+         * manifest are removed afterwards.
+         *
+         * The manifest only replaces the object read before the chunks are put: it is put with the version of that
+         * object as its previous version by key. If a concurrent put replaced the object in the meantime, the object
+         * is read again and the manifest put again, so the chunks of every replaced manifest are removed. If the
+         * object carries its own previous version by key, that check applies instead, and a conflict removes the new
+         * chunks and fails the put.
+         *
+         * @param[in] object            the object to write, whose payload must be in memory.
+         * @param[in] chunk_size        the chunk size in bytes, 0 for CASCADE/chunk_size_bytes. It is capped by
+         *                              max_chunk_size(). An object not larger than a chunk is put as it is.
+         *
+         * @return the version and timestamp of the put of the manifest, or of the object if it is not chunked. The
+         *         version is INVALID_VERSION if the previous version check of the object fails.
+         */
+        version_tuple put_chunked(const ObjectWithStringKey& object, uint64_t chunk_size = 0);
+
+        /**
+         * "get_chunked" reads the current state of an object written by put_chunked. The chunks are fetched in
+         * parallel and copied into one buffer allocated up front, which the returned object shares.
+         *
+         * @param[in] key               the object key
+         *
+         * @return the object with the assembled payload and the version and timestamp of the manifest, or the object
+         *         as it is if it is not chunked.
+         */
+        ObjectWithStringKey get_chunked(const std::string& key);
+
+        /**
+         * "remove_chunked" removes an object written by put_chunked, and then its chunks.
+         *
+         * @param[in] key               the object key
+         *
+         * @return the version and timestamp of the removal of the key.
+         */
+        version_tuple remove_chunked(const std::string& key);
+
+        /**
+         * "put_range" partially updates an object in a given subgroup/shard: it writes the payload of `patch` at
+         * `offset` of the payload of the current object of the key, and the persistent log stores only the patch.
+         *
+         * @tparam SubgroupType     Type of the subgroup, which must be a PersistentCascadeStore
+         * @param[in] patch             an object with the key and the patch as its payload.
+         * @param[in] offset            the offset of the patch, which must not be beyond the end of the current
+         *                              payload, or IPatchPayload::APPEND_OFFSET to append.
+         * @param[in] subgroup_index    the subgroup index of CascadeType
+         * @param[in] shard_index       the shard index.
+         *
+         * @return a future to the version and timestamp of the update, where the version is INVALID_VERSION if the
+         *         update is rejected.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<version_tuple> put_range(const typename SubgroupType::ObjectType& patch,
+                uint64_t offset, uint32_t subgroup_index, uint32_t shard_index);
+
+    protected:
+        template <typename ObjectType, typename FirstType, typename SecondType, typename... RestTypes>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_put_range(
+                uint32_t type_index,
+                const ObjectType& patch,
+                uint64_t offset,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+        template <typename ObjectType, typename LastType>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_put_range(
+                uint32_t type_index,
+                const ObjectType& patch,
+                uint64_t offset,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+    public:
+        /**
+         * object pool version of put_range, where the object pool must be in a PersistentCascadeStore subgroup.
+         * @param[in] patch             an object with the key and the patch as its payload, the object pool is
+         *                              extracted from the object key.
+         * @param[in] offset            the offset of the patch, or IPatchPayload::APPEND_OFFSET to append.
+         *
+         * @return a future to the version and timestamp of the update.
+         */
+        template <typename ObjectType>
+        derecho::rpc::QueryResults<version_tuple> put_range(const ObjectType& patch, uint64_t offset);
+
+        /**
+         * "append" appends the payload of `patch` to the current object of the key. It is put_range() at
+         * IPatchPayload::APPEND_OFFSET.
+         * @param[in] patch             an object with the key and the bytes to append as its payload, the object
+         *                              pool is extracted from the object key.
+         *
+         * @return a future to the version and timestamp of the update.
+         */
+        template <typename ObjectType>
+        derecho::rpc::QueryResults<version_tuple> append(const ObjectType& patch);
+
+        /**
+         * "merge" updates an object in a given subgroup/shard with a merge operator, which computes the new payload
+         * from the current object of the key and the payload of `operand` on the ordered path. For example,
+         * CASCADE_MERGE_ADD_INT64 increments a counter without a get and a conditional put.
+         *
+         * @tparam SubgroupType     Type of the subgroup, which must be a VolatileCascadeStore or a
+         *                          PersistentCascadeStore
+         * @param[in] operand           an object with the key and the operand as its payload.
+         * @param[in] merge_operator    the name of a merge operator in MergeOperatorRegistry, which must be
+         *                              registered on the members of the shard.
+         * @param[in] subgroup_index    the subgroup index of CascadeType
+         * @param[in] shard_index       the shard index.
+         *
+         * @return a future to the version and timestamp of the update, where the version is INVALID_VERSION if the
+         *         operator is unknown or rejects the operand.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<version_tuple> merge(const typename SubgroupType::ObjectType& operand,
+                const std::string& merge_operator, uint32_t subgroup_index, uint32_t shard_index);
+
+    protected:
+        template <typename ObjectType, typename FirstType, typename SecondType, typename... RestTypes>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_merge(
+                uint32_t type_index,
+                const ObjectType& operand,
+                const std::string& merge_operator,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+        template <typename ObjectType, typename LastType>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_merge(
+                uint32_t type_index,
+                const ObjectType& operand,
+                const std::string& merge_operator,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+    public:
+        /**
+         * object pool version of merge.
+         * @param[in] operand           an object with the key and the operand as its payload, the object pool is
+         *                              extracted from the object key.
+         * @param[in] merge_operator    the name of the merge operator.
+         *
+         * @return a future to the version and timestamp of the update.
+         */
+        template <typename ObjectType>
+        derecho::rpc::QueryResults<version_tuple> merge(const ObjectType& operand, const std::string& merge_operator);
+
         /**
          * "put_and_forget" writes an object to a given subgroup/shard, but no return value.
          *
@@ -1001,6 +1348,93 @@ namespace cascade {
                 const persistent::version_t& version = CURRENT_VERSION,
                 bool stable = true);
 
+        /**
+         * "get_range" retrieve the object of a given key with only a byte range of its payload, which is clipped to
+         * the end of the payload. Other than the payload, the object is the one returned by "get".
+         *
+         * @param[in] key               the object key
+         * @param[in] offset            the offset of the range in the payload
+         * @param[in] length            the length of the range
+         * @param[in] version           if version is CURRENT_VERSION, read the latest state of the key. Otherwise,
+         *                          read the key's state at version.
+         * @param[in] stable            stable get or not
+         * @param[in] subgroup_index    the subgroup index of CascadeType
+         * @param[in] shard_index       the shard index.
+         *
+         * @return a future to the retrieved object.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> get_range(
+                const typename SubgroupType::KeyType& key,
+                const uint64_t offset,
+                const uint64_t length,
+                const persistent::version_t& version = CURRENT_VERSION,
+                bool stable = true,
+                uint32_t subgroup_index = 0,
+                uint32_t shard_index = 0);
+
+    protected:
+        template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
+        auto type_recursive_get_range(
+                uint32_t type_index,
+                const KeyType& key,
+                const uint64_t offset,
+                const uint64_t length,
+                const persistent::version_t& version,
+                bool stable,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+        template <typename KeyType, typename LastType>
+        auto type_recursive_get_range(
+                uint32_t type_index,
+                const KeyType& key,
+                const uint64_t offset,
+                const uint64_t length,
+                const persistent::version_t& version,
+                bool stable,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+    public:
+        /**
+         * object pool version
+         */
+        template <typename KeyType>
+        auto get_range(
+                const KeyType& key,
+                const uint64_t offset,
+                const uint64_t length,
+                const persistent::version_t& version = CURRENT_VERSION,
+                bool stable = true);
+
+        /**
+         * "get_versions" retrieves the stable versions of a key in a version range from a shard of a
+         * PersistentCascadeStore subgroup in one round trip. The replica walks the version chain of the key in its
+         * local log, from the latest version backward, and returns a page of at most `max_count` objects that fits in
+         * the P2P reply size. To get a long history in pages, call it again with `ver_end` set to the returned version
+         * until it is INVALID_VERSION.
+         *
+         * @tparam SubgroupType         Type of the subgroup, which must be a PersistentCascadeStore
+         * @param[in] key               the object key
+         * @param[in] ver_begin         the earliest version to return, or INVALID_VERSION for no limit
+         * @param[in] ver_end           the latest version to return, or CURRENT_VERSION for the latest stable version
+         * @param[in] max_count         the maximum number of objects to return, or 0 for no limit
+         * @param[in] subgroup_index    the subgroup index of CascadeType
+         * @param[in] shard_index       the shard index.
+         *
+         * @return a future to the objects, latest first, including the null objects of removals, and the version to
+         *         continue from, which is INVALID_VERSION after the last page. An object with version EXPIRED_VERSION
+         *         ends the history if the log is trimmed.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<version_page_t<typename SubgroupType::ObjectType>> get_versions(
+                const typename SubgroupType::KeyType& key,
+                const persistent::version_t& ver_begin = INVALID_VERSION,
+                const persistent::version_t& ver_end = CURRENT_VERSION,
+                uint32_t max_count = 0,
+                uint32_t subgroup_index = 0,
+                uint32_t shard_index = 0);
+
         /**
          * "multi_get" retrieve the object of a given key, this operation involves atomic broadcast
          *
@@ -1276,6 +1710,110 @@ namespace cascade {
                 const uint64_t& ts_us,
                 const bool stable = true);
 
+        /**
+         * "head" retrieve the metadata of the object of a given key, i.e. its version, timestamp, previous versions
+         * and payload size, without transferring the payload.
+         *
+         * @param[in] key               the object key
+         * @param[in] version           if version is CURRENT_VERSION, get the metadata of the latest object.
+         *                          Otherwise, get the metadata of the key's state at version.
+         * @param[in] stable            stable head or not
+         * @param[in] subgroup_index    the subgroup index of CascadeType
+         * @param[in] shard_index       the shard index.
+         *
+         * @return a future to the metadata.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<ObjectHead> head(
+                const typename SubgroupType::KeyType& key,
+                const persistent::version_t& version = CURRENT_VERSION,
+                const bool stable = true,
+                uint32_t subgroup_index = 0,
+                uint32_t shard_index = 0);
+
+    protected:
+        template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
+        derecho::rpc::QueryResults<ObjectHead> type_recursive_head(
+                uint32_t type_index,
+                const KeyType& key,
+                const persistent::version_t& version,
+                const bool stable,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+        template <typename KeyType, typename LastType>
+        derecho::rpc::QueryResults<ObjectHead> type_recursive_head(
+                uint32_t type_index,
+                const KeyType& key,
+                const persistent::version_t& version,
+                const bool stable,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+    public:
+        /**
+         * object pool version
+         */
+        template <typename KeyType>
+        derecho::rpc::QueryResults<ObjectHead> head(
+                const KeyType& key,
+                const persistent::version_t& version = CURRENT_VERSION,
+                const bool stable = true);
+
+        /**
+         * "head_batch" retrieve the metadata of the objects of a batch of keys in a shard with one RPC, like head.
+         *
+         * @param[in] keys              the object keys, which must belong to the given shard.
+         * @param[in] version           the version, like head.
+         * @param[in] stable            stable head or not
+         * @param[in] subgroup_index    the subgroup index of CascadeType
+         * @param[in] shard_index       the shard index.
+         *
+         * @return a future to the metadata, in the order of the keys.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<std::vector<ObjectHead>> head_batch(
+                const std::vector<typename SubgroupType::KeyType>& keys,
+                const persistent::version_t& version = CURRENT_VERSION,
+                const bool stable = true,
+                uint32_t subgroup_index = 0,
+                uint32_t shard_index = 0);
+
+    protected:
+        template <typename KeyType, typename FirstType, typename SecondType, typename... RestTypes>
+        derecho::rpc::QueryResults<std::vector<ObjectHead>> type_recursive_head_batch(
+                uint32_t type_index,
+                const std::vector<KeyType>& keys,
+                const persistent::version_t& version,
+                const bool stable,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+        template <typename KeyType, typename LastType>
+        derecho::rpc::QueryResults<std::vector<ObjectHead>> type_recursive_head_batch(
+                uint32_t type_index,
+                const std::vector<KeyType>& keys,
+                const persistent::version_t& version,
+                const bool stable,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+    public:
+        /**
+         * object pool version of head_batch. The keys are grouped by the shards they map to, the groups are sent in
+         * parallel with one head_batch each, and the replies are waited for.
+         * @param[in] keys              the object keys, the object pools are extracted from the keys.
+         * @param[in] version           the version, like head.
+         * @param[in] stable            stable head or not
+         *
+         * @return the metadata of the objects, in the order of the keys.
+         */
+        template <typename KeyType>
+        std::vector<ObjectHead> head_batch(
+                const std::vector<KeyType>& keys,
+                const persistent::version_t& version = CURRENT_VERSION,
+                const bool stable = true);
+
         /**
          * "list_keys" retrieve the list of keys in a shard
          *
@@ -1401,6 +1939,92 @@ namespace cascade {
         */
         auto list_keys_by_time(const uint64_t& ts_us, const bool stable, const std::string& object_pool_pathname);
 
+        /**
+         * "scan" retrieves the latest objects of a shard with the keys matching a prefix, filtered and projected by the
+         * shard member, so that only the matching objects, trimmed to the projected bytes, are returned. See
+         * ScanFilter and ScanProjection for the expressions. A filter may call a predicate which is only registered on
+         * the servers, so the client only checks the syntax of the expressions. The objects are returned a page at a
+         * time, bounded by the P2P reply size: a scan starts with an empty cursor and continues with the cursor
+         * returned with each page, until it is empty.
+         *
+         * @param[in] prefix            the key prefix, empty for all keys.
+         * @param[in] filter            the filter expression, empty to match all objects.
+         * @param[in] projection        the projection expression, empty to return the whole payloads.
+         * @param[in] cursor            the cursor returned with the previous page, empty for the first page.
+         * @param[in] max_results       the maximum number of objects in the page, 0 for no limit but the reply size.
+         * @param[in] subgroup_index    the subgroup index of CascadeType
+         * @param[in] shard_index       the shard index.
+         *
+         * @return a future to the page of the matching objects and the cursor of the next page. The future throws if
+         *         the shard member rejects the expressions or the cursor.
+         * @throw derecho::derecho_exception if the filter or the projection is invalid.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<scan_page_t<typename SubgroupType::ObjectType>> scan(
+                const std::string& prefix,
+                const std::string& filter,
+                const std::string& projection,
+                const std::string& cursor,
+                uint32_t max_results = 0,
+                uint32_t subgroup_index = 0,
+                uint32_t shard_index = 0);
+
+    protected:
+        template <typename FirstType, typename SecondType, typename... RestTypes>
+        auto type_recursive_scan(
+                uint32_t type_index,
+                const std::string& filter,
+                const std::string& projection,
+                uint32_t max_results,
+                const std::string& object_pool_pathname);
+        template <typename LastType>
+        auto type_recursive_scan(
+                uint32_t type_index,
+                const std::string& filter,
+                const std::string& projection,
+                uint32_t max_results,
+                const std::string& object_pool_pathname);
+        template <typename SubgroupType>
+        std::vector<typename SubgroupType::ObjectType>
+            __scan(const std::string& filter, const std::string& projection, uint32_t max_results,
+                   const std::string& object_pool_pathname);
+    public:
+        /**
+         * object pool version, scanning all shards of the object pool. The first pages of the shards are requested
+         * together, and each shard is scanned to its last page.
+         *
+         * @param[in] filter                the filter expression
+         * @param[in] projection            the projection expression
+         * @param[in] max_results           the maximum number of objects returned by each shard, 0 for no limit.
+         * @param[in] object_pool_pathname  the object pool pathname
+         *
+         * @return the matching objects of all shards.
+         */
+        auto scan(const std::string& filter, const std::string& projection, uint32_t max_results,
+                  const std::string& object_pool_pathname);
+
+        /**
+         * "list_keys_paged" retrieves a page of the keys in a shard. A listing starts with an empty cursor and
+         * continues with the cursor returned with each page, until it is empty. The cursor carries the version of
+         * the listing and its last key, so the pages may be read from different shard members. Use CascadeKeyPager to
+         * list all shards of a subgroup with prefetching.
+         *
+         * @param[in] prefix            the key prefix, empty for all keys.
+         * @param[in] cursor            the cursor returned with the previous page, empty for the first page.
+         * @param[in] limit             the maximum number of keys in the page.
+         * @param[in] subgroup_index    the subgroup index of CascadeType
+         * @param[in] shard_index       the shard index.
+         *
+         * @return a future to the page of keys and the cursor of the next page.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<key_page_t<typename SubgroupType::KeyType>> list_keys_paged(
+                const std::string& prefix,
+                const std::string& cursor,
+                uint32_t limit,
+                uint32_t subgroup_index = 0,
+                uint32_t shard_index = 0);
+
         /**
          * Object Pool Management API: refresh object pool cache
          * We load 'unstable' (commited by may not persisted) metadata here.
@@ -1417,6 +2041,13 @@ namespace cascade {
          * @param[in]  object_locations The set of special object locations.
          * @param[in]  affinity_set_regex
          *                          The affinity set regex.
+         * @param[in]  memory_budget    The memory budget in bytes of each shard, which turns an object pool in a
+         *                          VolatileCascadeStore subgroup into a cache. 0 for unlimited.
+         * @param[in]  blob_threshold   The size in bytes above which the payloads of an object pool in a
+         *                          PersistentCascadeStore subgroup are written to blob segments instead of the log.
+         *                          0 for CASCADE/persistent_blob_threshold.
+         * @param[in]  ttl_ms           The time in milliseconds after which the objects of an object pool in a
+         *                          VolatileCascadeStore subgroup expire. 0 for never.
          *
          * @return a future to the version and timestamp of the put operation.
          */
@@ -1425,7 +2056,230 @@ namespace cascade {
                 const std::string& pathname, const uint32_t subgroup_index,
                 const sharding_policy_t sharding_policy = HASH,
                 const std::unordered_map<std::string,uint32_t>& object_locations = {},
-                const std::string& affinity_set_regex = "");
+                const std::string& affinity_set_regex = "",
+                const uint64_t memory_budget = 0,
+                const uint64_t blob_threshold = 0,
+                const uint64_t ttl_ms = 0);
+
+        /**
+         * Object Pool Management API: set the memory budget of an object pool in a shard of a VolatileCascadeStore
+         * subgroup. Objects are evicted when the object pool uses more memory than the budget in the shard.
+         *
+         * @tparam SubgroupType     Type of the subgroup, which must be a VolatileCascadeStore
+         * @param[in]  pathname         Object pool pathname
+         * @param[in]  memory_budget    The memory budget in bytes, 0 for unlimited.
+         * @param[in]  subgroup_index   Index of the subgroup
+         * @param[in]  shard_index      Index of the shard
+         *
+         * @return a future to the version and timestamp of the operation.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<version_tuple> set_memory_budget(
+                const std::string& pathname, const uint64_t memory_budget,
+                uint32_t subgroup_index, uint32_t shard_index);
+
+        /**
+         * Object Pool Management API: set the TTL of an object pool in a shard of a VolatileCascadeStore subgroup. An
+         * object expires `ttl_ms` milliseconds after its timestamp. Then get skips it, and the shard removes it in the
+         * background.
+         *
+         * @tparam SubgroupType     Type of the subgroup, which must be a VolatileCascadeStore
+         * @param[in]  pathname         Object pool pathname
+         * @param[in]  ttl_ms           The TTL in milliseconds, 0 for never.
+         * @param[in]  subgroup_index   Index of the subgroup
+         * @param[in]  shard_index      Index of the shard
+         *
+         * @return a future to the version and timestamp of the operation.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<version_tuple> set_ttl(
+                const std::string& pathname, const uint64_t ttl_ms,
+                uint32_t subgroup_index, uint32_t shard_index);
+
+    protected:
+        template <typename FirstType, typename SecondType, typename... RestTypes>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_set_ttl(
+                uint32_t type_index,
+                const std::string& pathname,
+                const uint64_t ttl_ms,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+        template <typename LastType>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_set_ttl(
+                uint32_t type_index,
+                const std::string& pathname,
+                const uint64_t ttl_ms,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+    public:
+        /**
+         * Object Pool Management API: set the TTL of an object pool in a VolatileCascadeStore subgroup, in all of its
+         * shards and in its metadata.
+         *
+         * @param[in]  pathname         Object pool pathname
+         * @param[in]  ttl_ms           The TTL in milliseconds, 0 for never.
+         *
+         * @return a future to the version and timestamp of the metadata update.
+         */
+        derecho::rpc::QueryResults<version_tuple> set_ttl(const std::string& pathname, const uint64_t ttl_ms);
+
+        /**
+         * Object Pool Management API: get the cache statistics of an object pool in a shard of a VolatileCascadeStore
+         * subgroup, including "budget", "used_bytes", "evictions", "hits", and "misses".
+         *
+         * @tparam SubgroupType     Type of the subgroup, which must be a VolatileCascadeStore
+         * @param[in]  pathname         Object pool pathname
+         * @param[in]  subgroup_index   Index of the subgroup
+         * @param[in]  shard_index      Index of the shard
+         *
+         * @return a future to the statistics, which is empty if the object pool has no memory budget.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<std::map<std::string,uint64_t>> get_cache_stats(
+                const std::string& pathname, uint32_t subgroup_index, uint32_t shard_index);
+
+        /**
+         * Get the statistics of the recovery of a replica in a shard of a PersistentCascadeStore subgroup from its
+         * snapshot and log, including "recovery_us", "snapshot_version", "snapshot_objects", "replayed_deltas", and
+         * "skipped_deltas".
+         *
+         * @tparam SubgroupType     Type of the subgroup, which must be a PersistentCascadeStore
+         * @param[in]  node_id          The replica, which must be a member of the shard
+         * @param[in]  subgroup_index   Index of the subgroup
+         * @param[in]  shard_index      Index of the shard
+         *
+         * @return a future to the statistics.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<std::map<std::string,uint64_t>> get_recovery_stats(
+                node_id_t node_id, uint32_t subgroup_index, uint32_t shard_index);
+
+        /**
+         * Get the memory used by the keys of a replica in a shard of a PersistentCascadeStore subgroup, in kv_map and
+         * in the per-key version index, including "keys", "prefixes", "key_bytes", "stored_key_bytes",
+         * "index_key_bytes", and the same bytes per key.
+         *
+         * @tparam SubgroupType     Type of the subgroup, which must be a PersistentCascadeStore
+         * @param[in]  node_id          The replica, which must be a member of the shard
+         * @param[in]  subgroup_index   Index of the subgroup
+         * @param[in]  shard_index      Index of the shard
+         *
+         * @return a future to the statistics.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<std::map<std::string,uint64_t>> get_key_memory_stats(
+                node_id_t node_id, uint32_t subgroup_index, uint32_t shard_index);
+
+        /**
+         * Object Pool Management API: set the log retention policy of an object pool in a PersistentCascadeStore
+         * subgroup. The log of each shard is trimmed in the background to the versions retained by the policies of
+         * its object pools, and a read of a trimmed version gets an object with version EXPIRED_VERSION.
+         *
+         * @param[in]  pathname         Object pool pathname
+         * @param[in]  log_retention    The log retention policy, where an all-zero policy keeps the whole log.
+         *
+         * @return a future to the version and timestamp of the metadata update.
+         */
+        derecho::rpc::QueryResults<version_tuple> set_log_retention(
+                const std::string& pathname, const LogRetentionPolicy& log_retention);
+
+        /**
+         * Object Pool Management API: apply the log retention policies of the object pools in a shard of a
+         * PersistentCascadeStore subgroup, which is called periodically by a shard member.
+         *
+         * @tparam SubgroupType     Type of the subgroup, which must be a PersistentCascadeStore
+         * @param[in]  policies         The log retention policies, keyed by the object pool pathnames.
+         * @param[in]  subgroup_index   Index of the subgroup
+         * @param[in]  shard_index      Index of the shard
+         *
+         * @return a future to the version and timestamp of the retention round.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<version_tuple> apply_retention(
+                const std::map<std::string,LogRetentionPolicy>& policies,
+                uint32_t subgroup_index, uint32_t shard_index);
+
+    protected:
+        template <typename FirstType, typename SecondType, typename... RestTypes>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_apply_retention(
+                uint32_t type_index,
+                const std::map<std::string,LogRetentionPolicy>& policies,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+        template <typename LastType>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_apply_retention(
+                uint32_t type_index,
+                const std::map<std::string,LogRetentionPolicy>& policies,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+    public:
+        /**
+         * Object Pool Management API: apply the log retention policies to a shard given by its subgroup type index.
+         *
+         * @param[in]  subgroup_type_index  Index of the subgroup type in CascadeTypes
+         * @param[in]  policies             The log retention policies, keyed by the object pool pathnames.
+         * @param[in]  subgroup_index       Index of the subgroup
+         * @param[in]  shard_index          Index of the shard
+         *
+         * @return a future to the version and timestamp of the retention round.
+         */
+        derecho::rpc::QueryResults<version_tuple> apply_retention(
+                uint32_t subgroup_type_index,
+                const std::map<std::string,LogRetentionPolicy>& policies,
+                uint32_t subgroup_index, uint32_t shard_index);
+
+        /**
+         * Object Pool Management API: set the blob thresholds of the object pools in a shard of a
+         * PersistentCascadeStore subgroup. The thresholds are logged by the shard, so they survive restarts and reach
+         * the joining members. They are set when an object pool is created, and set again by the first member of the
+         * shard only when they change.
+         *
+         * @tparam SubgroupType     Type of the subgroup, which must be a PersistentCascadeStore
+         * @param[in]  thresholds       The blob thresholds in bytes, keyed by the object pool pathnames.
+         * @param[in]  subgroup_index   Index of the subgroup
+         * @param[in]  shard_index      Index of the shard
+         *
+         * @return a future to the version and timestamp of the operation.
+         */
+        template <typename SubgroupType>
+        derecho::rpc::QueryResults<version_tuple> set_blob_thresholds(
+                const std::map<std::string,uint64_t>& thresholds,
+                uint32_t subgroup_index, uint32_t shard_index);
+
+    protected:
+        template <typename FirstType, typename SecondType, typename... RestTypes>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_set_blob_thresholds(
+                uint32_t type_index,
+                const std::map<std::string,uint64_t>& thresholds,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+        template <typename LastType>
+        derecho::rpc::QueryResults<version_tuple> type_recursive_set_blob_thresholds(
+                uint32_t type_index,
+                const std::map<std::string,uint64_t>& thresholds,
+                uint32_t subgroup_index,
+                uint32_t shard_index);
+
+    public:
+        /**
+         * Object Pool Management API: set the blob thresholds of a shard given by its subgroup type index.
+         *
+         * @param[in]  subgroup_type_index  Index of the subgroup type in CascadeTypes
+         * @param[in]  thresholds           The blob thresholds in bytes, keyed by the object pool pathnames.
+         * @param[in]  subgroup_index       Index of the subgroup
+         * @param[in]  shard_index          Index of the shard
+         *
+         * @return a future to the version and timestamp of the operation.
+         */
+        derecho::rpc::QueryResults<version_tuple> set_blob_thresholds(
+                uint32_t subgroup_type_index,
+                const std::map<std::string,uint64_t>& thresholds,
+                uint32_t subgroup_index, uint32_t shard_index);
 
         /**
          * ObjectPoolManagement API: remote object pool
@@ -1666,6 +2520,12 @@ namespace cascade {
          * Get the singleton ServiceClient API. If it does not exists, initialize it as an external client.
          */
         static ServiceClient& get_service_client();
+
+        /**
+         * Refresh the view of the singleton ServiceClient, if it has been initialized. This is registered as a view
+         * upcall of the cascade service.
+         */
+        static void refresh_singleton_view();
     }; // ServiceClient
 
 
@@ -1679,6 +2539,12 @@ namespace cascade {
     #define CASCADE_CONTEXT_CPU_CORES               "CASCADE/cpu_cores"
     #define CASCADE_CONTEXT_GPUS                    "CASCADE/gpus"
     #define CASCADE_CONTEXT_WORKER_CPU_AFFINITY     "CASCADE/worker_cpu_affinity"
+    /**
+     * The interval in seconds between the log retention rounds, where the first member of each shard applies the log
+     * retention policies of its object pools, and sets their blob thresholds if they changed. 0 disables log retention.
+     */
+    #define CASCADE_CONTEXT_LOG_RETENTION_INTERVAL  "CASCADE/log_retention_interval_sec"
+    #define CASCADE_CONTEXT_LOG_RETENTION_INTERVAL_DEFAULT  (60)
 
     /**
      * A class describing the resources available in the Cascade context.
@@ -1799,6 +2665,10 @@ namespace cascade {
         std::vector<std::thread> stateful_workhorses_for_p2p;
         std::thread              single_threaded_workhorse_for_multicast;
         std::thread              single_threaded_workhorse_for_p2p;
+        /** the log retention thread, woken up by destroy() */
+        std::thread              log_retention_thread;
+        std::mutex               log_retention_mutex;
+        std::condition_variable  log_retention_cv;
         /**
          * destroy the context, to be called in destructor
          */
@@ -1809,6 +2679,12 @@ namespace cascade {
          * @param[in] _2 The action queue
          */
         void workhorse(uint32_t,struct action_queue&);
+        /**
+         * log retention worker, which applies the log retention policies of the object pools to the shards led by
+         * this node periodically.
+         * @param[in] interval_sec  The interval between the rounds in seconds
+         */
+        void log_retention_worker(uint32_t interval_sec);
 
     public:
         /** Resources **/
@@ -2,6 +2,10 @@
 #include "service_types.hpp"
 #include "service.hpp"
 
+#include <deque>
+#include <iterator>
+#include <memory>
+
 #ifdef HAS_BOOLINQ
 #include <boolinq/boolinq.h>
 #endif
@@ -11,7 +15,138 @@ namespace cascade {
 /**
  * The client API
  */
-using ServiceClientAPI = ServiceClient<VolatileCascadeStoreWithStringKey, PersistentCascadeStoreWithStringKey, TriggerCascadeNoStoreWithStringKey>;
+using ServiceClientAPI = ServiceClient<CASCADE_SUBGROUP_TYPE_LIST>;
+
+/**
+ * The default number of keys in a page of CascadeKeyPager.
+ */
+#define CASCADE_KEY_PAGER_PAGE_SIZE_DEFAULT (4096)
+
+/**
+ * CascadeKeyPager lists the keys of all shards of a subgroup page by page with list_keys_paged, so that the client
+ * holds at most two pages per shard. The first pages of all shards are requested at once, and the next page of a
+ * shard is requested as soon as its current page arrives, so the shards are listed in parallel and a page is in
+ * flight while the caller consumes the previous one.
+ *
+ * The keys of a shard are returned in key order, and the pages of the shards are interleaved.
+ */
+template <typename CascadeType, typename ServiceClientType>
+class CascadeKeyPager {
+private:
+    using KeyType = typename CascadeType::KeyType;
+    using PageFuture = derecho::rpc::QueryResults<key_page_t<KeyType>>;
+
+    struct ShardListing {
+        uint32_t shard_index;
+        /* the page in flight, or nullptr if the listing of the shard is done */
+        std::unique_ptr<PageFuture> pending_page;
+    };
+
+    ServiceClientType& capi;
+    const uint32_t subgroup_index;
+    const std::string prefix;
+    const uint32_t page_size;
+    std::vector<ShardListing> shards;
+    /* the shard whose page is waited for next, in round robin */
+    std::size_t next_shard;
+    std::deque<KeyType> keys;
+
+    void request_page(ShardListing& shard, const std::string& cursor) {
+        shard.pending_page = std::make_unique<PageFuture>(
+                capi.template list_keys_paged<CascadeType>(prefix, cursor, page_size, subgroup_index, shard.shard_index));
+    }
+
+    /**
+     * Wait for the page in flight of the next shard, and request the page after it.
+     *
+     * @return false if all shards are listed.
+     */
+    bool fetch_page() {
+        for(std::size_t i = 0; i < shards.size(); i++) {
+            ShardListing& shard = shards[(next_shard + i) % shards.size()];
+            if(!shard.pending_page) {
+                continue;
+            }
+            next_shard = (next_shard + i + 1) % shards.size();
+            key_page_t<KeyType> page;
+            for(auto& reply_future : shard.pending_page->get()) {
+                page = reply_future.second.get();
+                break;
+            }
+            std::vector<KeyType>& page_keys = std::get<0>(page);
+            const std::string& cursor = std::get<1>(page);
+            if(cursor.empty()) {
+                shard.pending_page.reset();
+            } else {
+                request_page(shard, cursor);
+            }
+            std::move(page_keys.begin(), page_keys.end(), std::back_inserter(keys));
+            return true;
+        }
+        return false;
+    }
+
+public:
+    /**
+     * Start listing the keys of a subgroup.
+     *
+     * @param _capi             The cascade client.
+     * @param _subgroup_index   The subgroup index of CascadeType.
+     * @param _prefix           The key prefix, empty for all keys.
+     * @param _page_size        The number of keys requested in a page.
+     */
+    CascadeKeyPager(ServiceClientType& _capi, uint32_t _subgroup_index, const std::string& _prefix = "",
+                    uint32_t _page_size = CASCADE_KEY_PAGER_PAGE_SIZE_DEFAULT) :
+        capi(_capi),
+        subgroup_index(_subgroup_index),
+        prefix(_prefix),
+        page_size(_page_size),
+        next_shard(0) {
+        const uint32_t num_shards = capi.template get_number_of_shards<CascadeType>(subgroup_index);
+        shards.resize(num_shards);
+        for(uint32_t shard_index = 0; shard_index < num_shards; shard_index++) {
+            shards[shard_index].shard_index = shard_index;
+            request_page(shards[shard_index], "");
+        }
+    }
+
+    /**
+     * Get the next key.
+     *
+     * @param key   The key.
+     *
+     * @return false if all keys are listed.
+     */
+    bool next(KeyType& key) {
+        while(keys.empty()) {
+            if(!fetch_page()) {
+                return false;
+            }
+        }
+        key = std::move(keys.front());
+        keys.pop_front();
+        return true;
+    }
+
+    /**
+     * Get the next page of keys, or the rest of the current page if next() has taken some of it.
+     *
+     * @param page  The keys.
+     *
+     * @return false if all keys are listed.
+     */
+    bool next_page(std::vector<KeyType>& page) {
+        page.clear();
+        while(keys.empty()) {
+            if(!fetch_page()) {
+                return false;
+            }
+        }
+        std::move(keys.begin(), keys.end(), std::back_inserter(page));
+        keys.clear();
+        return true;
+    }
+};
 
 /**
  * Create Linq iterators on keys or versions of keys
@@ -126,9 +261,71 @@ CascadeShardLinq<CascadeType,ServiceClientType> from_shard_by_time (
         });
 }
 
+template <typename CascadeType>
+using CascadeScanLinqStorageType = std::pair<typename std::vector<typename CascadeType::ObjectType>::iterator, typename std::vector<typename CascadeType::ObjectType>::iterator>;
+
+/**
+ * Create a Linq iterating the latest objects in a shard selected by a scan. Unlike from_shard(...).where(...), the
+ * filter and the projection run on the shard member, and only the matching objects are fetched, a page at a time.
+ * @param object_list   This is an output argument to keep the scanned objects. Please keep it alive throughout the
+ *                      life time of the Linq object.
+ * @param capi          The cascade client.
+ * @param subgroup_index
+ * @param shard_index
+ * @param prefix        The key prefix.
+ * @param filter        The filter expression, see ScanFilter.
+ * @param projection    The projection expression, see ScanProjection.
+ * @return a Linq object
+ */
+template <typename CascadeType, typename ServiceClientType>
+boolinq::Linq<CascadeScanLinqStorageType<CascadeType>,typename CascadeType::ObjectType> from_shard_scan(
+        std::vector<typename CascadeType::ObjectType>& object_list,
+        ServiceClientType& capi, uint32_t subgroup_index, uint32_t shard_index,
+        const std::string& prefix, const std::string& filter, const std::string& projection = "") {
+    /* load objects. */
+    object_list.clear();
+    std::string cursor;
+    do {
+        auto result = capi.template scan<CascadeType>(prefix, filter, projection, cursor, 0, subgroup_index, shard_index);
+        scan_page_t<typename CascadeType::ObjectType> page;
+        for(auto& reply_future:result.get()) {
+            page = reply_future.second.get();
+            break;
+        }
+        auto& page_objects = std::get<0>(page);
+        std::move(page_objects.begin(), page_objects.end(), std::back_inserter(object_list));
+        cursor = std::move(std::get<1>(page));
+    } while(!cursor.empty());
+    return boolinq::Linq<CascadeScanLinqStorageType<CascadeType>,typename CascadeType::ObjectType>(
+        std::make_pair(object_list.begin(),object_list.end()),
+        [](CascadeScanLinqStorageType<CascadeType>& _storage) {
+            if (_storage.first == _storage.second) {
+                throw boolinq::LinqEndException();
+            }
+            return *(_storage.first++);
+        });
+}
+
+/**
+ * The maximum number of objects a version linq fetches in one get_versions call, which also stops at the P2P reply
+ * size.
+ */
+#define CASCADE_VERSION_LINQ_BATCH_DEFAULT  (256)
+
+/**
+ * The storage of a version linq: the version to fetch from, which is CURRENT_VERSION for the latest one, the objects
+ * fetched but not yet iterated, and if the versions in the range are all fetched.
+ */
+template <typename CascadeType>
+struct CascadeVersionLinqStorageType {
+    persistent::version_t next_version;
+    std::deque<typename CascadeType::ObjectType> batch;
+    bool exhausted;
+};
+
 /* A version linq iterates the versions of a Key*/
 template <typename CascadeType, typename ServiceClientType>
-class CascadeVersionLinq : public boolinq::Linq<persistent::version_t, typename CascadeType::ObjectType> {
+class CascadeVersionLinq : public boolinq::Linq<CascadeVersionLinqStorageType<CascadeType>, typename CascadeType::ObjectType> {
 private:
     ServiceClientType& client_api;
     uint32_t subgroup_index;
@@ -137,16 +334,17 @@ private:
     persistent::version_t version;
 
 public:
-    CascadeVersionLinq() : boolinq::Linq<persistent::version_t,typename CascadeType::ObjectType>() {};
+    CascadeVersionLinq() : boolinq::Linq<CascadeVersionLinqStorageType<CascadeType>,typename CascadeType::ObjectType>() {};
     
     CascadeVersionLinq(ServiceClientType& capi, 
         uint32_t sgidx, 
         uint32_t shidx, 
         const typename CascadeType::KeyType& objkey, 
         persistent::version_t ver,
-                       std::function<typename CascadeType::ObjectType(persistent::version_t&)> nextFunc) :
+                       std::function<typename CascadeType::ObjectType(CascadeVersionLinqStorageType<CascadeType>&)> nextFunc) :
 
-        boolinq::Linq<persistent::version_t, typename CascadeType::ObjectType>(ver, nextFunc),
+        boolinq::Linq<CascadeVersionLinqStorageType<CascadeType>, typename CascadeType::ObjectType>(
+                CascadeVersionLinqStorageType<CascadeType>{ver,{},false}, nextFunc),
         client_api(capi),
      subgroup_index(sgidx),
         shard_index(shidx),
@@ -155,37 +353,66 @@ public:
 };
 
 /**
- * Create a Linq iterating the objects of a key for given versions.
+ * Create a Linq iterating the objects of a key for given versions, from the latest backward. With a
+ * PersistentCascadeStore, the objects are fetched in pages of at most `batch_size` by get_versions, which walks the
+ * version chain on the server and ends a page before the reply exceeds the P2P reply size; otherwise, each version is
+ * fetched by a get.
  * @param key       The key to iterate over
  * @param capi      The cascade client.
  * @param subgroup_index
  * @param shard_index
- * @param version   The start version going backward: TODO: this should be a pair for version range.
+ * @param version   The start version going backward.
+ * @param ver_begin The earliest version to iterate, or INVALID_VERSION to iterate to the first version of the key.
+ * @param batch_size The maximum number of objects fetched in one get_versions call.
  * @return a Linq object
  */
 template <typename CascadeType, typename ServiceClientType>
 CascadeVersionLinq<CascadeType,ServiceClientType> from_versions(
     const typename CascadeType::KeyType& key, 
  ServiceClientType &capi, uint32_t subgroup_index,
-    uint32_t shard_index, persistent::version_t version) {
+    uint32_t shard_index, persistent::version_t version,
+    persistent::version_t ver_begin = INVALID_VERSION,
+    uint32_t batch_size = CASCADE_VERSION_LINQ_BATCH_DEFAULT) {
 
  return CascadeVersionLinq<CascadeType,ServiceClientType>(capi,subgroup_index,shard_index,key,version,
-     [&capi,&key,subgroup_index,shard_index](persistent::version_t& ver) {
-   if (ver == INVALID_VERSION) {
-       throw boolinq::LinqEndException();
-   }
-  
-            do {
-                auto result = capi.template get<CascadeType>(key,ver,true/*always use stable data*/,subgroup_index,shard_index);
-                for (auto& reply_future:result.get()) {
-                    auto object = reply_future.second.get();
-                    ver = object.previous_version_by_key; 
-                    if (!object.is_null())
-                        return object;
+     [&capi,&key,subgroup_index,shard_index,ver_begin,batch_size](CascadeVersionLinqStorageType<CascadeType>& storage) {
+            while (storage.batch.empty()) {
+                if (storage.exhausted) {
+                    throw boolinq::LinqEndException();
                 }
-            } while (ver != INVALID_VERSION);
-
-            throw boolinq::LinqEndException();
+                if constexpr (is_persistent_cascade_store<CascadeType>::value) {
+                    auto result = capi.template get_versions<CascadeType>(key,ver_begin,storage.next_version,batch_size,subgroup_index,shard_index);
+                    storage.exhausted = true;
+                    for (auto& reply_future:result.get()) {
+                        auto page = reply_future.second.get();
+                        auto& objects = std::get<0>(page);
+                        // the server tells where the next page starts.
+                        storage.next_version = std::get<1>(page);
+                        storage.exhausted = (storage.next_version == INVALID_VERSION);
+                        for (auto& object:objects) {
+                            if (!object.is_null()) {
+                                storage.batch.emplace_back(std::move(object));
+                            }
+                        }
+                    }
+                } else {
+                    auto result = capi.template get<CascadeType>(key,storage.next_version,true/*always use stable data*/,subgroup_index,shard_index);
+                    storage.exhausted = true;
+                    for (auto& reply_future:result.get()) {
+                        auto object = reply_future.second.get();
+                        storage.next_version = object.previous_version_by_key;
+                        storage.exhausted = (storage.next_version == INVALID_VERSION);
+                        if (ver_begin != INVALID_VERSION && object.version < ver_begin) {
+                            storage.exhausted = true;
+                        } else if (!object.is_null()) {
+                            storage.batch.emplace_back(std::move(object));
+                        }
+                    }
+                }
+            }
+            auto object = std::move(storage.batch.front());
+            storage.batch.pop_front();
+            return object;
      });
 }
 
@@ -12,11 +12,19 @@
 #define CONF_VCS_STRINGKEY_LAYOUT "CASCADE/VOLATILECASCADESTORE/STRING/layout"
 #define CONF_PCS_UINT64KEY_LAYOUT "CASCADE/PERSISTENTCASCADESTORE/UINT64/layout"
 #define CONF_PCS_STRINGKEY_LAYOUT "CASCADE/PERSISTENTCASCADESTORE/STRING/layout"
+#define CONF_VCCS_UINT64KEY_LAYOUT "CASCADE/VOLATILECOMPACTCASCADESTORE/UINT64/layout"
+#define CONF_PCCS_UINT64KEY_LAYOUT "CASCADE/PERSISTENTCOMPACTCASCADESTORE/UINT64/layout"
 
+/**
+ * The subgroup types of the cascade service, in the order of the entries of the json layout. The compact stores come
+ * last, so that their entries can be left out of a layout, see subgroup_layout_conf_key().
+ */
 #define CASCADE_SUBGROUP_TYPE_LIST  \
     VolatileCascadeStoreWithStringKey, \
     PersistentCascadeStoreWithStringKey, \
-    TriggerCascadeNoStoreWithStringKey
+    TriggerCascadeNoStoreWithStringKey, \
+    VolatileCompactCascadeStoreWithUInt64Key, \
+    PersistentCompactCascadeStoreWithUInt64Key
                                     
 
 namespace derecho {
@@ -40,6 +48,32 @@ using TriggerCascadeNoStoreWithStringKey = TriggerCascadeNoStore<
                                                 ObjectWithStringKey,
                                                 &ObjectWithStringKey::IK,
                                                 &ObjectWithStringKey::IV>;
+/**
+ * The compact stores for numeric keys. Object pools need string keys, so they are accessed with the ServiceClient APIs
+ * taking a subgroup type, index and shard. Their layouts are read from CONF_VCCS_UINT64KEY_LAYOUT and
+ * CONF_PCCS_UINT64KEY_LAYOUT if the json layout has no entries for them.
+ */
+using VolatileCompactCascadeStoreWithUInt64Key = VolatileCompactCascadeStore<
+                                                uint64_t,
+                                                ObjectWithUInt64Key,
+                                                &ObjectWithUInt64Key::IK,
+                                                &ObjectWithUInt64Key::IV>;
+using PersistentCompactCascadeStoreWithUInt64Key = PersistentCompactCascadeStore<
+                                                uint64_t,
+                                                ObjectWithUInt64Key,
+                                                &ObjectWithUInt64Key::IK,
+                                                &ObjectWithUInt64Key::IV,ST_FILE>;
+using PCSU = PersistentCompactCascadeStoreWithUInt64Key;
+
+template <>
+inline const char* subgroup_layout_conf_key<VolatileCompactCascadeStoreWithUInt64Key>() {
+    return CONF_VCCS_UINT64KEY_LAYOUT;
+}
+
+template <>
+inline const char* subgroup_layout_conf_key<PersistentCompactCascadeStoreWithUInt64Key>() {
+    return CONF_PCCS_UINT64KEY_LAYOUT;
+}
 
 using DefaultServiceType = Service<CASCADE_SUBGROUP_TYPE_LIST>;
 
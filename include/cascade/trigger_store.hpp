@@ -38,19 +38,25 @@ public:
                                              P2P_TARGETS(
                                                      put,
                                                      put_and_forget,
+                                                     put_batch,
 #ifdef ENABLE_EVALUATION
                                                      perf_put,
 #endif
                                                      remove,
                                                      get,
+                                                     get_range,
                                                      multi_get,
                                                      get_by_time,
                                                      multi_list_keys,
                                                      list_keys,
                                                      list_keys_by_time,
+                                                     list_keys_paged,
+                                                     scan,
                                                      multi_get_size,
                                                      get_size,
                                                      get_size_by_time,
+                                                     head,
+                                                     head_batch,
                                                      trigger_put
 #ifdef ENABLE_EVALUATION
                                                      ,
@@ -64,6 +70,7 @@ public:
                                              ORDERED_TARGETS(
                                                      ordered_put,
                                                      ordered_put_and_forget,
+                                                     ordered_put_batch,
                                                      ordered_remove,
                                                      ordered_get,
                                                      ordered_list_keys,
@@ -82,21 +89,31 @@ public:
     virtual void trigger_put(const VT& value) const override;
     virtual version_tuple put(const VT& value, bool as_trigger) const override;
     virtual void put_and_forget(const VT& value, bool as_trigger) const override;
+    virtual version_tuple put_batch(const std::vector<VT>& values, bool as_trigger) const override;
 #ifdef ENABLE_EVALUATION
     virtual double perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const override;
 #endif  // ENABLE_EVALUATION
     virtual version_tuple remove(const KT& key) const override;
     virtual const VT get(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
+    virtual const VT get_range(const KT& key, const persistent::version_t& ver, const bool stable,
+                               const uint64_t& offset, const uint64_t& length) const override;
     virtual const VT multi_get(const KT& key) const override;
     virtual const VT get_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
     virtual std::vector<KT> multi_list_keys(const std::string& prefix) const override;
     virtual std::vector<KT> list_keys(const std::string& prefix, const persistent::version_t& ver, const bool stable) const override;
     virtual std::vector<KT> list_keys_by_time(const std::string& prefix, const uint64_t& ts_us, const bool stable) const override;
+    virtual key_page_t<KT> list_keys_paged(const std::string& prefix, const std::string& cursor, const uint32_t& limit) const override;
+    virtual scan_page_t<VT> scan(const std::string& prefix, const std::string& filter, const std::string& projection,
+                                 const std::string& cursor, const uint32_t& max_results) const override;
     virtual uint64_t multi_get_size(const KT& key) const override;
     virtual uint64_t get_size(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
     virtual uint64_t get_size_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
+    virtual ObjectHead head(const KT& key, const persistent::version_t& ver, const bool stable) const override;
+    virtual std::vector<ObjectHead> head_batch(const std::vector<KT>& keys, const persistent::version_t& ver,
+                                               const bool stable) const override;
     virtual version_tuple ordered_put(const VT& value, bool as_trigger) override;
     virtual void ordered_put_and_forget(const VT& value, bool as_trigger) override;
+    virtual version_tuple ordered_put_batch(const std::vector<VT>& values, bool as_trigger) override;
     virtual version_tuple ordered_remove(const KT& key) override;
     virtual const VT ordered_get(const KT& key) override;
     virtual std::vector<KT> ordered_list_keys(const std::string& prefix) override;
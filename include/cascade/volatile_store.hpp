@@ -2,6 +2,15 @@
 
 #include "cascade/config.h"
 #include "cascade_interface.hpp"
+#include "merge_operator.hpp"
+#include "detail/concurrent_index.hpp"
+#include "detail/key_page_cursor.hpp"
+#include "detail/key_value_map.hpp"
+#include "detail/message_limits.hpp"
+#include "detail/object_head.hpp"
+#include "detail/payload_range.hpp"
+#include "detail/scan_object.hpp"
+#include "detail/timing_wheel.hpp"
 
 #include <derecho/core/derecho.hpp>
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
@@ -9,10 +18,94 @@
 
 #include <map>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace derecho {
 namespace cascade {
+
+/**
+ * The number of versions a removed key is kept as a tombstone (a null object) before it is purged from the
+ * VolatileCascadeStore, counted by the sequence numbers of the versions. A tombstone from an earlier view is kept
+ * for this many versions of the current view. Tombstones are purged on the ordered path, so this value MUST be the
+ * same on all members.
+ */
+#define CASCADE_VOLATILE_TOMBSTONE_GC_DELAY     "CASCADE/volatile_tombstone_gc_delay"
+#define CASCADE_VOLATILE_TOMBSTONE_GC_DELAY_DEFAULT (1024)
+/**
+ * The maximum number of tombstones purged in a single ordered operation. 0 disables tombstone garbage collection.
+ */
+#define CASCADE_VOLATILE_TOMBSTONE_GC_BATCH     "CASCADE/volatile_tombstone_gc_batch"
+#define CASCADE_VOLATILE_TOMBSTONE_GC_BATCH_DEFAULT (64)
+/**
+ * The state of a VolatileCascadeStore larger than this many bytes is streamed to a joining member after the view change,
+ * instead of being sent as a whole in the view change. A chunk of the stream is at most this size and fits in a P2P
+ * reply (DERECHO/max_p2p_reply_payload_size); an object larger than a chunk is fetched in pieces. Only VT implementing
+ * ISharePayload, IPatchPayload and IKeepVersion is streamed. 0 always sends the whole state.
+ */
+#define CASCADE_VOLATILE_STATE_TRANSFER_CHUNK   "CASCADE/volatile_state_transfer_chunk_bytes"
+#define CASCADE_VOLATILE_STATE_TRANSFER_CHUNK_DEFAULT (16ull << 20)
+/**
+ * The tick in milliseconds of the timing wheel expiring the objects of the object pools with a TTL. An object is
+ * removed at most about one tick after it expires, and P2P get skips it in between.
+ */
+#define CASCADE_VOLATILE_TTL_TICK               "CASCADE/volatile_ttl_tick_ms"
+#define CASCADE_VOLATILE_TTL_TICK_DEFAULT       (100)
+/**
+ * The maximum number of keys removed by a single ordered expiration.
+ */
+#define CASCADE_VOLATILE_TTL_BATCH              "CASCADE/volatile_ttl_batch"
+#define CASCADE_VOLATILE_TTL_BATCH_DEFAULT      (1024)
+
+/**
+ * The cache state of an object pool with a memory budget in a VolatileCascadeStore.
+ *
+ * When the objects of the pool take more memory than the budget, the store evicts objects with the CLOCK policy. The
+ * clock hand sweeps the keys of the pool in key order, and a key referenced since the hand passed it last time gets a
+ * second chance. The reference bit is kept in the stored key in kv_map, see InternedPathname::set_mark(). The state is
+ * only updated on the ordered path, and it is part of the state transferred to new members, so all members evict the
+ * same keys at the same version.
+ *
+ * The policy follows the recency of ordered operations only: a key is referenced when it is written or read by
+ * ordered_get. P2P gets do not reference keys, because they are served by a single member and are not seen by the
+ * others. So an object that is only read by P2P gets is evicted as if it was never read since it was written; a client
+ * that needs such an object to stay cached refreshes it with ordered_get.
+ *
+ * @tparam KT   - the key type
+ */
+template <typename KT>
+class VolatilePoolCache : public mutils::ByteRepresentable {
+public:
+    /* the memory budget in bytes */
+    uint64_t budget;
+    /* the number of evicted objects */
+    uint64_t evictions;
+    /* the last key visited by the clock hand */
+    KT hand;
+    /* the serialized size of the objects in the pool, which is recomputed from kv_map after state transfer */
+    uint64_t used_bytes;
+
+    DEFAULT_SERIALIZATION_SUPPORT(VolatilePoolCache, budget, evictions, hand);
+
+    VolatilePoolCache(uint64_t _budget = 0,
+                      uint64_t _evictions = 0,
+                      const KT& _hand = KT{}) : budget(_budget),
+                                                evictions(_evictions),
+                                                hand(_hand),
+                                                used_bytes(0) {}
+};
+
 /**
  * template volatile cascade stores.
  *
@@ -25,18 +118,346 @@ class VolatileCascadeStore : public ICascadeStore<KT, VT, IK, IV>,
                              public derecho::GroupReference,
                              public derecho::NotificationSupport {
 private:
+    using pool_cache_map_t = std::map<std::string, VolatilePoolCache<KT>>;
+
     bool internal_ordered_put(const VT& value, bool as_trigger);
-#if defined(__i386__) || defined(__x86_64__) || defined(_M_AMD64) || defined(_M_IX86)
-    mutable std::atomic<persistent::version_t> lockless_v1;
-    mutable std::atomic<persistent::version_t> lockless_v2;
-#else
-#error The lockless reader/writer works only with TSO memory reordering. Please check https://en.wikipedia.org/wiki/Memory_ordering
-#endif
+    /**
+     * Apply a batch of objects under the current version. The batch is verified as a whole before any object is
+     * applied, so a rejected batch leaves kv_map unchanged.
+     *
+     * @return false if the batch is rejected.
+     */
+    bool internal_ordered_put_batch(const std::vector<VT>& values, bool as_trigger);
+    /**
+     * Replace the object of a key in kv_map and publish it to the lockless readers. The old map node is retired to
+     * kv_index so that concurrent readers holding a pointer to it stay safe. Only called from the ordered path.
+     *
+     * @param key       The key
+     * @param value     The new object
+     */
+    void update_kv_map(const KT& key, const VT& value);
+    /**
+     * Drop a key from kv_map and kv_index. The map node is retired to kv_index. Only called from the ordered path.
+     *
+     * @param key       The key
+     */
+    void erase_from_kv_map(const KT& key);
+    /**
+     * Rebuild kv_index and the tombstone queue from kv_map, used after kv_map is constructed.
+     */
+    void rebuild_kv_index();
+    /**
+     * The age of a tombstone in versions, compared with `tombstone_gc_delay`. A version carries the view id in its high
+     * 32 bits and the sequence number in the view in its low 32 bits, so a raw difference across a view change is huge.
+     * Only the sequence numbers are compared: within a view the age is their difference, and a tombstone from an
+     * earlier view is as old as the versions delivered in the current view, since the versions delivered after it in
+     * its own view are unknown.
+     *
+     * @param removal_version   The version of the removal
+     * @param current_version   The current version
+     *
+     * @return the age, which is the same on all members.
+     */
+    static uint64_t tombstone_age(persistent::version_t removal_version, persistent::version_t current_version);
+    /**
+     * Purge the tombstones removed at least `tombstone_gc_delay` versions before `current_version`, at most
+     * `tombstone_gc_batch` of them. Only called from the ordered path. Since every member delivers the same sequence of
+     * versions, all members purge the same tombstones at the same version and kv_map stays identical on all of them.
+     *
+     * @param current_version   The version of the ordered operation being delivered.
+     */
+    void collect_tombstones(persistent::version_t current_version);
+    /**
+     * Find the cache state of the object pool a key belongs to.
+     *
+     * @param key       The key
+     *
+     * @return the iterator to the cache state in pool_caches, or pool_caches.end() if the object pool of the key has no
+     *         memory budget.
+     */
+    typename pool_cache_map_t::iterator find_pool_cache(const KT& key);
+    /**
+     * Compute the memory used by the objects of an object pool by scanning kv_map.
+     *
+     * @param pathname  The object pool pathname
+     */
+    uint64_t compute_pool_bytes(const std::string& pathname) const;
+    /**
+     * Evict objects with the CLOCK policy until the object pool fits in its budget. Only called from the ordered path.
+     *
+     * @param pool_cache_it The iterator to the cache state of the object pool in pool_caches
+     */
+    void evict_from_pool(typename pool_cache_map_t::iterator pool_cache_it);
+    /**
+     * Recompute the memory usage of the object pools with a memory budget, used after state transfer.
+     */
+    void rebuild_pool_caches();
+    /**
+     * The CLOCK reference bit of a key in kv_map, kept in the stored key. Only pathname keys, stored as
+     * InternedPathname, carry it; other keys are never referenced.
+     */
+    static bool is_referenced(const stored_key_t<KT>& key);
+    static void set_referenced(const stored_key_t<KT>& key, bool referenced);
+    /**
+     * @return the keys in kv_map with the reference bit set, which are sent with the state to new members.
+     */
+    std::vector<KT> get_referenced_keys() const;
+    /**
+     * Get the TTL of the object pool of a key.
+     *
+     * @param key       The key
+     * @param ttls      The TTLs in milliseconds of the object pools, see pool_ttls
+     *
+     * @return the TTL in microseconds, or 0 if the object pool of the key has no TTL.
+     */
+    static uint64_t find_ttl_us(const KT& key, const std::map<std::string, uint64_t>& ttls);
+    /**
+     * Get the time at which an object expires.
+     *
+     * @param value     The object
+     * @param ttls      The TTLs in milliseconds of the object pools, see pool_ttls
+     *
+     * @return the expiration time in microseconds, or 0 if the object does not expire.
+     */
+    static uint64_t get_expiration_us(const VT& value, const std::map<std::string, uint64_t>& ttls);
+    /**
+     * Test if an object expired, for the P2P readers.
+     *
+     * @param value     The object
+     *
+     * @return true if the object expired by the local clock, but may not be removed yet.
+     */
+    bool is_expired(const VT& value) const;
+    /**
+     * Put an object in the timing wheel if it expires. Called from the ordered path for every object written to kv_map.
+     *
+     * @param key       The key
+     * @param value     The object
+     */
+    void schedule_expiration(const KT& key, const VT& value);
+    /**
+     * Put all objects in the timing wheel again, used after state transfer.
+     */
+    void rebuild_expiration_wheel();
+    /**
+     * Start the expiration worker if it is not running.
+     */
+    void start_expiration_worker();
+    /**
+     * The expiration worker advances the timing wheel every tick. The first member of the shard removes the expired
+     * keys with ordered_expire. The other members keep the keys in the wheel until the removal is delivered, so they
+     * take over if the first member fails.
+     */
+    void expiration_worker();
+    /* lockless hash and prefix index for P2P readers, pointing into the nodes of kv_map */
+    ConcurrentKeyIndex<KT, VT> kv_index;
+    /* tombstones in removal order as (removal version, key). An entry is stale if the key was updated since then. */
+    std::deque<std::pair<persistent::version_t, KT>> tombstones;
+    /* tombstone garbage collection settings */
+    uint64_t tombstone_gc_delay;
+    uint32_t tombstone_gc_batch;
+    /* the state size above which the state is streamed, see CASCADE_VOLATILE_STATE_TRANSFER_CHUNK */
+    uint64_t state_transfer_chunk_bytes;
+    /* true if any object pool has a memory budget, read by P2P readers to decide if they count cache hits and misses */
+    std::atomic<bool> cache_enabled;
+    /* cache hits and misses seen by P2P get on this member */
+    mutable std::atomic<uint64_t> cache_hits;
+    mutable std::atomic<uint64_t> cache_misses;
+    /* the TTL in milliseconds of the object pools with one, keyed by object pool pathname. It is only replaced by the
+     * ordered path, as a whole, so that P2P readers load it with std::atomic_load without a lock. */
+    std::shared_ptr<const std::map<std::string, uint64_t>> pool_ttls;
+    /* expiration settings, see CASCADE_VOLATILE_TTL_TICK and CASCADE_VOLATILE_TTL_BATCH */
+    uint64_t ttl_tick_us;
+    uint32_t ttl_batch;
+    /* the keys to expire as (key, expiration time in us), at the tick of the expiration time. An entry is stale if the
+     * key was updated since then. */
+    TimingWheel<std::pair<KT, uint64_t>> expiration_wheel;
+    std::mutex expiration_mutex;
+    std::condition_variable expiration_cv;
+    bool expiration_stopping;
+    std::thread expiration_thread;
+
+    /*
+     * Chunked state transfer
+     *
+     * When a member joins, the member sending the state copies kv_map at the cut of the view change, pinning the
+     * payloads instead of copying them, and sends only an id of the copy in the view change. The joining member
+     * streams the copy in chunks that fit in a P2P reply, fetching an object larger than a chunk in pieces, while it
+     * delivers the updates after the cut. An update after the cut marks its key as touched, and the stream skips the
+     * touched keys, so the state converges to the one of the other members. Until the stream finishes, an ordered
+     * operation on a key that has not arrived waits for it to be fetched on demand, and P2P reads of such keys fail, so
+     * the member serves requests for the keys it has caught up with. The whole state is sent in the view change if an
+     * object pool has a memory budget, because evictions depend on all keys of the pool, or if VT can not share and
+     * slice its payload.
+     *
+     * A failed request is retried. If the sender keeps failing, or has dropped the copy, the joining member streams the
+     * rest from the live state of another shard member instead, with transfer id 0. A live chunk may be newer than the
+     * state of the joining member, so it is installed only after the joining member has delivered every operation the
+     * chunk reflects, i.e. the version of the chunk; until then an untouched key still has its value at the cut on the
+     * other member. If no member can serve a state it can install after STATE_TRANSFER_ROUNDS rounds with backoff,
+     * the transfer fails without stopping the process: the keys streamed so far are served, the others stay
+     * unavailable, and the ordered operations on them fail with a derecho::derecho_exception until the member is
+     * restarted.
+     */
+    /* true if VT can share and slice its payload, which the stream requires */
+    static constexpr bool state_streamable = std::is_base_of<ISharePayload, VT>::value
+                                             && std::is_base_of<IPatchPayload, VT>::value
+                                             && std::is_base_of<IKeepVersion, VT>::value;
+    /* the state of the stream as (objects, the next key whose object is larger than a chunk if any, version). The
+     * version is the last operation the state reflects. */
+    using state_chunk_t = std::tuple<std::vector<VT>, std::vector<KT>, persistent::version_t>;
+    /* a piece of an object as (the object with a range of its payload, the payload size, version), see state_chunk_t.
+     * The object is *IV if the key is absent. */
+    using state_piece_t = std::tuple<VT, uint64_t, persistent::version_t>;
+    /* the copy of kv_map sent to the joining members */
+    struct OutgoingTransfer {
+        std::shared_ptr<const key_value_map_t<KT, VT>> snapshot;
+        persistent::version_t version;
+        std::chrono::steady_clock::time_point last_access;
+    };
+    /* the copies of kv_map being sent, by transfer id, dropped when the joining member finishes or stops asking */
+    mutable std::map<uint64_t, OutgoingTransfer> outgoing_transfers;
+    mutable uint64_t next_transfer_id;
+    mutable std::mutex outgoing_transfers_mutex;
+    static constexpr std::chrono::minutes OUTGOING_TRANSFER_IDLE_TIMEOUT{10};
+    /* the attempts of a request to a member before the joining member turns to another one */
+    static constexpr uint32_t STATE_TRANSFER_ATTEMPTS = 3;
+    static constexpr std::chrono::milliseconds STATE_TRANSFER_RETRY_DELAY{200};
+    /* the rounds over the shard members, backing off between them, before the joining member gives up the state */
+    static constexpr uint32_t STATE_TRANSFER_ROUNDS = 3;
+    /* the state streamed by this joining member */
+    struct IncomingTransfer {
+        node_id_t donor;
+        uint64_t id;
+        uint64_t num_keys;
+        /* the member the state is streamed from, which is the donor until it fails */
+        node_id_t source;
+        /* the transfer id at the source, or 0 to stream its live state */
+        uint64_t source_id;
+        /* the members which failed to serve the state */
+        std::set<node_id_t> failed_sources;
+        /* the last key streamed, in key order */
+        std::optional<KT> cursor;
+        /* the keys updated by the ordered path after the cut, or fetched on demand */
+        std::set<KT> touched;
+        /* the key an ordered operation waits for */
+        std::optional<KT> demand;
+        /* true while an ordered operation waits for a key or the whole state, before changing anything */
+        bool ordered_waiting = false;
+        /* true while an ordered operation waits for the whole state */
+        bool waiting_for_state = false;
+        /* true if the state can not be streamed, so the keys not streamed stay unavailable at this member */
+        bool failed = false;
+        std::thread worker;
+    };
+    std::unique_ptr<IncomingTransfer> incoming_transfer;
+    /* true while incoming_transfer streams, during which the ordered path holds transfer_mutex */
+    std::atomic<bool> transfer_in_progress;
+    bool transfer_stopping;
+    mutable std::mutex transfer_mutex;
+    std::condition_variable transfer_cv;
+    /* the version of the last ordered operation started, stored before it changes kv_map. It bounds the versions seen
+     * by a P2P reader of the live state, see state_chunk_t. */
+    std::atomic<persistent::version_t> applying_version;
+    /**
+     * Get the id of the copy of kv_map to send to the joining members, copying kv_map if it has changed since the last
+     * copy. Called by the serialization during a view change, when kv_map does not change.
+     *
+     * @return the transfer id, or 0 if the whole state is sent in the view change.
+     */
+    uint64_t prepare_outgoing_transfer() const;
+    /**
+     * Find a copy of kv_map being sent.
+     *
+     * @param transfer_id   The transfer id
+     *
+     * @throw std::out_of_range if the transfer is unknown, e.g. it has been dropped.
+     */
+    OutgoingTransfer find_outgoing_transfer(const uint64_t& transfer_id) const;
+    /**
+     * Get the budget of a chunk or piece of the stream, see CASCADE_VOLATILE_STATE_TRANSFER_CHUNK.
+     */
+    uint64_t state_chunk_budget() const;
+    /**
+     * Stream the state from the donor, run by the worker of incoming_transfer. If no shard member can serve the state,
+     * the transfer is marked failed instead of finishing, see IncomingTransfer::failed.
+     */
+    void stream_state();
+    /**
+     * Send a request of the stream to the source, retrying it, and turn to another shard member if the source keeps
+     * failing. When every shard member has failed, it backs off and tries them again, up to STATE_TRANSFER_ROUNDS
+     * rounds. Called by stream_state without transfer_mutex.
+     *
+     * @param request   Sends the request to a node with a transfer id and returns the reply
+     *
+     * @return the reply, or std::nullopt if no member can serve the state.
+     */
+    template <typename ReplyType>
+    std::optional<ReplyType> request_state(const std::function<ReplyType(node_id_t, uint64_t)>& request);
+    /**
+     * Fetch the object of a key from the source, in pieces if it is larger than a chunk. Called by stream_state
+     * without transfer_mutex.
+     *
+     * @param subgroup_handle   The subgroup handle
+     * @param key               The key
+     *
+     * @return the object, *IV if the key is absent, and the version of the state; or std::nullopt if no member can
+     *         serve the state.
+     */
+    std::optional<std::pair<VT, persistent::version_t>> fetch_state_object(
+            derecho::Replicated<VolatileCascadeStore>& subgroup_handle, const KT& key);
+    /**
+     * Test if this member has delivered every operation up to a version, so that a state of that version can be
+     * installed. Requires transfer_mutex.
+     *
+     * @param version   The version of the state
+     */
+    bool has_delivered(persistent::version_t version) const;
+    /**
+     * Lock transfer_mutex if the state is being streamed. Called at the beginning of the ordered operations.
+     *
+     * @return the lock, which does not own the mutex if the state is not being streamed.
+     */
+    std::unique_lock<std::mutex> lock_for_transfer();
+    /**
+     * Wait until a key arrives or is touched, fetching it on demand. It returns at once if the state is not being
+     * streamed.
+     *
+     * @param key   The key
+     * @param lck   The lock returned by lock_for_transfer()
+     *
+     * @throw derecho::derecho_exception if the state transfer failed before the key arrived.
+     */
+    void wait_for_key(const KT& key, std::unique_lock<std::mutex>& lck);
+    /**
+     * Wait until the whole state arrives, used by the ordered operations on more than one key.
+     *
+     * @param lck   The lock returned by lock_for_transfer()
+     *
+     * @throw derecho::derecho_exception if the state transfer failed.
+     */
+    void wait_for_transfer(std::unique_lock<std::mutex>& lck);
+    /**
+     * Test if a key has arrived or is touched. Requires transfer_mutex.
+     */
+    bool is_transferred(const KT& key) const;
+    /**
+     * Install an object streamed from the source unless its key is touched. Requires transfer_mutex.
+     *
+     * @param value     The object
+     */
+    void install_transferred(const VT& value);
+    /**
+     * Throw if a P2P read of a key can not be served because the key has not arrived yet.
+     */
+    void check_transferred(const KT& key) const;
 public:
     /* group reference */
     using derecho::GroupReference::group;
     /* volatile cascade store in memory */
-    std::map<KT, VT> kv_map;
+    key_value_map_t<KT, VT> kv_map;
+    /* the cache state of the object pools with a memory budget, keyed by object pool pathname */
+    pool_cache_map_t pool_caches;
     /* record the version of latest update */
     persistent::version_t update_version;
     /* watcher */
@@ -48,20 +469,33 @@ public:
                                              P2P_TARGETS(
                                                      put,
                                                      put_and_forget,
+                                                     put_batch,
+                                                     merge,
 #ifdef ENABLE_EVALUATION
                                                      perf_put,
 #endif
                                                      remove,
                                                      get,
+                                                     get_range,
                                                      multi_get,
                                                      get_by_time,
                                                      multi_list_keys,
                                                      list_keys,
                                                      list_keys_by_time,
+                                                     list_keys_paged,
+                                                     scan,
                                                      multi_get_size,
                                                      get_size,
                                                      get_size_by_time,
-                                                     trigger_put
+                                                     head,
+                                                     head_batch,
+                                                     trigger_put,
+                                                     set_memory_budget,
+                                                     get_cache_stats,
+                                                     set_ttl,
+                                                     get_state_chunk,
+                                                     get_state_object,
+                                                     end_state_transfer
 #ifdef ENABLE_EVALUATION
                                                      ,
                                                      dump_timestamp_log
@@ -74,10 +508,16 @@ public:
                                              ORDERED_TARGETS(
                                                      ordered_put,
                                                      ordered_put_and_forget,
+                                                     ordered_put_batch,
+                                                     ordered_merge,
                                                      ordered_remove,
                                                      ordered_get,
                                                      ordered_list_keys,
-                                                     ordered_get_size
+                                                     ordered_get_size,
+                                                     ordered_set_memory_budget,
+                                                     ordered_get_cache_stats,
+                                                     ordered_set_ttl,
+                                                     ordered_expire
 #ifdef ENABLE_EVALUATION
                                                      ,
                                                      ordered_dump_timestamp_log
@@ -95,18 +535,41 @@ public:
     virtual double perf_put(const uint32_t max_payload_size, const uint64_t duration_sec) const override;
 #endif  // ENABLE_EVALUATION
     virtual void put_and_forget(const VT& value, bool as_trigger) const override;
+    virtual version_tuple put_batch(const std::vector<VT>& values, bool as_trigger) const override;
+    /**
+     * Merge an operand into the object of its key with a merge operator in MergeOperatorRegistry, e.g. to add to a
+     * counter or append to a list in one ordered message instead of a get and a conditional put. It requires VT to
+     * implement IMergePayload.
+     *
+     * @param operand           An object with the key and the operand as its payload
+     * @param merge_operator    The name of the merge operator
+     *
+     * @return a tuple of version and timestamp, which is INVALID_VERSION if the operator is unknown or rejects the
+     *         operand, or the update is rejected.
+     */
+    version_tuple merge(const VT& operand, const std::string& merge_operator) const;
     virtual version_tuple remove(const KT& key) const override;
     virtual const VT get(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
+    virtual const VT get_range(const KT& key, const persistent::version_t& ver, const bool stable,
+                               const uint64_t& offset, const uint64_t& length) const override;
     virtual const VT multi_get(const KT& key) const override;
     virtual const VT get_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
     virtual std::vector<KT> multi_list_keys(const std::string& prefix) const override;
     virtual std::vector<KT> list_keys(const std::string& prefix, const persistent::version_t& ver, const bool stable) const override;
     virtual std::vector<KT> list_keys_by_time(const std::string& prefix, const uint64_t& ts_us, const bool stable) const override;
+    virtual key_page_t<KT> list_keys_paged(const std::string& prefix, const std::string& cursor, const uint32_t& limit) const override;
+    virtual scan_page_t<VT> scan(const std::string& prefix, const std::string& filter, const std::string& projection,
+                                 const std::string& cursor, const uint32_t& max_results) const override;
     virtual uint64_t multi_get_size(const KT& key) const override;
     virtual uint64_t get_size(const KT& key, const persistent::version_t& ver, const bool stable, bool exact = false) const override;
     virtual uint64_t get_size_by_time(const KT& key, const uint64_t& ts_us, const bool stable) const override;
+    virtual ObjectHead head(const KT& key, const persistent::version_t& ver, const bool stable) const override;
+    virtual std::vector<ObjectHead> head_batch(const std::vector<KT>& keys, const persistent::version_t& ver,
+                                               const bool stable) const override;
     virtual version_tuple ordered_put(const VT& value, bool as_trigger) override;
     virtual void ordered_put_and_forget(const VT& value, bool as_trigger) override;
+    virtual version_tuple ordered_put_batch(const std::vector<VT>& values, bool as_trigger) override;
+    version_tuple ordered_merge(const VT& operand, const std::string& merge_operator);
     virtual version_tuple ordered_remove(const KT& key) override;
     virtual const VT ordered_get(const KT& key) override;
     virtual std::vector<KT> ordered_list_keys(const std::string& prefix) override;
@@ -115,8 +578,81 @@ public:
     virtual void ordered_dump_timestamp_log(const std::string& filename) override;
 #endif  // ENABLE_EVALUATION
 
-    // serialization support
-    DEFAULT_SERIALIZE(kv_map, update_version);
+    /**
+     * Set the memory budget of an object pool, turning it into a cache. Objects are evicted when the pool is over
+     * budget. A budget of 0 removes the limit.
+     *
+     * @param pathname  The object pool pathname
+     * @param budget    The memory budget in bytes
+     *
+     * @return the version and timestamp of the operation.
+     */
+    version_tuple set_memory_budget(const std::string& pathname, const uint64_t& budget) const;
+    version_tuple ordered_set_memory_budget(const std::string& pathname, const uint64_t& budget);
+    /**
+     * Get the cache statistics of an object pool: "budget", "used_bytes" and "evictions" of the pool, and "hits" and
+     * "misses" of P2P get summed over the shard members.
+     *
+     * @param pathname  The object pool pathname
+     *
+     * @return the statistics by name, or an empty map if the object pool has no memory budget.
+     */
+    std::map<std::string, uint64_t> get_cache_stats(const std::string& pathname) const;
+    std::map<std::string, uint64_t> ordered_get_cache_stats(const std::string& pathname);
+    /**
+     * Set the TTL of an object pool. An object of the pool expires `ttl_ms` milliseconds after its timestamp, after
+     * which P2P get skips it and the store removes it, as `remove` does, within about CASCADE_VOLATILE_TTL_TICK. A TTL
+     * of 0 keeps the objects until they are removed. Only supported if VT implements IKeepTimestamp.
+     *
+     * @param pathname  The object pool pathname
+     * @param ttl_ms    The TTL in milliseconds
+     *
+     * @return the version and timestamp of the operation.
+     */
+    version_tuple set_ttl(const std::string& pathname, const uint64_t& ttl_ms) const;
+    version_tuple ordered_set_ttl(const std::string& pathname, const uint64_t& ttl_ms);
+    /**
+     * Remove the keys which expired by the timestamp of this operation. Keys updated since they are scheduled are
+     * kept, so all members remove the same keys. Sent by the expiration worker.
+     *
+     * @param keys      The keys
+     *
+     * @return the version and timestamp of the operation.
+     */
+    version_tuple ordered_expire(const std::vector<KT>& keys);
+    /**
+     * Get a chunk of the state sent to a joining member.
+     *
+     * @param transfer_id   The transfer id sent in the view change, or 0 for the live state of this member
+     * @param after         The last key of the previous chunk, ignored for the first chunk
+     * @param from_start    True for the first chunk
+     *
+     * @return the objects following `after` in key order that fit in a P2P reply, see state_chunk_t. The objects and
+     *         the next key are both empty at the end of the state.
+     */
+    state_chunk_t get_state_chunk(const uint64_t& transfer_id, const KT& after, const bool& from_start) const;
+    /**
+     * Get a piece of an object of the state sent to a joining member, for a key it waits for or an object larger than
+     * a chunk.
+     *
+     * @param transfer_id   The transfer id sent in the view change, or 0 for the live state of this member
+     * @param key           The key
+     * @param offset        The offset of the piece in the payload
+     *
+     * @return the object with the payload range from `offset` that fits in a P2P reply, see state_piece_t.
+     */
+    state_piece_t get_state_object(const uint64_t& transfer_id, const KT& key, const uint64_t& offset) const;
+    /**
+     * Drop the state sent to a joining member, which has streamed all of it.
+     *
+     * @param transfer_id   The transfer id sent in the view change
+     */
+    void end_state_transfer(const uint64_t& transfer_id) const;
+
+    // serialization support, see the chunked state transfer above.
+    std::size_t to_bytes(uint8_t* buf) const;
+    std::size_t bytes_size() const;
+    void post_object(const std::function<void(uint8_t const* const, std::size_t)>& f) const;
 
     static std::unique_ptr<VolatileCascadeStore> from_bytes(mutils::DeserializationManager* dsm, uint8_t const* buf);
 
@@ -135,7 +671,18 @@ public:
                          persistent::version_t _uv,
                          CriticalDataPathObserver<VolatileCascadeStore<KT, VT, IK, IV>>* cw = nullptr,
                          ICascadeContext* cc = nullptr);  // move kv_map
+    virtual ~VolatileCascadeStore();
 };
+
+/**
+ * Test if a subgroup type is a VolatileCascadeStore.
+ */
+template <typename T>
+struct is_volatile_cascade_store : std::false_type {};
+
+template <typename KT, typename VT, KT* IK, VT* IV>
+struct is_volatile_cascade_store<VolatileCascadeStore<KT, VT, IK, IV>> : std::true_type {};
+
 }  // namespace cascade
 }  // namespace derecho
 
@@ -0,0 +1,262 @@
+#include <getopt.h>
+#include <atomic>
+#include <cinttypes>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cascade/service_client_api.hpp>
+#include <cascade/utils.hpp>
+
+/**
+ * @file client_throughput.cpp
+ *
+ * Multi-threaded ServiceClient Throughput Tester
+ *
+ * A number of threads share one ServiceClient and issue operations back to back on their own keys for a fixed time.
+ * The test is repeated for each thread count, so the scaling of the client send path shows in the aggregated
+ * throughput. It connects to a running cascade service as an external client, using derecho.cfg in the current
+ * directory. An external client runs its sends through the external group client one at a time, from a lock-free
+ * submission stack, so the threads scale by overlapping the rest of an operation, e.g. the member selection and the
+ * waits for the replies, with the sends.
+ */
+
+using namespace derecho::cascade;
+
+/**
+ * @brief Help string.
+ */
+const char* help_string =
+    "Multi-threaded ServiceClient Throughput Tester\n"
+    "----------------------------------------------\n"
+    "Options:\n"
+    "\t--(o)bject-pool <pathname>                   the object pool to test, which is created in the first\n"
+    "\t                                             VolatileCascadeStore subgroup if it does not exist.\n"
+    "\t                                             Default: /client_throughput\n"
+    "\t--(m)ode <put|put_and_forget|get>            the operation to evaluate. Default: put\n"
+    "\t--(t)hreads <n1,n2,...>                      the thread counts to evaluate. Default: 1,2,4,8,16,32,64\n"
+    "\t--(s)ize <bytes>                             the payload size. Default: 256\n"
+    "\t--(d)uration <seconds>                       the duration of each run. Default: 5\n"
+    "\t--(k)eys-per-thread <num>                    the number of distinct keys of each thread. Default: 64\n"
+    "\t--(h)elp                                     help information\n"
+    ;
+
+enum class Mode {
+    PUT,
+    PUT_AND_FORGET,
+    GET
+};
+
+/**
+ * @brief Run the test with a given number of threads.
+ *
+ * @param[in]   capi            The service client shared by all threads.
+ * @param[in]   mode            The operation to evaluate.
+ * @param[in]   object_pool     The object pool pathname.
+ * @param[in]   num_threads     The number of threads.
+ * @param[in]   payload_size    The payload size in bytes.
+ * @param[in]   duration_sec    The duration of the run in seconds.
+ * @param[in]   keys_per_thread The number of distinct keys of each thread.
+ *
+ * @return the number of completed operations.
+ */
+uint64_t run(ServiceClientAPI& capi, Mode mode, const std::string& object_pool, uint32_t num_threads,
+             uint32_t payload_size, uint32_t duration_sec, uint32_t keys_per_thread) {
+    std::vector<std::thread> threads;
+    std::atomic<uint64_t> total_ops{0};
+    std::mutex start_mutex;
+    std::condition_variable start_cv;
+    uint32_t ready = 0;
+    bool started = false;
+    uint64_t deadline_ns = 0;
+
+    for (uint32_t tid = 0; tid < num_threads; tid++) {
+        threads.emplace_back([&,tid](){
+            // prepare the objects of this thread.
+            std::vector<ObjectWithStringKey> objects;
+            std::string payload(payload_size,'x');
+            for (uint32_t i = 0; i < keys_per_thread; i++) {
+                ObjectWithStringKey obj;
+                obj.key = object_pool + "/t" + std::to_string(tid) + "_" + std::to_string(i);
+                obj.previous_version = INVALID_VERSION;
+                obj.previous_version_by_key = INVALID_VERSION;
+                obj.blob = Blob(reinterpret_cast<const uint8_t*>(payload.data()),payload.size());
+                objects.emplace_back(std::move(obj));
+            }
+            if (mode == Mode::GET) {
+                for (auto& obj: objects) {
+                    auto result = capi.put(obj);
+                    for (auto& reply_future: result.get()) {
+                        reply_future.second.get();
+                    }
+                }
+            }
+            // wait for all threads.
+            {
+                std::unique_lock<std::mutex> lck(start_mutex);
+                ready ++;
+                start_cv.notify_all();
+                start_cv.wait(lck,[&started](){return started;});
+            }
+            uint64_t ops = 0;
+            while (get_time_ns() < deadline_ns) {
+                auto& obj = objects[ops % keys_per_thread];
+                switch (mode) {
+                case Mode::PUT:
+                    {
+                        auto result = capi.put(obj);
+                        for (auto& reply_future: result.get()) {
+                            reply_future.second.get();
+                        }
+                    }
+                    break;
+                case Mode::PUT_AND_FORGET:
+                    capi.put_and_forget(obj);
+                    break;
+                case Mode::GET:
+                    {
+                        auto result = capi.get(obj.key,CURRENT_VERSION,true);
+                        for (auto& reply_future: result.get()) {
+                            reply_future.second.get();
+                        }
+                    }
+                    break;
+                }
+                ops ++;
+            }
+            total_ops.fetch_add(ops);
+        });
+    }
+
+    // start the clock after the threads are ready, so that the setup is not measured.
+    {
+        std::unique_lock<std::mutex> lck(start_mutex);
+        start_cv.wait(lck,[&ready,num_threads](){return ready == num_threads;});
+        deadline_ns = get_time_ns() + static_cast<uint64_t>(duration_sec) * 1000000000ull;
+        started = true;
+    }
+    start_cv.notify_all();
+
+    for (auto& t: threads) {
+        t.join();
+    }
+    return total_ops.load();
+}
+
+/**
+ * @brief The main entry.
+ */
+int main(int argc, char** argv) {
+
+    // step 0 - parameters
+    static struct option long_options[] = {
+        {"object-pool",             required_argument,  0,  'o'},
+        {"mode",                    required_argument,  0,  'm'},
+        {"threads",                 required_argument,  0,  't'},
+        {"size",                    required_argument,  0,  's'},
+        {"duration",                required_argument,  0,  'd'},
+        {"keys-per-thread",         required_argument,  0,  'k'},
+        {"help",                    no_argument,        0,  'h'},
+        {0,0,0,0}
+    };
+
+    int c;
+    std::string             object_pool = "/client_throughput";
+    Mode                    mode = Mode::PUT;
+    std::string             mode_name = "put";
+    std::vector<uint32_t>   thread_counts = {1,2,4,8,16,32,64};
+    uint32_t                payload_size = 256;
+    uint32_t                duration_sec = 5;
+    uint32_t                keys_per_thread = 64;
+
+    while (true) {
+        int option_index = 0;
+        c = getopt_long(argc,argv,"o:m:t:s:d:k:h",long_options,&option_index);
+
+        if (c == -1) {
+            break;
+        }
+
+        switch(c) {
+        case 'o':
+            object_pool = optarg;
+            break;
+        case 'm':
+            mode_name = optarg;
+            if (mode_name == "put") {
+                mode = Mode::PUT;
+            } else if (mode_name == "put_and_forget") {
+                mode = Mode::PUT_AND_FORGET;
+            } else if (mode_name == "get") {
+                mode = Mode::GET;
+            } else {
+                std::cout << "unknown mode:" << mode_name << std::endl;
+                return -1;
+            }
+            break;
+        case 't':
+            {
+                thread_counts.clear();
+                std::istringstream iss(optarg);
+                std::string token;
+                while (std::getline(iss,token,',')) {
+                    thread_counts.emplace_back(std::stoul(token));
+                }
+            }
+            break;
+        case 's':
+            payload_size = std::stoul(optarg);
+            break;
+        case 'd':
+            duration_sec = std::stoul(optarg);
+            break;
+        case 'k':
+            keys_per_thread = std::stoul(optarg);
+            break;
+        case 'h':
+            std::cout << help_string << std::endl;
+            return 0;
+        case '?':
+        default:
+            std::cout << "unknown options." << std::endl;
+            std::cout << help_string << std::endl;
+            return -1;
+        }
+    }
+    if (keys_per_thread == 0 || duration_sec == 0) {
+        std::cout << "keys-per-thread and duration must be positive." << std::endl;
+        return -1;
+    }
+
+    // step 1 - connect and prepare the object pool
+    ServiceClientAPI& capi = ServiceClientAPI::get_service_client();
+    auto opm = capi.find_object_pool(object_pool);
+    if (!opm.is_valid() || opm.is_null() || opm.deleted) {
+        auto result = capi.template create_object_pool<VolatileCascadeStoreWithStringKey>(object_pool,0);
+        for (auto& reply_future: result.get()) {
+            reply_future.second.get();
+        }
+    }
+
+    // step 2 - evaluate
+    std::cout << "mode=" << mode_name << ", payload=" << payload_size << " bytes, duration=" << duration_sec << "s"
+              << std::endl;
+    std::cout << "threads\tops\tops/s\tspeedup" << std::endl;
+    double base_ops_per_sec = 0.0;
+    for (auto num_threads: thread_counts) {
+        if (num_threads == 0) {
+            continue;
+        }
+        uint64_t ops = run(capi,mode,object_pool,num_threads,payload_size,duration_sec,keys_per_thread);
+        double ops_per_sec = static_cast<double>(ops)/duration_sec;
+        if (base_ops_per_sec == 0.0) {
+            base_ops_per_sec = ops_per_sec;
+        }
+        std::cout << num_threads << "\t" << ops << "\t" << ops_per_sec << "\t"
+                  << (base_ops_per_sec > 0.0 ? ops_per_sec / base_ops_per_sec : 0.0) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <cascade/blob_store.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace derecho::cascade;
+
+/**
+ * Write payloads around the O_DIRECT block and buffer sizes, and check they are mapped back intact and deduplicated.
+ * Then check a segment acquired with its payload is served before the background writer writes it, and removed when
+ * the last reference is released.
+ */
+int main(int argc, char** argv) {
+    std::string path = (argc > 1) ? argv[1] : ("blob_store_test." + std::to_string(getpid()));
+    BlobSegmentStore store(path);
+    bool ok = true;
+    for(std::size_t size : {1ul, 4095ul, 4096ul, 4097ul, (4ul << 20) + 1, (9ul << 20) + 123}) {
+        std::vector<uint8_t> payload(size);
+        for(std::size_t i = 0; i < size; i++) {
+            payload[i] = static_cast<uint8_t>(i * 131 + size);
+        }
+        BlobReference reference = store.write(payload.data(), size);
+        BlobReference again = store.write(payload.data(), size);
+        if(reference.to_string() != again.to_string() || reference.size != size) {
+            std::cout << "size " << size << ": references of the same payload differ." << std::endl;
+            ok = false;
+            continue;
+        }
+        auto mapped = store.map(reference);
+        if(memcmp(mapped.get(), payload.data(), size) != 0) {
+            std::cout << "size " << size << ": the mapped segment differs from the payload." << std::endl;
+            ok = false;
+        }
+        if(store.map(again).get() != mapped.get()) {
+            std::cout << "size " << size << ": the segment is mapped twice." << std::endl;
+            ok = false;
+        }
+    }
+    BlobReference missing;
+    memset(missing.digest, 0, sizeof(missing.digest));
+    missing.size = 1;
+    try {
+        store.map(missing);
+        std::cout << "a missing segment is mapped." << std::endl;
+        ok = false;
+    } catch(const std::runtime_error&) {
+    }
+    if(!store.read(missing, 0, 1).empty()) {
+        std::cout << "a missing segment is read." << std::endl;
+        ok = false;
+    }
+
+    std::size_t size = (5ul << 20) + 7;
+    auto payload = std::shared_ptr<uint8_t>(new uint8_t[size], std::default_delete<uint8_t[]>());
+    for(std::size_t i = 0; i < size; i++) {
+        payload.get()[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    BlobReference reference = BlobSegmentStore::reference_of(payload.get(), size);
+    std::string segment = path + "/" + reference.to_string();
+    store.acquire(reference, payload);
+    store.acquire(reference);
+    if(!store.contains(reference) || memcmp(store.map(reference).get(), payload.get(), size) != 0) {
+        std::cout << "an acquired segment is not served." << std::endl;
+        ok = false;
+    }
+    auto range = store.read(reference, size - 10, 100);
+    if(range.size() != 10 || memcmp(range.data(), payload.get() + size - 10, 10) != 0) {
+        std::cout << "the tail of a segment is read wrong." << std::endl;
+        ok = false;
+    }
+    if(BlobReference::from_string(reference.to_string(), size).to_string() != reference.to_string()) {
+        std::cout << "a parsed reference differs." << std::endl;
+        ok = false;
+    }
+    for(int i = 0; i < 1000 && !std::filesystem::exists(segment); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if(!std::filesystem::exists(segment)) {
+        std::cout << "an acquired segment is not written." << std::endl;
+        ok = false;
+    }
+    store.release(reference);
+    if(!std::filesystem::exists(segment)) {
+        std::cout << "a segment is removed while it is referred to." << std::endl;
+        ok = false;
+    }
+    store.release(reference);
+    if(std::filesystem::exists(segment) || store.contains(reference)) {
+        std::cout << "a released segment is not removed." << std::endl;
+        ok = false;
+    }
+    std::cout << (ok ? "passed" : "failed") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+#include <cascade/detail/concurrent_index.hpp>
+#include <cascade/detail/key_page_cursor.hpp>
+
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace derecho::cascade;
+
+/**
+ * Check for_each_with_prefix() against a brute-force scan using the list_keys matching rule, and the listing in
+ * pages of two keys resumed by for_each_with_prefix_after() with a KeyPageCursor.
+ */
+static bool check_prefix_listing() {
+    key_value_map_t<std::string, std::string> kv_map;
+    ConcurrentKeyIndex<std::string, std::string> kv_index;
+    const std::vector<std::string> keys = {"/a/1", "/a/2", "/a/b/1", "/a/bc/1", "/ab/1", "/b/1", "/a", "x", "/a/b/c/d/1"};
+    for(const auto& key : keys) {
+        auto it = kv_map.emplace(key, key).first;
+        kv_index.publish(*it);
+    }
+    bool ok = true;
+    for(const std::string prefix : {"", "/", "/a", "/a/", "/a/b", "/a/b/", "/ab", "/c", "x"}) {
+        std::vector<std::string> expected, listed;
+        for(const auto& kv : kv_map) {
+            const std::string key = kv.first;
+            size_t pos = key.rfind('/');
+            std::string pathname = (pos == std::string::npos) ? "" : key.substr(0, pos);
+            if(pathname.find(prefix) == 0) {
+                expected.push_back(key);
+            }
+        }
+        EpochGuard epoch_guard;
+        kv_index.for_each_with_prefix(prefix, [&listed](const std::string& key, const std::string&) {
+            listed.push_back(key);
+            return true;
+        });
+        if(listed != expected) {
+            std::cout << "prefix '" << prefix << "' listed " << listed.size() << " keys, expected " << expected.size() << std::endl;
+            ok = false;
+        }
+        std::vector<std::string> paged;
+        std::string cursor;
+        do {
+            std::vector<std::string> page;
+            bool has_more = false;
+            auto visitor = [&page, &has_more](const std::string& key, const std::string&) {
+                if(page.size() == 2) {
+                    has_more = true;
+                    return false;
+                }
+                page.push_back(key);
+                return true;
+            };
+            KeyPageCursor<std::string> page_cursor{42, ""};
+            if(cursor.empty()) {
+                kv_index.for_each_with_prefix(prefix, visitor);
+            } else if(!KeyPageCursor<std::string>::decode(cursor, page_cursor) || page_cursor.version != 42) {
+                std::cout << "cursor '" << cursor << "' is not decoded." << std::endl;
+                return false;
+            } else {
+                kv_index.for_each_with_prefix_after(prefix, page_cursor.last_key, visitor);
+            }
+            paged.insert(paged.end(), page.begin(), page.end());
+            cursor.clear();
+            if(has_more) {
+                page_cursor.last_key = page.back();
+                cursor = page_cursor.encode();
+            }
+        } while(!cursor.empty());
+        if(paged != expected) {
+            std::cout << "prefix '" << prefix << "' paged " << paged.size() << " keys, expected " << expected.size() << std::endl;
+            ok = false;
+        }
+    }
+    KeyPageCursor<uint64_t> uint64_cursor{-1, 123};
+    if(!KeyPageCursor<uint64_t>::decode(uint64_cursor.encode(), uint64_cursor) || uint64_cursor.version != -1
+       || uint64_cursor.last_key != 123 || KeyPageCursor<uint64_t>::decode("x:1", uint64_cursor)
+       || KeyPageCursor<uint64_t>::decode("1:", uint64_cursor) || KeyPageCursor<uint64_t>::decode("1:-2", uint64_cursor)) {
+        std::cout << "uint64 cursors are not encoded correctly." << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * A single writer keeps replacing the values in a std::map and publishing them to a ConcurrentKeyIndex, retiring the
+ * old map nodes, while reader threads look up and copy the values without locks. Every value a reader sees must be
+ * intact: the value string is always the key repeated.
+ */
+int main(int argc, char** argv) {
+    const uint32_t num_keys = (argc > 1) ? std::stoul(argv[1]) : 4096;
+    const uint32_t num_updates = (argc > 2) ? std::stoul(argv[2]) : 1000000;
+    const uint32_t num_readers = (argc > 3) ? std::stoul(argv[3]) : 4;
+
+    if(!check_prefix_listing()) {
+        return 1;
+    }
+
+    std::map<uint64_t, std::string> kv_map;
+    ConcurrentKeyIndex<uint64_t, std::string> kv_index;
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> num_corrupted{0};
+    std::atomic<uint64_t> num_hits{0};
+
+    std::vector<std::thread> readers;
+    for(uint32_t r = 0; r < num_readers; r++) {
+        readers.emplace_back([&, r]() {
+            uint64_t key = r;
+            while(!stop.load(std::memory_order_relaxed)) {
+                key = (key * 6364136223846793005ULL + 1442695040888963407ULL);
+                uint64_t k = key % num_keys;
+                std::string copied_out;
+                if(r == 0) {
+                    // one reader keeps walking the key order instead.
+                    EpochGuard epoch_guard;
+                    uint64_t last_key = 0;
+                    bool first = true;
+                    kv_index.for_each([&](const uint64_t& k, const std::string& v) {
+                        if((!first && k <= last_key) || v.substr(0, std::to_string(k).size()) != std::to_string(k)) {
+                            num_corrupted++;
+                        }
+                        first = false;
+                        last_key = k;
+                        return true;
+                    });
+                    continue;
+                }
+                {
+                    EpochGuard epoch_guard;
+                    const std::string* value = kv_index.find(k);
+                    if(value != nullptr) {
+                        copied_out = *value;
+                    }
+                }
+                if(!copied_out.empty()) {
+                    num_hits++;
+                    if(copied_out.substr(0, std::to_string(k).size()) != std::to_string(k)) {
+                        num_corrupted++;
+                    }
+                }
+            }
+        });
+    }
+
+    for(uint32_t i = 0; i < num_updates; i++) {
+        uint64_t k = i % num_keys;
+        auto old_node = kv_map.extract(k);
+        std::string value = std::to_string(k);
+        value.append(i % 64, '#');
+        auto it = kv_map.emplace(k, std::move(value)).first;
+        kv_index.publish(*it);
+        if(!old_node.empty()) {
+            kv_index.retire(std::move(old_node));
+        }
+        if(i % 1000 == 999) {
+            // drop a key: unlink it from the index before retiring the map node.
+            kv_index.erase((i / 1000) % num_keys);
+            auto dropped_node = kv_map.extract((i / 1000) % num_keys);
+            if(!dropped_node.empty()) {
+                kv_index.retire(std::move(dropped_node));
+            }
+        }
+        kv_index.reclaim();
+    }
+    stop.store(true);
+    for(auto& reader : readers) {
+        reader.join();
+    }
+
+    std::cout << "hits:" << num_hits.load() << ", corrupted:" << num_corrupted.load()
+              << ", index size:" << kv_index.size() << ", map size:" << kv_map.size() << std::endl;
+    return (num_corrupted.load() == 0 && kv_index.size() == kv_map.size()) ? 0 : 1;
+}
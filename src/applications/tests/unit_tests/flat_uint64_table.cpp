@@ -0,0 +1,97 @@
+#include <cascade/detail/flat_uint64_table.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace derecho::cascade;
+
+/**
+ * Compare the table with a reference map.
+ */
+static bool check_table(const FlatUInt64Table& table, const std::map<uint64_t, std::string>& reference) {
+    if(table.size() != reference.size()) {
+        std::cout << "the table has " << table.size() << " keys instead of " << reference.size() << "." << std::endl;
+        return false;
+    }
+    for(const auto& kv : reference) {
+        FlatUInt64Table::View view;
+        if(!table.find(kv.first, view)) {
+            std::cout << "key " << kv.first << " is lost." << std::endl;
+            return false;
+        }
+        if(std::string(reinterpret_cast<const char*>(view.bytes), view.size) != kv.second
+           || view.version != static_cast<int64_t>(kv.first) || view.timestamp_us != kv.second.size()) {
+            std::cout << "the object of key " << kv.first << " is wrong." << std::endl;
+            return false;
+        }
+    }
+    std::size_t visited = 0;
+    table.for_each([&visited](uint64_t, const FlatUInt64Table::View&) { visited++; });
+    if(visited != reference.size()) {
+        std::cout << "for_each visits " << visited << " keys instead of " << reference.size() << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Apply random puts and erases on clustered keys with inline and allocated payloads, and check the table against a
+ * reference map, including after a serialization round trip.
+ */
+int main(int, char**) {
+    bool ok = true;
+    FlatUInt64Table table;
+    std::map<uint64_t, std::string> reference;
+    std::mt19937_64 rng(42);
+
+    for(uint32_t round = 0; round < 200000 && ok; round++) {
+        // sequential ids and a few far ones, so that probe sequences wrap around and collide.
+        const uint64_t key = (rng() % 8 == 0) ? rng() : rng() % 4096;
+        if(rng() % 3 == 0) {
+            if(table.erase(key) != (reference.erase(key) == 1)) {
+                std::cout << "erase of key " << key << " is wrong." << std::endl;
+                ok = false;
+            }
+        } else {
+            std::string value(rng() % 24, static_cast<char>('a' + key % 26));
+            table.put(key, static_cast<int64_t>(key), value.size(), reinterpret_cast<const uint8_t*>(value.data()), value.size());
+            reference[key] = value;
+        }
+        if(round % 10000 == 0) {
+            ok &= check_table(table, reference);
+        }
+    }
+    ok &= check_table(table, reference);
+
+    std::vector<uint8_t> buffer(table.bytes_size());
+    if(table.to_bytes(buffer.data()) != buffer.size()) {
+        std::cout << "to_bytes does not write bytes_size() bytes." << std::endl;
+        ok = false;
+    }
+    FlatUInt64Table copy;
+    copy.put(1ull << 63, 0, 0, nullptr, 0);
+    if(FlatUInt64Table::from_bytes(buffer.data(), copy) != buffer.size()) {
+        std::cout << "from_bytes does not read bytes_size() bytes." << std::endl;
+        ok = false;
+    }
+    ok &= check_table(copy, reference);
+
+    FlatUInt64Table moved(std::move(copy));
+    ok &= check_table(moved, reference);
+    if(copy.size() != 0) {
+        std::cout << "a moved table is not empty." << std::endl;
+        ok = false;
+    }
+    moved.clear();
+    if(moved.size() != 0 || moved.memory_usage() != 0) {
+        std::cout << "clear does not drop the keys." << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "passed" : "failed") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+#include <cascade/detail/interned_key_map.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace derecho::cascade;
+
+/**
+ * Compare the map with a reference map.
+ */
+static bool check_map(const InternedKeyMap<std::string, uint64_t>& map, const std::map<std::string, uint64_t>& reference) {
+    if(map.size() != reference.size()) {
+        std::cout << "the map has " << map.size() << " keys instead of " << reference.size() << "." << std::endl;
+        return false;
+    }
+    for(const auto& kv : reference) {
+        auto it = map.find(kv.first);
+        if(it == map.cend() || it->second != kv.second) {
+            std::cout << "key " << kv.first << " is lost." << std::endl;
+            return false;
+        }
+    }
+    for(const auto& kv : map) {
+        const std::string key = map.key_of(kv.first);
+        if(reference.count(key) == 0 || map.prefix_of(kv.first) + kv.first.suffix != key) {
+            std::cout << "key " << key << " is not materialized correctly." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Check that a map keyed by InternedPathname keeps the order, lookups, and hashes of the full pathnames, and that the
+ * prefixes are shared by keys interned in different threads.
+ */
+static bool check_interned_pathnames() {
+    bool ok = true;
+    const std::vector<std::string> pathnames = {"", "a", "/", "/a", "/a/", "/a/1", "/a/10", "/a/b/1", "/a/bc", "/ab/1",
+                                                "/a/b", "/a/b/", "/a/b/c/obj123", "/b/1", "x/y"};
+    key_value_map_t<std::string, uint64_t> kv_map;
+    std::map<std::string, uint64_t> reference;
+    for(uint64_t i = 0; i < pathnames.size(); i++) {
+        kv_map.emplace(pathnames[i], i);
+        reference.emplace(pathnames[i], i);
+    }
+    auto it = kv_map.cbegin();
+    for(const auto& kv : reference) {
+        const InternedPathname& key = it->first;
+        if(key.str() != kv.first || key != kv.first || key.hash() != pathname_hash(kv.first) || key.size() != kv.first.size()
+           || kv_map.find(kv.first) == kv_map.end() || kv_map.find(kv.first)->second != kv.second) {
+            std::cout << "key " << kv.first << " is not interned correctly." << std::endl;
+            ok = false;
+        }
+        for(const auto& other : pathnames) {
+            if((key.compare(other) < 0) != (kv.first.compare(other) < 0) || (key < InternedPathname(other)) != (kv.first < other)
+               || key.starts_with(other) != (kv.first.compare(0, other.size(), other) == 0)) {
+                std::cout << "key " << kv.first << " is not compared with " << other << " correctly." << std::endl;
+                ok = false;
+            }
+        }
+        it++;
+    }
+    if(kv_map.find(std::string("/a/2")) != kv_map.end() || kv_map.find(std::string("/c/1")) != kv_map.end()) {
+        std::cout << "a missing key is found." << std::endl;
+        ok = false;
+    }
+    // keys are interned and dropped concurrently, and the same prefix is shared by all of them.
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t> num_shared{0};
+    for(uint32_t t = 0; t < 4; t++) {
+        threads.emplace_back([&num_shared, t]() {
+            for(uint32_t i = 0; i < 20000; i++) {
+                InternedPathname key("/pool/dir" + std::to_string(i % 8) + "/obj" + std::to_string(t));
+                InternedPathname same("/pool/dir" + std::to_string(i % 8) + "/x");
+                InternedPathname copy(key);
+                if(same.prefix_id() == key.prefix_id() && copy.prefix_id() == key.prefix_id()) {
+                    num_shared++;
+                }
+            }
+        });
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    if(num_shared != 4 * 20000) {
+        std::cout << "the prefixes are not shared." << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * Apply random inserts and erases of pathname keys in a few object pools, and check the map, its prefixes and its
+ * memory statistics against a reference map.
+ */
+int main(int, char**) {
+    bool ok = check_interned_pathnames();
+    InternedKeyMap<std::string, uint64_t> map;
+    std::map<std::string, uint64_t> reference;
+    std::mt19937_64 rng(42);
+
+    for(uint32_t round = 0; round < 100000 && ok; round++) {
+        std::string key = "/pool" + std::to_string(rng() % 4) + "/dir" + std::to_string(rng() % 8) + "/obj" + std::to_string(rng() % 256);
+        if(rng() % 16 == 0) {
+            // keys without a separator, and keys in the root path.
+            key = (rng() % 2) ? std::to_string(rng() % 64) : "/" + std::to_string(rng() % 64);
+        }
+        if(rng() % 3 == 0) {
+            if(map.erase(key) != reference.erase(key)) {
+                std::cout << "erase of key " << key << " is wrong." << std::endl;
+                ok = false;
+            }
+        } else {
+            const bool inserted = map.try_emplace(key, round).second;
+            if(inserted != reference.emplace(key, round).second) {
+                std::cout << "try_emplace of key " << key << " is wrong." << std::endl;
+                ok = false;
+            }
+        }
+        if(round % 10000 == 0) {
+            ok &= check_map(map, reference);
+        }
+    }
+    ok &= check_map(map, reference);
+
+    auto stats = map.get_key_memory_stats();
+    uint64_t key_bytes = 0;
+    std::map<std::string, uint32_t> prefixes;
+    for(const auto& kv : reference) {
+        key_bytes += sizeof(std::string) + string_heap_bytes(kv.first.size());
+        prefixes[std::string(KeyPrefixTable::split(kv.first).first)]++;
+    }
+    if(stats["keys"] != reference.size() || stats["prefixes"] != prefixes.size() || stats["key_bytes"] != key_bytes) {
+        std::cout << "the key memory statistics are wrong." << std::endl;
+        ok = false;
+    }
+    if(stats["stored_key_bytes"] >= stats["key_bytes"]) {
+        std::cout << "the interned keys take " << stats["stored_key_bytes"] << " bytes, not less than "
+                  << stats["key_bytes"] << " bytes of the full keys." << std::endl;
+        ok = false;
+    }
+
+    map.clear();
+    stats = map.get_key_memory_stats();
+    if(map.size() != 0 || stats["prefixes"] != 0 || stats["key_bytes"] != 0 || map.find("/pool0/dir0/obj0") != map.end()) {
+        std::cout << "clear does not drop the keys." << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "passed" : "failed") << std::endl;
+    return ok ? 0 : 1;
+}
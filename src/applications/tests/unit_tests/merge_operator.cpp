@@ -0,0 +1,80 @@
+#include <cascade/merge_operator.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace derecho::cascade;
+
+static std::vector<uint8_t> int64_bytes(int64_t value) {
+    std::vector<uint8_t> bytes(sizeof(value));
+    memcpy(bytes.data(), &value, sizeof(value));
+    return bytes;
+}
+
+/**
+ * Merge an int64 operand into an int64 payload, or into an absent key if base is empty.
+ *
+ * @return true if the merge is accepted and the result is expected.
+ */
+static bool check_int64(const std::string& op, const std::vector<uint8_t>& base, int64_t operand, int64_t expected) {
+    std::vector<uint8_t> merged;
+    auto operand_bytes = int64_bytes(operand);
+    if(!MergeOperatorRegistry::get().merge(op, base.empty() ? nullptr : base.data(), base.size(),
+                                           operand_bytes.data(), operand_bytes.size(), merged)) {
+        std::cout << op << " rejected the operand " << operand << "." << std::endl;
+        return false;
+    }
+    if(merged != int64_bytes(expected)) {
+        std::cout << op << " of " << operand << " does not give " << expected << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Apply the built-in merge operators, and register a custom one.
+ */
+int main(int, char**) {
+    bool ok = true;
+    ok &= check_int64(CASCADE_MERGE_ADD_INT64, {}, 5, 5);
+    ok &= check_int64(CASCADE_MERGE_ADD_INT64, int64_bytes(40), 2, 42);
+    ok &= check_int64(CASCADE_MERGE_ADD_INT64, int64_bytes(-3), -4, -7);
+    ok &= check_int64(CASCADE_MERGE_MAX_INT64, {}, -9, -9);
+    ok &= check_int64(CASCADE_MERGE_MAX_INT64, int64_bytes(7), 3, 7);
+    ok &= check_int64(CASCADE_MERGE_MIN_INT64, int64_bytes(7), 3, 3);
+
+    std::vector<uint8_t> merged;
+    const std::string base = "abc", operand = "de";
+    if(!MergeOperatorRegistry::get().merge(CASCADE_MERGE_APPEND_BYTES, reinterpret_cast<const uint8_t*>(base.data()), base.size(),
+                                           reinterpret_cast<const uint8_t*>(operand.data()), operand.size(), merged)
+       || std::string(merged.begin(), merged.end()) != "abcde") {
+        std::cout << CASCADE_MERGE_APPEND_BYTES << " does not append." << std::endl;
+        ok = false;
+    }
+    // an int64 operator rejects a payload of another size.
+    if(MergeOperatorRegistry::get().merge(CASCADE_MERGE_ADD_INT64, reinterpret_cast<const uint8_t*>(base.data()), base.size(),
+                                          int64_bytes(1).data(), sizeof(int64_t), merged)) {
+        std::cout << CASCADE_MERGE_ADD_INT64 << " accepted a 3-byte payload." << std::endl;
+        ok = false;
+    }
+    if(MergeOperatorRegistry::get().merge("no_such_operator", nullptr, 0, nullptr, 0, merged)) {
+        std::cout << "an unknown operator is applied." << std::endl;
+        ok = false;
+    }
+
+    bool registered = MergeOperatorRegistry::get().register_operator(
+            "replace", [](const uint8_t*, std::size_t, const uint8_t* operand, std::size_t operand_size, std::vector<uint8_t>& merged) {
+                merged.assign(operand, operand + operand_size);
+                return true;
+            });
+    if(!registered || MergeOperatorRegistry::get().register_operator(CASCADE_MERGE_ADD_INT64, nullptr)) {
+        std::cout << "the registration of operators is wrong." << std::endl;
+        ok = false;
+    }
+    ok &= check_int64("replace", int64_bytes(1), 2, 2);
+
+    std::cout << (ok ? "passed" : "failed") << std::endl;
+    return ok ? 0 : 1;
+}
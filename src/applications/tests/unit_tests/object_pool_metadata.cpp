@@ -11,9 +11,45 @@ int main(int argc, char** argv) {
     std::cout << opm << std::endl;
     std::cout << *(mutils::from_bytes<DefaultObjectPoolMetadataType>(nullptr,buf)) << std::endl;
 
+    // the settings in the extension of the record survive a round trip.
+    opm.pathname = "/pool";
+    opm.memory_budget = 1024;
+    opm.log_retention = {8,60,4096};
+    opm.blob_threshold = 65536;
+    opm.ttl_ms = 1000;
+    opm.to_bytes(buf);
+    auto extended = mutils::from_bytes<DefaultObjectPoolMetadataType>(nullptr,buf);
+    std::cout << "extended record is " << ((mutils::bytes_size(opm) == mutils::bytes_size(*extended) &&
+            extended->memory_budget == 1024 && extended->log_retention.max_versions == 8 &&
+            extended->log_retention.max_age_sec == 60 && extended->log_retention.max_bytes == 4096 &&
+            extended->blob_threshold == 65536 && extended->ttl_ms == 1000) ? "read" : "NOT read") << std::endl;
+
+    // a record written before the extension is read with the settings at 0, and keeps its size.
+    std::size_t pos = 0;
+#ifdef ENABLE_EVALUATION
+    pos += mutils::to_bytes(opm.message_id,buf + pos);
+#endif
+    pos += mutils::to_bytes(opm.version,buf + pos);
+    pos += mutils::to_bytes(opm.timestamp_us,buf + pos);
+    pos += mutils::to_bytes(opm.previous_version,buf + pos);
+    pos += mutils::to_bytes(opm.previous_version_by_key,buf + pos);
+    pos += mutils::to_bytes(opm.pathname,buf + pos);
+    pos += mutils::to_bytes(opm.subgroup_type_index,buf + pos);
+    pos += mutils::to_bytes(opm.subgroup_index,buf + pos);
+    pos += mutils::to_bytes(opm.sharding_policy,buf + pos);
+    pos += mutils::to_bytes(opm.object_locations,buf + pos);
+    pos += mutils::to_bytes(opm.affinity_set_regex,buf + pos);
+    pos += mutils::to_bytes(opm.deleted,buf + pos);
+    auto original = mutils::from_bytes<DefaultObjectPoolMetadataType>(nullptr,buf);
+    std::cout << "original record is " << ((mutils::bytes_size(*original) == pos && original->pathname == "/pool" && original->deleted &&
+            original->memory_budget == 0 && !original->log_retention.is_enabled() &&
+            original->blob_threshold == 0 && original->ttl_ms == 0) ? "read" : "NOT read") << std::endl;
+
     std::cout << "VolatileCascadeStoreWithStringKey index is " << DefaultObjectPoolMetadataType::get_subgroup_type_index<VolatileCascadeStoreWithStringKey>() << std::endl;
     std::cout << "PersistentCascadeStoreWithStringKey index is " << DefaultObjectPoolMetadataType::get_subgroup_type_index<PersistentCascadeStoreWithStringKey>() << std::endl;
     std::cout << "TriggerCascadeNoStoreWithStringKey index is " << DefaultObjectPoolMetadataType::get_subgroup_type_index<TriggerCascadeNoStoreWithStringKey>() << std::endl;
+    std::cout << "VolatileCompactCascadeStoreWithUInt64Key index is " << DefaultObjectPoolMetadataType::get_subgroup_type_index<VolatileCompactCascadeStoreWithUInt64Key>() << std::endl;
+    std::cout << "PersistentCompactCascadeStoreWithUInt64Key index is " << DefaultObjectPoolMetadataType::get_subgroup_type_index<PersistentCompactCascadeStoreWithUInt64Key>() << std::endl;
     std::cout << "int index is " << DefaultObjectPoolMetadataType::get_subgroup_type_index<int>() << std::endl;
     return 0;
 }
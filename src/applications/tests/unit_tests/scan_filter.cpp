@@ -0,0 +1,117 @@
+#include <cascade/scan_filter.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+using namespace derecho::cascade;
+
+static ScanFields make_fields(const std::string& key, int64_t version, uint64_t timestamp_us, const std::string& payload) {
+    return ScanFields{key, version, timestamp_us, reinterpret_cast<const uint8_t*>(payload.data()), payload.size()};
+}
+
+/**
+ * Compile a filter and test it with an object.
+ *
+ * @return true if the filter compiles and matches the object as expected.
+ */
+static bool check_match(const std::string& expression, const ScanFields& fields, bool expected) {
+    ScanFilter filter;
+    std::string error;
+    if(!ScanFilter::compile(expression, filter, error)) {
+        std::cout << "filter '" << expression << "' is rejected: " << error << std::endl;
+        return false;
+    }
+    if(filter.match(fields) != expected) {
+        std::cout << "filter '" << expression << "' does not " << (expected ? "match" : "reject") << " the object." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool check_invalid(const std::string& expression) {
+    ScanFilter filter;
+    std::string error;
+    if(ScanFilter::compile(expression, filter, error)) {
+        std::cout << "filter '" << expression << "' is accepted." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Compile filters and projections, and test them with an object.
+ */
+int main(int, char**) {
+    bool ok = true;
+    const std::string payload = std::string("temp=21\x01\"x\\", 11);
+    const std::string key = "/pool/sensor/42";
+    const ScanFields fields = make_fields(key, 7, 1000000, payload);
+
+    ok &= check_match("", fields, true);
+    ok &= check_match("key == \"/pool/sensor/42\"", fields, true);
+    ok &= check_match("key ^= \"/pool/sensor/\" && version >= 7 && version < 8", fields, true);
+    ok &= check_match("key^=\"/pool/actuator/\"", fields, false);
+    ok &= check_match("timestamp > 0xf4240", fields, false);
+    ok &= check_match("size == 11 && payload ^= \"temp=\"", fields, true);
+    ok &= check_match("payload == " + ScanFilter::quote(payload), fields, true);
+    ok &= check_match("payload > \"temp=3\"", fields, false);
+    ok &= check_match("version != -1", ScanFields{key, -1, 0, nullptr, 0}, false);
+    ok &= check_invalid("key ^= 5");
+    ok &= check_invalid("size ^= \"a\"");
+    ok &= check_invalid("size < -1");
+    ok &= check_invalid("name == \"a\"");
+    ok &= check_invalid("key == \"a\" &&");
+    ok &= check_invalid("key == \"a");
+    ok &= check_invalid("payload == \"\\x4\"");
+    ok &= check_invalid("@unknown_predicate");
+
+    // a predicate is called with its argument, and matches every object on a client which does not resolve it.
+    ScanPredicateRegistry::get().register_predicate("min_size", [](const ScanFields& fields, const std::string& argument) {
+        return fields.payload_size >= std::stoull(argument);
+    });
+    if(ScanPredicateRegistry::get().register_predicate("min_size", [](const ScanFields&, const std::string&) { return true; })) {
+        std::cout << "a predicate is registered twice." << std::endl;
+        ok = false;
+    }
+    ok &= check_match("@min_size(\"11\") && key ^= \"/pool/\"", fields, true);
+    ok &= check_match("@min_size(\"12\")", fields, false);
+    ScanFilter unresolved;
+    std::string error;
+    if(!ScanFilter::compile("@server_only(\"x\")", unresolved, error, false) || !unresolved.match(fields)) {
+        std::cout << "an unresolved predicate does not match every object." << std::endl;
+        ok = false;
+    }
+
+    // projections
+    ScanProjection projection;
+    if(!ScanProjection::compile("", projection, error) || !projection.keeps_payload()
+       || !ScanProjection::compile("payload", projection, error) || !projection.keeps_payload()) {
+        std::cout << "the default projection does not keep the payload." << std::endl;
+        ok = false;
+    }
+    if(!ScanProjection::compile("none", projection, error) || projection.apply(fields.payload, fields.payload_size).second != 0) {
+        std::cout << "projection none keeps bytes." << std::endl;
+        ok = false;
+    }
+    auto projected = std::make_pair<const uint8_t*, std::size_t>(nullptr, 0);
+    if(!ScanProjection::compile("payload[5:2]", projection, error)
+       || (projected = projection.apply(fields.payload, fields.payload_size)).second != 2
+       || std::string(reinterpret_cast<const char*>(projected.first), projected.second) != "21") {
+        std::cout << "projection payload[5:2] is wrong." << std::endl;
+        ok = false;
+    }
+    if(!ScanProjection::compile("payload[8:100]", projection, error)
+       || projection.apply(fields.payload, fields.payload_size).second != 3
+       || projection.apply(fields.payload, 4).second != 0) {
+        std::cout << "projection payload[8:100] is not clipped to the payload." << std::endl;
+        ok = false;
+    }
+    if(ScanProjection::compile("payload[1:]", projection, error) || ScanProjection::compile("key", projection, error)) {
+        std::cout << "an invalid projection is accepted." << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "passed" : "failed") << std::endl;
+    return ok ? 0 : 1;
+}
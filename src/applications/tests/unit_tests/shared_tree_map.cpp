@@ -0,0 +1,98 @@
+#include <cascade/detail/shared_tree_map.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace derecho::cascade;
+
+/**
+ * Compare the map with a reference map, including the order of the keys.
+ */
+template <typename K>
+static bool check_map(const SharedTreeMap<K, uint64_t>& map, const std::map<K, uint64_t>& reference) {
+    if(map.size() != reference.size()) {
+        std::cout << "the map has " << map.size() << " keys instead of " << reference.size() << "." << std::endl;
+        return false;
+    }
+    for(const auto& kv : reference) {
+        const uint64_t* value = map.find(kv.first);
+        if(value == nullptr || *value != kv.second) {
+            std::cout << "key " << kv.first << " is lost." << std::endl;
+            return false;
+        }
+    }
+    auto it = reference.cbegin();
+    bool ordered = map.for_each([&it](const K& key, const uint64_t& value) {
+        if(key != it->first || value != it->second) {
+            return false;
+        }
+        it++;
+        return true;
+    });
+    if(!ordered) {
+        std::cout << "the keys are not visited in order." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Apply random updates, and check that the copies taken along the way keep their content.
+ */
+template <typename K, typename KeyOf>
+static bool check_random(uint64_t seed, KeyOf key_of) {
+    std::mt19937_64 rng(seed);
+    SharedTreeMap<K, uint64_t> map;
+    std::map<K, uint64_t> reference;
+    std::vector<std::pair<SharedTreeMap<K, uint64_t>, std::map<K, uint64_t>>> copies;
+    for(uint64_t i = 0; i < 20000; i++) {
+        K key = key_of(rng() % 2000);
+        if(rng() % 4 == 0) {
+            if(map.erase(key) != (reference.erase(key) > 0)) {
+                std::cout << "erase of key " << key << " is wrong." << std::endl;
+                return false;
+            }
+        } else {
+            map.insert_or_assign(key, i);
+            reference[key] = i;
+        }
+        if(i % 1000 == 0) {
+            copies.emplace_back(map, reference);
+        }
+    }
+    if(!check_map(map, reference)) {
+        return false;
+    }
+    for(const auto& copy : copies) {
+        if(!check_map(copy.first, copy.second)) {
+            std::cout << "a copy is changed by the later updates." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int, char**) {
+    bool ok = true;
+    ok &= check_random<std::string>(1, [](uint64_t i) { return "/pool/key" + std::to_string(i); });
+    // sequential integer keys must not degrade the tree to a list.
+    ok &= check_random<uint64_t>(2, [](uint64_t i) { return i; });
+
+    SharedTreeMap<uint64_t, uint64_t> sequential;
+    for(uint64_t i = 0; i < 1000000; i++) {
+        sequential.insert_or_assign(i, i);
+    }
+    uint64_t visited = 0;
+    sequential.for_each([&visited](const uint64_t&, const uint64_t&) { return ++visited < 10; });
+    if(sequential.size() != 1000000 || visited != 10) {
+        std::cout << "the visitor does not stop." << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "passed" : "failed") << std::endl;
+    return ok ? 0 : 1;
+}
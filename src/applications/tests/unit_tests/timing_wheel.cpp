@@ -0,0 +1,90 @@
+#include <cascade/detail/timing_wheel.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace derecho::cascade;
+
+/**
+ * Schedule entries at random distances covering all levels of the wheel, and check that each entry is due exactly at
+ * its deadline, or at the first tick processed after it.
+ */
+static bool check_random(uint64_t start_tick, uint64_t step) {
+    TimingWheel<uint64_t> wheel(start_tick);
+    std::mt19937_64 rng(start_tick);
+    std::map<uint64_t, uint64_t> deadlines;
+    const uint64_t span = uint64_t{1} << (TimingWheel<uint64_t>::SLOT_BITS * 3 + 2);
+    for(uint64_t id = 0; id < 10000; id++) {
+        uint64_t deadline = start_tick + rng() % span;
+        deadlines.emplace(id, deadline);
+        wheel.schedule(id, deadline);
+    }
+    uint64_t now = start_tick;
+    std::vector<uint64_t> due;
+    while(wheel.size() > 0) {
+        const uint64_t last = wheel.get_current_tick();
+        due.clear();
+        wheel.advance(now, due);
+        for(auto id : due) {
+            if(deadlines.at(id) > now || deadlines.at(id) < last) {
+                std::cout << "entry " << id << " due at " << deadlines.at(id) << " is returned at " << now << "." << std::endl;
+                return false;
+            }
+            deadlines.erase(id);
+        }
+        now += step;
+    }
+    if(!deadlines.empty()) {
+        std::cout << deadlines.size() << " entries are lost." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Apply the edge cases: overdue entries, entries beyond the span of the wheel, and reset.
+ */
+int main(int, char**) {
+    bool ok = true;
+    ok &= check_random(0, 1);
+    ok &= check_random(123456789, 1);
+    ok &= check_random(987654321, 37);
+
+    TimingWheel<int> wheel(1000);
+    std::vector<int> due;
+    wheel.schedule(1, 10);
+    wheel.advance(1000, due);
+    if(due != std::vector<int>{1}) {
+        std::cout << "an overdue entry is not due at the current tick." << std::endl;
+        ok = false;
+    }
+
+    const uint64_t far = 1000 + (uint64_t{1} << (TimingWheel<int>::SLOT_BITS * TimingWheel<int>::LEVELS)) * 3;
+    wheel.schedule(2, far);
+    due.clear();
+    wheel.advance(far - 1, due);
+    if(!due.empty() || wheel.size() != 1) {
+        std::cout << "an entry beyond the span of the wheel is due early." << std::endl;
+        ok = false;
+    }
+    wheel.advance(far, due);
+    if(due != std::vector<int>{2}) {
+        std::cout << "an entry beyond the span of the wheel is not due at its deadline." << std::endl;
+        ok = false;
+    }
+
+    wheel.schedule(3, far + 10);
+    wheel.reset(0);
+    due.clear();
+    wheel.advance(far + 10, due);
+    if(!due.empty() || wheel.size() != 0) {
+        std::cout << "reset does not drop the entries." << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "passed" : "failed") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,322 @@
+#include <cascade/blob_store.hpp>
+
+#include <derecho/conf/conf.hpp>
+#include <derecho/utils/logger.hpp>
+#include <openssl/evp.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace derecho {
+namespace cascade {
+
+/** The alignment of O_DIRECT writes, which is the logical block size of common devices. */
+static constexpr std::size_t BLOB_SEGMENT_ALIGNMENT = 4096;
+/** The size of the aligned bounce buffer of O_DIRECT writes. */
+static constexpr std::size_t BLOB_SEGMENT_IO_SIZE = (4ull << 20);
+
+std::string BlobReference::to_string() const {
+    static const char hex[] = "0123456789abcdef";
+    std::string str(sizeof(digest) * 2, '0');
+    for(std::size_t i = 0; i < sizeof(digest); i++) {
+        str[2 * i] = hex[digest[i] >> 4];
+        str[2 * i + 1] = hex[digest[i] & 0xf];
+    }
+    return str;
+}
+
+BlobReference BlobReference::from_string(const std::string& name, uint64_t size) {
+    BlobReference reference;
+    if(name.size() != sizeof(reference.digest) * 2) {
+        throw std::invalid_argument("Invalid blob segment name " + name + ".");
+    }
+    auto nibble = [&name](char c) -> uint8_t {
+        if(c >= '0' && c <= '9') {
+            return c - '0';
+        } else if(c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        throw std::invalid_argument("Invalid blob segment name " + name + ".");
+    };
+    for(std::size_t i = 0; i < sizeof(reference.digest); i++) {
+        reference.digest[i] = (nibble(name[2 * i]) << 4) | nibble(name[2 * i + 1]);
+    }
+    reference.size = size;
+    return reference;
+}
+
+BlobSegmentStore::BlobSegmentStore(const std::string& _path) : path(_path), temp_counter(0), writer_running(true) {
+    std::filesystem::create_directories(path);
+    writer_thread = std::thread(&BlobSegmentStore::writer, this);
+}
+
+BlobSegmentStore::~BlobSegmentStore() {
+    {
+        std::lock_guard<std::mutex> lck(segments_mutex);
+        writer_running = false;
+    }
+    segments_cv.notify_all();
+    if(writer_thread.joinable()) {
+        writer_thread.join();
+    }
+}
+
+/**
+ * Write a file with O_DIRECT through an aligned bounce buffer, padding the last block and truncating the padding
+ * afterwards. It falls back to buffered writes if the file system rejects O_DIRECT.
+ *
+ * @return 0 on success, or the errno.
+ */
+static int write_segment_file(const std::string& filename, const uint8_t* bytes, std::size_t size) {
+    bool direct = true;
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    if(fd < 0 && errno == EINVAL) {
+        direct = false;
+        fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if(fd < 0) {
+        return errno;
+    }
+    int error = 0;
+    if(direct) {
+        void* buffer = nullptr;
+        error = posix_memalign(&buffer, BLOB_SEGMENT_ALIGNMENT, BLOB_SEGMENT_IO_SIZE);
+        for(std::size_t offset = 0; error == 0 && offset < size; offset += BLOB_SEGMENT_IO_SIZE) {
+            std::size_t chunk = std::min(BLOB_SEGMENT_IO_SIZE, size - offset);
+            std::size_t aligned_chunk = (chunk + BLOB_SEGMENT_ALIGNMENT - 1) / BLOB_SEGMENT_ALIGNMENT * BLOB_SEGMENT_ALIGNMENT;
+            memcpy(buffer, bytes + offset, chunk);
+            memset(static_cast<uint8_t*>(buffer) + chunk, 0, aligned_chunk - chunk);
+            for(std::size_t written = 0; written < aligned_chunk;) {
+                ssize_t ret = ::pwrite(fd, static_cast<uint8_t*>(buffer) + written, aligned_chunk - written, offset + written);
+                if(ret < 0) {
+                    error = errno;
+                    break;
+                }
+                written += ret;
+            }
+        }
+        free(buffer);
+        if(error == 0 && ::ftruncate(fd, size) != 0) {
+            error = errno;
+        }
+    } else {
+        for(std::size_t written = 0; written < size;) {
+            ssize_t ret = ::pwrite(fd, bytes + written, size - written, written);
+            if(ret < 0) {
+                error = errno;
+                break;
+            }
+            written += ret;
+        }
+    }
+    if(error == 0 && ::fdatasync(fd) != 0) {
+        error = errno;
+    }
+    ::close(fd);
+    return error;
+}
+
+BlobReference BlobSegmentStore::reference_of(const uint8_t* bytes, std::size_t size) {
+    BlobReference reference;
+    reference.size = size;
+    if(EVP_Digest(bytes, size, reference.digest, nullptr, EVP_sha256(), nullptr) != 1) {
+        throw std::runtime_error("Failed to digest a blob of " + std::to_string(size) + " bytes.");
+    }
+    return reference;
+}
+
+void BlobSegmentStore::write_segment(const std::string& name, const uint8_t* bytes, std::size_t size) {
+    std::string segment = path + "/" + name;
+    if(::access(segment.c_str(), F_OK) == 0) {
+        return;
+    }
+    std::string temp = segment + ".tmp." + std::to_string(temp_counter.fetch_add(1));
+    int error = write_segment_file(temp, bytes, size);
+    if(error == 0 && ::rename(temp.c_str(), segment.c_str()) != 0) {
+        error = errno;
+    }
+    if(error != 0) {
+        ::unlink(temp.c_str());
+        dbg_default_error("Failed to write blob segment {}: {}", segment, strerror(error));
+        throw std::runtime_error("Failed to write blob segment " + segment + ": " + strerror(error));
+    }
+    // make the rename durable.
+    int dir_fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY);
+    if(dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+}
+
+BlobReference BlobSegmentStore::write(const uint8_t* bytes, std::size_t size) {
+    BlobReference reference = reference_of(bytes, size);
+    write_segment(reference.to_string(), bytes, size);
+    return reference;
+}
+
+void BlobSegmentStore::writer() {
+    pthread_setname_np(pthread_self(), "cs_blob_writer");
+    std::unique_lock<std::mutex> lck(segments_mutex);
+    while(true) {
+        segments_cv.wait(lck, [this]() { return !writer_running || !pending_segments.empty(); });
+        if(pending_segments.empty()) {
+            break;
+        }
+        // the segment stays pending, so that it is served from memory while it is written.
+        auto pending = pending_segments.begin();
+        std::string name = pending->first;
+        std::shared_ptr<const uint8_t> payload = pending->second.second;
+        std::size_t size = pending->second.first.size;
+        writing_segment = name;
+        lck.unlock();
+        bool written = true;
+        try {
+            write_segment(name, payload.get(), size);
+        } catch(const std::runtime_error&) {
+            written = false;
+        }
+        lck.lock();
+        writing_segment.clear();
+        if(segment_refcounts.find(name) == segment_refcounts.end()) {
+            // released while it was written.
+            pending_segments.erase(name);
+            ::unlink((path + "/" + name).c_str());
+        } else if(written || !writer_running) {
+            if(!written) {
+                dbg_default_error("Dropping blob segment {} that can not be written, which is fetched from the shard members after a restart.", name);
+            }
+            pending_segments.erase(name);
+        } else {
+            // retry later, while the payload is still served from memory.
+            segments_cv.wait_for(lck, std::chrono::seconds(1), [this]() { return !writer_running; });
+        }
+    }
+}
+
+void BlobSegmentStore::acquire(const BlobReference& reference, const std::shared_ptr<const uint8_t>& payload) {
+    std::string name = reference.to_string();
+    std::lock_guard<std::mutex> lck(segments_mutex);
+    segment_refcounts[name]++;
+    if(payload != nullptr && pending_segments.find(name) == pending_segments.end()
+       && ::access((path + "/" + name).c_str(), F_OK) != 0) {
+        pending_segments.emplace(name, std::make_pair(reference, payload));
+        segments_cv.notify_all();
+    }
+}
+
+void BlobSegmentStore::release(const BlobReference& reference) {
+    std::string name = reference.to_string();
+    std::lock_guard<std::mutex> lck(segments_mutex);
+    auto refcount = segment_refcounts.find(name);
+    if(refcount == segment_refcounts.end()) {
+        return;
+    }
+    if(--refcount->second > 0) {
+        return;
+    }
+    segment_refcounts.erase(refcount);
+    if(writing_segment != name) {
+        // the writer removes the segment it is writing when it is done.
+        pending_segments.erase(name);
+        ::unlink((path + "/" + name).c_str());
+    }
+}
+
+bool BlobSegmentStore::contains(const BlobReference& reference) {
+    std::string name = reference.to_string();
+    {
+        std::lock_guard<std::mutex> lck(segments_mutex);
+        if(pending_segments.find(name) != pending_segments.end()) {
+            return true;
+        }
+    }
+    return ::access((path + "/" + name).c_str(), F_OK) == 0;
+}
+
+std::shared_ptr<const uint8_t> BlobSegmentStore::map(const BlobReference& reference) {
+    std::string name = reference.to_string();
+    {
+        std::lock_guard<std::mutex> lck(segments_mutex);
+        auto pending = pending_segments.find(name);
+        if(pending != pending_segments.end()) {
+            return pending->second.second;
+        }
+    }
+    std::lock_guard<std::mutex> lck(mapped_segments_mutex);
+    auto it = mapped_segments.find(name);
+    if(it != mapped_segments.end()) {
+        auto mapped = it->second.lock();
+        if(mapped) {
+            return mapped;
+        }
+    }
+    std::string segment = path + "/" + name;
+    int fd = ::open(segment.c_str(), O_RDONLY);
+    if(fd < 0) {
+        dbg_default_error("Failed to open blob segment {}: {}", segment, strerror(errno));
+        throw std::runtime_error("Failed to open blob segment " + segment + ": " + strerror(errno));
+    }
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) != reference.size) {
+        ::close(fd);
+        dbg_default_error("Blob segment {} does not have {} bytes.", segment, reference.size);
+        throw std::runtime_error("Blob segment " + segment + " does not have " + std::to_string(reference.size) + " bytes.");
+    }
+    void* addr = ::mmap(nullptr, reference.size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(addr == MAP_FAILED) {
+        dbg_default_error("Failed to map blob segment {}: {}", segment, strerror(errno));
+        throw std::runtime_error("Failed to map blob segment " + segment + ": " + strerror(errno));
+    }
+    std::size_t size = reference.size;
+    std::shared_ptr<const uint8_t> mapped(static_cast<const uint8_t*>(addr), [size](const uint8_t* p) {
+        ::munmap(const_cast<uint8_t*>(p), size);
+    });
+    mapped_segments[name] = mapped;
+    // drop the segments that are no longer mapped.
+    if(mapped_segments.size() > 1024) {
+        for(auto seg = mapped_segments.begin(); seg != mapped_segments.end();) {
+            if(seg->second.expired()) {
+                seg = mapped_segments.erase(seg);
+            } else {
+                seg++;
+            }
+        }
+    }
+    return mapped;
+}
+
+std::vector<uint8_t> BlobSegmentStore::read(const BlobReference& reference, uint64_t offset, uint64_t max_length) {
+    if(offset >= reference.size) {
+        return {};
+    }
+    std::shared_ptr<const uint8_t> mapped;
+    try {
+        mapped = map(reference);
+    } catch(const std::runtime_error&) {
+        return {};
+    }
+    uint64_t length = std::min(max_length, reference.size - offset);
+    return std::vector<uint8_t>(mapped.get() + offset, mapped.get() + offset + length);
+}
+
+BlobSegmentStore& BlobSegmentStore::get() {
+    static BlobSegmentStore store(derecho::hasCustomizedConfKey(CASCADE_PERSISTENT_BLOB_PATH)
+                                          ? derecho::getConfString(CASCADE_PERSISTENT_BLOB_PATH)
+                                          : derecho::getConfString(derecho::Conf::PERS_FILE_PATH) + "/blobs");
+    return store;
+}
+
+}  // namespace cascade
+}  // namespace derecho
@@ -0,0 +1,109 @@
+#include <cascade/merge_operator.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace derecho {
+namespace cascade {
+
+/**
+ * Read an int64 payload, where an absent key reads as 0.
+ *
+ * @return false if the payload is not 8 bytes.
+ */
+static bool read_int64(const uint8_t* bytes, std::size_t size, bool absent, int64_t& value) {
+    if(absent) {
+        value = 0;
+        return true;
+    }
+    if(size != sizeof(int64_t)) {
+        return false;
+    }
+    memcpy(&value, bytes, sizeof(int64_t));
+    return true;
+}
+
+static void write_int64(int64_t value, std::vector<uint8_t>& merged) {
+    merged.resize(sizeof(int64_t));
+    memcpy(merged.data(), &value, sizeof(int64_t));
+}
+
+/**
+ * Make an operator keeping the better of two int64 values, where the operand wins if the key does not exist.
+ */
+template <typename Compare>
+static merge_operator_t make_select_int64(Compare better) {
+    return [better](const uint8_t* base, std::size_t base_size, const uint8_t* operand, std::size_t operand_size,
+                    std::vector<uint8_t>& merged) {
+        int64_t current, value;
+        if(!read_int64(operand, operand_size, false, value)) {
+            return false;
+        }
+        if(base != nullptr) {
+            if(!read_int64(base, base_size, false, current)) {
+                return false;
+            }
+            value = better(current, value) ? current : value;
+        }
+        write_int64(value, merged);
+        return true;
+    };
+}
+
+MergeOperatorRegistry::MergeOperatorRegistry() {
+    operators.emplace(CASCADE_MERGE_ADD_INT64,
+                      [](const uint8_t* base, std::size_t base_size, const uint8_t* operand, std::size_t operand_size,
+                         std::vector<uint8_t>& merged) {
+                          int64_t current, delta;
+                          if(!read_int64(base, base_size, base == nullptr, current)
+                             || !read_int64(operand, operand_size, false, delta)) {
+                              return false;
+                          }
+                          // wrap around on overflow, which is well defined for unsigned integers.
+                          write_int64(static_cast<int64_t>(static_cast<uint64_t>(current) + static_cast<uint64_t>(delta)), merged);
+                          return true;
+                      });
+    operators.emplace(CASCADE_MERGE_APPEND_BYTES,
+                      [](const uint8_t* base, std::size_t base_size, const uint8_t* operand, std::size_t operand_size,
+                         std::vector<uint8_t>& merged) {
+                          merged.resize(base_size + operand_size);
+                          if(base_size > 0) {
+                              memcpy(merged.data(), base, base_size);
+                          }
+                          if(operand_size > 0) {
+                              memcpy(merged.data() + base_size, operand, operand_size);
+                          }
+                          return true;
+                      });
+    operators.emplace(CASCADE_MERGE_MAX_INT64, make_select_int64([](int64_t a, int64_t b) { return a > b; }));
+    operators.emplace(CASCADE_MERGE_MIN_INT64, make_select_int64([](int64_t a, int64_t b) { return a < b; }));
+}
+
+bool MergeOperatorRegistry::register_operator(const std::string& name, const merge_operator_t& op) {
+    std::unique_lock<std::shared_mutex> wlck(operators_mutex);
+    return operators.emplace(name, op).second;
+}
+
+bool MergeOperatorRegistry::has_operator(const std::string& name) const {
+    std::shared_lock<std::shared_mutex> rlck(operators_mutex);
+    return operators.find(name) != operators.cend();
+}
+
+bool MergeOperatorRegistry::merge(const std::string& name, const uint8_t* base, std::size_t base_size,
+                                  const uint8_t* operand, std::size_t operand_size, std::vector<uint8_t>& merged) const {
+    std::shared_lock<std::shared_mutex> rlck(operators_mutex);
+    auto it = operators.find(name);
+    if(it == operators.cend()) {
+        return false;
+    }
+    return it->second(base, base_size, operand, operand_size, merged);
+}
+
+MergeOperatorRegistry& MergeOperatorRegistry::get() {
+    static MergeOperatorRegistry registry;
+    return registry;
+}
+
+}  // namespace cascade
+}  // namespace derecho
@@ -2,6 +2,8 @@
 #include <derecho/persistent/detail/PersistLog.hpp>
 #include <unistd.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <stdexcept>
 
 namespace derecho {
 namespace cascade {
@@ -70,6 +72,17 @@ Blob::Blob(const uint8_t* b, const decltype(size) s, bool emplaced) :
     }
 }
 
+Blob::Blob(const std::shared_ptr<const uint8_t>& shared, const decltype(size) s) :
+    bytes(nullptr), size(0), capacity(0), memory_mode(object_memory_mode_t::DEFAULT) {
+    if (shared && (s > 0)) {
+        bytes = shared.get();
+        size = s;
+        capacity = s;
+        shared_bytes = shared;
+        memory_mode = object_memory_mode_t::SHARED;
+    }
+}
+
 Blob::Blob(const blob_generator_func_t& generator, const decltype(size) s):
     bytes(nullptr), size(s), capacity(0), blob_generator(generator), memory_mode(object_memory_mode_t::BLOB_GENERATOR) {
     // no data is generated here.
@@ -77,7 +90,14 @@ Blob::Blob(const blob_generator_func_t& generator, const decltype(size) s):
 
 Blob::Blob(const Blob& other) :
     bytes(nullptr), size(0), capacity(0), memory_mode(object_memory_mode_t::DEFAULT) {
-    if(other.size > 0) {
+    if (other.memory_mode == object_memory_mode_t::SHARED) {
+        // pin the immutable data instead of copying it.
+        bytes = other.bytes;
+        size = other.size;
+        capacity = other.size;
+        shared_bytes = other.shared_bytes;
+        memory_mode = object_memory_mode_t::SHARED;
+    } else if(other.size > 0) {
         uint8_t* t_bytes = static_cast<uint8_t*>(malloc(other.size));
         if (memory_mode == object_memory_mode_t::BLOB_GENERATOR) {
             // instantiate data.
@@ -101,7 +121,8 @@ Blob::Blob(const Blob& other) :
 
 Blob::Blob(Blob&& other) : 
     bytes(other.bytes), size(other.size), capacity(other.size),
-    blob_generator(other.blob_generator), memory_mode(other.memory_mode) {
+    blob_generator(other.blob_generator), memory_mode(other.memory_mode),
+    shared_bytes(std::move(other.shared_bytes)) {
     other.bytes = nullptr;
     other.size = 0;
     other.capacity = 0;
@@ -131,15 +152,41 @@ Blob& Blob::operator=(Blob&& other) {
     capacity = swp_cap;
     blob_generator = swp_blob_generator;
     memory_mode = swp_memory_mode;
+    shared_bytes.swap(other.shared_bytes);
     return *this;
 }
 
 Blob& Blob::operator=(const Blob& other) {
+    if (this == &other) {
+        return *this;
+    }
+
+    // 0) the shared data is immutable, so unpin it before owning a copy;
+    if (memory_mode == object_memory_mode_t::SHARED) {
+        shared_bytes.reset();
+        bytes = nullptr;
+        capacity = 0;
+        memory_mode = object_memory_mode_t::DEFAULT;
+    }
+
     // 1) this->is_emplaced has to be false;
     if (memory_mode != object_memory_mode_t::DEFAULT) {
         throw std::runtime_error("Copy to a Blob that does not own the data (object_memory_mode_T::DEFAULT) is prohibited.");
     }
 
+    // 1.5) pin the shared data instead of copying it;
+    if (other.memory_mode == object_memory_mode_t::SHARED) {
+        if (bytes) {
+            free(const_cast<void*>(reinterpret_cast<const void*>(bytes)));
+        }
+        bytes = other.bytes;
+        size = other.size;
+        capacity = other.size;
+        shared_bytes = other.shared_bytes;
+        memory_mode = object_memory_mode_t::SHARED;
+        return *this;
+    }
+
     // 2) verify that this->capacity has enough memory;
     if (this->capacity < other.size) {
         bytes = static_cast<uint8_t*>(realloc(const_cast<void*>(static_cast<const void*>(bytes)),other.size));
@@ -166,6 +213,78 @@ Blob& Blob::operator=(const Blob& other) {
     return *this;
 }
 
+void Blob::share() {
+    if (memory_mode == object_memory_mode_t::SHARED || size == 0) {
+        return;
+    }
+    if (memory_mode != object_memory_mode_t::DEFAULT) {
+        // we do not own the data, so instantiate a copy to share.
+        uint8_t* t_bytes = static_cast<uint8_t*>(malloc(size));
+        if (memory_mode == object_memory_mode_t::BLOB_GENERATOR) {
+            auto number_bytes_generated = blob_generator(t_bytes,size);
+            if (number_bytes_generated != size) {
+                free(t_bytes);
+                dbg_default_error("Expecting {} bytes, but blob generator writes {} bytes.", size, number_bytes_generated);
+                throw std::runtime_error(std::string("Expecting ") + std::to_string(size)
+                        + " bytes, but blob generator writes "
+                        + std::to_string(number_bytes_generated) + " bytes.");
+            }
+        } else {
+            memcpy(t_bytes, bytes, size);
+        }
+        bytes = t_bytes;
+    }
+    shared_bytes = std::shared_ptr<const uint8_t>(bytes,
+            [](const uint8_t* b){free(const_cast<void*>(reinterpret_cast<const void*>(b)));});
+    capacity = size;
+    memory_mode = object_memory_mode_t::SHARED;
+}
+
+void Blob::patch(const uint8_t* base, const std::size_t base_size, const std::size_t offset) {
+    if (offset > base_size) {
+        throw std::out_of_range(std::string("Patch offset ") + std::to_string(offset)
+                + " is beyond the end of the base of " + std::to_string(base_size) + " bytes.");
+    }
+    Blob patched(nullptr, std::max(base_size, offset + size));
+    uint8_t* patched_bytes = const_cast<uint8_t*>(patched.bytes);
+    if (base_size > 0) {
+        memcpy(patched_bytes, base, base_size);
+    }
+    if (size > 0) {
+        if (memory_mode == object_memory_mode_t::BLOB_GENERATOR) {
+            auto number_bytes_generated = blob_generator(patched_bytes + offset, size);
+            if (number_bytes_generated != size) {
+                dbg_default_error("Expecting {} bytes, but blob generator writes {} bytes.", size, number_bytes_generated);
+                throw std::runtime_error(std::string("Expecting ") + std::to_string(size)
+                        + " bytes, but blob generator writes "
+                        + std::to_string(number_bytes_generated) + " bytes.");
+            }
+        } else {
+            memcpy(patched_bytes + offset, bytes, size);
+        }
+    }
+    *this = std::move(patched);
+}
+
+void Blob::trim(const std::size_t offset, const std::size_t s) {
+    if (offset + s > size) {
+        throw std::out_of_range(std::string("Range [") + std::to_string(offset) + "," + std::to_string(offset + s)
+                + ") is beyond the end of the blob of " + std::to_string(size) + " bytes.");
+    }
+    if (memory_mode == object_memory_mode_t::SHARED) {
+        // slice the immutable data instead of copying it.
+        bytes += offset;
+        size = s;
+        capacity = s;
+        return;
+    }
+    if (memory_mode == object_memory_mode_t::BLOB_GENERATOR) {
+        // instantiate the data before cutting it.
+        share();
+    }
+    *this = Blob(bytes + offset, s);
+}
+
 std::size_t Blob::to_bytes(uint8_t* v) const {
     ((std::size_t*)(v))[0] = size;
     if(size > 0) {
@@ -395,6 +514,34 @@ void ObjectWithUInt64Key::copy_from(const ObjectWithUInt64Key& rhs) {
     this->blob = rhs.blob;
 }
 
+void ObjectWithUInt64Key::share_payload() {
+    this->blob.share();
+}
+
+const uint8_t* ObjectWithUInt64Key::get_payload_bytes() const {
+    return this->blob.bytes;
+}
+
+std::size_t ObjectWithUInt64Key::get_payload_size() const {
+    return this->blob.size;
+}
+
+void ObjectWithUInt64Key::patch_payload(const uint8_t* base, std::size_t base_size, std::size_t offset) {
+    this->blob.patch(base, base_size, offset);
+}
+
+void ObjectWithUInt64Key::trim_payload(std::size_t offset, std::size_t size) {
+    this->blob.trim(offset, size);
+}
+
+void ObjectWithUInt64Key::attach_payload(const std::shared_ptr<const uint8_t>& bytes, std::size_t size) {
+    this->blob = Blob(bytes, size);
+}
+
+void ObjectWithUInt64Key::set_payload(const uint8_t* bytes, std::size_t size) {
+    this->blob = Blob(bytes, size);
+}
+
 void ObjectWithUInt64Key::set_version(persistent::version_t ver) const {
     this->version = ver;
 }
@@ -748,6 +895,34 @@ void ObjectWithStringKey::copy_from(const ObjectWithStringKey& rhs) {
     this->blob = rhs.blob;
 }
 
+void ObjectWithStringKey::share_payload() {
+    this->blob.share();
+}
+
+const uint8_t* ObjectWithStringKey::get_payload_bytes() const {
+    return this->blob.bytes;
+}
+
+std::size_t ObjectWithStringKey::get_payload_size() const {
+    return this->blob.size;
+}
+
+void ObjectWithStringKey::patch_payload(const uint8_t* base, std::size_t base_size, std::size_t offset) {
+    this->blob.patch(base, base_size, offset);
+}
+
+void ObjectWithStringKey::trim_payload(std::size_t offset, std::size_t size) {
+    this->blob.trim(offset, size);
+}
+
+void ObjectWithStringKey::attach_payload(const std::shared_ptr<const uint8_t>& bytes, std::size_t size) {
+    this->blob = Blob(bytes, size);
+}
+
+void ObjectWithStringKey::set_payload(const uint8_t* bytes, std::size_t size) {
+    this->blob = Blob(bytes, size);
+}
+
 void ObjectWithStringKey::set_version(persistent::version_t ver) const {
     this->version = ver;
 }
@@ -0,0 +1,344 @@
+#include <cascade/scan_filter.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <mutex>
+
+namespace derecho {
+namespace cascade {
+
+bool ScanPredicateRegistry::register_predicate(const std::string& name, const scan_predicate_t& predicate) {
+    std::unique_lock<std::shared_mutex> wlck(predicates_mutex);
+    return predicates.emplace(name, predicate).second;
+}
+
+bool ScanPredicateRegistry::find_predicate(const std::string& name, scan_predicate_t& predicate) const {
+    std::shared_lock<std::shared_mutex> rlck(predicates_mutex);
+    auto it = predicates.find(name);
+    if(it == predicates.cend()) {
+        return false;
+    }
+    predicate = it->second;
+    return true;
+}
+
+ScanPredicateRegistry& ScanPredicateRegistry::get() {
+    static ScanPredicateRegistry registry;
+    return registry;
+}
+
+namespace {
+
+/**
+ * A cursor over an expression, which skips the white spaces before each token.
+ */
+class ExpressionCursor {
+private:
+    const std::string& expression;
+    std::size_t pos;
+
+public:
+    explicit ExpressionCursor(const std::string& _expression) : expression(_expression), pos(0) {}
+
+    void skip_spaces() {
+        while(pos < expression.size() && std::isspace(static_cast<unsigned char>(expression[pos]))) {
+            pos++;
+        }
+    }
+
+    bool at_end() {
+        skip_spaces();
+        return pos == expression.size();
+    }
+
+    std::size_t position() const {
+        return pos;
+    }
+
+    /**
+     * Consume a token if the expression continues with it.
+     */
+    bool consume(std::string_view token) {
+        skip_spaces();
+        if(expression.compare(pos, token.size(), token) == 0) {
+            pos += token.size();
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Read a name of letters, digits, '_' and '-', which is empty if there is none.
+     */
+    std::string read_name() {
+        skip_spaces();
+        std::size_t begin = pos;
+        while(pos < expression.size()
+              && (std::isalnum(static_cast<unsigned char>(expression[pos])) || expression[pos] == '_' || expression[pos] == '-')) {
+            pos++;
+        }
+        return expression.substr(begin, pos - begin);
+    }
+
+    /**
+     * Read an integer, which is signed if it starts with '-'.
+     */
+    bool read_integer(int64_t& value) {
+        skip_spaces();
+        const char* begin = expression.c_str() + pos;
+        char* end = nullptr;
+        errno = 0;
+        if(*begin == '-') {
+            value = std::strtoll(begin, &end, 0);
+        } else {
+            value = static_cast<int64_t>(std::strtoull(begin, &end, 0));
+        }
+        if(end == begin || errno == ERANGE) {
+            return false;
+        }
+        pos += end - begin;
+        return true;
+    }
+
+    /**
+     * Read a string in double quotes, with \", \\ and \xHH escaped.
+     */
+    bool read_string(std::string& value) {
+        if(!consume("\"")) {
+            return false;
+        }
+        value.clear();
+        while(pos < expression.size()) {
+            char c = expression[pos++];
+            if(c == '"') {
+                return true;
+            }
+            if(c == '\\') {
+                if(pos >= expression.size()) {
+                    return false;
+                }
+                c = expression[pos++];
+                if(c == 'x') {
+                    if(pos + 2 > expression.size() || !std::isxdigit(static_cast<unsigned char>(expression[pos]))
+                       || !std::isxdigit(static_cast<unsigned char>(expression[pos + 1]))) {
+                        return false;
+                    }
+                    c = static_cast<char>(std::stoi(expression.substr(pos, 2), nullptr, 16));
+                    pos += 2;
+                } else if(c != '"' && c != '\\') {
+                    return false;
+                }
+            }
+            value.push_back(c);
+        }
+        return false;
+    }
+};
+
+}  // namespace
+
+bool ScanFilter::compare_bytes(std::string_view value, Op op, const std::string& literal) {
+    switch(op) {
+        case Op::EQ:
+            return value == literal;
+        case Op::NE:
+            return value != literal;
+        case Op::LT:
+            return value < literal;
+        case Op::LE:
+            return value <= literal;
+        case Op::GT:
+            return value > literal;
+        case Op::GE:
+            return value >= literal;
+        case Op::PREFIX:
+            return value.size() >= literal.size() && value.compare(0, literal.size(), literal) == 0;
+    }
+    return false;
+}
+
+template <typename T>
+bool ScanFilter::compare_number(T value, Op op, T literal) {
+    switch(op) {
+        case Op::EQ:
+            return value == literal;
+        case Op::NE:
+            return value != literal;
+        case Op::LT:
+            return value < literal;
+        case Op::LE:
+            return value <= literal;
+        case Op::GT:
+            return value > literal;
+        case Op::GE:
+            return value >= literal;
+        case Op::PREFIX:
+            return false;
+    }
+    return false;
+}
+
+bool ScanFilter::compile(const std::string& expression, ScanFilter& filter, std::string& error, bool resolve_predicates) {
+    static const std::vector<std::pair<std::string_view, Op>> operators = {
+            {"==", Op::EQ}, {"!=", Op::NE}, {"<=", Op::LE}, {">=", Op::GE}, {"^=", Op::PREFIX}, {"<", Op::LT}, {">", Op::GT}};
+    static const std::unordered_map<std::string, Field> fields = {
+            {"key", Field::KEY}, {"version", Field::VERSION}, {"timestamp", Field::TIMESTAMP}, {"size", Field::SIZE}, {"payload", Field::PAYLOAD}};
+
+    filter.clauses.clear();
+    ExpressionCursor cursor(expression);
+    auto fail = [&cursor, &filter, &error](const std::string& reason) {
+        filter.clauses.clear();
+        error = reason + " at position " + std::to_string(cursor.position());
+        return false;
+    };
+    if(cursor.at_end()) {
+        return true;
+    }
+    do {
+        Clause clause{Field::KEY, Op::EQ, 0, {}, {}};
+        if(cursor.consume("@")) {
+            const std::string name = cursor.read_name();
+            if(name.empty()) {
+                return fail("expecting a predicate name");
+            }
+            if(cursor.consume("(")) {
+                if(!cursor.read_string(clause.bytes) || !cursor.consume(")")) {
+                    return fail("expecting a string argument in parentheses");
+                }
+            }
+            if(!resolve_predicates) {
+                // a predicate which is not resolved matches every object.
+                clause.predicate = [](const ScanFields&, const std::string&) { return true; };
+            } else if(!ScanPredicateRegistry::get().find_predicate(name, clause.predicate)) {
+                return fail("unknown predicate @" + name);
+            }
+            clause.field = Field::PREDICATE;
+        } else {
+            auto field = fields.find(cursor.read_name());
+            if(field == fields.cend()) {
+                return fail("expecting a field");
+            }
+            clause.field = field->second;
+            auto op = std::find_if(operators.cbegin(), operators.cend(),
+                                   [&cursor](const auto& candidate) { return cursor.consume(candidate.first); });
+            if(op == operators.cend()) {
+                return fail("expecting an operator");
+            }
+            clause.op = op->second;
+            if(clause.field == Field::KEY || clause.field == Field::PAYLOAD) {
+                if(!cursor.read_string(clause.bytes)) {
+                    return fail("expecting a string");
+                }
+            } else {
+                if(clause.op == Op::PREFIX) {
+                    return fail("^= only applies to key and payload");
+                }
+                if(!cursor.read_integer(clause.number)) {
+                    return fail("expecting an integer");
+                }
+                if(clause.field != Field::VERSION && clause.number < 0) {
+                    return fail("expecting a non-negative integer");
+                }
+            }
+        }
+        filter.clauses.emplace_back(std::move(clause));
+    } while(cursor.consume("&&"));
+    if(!cursor.at_end()) {
+        return fail("unexpected characters");
+    }
+    return true;
+}
+
+std::string ScanFilter::quote(std::string_view bytes) {
+    static const char* hex_digits = "0123456789abcdef";
+    std::string literal = "\"";
+    for(const char c : bytes) {
+        if(c == '"' || c == '\\') {
+            literal.push_back('\\');
+            literal.push_back(c);
+        } else if(std::isprint(static_cast<unsigned char>(c))) {
+            literal.push_back(c);
+        } else {
+            literal.append("\\x");
+            literal.push_back(hex_digits[static_cast<unsigned char>(c) >> 4]);
+            literal.push_back(hex_digits[static_cast<unsigned char>(c) & 0xf]);
+        }
+    }
+    literal.push_back('"');
+    return literal;
+}
+
+bool ScanFilter::match(const ScanFields& fields) const {
+    for(const auto& clause : clauses) {
+        bool matched = false;
+        switch(clause.field) {
+            case Field::KEY:
+                matched = compare_bytes(fields.key, clause.op, clause.bytes);
+                break;
+            case Field::VERSION:
+                matched = compare_number<int64_t>(fields.version, clause.op, clause.number);
+                break;
+            case Field::TIMESTAMP:
+                matched = compare_number<uint64_t>(fields.timestamp_us, clause.op, static_cast<uint64_t>(clause.number));
+                break;
+            case Field::SIZE:
+                matched = compare_number<uint64_t>(fields.payload_size, clause.op, static_cast<uint64_t>(clause.number));
+                break;
+            case Field::PAYLOAD:
+                matched = compare_bytes(std::string_view(reinterpret_cast<const char*>(fields.payload), fields.payload_size),
+                                        clause.op, clause.bytes);
+                break;
+            case Field::PREDICATE:
+                matched = clause.predicate(fields, clause.bytes);
+                break;
+        }
+        if(!matched) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ScanProjection::compile(const std::string& expression, ScanProjection& projection, std::string& error) {
+    ExpressionCursor cursor(expression);
+    projection = ScanProjection();
+    if(cursor.at_end()) {
+        return true;
+    }
+    const std::string name = cursor.read_name();
+    if(name == "none") {
+        projection.length = 0;
+    } else if(name == "payload") {
+        if(cursor.consume("[")) {
+            int64_t offset, length;
+            if(!cursor.read_integer(offset) || !cursor.consume(":") || !cursor.read_integer(length)
+               || !cursor.consume("]") || offset < 0 || length < 0) {
+                error = "expecting payload[offset:length] at position " + std::to_string(cursor.position());
+                return false;
+            }
+            projection.offset = static_cast<uint64_t>(offset);
+            projection.length = static_cast<uint64_t>(length);
+        }
+    } else {
+        error = "expecting none or payload at position 0";
+        return false;
+    }
+    if(!cursor.at_end()) {
+        projection = ScanProjection();
+        error = "unexpected characters at position " + std::to_string(cursor.position());
+        return false;
+    }
+    return true;
+}
+
+std::pair<const uint8_t*, std::size_t> ScanProjection::apply(const uint8_t* payload, std::size_t size) const {
+    if(offset >= size || length == 0) {
+        return {nullptr, 0};
+    }
+    return {payload + offset, static_cast<std::size_t>(std::min<uint64_t>(length, size - offset))};
+}
+
+}  // namespace cascade
+}  // namespace derecho
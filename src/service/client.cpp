@@ -2,6 +2,7 @@
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <iterator>
 #include <typeindex>
 #include <stdio.h>
 #include <readline/readline.h>
@@ -233,6 +234,43 @@ void op_put(ServiceClientAPI& capi, const std::string& key, const std::string& v
     check_put_and_remove_result(result);
 }
 
+void op_put_range(ServiceClientAPI& capi, const std::string& key, const std::string& value, uint64_t offset) {
+    ObjectWithStringKey obj;
+    obj.key = key;
+    obj.blob = Blob(reinterpret_cast<const uint8_t*>(value.c_str()),value.length());
+    derecho::rpc::QueryResults<derecho::cascade::version_tuple> result = capi.put_range(obj,offset);
+    check_put_and_remove_result(result);
+}
+
+void op_merge(ServiceClientAPI& capi, const std::string& key, const std::string& merge_operator, const std::string& operand) {
+    ObjectWithStringKey obj;
+    obj.key = key;
+    if (merge_operator == CASCADE_MERGE_APPEND_BYTES) {
+        obj.blob = Blob(reinterpret_cast<const uint8_t*>(operand.c_str()),operand.length());
+    } else {
+        // the built-in int64 operators take a number.
+        int64_t value = static_cast<int64_t>(std::stoll(operand,nullptr,0));
+        obj.blob = Blob(reinterpret_cast<const uint8_t*>(&value),sizeof(value));
+    }
+    derecho::rpc::QueryResults<derecho::cascade::version_tuple> result = capi.merge(obj,merge_operator);
+    check_put_and_remove_result(result);
+}
+
+void op_put_batch(ServiceClientAPI& capi, const std::vector<std::string>& keys_and_values) {
+    std::vector<ObjectWithStringKey> objects;
+    for (std::size_t i = 0; i + 1 < keys_and_values.size(); i += 2) {
+        ObjectWithStringKey obj;
+        obj.key = keys_and_values[i];
+        obj.blob = Blob(reinterpret_cast<const uint8_t*>(keys_and_values[i+1].c_str()),keys_and_values[i+1].length());
+        objects.emplace_back(std::move(obj));
+    }
+    auto results = capi.put_batch(objects,false);
+    for (auto& shard_result : results) {
+        auto& result = *shard_result;
+        check_put_and_remove_result(result);
+    }
+}
+
 void op_put_file(ServiceClientAPI& capi, const std::string& key, const std::string& filename, persistent::version_t pver, persistent::version_t pver_bk) {
     // get file size
     std::ifstream value_file(filename,std::ios::binary);
@@ -288,15 +326,42 @@ void op_put_file_and_forget(ServiceClientAPI& capi, const std::string& key, cons
     std::cout << "put done." << std::endl;
 }
 
+void op_put_file_chunked(ServiceClientAPI& capi, const std::string& key, const std::string& filename, uint64_t chunk_size) {
+    // load the file, since the chunks are sliced from the payload.
+    std::ifstream value_file(filename,std::ios::binary);
+    if(!value_file.good()) {
+        dbg_default_error("Cannot open file:{} for read.", filename);
+        throw std::runtime_error("Cannot open file:" + filename + "for read");
+    }
+    std::vector<uint8_t> value((std::istreambuf_iterator<char>(value_file)),std::istreambuf_iterator<char>());
+    value_file.close();
+    ObjectWithStringKey obj(key,value.data(),value.size());
+    auto reply = capi.put_chunked(obj,chunk_size);
+    std::cout << "put_chunked done with version:" << std::get<0>(reply) << ",ts_us:" << std::get<1>(reply) << std::endl;
+    shell_vars["put.version"] =         std::to_string(std::get<0>(reply));
+    shell_vars["put.timestamp_us"] =    std::to_string(std::get<1>(reply));
+}
+
+void op_remove_chunked(ServiceClientAPI& capi, const std::string& key) {
+    auto reply = capi.remove_chunked(key);
+    std::cout << "remove_chunked done with version:" << std::get<0>(reply) << ",ts_us:" << std::get<1>(reply) << std::endl;
+    shell_vars["put.version"] =         std::to_string(std::get<0>(reply));
+    shell_vars["put.timestamp_us"] =    std::to_string(std::get<1>(reply));
+}
+
 template <typename SubgroupType>
 void create_object_pool(ServiceClientAPI& capi, const std::string& id, uint32_t subgroup_index,
-                        const std::string& affinity_set_regex) {
+                        const std::string& affinity_set_regex, uint64_t memory_budget, uint64_t blob_threshold,
+                        uint64_t ttl_ms) {
     auto result = capi.template create_object_pool<SubgroupType>(
             id,
             subgroup_index,
             sharding_policy_type::HASH,
             {},
-            affinity_set_regex);
+            affinity_set_regex,
+            memory_budget,
+            blob_threshold,
+            ttl_ms);
     check_put_and_remove_result(result);
     std::cout << "create_object_pool is done." << std::endl;
 }
@@ -470,6 +535,36 @@ void get_size_by_time(ServiceClientAPI& capi, const std::string& key, uint64_t t
     }
 }
 
+static void print_object_head(const ObjectHead& head) {
+    std::cout << "version:" << head.version << ", timestamp_us:" << head.timestamp_us
+              << ", previous_version:" << head.previous_version
+              << ", previous_version_by_key:" << head.previous_version_by_key
+              << ", payload_size:" << head.payload_size << (head.is_null ? ", null" : "") << std::endl;
+    shell_vars["object.version"] =                  std::to_string(head.version);
+    shell_vars["object.timestamp_us"] =             std::to_string(head.timestamp_us);
+    shell_vars["object.previous_version"] =         std::to_string(head.previous_version);
+    shell_vars["object.previous_version_by_key"] =  std::to_string(head.previous_version_by_key);
+}
+
+#define check_head_result(result) \
+    for (auto& reply_future:result.get()) {\
+        std::cout << "node(" << reply_future.first << ") replied with head: ";\
+        print_object_head(reply_future.second.get());\
+    }
+
+template <typename SubgroupType>
+void head(ServiceClientAPI& capi, const std::string& key, persistent::version_t ver, bool stable, uint32_t subgroup_index, uint32_t shard_index) {
+    if constexpr (std::is_same<typename SubgroupType::KeyType,uint64_t>::value) {
+        derecho::rpc::QueryResults<ObjectHead> result = capi.template head<SubgroupType>(
+                static_cast<uint64_t>(std::stol(key,nullptr,0)),ver,stable,subgroup_index,shard_index);
+        check_head_result(result);
+    } else if constexpr (std::is_same<typename SubgroupType::KeyType,std::string>::value) {
+        derecho::rpc::QueryResults<ObjectHead> result = capi.template head<SubgroupType>(
+                key,ver,stable,subgroup_index,shard_index);
+        check_head_result(result);
+    }
+}
+
 #define check_list_keys_result(result) \
     for (auto& reply_future:result.get()) {\
         auto reply = reply_future.second.get();\
@@ -503,10 +598,64 @@ void list_keys_by_time(ServiceClientAPI& capi, uint64_t ts_us, bool stable, uint
     check_list_keys_result(result);
 }
 
+template <typename SubgroupType>
+void list_keys_paged(ServiceClientAPI& capi, uint32_t subgroup_index, uint32_t page_size, const std::string& prefix) {
+    CascadeKeyPager<SubgroupType,ServiceClientAPI> pager(capi,subgroup_index,prefix,page_size);
+    std::vector<typename SubgroupType::KeyType> page;
+    uint64_t num_keys = 0;
+    std::cout << "Keys:" << std::endl;
+    while (pager.next_page(page)) {
+        for (auto& key:page) {
+            std::cout << "    " << key << std::endl;
+        }
+        num_keys += page.size();
+    }
+    std::cout << num_keys << " keys listed." << std::endl;
+}
+
+template <>
+void list_keys_paged<TriggerCascadeNoStoreWithStringKey>(ServiceClientAPI& capi, uint32_t subgroup_index, uint32_t page_size, const std::string& prefix) {
+    print_red("TCSS does not support list_keys_paged.");
+}
+
+template <typename SubgroupType>
+void scan(ServiceClientAPI& capi, const std::string& prefix, const std::string& filter, const std::string& projection, uint32_t subgroup_index, uint32_t shard_index) {
+    std::string cursor;
+    uint64_t num_objects = 0;
+    std::cout << "Objects:" << std::endl;
+    do {
+        derecho::rpc::QueryResults<scan_page_t<typename SubgroupType::ObjectType>> result = capi.template scan<SubgroupType>(prefix,filter,projection,cursor,0,subgroup_index,shard_index);
+        for (auto& reply_future:result.get()) {
+            auto reply = reply_future.second.get();
+            for (auto& obj:std::get<0>(reply)) {
+                std::cout << "    " << obj << std::endl;
+            }
+            num_objects += std::get<0>(reply).size();
+            cursor = std::get<1>(reply);
+            break;
+        }
+    } while (!cursor.empty());
+    std::cout << num_objects << " objects scanned." << std::endl;
+}
+
+template <>
+void scan<TriggerCascadeNoStoreWithStringKey>(ServiceClientAPI& capi, const std::string& prefix, const std::string& filter, const std::string& projection, uint32_t subgroup_index, uint32_t shard_index) {
+    print_red("TCSS does not support scan.");
+}
+
 #ifdef HAS_BOOLINQ
 //    "list_data_by_prefix <type> <prefix> [version] [subgroup_index] [shard_index\n\t test LINQ api\n]"
 template <typename SubgroupType>
 void list_data_by_prefix(ServiceClientAPI& capi, std::string prefix, persistent::version_t ver, uint32_t subgroup_index, uint32_t shard_index) {
+    if (ver == CURRENT_VERSION) {
+        // the latest objects are filtered by the shard member, which only sends the matching ones back.
+        std::vector<typename SubgroupType::ObjectType> objects;
+        for (auto& obj : from_shard_scan<SubgroupType,ServiceClientAPI>(objects,capi,subgroup_index,shard_index,"",
+                                                                        "payload ^= " + ScanFilter::quote(prefix)).toStdVector()) {
+            std::cout << "Found:" << obj << std::endl;
+        }
+        return;
+    }
     std::vector<typename SubgroupType::KeyType> keys;
     for (auto& obj : from_shard<SubgroupType,ServiceClientAPI>(keys,capi,subgroup_index,shard_index,ver).where([&prefix](typename SubgroupType::ObjectType o){
                 if (o.blob.size < prefix.size()) {
@@ -528,34 +677,14 @@ void list_data_by_prefix<TriggerCascadeNoStoreWithStringKey>(ServiceClientAPI& c
 //    "list_data_between_versions <type> <key> <subgroup_index> <shard_index> [version_begin] [version_end]\n\t test LINQ api - version_iterator \n"
 template <typename SubgroupType>
 void list_data_between_versions(ServiceClientAPI &capi, const std::string& key, uint32_t subgroup_index, uint32_t shard_index, persistent::version_t ver_begin, persistent::version_t ver_end) {
+    // the versions are walked on the server in batches, from ver_end backward to ver_begin.
     if constexpr (std::is_same<typename SubgroupType::KeyType, uint64_t>::value) {
-        auto result = capi.template get<SubgroupType>(static_cast<uint64_t>(std::stol(key,nullptr,0)), ver_end, subgroup_index, shard_index);
-        for (auto &reply_future : result.get()) {
-            auto reply = reply_future.second.get();
-            if (reply.is_valid()) {
-                ver_end = reply.version;
-            } else {
-                return;
-            }
-        }
-        for (auto &obj : from_versions<SubgroupType, ServiceClientAPI>(static_cast<uint64_t>(std::stol(key,nullptr,0)), capi, subgroup_index, shard_index, ver_end).where([ver_begin](typename SubgroupType::ObjectType obj) {
-                    return ver_begin == INVALID_VERSION || obj.version >= ver_begin;
-                }).toStdVector()) {
+        const uint64_t uint64_key = static_cast<uint64_t>(std::stol(key,nullptr,0));
+        for (auto &obj : from_versions<SubgroupType, ServiceClientAPI>(uint64_key, capi, subgroup_index, shard_index, ver_end, ver_begin).toStdVector()) {
             std::cout << "Found:" << obj << std::endl;
         }
     } else if constexpr (std::is_same<typename SubgroupType::KeyType, std::string>::value) {
-        auto result = capi.template get<SubgroupType>(key, ver_end, true/*always use stable here*/, subgroup_index, shard_index);
-        for (auto &reply_future : result.get()) {
-            auto reply = reply_future.second.get();
-            if (reply.is_valid()) {
-                ver_end = reply.version;
-            } else {
-                return;
-            }
-        }
-        for (auto &obj : from_versions<SubgroupType, ServiceClientAPI>(key, capi, subgroup_index, shard_index, ver_end).where([ver_begin](typename SubgroupType::ObjectType obj) {
-                    return ver_begin == INVALID_VERSION || obj.version >= ver_begin;
-                }).toStdVector()) {
+        for (auto &obj : from_versions<SubgroupType, ServiceClientAPI>(key, capi, subgroup_index, shard_index, ver_end, ver_begin).toStdVector()) {
             std::cout << "Found:" << obj << std::endl;
         }
     }
@@ -1118,18 +1247,124 @@ std::vector<command_entry_t> commands =
     {
         "create_object_pool",
         "Create an object pool",
-        "create_object_pool <path> <type> <subgroup_index> [affinity_set_regex]\n"
+        "create_object_pool <path> <type> <subgroup_index> [affinity_set_regex] [memory_budget] [blob_threshold] [ttl_ms]\n"
         "type := " SUBGROUP_TYPE_LIST "\n"
+        "memory_budget := the memory budget in bytes of each shard, turning a VCSS object pool into a cache.\n"
+        "blob_threshold := the size in bytes above which the payloads of a PCSS object pool are kept out of the log.\n"
+        "ttl_ms := the time in milliseconds after which the objects of a VCSS object pool expire.\n"
         "Note: put.[version,timestamp_us] will be set.",
         [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
             CHECK_FORMAT(cmd_tokens,4);
             std::string opath = cmd_tokens[1];
             uint32_t subgroup_index = static_cast<uint32_t>(std::stoi(cmd_tokens[3],nullptr,0));
             std::string affinity_set_regex;
+            uint64_t memory_budget = 0;
             if (cmd_tokens.size() >= 5) {
                 affinity_set_regex = cmd_tokens[4];
             }
-            on_subgroup_type(cmd_tokens[2],create_object_pool,capi,opath,subgroup_index,affinity_set_regex);
+            if (cmd_tokens.size() >= 6) {
+                memory_budget = static_cast<uint64_t>(std::stoull(cmd_tokens[5],nullptr,0));
+            }
+            uint64_t blob_threshold = 0;
+            if (cmd_tokens.size() >= 7) {
+                blob_threshold = static_cast<uint64_t>(std::stoull(cmd_tokens[6],nullptr,0));
+            }
+            uint64_t ttl_ms = 0;
+            if (cmd_tokens.size() >= 8) {
+                ttl_ms = static_cast<uint64_t>(std::stoull(cmd_tokens[7],nullptr,0));
+            }
+            on_subgroup_type(cmd_tokens[2],create_object_pool,capi,opath,subgroup_index,affinity_set_regex,memory_budget,blob_threshold,ttl_ms);
+            return true;
+        }
+    },
+    {
+        "get_cache_stats",
+        "Get the cache statistics of a VCSS object pool with a memory budget",
+        "get_cache_stats <path> <subgroup_index> <shard_index>",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,4);
+            uint32_t subgroup_index = static_cast<uint32_t>(std::stoi(cmd_tokens[2],nullptr,0));
+            uint32_t shard_index = static_cast<uint32_t>(std::stoi(cmd_tokens[3],nullptr,0));
+            auto result = capi.template get_cache_stats<VolatileCascadeStoreWithStringKey>(cmd_tokens[1],subgroup_index,shard_index);
+            for (auto& reply_future:result.get()) {
+                auto stats = reply_future.second.get();
+                if (stats.empty()) {
+                    print_red("object pool " + cmd_tokens[1] + " has no memory budget.");
+                }
+                for (const auto& stat:stats) {
+                    std::cout << stat.first << ":" << stat.second << std::endl;
+                }
+            }
+            return true;
+        }
+    },
+    {
+        "get_recovery_stats",
+        "Get the statistics of the recovery of the replicas in a PCSS shard from their snapshots and logs",
+        "get_recovery_stats <subgroup_index> <shard_index>",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,3);
+            uint32_t subgroup_index = static_cast<uint32_t>(std::stoi(cmd_tokens[1],nullptr,0));
+            uint32_t shard_index = static_cast<uint32_t>(std::stoi(cmd_tokens[2],nullptr,0));
+            for (auto node_id:capi.template get_shard_members<PersistentCascadeStoreWithStringKey>(subgroup_index,shard_index)) {
+                auto result = capi.template get_recovery_stats<PersistentCascadeStoreWithStringKey>(node_id,subgroup_index,shard_index);
+                for (auto& reply_future:result.get()) {
+                    std::cout << "node " << reply_future.first << ":" << std::endl;
+                    for (const auto& stat:reply_future.second.get()) {
+                        std::cout << "    " << stat.first << ":" << stat.second << std::endl;
+                    }
+                }
+            }
+            return true;
+        }
+    },
+    {
+        "get_key_memory_stats",
+        "Get the memory used by the keys of the replicas in a PCSS shard",
+        "get_key_memory_stats <subgroup_index> <shard_index>",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,3);
+            uint32_t subgroup_index = static_cast<uint32_t>(std::stoi(cmd_tokens[1],nullptr,0));
+            uint32_t shard_index = static_cast<uint32_t>(std::stoi(cmd_tokens[2],nullptr,0));
+            for (auto node_id:capi.template get_shard_members<PersistentCascadeStoreWithStringKey>(subgroup_index,shard_index)) {
+                auto result = capi.template get_key_memory_stats<PersistentCascadeStoreWithStringKey>(node_id,subgroup_index,shard_index);
+                for (auto& reply_future:result.get()) {
+                    std::cout << "node " << reply_future.first << ":" << std::endl;
+                    for (const auto& stat:reply_future.second.get()) {
+                        std::cout << "    " << stat.first << ":" << stat.second << std::endl;
+                    }
+                }
+            }
+            return true;
+        }
+    },
+    {
+        "set_log_retention",
+        "Set the log retention policy of a PCSS object pool",
+        "set_log_retention <path> <max_versions> <max_age_sec> <max_bytes>\n"
+        "A version of an object expires if any non-zero limit expires it, 0 to keep the whole log.\n"
+        "Note: put.[version,timestamp_us] will be set.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,5);
+            LogRetentionPolicy log_retention{
+                static_cast<uint64_t>(std::stoull(cmd_tokens[2],nullptr,0)),
+                static_cast<uint64_t>(std::stoull(cmd_tokens[3],nullptr,0)),
+                static_cast<uint64_t>(std::stoull(cmd_tokens[4],nullptr,0))};
+            auto result = capi.set_log_retention(cmd_tokens[1],log_retention);
+            check_put_and_remove_result(result);
+            return true;
+        }
+    },
+    {
+        "set_ttl",
+        "Set the TTL of a VCSS object pool",
+        "set_ttl <path> <ttl_ms>\n"
+        "An object expires ttl_ms milliseconds after its timestamp, 0 for never.\n"
+        "Note: put.[version,timestamp_us] will be set.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,3);
+            auto result = capi.set_ttl(cmd_tokens[1],static_cast<uint64_t>(std::stoull(cmd_tokens[2],nullptr,0)));
+            check_put_and_remove_result(result);
             return true;
         }
     },
@@ -1217,6 +1452,32 @@ std::vector<command_entry_t> commands =
             return true;
         }
     },
+    {
+        "op_merge",
+        "Merge an operand into an object in an object pool with a merge operator",
+        "op_merge <key> <merge_operator> <operand>\n"
+            "merge_operator := " CASCADE_MERGE_ADD_INT64 "|" CASCADE_MERGE_APPEND_BYTES "|" CASCADE_MERGE_MAX_INT64 "|" CASCADE_MERGE_MIN_INT64 "\n"
+            "Please note that cascade automatically decides the object pool path using the key's prefix.\n"
+            "Note: the operand of an int64 operator is a number, which is stored as 8 bytes.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,4);
+            op_merge(capi,cmd_tokens[1]/*key*/,cmd_tokens[2]/*merge_operator*/,cmd_tokens[3]/*operand*/);
+            return true;
+        }
+    },
+    {
+        "op_put_batch",
+        "Put a batch of objects into object pools, atomically in each message sent to a shard",
+        "op_put_batch <key1> <value1> [<key2> <value2> ...]\n"
+        "Please note that cascade automatically decides the object pool path using the key's prefix.\n"
+        "Note: the objects of a shard are put under one version for each message they fit in, which is reported once\n"
+        "for each message.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,3);
+            op_put_batch(capi,std::vector<std::string>(cmd_tokens.begin()+1,cmd_tokens.end()));
+            return true;
+        }
+    },
     {
         "op_put_file",
         "Put an object into an object pool, where object's value is from a file,",
@@ -1235,6 +1496,44 @@ std::vector<command_entry_t> commands =
             return true;
         }
     },
+    {
+        "op_put_file_chunked",
+        "Put a large object into an object pool as chunks, where object's value is from a file.",
+        "op_put_file_chunked <key> <filename> [chunk_size(default:" CASCADE_CHUNK_SIZE ")]\n"
+        "Please note that cascade automatically decides the object pool path using the key's prefix.\n"
+        "Note: put.[version,timestamp_us] will be set to those of the manifest.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            uint64_t chunk_size = 0;
+            CHECK_FORMAT(cmd_tokens,3);
+            if (cmd_tokens.size() >= 4)
+                chunk_size = static_cast<uint64_t>(std::stoull(cmd_tokens[3],nullptr,0));
+            op_put_file_chunked(capi,cmd_tokens[1]/*key*/,cmd_tokens[2]/*filename*/,chunk_size);
+            return true;
+        }
+    },
+    {
+        "op_put_range",
+        "Overwrite a range of an object in an object pool of a persistent subgroup",
+        "op_put_range <key> <offset> <value>\n"
+        "Please note that cascade automatically decides the object pool path using the key's prefix.\n"
+        "Note: the offset must not be beyond the end of the current value.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,4);
+            op_put_range(capi,cmd_tokens[1]/*key*/,cmd_tokens[3]/*value*/,std::stoull(cmd_tokens[2],nullptr,0));
+            return true;
+        }
+    },
+    {
+        "op_append",
+        "Append to an object in an object pool of a persistent subgroup",
+        "op_append <key> <value>\n"
+        "Please note that cascade automatically decides the object pool path using the key's prefix.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,3);
+            op_put_range(capi,cmd_tokens[1]/*key*/,cmd_tokens[2]/*value*/,IPatchPayload::APPEND_OFFSET);
+            return true;
+        }
+    },
     {
         "op_put_and_forget",
         "Put an object into an object pool, without a return value",
@@ -1407,6 +1706,40 @@ std::vector<command_entry_t> commands =
             return true;
         }
     },
+    {
+        "op_get_chunked_file",
+        "Get the current state of an object put as chunks from an object pool and save it to file.",
+        "op_get_chunked_file <file> <key>\n"
+        "Please note that cascade automatically decides the object pool path using the key's prefix.\n"
+        "Note: variable object.[version,timestamp_us,previous_version,previous_version_by_key] will be set to those of the manifest.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,3);
+            auto reply = capi.get_chunked(cmd_tokens[2]);
+            std::cout << "get_chunked returned " << reply.blob.size << " bytes of version:" << reply.version << std::endl;
+            // write blob to file
+            std::ofstream of(cmd_tokens[1],std::ios::binary);
+            of.write(reinterpret_cast<const char*>(reply.blob.bytes),reply.blob.size);
+            of.close();
+            // set variables
+            shell_vars["object.version"] =                  std::to_string(reply.version);
+            shell_vars["object.timestamp_us"] =             std::to_string(reply.timestamp_us);
+            shell_vars["object.previous_version"] =         std::to_string(reply.previous_version);
+            shell_vars["object.previous_version_by_key"] =  std::to_string(reply.previous_version_by_key);
+            return true;
+        }
+    },
+    {
+        "op_remove_chunked",
+        "Remove an object put as chunks from an object pool, and then its chunks.",
+        "op_remove_chunked <key>\n"
+        "Please note that cascade automatically decides the object pool path using the key's prefix.\n"
+        "Note: variable put.[version,timestamp_us] will be set.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,2);
+            op_remove_chunked(capi,cmd_tokens[1]);
+            return true;
+        }
+    },
     {
         "get_by_time",
         "Get an object (by timestamp in microseconds).",
@@ -1555,6 +1888,43 @@ std::vector<command_entry_t> commands =
             return true;
         }
     },
+    {
+        "head",
+        "Get the metadata of an object (by version) without its payload.",
+        "head <type> <key> <stable> <subgroup_index> <shard_index> [ version(default:current version) ]\n"
+            "type := " SUBGROUP_TYPE_LIST,
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,6);
+            bool stable = static_cast<bool>(std::stoi(cmd_tokens[3],nullptr,0));
+            uint32_t subgroup_index = static_cast<uint32_t>(std::stoi(cmd_tokens[4],nullptr,0));
+            uint32_t shard_index = static_cast<uint32_t>(std::stoi(cmd_tokens[5],nullptr,0));
+            persistent::version_t version = CURRENT_VERSION;
+            if (cmd_tokens.size() >= 7) {
+                version = static_cast<persistent::version_t>(std::stol(cmd_tokens[6],nullptr,0));
+            }
+            on_subgroup_type(cmd_tokens[1],head,capi,cmd_tokens[2],version,stable,subgroup_index,shard_index);
+            return true;
+        }
+    },
+    {
+        "op_head",
+        "Get the metadata of objects from object pools (by version) without their payloads, in one RPC per shard.",
+        "op_head <stable> <version> <key> [ key ... ]\n"
+            "version := -1 for the current version\n"
+            "Please note that cascade automatically decides the object pool path using the key's prefix.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,4);
+            bool stable = static_cast<bool>(std::stoi(cmd_tokens[1],nullptr,0));
+            persistent::version_t version = static_cast<persistent::version_t>(std::stol(cmd_tokens[2],nullptr,0));
+            std::vector<std::string> keys(cmd_tokens.begin() + 3, cmd_tokens.end());
+            auto heads = capi.head_batch(keys,version,stable);
+            for (std::size_t i = 0; i < keys.size(); i++) {
+                std::cout << keys[i] << ": ";
+                print_object_head(heads[i]);
+            }
+            return true;
+        }
+    },
     {
         "multi_list_keys",
         "list the object keys in a shard using atomic broadcast for the latest version.",
@@ -1642,6 +2012,68 @@ std::vector<command_entry_t> commands =
             return true;
         }
     },
+    {
+        "list_keys_paged",
+        "list the object keys in all shards of a subgroup, page by page.",
+        "list_keys_paged <type> <subgroup_index> <page_size> [prefix]\n"
+            "type := " SUBGROUP_TYPE_LIST,
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,4);
+            uint32_t subgroup_index = static_cast<uint32_t>(std::stoi(cmd_tokens[2],nullptr,0));
+            uint32_t page_size = static_cast<uint32_t>(std::stoi(cmd_tokens[3],nullptr,0));
+            std::string prefix;
+            if (cmd_tokens.size() >= 5) {
+                prefix = cmd_tokens[4];
+            }
+            on_subgroup_type(cmd_tokens[1],list_keys_paged,capi,subgroup_index,page_size,prefix);
+            return true;
+        }
+    },
+    {
+        "scan",
+        "scan the latest objects in a shard with a filter and a projection run by the shard member.",
+        "scan <type> <subgroup_index> <shard_index> <prefix> [filter] [projection]\n"
+            "type := " SUBGROUP_TYPE_LIST "\n"
+            "filter := clause[&&clause]..., e.g. key^=\"/pool/a\"&&size>1024&&@my_predicate(\"arg\")\n"
+            "    clause := <key|version|timestamp|size|payload> <==|!=|<|<=|>|>=|^=> <integer|\"string\"> | @<predicate>[(\"argument\")]\n"
+            "projection := payload | none | payload[<offset>:<length>]\n"
+            "The filter is one argument without spaces, which are written as \\x20 in strings.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,5);
+            uint32_t subgroup_index = static_cast<uint32_t>(std::stoi(cmd_tokens[2],nullptr,0));
+            uint32_t shard_index = static_cast<uint32_t>(std::stoi(cmd_tokens[3],nullptr,0));
+            std::string filter,projection;
+            if (cmd_tokens.size() >= 6) {
+                filter = cmd_tokens[5];
+            }
+            if (cmd_tokens.size() >= 7) {
+                projection = cmd_tokens[6];
+            }
+            on_subgroup_type(cmd_tokens[1],scan,capi,cmd_tokens[4],filter,projection,subgroup_index,shard_index);
+            return true;
+        }
+    },
+    {
+        "op_scan",
+        "scan the latest objects in an object pool with a filter and a projection run by the shard members.",
+        "op_scan <object pool pathname> [filter] [projection]\n"
+            "See scan for the filter and the projection.",
+        [](ServiceClientAPI& capi, const std::vector<std::string>& cmd_tokens) {
+            CHECK_FORMAT(cmd_tokens,2);
+            std::string filter,projection;
+            if (cmd_tokens.size() >= 3) {
+                filter = cmd_tokens[2];
+            }
+            if (cmd_tokens.size() >= 4) {
+                projection = cmd_tokens[3];
+            }
+            std::cout << "Objects:" << std::endl;
+            for (auto& obj:capi.scan(filter,projection,0,cmd_tokens[1])) {
+                std::cout << "    " << obj << std::endl;
+            }
+            return true;
+        }
+    },
 #ifdef HAS_BOOLINQ
     {
         "LINQ Tester Commands", "", "", command_handler_t()
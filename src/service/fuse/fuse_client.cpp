@@ -145,11 +145,12 @@ static void fs_open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi) {
 static void fs_read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi) {
     dbg_default_trace("entering {}.", __func__);
 
-    FileBytes* pfb = reinterpret_cast<FileBytes*>(fi->fh);
-    if (static_cast<size_t>(off) < pfb->size) {
-        fuse_reply_buf(req, reinterpret_cast<char*>(pfb->bytes+off), min(pfb->size - off, size));
+    FileBytes fb;
+    int err = FCC_REQ(req)->read_file_range(ino, static_cast<uint64_t>(off), size, fi, &fb);
+    if (err != 0) {
+        fuse_reply_err(req, err);
     } else {
-        fuse_reply_buf(req, nullptr, 0);
+        fuse_reply_buf(req, reinterpret_cast<char*>(fb.bytes), fb.size);
     }
     dbg_default_trace("leaving {}.", __func__);
 }
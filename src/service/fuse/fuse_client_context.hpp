@@ -4,6 +4,7 @@
 #include <mutex>
 #include <string>
 #include <limits>
+#include <algorithm>
 #include <mutils-containers/KindMap.hpp>
 #include <cascade/service_client_api.hpp>
 #include <fuse3/fuse_lowlevel.h>
@@ -88,6 +89,33 @@ public:
         return 0;
     }
 
+    /**
+     * get the version a file is read at while it is open, so that all the ranges read from it belong to the same
+     * object. This default implementation returns CURRENT_VERSION. Override it for files that can be read by range.
+     */
+    virtual persistent::version_t get_open_version() {
+        return CURRENT_VERSION;
+    }
+
+    /**
+     * read a byte range of the file at a version, clipped to the end of the file. This default implementation reads
+     * the whole file at its current version. Override it for files that can be read by range.
+     * @return 0, or EIO if the range can not be read at the version.
+     */
+    virtual uint64_t read_file_range(uint64_t offset, uint64_t size, persistent::version_t version, FileBytes* fb) {
+        (void) version;
+        FileBytes whole;
+        read_file(&whole);
+        offset = std::min<uint64_t>(offset, whole.size);
+        fb->size = std::min<uint64_t>(size, whole.size - offset);
+        fb->bytes = nullptr;
+        if (fb->size > 0) {
+            fb->bytes = static_cast<uint8_t*>(malloc(fb->size));
+            memcpy(fb->bytes, whole.bytes + offset, fb->size);
+        }
+        return 0;
+    }
+
     virtual void initialize(){
     }
   
@@ -388,7 +416,6 @@ template <typename CascadeType>
 class KeyINode : public FuseClientINode {
 public:
     typename CascadeType::KeyType key;
-    std::unique_ptr<FileBytes> file_bytes;
     uint64_t file_size;
     persistent::version_t                       version;
     uint64_t                                    timestamp_us;
@@ -398,7 +425,7 @@ public:
   
     KeyINode(typename CascadeType::KeyType& k, fuse_ino_t pino, ServiceClientAPI& _capi) : 
       key(k),
-      file_bytes(std::make_unique<FileBytes>()),
+      file_size(0),
       capi(_capi){
         dbg_default_trace("[{}]entering {}.", gettid(), __func__);
     this->update_interval = 2;
@@ -420,18 +447,69 @@ public:
     }
 
     virtual uint64_t read_file(FileBytes* _file_bytes) override {
-        dbg_default_trace("[{}]entering {}.", gettid(), __func__);
-        check_update();
-    _file_bytes->size = this->file_bytes.get()->size;
-    _file_bytes->bytes = static_cast<uint8_t*>(malloc(this->file_bytes.get()->size));
-    memcpy(_file_bytes->bytes,this->file_bytes.get()->bytes, this->file_bytes.get()->size);
+        return read_file_range(0, std::numeric_limits<uint64_t>::max(), CURRENT_VERSION, _file_bytes);
+    }
+
+    /**
+     * the version of the object when the file is opened, read with head.
+     */
+    virtual persistent::version_t get_open_version() override {
+        update_contents();
+        return this->version;
+    }
+
+    /**
+     * read a byte range of the payload of the object at a version with get_range, so that only the range is
+     * transferred. A volatile store only serves the latest object, so its version is checked instead.
+     */
+    virtual uint64_t read_file_range(uint64_t offset, uint64_t size, persistent::version_t version, FileBytes* _file_bytes) override {
+        dbg_default_trace("[{}]entering {} with offset={}, size={}, version=0x{:x}.", gettid(), __func__, offset, size, version);
+        ShardINode<CascadeType> *pino_shard = reinterpret_cast<ShardINode<CascadeType>*>(this->parent);
+        SubgroupINode<CascadeType> *pino_subgroup = reinterpret_cast<SubgroupINode<CascadeType>*>(pino_shard->parent);
+        persistent::version_t read_version = version;
+        if constexpr (!is_persistent_cascade_store<CascadeType>::value) {
+            read_version = CURRENT_VERSION;
+        }
+        auto result = capi.template get_range<CascadeType>(
+                             key,offset,size,read_version,true,pino_subgroup->subgroup_index,pino_shard->shard_index);
+        _file_bytes->size = 0;
+        _file_bytes->bytes = nullptr;
+        for(auto& reply_future:result.get()){
+            auto reply = reply_future.second.get();
+            if constexpr (std::is_base_of<IKeepVersion, typename CascadeType::ObjectType>::value) {
+                if (version != CURRENT_VERSION && reply.get_version() != version) {
+                    dbg_default_debug("[{}]{}: the object is updated to version 0x{:x} since it is opened at version 0x{:x}.",
+                                      gettid(), __func__, reply.get_version(), version);
+                    return EIO;
+                }
+            }
+            if constexpr (std::is_same<typename CascadeType::ObjectType, ObjectWithStringKey>::value ||
+                          std::is_same<typename CascadeType::ObjectType, ObjectWithUInt64Key>::value) {
+                _file_bytes->size = reply.blob.size;
+                if (_file_bytes->size > 0) {
+                    _file_bytes->bytes = static_cast<uint8_t*>(malloc(_file_bytes->size));
+                    memcpy(_file_bytes->bytes, reply.blob.bytes, _file_bytes->size);
+                }
+            } else {
+                // the file of an object without a payload is the serialized object.
+                std::vector<uint8_t> object_bytes(mutils::bytes_size(reply));
+                reply.to_bytes(object_bytes.data());
+                offset = std::min<uint64_t>(offset, object_bytes.size());
+                _file_bytes->size = std::min<uint64_t>(size, object_bytes.size() - offset);
+                if (_file_bytes->size > 0) {
+                    _file_bytes->bytes = static_cast<uint8_t*>(malloc(_file_bytes->size));
+                    memcpy(_file_bytes->bytes, object_bytes.data() + offset, _file_bytes->size);
+                }
+            }
+            break;
+        }
         dbg_default_trace("[{}]leaving {}.", gettid(), __func__);
         return 0;
     }
 
     virtual uint64_t get_file_size() override {
         check_update();
-        return this->file_bytes.get()->size;
+        return this->file_size;
     }
 
     KeyINode(KeyINode&& fci){
@@ -442,46 +520,24 @@ public:
         this->capi = std::move(fci.capi);
     }
 
-    virtual ~KeyINode() {
-        dbg_default_info("[{}] entering {}.", gettid(), __func__);
-    file_bytes.reset(nullptr);
-        dbg_default_info("[{}] leaving {}.", gettid(), __func__);
-    }
+    virtual ~KeyINode() {}
 private:
+    /**
+     * refresh the metadata with head, without transferring the payload.
+     */
     virtual void update_contents () override{
         ShardINode<CascadeType> *pino_shard = reinterpret_cast<ShardINode<CascadeType>*>(this->parent);
         SubgroupINode<CascadeType> *pino_subgroup = reinterpret_cast<SubgroupINode<CascadeType>*>(pino_shard->parent);
-        auto result = capi.template get<CascadeType>(
+        auto result = capi.template head<CascadeType>(
                              key,CURRENT_VERSION,true,pino_subgroup->subgroup_index,pino_shard->shard_index);
-    Blob blob;
         for(auto& reply_future:result.get()){
-        auto reply = reply_future.second.get();
-        dbg_default_trace("------ KEY INODE reply {}.", reply);
-        if(std::is_base_of<typename CascadeType::ObjectType, ObjectWithStringKey>::value){
-          ObjectWithStringKey *access_ptr = reinterpret_cast<ObjectWithStringKey*>(&reply);
-          this->version = access_ptr->version;
-          this->timestamp_us = access_ptr->timestamp_us;
-          this->previous_version = access_ptr->previous_version;
-          this->previous_version_by_key = access_ptr->previous_version_by_key;
-          blob = access_ptr->blob;
-        }else if(std::is_base_of<typename CascadeType::ObjectType, ObjectWithUInt64Key>::value){
-          ObjectWithUInt64Key *access_ptr = reinterpret_cast<ObjectWithUInt64Key*>(&reply);
-          this->version = access_ptr->version;
-          this->timestamp_us = access_ptr->timestamp_us;
-          this->previous_version = access_ptr->previous_version;
-          this->previous_version_by_key = access_ptr->previous_version_by_key;
-          blob = access_ptr->blob;
-        }
-        else{
-          this->file_bytes.get()->size = mutils::bytes_size(reply);
-          this->file_bytes.get()->bytes = static_cast<uint8_t*>(malloc(this->file_bytes.get()->size));
-          reply.to_bytes(this->file_bytes.get()->bytes);
-          return;
-              }
-        file_bytes.get()->size = blob.size;
-        file_bytes.get()->bytes = static_cast<uint8_t*>(malloc(file_bytes.get()->size));
-        memcpy(file_bytes.get()->bytes, blob.bytes, file_bytes.get()->size);
-        return;
+            ObjectHead head = reply_future.second.get();
+            this->version = head.version;
+            this->timestamp_us = head.timestamp_us;
+            this->previous_version = head.previous_version;
+            this->previous_version_by_key = head.previous_version_by_key;
+            this->file_size = head.payload_size;
+            return;
         }
     }
 };
@@ -793,17 +849,20 @@ private:
 class ObjectPoolKeyINode : public FuseClientINode{
 public:
     std::string key;
-     std::unique_ptr<FileBytes> file_bytes;
+    uint64_t file_size;
     persistent::version_t                       version;
     uint64_t                                    timestamp_us;
     persistent::version_t                       previous_version; 
     persistent::version_t                       previous_version_by_key; // previous version by key, INVALID_VERSION for the first value of the key.
     ServiceClientAPI& capi;
+    /** false once a read at a past version fails, i.e. the object pool is in a volatile store. */
+    std::atomic<bool> versioned_reads;
 
   ObjectPoolKeyINode(std::string k, fuse_ino_t pino, ServiceClientAPI& _capi) :
     key(k),
-    file_bytes(std::make_unique<FileBytes>()),
-    capi(_capi){
+    file_size(0),
+    capi(_capi),
+    versioned_reads(true){
         dbg_default_trace("[{}]entering {}.", gettid(), __func__);
         this->update_interval = 2;
         this->last_update_sec = 0;
@@ -815,11 +874,47 @@ public:
     }
 
     virtual uint64_t read_file(FileBytes* _file_bytes) override {
-      dbg_default_debug("-- READ FILE of key:[{}], [{}]entering {}.",this->key ,gettid(), __func__);
-    check_update();
-    _file_bytes->size = this->file_bytes.get()->size;
-    _file_bytes->bytes = static_cast<uint8_t*>(malloc(this->file_bytes.get()->size));
-    memcpy(_file_bytes->bytes,this->file_bytes.get()->bytes, this->file_bytes.get()->size);
+        return read_file_range(0, std::numeric_limits<uint64_t>::max(), CURRENT_VERSION, _file_bytes);
+    }
+
+    /**
+     * the version of the object when the file is opened, read with head.
+     */
+    virtual persistent::version_t get_open_version() override {
+        update_contents();
+        return this->version;
+    }
+
+    /**
+     * read a byte range of the payload of the object at a version with get_range, so that only the range is
+     * transferred. An object pool in a volatile store only serves the latest object, so the range is read again at
+     * the latest version, which is checked instead.
+     */
+    virtual uint64_t read_file_range(uint64_t offset, uint64_t size, persistent::version_t version, FileBytes* _file_bytes) override {
+        dbg_default_debug("-- READ FILE of key:[{}] offset={} size={} version=0x{:x}, [{}]entering {}.", this->key, offset, size, version, gettid(), __func__);
+        _file_bytes->size = 0;
+        _file_bytes->bytes = nullptr;
+        const bool versioned = (version != CURRENT_VERSION) && this->versioned_reads.load();
+        auto result = capi.get_range<std::string>(key,offset,size,versioned ? version : CURRENT_VERSION,true);
+        for (auto& reply_future:result.get()) {
+            auto reply = reply_future.second.get();
+            if (versioned && reply.version != version) {
+                // the object pool can not read a past version.
+                this->versioned_reads.store(false);
+                return read_file_range(offset, size, version, _file_bytes);
+            }
+            if (version != CURRENT_VERSION && reply.version != version) {
+                dbg_default_debug("[{}]{}: the object is updated to version 0x{:x} since it is opened at version 0x{:x}.",
+                                  gettid(), __func__, reply.version, version);
+                return EIO;
+            }
+            _file_bytes->size = reply.blob.size;
+            if (_file_bytes->size > 0) {
+                _file_bytes->bytes = static_cast<uint8_t*>(malloc(_file_bytes->size));
+                memcpy(_file_bytes->bytes, reply.blob.bytes, _file_bytes->size);
+            }
+            break;
+        }
         dbg_default_debug("[{}]leaving {}.", gettid(), __func__);
         return 0;
     }
@@ -827,33 +922,26 @@ public:
     virtual uint64_t get_file_size() override {
         dbg_default_debug("----GET FILE SIZE key is [{}].", this->key);
         check_update();
-        return this->file_bytes.get()->size; 
+        return this->file_size;
     }
 
-    virtual ~ObjectPoolKeyINode() {
-        dbg_default_info("[{}] entering {}.", gettid(), __func__);
-    file_bytes.reset(nullptr);
-        dbg_default_info("[{}] leaving {}.", gettid(), __func__);
-    }
+    virtual ~ObjectPoolKeyINode() {}
 private:
-  virtual void update_contents () override{
-    dbg_default_debug("\n \n ----OBJP keyInode key is:[{}] - update content [{}] entering {}.", this->key ,gettid(), __func__);
-        Blob blob;
-        auto result = capi.get<std::string>(key,CURRENT_VERSION,true);
+    /**
+     * refresh the metadata with head, without transferring the payload.
+     */
+    virtual void update_contents () override{
+        dbg_default_debug("----OBJP keyInode key is:[{}] - update content [{}] entering {}.", this->key ,gettid(), __func__);
+        auto result = capi.head<std::string>(key,CURRENT_VERSION,true);
         for (auto& reply_future:result.get()) {
-            auto reply = reply_future.second.get();
-        ObjectWithStringKey *access_ptr = reinterpret_cast<ObjectWithStringKey*>(&reply);
-       this->version = access_ptr->version;
-       this->timestamp_us = access_ptr->timestamp_us;
-       this->previous_version = access_ptr->previous_version;
-       this->previous_version_by_key = access_ptr->previous_version_by_key;
-       blob = access_ptr->blob;
-       this->file_bytes.get()->size = blob.size;
-       this->file_bytes.get()->bytes = static_cast<uint8_t*>(malloc(blob.size));
-       memcpy(this->file_bytes.get()->bytes, blob.bytes, blob.size);
-       return;
+            ObjectHead head = reply_future.second.get();
+            this->version = head.version;
+            this->timestamp_us = head.timestamp_us;
+            this->previous_version = head.previous_version;
+            this->previous_version_by_key = head.previous_version_by_key;
+            this->file_size = head.payload_size;
+            return;
         }
-    dbg_default_trace("\n \n ----OBJP keyInode update content [{}] leaving  {}.", gettid(), __func__);
     }
 };
 
@@ -1134,13 +1222,46 @@ public:
             pfci->type != INodeType::META) {
             return EISDIR;
         }
-        FileBytes* fb = new FileBytes();
-        pfci->read_file(fb);
-        fi->fh = reinterpret_cast<uint64_t>(fb);
+        if (pfci->type == INodeType::KEY) {
+            // key files are read by range on demand at the version when they are opened, see read_file_range().
+            fi->fh = static_cast<uint64_t>(pfci->get_open_version());
+        } else {
+            FileBytes* fb = new FileBytes();
+            pfci->read_file(fb);
+            fi->fh = reinterpret_cast<uint64_t>(fb);
+        }
         dbg_default_trace("[{}]leaving {}.",gettid(),__func__);
         return 0;
     }
 
+    /**
+     * read a byte range of an open file. A key file is read at the version when it is opened, and the other files
+     * from the buffer filled when they are opened.
+     * @param ino       inode
+     * @param offset    offset of the range
+     * @param size      size of the range
+     * @param fi        file structure shared among processes opening this file.
+     * @param fb        output, the bytes in the range, which are clipped to the file size.
+     * @return          error code. 0 for success.
+     */
+    int read_file_range(fuse_ino_t ino, uint64_t offset, uint64_t size, struct fuse_file_info *fi, FileBytes* fb) {
+        dbg_default_trace("[{}]entering {} with ino={:x}.", gettid(), __func__, ino);
+        FuseClientINode* pfci = reinterpret_cast<FuseClientINode*>(ino);
+        int err = 0;
+        if (pfci->type == INodeType::KEY) {
+            err = static_cast<int>(pfci->read_file_range(offset, size, static_cast<persistent::version_t>(fi->fh), fb));
+        } else {
+            FileBytes* pfb = reinterpret_cast<FileBytes*>(fi->fh);
+            if (offset < pfb->size) {
+                fb->size = std::min<uint64_t>(size, pfb->size - offset);
+                fb->bytes = static_cast<uint8_t*>(malloc(fb->size));
+                memcpy(fb->bytes, pfb->bytes + offset, fb->size);
+            }
+        }
+        dbg_default_trace("[{}]leaving {}.",gettid(),__func__);
+        return err;
+    }
+
     /**
      * close a file.
      * @param ino       inode
@@ -1149,9 +1270,10 @@ public:
      */
     int close_file(fuse_ino_t ino, struct fuse_file_info *fi) {
         dbg_default_trace("[{}]entering {} with ino={:x}.", gettid(), __func__, ino);
-        void* pfb = reinterpret_cast<void*>(fi->fh);
-        if (pfb!=nullptr) {
-            delete static_cast<FileBytes*>(pfb);
+        FuseClientINode* pfci = reinterpret_cast<FuseClientINode*>(ino);
+        // the handle of a key file is its version.
+        if (pfci->type != INodeType::KEY) {
+            delete reinterpret_cast<FileBytes*>(fi->fh);
         }
         return 0;
         dbg_default_trace("[{}]leaving {}.",gettid(),__func__);
@@ -262,6 +262,25 @@ auto get(ServiceClientAPI& capi, const std::string& key, persistent::version_t v
     return py::cast(s);
 }
 
+/**
+    Get objects from cascade store with a byte range of their payloads.
+    @param capi the service client API for this client.
+    @param key key of the object
+    @param offset offset of the range in the payload.
+    @param length length of the range.
+    @param ver version of the object you want to get.
+    @param stable using stable get or not.
+    @param subgroup_index
+    @param shard_index
+    @return QueryResultsStore that handles the return type.
+*/
+template <typename SubgroupType>
+auto get_range(ServiceClientAPI& capi, const std::string& key, uint64_t offset, uint64_t length, persistent::version_t ver, bool stable, uint32_t subgroup_index = 0, uint32_t shard_index = 0) {
+    derecho::rpc::QueryResults<const typename SubgroupType::ObjectType> result = capi.template get_range<SubgroupType>(key, offset, length, ver, stable, subgroup_index, shard_index);
+    auto s = new QueryResultsStore<const typename SubgroupType::ObjectType, py::dict>(std::move(result), object_unwrapper);
+    return py::cast(s);
+}
+
 /**
     Get objects from cascade store using multi_get.
     @param capi the service client API for this client.
@@ -794,6 +813,55 @@ PYBIND11_MODULE(member_client, m) {
                     "\t@argX    timestamp       Specify timestamp (as an integer in unix epoch microsecond) for a timestampped get.\n"
                     "\t@return  a dict version of the object."
             )
+            .def(
+                    "get_range",
+                    [](ServiceClientAPI_PythonWrapper& capi, std::string& key, uint64_t offset, uint64_t length, py::kwargs kwargs) {
+                        std::string subgroup_type;
+                        uint32_t subgroup_index = 0;
+                        uint32_t shard_index = 0;
+                        persistent::version_t version = CURRENT_VERSION;
+                        bool stable = true;
+                        if (kwargs.contains("subgroup_type")) {
+                            subgroup_type = kwargs["subgroup_type"].cast<std::string>();
+                        }
+                        if (kwargs.contains("subgroup_index")) {
+                            subgroup_index = kwargs["subgroup_index"].cast<uint32_t>();
+                        }
+                        if (kwargs.contains("shard_index")) {
+                            shard_index = kwargs["shard_index"].cast<uint32_t>();
+                        }
+                        if (kwargs.contains("version")) {
+                            version = kwargs["version"].cast<persistent::version_t>();
+                        }
+                        if (kwargs.contains("stable")) {
+                            stable = kwargs["stable"].cast<bool>();
+                        }
+
+                        if (subgroup_type.empty()) {
+                            auto res = capi.ref.get_range(key,offset,length,version,stable);
+                            auto s = new QueryResultsStore<const ObjectWithStringKey,py::dict>(std::move(res), object_unwrapper);
+                            return py::cast(s);
+                        } else {
+                            on_all_subgroup_type(subgroup_type, return get_range, capi.ref, key, offset, length, version, stable, subgroup_index, shard_index);
+                        }
+
+                        return py::cast(NULL);
+                    },
+                    "Get an object with a byte range of its payload. \n"
+                    "The range is clipped to the end of the payload. \n"
+                    "\t@arg0    key \n"
+                    "\t@arg1    offset          The offset of the range in the payload.\n"
+                    "\t@arg2    length          The length of the range.\n"
+                    "\t** Optional keyword argument: ** \n"
+                    "\t@argX    subgroup_type   VolatileCascadeStoreWithStringKey | \n"
+                    "\t                         PersistentCascadeStoreWithStringKey | \n"
+                    "\t                         TriggerCascadeNoStoreWithStringKey \n"
+                    "\t@argX    subgroup_index  \n"
+                    "\t@argX    shard_index     \n"
+                    "\t@argX    version         Specify version for a versioned get.\n"
+                    "\t@argX    stable          Specify if using stable get or not. Defaulted to true.\n"
+                    "\t@return  a dict version of the object."
+            )
             .def(
                     "multi_get",
                     [](ServiceClientAPI_PythonWrapper& capi, std::string& key, py::kwargs kwargs) {
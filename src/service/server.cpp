@@ -24,12 +24,13 @@ int main(int argc, char** argv) {
     CascadeServiceCDPO<VolatileCascadeStoreWithStringKey> cdpo_vcss;
     CascadeServiceCDPO<PersistentCascadeStoreWithStringKey> cdpo_pcss;
     CascadeServiceCDPO<TriggerCascadeNoStoreWithStringKey> cdpo_tcss;
+    CascadeServiceCDPO<VolatileCompactCascadeStoreWithUInt64Key> cdpo_vccsu;
+    CascadeServiceCDPO<PersistentCompactCascadeStoreWithUInt64Key> cdpo_pccsu;
 
     auto meta_factory = [](persistent::PersistentRegistry* pr, derecho::subgroup_id_t, ICascadeContext* context_ptr) {
         // critical data path for metadata service is currently disabled. But we can leverage it later for object pool
         // metadata handling.
-        return std::make_unique<CascadeMetadataService<VolatileCascadeStoreWithStringKey, PersistentCascadeStoreWithStringKey, TriggerCascadeNoStoreWithStringKey>>(
-                pr, nullptr, context_ptr);
+        return std::make_unique<CascadeMetadataService<CASCADE_SUBGROUP_TYPE_LIST>>(pr, nullptr, context_ptr);
     };
     auto vcss_factory = [&cdpo_vcss](persistent::PersistentRegistry*, derecho::subgroup_id_t, ICascadeContext* context_ptr) {
         return std::make_unique<VolatileCascadeStoreWithStringKey>(&cdpo_vcss, context_ptr);
@@ -40,24 +41,24 @@ int main(int argc, char** argv) {
     auto tcss_factory = [&cdpo_tcss](persistent::PersistentRegistry*, derecho::subgroup_id_t, ICascadeContext* context_ptr) {
         return std::make_unique<TriggerCascadeNoStoreWithStringKey>(&cdpo_tcss, context_ptr);
     };
+    auto vccsu_factory = [&cdpo_vccsu](persistent::PersistentRegistry*, derecho::subgroup_id_t, ICascadeContext* context_ptr) {
+        return std::make_unique<VolatileCompactCascadeStoreWithUInt64Key>(&cdpo_vccsu, context_ptr);
+    };
+    auto pccsu_factory = [&cdpo_pccsu](persistent::PersistentRegistry* pr, derecho::subgroup_id_t, ICascadeContext* context_ptr) {
+        return std::make_unique<PersistentCompactCascadeStoreWithUInt64Key>(pr, &cdpo_pccsu, context_ptr);
+    };
     dbg_default_trace("starting service...");
-    Service<VolatileCascadeStoreWithStringKey,
-            PersistentCascadeStoreWithStringKey,
-            TriggerCascadeNoStoreWithStringKey>::start({&cdpo_vcss, &cdpo_pcss, &cdpo_tcss},
-                                                       meta_factory,
-                                                       vcss_factory, pcss_factory, tcss_factory);
+    Service<CASCADE_SUBGROUP_TYPE_LIST>::start({&cdpo_vcss, &cdpo_pcss, &cdpo_tcss, &cdpo_vccsu, &cdpo_pccsu},
+                                               meta_factory,
+                                               vcss_factory, pcss_factory, tcss_factory, vccsu_factory, pccsu_factory);
     dbg_default_trace("started service, waiting till it ends.");
     std::cout << "Press Enter to Shutdown." << std::endl;
     std::cin.get();
     // wait for service to quit.
-    Service<VolatileCascadeStoreWithStringKey,
-            PersistentCascadeStoreWithStringKey,
-            TriggerCascadeNoStoreWithStringKey>::shutdown(false);
+    Service<CASCADE_SUBGROUP_TYPE_LIST>::shutdown(false);
     dbg_default_trace("shutdown service gracefully");
     // you can do something here to parallel the destructing process.
-    Service<VolatileCascadeStoreWithStringKey,
-            PersistentCascadeStoreWithStringKey,
-            TriggerCascadeNoStoreWithStringKey>::wait();
+    Service<CASCADE_SUBGROUP_TYPE_LIST>::wait();
     dbg_default_trace("Finish shutdown.");
 
     return 0;
@@ -44,11 +44,7 @@ class CascadeServiceCDPO : public CriticalDataPathObserver<CascadeType> {
         if constexpr(std::is_convertible<typename CascadeType::KeyType, std::string>::value) {
             using namespace derecho::cascade;
 
-            auto* engine = dynamic_cast<
-                    ExecutionEngine<
-                            VolatileCascadeStoreWithStringKey,
-                            PersistentCascadeStoreWithStringKey,
-                            TriggerCascadeNoStoreWithStringKey>*>(cascade_ctxt);
+            auto* engine = dynamic_cast<ExecutionEngine<CASCADE_SUBGROUP_TYPE_LIST>*>(cascade_ctxt);
             size_t pos = key.rfind(PATH_SEPARATOR);
             std::string prefix;
             if(pos != std::string::npos) {
@@ -26,7 +26,7 @@ namespace cascade {
  */
 template <typename FirstCascadeType,typename ... RestCascadeTypes>
 class MProcUDLClient {
-    static_assert(have_same_object_type<FirstCascadeType,RestCascadeTypes...>());
+    static_assert(have_same_object_pool_object_type<FirstCascadeType,RestCascadeTypes...>());
 private:
     std::unique_ptr<wsong::ipc::RingBuffer>     object_commit_rb;   /// object commit ring buffer
     /**
@@ -89,7 +89,7 @@ struct mproc_udl_server_arg_t {
  */
 template <typename FirstCascadeType, typename ... RestCascadeTypes>
 class MProcUDLServer : CascadeContext<FirstCascadeType, RestCascadeTypes...> {
-    static_assert(have_same_object_type<FirstCascadeType,RestCascadeTypes...>());
+    static_assert(have_same_object_pool_object_type<FirstCascadeType,RestCascadeTypes...>());
 protected:
     std::unique_ptr<UserDefinedLogicManager<FirstCascadeType,RestCascadeTypes...>>
                                                     user_defined_logic_manager; /// User defined logic manager;